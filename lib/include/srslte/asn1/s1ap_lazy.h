@@ -0,0 +1,136 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/******************************************************************************
+ *  File:         s1ap_lazy.h
+ *  Description:  Lazily decoded S1AP PDUs. parse() only walks the APER
+ *                IE headers and records where each IE value is; an IE is
+ *                decoded with its liblte unpacker the first time it is
+ *                accessed, into a per-message arena. Compared with
+ *                liblte_s1ap_unpack_s1ap_pdu() this avoids the bit buffer
+ *                for the whole message and the PDU struct, which is sized
+ *                for the largest message S1AP has.
+ *****************************************************************************/
+
+
+#ifndef SRSLTE_S1AP_LAZY_H
+#define SRSLTE_S1AP_LAZY_H
+
+#include <stdint.h>
+#include <vector>
+#include "srslte/asn1/liblte_s1ap.h"
+
+namespace srslte {
+
+#define S1AP_LAZY_MAX_IES   64
+
+/* Bump allocator for the IEs decoded from one message. Memory is only given
+ * back by reset(), which keeps the chunks for the next message.
+ */
+class s1ap_arena
+{
+public:
+  explicit s1ap_arena(uint32_t chunk_size = 64*1024);
+  ~s1ap_arena();
+
+  // 8-byte aligned, not zeroed
+  void*    alloc(uint32_t size);
+  void     reset();
+
+  uint32_t used() const { return nof_used; }
+  uint32_t capacity() const { return nof_held; }
+
+private:
+  std::vector<uint8_t*> chunks;
+  std::vector<uint32_t> chunk_sizes;
+  uint32_t              chunk_size;
+  uint32_t              cur_chunk;
+  uint32_t              cur_offset;
+  uint32_t              nof_used;
+  uint32_t              nof_held;
+};
+
+typedef struct {
+  uint32_t  id;
+  uint8_t   criticality;
+  uint32_t  offset;       // of the IE value, in bytes from the start of the PDU
+  uint32_t  len;
+  void     *decoded;      // NULL until first accessed
+} s1ap_lazy_ie_t;
+
+class s1ap_lazy_pdu
+{
+public:
+  s1ap_lazy_pdu();
+
+  /* Records the message type and the IE offsets. The message must stay
+   * valid, and the arena must not be reset, while the PDU is in use.
+   */
+  LIBLTE_ERROR_ENUM parse(const uint8_t *msg, uint32_t len, s1ap_arena *arena);
+
+  LIBLTE_S1AP_S1AP_PDU_CHOICE_ENUM get_pdu_type() const { return pdu_type; }
+  uint32_t get_procedure_code() const { return procedure_code; }
+  uint32_t get_nof_ies() const { return nof_ies; }
+  const s1ap_lazy_ie_t* find_ie(uint32_t id) const;
+
+  // Decodes the IE with the given liblte unpacker on first access. NULL if absent or undecodable
+  template<class T>
+  const T* get_ie(uint32_t id, LIBLTE_ERROR_ENUM (*unpack)(uint8_t **ptr, T *ie))
+  {
+    s1ap_lazy_ie_t *ie = (s1ap_lazy_ie_t*) find_ie(id);
+    if (ie == NULL) {
+      return NULL;
+    }
+    if (ie->decoded == NULL) {
+      T *value = (T*) arena->alloc(sizeof(T));
+      uint8_t *bits = unpack_bits(ie);
+      if (value == NULL || bits == NULL || unpack(&bits, value) != LIBLTE_SUCCESS) {
+        return NULL;
+      }
+      ie->decoded = value;
+    }
+    return (const T*) ie->decoded;
+  }
+
+  // Contents of an OCTET STRING IE (e.g. NAS-PDU) in place, without decoding
+  bool get_octet_string(uint32_t id, const uint8_t **data, uint32_t *len) const;
+
+private:
+  uint8_t* unpack_bits(const s1ap_lazy_ie_t *ie);
+
+  const uint8_t                    *msg;
+  uint32_t                          msg_len;
+  s1ap_arena                       *arena;
+  LIBLTE_S1AP_S1AP_PDU_CHOICE_ENUM  pdu_type;
+  uint32_t                          procedure_code;
+  uint32_t                          nof_ies;
+  s1ap_lazy_ie_t                    ies[S1AP_LAZY_MAX_IES];
+};
+
+} // namespace srslte
+
+#endif // SRSLTE_S1AP_LAZY_H
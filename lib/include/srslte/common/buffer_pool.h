@@ -28,8 +28,9 @@
 #define SRSLTE_BUFFER_POOL_H
 
 #include <pthread.h>
+#include <stdlib.h>
+#include <new>
 #include <vector>
-#include <stack>
 #include <map>
 #include <string>
 #include <algorithm>
@@ -43,6 +44,75 @@
 
 namespace srslte {
 
+/******************************************************************************
+ * Buffer pool storage
+ *
+ * Creates and destroys the array of buffers of a pool. Byte buffers
+ * specialise it to carve the storage of all buffers of a size class out of
+ * one slab. They are only constructed when first allocated, so the slab
+ * pages of buffers that were never used are not resident.
+ *****************************************************************************/
+
+template <class buffer_t>
+struct buffer_pool_storage {
+  buffer_t *buffers;
+  uint32_t  nof_buffers;
+  void create(uint32_t nof_buffers_, uint32_t size_class) {
+    nof_buffers = nof_buffers_;
+    buffers     = new buffer_t[nof_buffers];
+  }
+  void destroy() {
+    delete [] buffers;
+  }
+  void construct(uint32_t i) {}
+  void recycle(uint32_t i) {}
+  buffer_t* at(uint32_t i) {
+    return &buffers[i];
+  }
+  // Index of b, or false if it is not the start of one of the buffers
+  bool index_of(buffer_t *b, uint32_t *i) {
+    if (b < buffers || b >= buffers + nof_buffers) {
+      return false;
+    }
+    *i = (uint32_t) (b - buffers);
+    return true;
+  }
+};
+
+template <>
+struct buffer_pool_storage<byte_buffer_t> {
+  uint8_t       *slab;
+  uint32_t       nof_buffers;
+  uint32_t       stride;
+  byte_buffer_class_t size_class;
+  void create(uint32_t nof_buffers_, uint32_t size_class_) {
+    nof_buffers = nof_buffers_;
+    size_class  = (byte_buffer_class_t) size_class_;
+    stride      = byte_buffer_t::class_stride(size_class);
+    slab        = (uint8_t*) malloc((size_t) nof_buffers*stride);
+  }
+  void destroy() {
+    free(slab);
+  }
+  void construct(uint32_t i) {
+    new (at(i)) byte_buffer_t(size_class);
+  }
+  void recycle(uint32_t i) {
+    at(i)->reset();
+  }
+  byte_buffer_t* at(uint32_t i) {
+    return (byte_buffer_t*) &slab[(size_t) i*stride];
+  }
+  bool index_of(byte_buffer_t *b, uint32_t *i) {
+    uint8_t *p = (uint8_t*) b;
+    if (p < slab || p >= slab + (size_t) nof_buffers*stride || (p - slab) % stride) {
+      return false;
+    }
+    *i = (uint32_t) ((p - slab) / stride);
+    return true;
+  }
+};
+
 /******************************************************************************
  * Buffer pool
  *
@@ -50,6 +120,14 @@ namespace srslte {
  * deallocate functions. Provides quick object creation and deletion as well
  * as object reuse. 
  * Singleton class of byte_buffer_t (but other pools of different type can be created)
+ *
+ * The buffers live in one array, so checking that a pointer belongs to the
+ * pool is O(1). Free buffers are linked by index in a lock-free stack whose
+ * head carries an ABA tag. Each thread keeps a small magazine of free
+ * buffers so most allocate/deallocate pairs touch no shared cache line; a
+ * magazine is refilled from or flushed to the shared stack half at a time,
+ * with a single CAS. Magazines are sized to 1/64 of the pool so cached
+ * buffers can't starve small pools; pools under 128 buffers don't use them.
  *****************************************************************************/
 
 template <class buffer_t>
@@ -57,39 +135,53 @@ class buffer_pool{
 public:
   
   // non-static methods
-  buffer_pool(int capacity_ = -1)
+  buffer_pool(int capacity_ = -1, uint32_t size_class = 0)
   {
     uint32_t nof_buffers = POOL_SIZE;
     if (capacity_ > 0) {
       nof_buffers = (uint32_t) capacity_;
     }
     pthread_mutex_init(&mutex, NULL);
-    for(uint32_t i=0;i<nof_buffers;i++) {
-      buffer_t *b = new buffer_t;
-      available.push(b);
+    pthread_key_create(&magazine_key, &magazine_release);
+    storage.create(nof_buffers, size_class);
+    next     = new uint32_t[nof_buffers];
+    in_use   = new uint8_t[nof_buffers];
+    capacity = nof_buffers;
+    low_mark = nof_buffers/20;
+    nof_used = 0;
+    mag_size = nof_buffers/64 < MAGAZINE_SIZE ? nof_buffers/64 : MAGAZINE_SIZE;
+    for (uint32_t i = 0; i < nof_buffers; i++) {
+      next[i]   = i + 1 < nof_buffers ? i + 1 : NIL;
+      in_use[i] = BUFFER_FRESH;
     }
-    capacity = nof_buffers; 
+    free_head = make_head(0, nof_buffers > 0 ? 0 : NIL);
   }
 
   ~buffer_pool() { 
-    // this destructor assumes all buffers have been properly deallocated 
-    while(available.size()) {
-      delete available.top();
-      available.pop();
-    }
-
-    for (uint32_t i = 0; i < used.size(); i++) {
-      delete used[i];
+    // Magazines of live threads are dropped, their buffers go with the array
+    pthread_key_delete(magazine_key);
+    pthread_mutex_lock(&mutex);
+    for (uint32_t i = 0; i < magazines.size(); i++) {
+      delete magazines[i];
     }
+    magazines.clear();
+    pthread_mutex_unlock(&mutex);
+    pthread_mutex_destroy(&mutex);
+    storage.destroy();
+    delete [] next;
+    delete [] in_use;
   }
   
   void print_all_buffers()
   {
-    printf("%d buffers in queue\n", (int) used.size());
+    printf("%d buffers in queue\n", (int) nof_used_pdus());
 #ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
     std::map<std::string, uint32_t> buffer_cnt;
-    for (uint32_t i=0;i<used.size();i++) {
-      buffer_cnt[strlen(used[i]->debug_name)?used[i]->debug_name:"Undefined"]++;
+    for (uint32_t i=0;i<capacity;i++) {
+      if (__atomic_load_n(&in_use[i], __ATOMIC_ACQUIRE) == BUFFER_USED) {
+        buffer_t *b = storage.at(i);
+        buffer_cnt[strlen(b->debug_name)?b->debug_name:"Undefined"]++;
+      }
     }
     std::map<std::string, uint32_t>::iterator it;
     for (it = buffer_cnt.begin(); it != buffer_cnt.end(); it++) {
@@ -99,67 +191,195 @@ public:
   }
 
   uint32_t nof_available_pdus() {
-    return available.size();
+    return capacity - nof_used_pdus();
+  }
+
+  uint32_t nof_used_pdus() {
+    return __atomic_load_n(&nof_used, __ATOMIC_RELAXED);
   }
 
   bool is_almost_empty() {
-    return available.size() < capacity/20;
+    return nof_available_pdus() < low_mark;
   }
 
   buffer_t* allocate(const char *debug_name = NULL)
   {
-    pthread_mutex_lock(&mutex);
-    buffer_t* b = NULL;
-
-    if(available.size() > 0)
-    {
-      b = available.top();
-      used.push_back(b);
-      available.pop();
-      
-      if (is_almost_empty()) {
-        printf("Warning buffer pool capacity is %f %%\n", (float) 100*available.size()/capacity);
+    buffer_t *b = try_allocate(debug_name);
+    if (!b) {
+      printf("Error - buffer pool is empty\n");
+#ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
+      print_all_buffers();
+#endif
+      return NULL;
+    }
+    uint32_t available = nof_available_pdus();
+    if (available < low_mark) {
+      printf("Warning buffer pool capacity is %f %%\n", (float) 100*available/capacity);
+    }
+    return b;
+  }
+
+  // Same as allocate() but silent when the pool is (almost) empty
+  buffer_t* try_allocate(const char *debug_name = NULL)
+  {
+    uint32_t i = NIL;
+    if (mag_size < 2) {
+      pop_batch(&i, 1);
+    } else {
+      magazine_t *mag = get_magazine();
+      if (mag->count == 0) {
+        mag->count = pop_batch(mag->idx, mag_size/2);
+      }
+      if (mag->count > 0) {
+        i = mag->idx[--mag->count];
       }
+    }
+    if (i == NIL) {
+      return NULL;
+    }
+    if (__atomic_exchange_n(&in_use[i], BUFFER_USED, __ATOMIC_RELAXED) == BUFFER_FRESH) {
+      storage.construct(i);
+    }
+    buffer_t *b = storage.at(i);
+    __atomic_add_fetch(&nof_used, 1, __ATOMIC_RELAXED);
 #ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
     if (debug_name) {
       strncpy(b->debug_name, debug_name, SRSLTE_BUFFER_POOL_LOG_NAME_LEN);
       b->debug_name[SRSLTE_BUFFER_POOL_LOG_NAME_LEN-1] = 0;
     }
 #endif
-      
-    } else {
-      printf("Error - buffer pool is empty\n");
-      
-#ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
-      print_all_buffers();
-#endif
-    }
-
-    pthread_mutex_unlock(&mutex);
     return b;
   }
   
+  // True if b is one of the buffers of this pool, b is not dereferenced
+  bool owns(buffer_t *b)
+  {
+    uint32_t i;
+    return storage.index_of(b, &i);
+  }
+
+  // Returns false if b was not allocated from this pool (or freed twice).
+  // b is only recycled (byte buffers are reset) once it has been claimed.
   bool deallocate(buffer_t *b)
   {
-    bool ret = false; 
-    pthread_mutex_lock(&mutex);
-    typename std::vector<buffer_t*>::iterator elem = std::find(used.begin(), used.end(), b);
-    if (elem != used.end()) {
-      used.erase(elem); 
-      available.push(b);
-      ret = true; 
+    uint32_t i;
+    uint8_t  used = BUFFER_USED;
+    if (!storage.index_of(b, &i) ||
+        !__atomic_compare_exchange_n(&in_use[i], &used, BUFFER_FREE, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      return false;
     }
-    pthread_mutex_unlock(&mutex);
-    return ret; 
+    storage.recycle(i);
+    __atomic_sub_fetch(&nof_used, 1, __ATOMIC_RELAXED);
+
+    if (mag_size < 2) {
+      push_batch(&i, 1);
+      return true;
+    }
+    magazine_t *mag = get_magazine();
+    if (mag->count == mag_size) {
+      push_batch(&mag->idx[mag_size/2], mag_size - mag_size/2);
+      mag->count = mag_size/2;
+    }
+    mag->idx[mag->count++] = i;
+    return true;
   }
 
   
 private:  
-  static const int       POOL_SIZE = 2048;
-  std::stack<buffer_t*>  available;
-  std::vector<buffer_t*> used; 
-  pthread_mutex_t        mutex;  
-  uint32_t capacity;
+  static const int       POOL_SIZE     = 2048;
+  static const uint32_t  MAGAZINE_SIZE = 32;
+  static const uint32_t  NIL           = 0xFFFFFFFF;
+
+  // in_use[] states, a fresh buffer has never been handed out
+  static const uint8_t   BUFFER_FREE   = 0;
+  static const uint8_t   BUFFER_USED   = 1;
+  static const uint8_t   BUFFER_FRESH  = 2;
+
+  typedef struct {
+    buffer_pool *pool;
+    uint32_t     count;
+    uint32_t     idx[MAGAZINE_SIZE];
+  } magazine_t;
+
+  static uint64_t make_head(uint32_t tag, uint32_t idx) {
+    return ((uint64_t) tag << 32) | idx;
+  }
+
+  magazine_t* get_magazine() {
+    magazine_t *mag = (magazine_t*) pthread_getspecific(magazine_key);
+    if (!mag) {
+      mag        = new magazine_t;
+      mag->pool  = this;
+      mag->count = 0;
+      pthread_setspecific(magazine_key, mag);
+      pthread_mutex_lock(&mutex);
+      magazines.push_back(mag);
+      pthread_mutex_unlock(&mutex);
+    }
+    return mag;
+  }
+
+  // Thread exit: hand the cached buffers back to the shared stack
+  static void magazine_release(void *arg) {
+    magazine_t  *mag  = (magazine_t*) arg;
+    buffer_pool *pool = mag->pool;
+    if (mag->count) {
+      pool->push_batch(mag->idx, mag->count);
+    }
+    pthread_mutex_lock(&pool->mutex);
+    typename std::vector<magazine_t*>::iterator it = std::find(pool->magazines.begin(), pool->magazines.end(), mag);
+    if (it != pool->magazines.end()) {
+      pool->magazines.erase(it);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    delete mag;
+  }
+
+  void push_batch(uint32_t *idx, uint32_t n) {
+    for (uint32_t k = 0; k + 1 < n; k++) {
+      __atomic_store_n(&next[idx[k]], idx[k + 1], __ATOMIC_RELAXED);
+    }
+    uint64_t old = __atomic_load_n(&free_head, __ATOMIC_RELAXED);
+    uint64_t head;
+    do {
+      __atomic_store_n(&next[idx[n - 1]], (uint32_t) old, __ATOMIC_RELAXED);
+      head = make_head((uint32_t) (old >> 32) + 1, idx[0]);
+    } while (!__atomic_compare_exchange_n(&free_head, &old, head, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  }
+
+  /* Walks up to n links and detaches them with one CAS. The tag changes on
+   * every push/pop, so if the CAS succeeds the chain that was read is intact.
+   */
+  uint32_t pop_batch(uint32_t *idx, uint32_t n) {
+    uint64_t old = __atomic_load_n(&free_head, __ATOMIC_ACQUIRE);
+    uint32_t k;
+    while (true) {
+      uint32_t cur = (uint32_t) old;
+      for (k = 0; k < n && cur != NIL; k++) {
+        idx[k] = cur;
+        cur    = __atomic_load_n(&next[cur], __ATOMIC_RELAXED);
+      }
+      if (k == 0) {
+        return 0;
+      }
+      uint64_t head = make_head((uint32_t) (old >> 32) + 1, cur);
+      if (__atomic_compare_exchange_n(&free_head, &old, head, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        return k;
+      }
+    }
+  }
+
+  buffer_pool_storage<buffer_t> storage;
+  uint32_t                 *next;
+  uint8_t                  *in_use;
+  uint32_t                  capacity;
+  uint32_t                  low_mark;
+  uint32_t                  mag_size;
+  uint32_t                  nof_used;
+  uint64_t                  free_head;
+  pthread_key_t             magazine_key;
+  std::vector<magazine_t*>  magazines;
+  pthread_mutex_t           mutex;  
 };
 
 
@@ -169,15 +389,36 @@ public:
   static byte_buffer_pool   *instance;  
   static byte_buffer_pool*   get_instance(int capacity = -1);
   static void                cleanup(void); 
+  // capacity is the number of largest-class buffers, the small and medium
+  // classes get twice as many and as many
   byte_buffer_pool(int capacity = -1) {
     log = NULL;
-    pool = new buffer_pool<byte_buffer_t>(capacity);
+    int nof_large = capacity > 0 ? capacity : POOL_SIZE;
+    pool[SRSLTE_BUFFER_SMALL]  = new buffer_pool<byte_buffer_t>(2*nof_large, SRSLTE_BUFFER_SMALL);
+    pool[SRSLTE_BUFFER_MEDIUM] = new buffer_pool<byte_buffer_t>(nof_large, SRSLTE_BUFFER_MEDIUM);
+    pool[SRSLTE_BUFFER_LARGE]  = new buffer_pool<byte_buffer_t>(nof_large, SRSLTE_BUFFER_LARGE);
   }
   ~byte_buffer_pool() {
-    delete pool; 
+    for (uint32_t i = 0; i < SRSLTE_BUFFER_N_CLASSES; i++) {
+      delete pool[i];
+    }
   }
-  byte_buffer_t* allocate(const char *debug_name = NULL) {
-    return pool->allocate(debug_name);
+  /* Returns a buffer from the smallest class with room for len bytes after
+   * the headroom, falling back to larger classes when it is exhausted.
+   * len = 0 means unknown size and always gives a largest-class buffer.
+   */
+  byte_buffer_t* allocate(const char *debug_name = NULL, uint32_t len = 0) {
+    if (len > 0) {
+      for (uint32_t i = 0; i < SRSLTE_BUFFER_LARGE; i++) {
+        if (len <= byte_buffer_class_payload[i]) {
+          byte_buffer_t *b = pool[i]->try_allocate(debug_name);
+          if (b) {
+            return b;
+          }
+        }
+      }
+    }
+    return pool[SRSLTE_BUFFER_LARGE]->allocate(debug_name);
   }
   void set_log(srslte::log *log) {
     this->log = log;
@@ -186,22 +427,35 @@ public:
     if(!b) {
       return;
     }
-    b->reset();
-    if (!pool->deallocate(b)) {
+    // Find the owner by address: a foreign pointer must not be written to
+    uint32_t c = 0;
+    while (c < SRSLTE_BUFFER_N_CLASSES && !pool[c]->owns(b)) {
+      c++;
+    }
+    if (c == SRSLTE_BUFFER_N_CLASSES || !pool[c]->deallocate(b)) {
+#ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
+      const char *name = b->debug_name;
+#else
+      const char *name = "";
+#endif
       if (log) {
-        log->error("Deallocating PDU: Addr=0x%lx, name=%s not found in pool\n", (uint64_t) b, b->debug_name);
+        log->error("Deallocating PDU: Addr=0x%lx, name=%s not found in pool\n", (uint64_t) b, name);
       } else {
-        printf("Error deallocating PDU: Addr=0x%lx, name=%s not found in pool\n", (uint64_t) b, b->debug_name);
+        printf("Error deallocating PDU: Addr=0x%lx, name=%s not found in pool\n", (uint64_t) b, name);
       }
     }
     b = NULL;
   }
   void print_all_buffers() {
-    pool->print_all_buffers();
+    for (uint32_t i = 0; i < SRSLTE_BUFFER_N_CLASSES; i++) {
+      printf("%d-byte buffers: ", byte_buffer_class_payload[i]);
+      pool[i]->print_all_buffers();
+    }
   }
 private:
+  static const int POOL_SIZE = 2048;
   srslte::log *log;
-  buffer_pool<byte_buffer_t> *pool; 
+  buffer_pool<byte_buffer_t> *pool[SRSLTE_BUFFER_N_CLASSES];
 };
 
 
@@ -65,13 +65,21 @@
 #define SRSLTE_MAX_BUFFER_SIZE_BYTES 12756
 #define SRSLTE_BUFFER_HEADER_OFFSET  1020
 
-#define SRSLTE_BUFFER_POOL_LOG_ENABLED
+// Byte buffer size classes, by payload capacity. Every class keeps the
+// headroom in front of msg, pooled buffers come from the smallest class
+// that fits the requested payload and the default is the largest one.
+#define SRSLTE_BUFFER_SMALL_BYTES    256
+#define SRSLTE_BUFFER_MEDIUM_BYTES   2048
 
+// Buffer pool leak tracking (names every buffer with its allocating
+// function), enabled with the ENABLE_BUFFER_POOL_LOG cmake option
 #ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
 #define pool_allocate (pool->allocate(__PRETTY_FUNCTION__))
+#define pool_allocate_size(len) (pool->allocate(__PRETTY_FUNCTION__, len))
 #define SRSLTE_BUFFER_POOL_LOG_NAME_LEN 128
 #else
 #define pool_allocate (pool->allocate())
+#define pool_allocate_size(len) (pool->allocate(NULL, len))
 #endif
 
 #define ZERO_OBJECT(x) memset(&(x), 0x0, sizeof((x)))
@@ -108,11 +116,32 @@ static const char error_text[ERROR_N_ITEMS][20] = { "None",
  * Generic buffers with headroom to accommodate packet headers and custom
  * copy constructors & assignment operators for quick copying. Byte buffer
  * holds a next pointer to support linked lists.
+ *
+ * Byte buffers are cast to LIBLTE_BYTE_MSG_STRUCT, so N_bytes comes first
+ * and msg starts SRSLTE_BUFFER_HEADER_OFFSET bytes after it. The rest of
+ * the object header lives in that area (LIBLTE never touches it) and the
+ * headroom is what is left of it. Pooled buffers of the small and medium
+ * classes are only allocated up to the end of their payload. Storage is
+ * never zeroed, only N_bytes of msg are valid.
  *****************************************************************************/
+typedef enum {
+  SRSLTE_BUFFER_SMALL = 0,
+  SRSLTE_BUFFER_MEDIUM,
+  SRSLTE_BUFFER_LARGE,
+  SRSLTE_BUFFER_N_CLASSES
+} byte_buffer_class_t;
+
+static const uint32_t byte_buffer_class_payload[SRSLTE_BUFFER_N_CLASSES] = {
+  SRSLTE_BUFFER_SMALL_BYTES,
+  SRSLTE_BUFFER_MEDIUM_BYTES,
+  SRSLTE_MAX_BUFFER_SIZE_BYTES - SRSLTE_BUFFER_HEADER_OFFSET
+};
+
+#define SRSLTE_BUFFER_MSG_OFFSET (sizeof(uint32_t) + SRSLTE_BUFFER_HEADER_OFFSET)
+
 class byte_buffer_t{
 public:
     uint32_t    N_bytes;
-    uint8_t     buffer[SRSLTE_MAX_BUFFER_SIZE_BYTES];
     uint8_t    *msg;
 #ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
     char        debug_name[SRSLTE_BUFFER_POOL_LOG_NAME_LEN];
@@ -120,17 +149,18 @@ public:
 
     byte_buffer_t():N_bytes(0)
     {
-      bzero(buffer, SRSLTE_MAX_BUFFER_SIZE_BYTES);
-      timestamp_is_set = false;
-      msg  = &buffer[SRSLTE_BUFFER_HEADER_OFFSET];
-      next = NULL; 
-#ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
-      bzero(debug_name, SRSLTE_BUFFER_POOL_LOG_NAME_LEN);
-#endif
+      init(SRSLTE_BUFFER_LARGE);
+    }
+    // Only for the buffer pool: the object may be truncated after the
+    // payload of its class
+    explicit byte_buffer_t(byte_buffer_class_t size_class_):N_bytes(0)
+    {
+      init(size_class_);
     }
     byte_buffer_t(const byte_buffer_t& buf)
     {
-      bzero(buffer, SRSLTE_MAX_BUFFER_SIZE_BYTES);
+      init(SRSLTE_BUFFER_LARGE);
+      msg     = buffer + (buf.msg - buf.buffer);
       N_bytes = buf.N_bytes;
       memcpy(msg, buf.msg, N_bytes);
     }
@@ -139,14 +169,13 @@ public:
       // avoid self assignment
       if (&buf == this)
         return *this;
-      bzero(buffer, SRSLTE_MAX_BUFFER_SIZE_BYTES);
       N_bytes = buf.N_bytes;
       memcpy(msg, buf.msg, N_bytes);
       return *this;
     }
     void reset()
     {
-      msg       = &buffer[SRSLTE_BUFFER_HEADER_OFFSET];
+      msg       = (uint8_t*) this + SRSLTE_BUFFER_MSG_OFFSET;
       N_bytes   = 0;
       timestamp_is_set = false; 
     }
@@ -157,7 +186,17 @@ public:
     // Returns the remaining space from what is reported to be the length of msg
     uint32_t get_tailroom()
     {
-      return (sizeof(buffer) - (msg-buffer) - N_bytes);
+      return ((uint8_t*) this + SRSLTE_BUFFER_MSG_OFFSET + byte_buffer_class_payload[size_class]) - (msg + N_bytes);
+    }
+    byte_buffer_class_t get_size_class()
+    {
+      return size_class;
+    }
+    // Bytes a pool needs per buffer of the given class
+    static uint32_t class_stride(byte_buffer_class_t c)
+    {
+      uint32_t len = c == SRSLTE_BUFFER_LARGE ? sizeof(byte_buffer_t) : SRSLTE_BUFFER_MSG_OFFSET + byte_buffer_class_payload[c];
+      return (len + 63) & ~63;
     }
     long get_latency_us()
     {
@@ -182,9 +221,24 @@ public:
 
 private:
 
-    struct timeval timestamp[3];
-    bool           timestamp_is_set; 
-    byte_buffer_t *next;
+    void init(byte_buffer_class_t size_class_)
+    {
+      size_class = size_class_;
+      next       = NULL;
+      reset();
+#ifdef SRSLTE_BUFFER_POOL_LOG_ENABLED
+      bzero(debug_name, SRSLTE_BUFFER_POOL_LOG_NAME_LEN);
+#endif
+    }
+
+    struct timeval      timestamp[3];
+    bool                timestamp_is_set; 
+    byte_buffer_t      *next;
+    byte_buffer_class_t size_class;
+
+public:
+    // Headroom followed by the payload, must be the last member
+    uint8_t     buffer[SRSLTE_MAX_BUFFER_SIZE_BYTES];
 };
 
 struct bit_buffer_t{
@@ -47,6 +47,10 @@
                               TYPEDEFS
 *******************************************************************************/
 
+typedef struct{
+    uint8 rk[11][4][4];
+}LIBLTE_SECURITY_ROUND_KEY_STRUCT;
+
 
 /*******************************************************************************
                               DECLARATIONS
@@ -119,20 +123,24 @@ typedef enum{
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_EEA0 = 0,
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA1,
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA2,
+    LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_128_EEA3,
     LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS,
 }LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_ENUM;
 static const char liblte_security_ciphering_algorithm_id_text[LIBLTE_SECURITY_CIPHERING_ALGORITHM_ID_N_ITEMS][20] = {"EEA0",
                                                                                                                      "128-EEA1",
-                                                                                                                     "128-EEA2"};
+                                                                                                                     "128-EEA2",
+                                                                                                                     "128-EEA3"};
 typedef enum{
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_EIA0 = 0,
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA1,
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA2,
+    LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_128_EIA3,
     LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_N_ITEMS,
 }LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_ENUM;
 static const char liblte_security_integrity_algorithm_id_text[LIBLTE_SECURITY_INTEGRITY_ALGORITHM_ID_N_ITEMS][20] = {"EIA0",
                                                                                                                      "128-EIA1",
-                                                                                                                     "128-EIA2"};
+                                                                                                                     "128-EIA2",
+                                                                                                                     "128-EIA3"};
 // Structs
 // Functions
 LIBLTE_ERROR_ENUM liblte_security_generate_k_nas(uint8                                       *k_asme,
@@ -356,4 +364,50 @@ LIBLTE_ERROR_ENUM liblte_security_milenage_f5_star(uint8 *k,
                                                    uint8 *rand,
                                                    uint8 *ak);
 
+/*********************************************************************
+    Name: liblte_security_milenage_init
+
+    Description: Computes the Rijndael round keys of a subscriber's
+                 key K once, so that Milenage can be run for many
+                 RANDs without repeating the key schedule.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+typedef struct{
+    LIBLTE_SECURITY_ROUND_KEY_STRUCT round_keys;
+    uint8                            op_c[16];
+}LIBLTE_SECURITY_MILENAGE_CTX_STRUCT;
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_milenage_init(uint8                               *k,
+                                                uint8                               *op_c,
+                                                LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *ctx);
+
+/*********************************************************************
+    Name: liblte_security_milenage_f12345
+
+    Description: Milenage security functions F1, F2, F3, F4, and F5
+                 from a context set up by liblte_security_milenage_init.
+                 Computes MAC-A, RES, CK, IK, and AK of one
+                 authentication vector, sharing the first Rijndael
+                 block (TEMP) between F1 and F2-F5.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+// Defines
+// Enums
+// Structs
+// Functions
+LIBLTE_ERROR_ENUM liblte_security_milenage_f12345(LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *ctx,
+                                                  uint8                               *rand,
+                                                  uint8                               *sqn,
+                                                  uint8                               *amf,
+                                                  uint8                               *mac_a,
+                                                  uint8                               *res,
+                                                  uint8                               *ck,
+                                                  uint8                               *ik,
+                                                  uint8                               *ak);
+
 #endif // SRSLTE_LIBLTE_SECURITY_H
@@ -6,7 +6,7 @@
 #include "polarssl/sha256.h"
 #include "polarssl/aes.h"
 
-void sha256(const unsigned char *key, size_t keylen,
+inline void sha256(const unsigned char *key, size_t keylen,
             const unsigned char *input, size_t ilen,
             unsigned char output[32], int is224 )
 {
@@ -25,12 +25,12 @@ typedef mbedtls_aes_context aes_context;
 #define AES_ENCRYPT     1
 #define AES_DECRYPT     0
 
-int aes_setkey_enc( aes_context *ctx, const unsigned char *key, unsigned int keysize )
+inline int aes_setkey_enc( aes_context *ctx, const unsigned char *key, unsigned int keysize )
 {
   return mbedtls_aes_setkey_enc(ctx, key, keysize);
 }
 
-int aes_crypt_ecb( aes_context *ctx,
+inline int aes_crypt_ecb( aes_context *ctx,
                     int mode,
                     const unsigned char input[16],
                     unsigned char output[16] )
@@ -38,7 +38,7 @@ int aes_crypt_ecb( aes_context *ctx,
   return mbedtls_aes_crypt_ecb(ctx, mode, input, output);
 }
 
-int aes_crypt_ctr(aes_context *ctx,
+inline int aes_crypt_ctr(aes_context *ctx,
                   size_t length,
                   size_t *nc_off,
                   unsigned char nonce_counter[16],
@@ -50,7 +50,7 @@ int aes_crypt_ctr(aes_context *ctx,
       stream_block, input, output);
 }
 
-void sha256(const unsigned char *key, size_t keylen,
+inline void sha256(const unsigned char *key, size_t keylen,
             const unsigned char *input, size_t ilen,
             unsigned char output[32], int is224 )
 {
@@ -29,7 +29,8 @@
  * Description: Log filter for a specific layer or element.
  *              Performs filtering based on log level, generates
  *              timestamped log strings and passes them to the
- *              common logger object.
+ *              common logger object. With a logger_async the
+ *              arguments are queued and formatted by the logger.
  *****************************************************************************/
 
 #ifndef SRSLTE_LOG_FILTER_H
@@ -42,6 +43,7 @@
 #include "srslte/common/log.h"
 #include "srslte/common/logger.h"
 #include "srslte/common/logger_stdout.h"
+#include "srslte/common/logger_async.h"
 
 namespace srslte {
 
@@ -81,8 +83,9 @@ public:
   void set_time_src(time_itf *source, time_format_t format);
 
 private:
-  logger *logger_h;
-  bool    do_tti;
+  logger       *logger_h;
+  logger_async *async_h;
+  bool          do_tti;
 
   time_itf      *time_src;
   time_format_t time_format;
@@ -91,6 +94,8 @@ private:
 
   void all_log(srslte::LOG_LEVEL_ENUM level, uint32_t tti, const char *msg);
   void all_log(srslte::LOG_LEVEL_ENUM level, uint32_t tti, const char *msg, const uint8_t *hex, int size);
+  void all_log_va(srslte::LOG_LEVEL_ENUM level, uint32_t tti, bool dump, const uint8_t *hex, int size,
+                  const char *msg, va_list args);
   void all_log_line(srslte::LOG_LEVEL_ENUM level, uint32_t tti, std::string file, int line, char *msg);
   std::string now_time();
   std::string hex_string(const uint8_t *hex, int size);
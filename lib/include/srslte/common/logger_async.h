@@ -0,0 +1,148 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        logger_async.h
+ * Description: Asynchronous logger for log_filter. Each producer thread owns
+ *              a lock-free ring of fixed-size binary records holding the
+ *              format string pointer, the raw arguments, TTI and timestamp.
+ *              The logger thread formats them and writes the lines to
+ *              file, so a log call costs a format scan and a few copies.
+ *              A record is dropped (and counted) if the ring is full.
+ *****************************************************************************/
+
+#ifndef SRSLTE_LOGGER_ASYNC_H
+#define SRSLTE_LOGGER_ASYNC_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include "srslte/common/logger.h"
+#include "srslte/common/threads.h"
+#include "srslte/common/ring_queue.h"
+
+#define SRSLTE_LOG_RECORD_LEN   256   // bytes per record, header included
+#define SRSLTE_LOG_RING_LEN     4096  // records per producer thread
+#define SRSLTE_LOG_LINE_LEN     8192  // longest line the logger thread writes
+
+namespace srslte {
+
+typedef std::string* str_ptr;
+
+/* Record flags, they carry the log_filter settings at the time of the call */
+#define SRSLTE_LOG_SHOW_LAYER   0x01
+#define SRSLTE_LOG_LEVEL_SHORT  0x02
+#define SRSLTE_LOG_TTI          0x04
+#define SRSLTE_LOG_PREPEND      0x08  // prepended string follows the layer name
+#define SRSLTE_LOG_HEX          0x10  // *_hex() call: line ends with a newline
+#define SRSLTE_LOG_TIME_SRC     0x20  // time comes from log_filter::time_itf
+#define SRSLTE_LOG_EPOCH        0x40
+#define SRSLTE_LOG_FMT_INLINE   0x80  // format string copied into the payload
+
+/* Payload: layer name, [prepended string], [format string], hex dump and
+ * the arguments in 8-byte slots. A record with a NULL fmt carries a
+ * preformatted string instead.
+ */
+typedef struct {
+  const char    *fmt;
+  std::string   *str;
+  int64_t        secs;
+  uint32_t       usec;
+  uint32_t       tti;
+  uint16_t       hex_offset;
+  uint16_t       hex_size;
+  uint16_t       args_offset;
+  uint8_t        level;
+  uint8_t        flags;
+  uint8_t        payload[SRSLTE_LOG_RECORD_LEN - 40];
+} log_record_t;
+
+class logger_async : public thread, public logger
+{
+public:
+  logger_async();
+  ~logger_async();
+  void init(std::string file, int max_length = -1);
+  // Implementation of logger, strings are queued in order with the records
+  void log(str_ptr msg);
+  void log(const char *msg);
+
+  /* Queues a log_filter call. Returns false, without consuming anything,
+   * if the arguments don't fit in a record and the caller must format the
+   * line itself.
+   */
+  bool log_va(uint8_t level, uint8_t flags, uint32_t tti, int64_t secs, uint32_t usec,
+              const char *layer, const char *prepend,
+              const uint8_t *hex, int hex_size, const char *fmt, va_list args);
+
+  uint64_t get_nof_dropped();
+  // Records of the calling thread the logger thread has not written yet
+  uint32_t get_nof_queued();
+
+private:
+  typedef struct {
+    spsc_ring<log_record_t> *ring;
+    bool                     closed;
+  } producer_t;
+
+  log_record_t* get_slot();
+  void          commit();
+  static void   producer_release(void *arg);
+
+  void run_thread();
+  bool drain();
+  void write_record(log_record_t *r);
+  void write_line(const char *line, uint32_t len);
+
+  uint32_t print_time(log_record_t *r, char *out, uint32_t max);
+  uint32_t print_msg(log_record_t *r, const char *fmt, char *out, uint32_t max);
+
+  uint32_t              name_idx;
+  int64_t               max_length;
+  int64_t               cur_length;
+  FILE*                 logfile;
+  bool                  is_running;
+  std::string           filename;
+
+  pthread_key_t             producer_key;
+  pthread_mutex_t           mutex;
+  std::vector<producer_t*>  producers;
+  ring_queue_event          not_empty;
+  uint64_t                  nof_dropped;
+  uint64_t                  nof_dropped_reported;
+
+  // Logger thread state
+  int64_t               last_secs;
+  char                  last_time[16];
+  char                  line[SRSLTE_LOG_LINE_LEN];
+};
+
+} // namespace srslte
+
+#endif // SRSLTE_LOGGER_ASYNC_H
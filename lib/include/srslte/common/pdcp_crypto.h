@@ -0,0 +1,109 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/******************************************************************************
+ *  File:         pdcp_crypto.h
+ *  Description:  Ciphering and integrity protection of PDCP SDUs with keys
+ *                prepared once, when the bearer's security is configured.
+ *                EEA2 runs AES-CTR a block at a time from the cached key
+ *                schedule and EIA2 computes the CMAC directly over the
+ *                SDU with precomputed subkeys, so neither copies the SDU
+ *                nor expands the key per packet. EEA1/EIA1 (SNOW 3G) and
+ *                EEA3/EIA3 (ZUC) keep their state on the stack of each
+ *                call. An instance is used by one thread at a time.
+ *****************************************************************************/
+
+
+#ifndef SRSLTE_PDCP_CRYPTO_H
+#define SRSLTE_PDCP_CRYPTO_H
+
+#include <stdint.h>
+#include "srslte/common/security.h"
+#include "srslte/common/liblte_ssl.h"
+
+namespace srslte {
+
+typedef struct{
+  uint32_t  count;
+  uint8_t  *msg;      // ciphered in place
+  uint32_t  len;      // bytes
+}pdcp_crypto_sdu_t;
+
+class pdcp_crypto
+{
+public:
+  pdcp_crypto();
+
+  // 128-bit keys, i.e. the last 16 bytes of the derived 256-bit keys
+  void set_keys(uint8_t *k_enc_,
+                uint8_t *k_int_,
+                CIPHERING_ALGORITHM_ID_ENUM cipher_algo_,
+                INTEGRITY_ALGORITHM_ID_ENUM integ_algo_);
+
+  // msg and out may be the same buffer
+  void cipher(uint32_t  count,
+              uint8_t   bearer,
+              uint8_t   direction,
+              uint8_t  *msg,
+              uint32_t  len,
+              uint8_t  *out);
+
+  // Ciphers nof_sdus SDUs of one bearer in place
+  void cipher_batch(uint8_t            bearer,
+                    uint8_t            direction,
+                    pdcp_crypto_sdu_t *sdus,
+                    uint32_t           nof_sdus);
+
+  void integrity(uint32_t  count,
+                 uint8_t   bearer,
+                 uint8_t   direction,
+                 uint8_t  *msg,
+                 uint32_t  len,
+                 uint8_t  *mac);
+
+private:
+  // The AES contexts point into themselves, so they must not be copied
+  pdcp_crypto(const pdcp_crypto&);
+  pdcp_crypto& operator=(const pdcp_crypto&);
+
+  void eea2(uint32_t count, uint8_t bearer, uint8_t direction, uint8_t *msg, uint32_t len, uint8_t *out);
+  void eia2(uint32_t count, uint8_t bearer, uint8_t direction, uint8_t *msg, uint32_t len, uint8_t *mac);
+
+  CIPHERING_ALGORITHM_ID_ENUM cipher_algo;
+  INTEGRITY_ALGORITHM_ID_ENUM integ_algo;
+
+  uint8_t     k_enc[16];
+  uint8_t     k_int[16];
+  aes_context aes_enc;      // EEA2 key schedule
+  aes_context aes_int;      // EIA2 key schedule
+  uint8_t     cmac_k1[16];  // EIA2 subkeys, RFC4493
+  uint8_t     cmac_k2[16];
+};
+
+} // namespace srslte
+
+#endif // SRSLTE_PDCP_CRYPTO_H
@@ -0,0 +1,471 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/******************************************************************************
+ *  File:         ring_queue.h
+ *  Description:  Bounded lock-free queues with the block_queue API. spsc_queue
+ *                is a single-producer/single-consumer ring, mpmc_queue a
+ *                multi-producer/multi-consumer ring with per-slot sequence
+ *                numbers. Blocking push/pop spin for an adaptive number of
+ *                iterations and then sleep on a futex, so the uncontended
+ *                path never enters the kernel. Unlike block_queue the
+ *                capacity is fixed (rounded up to a power of two) and there
+ *                is no mutexed callback nor front().
+ *****************************************************************************/
+
+
+#ifndef SRSLTE_RING_QUEUE_H
+#define SRSLTE_RING_QUEUE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <strings.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#define SRSLTE_RING_QUEUE_CACHE_LINE  64
+#define SRSLTE_RING_QUEUE_MIN_SPIN    16
+#define SRSLTE_RING_QUEUE_MAX_SPIN    2048
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SRSLTE_RING_QUEUE_RELAX() __builtin_ia32_pause()
+#else
+#define SRSLTE_RING_QUEUE_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+namespace srslte {
+
+/* Event counter used to sleep until the other side of the ring made
+ * progress. Bit 0 of the counter flags sleeping waiters: a waiter sets it,
+ * re-checks the ring and sleeps only if the counter did not move. A notifier
+ * only bumps the counter and enters the kernel when the bit is set, which
+ * also clears it, so a burst of pushes costs at most one futex wake.
+ */
+class ring_queue_event {
+public:
+  ring_queue_event() : seq(0) {}
+
+  uint32_t prepare_wait() {
+    uint32_t s = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+    while (!(s & 1)) {
+      if (__atomic_compare_exchange_n(&seq, &s, s | 1, true, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)) {
+        s |= 1;
+      }
+    }
+    // Orders the flag before the caller re-checks the ring
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return s;
+  }
+  void wait(uint32_t s) {
+    syscall(SYS_futex, &seq, FUTEX_WAIT_PRIVATE, s, NULL, NULL, 0);
+  }
+  void notify() {
+    // Orders the caller's ring update before reading the flag
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint32_t s = __atomic_load_n(&seq, __ATOMIC_RELAXED);
+    while (s & 1) {
+      if (__atomic_compare_exchange_n(&seq, &s, s + 1, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        syscall(SYS_futex, &seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+        break;
+      }
+    }
+  }
+  void notify_all() {
+    __atomic_add_fetch(&seq, 2, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+  }
+
+private:
+  uint32_t seq;
+};
+
+static inline uint32_t ring_queue_pow2(uint32_t n) {
+  uint32_t p = 2;
+  while (p < n && p < (1u << 31)) {
+    p <<= 1;
+  }
+  return p;
+}
+
+/* Lamport ring: the producer owns tail, the consumer owns head and each side
+ * keeps a cached copy of the other index to avoid sharing the cache line on
+ * every operation.
+ */
+template<typename myobj>
+class spsc_ring {
+public:
+  spsc_ring(uint32_t capacity) {
+    cap    = ring_queue_pow2(capacity);
+    mask   = cap - 1;
+    buffer = new myobj[cap];
+    head = head_cache = 0;
+    tail = tail_cache = 0;
+  }
+  ~spsc_ring() {
+    delete [] buffer;
+  }
+
+  bool try_push(const myobj &value) {
+    uint32_t t = tail;
+    if (t - head_cache >= cap) {
+      head_cache = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+      if (t - head_cache >= cap) {
+        return false;
+      }
+    }
+    buffer[t & mask] = value;
+    __atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  bool try_pop(myobj *value) {
+    uint32_t h = head;
+    if (h == tail_cache) {
+      tail_cache = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+      if (h == tail_cache) {
+        return false;
+      }
+    }
+    if (value) {
+      *value = buffer[h & mask];
+    }
+    __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  /* Zero-copy variants for large elements: the producer fills the slot
+   * returned by push_slot() and publishes it with push_commit(), the
+   * consumer reads pop_slot() and frees it with pop_release().
+   */
+  myobj* push_slot() {
+    uint32_t t = tail;
+    if (t - head_cache >= cap) {
+      head_cache = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+      if (t - head_cache >= cap) {
+        return NULL;
+      }
+    }
+    return &buffer[t & mask];
+  }
+  void push_commit() {
+    __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+  }
+  myobj* pop_slot() {
+    uint32_t h = head;
+    if (h == tail_cache) {
+      tail_cache = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+      if (h == tail_cache) {
+        return NULL;
+      }
+    }
+    return &buffer[h & mask];
+  }
+  void pop_release() {
+    __atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+  }
+
+  uint32_t size() {
+    return __atomic_load_n(&tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+  }
+  uint32_t capacity() {
+    return cap;
+  }
+
+private:
+  myobj   *buffer;
+  uint32_t cap;
+  uint32_t mask;
+  char     pad0[SRSLTE_RING_QUEUE_CACHE_LINE];
+  uint32_t head;        // consumer
+  uint32_t tail_cache;
+  char     pad1[SRSLTE_RING_QUEUE_CACHE_LINE];
+  uint32_t tail;        // producer
+  uint32_t head_cache;
+  char     pad2[SRSLTE_RING_QUEUE_CACHE_LINE];
+};
+
+/* Bounded MPMC ring (D. Vyukov). Each slot carries a sequence number that
+ * tells producers and consumers whether it is free for lap n or holds the
+ * element of lap n, so a push or pop is one CAS on the shared index plus
+ * one release store on the slot.
+ */
+template<typename myobj>
+class mpmc_ring {
+public:
+  mpmc_ring(uint32_t capacity) {
+    cap   = ring_queue_pow2(capacity);
+    mask  = cap - 1;
+    cells = new cell_t[cap];
+    for (uint32_t i = 0; i < cap; i++) {
+      cells[i].seq = i;
+    }
+    enqueue_pos = 0;
+    dequeue_pos = 0;
+  }
+  ~mpmc_ring() {
+    delete [] cells;
+  }
+
+  bool try_push(const myobj &value) {
+    cell_t  *c;
+    uint32_t pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+    while (true) {
+      c = &cells[pos & mask];
+      int32_t diff = (int32_t) (__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+      if (diff == 0) {
+        if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+      }
+    }
+    c->data = value;
+    __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  bool try_pop(myobj *value) {
+    cell_t  *c;
+    uint32_t pos = __atomic_load_n(&dequeue_pos, __ATOMIC_RELAXED);
+    while (true) {
+      c = &cells[pos & mask];
+      int32_t diff = (int32_t) (__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+      if (diff == 0) {
+        if (__atomic_compare_exchange_n(&dequeue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = __atomic_load_n(&dequeue_pos, __ATOMIC_RELAXED);
+      }
+    }
+    if (value) {
+      *value = c->data;
+    }
+    __atomic_store_n(&c->seq, pos + mask + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  uint32_t size() {
+    int32_t n = (int32_t) (__atomic_load_n(&enqueue_pos, __ATOMIC_ACQUIRE) -
+                           __atomic_load_n(&dequeue_pos, __ATOMIC_ACQUIRE));
+    return n < 0 ? 0 : (uint32_t) n;
+  }
+  uint32_t capacity() {
+    return cap;
+  }
+
+private:
+  typedef struct {
+    uint32_t seq;
+    myobj    data;
+  } cell_t;
+
+  cell_t  *cells;
+  uint32_t cap;
+  uint32_t mask;
+  char     pad0[SRSLTE_RING_QUEUE_CACHE_LINE];
+  uint32_t enqueue_pos;
+  char     pad1[SRSLTE_RING_QUEUE_CACHE_LINE];
+  uint32_t dequeue_pos;
+  char     pad2[SRSLTE_RING_QUEUE_CACHE_LINE];
+};
+
+/* block_queue front-end shared by both rings */
+template<typename myobj, class ring_t>
+class ring_queue {
+public:
+  ring_queue(uint32_t capacity) : ring(capacity) {
+    enable      = true;
+    num_threads = 0;
+    spin_count  = SRSLTE_RING_QUEUE_MIN_SPIN;
+  }
+  ~ring_queue() {
+    // Unlock threads waiting at push or pop and wait for them to exit
+    __atomic_store_n(&enable, false, __ATOMIC_SEQ_CST);
+    not_empty.notify_all();
+    not_full.notify_all();
+    while (__atomic_load_n(&num_threads, __ATOMIC_ACQUIRE) > 0) {
+      usleep(100);
+    }
+  }
+
+  void push(const myobj& value) {
+    push_(value, true);
+  }
+
+  bool try_push(const myobj& value) {
+    return push_(value, false);
+  }
+
+  bool try_pop(myobj *value) {
+    return pop_(value, false);
+  }
+
+  myobj wait_pop() { // blocking pop
+    myobj value;
+    bzero(&value, sizeof(myobj));
+    pop_(&value, true);
+    return value;
+  }
+
+  bool empty() {
+    return ring.size() == 0;
+  }
+
+  void clear() { // remove all items
+    while (ring.try_pop(NULL)) {
+      not_full.notify();
+    }
+  }
+
+  size_t size() {
+    return ring.size();
+  }
+
+  uint32_t capacity() {
+    return ring.capacity();
+  }
+
+private:
+
+  bool pop_(myobj *value, bool block) {
+    if (ring.try_pop(value)) {
+      not_full.notify();
+      return true;
+    }
+    if (!block) {
+      return false;
+    }
+    __atomic_add_fetch(&num_threads, 1, __ATOMIC_SEQ_CST);
+    bool ret = wait_for(&ring_queue::do_pop, &not_empty, value, NULL);
+    __atomic_sub_fetch(&num_threads, 1, __ATOMIC_SEQ_CST);
+    if (ret) {
+      not_full.notify();
+    }
+    return ret;
+  }
+
+  bool push_(const myobj& value, bool block) {
+    if (!__atomic_load_n(&enable, __ATOMIC_RELAXED)) {
+      return false;
+    }
+    if (ring.try_push(value)) {
+      not_empty.notify();
+      return true;
+    }
+    if (!block) {
+      return false;
+    }
+    __atomic_add_fetch(&num_threads, 1, __ATOMIC_SEQ_CST);
+    bool ret = wait_for(&ring_queue::do_push, &not_full, NULL, &value);
+    __atomic_sub_fetch(&num_threads, 1, __ATOMIC_SEQ_CST);
+    if (ret) {
+      not_empty.notify();
+    }
+    return ret;
+  }
+
+  bool do_pop(myobj *value, const myobj *unused) {
+    return ring.try_pop(value);
+  }
+  bool do_push(myobj *unused, const myobj *value) {
+    return ring.try_push(*value);
+  }
+
+  /* Spins up to about twice the running average of the spins that were
+   * enough to complete the operation, then sleeps on the event. Spinning
+   * that ends up sleeping shrinks the budget, so on an oversubscribed host
+   * it decays to SRSLTE_RING_QUEUE_MIN_SPIN.
+   */
+  bool wait_for(bool (ring_queue::*op)(myobj*, const myobj*), ring_queue_event *ev,
+                myobj *out, const myobj *in) {
+    int32_t spins     = __atomic_load_n(&spin_count, __ATOMIC_RELAXED);
+    int32_t max_spins = spins * 2 + 10;
+    if (max_spins > SRSLTE_RING_QUEUE_MAX_SPIN) {
+      max_spins = SRSLTE_RING_QUEUE_MAX_SPIN;
+    }
+    int32_t i = 0;
+    bool    done = false;
+    while (i < max_spins && !done) {
+      SRSLTE_RING_QUEUE_RELAX();
+      done = (this->*op)(out, in);
+      i++;
+    }
+    if (done) {
+      spins += (i - spins) / 8;
+    } else {
+      spins -= spins / 8;
+    }
+    if (spins < SRSLTE_RING_QUEUE_MIN_SPIN) {
+      spins = SRSLTE_RING_QUEUE_MIN_SPIN;
+    }
+    __atomic_store_n(&spin_count, spins, __ATOMIC_RELAXED);
+
+    while (!done) {
+      uint32_t s = ev->prepare_wait();
+      if ((this->*op)(out, in)) {
+        return true;
+      }
+      if (!__atomic_load_n(&enable, __ATOMIC_SEQ_CST)) {
+        return false;
+      }
+      ev->wait(s);
+      done = (this->*op)(out, in);
+    }
+    return true;
+  }
+
+  ring_t           ring;
+  ring_queue_event not_empty;
+  ring_queue_event not_full;
+  bool             enable;
+  uint32_t         num_threads;
+  int32_t          spin_count;
+};
+
+template<typename myobj>
+class spsc_queue : public ring_queue<myobj, spsc_ring<myobj> > {
+public:
+  spsc_queue(uint32_t capacity = 1024) : ring_queue<myobj, spsc_ring<myobj> >(capacity) {}
+};
+
+template<typename myobj>
+class mpmc_queue : public ring_queue<myobj, mpmc_ring<myobj> > {
+public:
+  mpmc_queue(uint32_t capacity = 1024) : ring_queue<myobj, mpmc_ring<myobj> >(capacity) {}
+};
+
+} // namespace srslte
+
+#endif // SRSLTE_RING_QUEUE_H
@@ -21,14 +21,25 @@ typedef unsigned char u8;
 typedef unsigned int u32;
 typedef unsigned long long u64;
 
+/* State of one SNOW 3G instance. Every f8/f9 call uses its own, so
+* they can run concurrently.
+*/
+
+typedef struct {
+	u32 LFSR_S[16];
+	u32 FSM_R1;
+	u32 FSM_R2;
+	u32 FSM_R3;
+} snow3g_state_t;
+
 /* Initialization.
 * Input k[4]: Four 32-bit words making up 128-bit key.
 * Input IV[4]: Four 32-bit words making 128-bit initialization variable.
-* Output: All the LFSRs and FSM are initialized for key generation.
+* Output: All the LFSRs and FSM of state are initialized for key generation.
 * See Section 4.1.
 */
 
-void snow3g_initialize(u32 k[4], u32 IV[4]);
+void snow3g_initialize(snow3g_state_t *state, u32 k[4], u32 IV[4]);
 
 /* Generation of Keystream.
 * input n: number of 32-bit words of keystream.
@@ -38,7 +49,7 @@ void snow3g_initialize(u32 k[4], u32 IV[4]);
 * See section 4.2.
 */
 
-void snow3g_generate_keystream(u32 n, u32 *z);
+void snow3g_generate_keystream(snow3g_state_t *state, u32 n, u32 *z);
 
 /* f8.
 * Input key: 128 bit Confidentiality Key.
@@ -64,11 +75,11 @@ void snow3g_f8( u8 *key, u32 count, u32 bearer, u32 dir, \
 * Input dir:1 bit, direction of transmission (in the LSB).
 * Input data: length number of bits, input bit stream.
 * Input length: 64 bit Length, i.e., the number of bits to be MAC'd.
-* Output : 32 bit block used as MAC
+* Output mac: 32 bit block used as MAC
 * Generates 32-bit MAC using UIA2 algorithm as defined in Section 4.
 */
 
-u8* snow3g_f9( u8* key, u32 count, u32 fresh, u32 dir, \
-                 u8 *data, u64 length);
+void snow3g_f9( u8* key, u32 count, u32 fresh, u32 dir, \
+                 u8 *data, u64 length, u8 *mac);
 
-#endif // SRSLTE_SNOW_3G_H
\ No newline at end of file
+#endif // SRSLTE_SNOW_3G_H
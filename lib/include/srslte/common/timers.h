@@ -29,6 +29,10 @@
  *  File:         timers.h
  *  Description:  Manually incremented timers. Call a callback function upon
  *                expiry.
+ *                Running timers sit in a hierarchical timing wheel (4 levels
+ *                of 64 slots), so start, stop and expiry are O(1) and
+ *                step_all() only touches the timers that expire (or cascade
+ *                down a level) in that step.
  *  Reference:
  *****************************************************************************/
 
@@ -40,6 +44,10 @@
 #include <vector>
 #include <time.h>
 
+#define SRSLTE_TIMERS_WHEEL_BITS    6
+#define SRSLTE_TIMERS_WHEEL_SLOTS   (1 << SRSLTE_TIMERS_WHEEL_BITS)
+#define SRSLTE_TIMERS_WHEEL_LEVELS  4
+
 namespace srslte {
   
 class timer_callback 
@@ -51,35 +59,51 @@ class timer_callback
 class timers
 {
 public:
-  class timer
+  // Intrusive list link of a timer, the wheel slots are sentinels
+  class timer_link
+  {
+  public:
+    timer_link() {prev = NULL; next = NULL; }
+    timer_link *prev;
+    timer_link *next;
+  };
+
+  /* A timer counts steps while running. Timers of a timers object keep the
+   * counter as its value when they were last (re)started and derive the
+   * current one from the owner's step count; standalone timers are stepped
+   * one by one.
+   */
+  class timer : public timer_link
   {
   public:
-    timer(uint32_t id_=0) {id = id_; counter = 0; timeout = 0; running = false; callback = NULL; }
+    timer(uint32_t id_=0) {id = id_; counter = 0; timeout = 0; running = false; callback = NULL; owner = NULL; base = 0; expiry = 0; }
     void set(timer_callback *callback_, uint32_t timeout_) {
       callback = callback_; 
       timeout = timeout_; 
       reset();
     }
     bool is_running() {
-      return (counter < timeout) && running; 
+      return running && (value() < timeout);
     }
     bool is_expired() {
-      return (timeout > 0) && (counter >= timeout);
+      return (timeout > 0) && (value() >= timeout);
     }
     uint32_t get_timeout() {
       return timeout; 
     }
     void reset() {
       counter = 0; 
+      restart();
     }
     uint32_t value() {
-      return counter;
+      return (running && owner) ? counter + (owner->now - base) : counter;
     }
     void step() {
       if (running) {
-        counter++;
+        counter = value() + 1;
+        restart();
         if (is_expired()) {
-          running = false; 
+          stop();
           if (callback) {
             callback->timer_expired(id); 
           }
@@ -87,32 +111,99 @@ public:
       }
     }
     void stop() {
-      running = false; 
+      if (running) {
+        counter = value();
+        running = false; 
+        if (owner) {
+          owner->unlink(this);
+        }
+      }
     }
     void run() {
-      running = true; 
+      if (!running) {
+        running = true; 
+        restart();
+      }
     }
     uint32_t id; 
   private: 
+    friend class timers;
+
+    // counter is the value as of now, (re)schedules the expiry
+    void restart() {
+      if (running && owner) {
+        base    = owner->now;
+        owner->unlink(this);
+        if (timeout > 0) {
+          expiry = base + (counter < timeout ? timeout - counter : 1);
+          owner->schedule(this);
+        }
+      }
+    }
+
     timer_callback *callback; 
     uint32_t timeout; 
     uint32_t counter; 
     bool running; 
+    timers  *owner;
+    uint32_t base;    // owner step count when counter was taken
+    uint32_t expiry;  // owner step count at which the timer expires
   };
   
   timers(uint32_t nof_timers_) : timer_list(nof_timers_),used_timers(nof_timers_) {
     nof_timers = nof_timers_; 
     next_timer = 0;
     nof_used_timers = 0;
+    now = 0;
     for (uint32_t i=0;i<nof_timers;i++) {
       timer_list[i].id = i;
+      timer_list[i].owner = this;
       used_timers[i] = false;
     }
+    free_ids.reserve(nof_timers);
+    for (uint32_t i=nof_timers;i>0;i--) {
+      free_ids.push_back(i-1);
+    }
+    for (uint32_t l=0;l<SRSLTE_TIMERS_WHEEL_LEVELS;l++) {
+      for (uint32_t i=0;i<SRSLTE_TIMERS_WHEEL_SLOTS;i++) {
+        list_init(&wheel[l][i]);
+      }
+    }
+    list_init(&expiring);
+  }
+
+  // Timers point back to this object
+  ~timers() {
+    for (uint32_t i=0;i<nof_timers;i++) {
+      timer_list[i].owner = NULL;
+    }
   }
   
+  /* Advances all running timers by one step. Higher wheel levels are
+   * cascaded when the level below wraps, then the timers due in this step
+   * expire. A callback may start or stop any timer, including itself.
+   */
   void step_all() {
-    for (uint32_t i=0;i<nof_timers;i++) {
-      get(i)->step();
+    now++;
+    for (uint32_t l=1;l<SRSLTE_TIMERS_WHEEL_LEVELS;l++) {
+      if (now & ((1u << (l*SRSLTE_TIMERS_WHEEL_BITS)) - 1)) {
+        break;
+      }
+      cascade(&wheel[l][(now >> (l*SRSLTE_TIMERS_WHEEL_BITS)) & (SRSLTE_TIMERS_WHEEL_SLOTS-1)]);
+    }
+    list_splice(&wheel[0][now & (SRSLTE_TIMERS_WHEEL_SLOTS-1)], &expiring);
+    while (expiring.next != &expiring) {
+      timer *t = (timer*) expiring.next;
+      unlink(t);
+      if (t->expiry != now) {
+        schedule(t);
+        continue;
+      }
+      t->counter = t->value();
+      t->running = false;
+      if (t->callback) {
+        t->callback->timer_expired(t->id);
+      }
     }
   }
   void stop_all() {
@@ -139,36 +230,95 @@ public:
     }
   }
   void release_id(uint32_t i) {
-    if (nof_used_timers > 0 && i < nof_timers) {
+    if (nof_used_timers > 0 && i < nof_timers && used_timers[i]) {
       used_timers[i] = false;
       nof_used_timers--;
+      free_ids.push_back(i);
     } else {
       fprintf(stderr, "Error releasing timer id=%d: nof_used_timers=%d, nof_timers=%d\n", i, nof_used_timers, nof_timers);
     }
   }
   uint32_t get_unique_id() {
-    if (nof_used_timers >= nof_timers) {
+    if (nof_used_timers >= nof_timers || free_ids.empty()) {
       fprintf(stderr, "Error getting unique timer id: no more timers available\n");
       return 0;
     } else {
-      for (uint32_t i=0;i<nof_timers;i++) {
-        if (!used_timers[i]) {
-          used_timers[i] = true;
-          nof_used_timers++;
-          return i;
-        }
-      }
-      fprintf(stderr, "Error getting unique timer id: no more timers available but nof_used_timers=%d, nof_timers=%d\n",
-              nof_used_timers, nof_timers);
-      return 0;
+      uint32_t i = free_ids.back();
+      free_ids.pop_back();
+      used_timers[i] = true;
+      nof_used_timers++;
+      return i;
     }
   }
 private:
+
+  static void list_init(timer_link *l) {
+    l->prev = l;
+    l->next = l;
+  }
+  // Moves all the entries of src to the (empty) list dst
+  static void list_splice(timer_link *src, timer_link *dst) {
+    if (src->next != src) {
+      dst->next       = src->next;
+      dst->prev       = src->prev;
+      dst->next->prev = dst;
+      dst->prev->next = dst;
+      list_init(src);
+    }
+  }
+
+  void unlink(timer *t) {
+    if (t->next) {
+      t->prev->next = t->next;
+      t->next->prev = t->prev;
+      t->prev = NULL;
+      t->next = NULL;
+    }
+  }
+
+  /* Level l holds the timers due within 64^(l+1) steps, in the slot of
+   * their expiry's l-th 6-bit digit. Farther timers go to the last slot
+   * of the top level and are re-filed each time it is cascaded.
+   */
+  void schedule(timer *t) {
+    uint32_t   delta = t->expiry - now;
+    timer_link *slot = NULL;
+    for (uint32_t l=0;l<SRSLTE_TIMERS_WHEEL_LEVELS && !slot;l++) {
+      if (delta < (1u << ((l+1)*SRSLTE_TIMERS_WHEEL_BITS))) {
+        slot = &wheel[l][(t->expiry >> (l*SRSLTE_TIMERS_WHEEL_BITS)) & (SRSLTE_TIMERS_WHEEL_SLOTS-1)];
+      }
+    }
+    if (!slot) {
+      uint32_t shift = (SRSLTE_TIMERS_WHEEL_LEVELS-1)*SRSLTE_TIMERS_WHEEL_BITS;
+      slot = &wheel[SRSLTE_TIMERS_WHEEL_LEVELS-1][((now >> shift) - 1) & (SRSLTE_TIMERS_WHEEL_SLOTS-1)];
+    }
+    t->prev          = slot->prev;
+    t->next          = slot;
+    slot->prev->next = t;
+    slot->prev       = t;
+  }
+
+  void cascade(timer_link *slot) {
+    timer_link pending;
+    list_init(&pending);
+    list_splice(slot, &pending);
+    while (pending.next != &pending) {
+      timer *t = (timer*) pending.next;
+      unlink(t);
+      schedule(t);
+    }
+  }
+
   uint32_t next_timer;
   uint32_t nof_used_timers;
   uint32_t nof_timers;
   std::vector<timer>   timer_list;
   std::vector<bool>    used_timers;
+  std::vector<uint32_t> free_ids;
+
+  uint32_t   now;
+  timer_link wheel[SRSLTE_TIMERS_WHEEL_LEVELS][SRSLTE_TIMERS_WHEEL_SLOTS];
+  timer_link expiring;
 };
 
 } // namespace srslte
@@ -0,0 +1,75 @@
+/*---------------------------------------------------------
+* zuc.h
+*
+* Adapted from ETSI/SAGE specifications:
+* "Specification of the 3GPP Confidentiality and
+* Integrity Algorithms 128-EEA3 & 128-EIA3.
+* Document 1: 128-EEA3 and 128-EIA3 Specification"
+* "Specification of the 3GPP Confidentiality and
+* Integrity Algorithms 128-EEA3 & 128-EIA3.
+* Document 2: ZUC Specification"
+*---------------------------------------------------------*/
+#ifndef SRSLTE_ZUC_H
+#define SRSLTE_ZUC_H
+
+#include <stdint.h>
+
+/* State of one ZUC instance. Every EEA3/EIA3 call uses its own, so
+* they can run concurrently.
+*/
+
+typedef struct {
+	uint32_t LFSR_S[16];
+	uint32_t F_R1;
+	uint32_t F_R2;
+} zuc_state_t;
+
+/* Initialization.
+* Input k: 128-bit key.
+* Input iv: 128-bit initialization vector.
+* Output: the LFSR and the registers of F are initialized for key generation.
+* See Document 2, section 3.6.1.
+*/
+
+void zuc_initialize(zuc_state_t *state, const uint8_t k[16], const uint8_t iv[16]);
+
+/* Generation of Keystream.
+* input n: number of 32-bit words of keystream.
+* input z: space for the generated keystream, assumes
+* memory is allocated already.
+* output: generated keystream which is filled in z
+* See Document 2, section 3.6.2.
+*/
+
+void zuc_generate_keystream(zuc_state_t *state, uint32_t n, uint32_t *z);
+
+/* 128-EEA3.
+* Input key: 128 bit Confidentiality Key.
+* Input count: 32-bit Count.
+* Input bearer: 5-bit Bearer identity (in the LSB side).
+* Input dir: 1 bit, direction of transmission.
+* Input data: length number of bits, input bit stream.
+* Input length: 32 bit Length, i.e., the number of bits to be encrypted or
+* decrypted.
+* Output data: Output bit stream, written over the input.
+* See Document 1, section 3.
+*/
+
+void zuc_eea3(uint8_t *key, uint32_t count, uint32_t bearer, uint32_t dir,
+              uint8_t *data, uint32_t length);
+
+/* 128-EIA3.
+* Input key: 128 bit Integrity Key.
+* Input count: 32-bit Count.
+* Input bearer: 5-bit Bearer identity (in the LSB side).
+* Input dir: 1 bit, direction of transmission.
+* Input data: length number of bits, input bit stream.
+* Input length: 32 bit Length, i.e., the number of bits to be MAC'd.
+* Output mac: 32 bit block used as MAC.
+* See Document 1, section 4.
+*/
+
+void zuc_eia3(uint8_t *key, uint32_t count, uint32_t bearer, uint32_t dir,
+              uint8_t *data, uint32_t length, uint8_t *mac);
+
+#endif // SRSLTE_ZUC_H
@@ -508,8 +508,11 @@ typedef struct {
   bool ul_pwr_ctrl_en; 
   float prach_gain;
   int pdsch_max_its;
+  bool pdsch_early_stop;
+  bool pdsch_llr_8bit;
   bool attach_enable_64qam; 
   int nof_phy_threads;
+  int nof_fec_threads;
   
   int worker_cpu_mask;
   int sync_cpu_affinity;
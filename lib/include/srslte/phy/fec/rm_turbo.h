@@ -84,5 +84,11 @@ SRSLTE_API int srslte_rm_turbo_rx_lut(int16_t *input,
                                       uint32_t cb_idx, 
                                       uint32_t rv_idx); 
 
+SRSLTE_API int srslte_rm_turbo_rx_lut_8bit(int8_t *input, 
+                                           int8_t *output, 
+                                           uint32_t in_len, 
+                                           uint32_t cb_idx, 
+                                           uint32_t rv_idx); 
+
 
 #endif // SRSLTE_RM_TURBO_H
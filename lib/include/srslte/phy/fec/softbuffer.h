@@ -36,15 +36,33 @@
 #ifndef SRSLTE_SOFTBUFFER_H
 #define SRSLTE_SOFTBUFFER_H
 
+#include <pthread.h>
+
 #include "srslte/config.h"
 #include "srslte/phy/common/phy_common.h"
 
+/* Code block soft buffers shared by the RX soft buffers initialized with srslte_softbuffer_rx_init_pool().
+ * Buffers are allocated the first time they are needed, up to max_cb, and reused afterwards, the most
+ * recently released first. With int8 they hold saturated 8-bit LLRs and take half the memory. */
+typedef struct SRSLTE_API {
+  uint32_t max_cb;
+  uint32_t cb_size;
+  bool int8;
+  uint32_t nof_alloc;
+  uint32_t nof_free;
+  void **free_cb;
+  pthread_mutex_t mutex;
+} srslte_softbuffer_pool_t;
+
 typedef struct SRSLTE_API {
   uint32_t max_cb;
   int16_t **buffer_f;  
   uint8_t **data;
   bool *cb_crc;
   bool tb_crc;
+  /* With a pool, buffer_f[i] is NULL until srslte_softbuffer_rx_get_cb() takes it from the pool, and
+   * goes back to it when the code block passes its CRC or the soft buffer is reset */
+  srslte_softbuffer_pool_t *pool;
 } srslte_softbuffer_rx_t;
 
 typedef struct SRSLTE_API {
@@ -57,6 +75,19 @@ typedef struct SRSLTE_API {
 SRSLTE_API int  srslte_softbuffer_rx_init(srslte_softbuffer_rx_t * q,
                                           uint32_t nof_prb);
 
+SRSLTE_API int  srslte_softbuffer_rx_init_pool(srslte_softbuffer_rx_t * q,
+                                               uint32_t nof_prb,
+                                               srslte_softbuffer_pool_t *pool);
+
+SRSLTE_API int16_t* srslte_softbuffer_rx_get_cb(srslte_softbuffer_rx_t *q,
+                                                uint32_t cb_idx,
+                                                uint32_t nof_llr);
+
+SRSLTE_API void srslte_softbuffer_rx_release_cb(srslte_softbuffer_rx_t *q,
+                                                uint32_t cb_idx);
+
+SRSLTE_API bool srslte_softbuffer_rx_is_8bit(srslte_softbuffer_rx_t *q);
+
 SRSLTE_API void srslte_softbuffer_rx_reset(srslte_softbuffer_rx_t *p);
 
 SRSLTE_API void srslte_softbuffer_rx_reset_tbs(srslte_softbuffer_rx_t *q, 
@@ -67,6 +98,15 @@ SRSLTE_API void srslte_softbuffer_rx_reset_cb(srslte_softbuffer_rx_t *q,
 
 SRSLTE_API void srslte_softbuffer_rx_free(srslte_softbuffer_rx_t *p);
 
+SRSLTE_API int  srslte_softbuffer_pool_init(srslte_softbuffer_pool_t *pool,
+                                            uint32_t nof_prb,
+                                            uint32_t nof_softbuffers,
+                                            bool int8);
+
+SRSLTE_API void srslte_softbuffer_pool_free(srslte_softbuffer_pool_t *pool);
+
+SRSLTE_API uint32_t srslte_softbuffer_pool_nof_used(srslte_softbuffer_pool_t *pool);
+
 SRSLTE_API int  srslte_softbuffer_tx_init(srslte_softbuffer_tx_t * q,
                                           uint32_t nof_prb);
 
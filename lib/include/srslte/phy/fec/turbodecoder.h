@@ -39,6 +39,7 @@
 #ifndef SRSLTE_TURBODECODER_H
 #define SRSLTE_TURBODECODER_H
 
+#include <stdbool.h>
 #include "srslte/config.h"
 #include "srslte/phy/fec/tc_interl.h"
 #include "srslte/phy/fec/cbsegm.h"
@@ -51,11 +52,46 @@
 
 #include "srslte/phy/fec/turbodecoder_gen.h"
 #include "srslte/phy/fec/turbodecoder_simd.h"
+#include "srslte/phy/fec/turbodecoder_simd8.h"
+
+/* Decoder implementations. SRSLTE_TDEC_AUTO selects the widest one compiled-in and supported 
+ * by the CPU. The SIMD implementations decode 1 (SSE), 2 (AVX2) or 4 (AVX512) codeblocks 
+ * at once, one codeblock per 128-bit lane. SRSLTE_TDEC_SSE_WIN is the SSE decoder with 
+ * sliding-window MAP recursions of SRSLTE_TDEC_WINDOW steps: it trades a small BER loss 
+ * for metrics that fit in L1, and is never selected by SRSLTE_TDEC_AUTO: it is only reachable 
+ * through srslte_tdec_init_manual(), for benchmarking (turbodecoder_test -t). SRSLTE_TDEC_SSE8 
+ * and SRSLTE_TDEC_AVX8 decode 2 and 4 codeblocks at once with 8-bit LLRs and metrics, they 
+ * are neither selected by SRSLTE_TDEC_AUTO and are the only ones that accept the _8bit 
+ * functions */
+typedef enum SRSLTE_API {
+  SRSLTE_TDEC_AUTO = 0,
+  SRSLTE_TDEC_GEN,
+  SRSLTE_TDEC_SSE,
+  SRSLTE_TDEC_AVX2,
+  SRSLTE_TDEC_AVX512,
+  SRSLTE_TDEC_SSE_WIN,
+  SRSLTE_TDEC_SSE8,
+  SRSLTE_TDEC_AVX8,
+  SRSLTE_TDEC_NOF_IMPL
+} srslte_tdec_impl_type_t;
 
 typedef struct SRSLTE_API {
+  srslte_tdec_impl_type_t type; 
   float *input_conv;
+
+  /* Hard-decision aided early stopping: a codeblock has converged when an iteration 
+   * does not change any of its hard decisions */
+  bool early_stop;
+  bool converged[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *prev_decision[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *decision_tmp;
+
+  /* 16-bit input converted for the 8-bit decoders */
+  int8_t *input_b[SRSLTE_TDEC_MAX_NPAR];
+
   union {
     srslte_tdec_simd_t tdec_simd;
+    srslte_tdec_simd8_t tdec_simd8;
     srslte_tdec_gen_t  tdec_gen;
   };
 } srslte_tdec_t;
@@ -63,8 +99,30 @@ typedef struct SRSLTE_API {
 SRSLTE_API int srslte_tdec_init(srslte_tdec_t * h, 
                                 uint32_t max_long_cb);
 
+SRSLTE_API int srslte_tdec_init_manual(srslte_tdec_t * h, 
+                                       uint32_t max_long_cb, 
+                                       srslte_tdec_impl_type_t type);
+
+SRSLTE_API bool srslte_tdec_impl_available(srslte_tdec_impl_type_t type);
+
+SRSLTE_API const char *srslte_tdec_impl_string(srslte_tdec_impl_type_t type);
+
 SRSLTE_API void srslte_tdec_free(srslte_tdec_t * h);
 
+SRSLTE_API void srslte_tdec_set_early_stop(srslte_tdec_t * h, 
+                                           bool enable);
+
+SRSLTE_API bool srslte_tdec_is_converged_cb(srslte_tdec_t * h, 
+                                            uint32_t cb_idx);
+
+SRSLTE_API bool srslte_tdec_check_converged_cb(srslte_tdec_t * h, 
+                                               uint32_t cb_idx, 
+                                               uint8_t *decision, 
+                                               uint32_t long_cb);
+
+SRSLTE_API uint32_t srslte_tdec_get_map_footprint(srslte_tdec_t * h, 
+                                                  uint32_t long_cb);
+
 SRSLTE_API int srslte_tdec_reset(srslte_tdec_t * h, 
                                  uint32_t long_cb);
 
@@ -117,4 +175,14 @@ SRSLTE_API int srslte_tdec_run_all_par(srslte_tdec_t * h,
                                        uint32_t nof_iterations, 
                                        uint32_t long_cb);
 
+SRSLTE_API int srslte_tdec_iteration_par_8bit(srslte_tdec_t * h, 
+                                              int8_t* input[SRSLTE_TDEC_MAX_NPAR],
+                                              uint32_t long_cb);
+
+SRSLTE_API int srslte_tdec_run_all_par_8bit(srslte_tdec_t * h, 
+                                            int8_t * input[SRSLTE_TDEC_MAX_NPAR],
+                                            uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                                            uint32_t nof_iterations, 
+                                            uint32_t long_cb);
+
 #endif // SRSLTE_TURBODECODER_H
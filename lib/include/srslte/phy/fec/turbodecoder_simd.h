@@ -43,8 +43,12 @@
 #include "srslte/phy/fec/tc_interl.h"
 #include "srslte/phy/fec/cbsegm.h"
 
-// Define maximum number of CB decoded in parallel (2 for AVX2)
+// Define maximum number of CB decoded in parallel (2 for AVX2, 4 for AVX512 and 8-bit AVX2)
+#ifdef LV_HAVE_AVX2
+#define SRSLTE_TDEC_MAX_NPAR 4
+#else
 #define SRSLTE_TDEC_MAX_NPAR 2
+#endif
 
 #define SRSLTE_TCOD_RATE 3
 #define SRSLTE_TCOD_TOTALTAIL 12
@@ -52,9 +56,13 @@
 #define SRSLTE_TCOD_MAX_LEN_CB     6144
 #define SRSLTE_TCOD_MAX_LEN_CODED  (SRSLTE_TCOD_RATE*SRSLTE_TCOD_MAX_LEN_CB+SRSLTE_TCOD_TOTALTAIL)
 
+// Trellis steps per window of the sliding-window MAP decoder (multiple of 8)
+#define SRSLTE_TDEC_WINDOW 64
+
 typedef struct SRSLTE_API {
   uint32_t max_long_cb;
   uint32_t max_par_cb; 
+  uint32_t window;        // 0 for the full-length MAP
   int16_t *alpha;
   int16_t *branch;
 } map_gen_t;
@@ -83,6 +91,13 @@ SRSLTE_API int srslte_tdec_simd_init(srslte_tdec_simd_t * h,
                                      uint32_t max_par_cb, 
                                      uint32_t max_long_cb);
 
+SRSLTE_API int srslte_tdec_simd_init_window(srslte_tdec_simd_t * h, 
+                                            uint32_t max_long_cb, 
+                                            uint32_t window);
+
+SRSLTE_API uint32_t srslte_tdec_simd_map_footprint(srslte_tdec_simd_t * h, 
+                                                   uint32_t long_cb);
+
 SRSLTE_API void srslte_tdec_simd_free(srslte_tdec_simd_t * h);
 
 SRSLTE_API int srslte_tdec_simd_reset(srslte_tdec_simd_t * h, 
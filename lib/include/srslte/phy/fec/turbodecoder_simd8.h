@@ -0,0 +1,110 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/**********************************************************************************************
+ *  File:         turbodecoder_simd8.h
+ *
+ *  Description:  Turbo Decoder with 8-bit LLRs and state metrics.
+ *                MAX-LOG-MAP decoder that runs two codeblocks in each 128-bit lane,
+ *                8 states of 8 bits per codeblock: 2 codeblocks with SSE and 4 with AVX2.
+ *                All arithmetic saturates and the state metrics are normalized every
+ *                trellis step. Inputs are expected in the range of
+ *                srslte_demod_soft_demodulate_b().
+ *
+ *  Reference:    3GPP TS 36.212 version 10.0.0 Release 10 Sec. 5.1.3.2
+ *********************************************************************************************/
+
+#ifndef SRSLTE_TURBODECODER_SIMD8_H
+#define SRSLTE_TURBODECODER_SIMD8_H
+
+#include "srslte/config.h"
+#include "srslte/phy/fec/tc_interl.h"
+#include "srslte/phy/fec/cbsegm.h"
+#include "srslte/phy/fec/turbodecoder_simd.h"
+
+typedef struct SRSLTE_API {
+  uint32_t max_long_cb;
+  uint32_t max_par_cb;
+
+  int8_t *alpha;
+  int8_t *branch;
+
+  int8_t *app1[SRSLTE_TDEC_MAX_NPAR];
+  int8_t *app2[SRSLTE_TDEC_MAX_NPAR];
+  int8_t *ext1[SRSLTE_TDEC_MAX_NPAR];
+  int8_t *ext2[SRSLTE_TDEC_MAX_NPAR];
+  int8_t *syst[SRSLTE_TDEC_MAX_NPAR];
+  int8_t *parity0[SRSLTE_TDEC_MAX_NPAR];
+  int8_t *parity1[SRSLTE_TDEC_MAX_NPAR];
+
+  int cb_mask;
+  int current_cbidx;
+  srslte_tc_interl_t interleaver[SRSLTE_NOF_TC_CB_SIZES];
+  int n_iter[SRSLTE_TDEC_MAX_NPAR];
+} srslte_tdec_simd8_t;
+
+SRSLTE_API int srslte_tdec_simd8_init(srslte_tdec_simd8_t * h,
+                                      uint32_t max_par_cb,
+                                      uint32_t max_long_cb);
+
+SRSLTE_API void srslte_tdec_simd8_free(srslte_tdec_simd8_t * h);
+
+SRSLTE_API uint32_t srslte_tdec_simd8_map_footprint(srslte_tdec_simd8_t * h,
+                                                   uint32_t long_cb);
+
+SRSLTE_API int srslte_tdec_simd8_reset(srslte_tdec_simd8_t * h,
+                                      uint32_t long_cb);
+
+SRSLTE_API int srslte_tdec_simd8_reset_cb(srslte_tdec_simd8_t * h,
+                                         uint32_t cb_idx);
+
+SRSLTE_API int srslte_tdec_simd8_get_nof_iterations_cb(srslte_tdec_simd8_t * h,
+                                                      uint32_t cb_idx);
+
+SRSLTE_API void srslte_tdec_simd8_iteration(srslte_tdec_simd8_t * h,
+                                           int8_t * input[SRSLTE_TDEC_MAX_NPAR],
+                                           uint32_t long_cb);
+
+SRSLTE_API void srslte_tdec_simd8_decision(srslte_tdec_simd8_t * h,
+                                          uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                                          uint32_t long_cb);
+
+SRSLTE_API void srslte_tdec_simd8_decision_byte(srslte_tdec_simd8_t * h,
+                                               uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                                               uint32_t long_cb);
+
+SRSLTE_API void srslte_tdec_simd8_decision_byte_cb(srslte_tdec_simd8_t * h,
+                                                  uint8_t *output,
+                                                  uint32_t cbidx,
+                                                  uint32_t long_cb);
+
+SRSLTE_API int srslte_tdec_simd8_run_all(srslte_tdec_simd8_t * h,
+                                        int8_t * input[SRSLTE_TDEC_MAX_NPAR],
+                                        uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                                        uint32_t nof_iterations,
+                                        uint32_t long_cb);
+
+#endif // SRSLTE_TURBODECODER_SIMD8_H
@@ -167,8 +167,17 @@ SRSLTE_API int srslte_pdsch_cn_compute(srslte_pdsch_t *q,
 SRSLTE_API void srslte_pdsch_set_max_noi(srslte_pdsch_t *q,
                                          uint32_t max_iter);
 
+SRSLTE_API void srslte_pdsch_set_early_stop(srslte_pdsch_t *q,
+                                            bool enable);
+
 SRSLTE_API float srslte_pdsch_last_noi(srslte_pdsch_t *q);
 
+SRSLTE_API int srslte_pdsch_set_llr_8bit(srslte_pdsch_t *q,
+                                         bool enable);
+
+SRSLTE_API void srslte_pdsch_set_sch_pool(srslte_pdsch_t *q,
+                                          srslte_sch_pool_t *pool);
+
 SRSLTE_API int srslte_pdsch_enable_coworker(srslte_pdsch_t *q);
 
 SRSLTE_API uint32_t srslte_pdsch_last_noi_cw(srslte_pdsch_t *q,
@@ -35,6 +35,7 @@
 #ifndef SRSLTE_SCH_H
 #define SRSLTE_SCH_H
 
+#include <pthread.h>
 #include "srslte/config.h"
 #include "srslte/phy/common/phy_common.h"
 #include "srslte/phy/fec/rm_turbo.h"
@@ -53,6 +54,8 @@
 #define SRSLTE_TX_NULL 100
 #endif
 
+struct srslte_sch_pool_s;
+
 /* DL-SCH AND UL-SCH common functions */
 typedef struct SRSLTE_API {
   
@@ -74,8 +77,33 @@ typedef struct SRSLTE_API {
   srslte_crc_t crc_cb;
   
   srslte_uci_cqi_pusch_t uci_cqi;
+
+  /* The decoder takes 8-bit LLRs, see srslte_sch_set_llr_8bit() */
+  bool llr_8bit;
+
+  /* Shared FEC threads, NULL if code blocks are decoded by the caller only */
+  struct srslte_sch_pool_s *pool;
   
 } srslte_sch_t;
+
+/* Pool of FEC threads shared by several srslte_sch_t. Each thread owns a decoder and helps whichever
+ * transport block has code blocks left to decode. The caller decodes code blocks too and joins the
+ * helpers before the transport block CRC, so a TB never waits for a free thread. Threads also own
+ * an 8-bit decoder, when it is available, so they take 8-bit jobs without switching decoders.
+ */
+typedef struct srslte_sch_pool_s {
+  uint32_t nof_threads;
+  pthread_t *threads;
+  srslte_sch_t *sch;
+  srslte_sch_t *sch_8bit;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cvar_job;
+  pthread_cond_t cvar_done;
+  void *jobs;
+  bool quit;
+} srslte_sch_pool_t;
+
 #include "srslte/phy/phch/pmch.h"
 
 SRSLTE_API int srslte_sch_init(srslte_sch_t *q);
@@ -86,8 +114,34 @@ SRSLTE_API void srslte_sch_free(srslte_sch_t *q);
 SRSLTE_API void srslte_sch_set_max_noi(srslte_sch_t *q, 
                                        uint32_t max_iterations); 
 
+SRSLTE_API void srslte_sch_set_early_stop(srslte_sch_t *q, 
+                                          bool enable);
+
+SRSLTE_API int srslte_sch_set_llr_8bit(srslte_sch_t *q,
+                                       bool enable);
+
 SRSLTE_API uint32_t srslte_sch_last_noi(srslte_sch_t *q);
 
+SRSLTE_API void srslte_sch_set_pool(srslte_sch_t *q,
+                                    srslte_sch_pool_t *pool);
+
+/* Creates one pool thread. Returns true on success. Lets the caller give the FEC threads the priority
+ * and CPU affinity of its own workers, ctx is passed through */
+typedef bool (*srslte_sch_pool_thread_create_t)(pthread_t *thread,
+                                                void *(*start_routine)(void*),
+                                                void *arg,
+                                                void *ctx);
+
+SRSLTE_API int srslte_sch_pool_init(srslte_sch_pool_t *pool,
+                                    uint32_t nof_threads);
+
+SRSLTE_API int srslte_sch_pool_init_threads(srslte_sch_pool_t *pool,
+                                            uint32_t nof_threads,
+                                            srslte_sch_pool_thread_create_t thread_create,
+                                            void *ctx);
+
+SRSLTE_API void srslte_sch_pool_free(srslte_sch_pool_t *pool);
+
 SRSLTE_API int srslte_dlsch_encode(srslte_sch_t *q, 
                                    srslte_pdsch_cfg_t *cfg,
                                    srslte_softbuffer_tx_t *softbuffer,
@@ -114,6 +168,13 @@ SRSLTE_API int srslte_dlsch_decode2(srslte_sch_t *q,
                                    uint8_t *data,
                                    int codeword_idx);
 
+SRSLTE_API int srslte_dlsch_decode2_8bit(srslte_sch_t *q,
+                                         srslte_pdsch_cfg_t *cfg,
+                                         srslte_softbuffer_rx_t *softbuffer,
+                                         int8_t *e_bits,
+                                         uint8_t *data,
+                                         int codeword_idx);
+
 SRSLTE_API int srslte_ulsch_encode(srslte_sch_t *q, 
                                    srslte_pusch_cfg_t *cfg,
                                    srslte_softbuffer_tx_t *softbuffer,
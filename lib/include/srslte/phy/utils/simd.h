@@ -103,6 +103,8 @@
 #define SRSLTE_SIMD_S_SIZE    32
 #define SRSLTE_SIMD_C16_SIZE  0
 
+#define SRSLTE_SIMD_B_SIZE    64
+
 #else
 #ifdef LV_HAVE_AVX2
 
@@ -114,6 +116,8 @@
 #define SRSLTE_SIMD_S_SIZE    16
 #define SRSLTE_SIMD_C16_SIZE  16
 
+#define SRSLTE_SIMD_B_SIZE    32
+
 #else /* LV_HAVE_AVX2 */
 #ifdef LV_HAVE_SSE
 
@@ -125,6 +129,8 @@
 #define SRSLTE_SIMD_S_SIZE    8
 #define SRSLTE_SIMD_C16_SIZE  8
 
+#define SRSLTE_SIMD_B_SIZE    16
+
 #else /* LV_HAVE_SSE */
 #ifdef HAVE_NEON
 
@@ -136,6 +142,8 @@
 #define SRSLTE_SIMD_S_SIZE    8
 #define SRSLTE_SIMD_C16_SIZE  8
 
+#define SRSLTE_SIMD_B_SIZE    16
+
 #else /* HAVE_NEON */
 #define SRSLTE_SIMD_F_SIZE    0
 #define SRSLTE_SIMD_CF_SIZE   0
@@ -145,6 +153,8 @@
 #define SRSLTE_SIMD_S_SIZE    0
 #define SRSLTE_SIMD_C16_SIZE  0
 
+#define SRSLTE_SIMD_B_SIZE    0
+
 #endif /* HAVE_NEON */
 #endif /* LV_HAVE_SSE */
 #endif /* LV_HAVE_AVX2 */
@@ -1773,6 +1783,107 @@ static inline simd_b_t srslte_simd_b_xor(simd_b_t a, simd_b_t b) {
 #endif /* LV_HAVE_AVX512 */
 }
 
+/* Saturated 8-bit addition */
+static inline simd_b_t srslte_simd_b_add(simd_b_t a, simd_b_t b) {
+#ifdef LV_HAVE_AVX512
+  return _mm512_adds_epi8(a, b);
+#else /* LV_HAVE_AVX512 */
+#ifdef LV_HAVE_AVX2
+  return _mm256_adds_epi8(a, b);
+#else /* LV_HAVE_AVX2 */
+#ifdef LV_HAVE_SSE
+  return _mm_adds_epi8(a, b);
+#else /* LV_HAVE_SSE */
+#ifdef HAVE_NEON
+  return vqaddq_s8(a, b);
+#endif /* HAVE_NEON */
+#endif /* LV_HAVE_SSE */
+#endif /* LV_HAVE_AVX2 */
+#endif /* LV_HAVE_AVX512 */
+}
+
+/* Saturated 8-bit subtraction */
+static inline simd_b_t srslte_simd_b_sub(simd_b_t a, simd_b_t b) {
+#ifdef LV_HAVE_AVX512
+  return _mm512_subs_epi8(a, b);
+#else /* LV_HAVE_AVX512 */
+#ifdef LV_HAVE_AVX2
+  return _mm256_subs_epi8(a, b);
+#else /* LV_HAVE_AVX2 */
+#ifdef LV_HAVE_SSE
+  return _mm_subs_epi8(a, b);
+#else /* LV_HAVE_SSE */
+#ifdef HAVE_NEON
+  return vqsubq_s8(a, b);
+#endif /* HAVE_NEON */
+#endif /* LV_HAVE_SSE */
+#endif /* LV_HAVE_AVX2 */
+#endif /* LV_HAVE_AVX512 */
+}
+
+/* Negates the elements of a where b is 1, b must be 0 or 1. -128 saturates to 127 */
+static inline simd_b_t srslte_simd_b_neg(simd_b_t a, simd_b_t b) {
+#ifdef LV_HAVE_AVX512
+  __m512i m = _mm512_sub_epi8(_mm512_setzero_si512(), b);
+  return _mm512_subs_epi8(_mm512_xor_si512(a, m), m);
+#else /* LV_HAVE_AVX512 */
+#ifdef LV_HAVE_AVX2
+  __m256i m = _mm256_sub_epi8(_mm256_setzero_si256(), b);
+  return _mm256_subs_epi8(_mm256_xor_si256(a, m), m);
+#else /* LV_HAVE_AVX2 */
+#ifdef LV_HAVE_SSE
+  __m128i m = _mm_sub_epi8(_mm_setzero_si128(), b);
+  return _mm_subs_epi8(_mm_xor_si128(a, m), m);
+#else /* LV_HAVE_SSE */
+#ifdef HAVE_NEON
+  int8x16_t m = vnegq_s8(b);
+  return vqsubq_s8(veorq_s8(a, m), m);
+#endif /* HAVE_NEON */
+#endif /* LV_HAVE_SSE */
+#endif /* LV_HAVE_AVX2 */
+#endif /* LV_HAVE_AVX512 */
+}
+
+#if SRSLTE_SIMD_S_SIZE
+/* Arithmetic right shift of every element of a */
+static inline simd_s_t srslte_simd_s_sra(simd_s_t a, int shift) {
+#ifdef LV_HAVE_AVX512
+  return _mm512_sra_epi16(a, _mm_cvtsi32_si128(shift));
+#else /* LV_HAVE_AVX512 */
+#ifdef LV_HAVE_AVX2
+  return _mm256_sra_epi16(a, _mm_cvtsi32_si128(shift));
+#else /* LV_HAVE_AVX2 */
+#ifdef LV_HAVE_SSE
+  return _mm_sra_epi16(a, _mm_cvtsi32_si128(shift));
+#else /* LV_HAVE_SSE */
+#ifdef HAVE_NEON
+  return vshlq_s16(a, vdupq_n_s16(-shift));
+#endif /* HAVE_NEON */
+#endif /* LV_HAVE_SSE */
+#endif /* LV_HAVE_AVX2 */
+#endif /* LV_HAVE_AVX512 */
+}
+
+/* Packs a and b, in this order, into one register of bytes with saturation */
+static inline simd_b_t srslte_simd_convert_2s_b(simd_s_t a, simd_s_t b) {
+#ifdef LV_HAVE_AVX512
+  return _mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), _mm512_packs_epi16(a, b));
+#else /* LV_HAVE_AVX512 */
+#ifdef LV_HAVE_AVX2
+  return _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+#else /* LV_HAVE_AVX2 */
+#ifdef LV_HAVE_SSE
+  return _mm_packs_epi16(a, b);
+#else /* LV_HAVE_SSE */
+#ifdef HAVE_NEON
+  return vcombine_s8(vqmovn_s16(a), vqmovn_s16(b));
+#endif /* HAVE_NEON */
+#endif /* LV_HAVE_SSE */
+#endif /* LV_HAVE_AVX2 */
+#endif /* LV_HAVE_AVX512 */
+}
+#endif /* SRSLTE_SIMD_S_SIZE */
+
 #endif /*SRSLTE_SIMD_B_SIZE */
 
 
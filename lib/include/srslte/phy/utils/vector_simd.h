@@ -62,6 +62,10 @@ SRSLTE_API void srslte_vec_sum_sss_simd(const int16_t *x, const int16_t *y, int1
 
 SRSLTE_API void srslte_vec_sub_sss_simd(const int16_t *x, const int16_t *y, int16_t *z, int len);
 
+SRSLTE_API void srslte_vec_sub_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, int len);
+
+SRSLTE_API void srslte_vec_neg_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, int len);
+
 SRSLTE_API float srslte_vec_acc_ff_simd(const float *x, int len);
 
 SRSLTE_API cf_t srslte_vec_acc_cc_simd(const cf_t *x, int len);
@@ -124,6 +128,8 @@ SRSLTE_API void srslte_vec_convert_if_simd(const int16_t *x, float *z, const flo
 
 SRSLTE_API void srslte_vec_convert_fi_simd(const float *x, int16_t *z, const float scale, const int len);
 
+SRSLTE_API void srslte_vec_convert_sb_simd(const int16_t *x, int8_t *z, const int shift, const int len);
+
 SRSLTE_API void srslte_vec_cp_simd(const cf_t *src, cf_t *dst, int len);
 
 SRSLTE_API void srslte_vec_interleave_simd(const cf_t *x, const cf_t *y, cf_t *z, const int len);
@@ -28,6 +28,7 @@
 #define SRSLTE_GTPU_H
 
 #include <stdint.h>
+#include <string.h>
 #include "srslte/common/common.h"
 #include "srslte/common/log.h"
 
@@ -50,18 +51,84 @@ namespace srslte {
  ***************************************************************************/
 
 #define GTPU_HEADER_LEN 8
+#define GTPU_OPT_HEADER_LEN 4       // Sequence number, N-PDU number, next extension header type
+
+#define GTPU_FLAGS_VERSION_V1     0x20
+#define GTPU_FLAGS_GTP_PROTOCOL   0x10
+#define GTPU_FLAGS_EXTENDED_HDR   0x04
+#define GTPU_FLAGS_SEQUENCE       0x02
+#define GTPU_FLAGS_PACKET_NUM     0x01
+#define GTPU_FLAGS_OPTIONAL       (GTPU_FLAGS_EXTENDED_HDR | GTPU_FLAGS_SEQUENCE | GTPU_FLAGS_PACKET_NUM)
+
+#define GTPU_MSG_ECHO_REQUEST       1
+#define GTPU_MSG_ECHO_RESPONSE      2
+#define GTPU_MSG_ERROR_INDICATION   26
+#define GTPU_MSG_END_MARKER         254
+#define GTPU_MSG_DATA_PDU           255
+
+#define GTPU_IE_RECOVERY            14
 
 typedef struct{
-  uint8_t   flags;          // Only support 0x30 - v1, PT1 (GTP), no other flags
-  uint8_t   message_type;   // Only support 0xFF - T-PDU type
-  uint16_t  length;
+  uint8_t   flags;              // Version 1, PT 1 (GTP), plus optional E, S and PN
+  uint8_t   message_type;
+  uint16_t  length;             // Filled in by gtpu_write_header()
   uint32_t  teid;
+  uint16_t  seq_number;         // Valid if GTPU_FLAGS_SEQUENCE
+  uint8_t   n_pdu;              // Valid if GTPU_FLAGS_PACKET_NUM
+  uint8_t   next_ext_hdr_type;  // First extension header, if GTPU_FLAGS_EXTENDED_HDR
 }gtpu_header_t;
 
 
+/* gtpu_read_header() strips the header and any extension headers from the
+ * PDU, and trims it to the length field. Extension header contents are
+ * skipped. gtpu_write_header() prepends the header, with the optional fields
+ * if any of E, S or PN are set; extension headers are not written.
+ */
 bool gtpu_read_header(srslte::byte_buffer_t *pdu, gtpu_header_t *header, srslte::log *gtpu_log);
 bool gtpu_write_header(gtpu_header_t *header, srslte::byte_buffer_t *pdu, srslte::log *gtpu_log);
 
+// Turns an echo request, as returned by gtpu_read_header(), into the response in place
+bool gtpu_write_echo_response(const gtpu_header_t *request, srslte::byte_buffer_t *pdu, srslte::log *gtpu_log);
+bool gtpu_write_echo_request(uint16_t seq_number, srslte::byte_buffer_t *pdu, srslte::log *gtpu_log);
+
+/****************************************************************************
+ * T-PDU fast path
+ * A bearer's header only changes in the length field, so it is built once
+ * and written with a single 8-byte store.
+ ***************************************************************************/
+typedef uint64_t gtpu_tpdu_template_t;
+
+inline gtpu_tpdu_template_t gtpu_tpdu_template(uint32_t teid)
+{
+  uint8_t hdr[GTPU_HEADER_LEN] = {GTPU_FLAGS_VERSION_V1 | GTPU_FLAGS_GTP_PROTOCOL, GTPU_MSG_DATA_PDU, 0, 0,
+                                  (uint8_t) (teid >> 24), (uint8_t) (teid >> 16), (uint8_t) (teid >> 8), (uint8_t) teid};
+  gtpu_tpdu_template_t t;
+  memcpy(&t, hdr, sizeof(t));
+  return t;
+}
+
+// Writes the header for a payload of len bytes at hdr, e.g. straight into a ring frame
+inline void gtpu_write_tpdu(gtpu_tpdu_template_t tmpl, uint16_t len, uint8_t *hdr)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  tmpl |= (uint64_t) __builtin_bswap16(len) << 16;
+#else
+  tmpl |= (uint64_t) len << 32;
+#endif
+  memcpy(hdr, &tmpl, sizeof(tmpl));
+}
+
+inline bool gtpu_write_tpdu(gtpu_tpdu_template_t tmpl, srslte::byte_buffer_t *pdu)
+{
+  if (pdu->get_headroom() < GTPU_HEADER_LEN || pdu->N_bytes > 0xFFFF) {
+    return false;
+  }
+  gtpu_write_tpdu(tmpl, pdu->N_bytes, pdu->msg - GTPU_HEADER_LEN);
+  pdu->msg     -= GTPU_HEADER_LEN;
+  pdu->N_bytes += GTPU_HEADER_LEN;
+  return true;
+}
+
 inline void uint8_to_uint32(uint8_t *buf, uint32_t *i)
 {
   *i =  (uint32_t)buf[0] << 24 |
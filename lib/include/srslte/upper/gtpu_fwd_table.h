@@ -0,0 +1,270 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/******************************************************************************
+ *  File:         gtpu_fwd_table.h
+ *  Description:  Forwarding tables for the GTP-U gateways. teid_table is a
+ *                flat array indexed by a TEID it hands out itself, so TEIDs
+ *                stay dense and a lookup is one bounds check and one load.
+ *                fwd_map is an open-addressing Robin Hood hash for keys the
+ *                gateway does not choose (UE IPs, RNTIs). Keys and values
+ *                are stored in separate arrays so probing touches only 8
+ *                bytes per slot. Neither class is thread-safe, and pointers
+ *                returned by find() are invalidated by the next insertion.
+ *****************************************************************************/
+
+
+#ifndef SRSLTE_GTPU_FWD_TABLE_H
+#define SRSLTE_GTPU_FWD_TABLE_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+namespace srslte {
+
+template<class T>
+class teid_table
+{
+public:
+  static const uint32_t INVALID_TEID = 0;
+
+  explicit teid_table(uint32_t max_teids_ = 1<<20) : count(0), max_teids(max_teids_) {
+    // TEID 0 is never handed out
+    values.resize(1);
+    used.resize(1, 0);
+  }
+
+  // Stores value under a new TEID. Returns INVALID_TEID if the table is full
+  uint32_t add(const T &value) {
+    uint32_t teid;
+    if (!free_teids.empty()) {
+      // Reuse the TEID that has been free the longest, stale packets are then least likely
+      teid = free_teids.front();
+      free_teids.pop_front();
+    } else if (values.size() < max_teids) {
+      teid = values.size();
+      values.push_back(value);
+      used.push_back(0);
+    } else {
+      return INVALID_TEID;
+    }
+    values[teid] = value;
+    used[teid]   = 1;
+    count++;
+    return teid;
+  }
+
+  T* find(uint32_t teid) {
+    return (teid < used.size() && used[teid]) ? &values[teid] : NULL;
+  }
+
+  const T* find(uint32_t teid) const {
+    return (teid < used.size() && used[teid]) ? &values[teid] : NULL;
+  }
+
+  bool remove(uint32_t teid) {
+    if (!find(teid)) {
+      return false;
+    }
+    used[teid]   = 0;
+    values[teid] = T();
+    free_teids.push_back(teid);
+    count--;
+    return true;
+  }
+
+  void clear() {
+    values.resize(1);
+    used.resize(1);
+    free_teids.clear();
+    count = 0;
+  }
+
+  uint32_t size() const { return count; }
+
+  // One past the largest TEID handed out so far, to iterate with find()
+  uint32_t end_teid() const { return values.size(); }
+
+private:
+  std::vector<T>        values;
+  std::vector<uint8_t>  used;
+  std::deque<uint32_t>  free_teids;
+  uint32_t              count;
+  uint32_t              max_teids;
+};
+
+
+template<class T>
+class fwd_map
+{
+public:
+  explicit fwd_map(uint32_t capacity = 16) : count(0) {
+    uint32_t n = 16;
+    while (n * 7 < capacity * 8) {
+      n <<= 1;
+    }
+    resize(n);
+  }
+
+  T* find(uint32_t key) {
+    return const_cast<T*>(static_cast<const fwd_map*>(this)->find(key));
+  }
+
+  /* Robin Hood ordering keeps every probe sequence sorted by distance from
+   * home, so a miss ends at the first slot closer to its home than we are.
+   */
+  const T* find(uint32_t key) const {
+    uint32_t i = home(key);
+    for (uint32_t d = 1; ; d++) {
+      const slot_t &s = slots[i];
+      if (s.dist < d) {
+        return NULL;
+      }
+      if (s.key == key) {
+        return &values[i];
+      }
+      i = (i + 1) & mask;
+    }
+  }
+
+  // Inserts or overwrites. Returns the stored value
+  T* insert(uint32_t key, const T &value) {
+    T *v = find(key);
+    if (v) {
+      *v = value;
+      return v;
+    }
+    if ((count + 1) * 8 > slots.size() * 7) {
+      resize(slots.size() * 2);
+    }
+    count++;
+    return place(key, value);
+  }
+
+  bool erase(uint32_t key) {
+    T *v = find(key);
+    if (!v) {
+      return false;
+    }
+    // Backward-shift deletion: no tombstones, probe lengths stay short
+    uint32_t i = v - &values[0];
+    uint32_t j = (i + 1) & mask;
+    while (slots[j].dist > 1) {
+      slots[i]      = slots[j];
+      slots[i].dist--;
+      values[i]     = values[j];
+      i = j;
+      j = (j + 1) & mask;
+    }
+    slots[i].dist = 0;
+    values[i]     = T();
+    count--;
+    return true;
+  }
+
+  void clear() {
+    for (uint32_t i = 0; i < slots.size(); i++) {
+      slots[i].dist = 0;
+      values[i]     = T();
+    }
+    count = 0;
+  }
+
+  uint32_t size() const { return count; }
+
+  // Slot-wise iteration: for (i = 0; i < capacity(); i++) if (used(i)) ...
+  uint32_t capacity() const { return slots.size(); }
+  bool     used(uint32_t i) const { return slots[i].dist != 0; }
+  uint32_t key_at(uint32_t i) const { return slots[i].key; }
+  T&       value_at(uint32_t i) { return values[i]; }
+
+private:
+  struct slot_t {
+    uint32_t key;
+    uint32_t dist;    // 1 + distance from the home slot, 0 if empty
+  };
+
+  // Fibonacci hashing spreads consecutive keys (UE IPs, RNTIs) over the table
+  uint32_t home(uint32_t key) const {
+    return (key * 0x9E3779B1u) >> shift;
+  }
+
+  T* place(uint32_t key, T value) {
+    slot_t   s    = {key, 1};
+    uint32_t i    = home(key);
+    T       *ret  = NULL;
+    while (true) {
+      if (slots[i].dist == 0) {
+        slots[i] = s;
+        values[i] = value;
+        return ret ? ret : &values[i];
+      }
+      if (slots[i].dist < s.dist) {
+        std::swap(slots[i], s);
+        std::swap(values[i], value);
+        if (!ret) {
+          ret = &values[i];
+        }
+      }
+      i = (i + 1) & mask;
+      s.dist++;
+    }
+  }
+
+  void resize(uint32_t n) {
+    std::vector<slot_t> old_slots;
+    std::vector<T>      old_values;
+    old_slots.swap(slots);
+    old_values.swap(values);
+
+    slot_t empty = {0, 0};
+    slots.assign(n, empty);
+    values.assign(n, T());
+    mask  = n - 1;
+    shift = 32;
+    for (uint32_t m = n; m > 1; m >>= 1) {
+      shift--;
+    }
+    for (uint32_t i = 0; i < old_slots.size(); i++) {
+      if (old_slots[i].dist) {
+        place(old_slots[i].key, old_values[i]);
+      }
+    }
+  }
+
+  std::vector<slot_t> slots;
+  std::vector<T>      values;
+  uint32_t            mask;
+  uint32_t            shift;
+  uint32_t            count;
+};
+
+} // namespace srslte
+
+#endif // SRSLTE_GTPU_FWD_TABLE_H
@@ -32,6 +32,7 @@
 #include "srslte/common/common.h"
 #include "srslte/interfaces/ue_interfaces.h"
 #include "srslte/common/security.h"
+#include "srslte/common/pdcp_crypto.h"
 #include "srslte/common/threads.h"
 
 
@@ -103,8 +104,7 @@ private:
 
   uint32_t            rx_count;
   uint32_t            tx_count;
-  uint8_t             k_enc[32];
-  uint8_t             k_int[32];
+  pdcp_crypto         crypto;       // key schedules of k_enc and k_int
 
   CIPHERING_ALGORITHM_ID_ENUM cipher_algo;
   INTEGRITY_ALGORITHM_ID_ENUM integ_algo;
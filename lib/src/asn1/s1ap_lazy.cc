@@ -0,0 +1,210 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "srslte/asn1/s1ap_lazy.h"
+
+namespace srslte {
+
+// Zeroed bits after each IE. liblte's unpackers trust the encoded lengths, so this keeps a short read inside the arena
+#define S1AP_LAZY_IE_SLACK_BITS 512
+
+s1ap_arena::s1ap_arena(uint32_t chunk_size_) :
+  chunk_size(chunk_size_),
+  cur_chunk(0),
+  cur_offset(0),
+  nof_used(0),
+  nof_held(0)
+{
+}
+
+s1ap_arena::~s1ap_arena()
+{
+  for (uint32_t i = 0; i < chunks.size(); i++) {
+    free(chunks[i]);
+  }
+}
+
+void* s1ap_arena::alloc(uint32_t size)
+{
+  size = (size + 7) & ~7u;
+  while (cur_chunk < chunks.size() && cur_offset + size > chunk_sizes[cur_chunk]) {
+    cur_chunk++;
+    cur_offset = 0;
+  }
+  if (cur_chunk == chunks.size()) {
+    uint32_t n = size > chunk_size ? size : chunk_size;
+    uint8_t *chunk = (uint8_t*) malloc(n);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunks.push_back(chunk);
+    chunk_sizes.push_back(n);
+    nof_held  += n;
+    cur_offset = 0;
+  }
+  void *ret   = chunks[cur_chunk] + cur_offset;
+  cur_offset += size;
+  nof_used   += size;
+  return ret;
+}
+
+void s1ap_arena::reset()
+{
+  cur_chunk  = 0;
+  cur_offset = 0;
+  nof_used   = 0;
+}
+
+
+s1ap_lazy_pdu::s1ap_lazy_pdu() :
+  msg(NULL),
+  msg_len(0),
+  arena(NULL),
+  pdu_type(LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS),
+  procedure_code(0),
+  nof_ies(0)
+{
+}
+
+// APER length determinant, octet aligned. Fragmented (>16K) lengths are not supported, as in liblte
+static bool read_length(const uint8_t *msg, uint32_t len, uint32_t *pos, uint32_t *value)
+{
+  if (*pos >= len) {
+    return false;
+  }
+  if ((msg[*pos] & 0x80) == 0) {
+    *value = msg[*pos];
+    *pos  += 1;
+    return true;
+  }
+  if ((msg[*pos] & 0xc0) == 0x80 && *pos + 1 < len) {
+    *value = ((msg[*pos] & 0x3f) << 8) | msg[*pos + 1];
+    *pos  += 2;
+    return true;
+  }
+  return false;
+}
+
+LIBLTE_ERROR_ENUM s1ap_lazy_pdu::parse(const uint8_t *msg_, uint32_t len, s1ap_arena *arena_)
+{
+  msg     = msg_;
+  msg_len = len;
+  arena   = arena_;
+  nof_ies = 0;
+
+  // PDU: extension bit and choice, then procedure code and criticality
+  if (msg == NULL || arena == NULL || len < 4 || (msg[0] & 0x80)) {
+    return LIBLTE_ERROR_DECODE_FAIL;
+  }
+  pdu_type       = (LIBLTE_S1AP_S1AP_PDU_CHOICE_ENUM) ((msg[0] >> 5) & 0x3);
+  procedure_code = msg[1];
+  if (pdu_type >= LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS) {
+    return LIBLTE_ERROR_DECODE_FAIL;
+  }
+
+  // Message open type: extension bit, then the number of IEs in two octets
+  uint32_t pos = 3;
+  uint32_t value_len;
+  if (!read_length(msg, len, &pos, &value_len) || pos + value_len > len || value_len < 3) {
+    return LIBLTE_ERROR_DECODE_FAIL;
+  }
+  uint32_t end = pos + value_len;
+  if (msg[pos] & 0x80) {
+    // Extensions are not supported by liblte either
+    return LIBLTE_ERROR_DECODE_FAIL;
+  }
+  uint32_t n = (msg[pos + 1] << 8) | msg[pos + 2];
+  pos += 3;
+  if (n > S1AP_LAZY_MAX_IES) {
+    return LIBLTE_ERROR_DECODE_FAIL;
+  }
+
+  // IEs: id in two octets, criticality, then the value as an open type
+  for (uint32_t i = 0; i < n; i++) {
+    if (pos + 3 > end) {
+      return LIBLTE_ERROR_DECODE_FAIL;
+    }
+    s1ap_lazy_ie_t *ie = &ies[nof_ies];
+    ie->id          = (msg[pos] << 8) | msg[pos + 1];
+    ie->criticality = msg[pos + 2] >> 6;
+    pos += 3;
+    if (!read_length(msg, end, &pos, &ie->len) || pos + ie->len > end) {
+      return LIBLTE_ERROR_DECODE_FAIL;
+    }
+    ie->offset  = pos;
+    ie->decoded = NULL;
+    pos += ie->len;
+    nof_ies++;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+const s1ap_lazy_ie_t* s1ap_lazy_pdu::find_ie(uint32_t id) const
+{
+  for (uint32_t i = 0; i < nof_ies; i++) {
+    if (ies[i].id == id) {
+      return &ies[i];
+    }
+  }
+  return NULL;
+}
+
+bool s1ap_lazy_pdu::get_octet_string(uint32_t id, const uint8_t **data, uint32_t *len) const
+{
+  const s1ap_lazy_ie_t *ie = find_ie(id);
+  if (ie == NULL) {
+    return false;
+  }
+  uint32_t pos = ie->offset;
+  uint32_t end = ie->offset + ie->len;
+  if (!read_length(msg, end, &pos, len) || pos + *len > end) {
+    return false;
+  }
+  *data = &msg[pos];
+  return true;
+}
+
+// The IE value as liblte's one-bit-per-byte array
+uint8_t* s1ap_lazy_pdu::unpack_bits(const s1ap_lazy_ie_t *ie)
+{
+  uint32_t n_bits = ie->len * 8;
+  uint8_t *bits = (uint8_t*) arena->alloc(n_bits + S1AP_LAZY_IE_SLACK_BITS);
+  if (bits == NULL) {
+    return NULL;
+  }
+  const uint8_t *p = &msg[ie->offset];
+  for (uint32_t i = 0; i < ie->len; i++) {
+    for (uint32_t j = 0; j < 8; j++) {
+      bits[i * 8 + j] = (p[i] >> (7 - j)) & 1;
+    }
+  }
+  memset(&bits[n_bits], 0, S1AP_LAZY_IE_SLACK_BITS);
+  return bits;
+}
+
+} // namespace srslte
@@ -47,17 +47,15 @@
                               TYPEDEFS
 *******************************************************************************/
 
-typedef struct{
-    uint8 rk[11][4][4];
-}ROUND_KEY_STRUCT;
+typedef LIBLTE_SECURITY_ROUND_KEY_STRUCT ROUND_KEY_STRUCT;
 
 typedef struct{
     uint8 state[4][4];
 }STATE_STRUCT;
 
 typedef struct{
-    uint32 * lfsr;
-    uint32 * fsm;
+    uint32 lfsr[16];
+    uint32 fsm[3];
 }S3G_STATE;
 
 /*******************************************************************************
@@ -338,25 +336,16 @@ uint32 s3g_clock_fsm(S3G_STATE * state);
 void s3g_initialize(S3G_STATE * state, uint32 k[4], uint32 iv[4]);
 
 /*********************************************************************
-    Name: s3g_deinitialize
+    Name: s3g_generate_keystream_xor
 
-    Description: Deinitialization.
-
-    Document Reference: Specification of the 3GPP Confidentiality and
-                            Integrity Algorithms UEA2 & UIA2 D2 v1.1
-*********************************************************************/
-void s3g_deinitialize(S3G_STATE * state);
-
-/*********************************************************************
-    Name: s3g_generate_keystream
-
-    Description: Generation of Keystream.
+    Description: Generation of Keystream, XORed into n bytes of in
+                 as it is produced.
 
     Document Reference: Specification of the 3GPP Confidentiality and
                             Integrity Algorithms UEA2 & UIA2 D2 v1.1
                             Section 4.2
 *********************************************************************/
-void s3g_generate_keystream(S3G_STATE * state, uint32 n, uint32 *ks);
+void s3g_generate_keystream_xor(S3G_STATE * state, uint8 *in, uint32 n, uint8 *out);
 
 
 /*******************************************************************************
@@ -930,21 +919,15 @@ LIBLTE_ERROR_ENUM liblte_security_encryption_eea1(uint8  *key,
                                                   uint8  *out)
 {
     LIBLTE_ERROR_ENUM err = LIBLTE_ERROR_INVALID_INPUTS;
-    S3G_STATE state, *state_ptr;
+    S3G_STATE state;
     uint32 k[] = {0,0,0,0};
     uint32 iv[] = {0,0,0,0};
-    uint32 *ks;
     int32 i;
-    uint32 msg_len_block_8, msg_len_block_32, m;
 
     if (key != NULL &&
         msg != NULL &&
         out != NULL)
     {
-        state_ptr = &state;
-        msg_len_block_8 = (msg_len + 7) / 8;
-        msg_len_block_32 = (msg_len + 31) / 32;
-
         // Transform key
         for (i = 3; i >= 0; i--) {
             k[i] = (key[4 * (3 - i) + 0] << 24) |
@@ -960,33 +943,14 @@ LIBLTE_ERROR_ENUM liblte_security_encryption_eea1(uint8  *key,
         iv[0] = iv[2];
 
         // Initialize keystream
-        s3g_initialize(state_ptr, k, iv);
+        s3g_initialize(&state, k, iv);
 
-        // Generate keystream
-
-        ks = (uint32 *) calloc(msg_len_block_32, sizeof(uint32));
-        s3g_generate_keystream(state_ptr, msg_len_block_32, ks);
-
-        // Generate output except last block
-        for (i = 0; i < (int32_t)msg_len_block_32 - 1; i++) {
-            out[4 * i + 0] = msg[4 * i + 0] ^ ((ks[i] >> 24) & 0xFF);
-            out[4 * i + 1] = msg[4 * i + 1] ^ ((ks[i] >> 16) & 0xFF);
-            out[4 * i + 2] = msg[4 * i + 2] ^ ((ks[i] >>  8) & 0xFF);
-            out[4 * i + 3] = msg[4 * i + 3] ^ ((ks[i]        & 0xFF));
-        }
-
-        // Process last bytes
-        for (i = (msg_len_block_32 - 1) * 4; i < (int32_t)msg_len_block_8; i++) {
-            out[i] = msg[i] ^ ((ks[i / 4] >> ((3 - (i % 4)) * 8)) & 0xFF);
-        }
+        // Generate keystream and output
+        s3g_generate_keystream_xor(&state, msg, (msg_len + 7) / 8, out);
 
         // Zero tailing bits
         zero_tailing_bits(out, msg_len);
 
-        // Clean up
-        free(ks);
-        s3g_deinitialize(state_ptr);
-
         err = LIBLTE_SUCCESS;
     }
 
@@ -1449,6 +1413,161 @@ LIBLTE_ERROR_ENUM liblte_compute_opc(uint8            *k,
   return err;
 }
 
+/*********************************************************************
+    Name: liblte_security_milenage_init
+
+    Description: Computes the Rijndael round keys of a subscriber's
+                 key K once, so that Milenage can be run for many
+                 RANDs without repeating the key schedule.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_milenage_init(uint8                               *k,
+                                                uint8                               *op_c,
+                                                LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *ctx)
+{
+    LIBLTE_ERROR_ENUM err = LIBLTE_ERROR_INVALID_INPUTS;
+    uint32            i;
+
+    if(k    != NULL &&
+       op_c != NULL &&
+       ctx  != NULL)
+    {
+        rijndael_key_schedule(k, &ctx->round_keys);
+        for(i=0; i<16; i++)
+        {
+            ctx->op_c[i] = op_c[i];
+        }
+        err = LIBLTE_SUCCESS;
+    }
+    return(err);
+}
+
+/*********************************************************************
+    Name: liblte_security_milenage_f12345
+
+    Description: Milenage security functions F1, F2, F3, F4, and F5
+                 from a context set up by liblte_security_milenage_init.
+                 Computes MAC-A, RES, CK, IK, and AK of one
+                 authentication vector, sharing the first Rijndael
+                 block (TEMP) between F1 and F2-F5.
+
+    Document Reference: 35.206 v10.0.0 Annex 3
+*********************************************************************/
+LIBLTE_ERROR_ENUM liblte_security_milenage_f12345(LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *ctx,
+                                                  uint8                               *rand,
+                                                  uint8                               *sqn,
+                                                  uint8                               *amf,
+                                                  uint8                               *mac_a,
+                                                  uint8                               *res,
+                                                  uint8                               *ck,
+                                                  uint8                               *ik,
+                                                  uint8                               *ak)
+{
+    LIBLTE_ERROR_ENUM err = LIBLTE_ERROR_INVALID_INPUTS;
+    uint32            i;
+    uint8            *op_c;
+    uint8             temp[16];
+    uint8             in1[16];
+    uint8             out[16];
+    uint8             rijndael_input[16];
+
+    if(ctx   != NULL &&
+       rand  != NULL &&
+       sqn   != NULL &&
+       amf   != NULL &&
+       mac_a != NULL &&
+       res   != NULL &&
+       ck    != NULL &&
+       ik    != NULL &&
+       ak    != NULL)
+    {
+        op_c = ctx->op_c;
+
+        // Compute temp
+        for(i=0; i<16; i++)
+        {
+            rijndael_input[i] = rand[i] ^ op_c[i];
+        }
+        rijndael_encrypt(rijndael_input, &ctx->round_keys, temp);
+
+        // Construct in1
+        for(i=0; i<6; i++)
+        {
+            in1[i]   = sqn[i];
+            in1[i+8] = sqn[i];
+        }
+        for(i=0; i<2; i++)
+        {
+            in1[i+6]  = amf[i];
+            in1[i+14] = amf[i];
+        }
+
+        // Compute out1 and return MAC-A
+        for(i=0; i<16; i++)
+        {
+            rijndael_input[(i+8) % 16] = in1[i] ^ op_c[i];
+        }
+        for(i=0; i<16; i++)
+        {
+            rijndael_input[i] ^= temp[i];
+        }
+        rijndael_encrypt(rijndael_input, &ctx->round_keys, out);
+        for(i=0; i<8; i++)
+        {
+            mac_a[i] = out[i] ^ op_c[i];
+        }
+
+        // Compute out for RES and AK
+        for(i=0; i<16; i++)
+        {
+            rijndael_input[i] = temp[i] ^ op_c[i];
+        }
+        rijndael_input[15] ^= 1;
+        rijndael_encrypt(rijndael_input, &ctx->round_keys, out);
+        for(i=0; i<16; i++)
+        {
+            out[i] ^= op_c[i];
+        }
+        for(i=0; i<8; i++)
+        {
+            res[i] = out[i+8];
+        }
+        for(i=0; i<6; i++)
+        {
+            ak[i] = out[i];
+        }
+
+        // Compute out for CK
+        for(i=0; i<16; i++)
+        {
+            rijndael_input[(i+12) % 16] = temp[i] ^ op_c[i];
+        }
+        rijndael_input[15] ^= 2;
+        rijndael_encrypt(rijndael_input, &ctx->round_keys, out);
+        for(i=0; i<16; i++)
+        {
+            ck[i] = out[i] ^ op_c[i];
+        }
+
+        // Compute out for IK
+        for(i=0; i<16; i++)
+        {
+            rijndael_input[(i+8) % 16] = temp[i] ^ op_c[i];
+        }
+        rijndael_input[15] ^= 4;
+        rijndael_encrypt(rijndael_input, &ctx->round_keys, out);
+        for(i=0; i<16; i++)
+        {
+            ik[i] = out[i] ^ op_c[i];
+        }
+
+        err = LIBLTE_SUCCESS;
+    }
+
+    return(err);
+}
+
 /*******************************************************************************
                               LOCAL FUNCTIONS
 *******************************************************************************/
@@ -1658,7 +1777,9 @@ void mix_column(STATE_STRUCT *state)
 *********************************************************************/
 void zero_tailing_bits(uint8 * data, uint32 length_bits) {
     uint8 bits = (8 - (length_bits & 0x07)) & 0x07;
-    data[(length_bits + 7) / 8 - 1] &= (uint8) (0xFF << bits);
+    if (bits != 0) {
+        data[(length_bits + 7) / 8 - 1] &= (uint8) (0xFF << bits);
+    }
 }
 
 /*********************************************************************
@@ -1870,9 +1991,6 @@ void s3g_initialize(S3G_STATE * state, uint32 k[4], uint32 iv[4]) {
     uint8 i = 0;
     uint32 f = 0x0;
 
-    state->lfsr = (uint32 *) calloc(16, sizeof(uint32));
-    state->fsm  = (uint32 *) calloc( 3, sizeof(uint32));
-
     state->lfsr[15] = k[3] ^ iv[0];
     state->lfsr[14] = k[2];
     state->lfsr[13] = k[1];
@@ -1901,40 +2019,30 @@ void s3g_initialize(S3G_STATE * state, uint32 k[4], uint32 iv[4]) {
 }
 
 /*********************************************************************
-    Name: s3g_deinitialize
+    Name: s3g_generate_keystream_xor
 
-    Description: Deinitialization.
-
-    Document Reference: Specification of the 3GPP Confidentiality and
-                            Integrity Algorithms UEA2 & UIA2 D2 v1.1
-*********************************************************************/
-void s3g_deinitialize(S3G_STATE * state) {
-    free(state->lfsr);
-    free(state->fsm);
-}
-
-/*********************************************************************
-    Name: s3g_generate_keystream
-
-    Description: Generation of Keystream.
+    Description: Generation of Keystream, XORed into n bytes of in
+                 as it is produced.
 
     Document Reference: Specification of the 3GPP Confidentiality and
                             Integrity Algorithms UEA2 & UIA2 D2 v1.1
                             Section 4.2
 *********************************************************************/
-void s3g_generate_keystream(S3G_STATE * state, uint32 n, uint32 *ks) {
-    uint32 t = 0;
-    uint32 f = 0x0;
+void s3g_generate_keystream_xor(S3G_STATE * state, uint8 *in, uint32 n, uint8 *out) {
+    uint32 i = 0;
+    uint32 j = 0;
+    uint32 z = 0;
 
     // Clock FSM once. Discard the output.
     s3g_clock_fsm(state);
     //  Clock LFSR in keystream mode once.
     s3g_clock_lfsr(state, 0x0);
 
-    for (t = 0; t < n; t++) {
-        f = s3g_clock_fsm(state);
-        // Note that ks[t] corresponds to z_{t+1} in section 4.2
-        ks[t] = f ^ state->lfsr[0];
+    for (i = 0; i < n; i += 4) {
+        z = s3g_clock_fsm(state) ^ state->lfsr[0];
         s3g_clock_lfsr(state, 0x0);
+        for (j = 0; j < 4 && i + j < n; j++) {
+            out[i + j] = in[i + j] ^ ((z >> (24 - 8 * j)) & 0xFF);
+        }
     }
 }
@@ -41,6 +41,7 @@ log_filter::log_filter()
   time_src    = NULL;
   time_format = TIME;
   logger_h    = NULL;
+  async_h     = NULL;
 }
 
 log_filter::log_filter(std::string layer)
@@ -63,6 +64,7 @@ void log_filter::init(std::string layer, logger *logger_, bool tti)
 {
   service_name  = layer;
   logger_h      = logger_;
+  async_h       = dynamic_cast<logger_async*>(logger_);
   do_tti        = tti;
 }
 
@@ -135,6 +137,58 @@ void log_filter::all_log(srslte::LOG_LEVEL_ENUM level,
   }
 }
 
+/* Queues the call to the async logger if there is one, otherwise (or if the
+ * arguments don't fit in a record) formats the line here.
+ */
+void log_filter::all_log_va(srslte::LOG_LEVEL_ENUM level,
+                            uint32_t               tti,
+                            bool                   dump,
+                            const uint8_t         *hex,
+                            int                    size,
+                            const char            *msg,
+                            va_list                args)
+{
+  if (async_h) {
+    uint8_t  flags = 0;
+    int64_t  secs;
+    uint32_t usec;
+    if (!time_src) {
+      struct timeval rawtime;
+      gettimeofday(&rawtime, NULL);
+      secs = rawtime.tv_sec;
+      usec = (uint32_t) rawtime.tv_usec;
+    } else {
+      srslte_timestamp_t now = time_src->get_time();
+      secs   = now.full_secs;
+      usec   = (uint32_t) (now.frac_secs * 1e6);
+      flags |= SRSLTE_LOG_TIME_SRC;
+    }
+    flags |= time_format == EPOCH ? SRSLTE_LOG_EPOCH : 0;
+    flags |= show_layer_en ? SRSLTE_LOG_SHOW_LAYER : 0;
+    flags |= level_text_short ? SRSLTE_LOG_LEVEL_SHORT : 0;
+    flags |= do_tti ? SRSLTE_LOG_TTI : 0;
+    flags |= dump ? SRSLTE_LOG_HEX : 0;
+    int hex_size = 0;
+    if (dump && hex_limit > 0 && hex && size > 0) {
+      hex_size = size > hex_limit ? hex_limit : size;
+    }
+    if (async_h->log_va(level, flags, tti, secs, usec, service_name.c_str(),
+                        add_string_en ? add_string_val.c_str() : NULL,
+                        hex, hex_size, msg, args)) {
+      return;
+    }
+  }
+  char *args_msg = NULL;
+  if(vasprintf(&args_msg, msg, args) > 0) {
+    if (dump) {
+      all_log(level, tti, args_msg, hex, size);
+    } else {
+      all_log(level, tti, args_msg);
+    }
+  }
+  free(args_msg);
+}
+
 void log_filter::console(const char * message, ...) {
   char     *args_msg = NULL;
   va_list   args;
@@ -147,91 +201,67 @@ void log_filter::console(const char * message, ...) {
 
 void log_filter::error(const char * message, ...) {
   if (level >= LOG_LEVEL_ERROR) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_ERROR, tti, args_msg);
+    all_log_va(LOG_LEVEL_ERROR, tti, false, NULL, 0, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 void log_filter::warning(const char * message, ...) {
   if (level >= LOG_LEVEL_WARNING) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_WARNING, tti, args_msg);
+    all_log_va(LOG_LEVEL_WARNING, tti, false, NULL, 0, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 void log_filter::info(const char * message, ...) {
   if (level >= LOG_LEVEL_INFO) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_INFO, tti, args_msg);
+    all_log_va(LOG_LEVEL_INFO, tti, false, NULL, 0, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 void log_filter::debug(const char * message, ...) {
   if (level >= LOG_LEVEL_DEBUG) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_DEBUG, tti, args_msg);
+    all_log_va(LOG_LEVEL_DEBUG, tti, false, NULL, 0, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 
 void log_filter::error_hex(const uint8_t *hex, int size, const char * message, ...) {
   if (level >= LOG_LEVEL_ERROR) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_ERROR, tti, args_msg, hex, size);
+    all_log_va(LOG_LEVEL_ERROR, tti, true, hex, size, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 void log_filter::warning_hex(const uint8_t *hex, int size, const char * message, ...) {
   if (level >= LOG_LEVEL_WARNING) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_WARNING, tti, args_msg, hex, size);
+    all_log_va(LOG_LEVEL_WARNING, tti, true, hex, size, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 void log_filter::info_hex(const uint8_t *hex, int size, const char * message, ...) {
   if (level >= LOG_LEVEL_INFO) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_INFO, tti, args_msg, hex, size);
+    all_log_va(LOG_LEVEL_INFO, tti, true, hex, size, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 void log_filter::debug_hex(const uint8_t *hex, int size, const char * message, ...) {
   if (level >= LOG_LEVEL_DEBUG) {
-    char     *args_msg = NULL;
     va_list   args;
     va_start(args, message);
-    if(vasprintf(&args_msg, message, args) > 0)
-      all_log(LOG_LEVEL_DEBUG, tti, args_msg, hex, size);
+    all_log_va(LOG_LEVEL_DEBUG, tti, true, hex, size, message, args);
     va_end(args);
-    free(args_msg);
   }
 }
 
@@ -0,0 +1,618 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include "srslte/common/logger_async.h"
+#include "srslte/common/log.h"
+
+// Bounds of the executable image, string literals of the binary lie within
+extern "C" char __executable_start __attribute__((weak));
+extern "C" char edata __attribute__((weak));
+
+using namespace std;
+
+namespace srslte{
+
+/******************************************************************************
+ * Format string parsing, shared by the producers (to pack the arguments)
+ * and the logger thread (to print them)
+ *****************************************************************************/
+
+#define LOG_MAX_SPEC_LEN 32
+
+typedef enum {
+  ARG_NONE = 0,   // "%%"
+  ARG_INT,
+  ARG_LONG,
+  ARG_LLONG,
+  ARG_SIZE,
+  ARG_INTMAX,
+  ARG_PTRDIFF,
+  ARG_DOUBLE,
+  ARG_STRING,
+  ARG_POINTER,
+  ARG_INVALID     // not supported, the caller formats the line itself
+} arg_type_t;
+
+typedef struct {
+  arg_type_t type;
+  uint32_t   nof_stars;  // '*' width and precision, each an int argument
+  bool       prec_star;  // last star is the precision
+  int        precision;  // -1 if none
+  uint32_t   len;        // spec length, '%' included
+} fmt_spec_t;
+
+static void parse_spec(const char *p, fmt_spec_t *s)
+{
+  const char *q = p + 1;
+  s->type      = ARG_INVALID;
+  s->nof_stars = 0;
+  s->prec_star = false;
+  s->precision = -1;
+  s->len       = 1;
+
+  while (*q && strchr("-+ #0'", *q)) {
+    q++;
+  }
+  if (*q == '*') {
+    s->nof_stars++;
+    q++;
+  } else {
+    while (*q >= '0' && *q <= '9') {
+      q++;
+    }
+  }
+  if (*q == '.') {
+    q++;
+    if (*q == '*') {
+      s->nof_stars++;
+      s->prec_star = true;
+      q++;
+    } else {
+      s->precision = 0;
+      while (*q >= '0' && *q <= '9') {
+        s->precision = s->precision*10 + (*q - '0');
+        q++;
+      }
+    }
+  }
+  char length = 0;
+  if (*q == 'h') {
+    q += q[1] == 'h' ? 2 : 1;
+    length = 'h';
+  } else if (*q == 'l' && q[1] == 'l') {
+    q += 2;
+    length = 'q';
+  } else if (*q && strchr("lLqjzZt", *q)) {
+    length = *q == 'Z' ? 'z' : *q;
+    q++;
+  }
+  char conv = *q;
+  if (!conv) {
+    return;
+  }
+  s->len = (uint32_t) (q + 1 - p);
+  if (s->len >= LOG_MAX_SPEC_LEN) {
+    return;
+  }
+  if (conv == '%') {
+    s->type = s->len == 2 ? ARG_NONE : ARG_INVALID;
+  } else if (strchr("diouxXc", conv)) {
+    switch (length) {
+      case 0:
+      case 'h': s->type = ARG_INT; break;
+      case 'l': s->type = conv == 'c' ? ARG_INVALID : ARG_LONG; break;
+      case 'q': s->type = ARG_LLONG; break;
+      case 'j': s->type = ARG_INTMAX; break;
+      case 'z': s->type = ARG_SIZE; break;
+      case 't': s->type = ARG_PTRDIFF; break;
+      default:  break;
+    }
+  } else if (strchr("eEfFgGaA", conv)) {
+    if (length == 0 || length == 'l') {
+      s->type = ARG_DOUBLE;
+    }
+  } else if (conv == 's') {
+    if (length == 0) {
+      s->type = ARG_STRING;
+    }
+  } else if (conv == 'p') {
+    s->type = ARG_POINTER;
+  }
+}
+
+#define LOG_SLOT 8
+#define LOG_NULL_STRING 0xFFFFFFFF
+
+static uint32_t round_slot(uint32_t n)
+{
+  return (n + LOG_SLOT - 1) & ~(LOG_SLOT - 1);
+}
+
+/* Copies the arguments of fmt to out in 8-byte slots. Strings are copied
+ * too, as a length slot followed by the characters. Returns the number of
+ * bytes used or -1 if they don't fit or fmt has unsupported conversions.
+ */
+static int pack_args(const char *fmt, va_list args, uint8_t *out, uint32_t max)
+{
+  uint32_t   n = 0;
+  fmt_spec_t s;
+  const char *p = fmt;
+  while ((p = strchr(p, '%')) != NULL) {
+    parse_spec(p, &s);
+    p += s.len;
+    if (s.type == ARG_NONE) {
+      continue;
+    }
+    if (s.type == ARG_INVALID) {
+      return -1;
+    }
+    int prec = s.precision;
+    for (uint32_t i = 0; i < s.nof_stars + 1; i++) {
+      if (n + LOG_SLOT > max) {
+        return -1;
+      }
+      uint8_t *slot = &out[n];
+      n += LOG_SLOT;
+      if (i < s.nof_stars) {
+        int v = va_arg(args, int);
+        memcpy(slot, &v, sizeof(v));
+        if (s.prec_star && i == s.nof_stars - 1) {
+          prec = v;
+        }
+        continue;
+      }
+      switch (s.type) {
+        case ARG_INT:     { int v       = va_arg(args, int);       memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_LONG:    { long v      = va_arg(args, long);      memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_LLONG:   { long long v = va_arg(args, long long); memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_SIZE:    { size_t v    = va_arg(args, size_t);    memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_INTMAX:  { intmax_t v  = va_arg(args, intmax_t);  memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_PTRDIFF: { ptrdiff_t v = va_arg(args, ptrdiff_t); memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_DOUBLE:  { double v    = va_arg(args, double);    memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_POINTER: { void *v     = va_arg(args, void*);     memcpy(slot, &v, sizeof(v)); break; }
+        case ARG_STRING: {
+          const char *str = va_arg(args, const char*);
+          uint32_t    len = LOG_NULL_STRING;
+          if (str) {
+            len = (uint32_t) (prec >= 0 ? strnlen(str, prec) : strlen(str));
+            if (len > max || n + round_slot(len + 1) > max) {
+              return -1;
+            }
+            memcpy(&out[n], str, len);
+            out[n + len] = '\0';
+            n += round_slot(len + 1);
+          }
+          memcpy(slot, &len, sizeof(len));
+          break;
+        }
+        default:
+          return -1;
+      }
+    }
+  }
+  return (int) n;
+}
+
+static bool is_static_string(const char *s)
+{
+  return &__executable_start && &edata && s >= &__executable_start && s < &edata;
+}
+
+/******************************************************************************
+ * Producer side
+ *****************************************************************************/
+
+logger_async::logger_async()
+  :name_idx(0)
+  ,max_length(0)
+  ,cur_length(0)
+  ,logfile(NULL)
+  ,is_running(false)
+  ,nof_dropped(0)
+  ,nof_dropped_reported(0)
+  ,last_secs(-1)
+{
+  pthread_mutex_init(&mutex, NULL);
+  pthread_key_create(&producer_key, &producer_release);
+}
+
+logger_async::~logger_async() {
+  if(is_running) {
+    log(new std::string("Closing log\n"));
+    __atomic_store_n(&is_running, false, __ATOMIC_SEQ_CST);
+    not_empty.notify_all();
+    wait_thread_finish();
+    if (logfile) {
+      fclose(logfile);
+    }
+  }
+  // Rings of live producer threads are dropped with the logger
+  pthread_key_delete(producer_key);
+  for (uint32_t i = 0; i < producers.size(); i++) {
+    delete producers[i]->ring;
+    delete producers[i];
+  }
+  pthread_mutex_destroy(&mutex);
+}
+
+void logger_async::init(std::string file, int max_length_) {
+  max_length = (int64_t)max_length_*1024;
+  name_idx = 0;
+  filename = file;
+  logfile = fopen(filename.c_str(), "w");
+  if(logfile == NULL) {
+    printf("Error: could not create log file, no messages will be logged!\n");
+  }
+  is_running = true;
+  start(-2);
+}
+
+void logger_async::log(const char *msg) {
+  log(new std::string(msg));
+}
+
+void logger_async::log(str_ptr msg) {
+  log_record_t *r = get_slot();
+  if (!r) {
+    delete msg;
+    return;
+  }
+  r->fmt = NULL;
+  r->str = msg;
+  commit();
+}
+
+bool logger_async::log_va(uint8_t level, uint8_t flags, uint32_t tti, int64_t secs, uint32_t usec,
+                          const char *layer, const char *prepend,
+                          const uint8_t *hex, int hex_size, const char *fmt, va_list args)
+{
+  log_record_t *r = get_slot();
+  if (!r) {
+    return true;
+  }
+  uint8_t *p   = r->payload;
+  uint32_t max = sizeof(r->payload);
+  uint32_t n   = 0;
+
+  const char *strings[3] = {layer, prepend, is_static_string(fmt) ? NULL : fmt};
+  for (uint32_t i = 0; i < 3; i++) {
+    if (i > 0 && !strings[i]) {
+      continue;
+    }
+    uint32_t len = (uint32_t) strlen(strings[i]) + 1;
+    if (n + len > max) {
+      return false;
+    }
+    memcpy(&p[n], strings[i], len);
+    n += len;
+  }
+  if (prepend) {
+    flags |= SRSLTE_LOG_PREPEND;
+  }
+  if (strings[2]) {
+    flags |= SRSLTE_LOG_FMT_INLINE;
+  }
+  if (hex_size < 0 || n + (uint32_t) hex_size > max) {
+    return false;
+  }
+  if (hex_size > 0) {
+    memcpy(&p[n], hex, hex_size);
+  }
+  r->hex_offset = (uint16_t) n;
+  r->hex_size   = (uint16_t) hex_size;
+  n = round_slot(n + hex_size);
+  if (n > max) {
+    return false;
+  }
+
+  va_list ap;
+  __va_copy(ap, args);
+  int len = pack_args(fmt, ap, &p[n], max - n);
+  va_end(ap);
+  if (len < 0) {
+    return false;
+  }
+
+  r->fmt         = fmt;
+  r->str         = NULL;
+  r->secs        = secs;
+  r->usec        = usec;
+  r->tti         = tti;
+  r->args_offset = (uint16_t) n;
+  r->level       = level;
+  r->flags       = flags;
+  commit();
+  return true;
+}
+
+uint64_t logger_async::get_nof_dropped() {
+  return __atomic_load_n(&nof_dropped, __ATOMIC_RELAXED);
+}
+
+uint32_t logger_async::get_nof_queued() {
+  producer_t *p = (producer_t*) pthread_getspecific(producer_key);
+  return p ? p->ring->size() : 0;
+}
+
+log_record_t* logger_async::get_slot() {
+  producer_t *p = (producer_t*) pthread_getspecific(producer_key);
+  if (!p) {
+    p         = new producer_t;
+    p->ring   = new spsc_ring<log_record_t>(SRSLTE_LOG_RING_LEN);
+    p->closed = false;
+    pthread_mutex_lock(&mutex);
+    producers.push_back(p);
+    pthread_mutex_unlock(&mutex);
+    pthread_setspecific(producer_key, p);
+  }
+  log_record_t *r = p->ring->push_slot();
+  if (!r) {
+    __atomic_add_fetch(&nof_dropped, 1, __ATOMIC_RELAXED);
+  }
+  return r;
+}
+
+void logger_async::commit() {
+  producer_t *p = (producer_t*) pthread_getspecific(producer_key);
+  p->ring->push_commit();
+  not_empty.notify();
+}
+
+// Thread exit: the logger thread frees the ring once it is drained
+void logger_async::producer_release(void *arg) {
+  producer_t *p = (producer_t*) arg;
+  __atomic_store_n(&p->closed, true, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ * Logger thread
+ *****************************************************************************/
+
+void logger_async::run_thread() {
+  while(__atomic_load_n(&is_running, __ATOMIC_ACQUIRE)) {
+    if (!drain()) {
+      uint32_t s = not_empty.prepare_wait();
+      if (!drain() && __atomic_load_n(&is_running, __ATOMIC_ACQUIRE)) {
+        not_empty.wait(s);
+      }
+    }
+  }
+  drain();
+}
+
+bool logger_async::drain() {
+  bool any = false;
+  pthread_mutex_lock(&mutex);
+  for (uint32_t i = 0; i < producers.size(); i++) {
+    producer_t   *p      = producers[i];
+    bool          closed = __atomic_load_n(&p->closed, __ATOMIC_ACQUIRE);
+    log_record_t *r;
+    while ((r = p->ring->pop_slot()) != NULL) {
+      write_record(r);
+      p->ring->pop_release();
+      any = true;
+    }
+    if (closed) {
+      delete p->ring;
+      delete p;
+      producers.erase(producers.begin() + i);
+      i--;
+    }
+  }
+  pthread_mutex_unlock(&mutex);
+
+  uint64_t dropped = get_nof_dropped();
+  if (dropped != nof_dropped_reported) {
+    int n = snprintf(line, SRSLTE_LOG_LINE_LEN, "Log: %lu records dropped\n",
+                     (unsigned long) (dropped - nof_dropped_reported));
+    write_line(line, (uint32_t) n);
+    nof_dropped_reported = dropped;
+  }
+  return any;
+}
+
+static uint32_t clamp_len(int n, uint32_t room)
+{
+  if (n < 0 || room == 0) {
+    return 0;
+  }
+  return (uint32_t) n < room ? (uint32_t) n : room - 1;
+}
+
+uint32_t logger_async::print_time(log_record_t *r, char *out, uint32_t max) {
+  if (r->flags & SRSLTE_LOG_EPOCH) {
+    return clamp_len(snprintf(out, max, "%ld", (long) (r->secs*1000000 + r->usec)), max);
+  }
+  if (r->flags & SRSLTE_LOG_TIME_SRC) {
+    return clamp_len(snprintf(out, max, "%ld:%06u", (long) r->secs, r->usec), max);
+  }
+  if (r->secs != last_secs) {
+    time_t    t = (time_t) r->secs;
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    strftime(last_time, sizeof(last_time), "%H:%M:%S", &timeinfo);
+    last_secs = r->secs;
+  }
+  return clamp_len(snprintf(out, max, "%s.%06u", last_time, r->usec), max);
+}
+
+#define LOG_PRINT(v) \
+  (s.nof_stars == 0 ? snprintf(o, room, spec, v) : \
+   s.nof_stars == 1 ? snprintf(o, room, spec, star[0], v) : \
+                      snprintf(o, room, spec, star[0], star[1], v))
+
+#define LOG_PRINT_ARG(type) \
+  { type v; memcpy(&v, slot, sizeof(v)); w = LOG_PRINT(v); }
+
+uint32_t logger_async::print_msg(log_record_t *r, const char *fmt, char *out, uint32_t max) {
+  const uint8_t *args = &r->payload[r->args_offset];
+  uint32_t       n    = 0;
+  uint32_t       pos  = 0;
+  fmt_spec_t     s;
+  char           spec[LOG_MAX_SPEC_LEN];
+
+  const char *p = fmt;
+  while (*p && pos + 1 < max) {
+    const char *q = strchr(p, '%');
+    uint32_t lit = q ? (uint32_t) (q - p) : (uint32_t) strlen(p);
+    lit = lit < max - 1 - pos ? lit : max - 1 - pos;
+    memcpy(&out[pos], p, lit);
+    pos += lit;
+    if (!q) {
+      break;
+    }
+    parse_spec(q, &s);
+    p = q + s.len;
+    if (s.type == ARG_NONE) {
+      if (pos + 1 < max) {
+        out[pos++] = '%';
+      }
+      continue;
+    }
+    int star[2] = {0, 0};
+    for (uint32_t i = 0; i < s.nof_stars; i++) {
+      memcpy(&star[i], &args[n], sizeof(int));
+      n += LOG_SLOT;
+    }
+    memcpy(spec, q, s.len);
+    spec[s.len] = '\0';
+    const uint8_t *slot = &args[n];
+    n += LOG_SLOT;
+
+    char    *o    = &out[pos];
+    uint32_t room = max - pos;
+    int      w    = 0;
+    switch (s.type) {
+      case ARG_INT:     LOG_PRINT_ARG(int);       break;
+      case ARG_LONG:    LOG_PRINT_ARG(long);      break;
+      case ARG_LLONG:   LOG_PRINT_ARG(long long); break;
+      case ARG_SIZE:    LOG_PRINT_ARG(size_t);    break;
+      case ARG_INTMAX:  LOG_PRINT_ARG(intmax_t);  break;
+      case ARG_PTRDIFF: LOG_PRINT_ARG(ptrdiff_t); break;
+      case ARG_DOUBLE:  LOG_PRINT_ARG(double);    break;
+      case ARG_POINTER: LOG_PRINT_ARG(void*);     break;
+      case ARG_STRING: {
+        uint32_t len;
+        memcpy(&len, slot, sizeof(len));
+        const char *str = NULL;
+        if (len != LOG_NULL_STRING) {
+          str = (const char*) &args[n];
+          n  += round_slot(len + 1);
+        }
+        w = LOG_PRINT(str);
+        break;
+      }
+      default:
+        break;
+    }
+    pos += clamp_len(w, room);
+  }
+  out[pos] = '\0';
+  return pos;
+}
+
+void logger_async::write_record(log_record_t *r) {
+  if (!r->fmt) {
+    if (r->str) {
+      write_line(r->str->c_str(), (uint32_t) r->str->length());
+      delete r->str;
+    }
+    return;
+  }
+  const uint32_t max   = SRSLTE_LOG_LINE_LEN;
+  const char    *layer = (const char*) r->payload;
+  const char    *extra = layer + strlen(layer) + 1;
+  const char    *fmt   = r->fmt;
+  uint32_t       pos;
+
+  pos  = print_time(r, line, max);
+  pos += clamp_len(snprintf(&line[pos], max - pos, " "), max - pos);
+  if (r->flags & SRSLTE_LOG_SHOW_LAYER) {
+    pos += clamp_len(snprintf(&line[pos], max - pos, "[%s] ", layer), max - pos);
+  }
+  pos += clamp_len(snprintf(&line[pos], max - pos, "%s ", (r->flags & SRSLTE_LOG_LEVEL_SHORT) ?
+                            log_level_text_short[r->level] : log_level_text[r->level]), max - pos);
+  if (r->flags & SRSLTE_LOG_TTI) {
+    pos += clamp_len(snprintf(&line[pos], max - pos, "[%05u] ", r->tti), max - pos);
+  }
+  if (r->flags & SRSLTE_LOG_PREPEND) {
+    pos += clamp_len(snprintf(&line[pos], max - pos, "%s ", extra), max - pos);
+    extra += strlen(extra) + 1;
+  }
+  if (r->flags & SRSLTE_LOG_FMT_INLINE) {
+    fmt = extra;
+  }
+
+  uint32_t msg_len = print_msg(r, fmt, &line[pos], max - pos);
+  if (msg_len == 0) {
+    // Empty message, log_filter drops those
+    return;
+  }
+  pos += msg_len;
+
+  if (r->flags & SRSLTE_LOG_HEX) {
+    if (line[pos - 1] != '\n' && pos + 1 < max) {
+      line[pos++] = '\n';
+    }
+    const uint8_t *hex = &r->payload[r->hex_offset];
+    for (uint32_t c = 0; c < r->hex_size && pos + 1 < max; ) {
+      pos += clamp_len(snprintf(&line[pos], max - pos, "             %04x: ", c), max - pos);
+      uint32_t tmp = (r->hex_size - c < 16) ? r->hex_size - c : 16;
+      for (uint32_t i = 0; i < tmp; i++) {
+        pos += clamp_len(snprintf(&line[pos], max - pos, "%02x ", hex[c++]), max - pos);
+      }
+      pos += clamp_len(snprintf(&line[pos], max - pos, "\n"), max - pos);
+    }
+  }
+  write_line(line, pos);
+}
+
+void logger_async::write_line(const char *msg, uint32_t len) {
+  if (!logfile || len == 0) {
+    return;
+  }
+  size_t n = fwrite(msg, 1, len, logfile);
+  cur_length += (int64_t) n;
+  if (cur_length >= max_length && max_length > 0) {
+    fclose(logfile);
+    name_idx++;
+    char numstr[21]; // enough to hold all numbers up to 64-bits
+    sprintf(numstr, ".%d", name_idx);
+    string newfilename = filename + numstr ;
+    logfile = fopen(newfilename.c_str(), "w");
+    if(logfile==NULL) {
+      printf("Error: could not create log file, no messages will be logged!\n");
+    }
+    cur_length = 0;
+  }
+}
+
+} // namespace srslte
@@ -0,0 +1,261 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <string.h>
+#include "srslte/common/pdcp_crypto.h"
+#include "srslte/common/snow_3g.h"
+#include "srslte/common/zuc.h"
+
+namespace srslte {
+
+static inline void xor_block(uint8_t *x, const uint8_t *y)
+{
+  uint64_t a[2], b[2];
+  memcpy(a, x, 16);
+  memcpy(b, y, 16);
+  a[0] ^= b[0];
+  a[1] ^= b[1];
+  memcpy(x, a, 16);
+}
+
+// Left shift by one bit of a 128-bit string, with the RFC4493 reduction
+static void cmac_subkey(const uint8_t *in, uint8_t *out)
+{
+  for (int i = 0; i < 15; i++) {
+    out[i] = (in[i] << 1) | (in[i+1] >> 7);
+  }
+  out[15] = in[15] << 1;
+  if (in[0] & 0x80) {
+    out[15] ^= 0x87;
+  }
+}
+
+pdcp_crypto::pdcp_crypto()
+{
+  cipher_algo = CIPHERING_ALGORITHM_ID_EEA0;
+  integ_algo  = INTEGRITY_ALGORITHM_ID_EIA0;
+  bzero(k_enc, sizeof(k_enc));
+  bzero(k_int, sizeof(k_int));
+  bzero(cmac_k1, sizeof(cmac_k1));
+  bzero(cmac_k2, sizeof(cmac_k2));
+}
+
+void pdcp_crypto::set_keys(uint8_t *k_enc_,
+                           uint8_t *k_int_,
+                           CIPHERING_ALGORITHM_ID_ENUM cipher_algo_,
+                           INTEGRITY_ALGORITHM_ID_ENUM integ_algo_)
+{
+  memcpy(k_enc, k_enc_, 16);
+  memcpy(k_int, k_int_, 16);
+  cipher_algo = cipher_algo_;
+  integ_algo  = integ_algo_;
+
+  if (cipher_algo == CIPHERING_ALGORITHM_ID_128_EEA2) {
+    aes_setkey_enc(&aes_enc, k_enc, 128);
+  }
+  if (integ_algo == INTEGRITY_ALGORITHM_ID_128_EIA2) {
+    uint8_t l[16];
+    bzero(l, sizeof(l));
+    aes_setkey_enc(&aes_int, k_int, 128);
+    aes_crypt_ecb(&aes_int, AES_ENCRYPT, l, l);
+    cmac_subkey(l, cmac_k1);
+    cmac_subkey(cmac_k1, cmac_k2);
+  }
+}
+
+void pdcp_crypto::cipher(uint32_t  count,
+                         uint8_t   bearer,
+                         uint8_t   direction,
+                         uint8_t  *msg,
+                         uint32_t  len,
+                         uint8_t  *out)
+{
+  switch(cipher_algo)
+  {
+  case CIPHERING_ALGORITHM_ID_EEA0:
+    if (out != msg) {
+      memmove(out, msg, len);
+    }
+    break;
+  case CIPHERING_ALGORITHM_ID_128_EEA1:
+    if (out != msg) {
+      memmove(out, msg, len);
+    }
+    snow3g_f8(k_enc, count, bearer, direction, out, len * 8);
+    break;
+  case CIPHERING_ALGORITHM_ID_128_EEA2:
+    eea2(count, bearer, direction, msg, len, out);
+    break;
+  case CIPHERING_ALGORITHM_ID_128_EEA3:
+    if (out != msg) {
+      memmove(out, msg, len);
+    }
+    zuc_eea3(k_enc, count, bearer, direction, out, len * 8);
+    break;
+  default:
+    break;
+  }
+}
+
+void pdcp_crypto::cipher_batch(uint8_t            bearer,
+                               uint8_t            direction,
+                               pdcp_crypto_sdu_t *sdus,
+                               uint32_t           nof_sdus)
+{
+  switch(cipher_algo)
+  {
+  case CIPHERING_ALGORITHM_ID_128_EEA1:
+    for (uint32_t i = 0; i < nof_sdus; i++) {
+      snow3g_f8(k_enc, sdus[i].count, bearer, direction, sdus[i].msg, sdus[i].len * 8);
+    }
+    break;
+  case CIPHERING_ALGORITHM_ID_128_EEA2:
+    for (uint32_t i = 0; i < nof_sdus; i++) {
+      eea2(sdus[i].count, bearer, direction, sdus[i].msg, sdus[i].len, sdus[i].msg);
+    }
+    break;
+  case CIPHERING_ALGORITHM_ID_128_EEA3:
+    for (uint32_t i = 0; i < nof_sdus; i++) {
+      zuc_eea3(k_enc, sdus[i].count, bearer, direction, sdus[i].msg, sdus[i].len * 8);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void pdcp_crypto::integrity(uint32_t  count,
+                            uint8_t   bearer,
+                            uint8_t   direction,
+                            uint8_t  *msg,
+                            uint32_t  len,
+                            uint8_t  *mac)
+{
+  switch(integ_algo)
+  {
+  case INTEGRITY_ALGORITHM_ID_EIA0:
+    break;
+  case INTEGRITY_ALGORITHM_ID_128_EIA1:
+    security_128_eia1(k_int, count, bearer, direction, msg, len, mac);
+    break;
+  case INTEGRITY_ALGORITHM_ID_128_EIA2:
+    eia2(count, bearer, direction, msg, len, mac);
+    break;
+  case INTEGRITY_ALGORITHM_ID_128_EIA3:
+    zuc_eia3(k_int, count, bearer, direction, msg, len * 8, mac);
+    break;
+  default:
+    break;
+  }
+}
+
+/* AES-CTR, 33.401 Annex B.1.3. The keystream is made a block at a time
+ * from the cached key schedule and XORed 64 bits at a time.
+ */
+void pdcp_crypto::eea2(uint32_t count, uint8_t bearer, uint8_t direction, uint8_t *msg, uint32_t len, uint8_t *out)
+{
+  uint8_t ctr[16];
+  uint8_t ks[16];
+  uint32_t i = 0;
+
+  bzero(ctr, sizeof(ctr));
+  ctr[0] = (count >> 24) & 0xFF;
+  ctr[1] = (count >> 16) & 0xFF;
+  ctr[2] = (count >>  8) & 0xFF;
+  ctr[3] = count & 0xFF;
+  ctr[4] = ((bearer & 0x1F) << 3) | ((direction & 0x01) << 2);
+
+  while (i < len) {
+    aes_crypt_ecb(&aes_enc, AES_ENCRYPT, ctr, ks);
+    for (int j = 15; j >= 0; j--) {
+      if (++ctr[j] != 0) {
+        break;
+      }
+    }
+    if (len - i >= 16) {
+      if (out != msg) {
+        memmove(&out[i], &msg[i], 16);
+      }
+      xor_block(&out[i], ks);
+      i += 16;
+    } else {
+      for (uint32_t j = 0; i < len; i++, j++) {
+        out[i] = msg[i] ^ ks[j];
+      }
+    }
+  }
+}
+
+/* AES-CMAC, 33.401 Annex B.2.3 and RFC4493. The 8-byte COUNT/BEARER/
+ * DIRECTION header and the first 8 bytes of msg make the first block;
+ * the other blocks are read from msg where it lies.
+ */
+void pdcp_crypto::eia2(uint32_t count, uint8_t bearer, uint8_t direction, uint8_t *msg, uint32_t len, uint8_t *mac)
+{
+  uint8_t  t[16];
+  uint8_t  blk[16];
+  uint32_t total      = len + 8;
+  uint32_t nof_blocks = (total + 15) / 16;
+
+  bzero(t, sizeof(t));
+  for (uint32_t i = 0; i < nof_blocks; i++) {
+    const uint8_t *src;
+    uint32_t       src_len;
+    if (i == 0) {
+      bzero(blk, sizeof(blk));
+      blk[0] = (count >> 24) & 0xFF;
+      blk[1] = (count >> 16) & 0xFF;
+      blk[2] = (count >>  8) & 0xFF;
+      blk[3] = count & 0xFF;
+      blk[4] = (bearer << 3) | (direction << 2);
+      src_len = (len < 8) ? len : 8;
+      memcpy(&blk[8], msg, src_len);
+      src     = blk;
+      src_len += 8;
+    } else {
+      src     = &msg[16 * i - 8];
+      src_len = (total - 16 * i < 16) ? (total - 16 * i) : 16;
+    }
+
+    if (i < nof_blocks - 1) {
+      xor_block(t, src);
+    } else if (src_len == 16) {
+      xor_block(t, src);
+      xor_block(t, cmac_k1);
+    } else {
+      uint8_t last[16];
+      bzero(last, sizeof(last));
+      memcpy(last, src, src_len);
+      last[src_len] = 0x80;
+      xor_block(t, last);
+      xor_block(t, cmac_k2);
+    }
+    aes_crypt_ecb(&aes_int, AES_ENCRYPT, t, t);
+  }
+  memcpy(mac, t, 4);
+}
+
+} // namespace srslte
@@ -28,6 +28,7 @@
 #include "srslte/common/security.h"
 #include "srslte/common/liblte_security.h"
 #include "srslte/common/snow_3g.h"
+#include "srslte/common/zuc.h"
 
 #ifdef HAVE_MBEDTLS
 #include "mbedtls/md5.h"
@@ -139,20 +140,14 @@ uint8_t security_128_eia1( uint8_t  *key,
                            uint32_t  msg_len,
                            uint8_t  *mac)
 {
-  uint32_t msg_len_bits;
-  uint32_t i;
-  uint8_t *m_ptr;
-
-  msg_len_bits = msg_len*8;
-  m_ptr = snow3g_f9(key,
-                    count,
-                    bearer,
-                    direction,
-                    msg,
-                    msg_len_bits);
-  for(i=0; i<4; i++) {
-    mac[i] = m_ptr[i];
-  }
+  // FRESH is BEARER in the 5 MSBs, see 33.401 B.2.2
+  snow3g_f9(key,
+            count,
+            bearer << 27,
+            direction,
+            msg,
+            (uint64_t)msg_len*8,
+            mac);
   return ERROR_NONE;
 }
 
@@ -173,6 +168,24 @@ uint8_t security_128_eia2( uint8_t  *key,
                                   mac);
 }
 
+uint8_t security_128_eia3( uint8_t  *key,
+                           uint32_t  count,
+                           uint32_t   bearer,
+                           uint8_t   direction,
+                           uint8_t  *msg,
+                           uint32_t  msg_len,
+                           uint8_t  *mac)
+{
+  zuc_eia3(key,
+           count,
+           bearer,
+           direction,
+           msg,
+           msg_len*8,
+           mac);
+  return ERROR_NONE;
+}
+
 uint8_t security_md5(const uint8_t *input, size_t len, uint8_t *output)
 {
   memset(output, 0x00, 16);
@@ -226,6 +239,26 @@ uint8_t security_128_eea2(uint8_t  *key,
                                            msg_out);
 }
 
+uint8_t security_128_eea3(uint8_t  *key,
+                           uint32_t count,
+                           uint8_t  bearer,
+                           uint8_t direction,
+                           uint8_t *msg,
+                           uint32_t msg_len,
+                           uint8_t *msg_out){
+
+    if (msg_out != msg) {
+      memmove(msg_out, msg, msg_len);
+    }
+    zuc_eea3(key,
+             count,
+             bearer,
+             direction,
+             msg_out,
+             msg_len * 8);
+    return ERROR_NONE;
+}
+
 /******************************************************************************
  * Authentication
  *****************************************************************************/
@@ -296,5 +329,33 @@ uint8_t security_milenage_f5_star( uint8_t *k,
                                           ak);
 }
 
+uint8_t security_milenage_init( uint8_t                             *k,
+                                uint8_t                             *opc,
+                                LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *ctx)
+{
+  return liblte_security_milenage_init(k, opc, ctx);
+}
+
+uint8_t security_milenage_f12345( LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *ctx,
+                                  uint8_t *rand,
+                                  uint8_t *sqn,
+                                  uint8_t *amf,
+                                  uint8_t *mac_a,
+                                  uint8_t *res,
+                                  uint8_t *ck,
+                                  uint8_t *ik,
+                                  uint8_t *ak)
+{
+  return liblte_security_milenage_f12345(ctx,
+                                         rand,
+                                         sqn,
+                                         amf,
+                                         mac_a,
+                                         res,
+                                         ck,
+                                         ik,
+                                         ak);
+}
+
 
 } // namespace srsue
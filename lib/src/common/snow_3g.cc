@@ -12,34 +12,9 @@
 
 #include "srslte/common/snow_3g.h"
 
-/* LFSR */
-
-u32 LFSR_S0 = 0x00;
-u32 LFSR_S1 = 0x00;
-u32 LFSR_S2 = 0x00;
-u32 LFSR_S3 = 0x00;
-u32 LFSR_S4 = 0x00;
-u32 LFSR_S5 = 0x00;
-u32 LFSR_S6 = 0x00;
-u32 LFSR_S7 = 0x00;
-u32 LFSR_S8 = 0x00;
-u32 LFSR_S9 = 0x00;
-u32 LFSR_S10 = 0x00;
-u32 LFSR_S11 = 0x00;
-u32 LFSR_S12 = 0x00;
-u32 LFSR_S13 = 0x00;
-u32 LFSR_S14 = 0x00;
-u32 LFSR_S15 = 0x00;
-
-/* FSM */
-
-u32 FSM_R1 = 0x00;
-u32 FSM_R2 = 0x00;
-u32 FSM_R3 = 0x00;
-
 /* Rijndael S-box SR */
 
-u8 SR[256] = {
+static const u8 SR[256] = {
 0x63,0x7C,0x77,0x7B,0xF2,0x6B,0x6F,0xC5,0x30,0x01,0x67,0x2B,0xFE,0xD7,0xAB,0x76,
 0xCA,0x82,0xC9,0x7D,0xFA,0x59,0x47,0xF0,0xAD,0xD4,0xA2,0xAF,0x9C,0xA4,0x72,0xC0,
 0xB7,0xFD,0x93,0x26,0x36,0x3F,0xF7,0xCC,0x34,0xA5,0xE5,0xF1,0x71,0xD8,0x31,0x15,
@@ -60,7 +35,7 @@ u8 SR[256] = {
 
 /* S-box SQ */
 
-u8 SQ[256] = {
+static const u8 SQ[256] = {
 0x25,0x24,0x73,0x67,0xD7,0xAE,0x5C,0x30,0xA4,0xEE,0x6E,0xCB,0x7D,0xB5,0x82,0xDB,
 0xE4,0x8E,0x48,0x49,0x4F,0x5D,0x6A,0x78,0x70,0x88,0xE8,0x5F,0x5E,0x84,0x65,0xE2,
 0xD8,0xE9,0xCC,0xED,0x40,0x2F,0x11,0x28,0x57,0xD2,0xAC,0xE3,0x4A,0x15,0x1B,0xB9,
@@ -86,7 +61,7 @@ u8 SQ[256] = {
 * See section 3.1.1 for details.
 */
 
-u8 MULx(u8 V, u8 c)
+static u8 MULx(u8 V, u8 c)
 {
 	if ( V & 0x80 )
 		return ( (V << 1) ^ c);
@@ -102,179 +77,85 @@ u8 MULx(u8 V, u8 c)
 * See section 3.1.2 for details.
 */
 
-u8 MULxPOW(u8 V, u8 i, u8 c)
-{
-	if ( i == 0)
-		return V;
-	else
-		return MULx( MULxPOW( V, i-1, c ), c);
-}
-
-/* The function MUL alpha.
-* Input c: 8-bit input.
-* Output : 32-bit output.
-* See section 3.4.2 for details.
-*/
-
-u32 MULalpha(u8 c)
+static u8 MULxPOW(u8 V, u8 i, u8 c)
 {
-	return ( ( ((u32)MULxPOW(c, 23, 0xa9)) << 24 ) |
-		( ((u32)MULxPOW(c, 245, 0xa9)) << 16 ) |
-		( ((u32)MULxPOW(c, 48, 0xa9)) << 8 ) |
-		( ((u32)MULxPOW(c, 239, 0xa9)) ) ) ;
+	for ( ; i > 0; i--)
+		V = MULx(V, c);
+	return V;
 }
 
-/* The function DIV alpha.
-* Input c: 8-bit input.
-* Output : 32-bit output.
-* See section 3.4.3 for details.
+/* Lookup tables, filled once at startup.
+* MULalpha[c] and DIValpha[c] are the functions of sections 3.4.2 and
+* 3.4.3. S1_T[x] is column 0 of the S1 box (section 3.3.1) for input byte
+* x, i.e. the bytes 2*SR[x], 3*SR[x], SR[x], SR[x]; columns 1 to 3 are
+* its rotations. S2_T is the same for S2 (section 3.3.2).
 */
 
-u32 DIValpha(u8 c)
-{
-	return ( ( ((u32)MULxPOW(c, 16, 0xa9)) << 24 ) |
-		( ((u32)MULxPOW(c, 39, 0xa9)) << 16 ) |
-		( ((u32)MULxPOW(c, 6, 0xa9)) << 8 ) |
-		( ((u32)MULxPOW(c, 64, 0xa9)) ) ) ;
-}
-
-/* The 32x32-bit S-Box S1
-* Input: a 32-bit input.
-* Output: a 32-bit output of S1 box.
-* See section 3.3.1.
-*/
+static u32 MULalpha_T[256];
+static u32 DIValpha_T[256];
+static u32 S1_T[256];
+static u32 S2_T[256];
 
-u32 S1(u32 w)
+static u32 mix_column(u8 s, u8 c)
 {
-	u8 r0=0, r1=0, r2=0, r3=0;
-	u8 srw0 = SR[ (u8)((w >> 24) & 0xff) ];
-	u8 srw1 = SR[ (u8)((w >> 16) & 0xff) ];
-	u8 srw2 = SR[ (u8)((w >> 8) & 0xff) ];
-	u8 srw3 = SR[ (u8)((w) & 0xff) ];
-	r0 = ( ( MULx( srw0 , 0x1b) ) ^
-		( srw1 ) ^
-		( srw2 ) ^
-		( (MULx( srw3, 0x1b)) ^ srw3 )
-	);
-	r1 = ( ( ( MULx( srw0 , 0x1b) ) ^ srw0 ) ^
-		( MULx(srw1, 0x1b) ) ^
-		( srw2 ) ^
-		( srw3 )
-	);
-	r2 = ( ( srw0 ) ^
-		( ( MULx( srw1 , 0x1b) ) ^ srw1 ) ^
-		( MULx(srw2, 0x1b) ) ^
-		( srw3 )
-	);
-	r3 = ( ( srw0 ) ^
-		( srw1 ) ^
-		( ( MULx( srw2 , 0x1b) ) ^ srw2 ) ^
-		( MULx( srw3, 0x1b) )
-	);
-
-	return ( ( ((u32)r0) << 24 ) | ( ((u32)r1) << 16 ) | ( ((u32)r2) << 8 ) |
-		( ((u32)r3) ) );
+	u8 s2 = MULx(s, c);
+	return ((u32)s2 << 24) | ((u32)(s2 ^ s) << 16) | ((u32)s << 8) | s;
 }
 
-/* The 32x32-bit S-Box S2
-* Input: a 32-bit input.
-* Output: a 32-bit output of S2 box.
-* See section 3.3.2.
-*/
+static struct snow3g_tables_init {
+	snow3g_tables_init()
+	{
+		for (int c = 0; c < 256; c++) {
+			MULalpha_T[c] = ( ((u32)MULxPOW(c, 23, 0xa9)) << 24 ) |
+				( ((u32)MULxPOW(c, 245, 0xa9)) << 16 ) |
+				( ((u32)MULxPOW(c, 48, 0xa9)) << 8 ) |
+				( ((u32)MULxPOW(c, 239, 0xa9)) );
+			DIValpha_T[c] = ( ((u32)MULxPOW(c, 16, 0xa9)) << 24 ) |
+				( ((u32)MULxPOW(c, 39, 0xa9)) << 16 ) |
+				( ((u32)MULxPOW(c, 6, 0xa9)) << 8 ) |
+				( ((u32)MULxPOW(c, 64, 0xa9)) );
+			S1_T[c] = mix_column(SR[c], 0x1b);
+			S2_T[c] = mix_column(SQ[c], 0x69);
+		}
+	}
+} snow3g_tables;
 
-u32 S2(u32 w)
+static inline u32 ROR32(u32 w, int n)
 {
-	u8 r0=0, r1=0, r2=0, r3=0;
-	u8 sqw0 = SQ[ (u8)((w >> 24) & 0xff) ];
-	u8 sqw1 = SQ[ (u8)((w >> 16) & 0xff) ];
-	u8 sqw2 = SQ[ (u8)((w >> 8) & 0xff) ];
-	u8 sqw3 = SQ[ (u8)((w) & 0xff) ];
-	r0 = ( ( MULx( sqw0 , 0x69) ) ^
-		( sqw1 ) ^
-		( sqw2 ) ^
-		( (MULx( sqw3, 0x69)) ^ sqw3 )
-	);
-	r1 = ( ( ( MULx( sqw0 , 0x69) ) ^ sqw0 ) ^
-		( MULx(sqw1, 0x69) ) ^
-		( sqw2 ) ^
-		( sqw3 )
-	);
-	r2 = ( ( sqw0 ) ^
-		( ( MULx( sqw1 , 0x69) ) ^ sqw1 ) ^
-		( MULx(sqw2, 0x69) ) ^
-		( sqw3 )
-	);
-	r3 = ( ( sqw0 ) ^
-		( sqw1 ) ^
-		( ( MULx( sqw2 , 0x69) ) ^ sqw2 ) ^
-		( MULx( sqw3, 0x69) )
-	);
-	return ( ( ((u32)r0) << 24 ) | ( ((u32)r1) << 16 ) | ( ((u32)r2) << 8 ) |
-		( ((u32)r3) ) );
+	return (w >> n) | (w << (32 - n));
 }
 
-/* Clocking LFSR in initialization mode.
-* LFSR Registers S0 to S15 are updated as the LFSR receives a single clock.
-* Input F: a 32-bit word comes from output of FSM.
-* See section 3.4.4.
+/* The 32x32-bit S-Boxes S1 and S2.
+* Input T: S1_T or S2_T.
+* Input w: a 32-bit input.
+* Output: a 32-bit output of the S-box.
+* See sections 3.3.1 and 3.3.2.
 */
 
-void ClockLFSRInitializationMode(u32 F)
+static inline u32 S(const u32 *T, u32 w)
 {
-	u32 v = ( ( (LFSR_S0 << 8) & 0xffffff00 ) ^
-		( MULalpha( (u8)((LFSR_S0>>24) & 0xff) ) ) ^
-		( LFSR_S2 ) ^
-		( (LFSR_S11 >> 8) & 0x00ffffff ) ^
-		( DIValpha( (u8)( ( LFSR_S11) & 0xff ) ) ) ^
-		( F )
-	);
-	LFSR_S0 = LFSR_S1;
-	LFSR_S1 = LFSR_S2;
-	LFSR_S2 = LFSR_S3;
-	LFSR_S3 = LFSR_S4;
-	LFSR_S4 = LFSR_S5;
-	LFSR_S5 = LFSR_S6;
-	LFSR_S6 = LFSR_S7;
-	LFSR_S7 = LFSR_S8;
-	LFSR_S8 = LFSR_S9;
-	LFSR_S9 = LFSR_S10;
-	LFSR_S10 = LFSR_S11;
-	LFSR_S11 = LFSR_S12;
-	LFSR_S12 = LFSR_S13;
-	LFSR_S13 = LFSR_S14;
-	LFSR_S14 = LFSR_S15;
-	LFSR_S15 = v;
+	return T[ (w >> 24) & 0xff ] ^
+		ROR32( T[ (w >> 16) & 0xff ], 8 ) ^
+		ROR32( T[ (w >> 8) & 0xff ], 16 ) ^
+		ROR32( T[ w & 0xff ], 24 );
 }
 
-/* Clocking LFSR in keystream mode.
+/* Clocking LFSR.
 * LFSR Registers S0 to S15 are updated as the LFSR receives a single clock.
-* See section 3.4.5.
+* Input F: a 32-bit word comes from output of FSM in initialization
+* mode, 0 in keystream mode.
+* See sections 3.4.4 and 3.4.5.
 */
 
-void ClockLFSRKeyStreamMode()
+static inline void ClockLFSR(snow3g_state_t *st, u32 F)
 {
-	u32 v = ( ( (LFSR_S0 << 8) & 0xffffff00 ) ^
-		( MULalpha( (u8)((LFSR_S0>>24) & 0xff) ) ) ^
-		( LFSR_S2 ) ^
-		( (LFSR_S11 >> 8) & 0x00ffffff ) ^
-		( DIValpha( (u8)( ( LFSR_S11) & 0xff ) ) )
-	);
-	LFSR_S0 = LFSR_S1;
-	LFSR_S1 = LFSR_S2;
-	LFSR_S2 = LFSR_S3;
-	LFSR_S3 = LFSR_S4;
-	LFSR_S4 = LFSR_S5;
-	LFSR_S5 = LFSR_S6;
-	LFSR_S6 = LFSR_S7;
-	LFSR_S7 = LFSR_S8;
-	LFSR_S8 = LFSR_S9;
-	LFSR_S9 = LFSR_S10;
-	LFSR_S10 = LFSR_S11;
-	LFSR_S11 = LFSR_S12;
-	LFSR_S12 = LFSR_S13;
-	LFSR_S13 = LFSR_S14;
-	LFSR_S14 = LFSR_S15;
-	LFSR_S15 = v;
+	u32 *s = st->LFSR_S;
+	u32 v = ( s[0] << 8 ) ^ MULalpha_T[ s[0] >> 24 ] ^
+		s[2] ^
+		( s[11] >> 8 ) ^ DIValpha_T[ s[11] & 0xff ] ^
+		F;
+	memmove(&s[0], &s[1], 15 * sizeof(u32));
+	s[15] = v;
 }
 
 /* Clocking FSM.
@@ -283,13 +164,13 @@ void ClockLFSRKeyStreamMode()
 * See Section 3.4.6.
 */
 
-u32 ClockFSM()
+static inline u32 ClockFSM(snow3g_state_t *st)
 {
-	u32 F = ( ( LFSR_S15 + FSM_R1 ) & 0xffffffff ) ^ FSM_R2 ;
-	u32 r = ( FSM_R2 + ( FSM_R3 ^ LFSR_S5 ) ) & 0xffffffff ;
-	FSM_R3 = S2(FSM_R2);
-	FSM_R2 = S1(FSM_R1);
-	FSM_R1 = r;
+	u32 F = ( st->LFSR_S[15] + st->FSM_R1 ) ^ st->FSM_R2 ;
+	u32 r = st->FSM_R2 + ( st->FSM_R3 ^ st->LFSR_S[5] );
+	st->FSM_R3 = S(S2_T, st->FSM_R2);
+	st->FSM_R2 = S(S1_T, st->FSM_R1);
+	st->FSM_R1 = r;
 	return F;
 }
 
@@ -300,34 +181,44 @@ u32 ClockFSM()
 * See Section 4.1.
 */
 
-void snow3g_initialize(u32 k[4], u32 IV[4])
+void snow3g_initialize(snow3g_state_t *st, u32 k[4], u32 IV[4])
 {
 	u8 i=0;
-	u32 F = 0x0;
-	LFSR_S15 = k[3] ^ IV[0];
-	LFSR_S14 = k[2];
-	LFSR_S13 = k[1];
-	LFSR_S12 = k[0] ^ IV[1];
-	LFSR_S11 = k[3] ^ 0xffffffff;
-	LFSR_S10 = k[2] ^ 0xffffffff ^ IV[2];
-	LFSR_S9 = k[1] ^ 0xffffffff ^ IV[3];
-	LFSR_S8 = k[0] ^ 0xffffffff;
-	LFSR_S7 = k[3];
-	LFSR_S6 = k[2];
-	LFSR_S5 = k[1];
-	LFSR_S4 = k[0];
-	LFSR_S3 = k[3] ^ 0xffffffff;
-	LFSR_S2 = k[2] ^ 0xffffffff;
-	LFSR_S1 = k[1] ^ 0xffffffff;
-	LFSR_S0 = k[0] ^ 0xffffffff;
-	FSM_R1 = 0x0;
-	FSM_R2 = 0x0;
-	FSM_R3 = 0x0;
+	u32 *s = st->LFSR_S;
+	s[15] = k[3] ^ IV[0];
+	s[14] = k[2];
+	s[13] = k[1];
+	s[12] = k[0] ^ IV[1];
+	s[11] = k[3] ^ 0xffffffff;
+	s[10] = k[2] ^ 0xffffffff ^ IV[2];
+	s[9] = k[1] ^ 0xffffffff ^ IV[3];
+	s[8] = k[0] ^ 0xffffffff;
+	s[7] = k[3];
+	s[6] = k[2];
+	s[5] = k[1];
+	s[4] = k[0];
+	s[3] = k[3] ^ 0xffffffff;
+	s[2] = k[2] ^ 0xffffffff;
+	s[1] = k[1] ^ 0xffffffff;
+	s[0] = k[0] ^ 0xffffffff;
+	st->FSM_R1 = 0x0;
+	st->FSM_R2 = 0x0;
+	st->FSM_R3 = 0x0;
 	for(i=0;i<32;i++)
 	{
-		F = ClockFSM();
-		ClockLFSRInitializationMode(F);
+		ClockLFSR(st, ClockFSM(st));
 	}
+	ClockFSM(st); /* Clock FSM once. Discard the output. */
+	ClockLFSR(st, 0); /* Clock LFSR in keystream mode once. */
+}
+
+/* One word of keystream, z_{t+1} of section 4.2. */
+
+static inline u32 snow3g_next_word(snow3g_state_t *st)
+{
+	u32 z = ClockFSM(st) ^ st->LFSR_S[0];
+	ClockLFSR(st, 0);
+	return z;
 }
 
 /* Generation of Keystream.
@@ -338,19 +229,12 @@ void snow3g_initialize(u32 k[4], u32 IV[4])
 * See section 4.2.
 */
 
-void snow3g_generate_keystream(u32 n, u32 *ks)
+void snow3g_generate_keystream(snow3g_state_t *st, u32 n, u32 *ks)
 {
 	u32 t = 0;
-	u32 F = 0x0;
-	ClockFSM(); /* Clock FSM once. Discard the output. */
-	ClockLFSRKeyStreamMode(); /* Clock LFSR in keystream mode once. */
 	for ( t=0; t<n; t++)
 	{
-		F = ClockFSM(); /* STEP 1 */
-		ks[t] = F ^ LFSR_S0; /* STEP 2 */
-		/* Note that ks[t] corresponds to z_{t+1} in section 4.2
-		*/
-		ClockLFSRKeyStreamMode(); /* STEP 3 */
+		ks[t] = snow3g_next_word(st);
 	}
 }
 
@@ -370,11 +254,11 @@ void snow3g_generate_keystream(u32 n, u32 *ks)
 
 void snow3g_f8(u8 *key, u32 count, u32 bearer, u32 dir, u8 *data, u32 length)
 {
+	snow3g_state_t st;
 	u32 K[4],IV[4];
-	int n = ( length + 31 ) / 32;
-	int i=0;
+	u32 nbytes = ( length + 7 ) / 8;
+	u32 i=0;
 	int lastbits = (8-(length%8)) % 8;
-	u32 *KS;
 	
 	/*Initialisation*/
 	/* Load the confidentiality key for SNOW 3G initialization as in section
@@ -390,22 +274,24 @@ void snow3g_f8(u8 *key, u32 count, u32 bearer, u32 dir, u8 *data, u32 length)
 	IV[1] = IV[3];
 	IV[0] = IV[2];
 	
-	/* Run SNOW 3G algorithm to generate sequence of key stream bits KS*/
-  snow3g_initialize(K,IV);
-	KS = (u32 *)malloc(4*n);
-  snow3g_generate_keystream(n,(u32*)KS);
+	snow3g_initialize(&st,K,IV);
 	
-	/* Exclusive-OR the input data with keystream to generate the output bit
-	stream */
-	for (i=0; i<n; i++)
+	/* Exclusive-OR the input data with keystream words as they are
+	generated. Bytes past length are left untouched */
+	for (i=0; i+4<=nbytes; i+=4)
 	{
-		data[4*i+0] ^= (u8) (KS[i] >> 24) & 0xff;
-		data[4*i+1] ^= (u8) (KS[i] >> 16) & 0xff;
-		data[4*i+2] ^= (u8) (KS[i] >> 8) & 0xff;
-		data[4*i+3] ^= (u8) (KS[i] ) & 0xff;
+		u32 z = snow3g_next_word(&st);
+		data[i+0] ^= (u8) (z >> 24);
+		data[i+1] ^= (u8) (z >> 16);
+		data[i+2] ^= (u8) (z >> 8);
+		data[i+3] ^= (u8) (z );
+	}
+	if (i < nbytes)
+	{
+		u32 z = snow3g_next_word(&st);
+		for ( ; i<nbytes; i++, z <<= 8)
+			data[i] ^= (u8) (z >> 24);
 	}
-	
-	free(KS);
 	
 	/* zero last bits of data in case its length is not byte-aligned 
 	   this is an addition to the C reference code, which did not handle it */
@@ -413,68 +299,49 @@ void snow3g_f8(u8 *key, u32 count, u32 bearer, u32 dir, u8 *data, u32 length)
 		data[length/8] &= 256 - (1<<lastbits);
 }
 
-/* MUL64x.
- * Input V: a 64-bit input.
- * Input c: a 64-bit input.
- * Output : a 64-bit output.
- * A 64-bit memory is allocated which is to be freed by the calling 
- * function.
- * See section 4.3.2 for details.
+/* MUL64 with a table.
+ * MUL64(V,P,c) of section 4.3.4 is the product of V and P in GF(2^64)
+ * with the reduction polynomial given by c. With T[j] = j*P for the 16
+ * 4-bit values j, V is consumed a nibble at a time, most significant
+ * first (Horner's rule). R[h] reduces the 4 bits shifted out at the top.
  */
-u64 MUL64x(u64 V, u64 c)
-{
-	if ( V & 0x8000000000000000 )
-		return (V << 1) ^ c;
-	else
-		return V << 1;
-}
 
-/* MUL64xPOW.
- * Input V: a 64-bit input.
- * Input i: a positive integer.
- * Input c: a 64-bit input.
- * Output : a 64-bit output.
- * A 64-bit memory is allocated which is to be freed by the calling function.
- * See section 4.3.3 for details.
- */
-u64 MUL64xPOW(u64 V, u8 i, u64 c)
-{
-	if ( i == 0)
-		return V; 
-	else
-		return MUL64x( MUL64xPOW(V,i-1,c) , c);
-}
+typedef struct {
+	u64 T[16];
+	u64 R[16];
+} mul64_table_t;
 
-/* MUL64.
- * Input V: a 64-bit input.
- * Input P: a 64-bit input.
- * Input c: a 64-bit input.
- * Output : a 64-bit output.
- * A 64-bit memory is allocated which is to be freed by the calling 
- * function.
- * See section 4.3.4 for details.
- */
-u64 MUL64(u64 V, u64 P, u64 c)
+static void MUL64_init(mul64_table_t *t, u64 P, u64 c)
 {
-	u64 result = 0;
-	int i = 0;
-
-	for ( i=0; i<64; i++)
+	u64 xP = P;
+	int i, j;
+	t->T[0] = 0;
+	for (i = 1; i < 16; i <<= 1)
+	{
+		/* T[i] = x^log2(i) * P (MUL64x of section 4.3.2) */
+		for (j = 0; j < i; j++)
+			t->T[i + j] = t->T[j] ^ xP;
+		xP = ( xP & 0x8000000000000000ULL ) ? ( (xP << 1) ^ c ) : ( xP << 1 );
+	}
+	for (i = 0; i < 16; i++)
 	{
-		if( ( P>>i ) & 0x1 )
-			result ^= MUL64xPOW(V,i,c);
+		/* h * x^64 reduced, c has degree below 60 */
+		t->R[i] = 0;
+		for (j = 0; j < 4; j++)
+			if (i & (1 << j))
+				t->R[i] ^= c << j;
 	}
-	return result;
 }
 
-/* mask8bit.
- * Input n: an integer in 1-7.
- * Output : an 8 bit mask.
- * Prepares an 8 bit mask with required number of 1 bits on the MSB side.
- */
-u8 mask8bit(int n)
+static inline u64 MUL64(const mul64_table_t *t, u64 V)
 {
-	return 0xFF ^ ((1<<(8-n)) - 1);
+	u64 r = 0;
+	int i;
+	for (i = 60; i >= 0; i -= 4)
+	{
+		r = ( r << 4 ) ^ t->R[ r >> 60 ] ^ t->T[ (V >> i) & 0xf ];
+	}
+	return r;
 }
 
 /* f9.
@@ -484,22 +351,20 @@ u8 mask8bit(int n)
  * Input dir:1 bit, direction of transmission (in the LSB).
  * Input data: length number of bits, input bit stream.
  * Input length: 64 bit Length, i.e., the number of bits to be MAC'd.
- * Output  : 32 bit block used as MAC 
+ * Output mac: 32 bit block used as MAC 
  * Generates 32-bit MAC using UIA2 algorithm as defined in Section 4.
  */
-u8* snow3g_f9( u8* key, u32 count, u32 fresh, u32 dir, u8 *data, u64 length)
+void snow3g_f9( u8* key, u32 count, u32 fresh, u32 dir, u8 *data, u64 length, u8 *mac)
 {
+	snow3g_state_t st;
+	mul64_table_t tP, tQ;
 	u32 K[4],IV[4], z[5];
-	u32 i=0, D;
-	static u8 MAC_I[4] = {0,0,0,0}; /* static memory for the result */
+	u64 i=0, j=0, nblocks;
 	u64 EVAL;
-	u64 V;
+	u64 M;
 	u64 P;
 	u64 Q;
-	u64 c;
-	
-	u64 M_D_2;
-	int rem_bits = 0;
+	u64 c = 0x1b;
 	
 	/* Load the Integrity Key for SNOW3G initialization as in section 4.4. */
 	for (i=0; i<4; i++)
@@ -513,65 +378,45 @@ u8* snow3g_f9( u8* key, u32 count, u32 fresh, u32 dir, u8 *data, u64 length)
 	IV[1] = count ^ ( dir << 31 ) ;
 	IV[0] = fresh ^ (dir << 15);
 	
-	z[0] = z[1] = z[2] = z[3] = z[4] = 0;
-	
 	/* Run SNOW 3G to produce 5 keystream words z_1, z_2, z_3, z_4 and z_5. */
-  snow3g_initialize(K, IV);
-  snow3g_generate_keystream(5, z);
+	snow3g_initialize(&st, K, IV);
+	snow3g_generate_keystream(&st, 5, z);
 	
 	P = (u64)z[0] << 32 | (u64)z[1];
 	Q = (u64)z[2] << 32 | (u64)z[3];
+	MUL64_init(&tP, P, c);
+	MUL64_init(&tQ, Q, c);
 	
-	/* Calculation */
-	if ((length % 64) == 0)
-		D = (length>>6) + 1;
-	else
-		D = (length>>6) + 2;
+	/* for 0 <= i <= D-2: the message in 64-bit blocks, the last one padded
+	   with zeros. Bytes past length are not read */
+	nblocks = ( length + 63 ) / 64;
 	EVAL = 0;
-	c = 0x1b;
-	
-	/* for 0 <= i <= D-3 */
-	for (i=0; i<D-2; i++)
+	for (i=0; i<nblocks; i++)
 	{
-		V = EVAL ^ ( (u64)data[8*i  ]<<56 | (u64)data[8*i+1]<<48 | 
-				     (u64)data[8*i+2]<<40 | (u64)data[8*i+3]<<32 | 
-                     (u64)data[8*i+4]<<24 | (u64)data[8*i+5]<<16 | 
-				     (u64)data[8*i+6]<< 8 | (u64)data[8*i+7] )   ;
-		EVAL = MUL64(V,P,c);
+		u64 bits = length - 64*i;
+		M = 0;
+		if (bits >= 64)
+		{
+			for (j=0; j<8; j++)
+				M = (M << 8) | data[8*i+j];
+		}
+		else
+		{
+			for (j=0; 8*j<bits; j++)
+				M |= (u64)data[8*i+j] << (56 - 8*j);
+			M &= ~0ULL << (64 - bits);
+		}
+		EVAL = MUL64(&tP, EVAL ^ M);
 	}
 	
-	/* for D-2 */
-	rem_bits = length % 64;
-	if (rem_bits == 0)
-		rem_bits = 64;
-	
-	M_D_2 = 0;
-	i = 0;
-	while (rem_bits > 7)
-	{
-		M_D_2 |= (u64)data[8*(D-2)+i] << (8*(7-i));
-		rem_bits -= 8;
-		i++;
-	}
-	if (rem_bits > 0)
-		M_D_2 |= (u64)(data[8*(D-2)+i] & mask8bit(rem_bits)) << (8*(7-i));
-	
-	V = EVAL ^ M_D_2;
-	EVAL = MUL64(V,P,c);
-	
 	/* for D-1 */
 	EVAL ^= length;
 	
 	/* Multiply by Q */
-	EVAL = MUL64(EVAL,Q,c);
+	EVAL = MUL64(&tQ, EVAL);
 	
 	/* XOR with z_5: this is a modification to the reference C code, 
 	   which forgot to XOR z[5] */
 	for (i=0; i<4; i++)
-		/*
-		MAC_I[i] = (mac32 >> (8*(3-i))) & 0xff;
-		*/
-		MAC_I[i] = ((EVAL >> (56-(i*8))) ^ (z[4] >> (24-(i*8)))) & 0xff;
-	
-	return MAC_I;
+		mac[i] = ((EVAL >> (56-(i*8))) ^ (z[4] >> (24-(i*8)))) & 0xff;
 }
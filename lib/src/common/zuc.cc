@@ -0,0 +1,273 @@
+/*------------------------------------------------------------------------
+* zuc.cc
+*
+* Adapted from ETSI/SAGE specifications:
+* "Specification of the 3GPP Confidentiality and
+* Integrity Algorithms 128-EEA3 & 128-EIA3.
+* Document 1: 128-EEA3 and 128-EIA3 Specification"
+* "Specification of the 3GPP Confidentiality and
+* Integrity Algorithms 128-EEA3 & 128-EIA3.
+* Document 2: ZUC Specification"
+*------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "srslte/common/zuc.h"
+
+/* S-box S0 */
+
+static const uint8_t S0[256] = {
+0x3e,0x72,0x5b,0x47,0xca,0xe0,0x00,0x33,0x04,0xd1,0x54,0x98,0x09,0xb9,0x6d,0xcb,
+0x7b,0x1b,0xf9,0x32,0xaf,0x9d,0x6a,0xa5,0xb8,0x2d,0xfc,0x1d,0x08,0x53,0x03,0x90,
+0x4d,0x4e,0x84,0x99,0xe4,0xce,0xd9,0x91,0xdd,0xb6,0x85,0x48,0x8b,0x29,0x6e,0xac,
+0xcd,0xc1,0xf8,0x1e,0x73,0x43,0x69,0xc6,0xb5,0xbd,0xfd,0x39,0x63,0x20,0xd4,0x38,
+0x76,0x7d,0xb2,0xa7,0xcf,0xed,0x57,0xc5,0xf3,0x2c,0xbb,0x14,0x21,0x06,0x55,0x9b,
+0xe3,0xef,0x5e,0x31,0x4f,0x7f,0x5a,0xa4,0x0d,0x82,0x51,0x49,0x5f,0xba,0x58,0x1c,
+0x4a,0x16,0xd5,0x17,0xa8,0x92,0x24,0x1f,0x8c,0xff,0xd8,0xae,0x2e,0x01,0xd3,0xad,
+0x3b,0x4b,0xda,0x46,0xeb,0xc9,0xde,0x9a,0x8f,0x87,0xd7,0x3a,0x80,0x6f,0x2f,0xc8,
+0xb1,0xb4,0x37,0xf7,0x0a,0x22,0x13,0x28,0x7c,0xcc,0x3c,0x89,0xc7,0xc3,0x96,0x56,
+0x07,0xbf,0x7e,0xf0,0x0b,0x2b,0x97,0x52,0x35,0x41,0x79,0x61,0xa6,0x4c,0x10,0xfe,
+0xbc,0x26,0x95,0x88,0x8a,0xb0,0xa3,0xfb,0xc0,0x18,0x94,0xf2,0xe1,0xe5,0xe9,0x5d,
+0xd0,0xdc,0x11,0x66,0x64,0x5c,0xec,0x59,0x42,0x75,0x12,0xf5,0x74,0x9c,0xaa,0x23,
+0x0e,0x86,0xab,0xbe,0x2a,0x02,0xe7,0x67,0xe6,0x44,0xa2,0x6c,0xc2,0x93,0x9f,0xf1,
+0xf6,0xfa,0x36,0xd2,0x50,0x68,0x9e,0x62,0x71,0x15,0x3d,0xd6,0x40,0xc4,0xe2,0x0f,
+0x8e,0x83,0x77,0x6b,0x25,0x05,0x3f,0x0c,0x30,0xea,0x70,0xb7,0xa1,0xe8,0xa9,0x65,
+0x8d,0x27,0x1a,0xdb,0x81,0xb3,0xa0,0xf4,0x45,0x7a,0x19,0xdf,0xee,0x78,0x34,0x60
+};
+
+/* S-box S1 */
+
+static const uint8_t S1[256] = {
+0x55,0xc2,0x63,0x71,0x3b,0xc8,0x47,0x86,0x9f,0x3c,0xda,0x5b,0x29,0xaa,0xfd,0x77,
+0x8c,0xc5,0x94,0x0c,0xa6,0x1a,0x13,0x00,0xe3,0xa8,0x16,0x72,0x40,0xf9,0xf8,0x42,
+0x44,0x26,0x68,0x96,0x81,0xd9,0x45,0x3e,0x10,0x76,0xc6,0xa7,0x8b,0x39,0x43,0xe1,
+0x3a,0xb5,0x56,0x2a,0xc0,0x6d,0xb3,0x05,0x22,0x66,0xbf,0xdc,0x0b,0xfa,0x62,0x48,
+0xdd,0x20,0x11,0x06,0x36,0xc9,0xc1,0xcf,0xf6,0x27,0x52,0xbb,0x69,0xf5,0xd4,0x87,
+0x7f,0x84,0x4c,0xd2,0x9c,0x57,0xa4,0xbc,0x4f,0x9a,0xdf,0xfe,0xd6,0x8d,0x7a,0xeb,
+0x2b,0x53,0xd8,0x5c,0xa1,0x14,0x17,0xfb,0x23,0xd5,0x7d,0x30,0x67,0x73,0x08,0x09,
+0xee,0xb7,0x70,0x3f,0x61,0xb2,0x19,0x8e,0x4e,0xe5,0x4b,0x93,0x8f,0x5d,0xdb,0xa9,
+0xad,0xf1,0xae,0x2e,0xcb,0x0d,0xfc,0xf4,0x2d,0x46,0x6e,0x1d,0x97,0xe8,0xd1,0xe9,
+0x4d,0x37,0xa5,0x75,0x5e,0x83,0x9e,0xab,0x82,0x9d,0xb9,0x1c,0xe0,0xcd,0x49,0x89,
+0x01,0xb6,0xbd,0x58,0x24,0xa2,0x5f,0x38,0x78,0x99,0x15,0x90,0x50,0xb8,0x95,0xe4,
+0xd0,0x91,0xc7,0xce,0xed,0x0f,0xb4,0x6f,0xa0,0xcc,0xf0,0x02,0x4a,0x79,0xc3,0xde,
+0xa3,0xef,0xea,0x51,0xe6,0x6b,0x18,0xec,0x1b,0x2c,0x80,0xf7,0x74,0xe7,0xff,0x21,
+0x5a,0x6a,0x54,0x1e,0x41,0x31,0x92,0x35,0xc4,0x33,0x07,0x0a,0xba,0x7e,0x0e,0x34,
+0x88,0xb1,0x98,0x7c,0xf3,0x3d,0x60,0x6c,0x7b,0xca,0xd3,0x1f,0x32,0x65,0x04,0x28,
+0x64,0xbe,0x85,0x9b,0x2f,0x59,0x8a,0xd7,0xb0,0x25,0xac,0xaf,0x12,0x03,0xe2,0xf2
+};
+
+/* The constants D of section 3.6.1 */
+
+static const uint32_t EK_d[16] = {
+0x44D7,0x26BC,0x626B,0x135E,0x5789,0x35E2,0x7135,0x09AF,
+0x4D78,0x2F13,0x6BC4,0x1AF1,0x5E26,0x3C4D,0x789A,0x47AC
+};
+
+/* Addition modulo 2^31-1 */
+
+static inline uint32_t AddM(uint32_t a, uint32_t b)
+{
+	uint32_t c = a + b;
+	return (c & 0x7FFFFFFF) + (c >> 31);
+}
+
+/* Multiplication by 2^k modulo 2^31-1 is a 31-bit rotation */
+
+static inline uint32_t MulByPow2(uint32_t x, int k)
+{
+	return ((x << k) | (x >> (31 - k))) & 0x7FFFFFFF;
+}
+
+static inline uint32_t ROT(uint32_t a, int k)
+{
+	return (a << k) | (a >> (32 - k));
+}
+
+/* The linear transforms L1 and L2, section 3.4.2 */
+
+static inline uint32_t L1(uint32_t X)
+{
+	return X ^ ROT(X, 2) ^ ROT(X, 10) ^ ROT(X, 18) ^ ROT(X, 24);
+}
+
+static inline uint32_t L2(uint32_t X)
+{
+	return X ^ ROT(X, 8) ^ ROT(X, 14) ^ ROT(X, 22) ^ ROT(X, 30);
+}
+
+/* The 32x32 S-box S = (S0, S1, S0, S1), section 3.4.2 */
+
+static inline uint32_t S(uint32_t w)
+{
+	return ((uint32_t)S0[w >> 24] << 24) |
+		((uint32_t)S1[(w >> 16) & 0xFF] << 16) |
+		((uint32_t)S0[(w >> 8) & 0xFF] << 8) |
+		((uint32_t)S1[w & 0xFF]);
+}
+
+/* The LFSR in initialisation (u = W >> 1) or work mode (u = 0),
+* section 3.2. A 0 result is replaced by 2^31-1.
+*/
+
+static inline void LFSRClock(zuc_state_t *st, uint32_t u)
+{
+	uint32_t *s = st->LFSR_S;
+	uint32_t f = s[0];
+	f = AddM(f, MulByPow2(s[0], 8));
+	f = AddM(f, MulByPow2(s[4], 20));
+	f = AddM(f, MulByPow2(s[10], 21));
+	f = AddM(f, MulByPow2(s[13], 17));
+	f = AddM(f, MulByPow2(s[15], 15));
+	f = AddM(f, u);
+	if (f == 0)
+		f = 0x7FFFFFFF;
+	memmove(&s[0], &s[1], 15 * sizeof(uint32_t));
+	s[15] = f;
+}
+
+/* Bit reorganization (section 3.3) followed by the nonlinear function F
+* (section 3.4). Returns W, and X3 through x3.
+*/
+
+static inline uint32_t BRF(zuc_state_t *st, uint32_t *x3)
+{
+	uint32_t *s = st->LFSR_S;
+	uint32_t X0 = ((s[15] & 0x7FFF8000) << 1) | (s[14] & 0xFFFF);
+	uint32_t X1 = ((s[11] & 0xFFFF) << 16) | (s[9] >> 15);
+	uint32_t X2 = ((s[7] & 0xFFFF) << 16) | (s[5] >> 15);
+	uint32_t W, W1, W2;
+
+	*x3 = ((s[2] & 0xFFFF) << 16) | (s[0] >> 15);
+
+	W  = (X0 ^ st->F_R1) + st->F_R2;
+	W1 = st->F_R1 + X1;
+	W2 = st->F_R2 ^ X2;
+	st->F_R1 = S(L1((W1 << 16) | (W2 >> 16)));
+	st->F_R2 = S(L2((W2 << 16) | (W1 >> 16)));
+	return W;
+}
+
+void zuc_initialize(zuc_state_t *st, const uint8_t k[16], const uint8_t iv[16])
+{
+	uint32_t x3;
+	int i;
+	for (i = 0; i < 16; i++)
+		st->LFSR_S[i] = ((uint32_t)k[i] << 23) | (EK_d[i] << 8) | iv[i];
+	st->F_R1 = 0;
+	st->F_R2 = 0;
+	for (i = 0; i < 32; i++)
+		LFSRClock(st, BRF(st, &x3) >> 1);
+	/* First step of the working stage, the output of F is discarded */
+	BRF(st, &x3);
+	LFSRClock(st, 0);
+}
+
+static inline uint32_t zuc_next_word(zuc_state_t *st)
+{
+	uint32_t x3;
+	uint32_t z = BRF(st, &x3);
+	LFSRClock(st, 0);
+	return z ^ x3;
+}
+
+void zuc_generate_keystream(zuc_state_t *st, uint32_t n, uint32_t *z)
+{
+	uint32_t t;
+	for (t = 0; t < n; t++)
+		z[t] = zuc_next_word(st);
+}
+
+void zuc_eea3(uint8_t *key, uint32_t count, uint32_t bearer, uint32_t dir,
+              uint8_t *data, uint32_t length)
+{
+	zuc_state_t st;
+	uint8_t iv[16];
+	uint32_t nbytes = (length + 7) / 8;
+	uint32_t i;
+	int lastbits = (8 - (length % 8)) % 8;
+
+	iv[0] = (count >> 24) & 0xFF;
+	iv[1] = (count >> 16) & 0xFF;
+	iv[2] = (count >> 8) & 0xFF;
+	iv[3] = count & 0xFF;
+	iv[4] = ((bearer & 0x1F) << 3) | ((dir & 0x1) << 2);
+	iv[5] = iv[6] = iv[7] = 0;
+	memcpy(&iv[8], &iv[0], 8);
+
+	zuc_initialize(&st, key, iv);
+
+	/* XOR the keystream in as it is generated */
+	for (i = 0; i + 4 <= nbytes; i += 4)
+	{
+		uint32_t z = zuc_next_word(&st);
+		data[i+0] ^= (uint8_t) (z >> 24);
+		data[i+1] ^= (uint8_t) (z >> 16);
+		data[i+2] ^= (uint8_t) (z >> 8);
+		data[i+3] ^= (uint8_t) (z );
+	}
+	if (i < nbytes)
+	{
+		uint32_t z = zuc_next_word(&st);
+		for ( ; i < nbytes; i++, z <<= 8)
+			data[i] ^= (uint8_t) (z >> 24);
+	}
+
+	if (lastbits)
+		data[length/8] &= 256 - (1 << lastbits);
+}
+
+/* The MAC is the XOR of the keystream words z_i starting at every set bit
+* i of the message, section 4.4. The keystream is kept in a 64-bit window
+* holding words j and j+1 while bits 32j..32j+31 are processed.
+*/
+
+void zuc_eia3(uint8_t *key, uint32_t count, uint32_t bearer, uint32_t dir,
+              uint8_t *data, uint32_t length, uint8_t *mac)
+{
+	zuc_state_t st;
+	uint8_t iv[16];
+	uint64_t win;
+	uint32_t T = 0;
+	uint32_t nwords = length / 32;
+	uint32_t i, b;
+
+	iv[0] = (count >> 24) & 0xFF;
+	iv[1] = (count >> 16) & 0xFF;
+	iv[2] = (count >> 8) & 0xFF;
+	iv[3] = count & 0xFF;
+	iv[4] = (bearer & 0x1F) << 3;
+	iv[5] = iv[6] = iv[7] = 0;
+	memcpy(&iv[8], &iv[0], 8);
+	iv[8]  ^= (dir & 0x1) << 7;
+	iv[14] ^= (dir & 0x1) << 7;
+
+	zuc_initialize(&st, key, iv);
+	win  = (uint64_t)zuc_next_word(&st) << 32;
+	win |= zuc_next_word(&st);
+
+	for (i = 0; i <= nwords; i++)
+	{
+		uint32_t nbits = (i < nwords) ? 32 : length % 32;
+		uint32_t m = 0;
+		for (b = 0; b < (nbits + 7) / 8; b++)
+			m |= (uint32_t)data[4*i+b] << (24 - 8*b);
+		for (b = 0; b < nbits; b++, m <<= 1)
+		{
+			if (m & 0x80000000)
+				T ^= (uint32_t)(win >> (32 - b));
+		}
+		if (i < nwords)
+			win = (win << 32) | zuc_next_word(&st);
+	}
+
+	/* z_LENGTH, then z_{32(L-1)} with L = ceil(LENGTH/32) + 2 */
+	T ^= (uint32_t)(win >> (32 - length % 32));
+	if (length % 32)
+		T ^= zuc_next_word(&st);
+	else
+		T ^= (uint32_t)win;
+
+	mac[0] = (T >> 24) & 0xFF;
+	mac[1] = (T >> 16) & 0xFF;
+	mac[2] = (T >> 8) & 0xFF;
+	mac[3] = T & 0xFF;
+}
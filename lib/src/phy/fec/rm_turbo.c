@@ -354,6 +354,64 @@ int srslte_rm_turbo_rx_lut(int16_t *input, int16_t *output, uint32_t in_len, uin
 #endif
 }
 
+static inline int8_t rm_turbo_adds_8bit(int8_t a, int8_t b)
+{
+  int16_t r = (int16_t) a + b;
+  return (int8_t) (r > INT8_MAX ? INT8_MAX : (r < INT8_MIN ? INT8_MIN : r));
+}
+
+/* Same as srslte_rm_turbo_rx_lut() for 8-bit LLRs. Combining saturates so that
+ * retransmissions can not wrap a strong LLR around to the opposite sign. Each pass
+ * of out_len input LLRs lands once on every output LLR, so a pass is scattered into
+ * a buffer of its own and then added to the output with saturating SIMD adds */
+int srslte_rm_turbo_rx_lut_8bit(int8_t *input, int8_t *output, uint32_t in_len, uint32_t cb_idx, uint32_t rv_idx) 
+{
+  if (rv_idx < 4 && cb_idx < SRSLTE_NOF_TC_CB_SIZES) {
+    uint32_t out_len = 3*srslte_cbsegm_cbsize(cb_idx)+12;
+    uint16_t *deinter = deinterleaver[cb_idx][rv_idx];
+#ifdef LV_HAVE_SSE
+    int8_t pass[18448] __attribute__ ((aligned (32)));
+
+    for (uint32_t i=0;i<in_len;i+=out_len) {
+      uint32_t n = SRSLTE_MIN(out_len, in_len - i);
+      uint32_t k = 0;
+      if (n < out_len) {
+        // The last pass leaves some output LLRs as they are
+        bzero(pass, out_len);
+      }
+      for (uint32_t j=0;j<n;j++) {
+        pass[deinter[j]] = input[i+j];
+      }
+#ifdef LV_HAVE_AVX2
+      for (;k+32<=out_len;k+=32) {
+        __m256i o = _mm256_loadu_si256((__m256i*) &output[k]);
+        _mm256_storeu_si256((__m256i*) &output[k], _mm256_adds_epi8(o, _mm256_load_si256((__m256i*) &pass[k])));
+      }
+#endif
+      for (;k+16<=out_len;k+=16) {
+        __m128i o = _mm_loadu_si128((__m128i*) &output[k]);
+        _mm_storeu_si128((__m128i*) &output[k], _mm_adds_epi8(o, _mm_load_si128((__m128i*) &pass[k])));
+      }
+      for (;k<out_len;k++) {
+        output[k] = rm_turbo_adds_8bit(output[k], pass[k]);
+      }
+    }
+#else
+    uint32_t j = 0;
+    for (int i=0;i<in_len;i++) {
+      output[deinter[j]] = rm_turbo_adds_8bit(output[deinter[j]], input[i]);
+      if (++j == out_len) {
+        j = 0;
+      }
+    }
+#endif
+    return 0;
+  } else {
+    printf("Invalid inputs rv_idx=%d, cb_idx=%d\n", rv_idx, cb_idx);
+    return SRSLTE_ERROR_INVALID_INPUTS; 
+  }
+}
+
 #ifdef LV_HAVE_SSE
 
 int srslte_rm_turbo_rx_lut_sse(int16_t *input, int16_t *output, uint32_t in_len, uint32_t cb_idx, uint32_t rv_idx) 
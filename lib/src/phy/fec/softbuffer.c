@@ -43,15 +43,25 @@
 
 #define MAX_PDSCH_RE(cp) (2 * SRSLTE_CP_NSYMB(cp) * 12)
 
-int srslte_softbuffer_rx_init(srslte_softbuffer_rx_t *q, uint32_t nof_prb) {
+/* Returns the maximum number of code blocks of a transport block in nof_prb */
+static int softbuffer_max_cb(uint32_t nof_prb) {
+  int tbs = srslte_ra_tbs_from_idx(26, nof_prb);
+  if (tbs == SRSLTE_ERROR) {
+    return SRSLTE_ERROR;
+  }
+  return tbs / (SRSLTE_TCOD_MAX_LEN_CB - 24) + 1;
+}
+
+static int softbuffer_rx_init(srslte_softbuffer_rx_t *q, uint32_t nof_prb, srslte_softbuffer_pool_t *pool) {
   int ret = SRSLTE_ERROR_INVALID_INPUTS;
   
   if (q != NULL) {    
     bzero(q, sizeof(srslte_softbuffer_rx_t));
     
-    ret = srslte_ra_tbs_from_idx(26, nof_prb);
+    ret = softbuffer_max_cb(nof_prb);
     if (ret != SRSLTE_ERROR) {
-      q->max_cb =  (uint32_t) ret / (SRSLTE_TCOD_MAX_LEN_CB - 24) + 1; 
+      q->max_cb = (uint32_t) ret; 
+      q->pool   = pool;
       ret = SRSLTE_ERROR;
       
       q->buffer_f = srslte_vec_malloc(sizeof(int16_t*) * q->max_cb);
@@ -59,12 +69,14 @@ int srslte_softbuffer_rx_init(srslte_softbuffer_rx_t *q, uint32_t nof_prb) {
         perror("malloc");
         goto clean_exit;
       }
+      bzero(q->buffer_f, sizeof(int16_t*) * q->max_cb);
       
       q->data = srslte_vec_malloc(sizeof(uint8_t*) * q->max_cb);
       if (!q->data) {
         perror("malloc");
         goto clean_exit;
       }
+      bzero(q->data, sizeof(uint8_t*) * q->max_cb);
 
       q->cb_crc = srslte_vec_malloc(sizeof(bool) * q->max_cb);
       if (!q->cb_crc) {
@@ -75,10 +87,12 @@ int srslte_softbuffer_rx_init(srslte_softbuffer_rx_t *q, uint32_t nof_prb) {
 
       // FIXME: Use HARQ buffer limitation based on UE category
       for (uint32_t i=0;i<q->max_cb;i++) {
-        q->buffer_f[i] = srslte_vec_malloc(sizeof(int16_t) * SOFTBUFFER_SIZE);
-        if (!q->buffer_f[i]) {
-          perror("malloc");
-          goto clean_exit;
+        if (!pool) {
+          q->buffer_f[i] = srslte_vec_malloc(sizeof(int16_t) * SOFTBUFFER_SIZE);
+          if (!q->buffer_f[i]) {
+            perror("malloc");
+            goto clean_exit;
+          }
         }
 
         q->data[i] = srslte_vec_malloc(sizeof(uint8_t) * 6144/8);
@@ -100,11 +114,26 @@ int srslte_softbuffer_rx_init(srslte_softbuffer_rx_t *q, uint32_t nof_prb) {
   return ret;
 }
 
+int srslte_softbuffer_rx_init(srslte_softbuffer_rx_t *q, uint32_t nof_prb) {
+  return softbuffer_rx_init(q, nof_prb, NULL);
+}
+
+/* Same as srslte_softbuffer_rx_init() with the code block soft buffers taken from the pool only when 
+ * they are used. The pool must outlive the soft buffer */
+int srslte_softbuffer_rx_init_pool(srslte_softbuffer_rx_t *q, uint32_t nof_prb, srslte_softbuffer_pool_t *pool) {
+  if (pool == NULL) {
+    return SRSLTE_ERROR_INVALID_INPUTS;
+  }
+  return softbuffer_rx_init(q, nof_prb, pool);
+}
+
 void srslte_softbuffer_rx_free(srslte_softbuffer_rx_t *q) {
   if (q) {
     if (q->buffer_f) {
       for (uint32_t i=0;i<q->max_cb;i++) {
-        if (q->buffer_f[i]) {
+        if (q->pool) {
+          srslte_softbuffer_rx_release_cb(q, i);
+        } else if (q->buffer_f[i]) {
           free(q->buffer_f[i]);
         }
       }
@@ -125,6 +154,60 @@ void srslte_softbuffer_rx_free(srslte_softbuffer_rx_t *q) {
   }
 }
 
+static void *softbuffer_pool_get(srslte_softbuffer_pool_t *pool) {
+  void *cb = NULL;
+  pthread_mutex_lock(&pool->mutex);
+  if (pool->nof_free > 0) {
+    cb = pool->free_cb[--pool->nof_free];
+  } else if (pool->nof_alloc < pool->max_cb) {
+    cb = srslte_vec_malloc(pool->cb_size);
+    if (cb) {
+      pool->nof_alloc++;
+    } else {
+      perror("malloc");
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return cb;
+}
+
+static void softbuffer_pool_put(srslte_softbuffer_pool_t *pool, void *cb) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->free_cb[pool->nof_free++] = cb;
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+/* Returns the soft buffer of a code block, taking it from the pool the first time it is used after a 
+ * reset. Only its first nof_llr LLRs, the 3*K+12 the rate matching and the decoder go through for a 
+ * code block of K bits, are zeroed. Returns NULL if the pool is exhausted */
+int16_t* srslte_softbuffer_rx_get_cb(srslte_softbuffer_rx_t *q, uint32_t cb_idx, uint32_t nof_llr) {
+  if (cb_idx >= q->max_cb || nof_llr > SOFTBUFFER_SIZE) {
+    return NULL;
+  }
+  if (q->pool && !q->buffer_f[cb_idx]) {
+    q->buffer_f[cb_idx] = softbuffer_pool_get(q->pool);
+    if (!q->buffer_f[cb_idx]) {
+      fprintf(stderr, "Soft buffer pool exhausted (%d code blocks)\n", q->pool->max_cb);
+      return NULL;
+    }
+    bzero(q->buffer_f[cb_idx], q->pool->int8?sizeof(int8_t) * nof_llr:sizeof(int16_t) * nof_llr);
+  }
+  return q->buffer_f[cb_idx];
+}
+
+/* Gives the soft buffer of a code block back to the pool. Does nothing without a pool */
+void srslte_softbuffer_rx_release_cb(srslte_softbuffer_rx_t *q, uint32_t cb_idx) {
+  if (q->pool && cb_idx < q->max_cb && q->buffer_f[cb_idx]) {
+    softbuffer_pool_put(q->pool, q->buffer_f[cb_idx]);
+    q->buffer_f[cb_idx] = NULL;
+  }
+}
+
+/* Returns true if the code block soft buffers hold 8-bit LLRs */
+bool srslte_softbuffer_rx_is_8bit(srslte_softbuffer_rx_t *q) {
+  return q->pool && q->pool->int8;
+}
+
 void srslte_softbuffer_rx_reset_tbs(srslte_softbuffer_rx_t *q, uint32_t tbs) {
   uint32_t nof_cb = (tbs + 24)/(SRSLTE_TCOD_MAX_LEN_CB - 24) + 1; 
   srslte_softbuffer_rx_reset_cb(q, nof_cb);
@@ -134,13 +217,17 @@ void srslte_softbuffer_rx_reset(srslte_softbuffer_rx_t *q) {
   srslte_softbuffer_rx_reset_cb(q, q->max_cb);
 }
 
+/* Without a pool, zeroes the soft buffers of the first nof_cb code blocks. With a pool all of them go 
+ * back to it */
 void srslte_softbuffer_rx_reset_cb(srslte_softbuffer_rx_t *q, uint32_t nof_cb) {
   if (q->buffer_f) {
-    if (nof_cb > q->max_cb) {
+    if (nof_cb > q->max_cb || q->pool) {
       nof_cb = q->max_cb; 
     }
     for (uint32_t i=0;i<nof_cb;i++) {
-      if (q->buffer_f[i]) {
+      if (q->pool) {
+        srslte_softbuffer_rx_release_cb(q, i);
+      } else if (q->buffer_f[i]) {
         bzero(q->buffer_f[i], SOFTBUFFER_SIZE*sizeof(int16_t));
       }
     }
@@ -150,6 +237,58 @@ void srslte_softbuffer_rx_reset_cb(srslte_softbuffer_rx_t *q, uint32_t nof_cb) {
   }
 }
 
+/* Initializes a pool with room for the code blocks of nof_softbuffers soft buffers of nof_prb. The 
+ * memory is only allocated as code blocks are used, so sizing it for all the HARQ processes costs 
+ * nothing until they are all retransmitting. A smaller pool bounds the memory instead, code blocks 
+ * that find it exhausted fail to decode */
+int srslte_softbuffer_pool_init(srslte_softbuffer_pool_t *pool, uint32_t nof_prb, uint32_t nof_softbuffers, bool int8) {
+  int ret = SRSLTE_ERROR_INVALID_INPUTS;
+
+  if (pool != NULL && nof_softbuffers > 0) {
+    bzero(pool, sizeof(srslte_softbuffer_pool_t));
+
+    ret = softbuffer_max_cb(nof_prb);
+    if (ret != SRSLTE_ERROR) {
+      pool->max_cb  = (uint32_t) ret * nof_softbuffers;
+      pool->int8    = int8;
+      pool->cb_size = int8?sizeof(int8_t) * SOFTBUFFER_SIZE:sizeof(int16_t) * SOFTBUFFER_SIZE;
+      ret = SRSLTE_ERROR;
+
+      pool->free_cb = srslte_vec_malloc(sizeof(void*) * pool->max_cb);
+      if (!pool->free_cb) {
+        perror("malloc");
+        return ret;
+      }
+      pthread_mutex_init(&pool->mutex, NULL);
+      ret = SRSLTE_SUCCESS;
+    }
+  }
+  return ret;
+}
+
+/* The soft buffers initialized with the pool must be freed first */
+void srslte_softbuffer_pool_free(srslte_softbuffer_pool_t *pool) {
+  if (pool && pool->free_cb) {
+    if (pool->nof_free < pool->nof_alloc) {
+      fprintf(stderr, "Freeing soft buffer pool with %d code blocks in use\n", pool->nof_alloc - pool->nof_free);
+    }
+    for (uint32_t i=0;i<pool->nof_free;i++) {
+      free(pool->free_cb[i]);
+    }
+    free(pool->free_cb);
+    pthread_mutex_destroy(&pool->mutex);
+    bzero(pool, sizeof(srslte_softbuffer_pool_t));
+  }
+}
+
+/* Returns the number of code block soft buffers held by soft buffers */
+uint32_t srslte_softbuffer_pool_nof_used(srslte_softbuffer_pool_t *pool) {
+  pthread_mutex_lock(&pool->mutex);
+  uint32_t n = pool->nof_alloc - pool->nof_free;
+  pthread_mutex_unlock(&pool->mutex);
+  return n;
+}
+
 
 
 int srslte_softbuffer_tx_init(srslte_softbuffer_tx_t *q, uint32_t nof_prb) {
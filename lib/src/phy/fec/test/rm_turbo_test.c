@@ -50,6 +50,8 @@ uint8_t buff_b[BUFFSZ];
 float buff_f[BUFFSZ];
 float bits_f[3*6144+12];
 short bits2_s[3*6144+12];
+int8_t bits_b[3*6144+12], bits2_b[3*6144+12];
+uint32_t pos[3*6144+12];
 
 void usage(char *prog) {
   printf("Usage: %s -c cb_idx -e nof_e_bits [-i rv_idx]\n", prog);
@@ -85,6 +87,7 @@ int main(int argc, char **argv) {
   uint8_t *rm_bits, *rm_bits2, *rm_bits2_bytes;
   short *rm_bits_s; 
   float *rm_bits_f; 
+  int8_t *rm_bits_b;
   
   parse_args(argc, argv);
   
@@ -100,6 +103,11 @@ int main(int argc, char **argv) {
     perror("malloc");
     exit(-1);
   }
+  rm_bits_b = srslte_vec_malloc(sizeof(int8_t) * nof_e_bits);
+  if (!rm_bits_b) {
+    perror("malloc");
+    exit(-1);
+  }
   rm_bits = srslte_vec_malloc(sizeof(uint8_t) * nof_e_bits);
   if (!rm_bits) {
     perror("malloc");
@@ -177,6 +185,7 @@ int main(int argc, char **argv) {
       for (int i=0;i<nof_e_bits;i++) {
         rm_bits_f[i] = rand()%10-5;
         rm_bits_s[i] = (short) rm_bits_f[i];
+        rm_bits_b[i] = (int8_t) (rand()%256-128);
       }
 
       bzero(buff_f, BUFFSZ*sizeof(float));
@@ -192,7 +201,37 @@ int main(int argc, char **argv) {
         }
       }
     
-      printf("OK RX\n");
+      printf("OK RX...");
+
+      /* 8-bit combining into LLRs already in the buffer saturates at each addition. The 
+       * 16-bit rate matching of the input positions gives where each 8-bit LLR lands */
+      uint32_t n = SRSLTE_MIN(nof_e_bits, long_cb_enc);
+      for (int i=0;i<n;i++) {
+        rm_bits_s[i] = (short) (i+1);
+      }
+      bzero(bits2_s, long_cb_enc*sizeof(short));
+      srslte_rm_turbo_rx_lut(rm_bits_s, bits2_s, n, cb_idx, rv_idx);
+      for (int i=0;i<long_cb_enc;i++) {
+        if (bits2_s[i]) {
+          pos[bits2_s[i]-1] = i;
+        }
+        bits_b[i]  = (int8_t) (rand()%256-128);
+        bits2_b[i] = bits_b[i];
+      }
+      for (int i=0;i<nof_e_bits;i++) {
+        int16_t r = (int16_t) bits_b[pos[i%long_cb_enc]] + rm_bits_b[i];
+        bits_b[pos[i%long_cb_enc]] = (int8_t) (r > INT8_MAX ? INT8_MAX : (r < INT8_MIN ? INT8_MIN : r));
+      }
+      srslte_rm_turbo_rx_lut_8bit(rm_bits_b, bits2_b, nof_e_bits, cb_idx, rv_idx);
+
+      for (int i=0;i<long_cb_enc;i++) {
+        if (bits_b[i] != bits2_b[i]) {
+          printf("error RX 8-bit in bit %d %d!=%d\n", i, bits_b[i], bits2_b[i]);
+          exit(-1);
+        }
+      }
+
+      printf("OK RX 8-bit\n");
 
     }
   }
@@ -200,6 +239,7 @@ int main(int argc, char **argv) {
   srslte_rm_turbo_free_tables();
   free(rm_bits_s);
   free(rm_bits_f);
+  free(rm_bits_b);
   free(rm_bits);
   free(rm_bits2);
   free(rm_bits2_bytes);
@@ -51,6 +51,8 @@ int nof_iterations = MAX_ITERATIONS;
 int test_known_data = 0;
 int test_errors = 0;
 int nof_repetitions = 1; 
+int benchmark = 0; 
+int early_stop = 0; 
 
 #define SNR_POINTS      4
 #define SNR_MIN         1.0
@@ -68,11 +70,13 @@ void usage(char *prog) {
   printf("\t-e ebno in dB [Default scan]\n");
   printf("\t-t test: check errors on exit [Default disabled]\n");
   printf("\t-s seed [Default 0=time]\n");
+  printf("\t-b benchmark every decoder implementation [Default disabled]\n");
+  printf("\t-E stop iterating once the hard decisions are stable [Default disabled]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "cinNlstvekt")) != -1) {
+  while ((opt = getopt(argc, argv, "cinNlstvektbE")) != -1) {
     switch (opt) {
     case 'c':
       nof_cb = atoi(argv[optind]);
@@ -104,6 +108,12 @@ void parse_args(int argc, char **argv) {
     case 'v':
       srslte_verbose++;
       break;
+    case 'b':
+      benchmark = 1;
+      break;
+    case 'E':
+      early_stop = 1;
+      break;
     default:
       usage(argv[0]);
       exit(-1);
@@ -111,6 +121,145 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+/* Decodes the same sequence of nof_frames*SRSLTE_TDEC_MAX_NPAR codeblocks with every available 
+ * implementation, filling all its lanes on each pass, and reports the single-core throughput, 
+ * the average number of iterations and the memory the MAP recursions run through per codeblock. 
+ * The full-length SIMD implementations use the same fixed-point arithmetic, so they must return 
+ * the same bits. The sliding-window decoder approximates beta at the window edges and the 8-bit decoder 
+ * saturates, they are only reported. The 8-bit decoder is given 8-bit LLRs at the scale of the soft 
+ * demodulator, so its throughput does not include any conversion. With early stopping every 
+ * implementation must average fewer iterations than the maximum. 
+ */
+int run_benchmark(srslte_tcod_t *tcod, float var, uint32_t coded_length) {
+  int ret = -1; 
+  srslte_tdec_t tdec;
+  struct timeval tdata[3];
+  uint8_t *data_tx[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *data_rx_bytes[SRSLTE_TDEC_MAX_NPAR];
+  int16_t *llr_s[SRSLTE_TDEC_MAX_NPAR];
+  int8_t  *llr_b[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *data_rx  = srslte_vec_malloc(frame_length * sizeof(uint8_t));
+  uint8_t *symbols  = srslte_vec_malloc(coded_length * sizeof(uint8_t));
+  float   *llr      = srslte_vec_malloc(coded_length * sizeof(float));
+  uint32_t nof_cb   = nof_frames * SRSLTE_TDEC_MAX_NPAR;
+  int simd_errors   = -1; 
+  uint32_t max_iterations = nof_iterations<0?MAX_ITERATIONS:nof_iterations;
+
+  bzero(data_tx, sizeof(data_tx));
+  bzero(data_rx_bytes, sizeof(data_rx_bytes));
+  bzero(llr_s, sizeof(llr_s));
+  bzero(llr_b, sizeof(llr_b));
+  if (!data_rx || !symbols || !llr) {
+    perror("malloc");
+    goto clean_exit;
+  }
+  for (int n=0;n<SRSLTE_TDEC_MAX_NPAR;n++) {
+    data_tx[n]       = srslte_vec_malloc(frame_length * sizeof(uint8_t));
+    data_rx_bytes[n] = srslte_vec_malloc(frame_length * sizeof(uint8_t));
+    llr_s[n]         = srslte_vec_malloc(coded_length * sizeof(int16_t));
+    llr_b[n]         = srslte_vec_malloc(coded_length * sizeof(int8_t));
+    if (!data_tx[n] || !data_rx_bytes[n] || !llr_s[n] || !llr_b[n]) {
+      perror("malloc");
+      goto clean_exit;
+    }
+  }
+
+  printf("  %-7s %5s %12s %10s %10s %8s %8s\n", "Decoder", "CB", "Mbps/core", "usec/pass", "BER", "iter/CB", "MAP KB");
+  for (srslte_tdec_impl_type_t type = SRSLTE_TDEC_GEN; type < SRSLTE_TDEC_NOF_IMPL; type++) {
+    if (!srslte_tdec_impl_available(type)) {
+      continue;
+    }
+    if (srslte_tdec_init_manual(&tdec, frame_length, type)) {
+      fprintf(stderr, "Error initiating Turbo decoder\n");
+      goto clean_exit;
+    }
+    uint32_t npar   = srslte_tdec_get_nof_parallel(&tdec);
+    uint32_t errors = 0;
+    uint64_t usec   = 0;
+    uint64_t iters  = 0;
+
+    srslte_tdec_set_early_stop(&tdec, early_stop);
+
+    srand(seed);
+    for (uint32_t cb=0;cb<nof_cb;cb+=npar) {
+      for (int n=0;n<npar;n++) {
+        for (int j=0;j<frame_length;j++) {
+          data_tx[n][j] = rand() % 2;
+        }
+        srslte_tcod_encode(tcod, data_tx[n], symbols, frame_length);
+        for (int j=0;j<coded_length;j++) {
+          llr[j] = symbols[j] ? 1 : -1;
+        }
+        srslte_ch_awgn_f(llr, llr, var, coded_length);
+        for (int j=0;j<coded_length;j++) {
+          llr_s[n][j] = (int16_t) (100*llr[j]);
+        }
+        srslte_vec_convert_sb(llr_s[n], 2, llr_b[n], coded_length);
+      }
+
+      gettimeofday(&tdata[1], NULL);
+      if (type == SRSLTE_TDEC_SSE8 || type == SRSLTE_TDEC_AVX8) {
+        srslte_tdec_run_all_par_8bit(&tdec, llr_b, data_rx_bytes, max_iterations, frame_length);
+      } else {
+        srslte_tdec_run_all_par(&tdec, llr_s, data_rx_bytes, max_iterations, frame_length);
+      }
+      gettimeofday(&tdata[2], NULL);
+      get_time_interval(tdata);
+      usec += tdata[0].tv_sec*1000000 + tdata[0].tv_usec;
+
+      for (int n=0;n<npar;n++) {
+        srslte_bit_unpack_vector(data_rx_bytes[n], data_rx, frame_length);
+        errors += srslte_bit_diff(data_tx[n], data_rx, frame_length);
+        iters  += srslte_tdec_get_nof_iterations_cb(&tdec, n);
+      }
+    }
+
+    printf("  %-7s %5d %12.1f %10.2f %10.2e %8.2f %8.1f\n", srslte_tdec_impl_string(type), npar, 
+           (float) nof_cb*frame_length/usec, (float) usec*npar/nof_cb, (float) errors/(nof_cb*frame_length), 
+           (float) iters/nof_cb, (float) srslte_tdec_get_map_footprint(&tdec, frame_length)/1024);
+    srslte_tdec_free(&tdec);
+
+    if (early_stop && iters >= (uint64_t) nof_cb*max_iterations) {
+      fprintf(stderr, "Error %s did not stop early, %.2f iterations per CB\n", srslte_tdec_impl_string(type), (float) iters/nof_cb);
+      goto clean_exit;
+    }
+
+    if (type != SRSLTE_TDEC_GEN && type != SRSLTE_TDEC_SSE_WIN && type != SRSLTE_TDEC_SSE8 && type != SRSLTE_TDEC_AVX8) {
+      if (simd_errors >= 0 && errors != simd_errors) {
+        fprintf(stderr, "Error %s decoded %d errors, expected %d\n", srslte_tdec_impl_string(type), errors, simd_errors);
+        goto clean_exit;
+      }
+      simd_errors = errors;
+    }
+  }
+  ret = 0; 
+
+clean_exit:
+  for (int n=0;n<SRSLTE_TDEC_MAX_NPAR;n++) {
+    if (data_tx[n]) {
+      free(data_tx[n]);
+    }
+    if (data_rx_bytes[n]) {
+      free(data_rx_bytes[n]);
+    }
+    if (llr_s[n]) {
+      free(llr_s[n]);
+    }
+    if (llr_b[n]) {
+      free(llr_b[n]);
+    }
+  }
+  if (data_rx) {
+    free(data_rx);
+  }
+  if (symbols) {
+    free(symbols);
+  }
+  if (llr) {
+    free(llr);
+  }
+  return ret; 
+}
 
 int main(int argc, char **argv) {
   uint32_t frame_cnt;
@@ -197,6 +346,12 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Error initiating Turbo decoder\n");
     exit(-1);
   }
+  srslte_tdec_set_early_stop(&tdec, early_stop);
+  if (nof_cb > srslte_tdec_get_nof_parallel(&tdec)) {
+    fprintf(stderr, "Turbo decoder %s supports up to %d CB in parallel\n", 
+            srslte_tdec_impl_string(tdec.type), srslte_tdec_get_nof_parallel(&tdec));
+    exit(-1);
+  }
 
   float ebno_inc, esno_db;
   ebno_inc = (SNR_MAX - SNR_MIN) / SNR_POINTS;
@@ -212,6 +367,13 @@ int main(int argc, char **argv) {
     var[0] = sqrt(1 / (pow(10, esno_db / 10)));
     snr_points = 1;
   }
+
+  if (benchmark) {
+    int ret = run_benchmark(&tcod, var[0], coded_length);
+    srslte_tdec_free(&tdec);
+    srslte_tcod_free(&tcod);
+    exit(ret);
+  }
   for (i = 0; i < snr_points; i++) {
 
     mean_usec = 0;
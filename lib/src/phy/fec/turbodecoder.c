@@ -29,6 +29,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <strings.h>
 
 #include "srslte/phy/fec/turbodecoder.h"
 #include "srslte/phy/fec/turbodecoder_gen.h"
@@ -36,136 +37,418 @@
 
 #ifdef LV_HAVE_SSE
 #include "srslte/phy/fec/turbodecoder_simd.h"
+#include "srslte/phy/fec/turbodecoder_simd8.h"
 #endif
 
 #include "srslte/phy/utils/vector.h"
 
 
-int srslte_tdec_init(srslte_tdec_t * h, uint32_t max_long_cb) {
+static const char *tdec_impl_names[SRSLTE_TDEC_NOF_IMPL] = {"auto", "gen", "sse", "avx2", "avx512", "sse_win", "sse8", "avx8"};
+
+/* 16-bit LLRs given to the 8-bit decoders are scaled down as srslte_demod_soft_demodulate_b() does */
+#define TDEC_SIMD8_SHIFT 2
+
+static bool tdec_is_8bit(srslte_tdec_t * h) {
+  return h->type == SRSLTE_TDEC_SSE8 || h->type == SRSLTE_TDEC_AVX8;
+}
+
+const char *srslte_tdec_impl_string(srslte_tdec_impl_type_t type) {
+  if (type < SRSLTE_TDEC_NOF_IMPL) {
+    return tdec_impl_names[type];
+  }
+  return "unknown";
+}
+
+/* Returns true if the implementation is compiled-in and the CPU supports it */
+bool srslte_tdec_impl_available(srslte_tdec_impl_type_t type) {
+  switch (type) {
+    case SRSLTE_TDEC_AUTO:
+    case SRSLTE_TDEC_GEN:
+      return true;
 #ifdef LV_HAVE_SSE
-  return srslte_tdec_simd_init(&h->tdec_simd, SRSLTE_TDEC_MAX_NPAR, max_long_cb);
-#else
-  h->input_conv = srslte_vec_malloc(sizeof(float) * (3*max_long_cb+12));
-  if (!h->input_conv) {
-    perror("malloc");
+    case SRSLTE_TDEC_SSE:
+    case SRSLTE_TDEC_SSE_WIN:
+    case SRSLTE_TDEC_SSE8:
+      return __builtin_cpu_supports("sse4.1");
+#endif
+#ifdef LV_HAVE_AVX2
+    case SRSLTE_TDEC_AVX2:
+    case SRSLTE_TDEC_AVX8:
+      return __builtin_cpu_supports("avx2");
+#endif
+#ifdef LV_HAVE_AVX512
+    case SRSLTE_TDEC_AVX512:
+      return __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+      return false;
+  }
+}
+
+int srslte_tdec_init(srslte_tdec_t * h, uint32_t max_long_cb) {
+  return srslte_tdec_init_manual(h, max_long_cb, SRSLTE_TDEC_AUTO);
+}
+
+int srslte_tdec_init_manual(srslte_tdec_t * h, uint32_t max_long_cb, srslte_tdec_impl_type_t type) {
+  bzero(h, sizeof(srslte_tdec_t));
+
+  if (type == SRSLTE_TDEC_AUTO) {
+    type = SRSLTE_TDEC_AVX512;
+    while (type > SRSLTE_TDEC_GEN && !srslte_tdec_impl_available(type)) {
+      type--;
+    }
+  } else if (!srslte_tdec_impl_available(type)) {
+    fprintf(stderr, "Turbo decoder %s not available\n", srslte_tdec_impl_string(type));
     return -1;
   }
-  return srslte_tdec_gen_init(&h->tdec_gen, max_long_cb);
+
+  int ret;
+  h->type = type;
+  switch (type) {
+#ifdef LV_HAVE_SSE
+    case SRSLTE_TDEC_SSE:
+      ret = srslte_tdec_simd_init(&h->tdec_simd, 1, max_long_cb);
+      break;
+    case SRSLTE_TDEC_AVX2:
+      ret = srslte_tdec_simd_init(&h->tdec_simd, 2, max_long_cb);
+      break;
+    case SRSLTE_TDEC_AVX512:
+      ret = srslte_tdec_simd_init(&h->tdec_simd, 4, max_long_cb);
+      break;
+    case SRSLTE_TDEC_SSE_WIN:
+      ret = srslte_tdec_simd_init_window(&h->tdec_simd, max_long_cb, SRSLTE_TDEC_WINDOW);
+      break;
+    case SRSLTE_TDEC_SSE8:
+    case SRSLTE_TDEC_AVX8:
+      ret = srslte_tdec_simd8_init(&h->tdec_simd8, type == SRSLTE_TDEC_AVX8?4:2, max_long_cb);
+      for (int i=0;i<srslte_tdec_get_nof_parallel(h) && !ret;i++) {
+        h->input_b[i] = srslte_vec_malloc(sizeof(int8_t) * (3*max_long_cb+12));
+        if (!h->input_b[i]) {
+          perror("srslte_vec_malloc");
+          ret = -1;
+        }
+      }
+      break;
 #endif
+    default:
+      h->type = SRSLTE_TDEC_GEN;
+      h->input_conv = srslte_vec_malloc(sizeof(float) * (3*max_long_cb+12));
+      if (!h->input_conv) {
+        perror("malloc");
+        return -1;
+      }
+      ret = srslte_tdec_gen_init(&h->tdec_gen, max_long_cb);
+      break;
+  }
+  if (ret) {
+    return ret;
+  }
+
+  for (int i=0;i<srslte_tdec_get_nof_parallel(h);i++) {
+    h->prev_decision[i] = srslte_vec_malloc(max_long_cb/8+1);
+    if (!h->prev_decision[i]) {
+      perror("srslte_vec_malloc");
+      return -1;
+    }
+  }
+  h->decision_tmp = srslte_vec_malloc(max_long_cb/8+1);
+  if (!h->decision_tmp) {
+    perror("srslte_vec_malloc");
+    return -1;
+  }
+  return 0;
 }
 
 void srslte_tdec_free(srslte_tdec_t * h) {
+  for (int i=0;i<SRSLTE_TDEC_MAX_NPAR;i++) {
+    if (h->prev_decision[i]) {
+      free(h->prev_decision[i]);
+    }
+  }
+  if (h->decision_tmp) {
+    free(h->decision_tmp);
+  }
+  for (int i=0;i<SRSLTE_TDEC_MAX_NPAR;i++) {
+    if (h->input_b[i]) {
+      free(h->input_b[i]);
+    }
+  }
+  if (h->type == SRSLTE_TDEC_GEN) {
+    if (h->input_conv) {
+      free(h->input_conv);
+    }
+    srslte_tdec_gen_free(&h->tdec_gen);
+  } else {
 #ifdef LV_HAVE_SSE
-  srslte_tdec_simd_free(&h->tdec_simd);  
-#else
-  if (h->input_conv) {
-    free(h->input_conv);
+    if (tdec_is_8bit(h)) {
+      srslte_tdec_simd8_free(&h->tdec_simd8);
+    } else {
+      srslte_tdec_simd_free(&h->tdec_simd);  
+    }
+#endif
+  }
+}
+
+/* Enables hard-decision aided early stopping. srslte_tdec_run_all() then stops iterating a 
+ * codeblock as soon as it converges. Callers running iterations themselves pass the decision 
+ * they already computed to srslte_tdec_check_converged_cb(), e.g. only once its CRC failed */
+void srslte_tdec_set_early_stop(srslte_tdec_t * h, bool enable) {
+  h->early_stop = enable;
+}
+
+bool srslte_tdec_is_converged_cb(srslte_tdec_t * h, uint32_t cb_idx) {
+  return cb_idx < SRSLTE_TDEC_MAX_NPAR && h->converged[cb_idx];
+}
+
+/* Returns the bytes of state and branch metrics the MAP recursions go through for one codeblock */
+uint32_t srslte_tdec_get_map_footprint(srslte_tdec_t * h, uint32_t long_cb) {
+#ifdef LV_HAVE_SSE
+  if (tdec_is_8bit(h)) {
+    return srslte_tdec_simd8_map_footprint(&h->tdec_simd8, long_cb);
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    return srslte_tdec_simd_map_footprint(&h->tdec_simd, long_cb);
   }
-  srslte_tdec_gen_free(&h->tdec_gen);
 #endif
+  // The generic decoder stores beta of the long_cb+3 steps and computes alpha and gamma on the fly
+  return sizeof(float) * (long_cb + 4) * 8;
+}
 
+/* Compares the packed hard decisions of the last iteration of codeblock cb_idx with those of 
+ * the previous one and keeps them for the next. It must see every iteration of the codeblock 
+ * after the first, otherwise it compares with an older one */
+bool srslte_tdec_check_converged_cb(srslte_tdec_t * h, uint32_t cb_idx, uint8_t *decision, uint32_t long_cb) {
+  if (cb_idx >= SRSLTE_TDEC_MAX_NPAR) {
+    return false; 
+  }
+  h->converged[cb_idx] = srslte_tdec_get_nof_iterations_cb(h, cb_idx) > 1 && 
+                         !memcmp(decision, h->prev_decision[cb_idx], long_cb/8);
+  memcpy(h->prev_decision[cb_idx], decision, long_cb/8);
+  return h->converged[cb_idx];
+}
+
+static void tdec_check_convergence(srslte_tdec_t * h, int16_t* input[SRSLTE_TDEC_MAX_NPAR], 
+                                   int8_t* input_b[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
+  for (int i=0;i<srslte_tdec_get_nof_parallel(h);i++) {
+    if (input_b?input_b[i]!=NULL:input[i]!=NULL) {
+      srslte_tdec_decision_byte_par_cb(h, h->decision_tmp, i, long_cb);
+      srslte_tdec_check_converged_cb(h, i, h->decision_tmp, long_cb);
+    }
+  }
 }
 
 int srslte_tdec_reset(srslte_tdec_t * h, uint32_t long_cb) {
+  bzero(h->converged, sizeof(h->converged));
 #ifdef LV_HAVE_SSE
-  return srslte_tdec_simd_reset(&h->tdec_simd, long_cb);
-#else
-  return srslte_tdec_gen_reset(&h->tdec_gen, long_cb);
+  if (tdec_is_8bit(h)) {
+    return srslte_tdec_simd8_reset(&h->tdec_simd8, long_cb);
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    return srslte_tdec_simd_reset(&h->tdec_simd, long_cb);
+  }
 #endif
+  return srslte_tdec_gen_reset(&h->tdec_gen, long_cb);
 }
 
 int srslte_tdec_reset_cb(srslte_tdec_t * h, uint32_t cb_idx) {
+  if (cb_idx < SRSLTE_TDEC_MAX_NPAR) {
+    h->converged[cb_idx] = false;
+  }
 #ifdef LV_HAVE_SSE
-  return srslte_tdec_simd_reset_cb(&h->tdec_simd, cb_idx);      
-#else
-  return srslte_tdec_gen_reset(&h->tdec_gen, h->tdec_gen.current_cb_len);
+  if (tdec_is_8bit(h)) {
+    return srslte_tdec_simd8_reset_cb(&h->tdec_simd8, cb_idx);
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    return srslte_tdec_simd_reset_cb(&h->tdec_simd, cb_idx);      
+  }
 #endif
+  return srslte_tdec_gen_reset(&h->tdec_gen, h->tdec_gen.current_cb_len);
 }
 
 int srslte_tdec_get_nof_iterations_cb(srslte_tdec_t * h, uint32_t cb_idx)
 {
 #ifdef LV_HAVE_SSE
-  return srslte_tdec_simd_get_nof_iterations_cb(&h->tdec_simd, cb_idx);
-#else
+  if (tdec_is_8bit(h)) {
+    return srslte_tdec_simd8_get_nof_iterations_cb(&h->tdec_simd8, cb_idx);
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    return srslte_tdec_simd_get_nof_iterations_cb(&h->tdec_simd, cb_idx);
+  }
+#endif
   return h->tdec_gen.n_iter;
-#endif  
 }
 
-void srslte_tdec_iteration_par(srslte_tdec_t * h, int16_t* input[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
+/* Runs one iteration over the 16-bit input or, if it is not NULL, the 8-bit input_b. Only 
+ * the 8-bit decoders take 8-bit input, they convert 16-bit input before the first iteration */
+static void tdec_iteration_par(srslte_tdec_t * h, int16_t* input[SRSLTE_TDEC_MAX_NPAR], 
+                               int8_t* input_b[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
 #ifdef LV_HAVE_SSE
-  srslte_tdec_simd_iteration(&h->tdec_simd, input, long_cb);      
-#else
-  srslte_vec_convert_if(input[0], 0.01, h->input_conv, 3*long_cb+12);
-  srslte_tdec_gen_iteration(&h->tdec_gen, h->input_conv, long_cb);
+  if (tdec_is_8bit(h)) {
+    int8_t *in[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+    for (int i=0;i<srslte_tdec_get_nof_parallel(h);i++) {
+      if (input_b) {
+        in[i] = input_b[i];
+      } else if (input[i]) {
+        if (srslte_tdec_simd8_get_nof_iterations_cb(&h->tdec_simd8, i) == 0) {
+          srslte_vec_convert_sb(input[i], TDEC_SIMD8_SHIFT, h->input_b[i], 3*long_cb+12);
+        }
+        in[i] = h->input_b[i];
+      }
+    }
+    srslte_tdec_simd8_iteration(&h->tdec_simd8, in, long_cb);
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    srslte_tdec_simd_iteration(&h->tdec_simd, input, long_cb);      
+  } else 
 #endif
+  {
+    srslte_vec_convert_if(input[0], 0.01, h->input_conv, 3*long_cb+12);
+    srslte_tdec_gen_iteration(&h->tdec_gen, h->input_conv, long_cb);
+  }
+}
+
+void srslte_tdec_iteration_par(srslte_tdec_t * h, int16_t* input[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
+  tdec_iteration_par(h, input, NULL, long_cb);
+}
+
+int srslte_tdec_iteration_par_8bit(srslte_tdec_t * h, int8_t* input[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
+  if (!tdec_is_8bit(h)) {
+    fprintf(stderr, "Turbo decoder %s does not support 8-bit LLRs\n", srslte_tdec_impl_string(h->type));
+    return SRSLTE_ERROR;
+  }
+  tdec_iteration_par(h, NULL, input, long_cb);
+  return SRSLTE_SUCCESS;
 }
 
 void srslte_tdec_iteration(srslte_tdec_t * h, int16_t* input, uint32_t long_cb) {
-  int16_t *input_par[SRSLTE_TDEC_MAX_NPAR];
+  int16_t *input_par[SRSLTE_TDEC_MAX_NPAR] = {NULL};
   input_par[0] = input; 
   return srslte_tdec_iteration_par(h, input_par, long_cb);
 }
 
 void srslte_tdec_decision_par(srslte_tdec_t * h, uint8_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
 #ifdef LV_HAVE_SSE
-  return srslte_tdec_simd_decision(&h->tdec_simd, output, long_cb);
-#else
-  return srslte_tdec_gen_decision(&h->tdec_gen, output[0], long_cb);
+  if (tdec_is_8bit(h)) {
+    srslte_tdec_simd8_decision(&h->tdec_simd8, output, long_cb);
+    return;
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    srslte_tdec_simd_decision(&h->tdec_simd, output, long_cb);
+    return;
+  }
 #endif
+  srslte_tdec_gen_decision(&h->tdec_gen, output[0], long_cb);
 }
 
 uint32_t srslte_tdec_get_nof_parallel(srslte_tdec_t *h) {
-#ifdef LV_HAVE_AVX2
-  return 2;
-#else
-  return 1;
+#ifdef LV_HAVE_SSE
+  if (tdec_is_8bit(h)) {
+    return h->tdec_simd8.max_par_cb;
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    return h->tdec_simd.max_par_cb;
+  }
 #endif
+  return 1;
 }
 
 void srslte_tdec_decision(srslte_tdec_t * h, uint8_t *output, uint32_t long_cb) {
-  uint8_t *output_par[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *output_par[SRSLTE_TDEC_MAX_NPAR] = {NULL};
   output_par[0] = output; 
   srslte_tdec_decision_par(h, output_par, long_cb);
 }
 
 void srslte_tdec_decision_byte_par(srslte_tdec_t * h, uint8_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb) {
 #ifdef LV_HAVE_SSE
-  srslte_tdec_simd_decision_byte(&h->tdec_simd, output, long_cb);  
-#else
+  if (tdec_is_8bit(h)) {
+    srslte_tdec_simd8_decision_byte(&h->tdec_simd8, output, long_cb);
+    return;
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    srslte_tdec_simd_decision_byte(&h->tdec_simd, output, long_cb);  
+    return;
+  }
+#endif
   srslte_tdec_gen_decision_byte(&h->tdec_gen, output[0], long_cb);
-#endif  
 }
 
 void srslte_tdec_decision_byte_par_cb(srslte_tdec_t * h, uint8_t *output, uint32_t cb_idx, uint32_t long_cb) {
 #ifdef LV_HAVE_SSE
-  srslte_tdec_simd_decision_byte_cb(&h->tdec_simd, output, cb_idx, long_cb);
-#else
+  if (tdec_is_8bit(h)) {
+    srslte_tdec_simd8_decision_byte_cb(&h->tdec_simd8, output, cb_idx, long_cb);
+    return;
+  } else if (h->type != SRSLTE_TDEC_GEN) {
+    srslte_tdec_simd_decision_byte_cb(&h->tdec_simd, output, cb_idx, long_cb);
+    return;
+  }
+#endif
   srslte_tdec_gen_decision_byte(&h->tdec_gen, output, long_cb);
-#endif  
 }
 
 void srslte_tdec_decision_byte(srslte_tdec_t * h, uint8_t *output, uint32_t long_cb) {
-  uint8_t *output_par[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *output_par[SRSLTE_TDEC_MAX_NPAR] = {NULL};
   output_par[0] = output; 
   srslte_tdec_decision_byte_par(h, output_par, long_cb);
 }
 
-int srslte_tdec_run_all_par(srslte_tdec_t * h, int16_t * input[SRSLTE_TDEC_MAX_NPAR],
+/* Same as tdec_iteration_par() for all the iterations, followed by the decision */
+static int tdec_run_all_par(srslte_tdec_t * h, int16_t * input[SRSLTE_TDEC_MAX_NPAR],
+                            int8_t * input_b[SRSLTE_TDEC_MAX_NPAR],
                             uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
                             uint32_t nof_iterations, uint32_t long_cb) {
+  if (h->early_stop || tdec_is_8bit(h)) {
+    int16_t *active[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+    int8_t *active_b[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+    bool any_active;
+    uint32_t iter = 0;
+    if (input) {
+      memcpy(active, input, sizeof(active));
+    } else {
+      memcpy(active_b, input_b, sizeof(active_b));
+    }
+    if (srslte_tdec_reset(h, long_cb)) {
+      return SRSLTE_ERROR;
+    }
+    do {
+      tdec_iteration_par(h, active, input_b?active_b:NULL, long_cb);
+      if (h->early_stop) {
+        tdec_check_convergence(h, active, input_b?active_b:NULL, long_cb);
+      }
+      iter++;
+      any_active = false;
+      for (int i=0;i<srslte_tdec_get_nof_parallel(h);i++) {
+        if (h->converged[i]) {
+          active[i] = NULL;
+          active_b[i] = NULL;
+        }
+        any_active |= active[i] != NULL || active_b[i] != NULL;
+      }
+    } while (iter < nof_iterations && any_active);
+    srslte_tdec_decision_byte_par(h, output, long_cb);
+    return SRSLTE_SUCCESS;
+  }
 #ifdef LV_HAVE_SSE
-  return srslte_tdec_simd_run_all(&h->tdec_simd, input, output, nof_iterations, long_cb);  
-#else
+  if (h->type != SRSLTE_TDEC_GEN) {
+    return srslte_tdec_simd_run_all(&h->tdec_simd, input, output, nof_iterations, long_cb);  
+  }
+#endif
   srslte_vec_convert_if(input[0], 0.01, h->input_conv, 3*long_cb+12);
   return srslte_tdec_gen_run_all(&h->tdec_gen, h->input_conv, output[0], nof_iterations, long_cb);
-#endif
+}
+
+int srslte_tdec_run_all_par(srslte_tdec_t * h, int16_t * input[SRSLTE_TDEC_MAX_NPAR],
+                            uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                            uint32_t nof_iterations, uint32_t long_cb) {
+  return tdec_run_all_par(h, input, NULL, output, nof_iterations, long_cb);
+}
+
+int srslte_tdec_run_all_par_8bit(srslte_tdec_t * h, int8_t * input[SRSLTE_TDEC_MAX_NPAR],
+                                 uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                                 uint32_t nof_iterations, uint32_t long_cb) {
+  if (!tdec_is_8bit(h)) {
+    fprintf(stderr, "Turbo decoder %s does not support 8-bit LLRs\n", srslte_tdec_impl_string(h->type));
+    return SRSLTE_ERROR;
+  }
+  return tdec_run_all_par(h, NULL, input, output, nof_iterations, long_cb);
 }
 
 int srslte_tdec_run_all(srslte_tdec_t * h, int16_t * input, uint8_t *output, uint32_t nof_iterations, uint32_t long_cb)
 {
-  uint8_t *output_par[SRSLTE_TDEC_MAX_NPAR];
+  uint8_t *output_par[SRSLTE_TDEC_MAX_NPAR] = {NULL};
   output_par[0] = output;   
-  int16_t *input_par[SRSLTE_TDEC_MAX_NPAR];
+  int16_t *input_par[SRSLTE_TDEC_MAX_NPAR] = {NULL};
   input_par[0] = input; 
  
   return srslte_tdec_run_all_par(h, input_par, output_par, nof_iterations, long_cb);
@@ -333,7 +333,9 @@ void map_avx_alpha(map_gen_t * s, uint32_t long_cb)
   }  
 }
 
-void map_sse_gamma_single(int16_t *output, int16_t *input, int16_t *app, int16_t *parity) 
+/* Computes the branch metrics of the last 8 steps when long_cb is not multiple of 16. The 
+ * second group of 4 steps belongs to the next slot of this CB, NCB 128-bit words ahead */
+static void map_sse_gamma_single(int16_t *output, int16_t *input, int16_t *app, int16_t *parity) 
 {
   __m128i res00, res10, res01, res11, res0, res1; 
   __m128i in, ap, pa, g1, g0;
@@ -374,9 +376,8 @@ void map_sse_gamma_single(int16_t *output, int16_t *input, int16_t *app, int16_t
   res1  = _mm_or_si128(res10, res11);
 
   _mm_store_si128(resPtr, res0);
-  resPtr++;
+  resPtr += NCB;
   _mm_store_si128(resPtr, res1);    
-  resPtr++;
 }
 
 
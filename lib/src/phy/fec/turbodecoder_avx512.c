@@ -0,0 +1,351 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "srslte/phy/fec/turbodecoder_simd.h"
+#include "srslte/phy/utils/vector.h"
+
+#include <inttypes.h>
+
+#define NUMSTATES       8
+#define NINPUTS         2
+#define TAIL            3
+#define TOTALTAIL       12
+
+#define INF 10000
+#define ZERO 0
+
+
+#ifdef LV_HAVE_AVX512
+
+#include <immintrin.h>
+
+
+// Number of CB processed in parallel in AVX512. Each CB uses one 128-bit lane
+#define NCB 4
+
+/* Branch metrics are stored in groups of 4 trellis steps (g0,g1 pairs) per CB, 
+ * the groups of all CB for the same steps are contiguous. This is the AVX2 layout 
+ * extended to 4 lanes. 
+ */
+#define BRANCH_IDX(k, cb) (((k)/4)*8*NCB + (cb)*8 + ((k)%4)*2)
+
+/* Replicates a 128-bit shuffle pattern on the 4 lanes. _mm512_shuffle_epi8 does not cross lanes, 
+ * so the patterns are the same used by the SSE decoder */
+#define SET_LANES_EPI8(...) _mm512_broadcast_i32x4(_mm_set_epi8(__VA_ARGS__))
+
+/* Computes the maximum of the 8 16-bit states of bp and bn in each lane. The maximum of bp is 
+ * returned in the words 0-3 of the lane and the maximum of bn in the words 4-7 */
+static inline __m512i hMax_lane(__m512i bp, __m512i bn)
+{
+  __m512i x = _mm512_max_epi16(_mm512_unpacklo_epi64(bp, bn), _mm512_unpackhi_epi64(bp, bn));
+  x = _mm512_max_epi16(x, _mm512_shuffle_epi32(x, _MM_PERM_CDAB));
+  x = _mm512_max_epi16(x, _mm512_rol_epi32(x, 16));
+  return x;
+}
+
+/* Computes beta values */
+void map_avx512_beta(map_gen_t * s, int16_t * output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb)
+{
+  int k;
+  uint32_t end = long_cb + 3;
+  const __m512i *alphaPtr = (const __m512i*) s->alpha;
+
+  __m512i beta_k = _mm512_broadcast_i32x4(_mm_set_epi16(-INF, -INF, -INF, -INF, -INF, -INF, -INF, 0));
+  __m512i g, bp, bn, alpha_k, out, out_lo, out_hi;
+
+  /* Define the shuffle constant for the positive beta */
+  __m512i shuf_bp = SET_LANES_EPI8(
+    15, 14, // 7
+    7,  6,  // 3
+    5,  4,  // 2
+    13, 12, // 6
+    11, 10, // 5
+    3,  2,  // 1
+    1,  0,  // 0
+    9,  8   // 4
+  );
+
+  /* Define the shuffle constant for the negative beta */
+  __m512i shuf_bn = SET_LANES_EPI8(
+    7,   6, // 3
+    15, 14, // 7
+    13, 12, // 6
+    5,  4,  // 2
+    3,  2,  // 1
+    11, 10, // 5
+    9,  8,  // 4
+    1,  0   // 0
+  );
+
+  alphaPtr += long_cb-1;
+
+  /* Define shuffle for branch costs */
+  __m512i shuf_g[4];
+  shuf_g[3] = SET_LANES_EPI8(3,2,1,0,1,0,3,2,3,2,1,0,1,0,3,2);
+  shuf_g[2] = SET_LANES_EPI8(7,6,5,4,5,4,7,6,7,6,5,4,5,4,7,6);
+  shuf_g[1] = SET_LANES_EPI8(11,10,9,8,9,8,11,10,11,10,9,8,9,8,11,10);
+  shuf_g[0] = SET_LANES_EPI8(15,14,13,12,13,12,15,14,15,14,13,12,13,12,15,14);
+
+  /* Define shuffle for beta normalization */
+  __m512i shuf_norm = SET_LANES_EPI8(1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0);
+
+  __m512i gv;
+  __m512i *gPtr = (__m512i*) s->branch;
+  gPtr += long_cb/4-1;
+
+  /* This defines a beta computation step:
+   * Adds and substracts the branch metrics to the previous beta step,
+   * shuffles the states according to the trellis path and selects maximum state
+   */
+#define BETA_STEP(g)     bp = _mm512_add_epi16(beta_k, g);\
+    bn = _mm512_sub_epi16(beta_k, g);\
+    bp = _mm512_shuffle_epi8(bp, shuf_bp);\
+    bn = _mm512_shuffle_epi8(bn, shuf_bn);\
+    beta_k = _mm512_max_epi16(bp, bn);
+
+    /* Loads the alpha metrics from memory and adds them to the temporal bn and bp
+     * metrics. Then computes horizontal maximum of both metrics. Step c of a group of 4 goes to 
+     * word 3-c of out, which is out_hi for the 4 first steps and out_lo for the 4 last 
+     */
+#define BETA_STEP_CNT(c,out) g = _mm512_shuffle_epi8(gv, shuf_g[c]);\
+    BETA_STEP(g)\
+    alpha_k = _mm512_load_si512(alphaPtr);\
+    alphaPtr--;\
+    bp = hMax_lane(_mm512_add_epi16(bp, alpha_k), _mm512_add_epi16(bn, alpha_k));\
+    out = _mm512_mask_mov_epi16(out, (__mmask32) 0x11111111 << (3-c), bp);
+
+  /* Computes max(bp)-max(bn) for the last 8 steps and stores them */
+#define BETA_STORE(lane) if (output[lane]) {\
+      _mm_storeu_si128((__m128i*) &output[lane][k-7], _mm512_extracti32x4_epi32(out, lane));\
+    }
+
+  /* The tail does not require to load alpha or produce outputs. Only update
+   * beta metrics accordingly */
+  int16_t gtail[NCB*NUMSTATES] __attribute__ ((aligned (64)));
+  for (k=end-1; k>=long_cb; k--) {
+    for (int i=0;i<NCB;i++) {
+      int16_t g0 = s->branch[BRANCH_IDX(k, i)];
+      int16_t g1 = s->branch[BRANCH_IDX(k, i)+1];
+      int16_t *gt = &gtail[i*NUMSTATES];
+      gt[0] = g1; gt[1] = g0; gt[2] = g0; gt[3] = g1;
+      gt[4] = g1; gt[5] = g0; gt[6] = g0; gt[7] = g1;
+    }
+    g = _mm512_load_si512(gtail);
+    BETA_STEP(g);
+  }
+
+  /* We inline 2 trelis steps for each normalization */
+  __m512i norm;
+  out_lo = _mm512_setzero_si512();
+  out_hi = _mm512_setzero_si512();
+  for (; k >= 0; k-=8) {
+    gv = _mm512_load_si512(gPtr);
+    gPtr--;
+    BETA_STEP_CNT(0,out_hi);
+    BETA_STEP_CNT(1,out_hi);
+    BETA_STEP_CNT(2,out_hi);
+    BETA_STEP_CNT(3,out_hi);
+    norm = _mm512_shuffle_epi8(beta_k, shuf_norm);
+    beta_k = _mm512_sub_epi16(beta_k, norm);
+    gv = _mm512_load_si512(gPtr);
+    gPtr--;
+    BETA_STEP_CNT(0,out_lo);
+    BETA_STEP_CNT(1,out_lo);
+    BETA_STEP_CNT(2,out_lo);
+    BETA_STEP_CNT(3,out_lo);
+    norm = _mm512_shuffle_epi8(beta_k, shuf_norm);
+    beta_k = _mm512_sub_epi16(beta_k, norm);
+
+    out = _mm512_sub_epi16(_mm512_unpacklo_epi64(out_lo, out_hi), _mm512_unpackhi_epi64(out_lo, out_hi));
+    BETA_STORE(0);
+    BETA_STORE(1);
+    BETA_STORE(2);
+    BETA_STORE(3);
+  }
+}
+
+/* Computes alpha metrics */
+void map_avx512_alpha(map_gen_t * s, uint32_t long_cb)
+{
+  uint32_t k;
+
+  /* Define the shuffle constant for the positive alpha */
+  __m512i shuf_ap = SET_LANES_EPI8(
+    15, 14, // 7
+    9,  8,  // 4
+    7,  6,  // 3
+    1,  0,  // 0
+    13, 12, // 6
+    11, 10, // 5
+    5,  4,  // 2
+    3,  2   // 1
+  );
+
+  /* Define the shuffle constant for the negative alpha */
+  __m512i shuf_an = SET_LANES_EPI8(
+    13, 12, // 6
+    11, 10, // 5
+    5,  4,  // 2
+    3,  2,  // 1
+    15, 14, // 7
+    9,  8,  // 4
+    7,  6,  // 3
+    1,  0   // 0
+  );
+
+  /* Define shuffle for branch costs */
+  __m512i shuf_g[4];
+  shuf_g[0] = SET_LANES_EPI8(3,2,3,2,1,0,1,0,1,0,1,0,3,2,3,2);
+  shuf_g[1] = SET_LANES_EPI8(7,6,7,6,5,4,5,4,5,4,5,4,7,6,7,6);
+  shuf_g[2] = SET_LANES_EPI8(11,10,11,10,9,8,9,8,9,8,9,8,11,10,11,10);
+  shuf_g[3] = SET_LANES_EPI8(15,14,15,14,13,12,13,12,13,12,13,12,15,14,15,14);
+
+  __m512i shuf_norm = SET_LANES_EPI8(1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0);
+
+  __m512i* alphaPtr = (__m512i*) s->alpha;
+
+  __m512i gv;
+  __m512i *gPtr = (__m512i*) s->branch;
+  __m512i g, ap, an;
+
+  __m512i alpha_k = _mm512_broadcast_i32x4(_mm_set_epi16(-INF, -INF, -INF, -INF, -INF, -INF, -INF, 0));
+  _mm512_store_si512(alphaPtr, alpha_k);
+  alphaPtr++;
+
+  /* This defines a alpha computation step:
+   * Adds and substracts the branch metrics to the previous alpha step,
+   * shuffles the states according to the trellis path and selects maximum state
+   */
+#define ALPHA_STEP(c)  g = _mm512_shuffle_epi8(gv, shuf_g[c]); \
+  ap = _mm512_add_epi16(alpha_k, g);\
+  an = _mm512_sub_epi16(alpha_k, g);\
+  ap = _mm512_shuffle_epi8(ap, shuf_ap);\
+  an = _mm512_shuffle_epi8(an, shuf_an);\
+  alpha_k = _mm512_max_epi16(ap, an);\
+  _mm512_store_si512(alphaPtr, alpha_k);\
+  alphaPtr++;\
+
+
+  /* In this loop, we compute 8 steps and normalize twice for each branch metrics memory load */
+  __m512i norm;
+  for (k = 0; k < long_cb/8; k++) {
+    gv = _mm512_load_si512(gPtr);
+    gPtr++;
+    ALPHA_STEP(0);
+    ALPHA_STEP(1);
+    ALPHA_STEP(2);
+    ALPHA_STEP(3);
+    norm = _mm512_shuffle_epi8(alpha_k, shuf_norm);
+    alpha_k = _mm512_sub_epi16(alpha_k, norm);
+    gv = _mm512_load_si512(gPtr);
+    gPtr++;
+    ALPHA_STEP(0);
+    ALPHA_STEP(1);
+    ALPHA_STEP(2);
+    ALPHA_STEP(3);
+    norm = _mm512_shuffle_epi8(alpha_k, shuf_norm);
+    alpha_k = _mm512_sub_epi16(alpha_k, norm);
+  }
+}
+
+/* Compute branch metrics (gamma) */
+void map_avx512_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity, uint32_t cbidx, uint32_t long_cb)
+{
+  __m512i in, ap, pa, g1, g0, res1, res2;
+  __m128i in_s, ap_s, pa_s, g1_s, g0_s;
+
+  __m128i *resPtr = (__m128i*) h->branch;
+  resPtr += cbidx;
+
+  /* Each lane holds 8 steps: the first 4 go to res1 and the last 4 to res2 */
+  __m512i res10_mask = SET_LANES_EPI8(0xff,0xff,7,6,0xff,0xff,5,4,0xff,0xff,3,2,0xff,0xff,1,0);
+  __m512i res11_mask = SET_LANES_EPI8(7,6,0xff,0xff,5,4,0xff,0xff,3,2,0xff,0xff,1,0,0xff,0xff);
+
+  __m512i res20_mask = SET_LANES_EPI8(0xff,0xff,15,14,0xff,0xff,13,12,0xff,0xff,11,10,0xff,0xff,9,8);
+  __m512i res21_mask = SET_LANES_EPI8(15,14,0xff,0xff,13,12,0xff,0xff,11,10,0xff,0xff,9,8,0xff,0xff);
+
+#define GAMMA_STORE(lane) _mm_store_si128(&resPtr[(2*lane)*NCB],   _mm512_extracti32x4_epi32(res1, lane));\
+  _mm_store_si128(&resPtr[(2*lane+1)*NCB], _mm512_extracti32x4_epi32(res2, lane));
+
+  uint32_t i;
+  for (i=0;i<long_cb/32;i++) {
+    in = _mm512_loadu_si512(&input[32*i]);
+    pa = _mm512_loadu_si512(&parity[32*i]);
+
+    if (app) {
+      ap = _mm512_loadu_si512(&app[32*i]);
+      in = _mm512_add_epi16(ap, in);
+    }
+
+    g0 = _mm512_srai_epi16(_mm512_sub_epi16(in, pa), 1);
+    g1 = _mm512_srai_epi16(_mm512_add_epi16(in, pa), 1);
+
+    res1 = _mm512_or_si512(_mm512_shuffle_epi8(g0, res10_mask), _mm512_shuffle_epi8(g1, res11_mask));
+    res2 = _mm512_or_si512(_mm512_shuffle_epi8(g0, res20_mask), _mm512_shuffle_epi8(g1, res21_mask));
+
+    GAMMA_STORE(0);
+    GAMMA_STORE(1);
+    GAMMA_STORE(2);
+    GAMMA_STORE(3);
+    resPtr += 8*NCB;
+  }
+
+  /* CB lengths are multiple of 8, finish the remaining steps 8 at a time */
+  for (i=32*i;i<long_cb;i+=8) {
+    in_s = _mm_loadu_si128((__m128i*) &input[i]);
+    pa_s = _mm_loadu_si128((__m128i*) &parity[i]);
+
+    if (app) {
+      ap_s = _mm_loadu_si128((__m128i*) &app[i]);
+      in_s = _mm_add_epi16(ap_s, in_s);
+    }
+
+    g0_s = _mm_srai_epi16(_mm_sub_epi16(in_s, pa_s), 1);
+    g1_s = _mm_srai_epi16(_mm_add_epi16(in_s, pa_s), 1);
+
+    _mm_store_si128(&resPtr[0], _mm_or_si128(_mm_shuffle_epi8(g0_s, _mm512_castsi512_si128(res10_mask)),
+                                             _mm_shuffle_epi8(g1_s, _mm512_castsi512_si128(res11_mask))));
+    _mm_store_si128(&resPtr[NCB], _mm_or_si128(_mm_shuffle_epi8(g0_s, _mm512_castsi512_si128(res20_mask)),
+                                               _mm_shuffle_epi8(g1_s, _mm512_castsi512_si128(res21_mask))));
+    resPtr += 2*NCB;
+  }
+
+  for (i=long_cb;i<long_cb+3;i++) {
+    h->branch[BRANCH_IDX(i, cbidx)]   = (input[i] - parity[i])/2;
+    h->branch[BRANCH_IDX(i, cbidx)+1] = (input[i] + parity[i])/2;
+  }
+}
+
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "srslte/phy/fec/turbodecoder_simd8.h"
+
+#define INF8            127
+
+#ifdef LV_HAVE_AVX2
+#include <immintrin.h>
+
+/* Same trellis as map_sse8_trellis() with codeblocks 0 and 1 in the lower 128-bit lane and codeblocks
+ * 2 and 3 in the upper one. All the byte shuffles of the SSE decoder stay within a lane, so they only
+ * need their constants duplicated. The branch metrics are laid out by map_sse8_gamma() with a stride
+ * of 32 bytes, the upper lane of each load being the 4 steps of codeblocks 2 and 3.
+ */
+
+static inline __m256i shuf_g_step_avx8(__m256i shuf_g0, int j)
+{
+  return _mm256_add_epi8(shuf_g0, _mm256_set1_epi8(4*j));
+}
+
+static inline __m256i normalize_avx8(__m256i a, __m256i swap16, __m256i swap8)
+{
+  __m256i m = _mm256_max_epi8(a, _mm256_shuffle_epi32(a, 0xB1));
+  m = _mm256_max_epi8(m, _mm256_shuffle_epi8(m, swap16));
+  m = _mm256_max_epi8(m, _mm256_shuffle_epi8(m, swap8));
+  return _mm256_subs_epi8(a, m);
+}
+
+/* See llr2_sse8(), codeblocks 2 and 3 end up in words 8 to 11 */
+static inline __m256i llr2_avx8(__m256i bp0, __m256i bn0, __m256i bp1, __m256i bn1)
+{
+  __m256 p0 = _mm256_castsi256_ps(bp0), n0 = _mm256_castsi256_ps(bn0);
+  __m256 p1 = _mm256_castsi256_ps(bp1), n1 = _mm256_castsi256_ps(bn1);
+  __m256i r0 = _mm256_max_epi8(_mm256_castps_si256(_mm256_shuffle_ps(p0, n0, _MM_SHUFFLE(2,0,2,0))),
+                               _mm256_castps_si256(_mm256_shuffle_ps(p0, n0, _MM_SHUFFLE(3,1,3,1))));
+  __m256i r1 = _mm256_max_epi8(_mm256_castps_si256(_mm256_shuffle_ps(p1, n1, _MM_SHUFFLE(2,0,2,0))),
+                               _mm256_castps_si256(_mm256_shuffle_ps(p1, n1, _MM_SHUFFLE(3,1,3,1))));
+
+  __m256i m = _mm256_max_epi8(_mm256_blend_epi16(r0, _mm256_slli_epi32(r1, 16), 0xAA),
+                              _mm256_blend_epi16(_mm256_srli_epi32(r0, 16), r1, 0xAA));
+  m = _mm256_max_epi8(m, _mm256_srli_epi16(m, 8));
+
+  return _mm256_subs_epi8(m, _mm256_srli_si256(m, 8));
+}
+
+/* Computes alpha and beta metrics and the output LLR of the codeblocks with non-NULL output, see
+ * map_sse8_trellis().
+ */
+void map_avx8_trellis(int8_t *alpha, int8_t *branch_b, int8_t *output[4], uint32_t long_cb)
+{
+  int k;
+  __m256i *metric = (__m256i*) alpha;
+  __m256i *branch = (__m256i*) branch_b;
+  uint32_t half = long_cb/2;
+  __m256i gva, gvb, g, ap, an, bp, bn, cp, cn, bp0, bn0, cp0, cn0, llr;
+
+  __m256i shuf_ap   = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 2, 5, 6, 0, 3, 4, 7, 9, 10, 13, 14, 8, 11, 12, 15));
+  __m256i shuf_an   = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 3, 4, 7, 1, 2, 5, 6, 8, 11, 12, 15, 9, 10, 13, 14));
+  __m256i shuf_bp   = _mm256_broadcastsi128_si256(_mm_setr_epi8(4, 0, 1, 5, 6, 2, 3, 7, 12, 8, 9, 13, 14, 10, 11, 15));
+  __m256i shuf_bn   = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 4, 5, 1, 2, 6, 7, 3, 8, 12, 13, 9, 10, 14, 15, 11));
+  __m256i shuf_ga0  = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 1, 0, 0, 0, 0, 1, 1, 3, 3, 2, 2, 2, 2, 3, 3));
+  __m256i shuf_gb0  = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0, 0, 1, 1, 0, 0, 1, 3, 2, 2, 3, 3, 2, 2, 3));
+  __m256i swap16    = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+  __m256i swap8     = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+  __m256i shuf_ga[4], shuf_gb[4];
+  for (int j = 0; j < 4; j++) {
+    shuf_ga[j] = shuf_g_step_avx8(shuf_ga0, j);
+    shuf_gb[j] = shuf_g_step_avx8(shuf_gb0, j);
+  }
+
+  __m256i alpha_k = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8,
+                                                               0, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8));
+  __m256i beta_k  = alpha_k;
+
+#define ALPHA_STEP(c)  g = _mm256_shuffle_epi8(gva, shuf_ga[c]);\
+  ap = _mm256_shuffle_epi8(_mm256_adds_epi8(alpha_k, g), shuf_ap);\
+  an = _mm256_shuffle_epi8(_mm256_subs_epi8(alpha_k, g), shuf_an);\
+  alpha_k = normalize_avx8(_mm256_max_epi8(ap, an), swap16, swap8);
+
+#define BETA_STEP(c)  g = _mm256_shuffle_epi8(gvb, shuf_gb[c]);\
+  bp = _mm256_shuffle_epi8(_mm256_adds_epi8(beta_k, g), shuf_bp);\
+  bn = _mm256_shuffle_epi8(_mm256_subs_epi8(beta_k, g), shuf_bn);\
+  beta_k = normalize_avx8(_mm256_max_epi8(bp, bn), swap16, swap8);
+
+  /* Same as the first half of BETA_STEP() on the forward side, from the stored beta of the next step */
+#define BETA_BRANCH(c)  g = _mm256_shuffle_epi8(gva, shuf_gb[c]);\
+  cp = _mm256_load_si256(&metric[k + c + 1]);\
+  cn = _mm256_shuffle_epi8(_mm256_subs_epi8(cp, g), shuf_bn);\
+  cp = _mm256_shuffle_epi8(_mm256_adds_epi8(cp, g), shuf_bp);\
+  cp = _mm256_adds_epi8(cp, alpha_k);\
+  cn = _mm256_adds_epi8(cn, alpha_k);
+
+#define WRITE_LLR(k0, k1)  if (output[0]) {\
+    output[0][k0] = (int8_t) _mm256_extract_epi8(llr, 0);\
+    output[0][k1] = (int8_t) _mm256_extract_epi8(llr, 2);\
+  }\
+  if (output[1]) {\
+    output[1][k0] = (int8_t) _mm256_extract_epi8(llr, 4);\
+    output[1][k1] = (int8_t) _mm256_extract_epi8(llr, 6);\
+  }\
+  if (output[2]) {\
+    output[2][k0] = (int8_t) _mm256_extract_epi8(llr, 16);\
+    output[2][k1] = (int8_t) _mm256_extract_epi8(llr, 18);\
+  }\
+  if (output[3]) {\
+    output[3][k0] = (int8_t) _mm256_extract_epi8(llr, 20);\
+    output[3][k1] = (int8_t) _mm256_extract_epi8(llr, 22);\
+  }
+
+  /* The tail only updates beta */
+  gvb = _mm256_load_si256(&branch[long_cb/4]);
+  BETA_STEP(2);
+  BETA_STEP(1);
+  BETA_STEP(0);
+
+  /* First half: alpha of steps 0 to half and beta of steps long_cb to half+1 are stored */
+  _mm256_store_si256(&metric[0], alpha_k);
+  for (k = 0; k < (int) half; k += 4) {
+    int kb = long_cb - 4 - k;
+    gva = _mm256_load_si256(&branch[k/4]);
+    gvb = _mm256_load_si256(&branch[kb/4]);
+    _mm256_store_si256(&metric[kb + 4], beta_k);
+    ALPHA_STEP(0);
+    BETA_STEP(3);
+    _mm256_store_si256(&metric[k + 1], alpha_k);
+    _mm256_store_si256(&metric[kb + 3], beta_k);
+    ALPHA_STEP(1);
+    BETA_STEP(2);
+    _mm256_store_si256(&metric[k + 2], alpha_k);
+    _mm256_store_si256(&metric[kb + 2], beta_k);
+    ALPHA_STEP(2);
+    BETA_STEP(1);
+    _mm256_store_si256(&metric[k + 3], alpha_k);
+    _mm256_store_si256(&metric[kb + 1], beta_k);
+    ALPHA_STEP(3);
+    BETA_STEP(0);
+    _mm256_store_si256(&metric[k + 4], alpha_k);
+  }
+
+  /* Second half: alpha goes on over steps half to long_cb-1 and beta over steps half-1 to 0 */
+  for (k = half; k < (int) long_cb; k += 4) {
+    int kb = long_cb - 4 - k;
+    gva = _mm256_load_si256(&branch[k/4]);
+    gvb = _mm256_load_si256(&branch[kb/4]);
+    for (int c = 0; c < 4; c += 2) {
+      BETA_BRANCH(c);
+      cp0 = cp;
+      cn0 = cn;
+      ALPHA_STEP(c);
+      BETA_STEP(3 - c);
+      bp0 = _mm256_adds_epi8(bp, _mm256_load_si256(&metric[kb + 3 - c]));
+      bn0 = _mm256_adds_epi8(bn, _mm256_load_si256(&metric[kb + 3 - c]));
+      BETA_BRANCH(c + 1);
+      ALPHA_STEP(c + 1);
+      BETA_STEP(2 - c);
+      llr = llr2_avx8(cp0, cn0, cp, cn);
+      WRITE_LLR(k + c, k + c + 1);
+      llr = llr2_avx8(bp0, bn0, _mm256_adds_epi8(bp, _mm256_load_si256(&metric[kb + 2 - c])),
+                      _mm256_adds_epi8(bn, _mm256_load_si256(&metric[kb + 2 - c])));
+      WRITE_LLR(kb + 3 - c, kb + 2 - c);
+    }
+  }
+#undef WRITE_LLR
+#undef BETA_BRANCH
+#undef BETA_STEP
+#undef ALPHA_STEP
+}
+
+#endif
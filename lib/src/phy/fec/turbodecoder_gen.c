@@ -341,6 +341,7 @@ int srslte_tdec_gen_reset(srslte_tdec_gen_t * h, uint32_t long_cb)
     return -1;
   }
   memset(h->w, 0, sizeof(float) * long_cb);
+  h->n_iter = 0;
   h->current_cbidx = srslte_cbsegm_cbindex(long_cb);
   h->current_cb_len = long_cb;
   if (h->current_cbidx < 0) {
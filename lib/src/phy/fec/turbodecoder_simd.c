@@ -52,6 +52,7 @@
 void map_sse_beta(map_gen_t * s, int16_t * output, uint32_t long_cb);
 void map_sse_alpha(map_gen_t * s, uint32_t long_cb);
 void map_sse_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity, uint32_t long_cb);
+void map_sse_win_dec(map_gen_t * s, int16_t *input, int16_t *app, int16_t *parity, int16_t *output, uint32_t long_cb);
 
 #ifdef LV_HAVE_AVX2
 void map_avx_beta(map_gen_t * s, int16_t * output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb);
@@ -59,7 +60,14 @@ void map_avx_alpha(map_gen_t * s, uint32_t long_cb);
 void map_avx_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity, uint32_t cbidx, uint32_t long_cb);
 #endif
 
+#ifdef LV_HAVE_AVX512
+void map_avx512_beta(map_gen_t * s, int16_t * output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb);
+void map_avx512_alpha(map_gen_t * s, uint32_t long_cb);
+void map_avx512_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity, uint32_t cbidx, uint32_t long_cb);
+#endif
 
+/* nof_cb is the number of lanes of the implementation (1 for SSE, 2 for AVX2 and 4 for AVX512), 
+ * lanes with a NULL output are not written */
 void map_simd_beta(map_gen_t * s, int16_t * output[SRSLTE_TDEC_MAX_NPAR], uint32_t nof_cb, uint32_t long_cb)
 {
   if (nof_cb == 1) {
@@ -70,6 +78,11 @@ void map_simd_beta(map_gen_t * s, int16_t * output[SRSLTE_TDEC_MAX_NPAR], uint32
     map_avx_beta(s, output, long_cb);
   }
 #endif
+#ifdef LV_HAVE_AVX512
+  else if (nof_cb == 4) {
+    map_avx512_beta(s, output, long_cb);
+  }
+#endif
 }
 
 void map_simd_alpha(map_gen_t * s, uint32_t nof_cb, uint32_t long_cb)
@@ -82,6 +95,11 @@ void map_simd_alpha(map_gen_t * s, uint32_t nof_cb, uint32_t long_cb)
     map_avx_alpha(s, long_cb);
   }
 #endif
+#ifdef LV_HAVE_AVX512
+  else if (nof_cb == 4) {
+    map_avx512_alpha(s, long_cb);
+  }
+#endif
 }
 void map_simd_gamma(map_gen_t * s, int16_t *input, int16_t *app, int16_t *parity, uint32_t cbidx, uint32_t nof_cb, uint32_t long_cb) 
 {
@@ -93,22 +111,61 @@ void map_simd_gamma(map_gen_t * s, int16_t *input, int16_t *app, int16_t *parity
     map_avx_gamma(s, input, app, parity, cbidx, long_cb);
   }    
 #endif
+#ifdef LV_HAVE_AVX512
+  else if (nof_cb == 4) {
+    map_avx512_gamma(s, input, app, parity, cbidx, long_cb);
+  }
+#endif
 }
 
-/* Inititalizes constituent decoder object */
-int map_simd_init(map_gen_t * h, uint32_t max_par_cb, uint32_t max_long_cb)
+/* Returns the widest implementation available: 1 (SSE), 2 (AVX2) or 4 (AVX512) codeblocks */
+static uint32_t map_simd_max_lanes()
+{
+#ifdef LV_HAVE_AVX512
+  return 4;
+#else
+#ifdef LV_HAVE_AVX2
+  return 2;
+#else
+  return 1;
+#endif
+#endif
+}
+
+/* Returns the number of lanes of the implementation used to decode nof_cb codeblocks */
+static uint32_t map_simd_nof_lanes(uint32_t nof_cb)
+{
+#ifdef LV_HAVE_AVX512
+#ifdef LV_HAVE_AVX2
+  if (nof_cb > 2) {
+#else
+  if (nof_cb > 1) {
+#endif
+    return 4; 
+  }
+#endif
+  return nof_cb; 
+}
+
+/* Inititalizes constituent decoder object. With a non-zero window, the metrics of only 
+ * one window of alpha and two windows of branch metrics are allocated */
+int map_simd_init(map_gen_t * h, uint32_t max_par_cb, uint32_t max_long_cb, uint32_t window)
 {
   bzero(h, sizeof(map_gen_t));
 
   h->max_par_cb  = max_par_cb;
   h->max_long_cb = max_long_cb;
+  h->window      = window;
+
+  uint32_t nof_lanes = map_simd_nof_lanes(max_par_cb);
+  uint32_t len       = window?2*window:max_long_cb;
 
-  h->alpha = srslte_vec_malloc(sizeof(int16_t) * (max_long_cb + SRSLTE_TCOD_TOTALTAIL + 1) * NUMSTATES * h->max_par_cb);
+  h->alpha = srslte_vec_malloc(sizeof(int16_t) * (len + SRSLTE_TCOD_TOTALTAIL + 1) * NUMSTATES * nof_lanes);
   if (!h->alpha) {
     perror("srslte_vec_malloc");
     return -1;
   }
-  h->branch = srslte_vec_malloc(sizeof(int16_t) * (max_long_cb + SRSLTE_TCOD_TOTALTAIL + 1) * NUMSTATES * h->max_par_cb);
+  h->branch = srslte_vec_malloc(sizeof(int16_t) * (len + SRSLTE_TCOD_TOTALTAIL + 1) * NUMSTATES * nof_lanes);
   if (!h->branch) {
     perror("srslte_vec_malloc");
     return -1;
@@ -132,28 +189,43 @@ void map_simd_dec(map_gen_t * h, int16_t * input[SRSLTE_TDEC_MAX_NPAR], int16_t
                   int16_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t cb_mask, uint32_t long_cb)
 {
   
-  uint32_t nof_cb = 1;
-  int16_t *outptr[SRSLTE_TDEC_MAX_NPAR] = { NULL, NULL };
+  uint32_t nof_cb = 0;
+  uint32_t lane[SRSLTE_TDEC_MAX_NPAR];
+  int16_t *outptr[SRSLTE_TDEC_MAX_NPAR];
   
+  for (int i=0;i<h->max_par_cb;i++) {
+    if (cb_mask & (1<<i)) {
+      lane[nof_cb++] = i;
+    }
+  }
+  if (nof_cb == 0) {
+    return; 
+  }
+
+  if (h->window) {
+    map_sse_win_dec(h, input[0], app?app[0]:NULL, parity[0], output[0], long_cb);
+    return; 
+  }
+
+  // Use the narrowest implementation that fits the active CB. Active CB are packed 
+  // to the first lanes except for AVX512, where inactive lanes are just not written
+#ifdef LV_HAVE_AVX512
+  if (map_simd_nof_lanes(nof_cb) == 4) {
+    nof_cb = map_simd_max_lanes(); 
+    for (int i=0;i<nof_cb && i<SRSLTE_TDEC_MAX_NPAR;i++) {
+      lane[i] = i;
+    }
+  }
+#endif
+
   // Compute branch metrics
-  switch(cb_mask) {
-    case 1:
-      nof_cb = 1; 
-      outptr[0] = output[0];
-      map_simd_gamma(h, input[0], app?app[0]:NULL, parity[0], 0, 1, long_cb);    
-      break;
-    case 2:
-      nof_cb = 1; 
-      outptr[0] = output[1];
-      map_simd_gamma(h, input[1], app?app[1]:NULL, parity[1], 0, 1, long_cb);    
-      break;
-    case 3:
-      nof_cb = 2; 
-      for (int i=0;i<2;i++) {    
-        outptr[i] = output[i];
-        map_simd_gamma(h, input[i], app?app[i]:NULL, parity[i], i, 2, long_cb);    
-      }
-      break;
+  for (int i=0;i<nof_cb;i++) {
+    if (cb_mask & (1<<lane[i])) {
+      outptr[i] = output[lane[i]];
+      map_simd_gamma(h, input[lane[i]], app?app[lane[i]]:NULL, parity[lane[i]], i, nof_cb, long_cb);
+    } else {
+      outptr[i] = NULL;
+    }
   }
 
   // Forward recursion
@@ -163,13 +235,44 @@ void map_simd_dec(map_gen_t * h, int16_t * input[SRSLTE_TDEC_MAX_NPAR], int16_t
   map_simd_beta(h, outptr, nof_cb, long_cb);
 }
 
+static int tdec_simd_init(srslte_tdec_simd_t * h, uint32_t max_par_cb, uint32_t max_long_cb, uint32_t window);
+
 /* Initializes the turbo decoder object */
 int srslte_tdec_simd_init(srslte_tdec_simd_t * h, uint32_t max_par_cb, uint32_t max_long_cb)
+{
+  return tdec_simd_init(h, max_par_cb, max_long_cb, 0);
+}
+
+/* Initializes a single-codeblock turbo decoder that runs the MAP recursions in windows of 
+ * window trellis steps, so the state metrics stay in L1 for any codeblock size */
+int srslte_tdec_simd_init_window(srslte_tdec_simd_t * h, uint32_t max_long_cb, uint32_t window)
+{
+  if (window == 0 || window % 8) {
+    fprintf(stderr, "TDEC window must be a non-zero multiple of 8\n");
+    return -1; 
+  }
+  return tdec_simd_init(h, 1, max_long_cb, window);
+}
+
+/* Returns the bytes of alpha and branch metrics a MAP recursion over a codeblock of long_cb bits goes through */
+uint32_t srslte_tdec_simd_map_footprint(srslte_tdec_simd_t * h, uint32_t long_cb)
+{
+  uint32_t len = h->dec.window?SRSLTE_MIN(2*h->dec.window, long_cb):long_cb;
+  uint32_t nof_alpha = h->dec.window?SRSLTE_MIN(h->dec.window, long_cb):long_cb + 1;
+  return sizeof(int16_t) * (nof_alpha * NUMSTATES + (len + TAIL) * NINPUTS);
+}
+
+static int tdec_simd_init(srslte_tdec_simd_t * h, uint32_t max_par_cb, uint32_t max_long_cb, uint32_t window)
 {
   int ret = -1;
   bzero(h, sizeof(srslte_tdec_simd_t));
   uint32_t len = max_long_cb + SRSLTE_TCOD_TOTALTAIL;
 
+  if (max_par_cb < 1 || max_par_cb > map_simd_max_lanes()) {
+    fprintf(stderr, "TDEC supports up to %d codeblocks in parallel\n", map_simd_max_lanes());
+    return -1; 
+  }
+
   h->max_long_cb = max_long_cb;
   h->max_par_cb  = max_par_cb; 
   
@@ -212,7 +315,7 @@ int srslte_tdec_simd_init(srslte_tdec_simd_t * h, uint32_t max_par_cb, uint32_t
     
   }
 
-  if (map_simd_init(&h->dec, h->max_par_cb, h->max_long_cb)) {
+  if (map_simd_init(&h->dec, h->max_par_cb, h->max_long_cb, window)) {
     goto clean_and_exit;
   }
 
@@ -363,11 +466,12 @@ void srslte_tdec_simd_iteration(srslte_tdec_simd_t * h, int16_t * input[SRSLTE_T
     uint16_t *inter   = h->interleaver[h->current_cbidx].forward;
     uint16_t *deinter = h->interleaver[h->current_cbidx].reverse;
     
-#ifndef LV_HAVE_AVX2
-    input[1] = NULL;
-#endif
-
-    h->cb_mask = (input[0]?1:0) | (input[1]?2:0);
+    h->cb_mask = 0;
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (input[i]) {
+        h->cb_mask |= 1<<i;
+      }
+    }
 
     for (int i=0;i<h->max_par_cb;i++) {
       if (h->n_iter[i] == 0 && input[i]) {
@@ -487,7 +591,9 @@ void tdec_simd_decision(srslte_tdec_simd_t * h, uint8_t *output, uint32_t cbidx,
 void srslte_tdec_simd_decision(srslte_tdec_simd_t * h, uint8_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb)
 {
   for (int i=0;i<h->max_par_cb;i++) {    
-    tdec_simd_decision(h, output[i], i, long_cb);
+    if (output[i]) {
+      tdec_simd_decision(h, output[i], i, long_cb);
+    }
   }
 }
 
@@ -528,9 +634,11 @@ int srslte_tdec_simd_run_all(srslte_tdec_simd_t * h, int16_t * input[SRSLTE_TDEC
     return SRSLTE_ERROR; 
   }
 
+  uint32_t n_iter = 0; 
   do {
     srslte_tdec_simd_iteration(h, input, long_cb);
-  } while (h->n_iter[0] < nof_iterations);
+    n_iter++;
+  } while (n_iter < nof_iterations);
 
   srslte_tdec_simd_decision_byte(h, output, long_cb);
   
@@ -0,0 +1,381 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "srslte/phy/fec/turbodecoder_simd8.h"
+#include "srslte/phy/utils/vector.h"
+
+#define NUMSTATES       8
+#define NINPUTS         2
+#define TAIL            3
+
+#ifdef LV_HAVE_SSE
+
+void map_sse8_gamma(int8_t *branch, uint32_t stride, int8_t *input[2], int8_t *app[2], int8_t *parity[2], uint32_t long_cb);
+void map_sse8_trellis(int8_t *alpha, int8_t *branch, int8_t *output[2], uint32_t long_cb);
+
+#ifdef LV_HAVE_AVX2
+void map_avx8_trellis(int8_t *alpha, int8_t *branch, int8_t *output[4], uint32_t long_cb);
+#endif
+
+/* Runs one instance of a decoder on the codeblocks with non-NULL input. Codeblocks 0 and 1 go through
+ * the SSE decoder when the others are not used */
+static void map_simd8_dec(srslte_tdec_simd8_t * h, int8_t *input[SRSLTE_TDEC_MAX_NPAR], int8_t *app[SRSLTE_TDEC_MAX_NPAR],
+                          int8_t *parity[SRSLTE_TDEC_MAX_NPAR], int8_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb)
+{
+#ifdef LV_HAVE_AVX2
+  if (h->max_par_cb == 4 && (input[2] || input[3])) {
+    map_sse8_gamma(h->branch, 32, input, app, parity, long_cb);
+    map_sse8_gamma(&h->branch[16], 32, &input[2], &app[2], &parity[2], long_cb);
+    map_avx8_trellis(h->alpha, h->branch, output, long_cb);
+    return;
+  }
+#endif
+  map_sse8_gamma(h->branch, 16, input, app, parity, long_cb);
+  map_sse8_trellis(h->alpha, h->branch, output, long_cb);
+}
+
+/* Initializes the turbo decoder object */
+int srslte_tdec_simd8_init(srslte_tdec_simd8_t * h, uint32_t max_par_cb, uint32_t max_long_cb)
+{
+  int ret = -1;
+  bzero(h, sizeof(srslte_tdec_simd8_t));
+  uint32_t len = max_long_cb + SRSLTE_TCOD_TOTALTAIL;
+
+  if (max_par_cb != 2 && max_par_cb != 4) {
+    fprintf(stderr, "The 8-bit turbo decoder runs 2 or 4 codeblocks, not %d\n", max_par_cb);
+    return ret;
+  }
+#ifndef LV_HAVE_AVX2
+  if (max_par_cb == 4) {
+    fprintf(stderr, "The 8-bit turbo decoder needs AVX2 for 4 codeblocks\n");
+    return ret;
+  }
+#endif
+
+  h->max_long_cb = max_long_cb;
+  h->max_par_cb  = max_par_cb;
+
+  for (int i=0;i<h->max_par_cb;i++) {
+    h->app1[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->app1[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+    h->app2[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->app2[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+    h->ext1[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->ext1[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+    h->ext2[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->ext2[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+    h->syst[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->syst[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+    h->parity0[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->parity0[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+    h->parity1[i] = srslte_vec_malloc(sizeof(int8_t) * len);
+    if (!h->parity1[i]) {
+      perror("srslte_vec_malloc");
+      goto clean_and_exit;
+    }
+  }
+
+  h->alpha = srslte_vec_malloc(sizeof(int8_t) * (max_long_cb + 1) * NUMSTATES * h->max_par_cb);
+  if (!h->alpha) {
+    perror("srslte_vec_malloc");
+    goto clean_and_exit;
+  }
+  h->branch = srslte_vec_malloc(sizeof(int8_t) * (max_long_cb + 4) * NINPUTS * h->max_par_cb);
+  if (!h->branch) {
+    perror("srslte_vec_malloc");
+    goto clean_and_exit;
+  }
+
+  for (int i=0;i<SRSLTE_NOF_TC_CB_SIZES;i++) {
+    if (srslte_tc_interl_init(&h->interleaver[i], srslte_cbsegm_cbsize(i)) < 0) {
+      goto clean_and_exit;
+    }
+    srslte_tc_interl_LTE_gen(&h->interleaver[i], srslte_cbsegm_cbsize(i));
+  }
+  h->current_cbidx = -1;
+  h->cb_mask = 0;
+  ret = 0;
+clean_and_exit:if (ret == -1) {
+    srslte_tdec_simd8_free(h);
+  }
+  return ret;
+}
+
+void srslte_tdec_simd8_free(srslte_tdec_simd8_t * h)
+{
+  for (int i=0;i<h->max_par_cb;i++) {
+    if (h->app1[i]) {
+      free(h->app1[i]);
+    }
+    if (h->app2[i]) {
+      free(h->app2[i]);
+    }
+    if (h->ext1[i]) {
+      free(h->ext1[i]);
+    }
+    if (h->ext2[i]) {
+      free(h->ext2[i]);
+    }
+    if (h->syst[i]) {
+      free(h->syst[i]);
+    }
+    if (h->parity0[i]) {
+      free(h->parity0[i]);
+    }
+    if (h->parity1[i]) {
+      free(h->parity1[i]);
+    }
+  }
+  if (h->alpha) {
+    free(h->alpha);
+  }
+  if (h->branch) {
+    free(h->branch);
+  }
+
+  for (int i=0;i<SRSLTE_NOF_TC_CB_SIZES;i++) {
+    srslte_tc_interl_free(&h->interleaver[i]);
+  }
+
+  bzero(h, sizeof(srslte_tdec_simd8_t));
+}
+
+/* Returns the bytes of alpha and branch metrics a MAP recursion over a codeblock of long_cb bits goes through */
+uint32_t srslte_tdec_simd8_map_footprint(srslte_tdec_simd8_t * h, uint32_t long_cb)
+{
+  return sizeof(int8_t) * ((long_cb + 1) * NUMSTATES + (long_cb + TAIL) * NINPUTS);
+}
+
+/* Splits the systematic and the 2 parity streams of the input */
+static void deinterleave_input_simd8(srslte_tdec_simd8_t *h, int8_t *input, uint32_t cbidx, uint32_t long_cb)
+{
+  uint32_t i;
+
+  for (i = 0; i < long_cb; i++) {
+    h->syst[cbidx][i]    = input[3*i];
+    h->parity0[cbidx][i] = input[3*i + 1];
+    h->parity1[cbidx][i] = input[3*i + 2];
+  }
+  for (i = 0; i < 3; i++) {
+    h->syst[cbidx][i+long_cb]    = input[3*long_cb + 2*i];
+    h->parity0[cbidx][i+long_cb] = input[3*long_cb + 2*i + 1];
+  }
+  for (i = 0; i < 3; i++) {
+    h->app2[cbidx][i+long_cb]    = input[3*long_cb + 6 + 2*i];
+    h->parity1[cbidx][i+long_cb] = input[3*long_cb + 6 + 2*i + 1];
+  }
+}
+
+/* Runs 1 turbo decoder iteration */
+void srslte_tdec_simd8_iteration(srslte_tdec_simd8_t * h, int8_t * input[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb)
+{
+  int8_t *syst[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+  int8_t *app[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+  int8_t *parity[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+  int8_t *output[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+
+  if (h->current_cbidx >= 0) {
+    uint16_t *inter   = h->interleaver[h->current_cbidx].forward;
+    uint16_t *deinter = h->interleaver[h->current_cbidx].reverse;
+
+    h->cb_mask = 0;
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (input[i]) {
+        h->cb_mask |= 1<<i;
+      }
+    }
+
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (h->n_iter[i] == 0 && input[i]) {
+        deinterleave_input_simd8(h, input[i], i, long_cb);
+      }
+    }
+
+    // Add apriori information to decoder 1
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (h->n_iter[i] > 0 && input[i]) {
+        srslte_vec_sub_bbb(h->app1[i], h->ext1[i], h->app1[i], long_cb);
+      }
+    }
+
+    // Run MAP DEC #1
+    for (int i=0;i<h->max_par_cb;i++) {
+      syst[i]   = input[i]?h->syst[i]:NULL;
+      app[i]    = (input[i] && h->n_iter[i])?h->app1[i]:NULL;
+      parity[i] = input[i]?h->parity0[i]:NULL;
+      output[i] = input[i]?h->ext1[i]:NULL;
+    }
+    map_simd8_dec(h, syst, app, parity, output, long_cb);
+
+    // Convert aposteriori information into extrinsic information
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (h->n_iter[i] > 0 && input[i]) {
+        srslte_vec_sub_bbb(h->ext1[i], h->app1[i], h->ext1[i], long_cb);
+      }
+    }
+
+    // Interleave extrinsic output of DEC1 to form apriori info for decoder 2
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (input[i]) {
+        srslte_vec_lut_bbb(h->ext1[i], deinter, h->app2[i], long_cb);
+      }
+    }
+
+    // Run MAP DEC #2. 2nd decoder uses apriori information as systematic bits
+    for (int i=0;i<h->max_par_cb;i++) {
+      syst[i]   = input[i]?h->app2[i]:NULL;
+      app[i]    = NULL;
+      parity[i] = input[i]?h->parity1[i]:NULL;
+      output[i] = input[i]?h->ext2[i]:NULL;
+    }
+    map_simd8_dec(h, syst, app, parity, output, long_cb);
+
+    // Deinterleaved extrinsic bits become apriori info for decoder 1
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (input[i]) {
+        srslte_vec_lut_bbb(h->ext2[i], inter, h->app1[i], long_cb);
+      }
+    }
+
+    for (int i=0;i<h->max_par_cb;i++) {
+      if (input[i]) {
+        h->n_iter[i]++;
+      }
+    }
+  } else {
+    fprintf(stderr, "Error CB index not set (call srslte_tdec_simd8_reset() first\n");
+  }
+}
+
+/* Resets the decoder and sets the codeblock length */
+int srslte_tdec_simd8_reset(srslte_tdec_simd8_t * h, uint32_t long_cb)
+{
+  if (long_cb > h->max_long_cb) {
+    fprintf(stderr, "TDEC was initialized for max_long_cb=%d\n",
+            h->max_long_cb);
+    return -1;
+  }
+  for (int i=0;i<h->max_par_cb;i++) {
+    h->n_iter[i] = 0;
+  }
+  h->cb_mask = 0;
+  h->current_cbidx = srslte_cbsegm_cbindex(long_cb);
+  if (h->current_cbidx < 0) {
+    fprintf(stderr, "Invalid CB length %d\n", long_cb);
+    return -1;
+  }
+  return 0;
+}
+
+int srslte_tdec_simd8_reset_cb(srslte_tdec_simd8_t * h, uint32_t cb_idx)
+{
+  h->n_iter[cb_idx] = 0;
+  return 0;
+}
+
+int srslte_tdec_simd8_get_nof_iterations_cb(srslte_tdec_simd8_t * h, uint32_t cb_idx)
+{
+  return h->n_iter[cb_idx];
+}
+
+void srslte_tdec_simd8_decision(srslte_tdec_simd8_t * h, uint8_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb)
+{
+  for (int i=0;i<h->max_par_cb;i++) {
+    if (output[i]) {
+      for (uint32_t j=0;j<long_cb;j++) {
+        output[i][j] = h->app1[i][j]>0?1:0;
+      }
+    }
+  }
+}
+
+void srslte_tdec_simd8_decision_byte_cb(srslte_tdec_simd8_t * h, uint8_t *output, uint32_t cbidx, uint32_t long_cb)
+{
+  uint8_t mask[8] = {0x80, 0x40, 0x20, 0x10, 0x8, 0x4, 0x2, 0x1};
+
+  // long_cb is always byte aligned
+  for (uint32_t i = 0; i < long_cb/8; i++) {
+    uint8_t out = 0;
+    for (int j = 0; j < 8; j++) {
+      out |= h->app1[cbidx][8*i+j]>0?mask[j]:0;
+    }
+    output[i] = out;
+  }
+}
+
+void srslte_tdec_simd8_decision_byte(srslte_tdec_simd8_t * h, uint8_t *output[SRSLTE_TDEC_MAX_NPAR], uint32_t long_cb)
+{
+  for (int i=0;i<h->max_par_cb;i++) {
+    if (output[i]) {
+      srslte_tdec_simd8_decision_byte_cb(h, output[i], i, long_cb);
+    }
+  }
+}
+
+/* Runs nof_iterations iterations and decides the output bits */
+int srslte_tdec_simd8_run_all(srslte_tdec_simd8_t * h, int8_t * input[SRSLTE_TDEC_MAX_NPAR], uint8_t *output[SRSLTE_TDEC_MAX_NPAR],
+                             uint32_t nof_iterations, uint32_t long_cb)
+{
+  if (srslte_tdec_simd8_reset(h, long_cb)) {
+    return SRSLTE_ERROR;
+  }
+
+  uint32_t n_iter = 0;
+  do {
+    srslte_tdec_simd8_iteration(h, input, long_cb);
+    n_iter++;
+  } while (n_iter < nof_iterations);
+
+  srslte_tdec_simd8_decision_byte(h, output, long_cb);
+
+  return SRSLTE_SUCCESS;
+}
+
+#endif
@@ -267,8 +267,8 @@ void map_sse_alpha(map_gen_t * s, uint32_t long_cb)
   }  
 }
 
-/* Compute branch metrics (gamma) */
-void map_sse_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity, uint32_t long_cb) 
+/* Compute branch metrics (gamma) of long_cb steps and the 3 tail steps after them into branch */
+void map_sse_gamma_buf(int16_t *branch, int16_t *input, int16_t *app, int16_t *parity, uint32_t long_cb) 
 {
   __m128i res00, res10, res01, res11, res0, res1; 
   __m128i in, ap, pa, g1, g0;
@@ -276,7 +276,7 @@ void map_sse_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity,
   __m128i *inPtr  = (__m128i*) input;
   __m128i *appPtr = (__m128i*) app;
   __m128i *paPtr  = (__m128i*) parity;
-  __m128i *resPtr = (__m128i*) h->branch;
+  __m128i *resPtr = (__m128i*) branch;
   
   __m128i res00_mask = _mm_set_epi8(0xff,0xff,7,6,0xff,0xff,5,4,0xff,0xff,3,2,0xff,0xff,1,0);
   __m128i res10_mask = _mm_set_epi8(0xff,0xff,15,14,0xff,0xff,13,12,0xff,0xff,11,10,0xff,0xff,9,8);
@@ -316,11 +316,17 @@ void map_sse_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity,
   }
 
   for (int i=long_cb;i<long_cb+3;i++) {
-    h->branch[2*i]   = (input[i] - parity[i])/2;
-    h->branch[2*i+1] = (input[i] + parity[i])/2;
+    branch[2*i]   = (input[i] - parity[i])/2;
+    branch[2*i+1] = (input[i] + parity[i])/2;
   }
 }
 
+/* Compute branch metrics (gamma) */
+void map_sse_gamma(map_gen_t * h, int16_t *input, int16_t *app, int16_t *parity, uint32_t long_cb) 
+{
+  map_sse_gamma_buf(h->branch, input, app, parity, long_cb);
+}
+
 
 
 
@@ -0,0 +1,270 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "srslte/phy/fec/turbodecoder_simd8.h"
+
+#define TAIL            3
+
+#define INF8            127
+
+#ifdef LV_HAVE_SSE
+#include <smmintrin.h>
+
+/* The state metrics of both codeblocks share one register: byte 8*cb+s is state s of codeblock cb.
+ * The branch metrics of a trellis step take 4 bytes, {g0, g1} of codeblock 0 and then of codeblock 1,
+ * so one 128-bit load brings the branch metrics of 4 steps. Groups of 4 steps are stride bytes apart,
+ * which lets the AVX2 decoder keep the branch metrics of codeblocks 2 and 3 in the upper lane.
+ *
+ * The trellis is the one of map_sse_alpha() and map_sse_beta() with the 16-bit shuffles turned into
+ * byte shuffles and every addition saturating. Metrics are normalized after every step, and to the
+ * maximum state rather than to state 0: 8 bits do not leave room above the survivor, subtracting an
+ * unlikely state 0 would saturate all the others to the same value.
+ */
+
+/* Per-step shuffle of the branch metrics for step j of a load is the one of step 0 plus 4*j */
+static inline __m128i shuf_g_step(__m128i shuf_g0, int j)
+{
+  return _mm_add_epi8(shuf_g0, _mm_set1_epi8(4*j));
+}
+
+/* Subtracts from each state the maximum over the 8 states of its codeblock */
+static inline __m128i normalize_sse8(__m128i a, __m128i swap16, __m128i swap8)
+{
+  __m128i m = _mm_max_epi8(a, _mm_shuffle_epi32(a, 0xB1));
+  m = _mm_max_epi8(m, _mm_shuffle_epi8(m, swap16));
+  m = _mm_max_epi8(m, _mm_shuffle_epi8(m, swap8));
+  return _mm_subs_epi8(a, m);
+}
+
+/* Returns max(bp)-max(bn) over the states of each codeblock for two consecutive trellis steps, in
+ * the low byte of the 16-bit words: word 0 and 1 for both steps of codeblock 0, words 2 and 3 for
+ * codeblock 1. This is the sign of the 16-bit decoders, whose hMax() returns 0x7FFF minus the maximum.
+ * Both steps are reduced together since a single step only fills half of the registers */
+static inline __m128i llr2_sse8(__m128i bp0, __m128i bn0, __m128i bp1, __m128i bn1)
+{
+  // 32-bit words hold the partial maximums of bp(cb0), bp(cb1), bn(cb0) and bn(cb1)
+  __m128 p0 = _mm_castsi128_ps(bp0), n0 = _mm_castsi128_ps(bn0);
+  __m128 p1 = _mm_castsi128_ps(bp1), n1 = _mm_castsi128_ps(bn1);
+  __m128i r0 = _mm_max_epi8(_mm_castps_si128(_mm_shuffle_ps(p0, n0, _MM_SHUFFLE(2,0,2,0))),
+                            _mm_castps_si128(_mm_shuffle_ps(p0, n0, _MM_SHUFFLE(3,1,3,1))));
+  __m128i r1 = _mm_max_epi8(_mm_castps_si128(_mm_shuffle_ps(p1, n1, _MM_SHUFFLE(2,0,2,0))),
+                            _mm_castps_si128(_mm_shuffle_ps(p1, n1, _MM_SHUFFLE(3,1,3,1))));
+
+  // Even 16-bit words from the first step, odd words from the second one
+  __m128i m = _mm_max_epi8(_mm_blend_epi16(r0, _mm_slli_epi32(r1, 16), 0xAA),
+                           _mm_blend_epi16(_mm_srli_epi32(r0, 16), r1, 0xAA));
+  m = _mm_max_epi8(m, _mm_srli_epi16(m, 8));
+
+  return _mm_subs_epi8(m, _mm_srli_si128(m, 8));
+}
+
+/* Computes branch metrics of 2 codeblocks, those with NULL input get zero metrics */
+void map_sse8_gamma(int8_t *branch, uint32_t stride, int8_t *input[2], int8_t *app[2], int8_t *parity[2], uint32_t long_cb)
+{
+  __m128i g0[2], g1[2];
+  uint32_t i;
+
+  for (i = 0; i < long_cb/16; i++) {
+    for (int cb = 0; cb < 2; cb++) {
+      if (input[cb]) {
+        __m128i in = _mm_load_si128((__m128i*) &input[cb][16*i]);
+        __m128i pa = _mm_load_si128((__m128i*) &parity[cb][16*i]);
+        if (app[cb]) {
+          in = _mm_adds_epi8(in, _mm_load_si128((__m128i*) &app[cb][16*i]));
+        }
+
+        // (in+pa)/2 and (in-pa)/2 are computed in 16 bits, where they can not overflow
+        __m128i in_lo = _mm_cvtepi8_epi16(in);
+        __m128i in_hi = _mm_cvtepi8_epi16(_mm_srli_si128(in, 8));
+        __m128i pa_lo = _mm_cvtepi8_epi16(pa);
+        __m128i pa_hi = _mm_cvtepi8_epi16(_mm_srli_si128(pa, 8));
+
+        g1[cb] = _mm_packs_epi16(_mm_srai_epi16(_mm_add_epi16(in_lo, pa_lo), 1),
+                                 _mm_srai_epi16(_mm_add_epi16(in_hi, pa_hi), 1));
+        g0[cb] = _mm_packs_epi16(_mm_srai_epi16(_mm_sub_epi16(in_lo, pa_lo), 1),
+                                 _mm_srai_epi16(_mm_sub_epi16(in_hi, pa_hi), 1));
+      } else {
+        g0[cb] = _mm_setzero_si128();
+        g1[cb] = _mm_setzero_si128();
+      }
+    }
+
+    __m128i a_lo = _mm_unpacklo_epi8(g0[0], g1[0]);
+    __m128i a_hi = _mm_unpackhi_epi8(g0[0], g1[0]);
+    __m128i b_lo = _mm_unpacklo_epi8(g0[1], g1[1]);
+    __m128i b_hi = _mm_unpackhi_epi8(g0[1], g1[1]);
+
+    _mm_store_si128((__m128i*) &branch[(4*i + 0)*stride], _mm_unpacklo_epi16(a_lo, b_lo));
+    _mm_store_si128((__m128i*) &branch[(4*i + 1)*stride], _mm_unpackhi_epi16(a_lo, b_lo));
+    _mm_store_si128((__m128i*) &branch[(4*i + 2)*stride], _mm_unpacklo_epi16(a_hi, b_hi));
+    _mm_store_si128((__m128i*) &branch[(4*i + 3)*stride], _mm_unpackhi_epi16(a_hi, b_hi));
+  }
+
+  // Remaining 8 steps of the codeblock sizes that are not multiple of 16, and the tail
+  for (i = 16*(long_cb/16); i < long_cb + TAIL; i++) {
+    for (int cb = 0; cb < 2; cb++) {
+      int16_t in = 0, pa = 0;
+      if (input[cb]) {
+        in = input[cb][i];
+        pa = parity[cb][i];
+        if (app[cb] && i < long_cb) {
+          in += app[cb][i];
+          in = in > INT8_MAX ? INT8_MAX : (in < INT8_MIN ? INT8_MIN : in);
+        }
+      }
+      branch[(i/4)*stride + 4*(i%4) + 2*cb]     = (int8_t) ((in - pa) >> 1);
+      branch[(i/4)*stride + 4*(i%4) + 2*cb + 1] = (int8_t) ((in + pa) >> 1);
+    }
+  }
+}
+
+/* Computes alpha and beta metrics and the output LLR of the codeblocks with non-NULL output.
+ *
+ * The per-step normalization makes one recursion latency bound, so the forward and the backward
+ * recursions are interleaved: alpha runs over the first half of the codeblock while beta runs over the
+ * second half, both storing their metrics, and then each one carries on over the other half computing
+ * the LLR with the metrics stored by the other. metric[k] holds alpha of step k for k <= long_cb/2
+ * and beta of step k above.
+ */
+void map_sse8_trellis(int8_t *alpha, int8_t *branch_b, int8_t *output[2], uint32_t long_cb)
+{
+  int k;
+  __m128i *metric = (__m128i*) alpha;
+  __m128i *branch = (__m128i*) branch_b;
+  uint32_t half = long_cb/2;
+  __m128i gva, gvb, g, ap, an, bp, bn, cp, cn, bp0, bn0, cp0, cn0, llr;
+
+  __m128i shuf_ap   = _mm_setr_epi8(1, 2, 5, 6, 0, 3, 4, 7, 9, 10, 13, 14, 8, 11, 12, 15);
+  __m128i shuf_an   = _mm_setr_epi8(0, 3, 4, 7, 1, 2, 5, 6, 8, 11, 12, 15, 9, 10, 13, 14);
+  __m128i shuf_bp   = _mm_setr_epi8(4, 0, 1, 5, 6, 2, 3, 7, 12, 8, 9, 13, 14, 10, 11, 15);
+  __m128i shuf_bn   = _mm_setr_epi8(0, 4, 5, 1, 2, 6, 7, 3, 8, 12, 13, 9, 10, 14, 15, 11);
+  __m128i shuf_ga0  = _mm_setr_epi8(1, 1, 0, 0, 0, 0, 1, 1, 3, 3, 2, 2, 2, 2, 3, 3);
+  __m128i shuf_gb0  = _mm_setr_epi8(1, 0, 0, 1, 1, 0, 0, 1, 3, 2, 2, 3, 3, 2, 2, 3);
+  __m128i swap16    = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+  __m128i swap8     = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  __m128i shuf_ga[4], shuf_gb[4];
+  for (int j = 0; j < 4; j++) {
+    shuf_ga[j] = shuf_g_step(shuf_ga0, j);
+    shuf_gb[j] = shuf_g_step(shuf_gb0, j);
+  }
+
+  __m128i alpha_k = _mm_setr_epi8(0, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8,
+                                  0, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8, -INF8);
+  __m128i beta_k  = alpha_k;
+
+#define ALPHA_STEP(c)  g = _mm_shuffle_epi8(gva, shuf_ga[c]);\
+  ap = _mm_shuffle_epi8(_mm_adds_epi8(alpha_k, g), shuf_ap);\
+  an = _mm_shuffle_epi8(_mm_subs_epi8(alpha_k, g), shuf_an);\
+  alpha_k = normalize_sse8(_mm_max_epi8(ap, an), swap16, swap8);
+
+#define BETA_STEP(c)  g = _mm_shuffle_epi8(gvb, shuf_gb[c]);\
+  bp = _mm_shuffle_epi8(_mm_adds_epi8(beta_k, g), shuf_bp);\
+  bn = _mm_shuffle_epi8(_mm_subs_epi8(beta_k, g), shuf_bn);\
+  beta_k = normalize_sse8(_mm_max_epi8(bp, bn), swap16, swap8);
+
+  /* Same as the first half of BETA_STEP() on the forward side, from the stored beta of the next step */
+#define BETA_BRANCH(c)  g = _mm_shuffle_epi8(gva, shuf_gb[c]);\
+  cp = _mm_load_si128(&metric[k + c + 1]);\
+  cn = _mm_shuffle_epi8(_mm_subs_epi8(cp, g), shuf_bn);\
+  cp = _mm_shuffle_epi8(_mm_adds_epi8(cp, g), shuf_bp);\
+  cp = _mm_adds_epi8(cp, alpha_k);\
+  cn = _mm_adds_epi8(cn, alpha_k);
+
+#define WRITE_LLR(k0, k1)  if (output[0]) {\
+    output[0][k0] = (int8_t) _mm_extract_epi8(llr, 0);\
+    output[0][k1] = (int8_t) _mm_extract_epi8(llr, 2);\
+  }\
+  if (output[1]) {\
+    output[1][k0] = (int8_t) _mm_extract_epi8(llr, 4);\
+    output[1][k1] = (int8_t) _mm_extract_epi8(llr, 6);\
+  }
+
+  /* The tail only updates beta */
+  gvb = _mm_load_si128(&branch[long_cb/4]);
+  BETA_STEP(2);
+  BETA_STEP(1);
+  BETA_STEP(0);
+
+  /* First half: alpha of steps 0 to half and beta of steps long_cb to half+1 are stored */
+  _mm_store_si128(&metric[0], alpha_k);
+  for (k = 0; k < (int) half; k += 4) {
+    int kb = long_cb - 4 - k;
+    gva = _mm_load_si128(&branch[k/4]);
+    gvb = _mm_load_si128(&branch[kb/4]);
+    _mm_store_si128(&metric[kb + 4], beta_k);
+    ALPHA_STEP(0);
+    BETA_STEP(3);
+    _mm_store_si128(&metric[k + 1], alpha_k);
+    _mm_store_si128(&metric[kb + 3], beta_k);
+    ALPHA_STEP(1);
+    BETA_STEP(2);
+    _mm_store_si128(&metric[k + 2], alpha_k);
+    _mm_store_si128(&metric[kb + 2], beta_k);
+    ALPHA_STEP(2);
+    BETA_STEP(1);
+    _mm_store_si128(&metric[k + 3], alpha_k);
+    _mm_store_si128(&metric[kb + 1], beta_k);
+    ALPHA_STEP(3);
+    BETA_STEP(0);
+    _mm_store_si128(&metric[k + 4], alpha_k);
+  }
+
+  /* Second half: alpha goes on over steps half to long_cb-1 and beta over steps half-1 to 0 */
+  for (k = half; k < (int) long_cb; k += 4) {
+    int kb = long_cb - 4 - k;
+    gva = _mm_load_si128(&branch[k/4]);
+    gvb = _mm_load_si128(&branch[kb/4]);
+    for (int c = 0; c < 4; c += 2) {
+      BETA_BRANCH(c);
+      cp0 = cp;
+      cn0 = cn;
+      ALPHA_STEP(c);
+      BETA_STEP(3 - c);
+      bp0 = _mm_adds_epi8(bp, _mm_load_si128(&metric[kb + 3 - c]));
+      bn0 = _mm_adds_epi8(bn, _mm_load_si128(&metric[kb + 3 - c]));
+      BETA_BRANCH(c + 1);
+      ALPHA_STEP(c + 1);
+      BETA_STEP(2 - c);
+      llr = llr2_sse8(cp0, cn0, cp, cn);
+      WRITE_LLR(k + c, k + c + 1);
+      llr = llr2_sse8(bp0, bn0, _mm_adds_epi8(bp, _mm_load_si128(&metric[kb + 2 - c])),
+                      _mm_adds_epi8(bn, _mm_load_si128(&metric[kb + 2 - c])));
+      WRITE_LLR(kb + 3 - c, kb + 2 - c);
+    }
+  }
+#undef WRITE_LLR
+#undef BETA_BRANCH
+#undef BETA_STEP
+#undef ALPHA_STEP
+}
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/* Sliding-window variant of the SSE MAP decoder. 
+ * 
+ * The full-length decoder keeps the alpha metrics and the branch metrics of the 
+ * whole codeblock (about 120 KB for 6144 bits), which does not fit in L1. Here the 
+ * codeblock is processed in windows of s->window trellis steps: the forward recursion 
+ * carries alpha from one window to the next, and the backward recursion of each window 
+ * is started one window further, from equiprobable states (or from the trellis tail 
+ * at the end of the codeblock). Only the metrics of two windows are kept in memory. 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+#include "srslte/phy/fec/turbodecoder_simd.h"
+#include "srslte/phy/utils/vector.h"
+
+#include <inttypes.h>
+
+#define NUMSTATES       8
+#define NINPUTS         2
+#define TAIL            3
+#define TOTALTAIL       12
+
+#define INF 10000
+#define ZERO 0
+
+
+#ifdef LV_HAVE_SSE
+#include <smmintrin.h>
+
+void map_sse_gamma_buf(int16_t *branch, int16_t *input, int16_t *app, int16_t *parity, uint32_t long_cb);
+
+/* Computes the horizontal MAX from 8 16-bit integers using the minpos_epu16 SSE4.1 instruction */
+static inline int16_t hMax(__m128i buffer)
+{
+  __m128i tmp1 = _mm_sub_epi16(_mm_set1_epi16(0x7FFF), buffer);
+  __m128i tmp3 = _mm_minpos_epu16(tmp1);
+  return (int16_t)(_mm_cvtsi128_si32(tmp3));
+}
+
+/* Runs one constituent decoder on a codeblock. long_cb and s->window must be multiples of 8 */
+void map_sse_win_dec(map_gen_t * s, int16_t *input, int16_t *app, int16_t *parity, int16_t *output, uint32_t long_cb)
+{
+  int j;
+  __m128i *alpha  = (__m128i*) s->alpha;
+  int16_t *branch = s->branch;
+
+  /* Trellis permutations, same as map_sse_alpha() and map_sse_beta() */
+  __m128i shuf_ap = _mm_set_epi8(15,14,9,8,7,6,1,0,13,12,11,10,5,4,3,2);
+  __m128i shuf_an = _mm_set_epi8(13,12,11,10,5,4,3,2,15,14,9,8,7,6,1,0);
+  __m128i shuf_bp = _mm_set_epi8(15,14,7,6,5,4,13,12,11,10,3,2,1,0,9,8);
+  __m128i shuf_bn = _mm_set_epi8(7,6,15,14,13,12,5,4,3,2,11,10,9,8,1,0);
+
+  /* Branch cost shuffles for the step in position c of a 4-step load */
+  __m128i shuf_ga[4], shuf_gb[4];
+  shuf_ga[0] = _mm_set_epi8(3,2,3,2,1,0,1,0,1,0,1,0,3,2,3,2);
+  shuf_ga[1] = _mm_set_epi8(7,6,7,6,5,4,5,4,5,4,5,4,7,6,7,6);
+  shuf_ga[2] = _mm_set_epi8(11,10,11,10,9,8,9,8,9,8,9,8,11,10,11,10);
+  shuf_ga[3] = _mm_set_epi8(15,14,15,14,13,12,13,12,13,12,13,12,15,14,15,14);
+  shuf_gb[0] = _mm_set_epi8(3,2,1,0,1,0,3,2,3,2,1,0,1,0,3,2);
+  shuf_gb[1] = _mm_set_epi8(7,6,5,4,5,4,7,6,7,6,5,4,5,4,7,6);
+  shuf_gb[2] = _mm_set_epi8(11,10,9,8,9,8,11,10,11,10,9,8,9,8,11,10);
+  shuf_gb[3] = _mm_set_epi8(15,14,13,12,13,12,15,14,15,14,13,12,13,12,15,14);
+
+  __m128i shuf_norm = _mm_set_epi8(1,0,1,0,1,0,1,0,1,0,1,0,1,0,1,0);
+
+  __m128i alpha_k = _mm_set_epi16(-INF, -INF, -INF, -INF, -INF, -INF, -INF, 0);
+  __m128i beta_k, a, g, gv, ap, an, bp, bn, norm;
+
+  /* Stores alpha before trellis step j of the window and advances it */
+#define WIN_ALPHA_STEP(c) g = _mm_shuffle_epi8(gv, shuf_ga[c]);\
+  _mm_store_si128(&alpha[j+c], alpha_k);\
+  ap = _mm_add_epi16(alpha_k, g);\
+  an = _mm_sub_epi16(alpha_k, g);\
+  ap = _mm_shuffle_epi8(ap, shuf_ap);\
+  an = _mm_shuffle_epi8(an, shuf_an);\
+  alpha_k = _mm_max_epi16(ap, an);
+
+#define WIN_BETA_STEP(g) bp = _mm_add_epi16(beta_k, g);\
+  bn = _mm_sub_epi16(beta_k, g);\
+  bp = _mm_shuffle_epi8(bp, shuf_bp);\
+  bn = _mm_shuffle_epi8(bn, shuf_bn);\
+  beta_k = _mm_max_epi16(bp, bn);
+
+  /* Beta step that also produces the LLR of trellis step j-d of the window */
+#define WIN_BETA_OUT(c,d) g = _mm_shuffle_epi8(gv, shuf_gb[c]);\
+  WIN_BETA_STEP(g)\
+  a  = _mm_load_si128(&alpha[j-d]);\
+  bp = _mm_add_epi16(bp, a);\
+  bn = _mm_add_epi16(bn, a);\
+  output[k0+j-d] = hMax(bn)-hMax(bp);
+
+#define WIN_NORM(x) norm = _mm_shuffle_epi8(x, shuf_norm);\
+  x = _mm_sub_epi16(x, norm);
+
+  /* Steps of branch metrics at the start of branch, computed for the previous window */
+  uint32_t have = 0;
+
+  for (uint32_t k0 = 0; k0 < long_cb; k0 += s->window) {
+    uint32_t n   = SRSLTE_MIN(s->window, long_cb - k0);
+    uint32_t len = SRSLTE_MIN(n + s->window, long_cb - k0);
+
+    /* Branch metrics of this window and the next one. This window's were computed as the 
+     * next window of the previous one. When len reaches the end of the codeblock, 
+     * map_sse_gamma_buf() also leaves the tail metrics after them */
+    if (len > have) {
+      map_sse_gamma_buf(&branch[2*have], &input[k0+have], app?&app[k0+have]:NULL, &parity[k0+have], len - have);
+    }
+
+    /* Forward recursion, alpha_k carries over to the next window */
+    for (j = 0; j < n; j += 4) {
+      gv = _mm_load_si128((__m128i*) &branch[2*j]);
+      WIN_ALPHA_STEP(0);
+      WIN_ALPHA_STEP(1);
+      WIN_ALPHA_STEP(2);
+      WIN_ALPHA_STEP(3);
+      WIN_NORM(alpha_k);
+    }
+
+    /* Backward recursion over the next window to acquire the beta metrics */
+    if (k0 + len == long_cb) {
+      beta_k = _mm_set_epi16(-INF, -INF, -INF, -INF, -INF, -INF, -INF, 0);
+      for (j = len + 2; j >= (int) len; j--) {
+        int16_t g0 = branch[2*j];
+        int16_t g1 = branch[2*j+1];
+        g = _mm_set_epi16(g1, g0, g0, g1, g1, g0, g0, g1);
+        WIN_BETA_STEP(g);
+      }
+    } else {
+      beta_k = _mm_setzero_si128();
+    }
+    for (j = len - 1; j >= (int) n; j -= 4) {
+      gv = _mm_load_si128((__m128i*) &branch[2*(j-3)]);
+      g = _mm_shuffle_epi8(gv, shuf_gb[3]);
+      WIN_BETA_STEP(g);
+      g = _mm_shuffle_epi8(gv, shuf_gb[2]);
+      WIN_BETA_STEP(g);
+      g = _mm_shuffle_epi8(gv, shuf_gb[1]);
+      WIN_BETA_STEP(g);
+      g = _mm_shuffle_epi8(gv, shuf_gb[0]);
+      WIN_BETA_STEP(g);
+      WIN_NORM(beta_k);
+    }
+
+    /* Backward recursion over this window and LLR computation */
+    for (j = n - 1; j >= 0; j -= 4) {
+      gv = _mm_load_si128((__m128i*) &branch[2*(j-3)]);
+      WIN_BETA_OUT(3,0);
+      WIN_BETA_OUT(2,1);
+      WIN_BETA_OUT(1,2);
+      WIN_BETA_OUT(0,3);
+      WIN_NORM(beta_k);
+    }
+
+    /* The next window's metrics, and the tail if present, move to the front */
+    have = len - n;
+    if (have) {
+      memmove(branch, &branch[2*n], sizeof(int16_t) * 2 * (have + TAIL));
+    }
+  }
+}
+
+#endif
@@ -44,6 +44,17 @@ void demod_16qam_lte_s_sse(const cf_t *symbols, short *llr, int nsymbols);
 #define SCALE_SHORT_CONV_QAM16 400
 #define SCALE_SHORT_CONV_QAM64 700
 
+/* 8-bit LLRs take the 16-bit scales divided by 4, 8 and 16, which undoes the larger
+ * QAM scales, so that the 8-bit LLRs of every modulation leave the turbo decoder the
+ * same headroom. They are computed in 16-bit and saturated to 8-bit when stored */
+#define SCALE_BYTE_CONV_QPSK   25
+#define SCALE_BYTE_CONV_QAM16  50
+#define SCALE_BYTE_CONV_QAM64  44
+
+static inline int8_t sat_b(int x) {
+  return (int8_t) (x > 127 ? 127 : (x < -128 ? -128 : x));
+}
+
 void demod_bpsk_lte_s(const cf_t *symbols, short *llr, int nsymbols) {
   for (int i=0;i<nsymbols;i++) {
     llr[i] = (short) -SCALE_SHORT_CONV_QPSK*(crealf(symbols[i]) + cimagf(symbols[i]))/sqrt(2);
@@ -56,6 +67,33 @@ void demod_bpsk_lte(const cf_t *symbols, float *llr, int nsymbols) {
   }
 }
 
+void demod_bpsk_lte_b(const cf_t *symbols, int8_t *llr, int nsymbols) {
+  for (int i=0;i<nsymbols;i++) {
+    llr[i] = sat_b((int) (-SCALE_BYTE_CONV_QPSK*(crealf(symbols[i]) + cimagf(symbols[i]))/sqrt(2)));
+  }
+}
+
+void demod_qpsk_lte_b(const cf_t *symbols, int8_t *llr, int nsymbols) {
+  int i = 0;
+#ifdef LV_HAVE_SSE
+  float *symbolsPtr = (float*) symbols;
+  __m128 scale_v = _mm_set1_ps(-SCALE_BYTE_CONV_QPSK*sqrt(2));
+  for (;i<nsymbols/8;i++) {
+    __m128i s1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&symbolsPtr[0]), scale_v));
+    __m128i s2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&symbolsPtr[4]), scale_v));
+    __m128i s3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&symbolsPtr[8]), scale_v));
+    __m128i s4 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(&symbolsPtr[12]), scale_v));
+    symbolsPtr += 16;
+    _mm_storeu_si128((__m128i*) &llr[16*i], _mm_packs_epi16(_mm_packs_epi32(s1, s2), _mm_packs_epi32(s3, s4)));
+  }
+  i *= 8;
+#endif
+  for (;i<nsymbols;i++) {
+    llr[2*i+0] = sat_b((int) roundf(-SCALE_BYTE_CONV_QPSK*sqrt(2)*crealf(symbols[i])));
+    llr[2*i+1] = sat_b((int) roundf(-SCALE_BYTE_CONV_QPSK*sqrt(2)*cimagf(symbols[i])));
+  }
+}
+
 void demod_qpsk_lte_s(const cf_t *symbols, short *llr, int nsymbols) {
   srslte_vec_convert_fi((const float*) symbols, -SCALE_SHORT_CONV_QPSK*sqrt(2), llr, nsymbols*2);
 }
@@ -122,6 +160,70 @@ void demod_16qam_lte_s_sse(const cf_t *symbols, short *llr, int nsymbols) {
 }
 #endif
 
+#ifdef LV_HAVE_SSE
+
+/* Same as demod_16qam_lte_s_sse() with the 8-bit scale, the 16-bit LLRs of 4 symbols are
+ * packed with saturation into 16 bytes */
+void demod_16qam_lte_b_sse(const cf_t *symbols, int8_t *llr, int nsymbols) {
+  float *symbolsPtr = (float*) symbols;
+  __m128i *resultPtr = (__m128i*) llr;
+  __m128 symbol1, symbol2; 
+  __m128i symbol_i1, symbol_i2, symbol_i, symbol_abs;
+  __m128i offset = _mm_set1_epi16(2*SCALE_BYTE_CONV_QAM16/sqrt(10));
+  __m128i result11, result12, result22, result21; 
+  __m128 scale_v = _mm_set1_ps(-SCALE_BYTE_CONV_QAM16);
+  __m128i shuffle_negated_1 = _mm_set_epi8(0xff,0xff,0xff,0xff,7,6,5,4,0xff,0xff,0xff,0xff,3,2,1,0);
+  __m128i shuffle_negated_2 = _mm_set_epi8(0xff,0xff,0xff,0xff,15,14,13,12,0xff,0xff,0xff,0xff,11,10,9,8);
+  __m128i shuffle_abs_1 = _mm_set_epi8(7,6,5,4,0xff,0xff,0xff,0xff,3,2,1,0,0xff,0xff,0xff,0xff);
+  __m128i shuffle_abs_2 = _mm_set_epi8(15,14,13,12,0xff,0xff,0xff,0xff,11,10,9,8,0xff,0xff,0xff,0xff);
+  for (int i=0;i<nsymbols/4;i++) {
+    symbol1   = _mm_loadu_ps(symbolsPtr); symbolsPtr+=4;
+    symbol2   = _mm_loadu_ps(symbolsPtr); symbolsPtr+=4;
+    symbol_i1 = _mm_cvtps_epi32(_mm_mul_ps(symbol1, scale_v));
+    symbol_i2 = _mm_cvtps_epi32(_mm_mul_ps(symbol2, scale_v));
+    symbol_i  = _mm_packs_epi32(symbol_i1, symbol_i2);
+    
+    symbol_abs  = _mm_abs_epi16(symbol_i);
+    symbol_abs  = _mm_sub_epi16(symbol_abs, offset);
+    
+    result11 = _mm_shuffle_epi8(symbol_i, shuffle_negated_1);  
+    result12 = _mm_shuffle_epi8(symbol_abs, shuffle_abs_1);  
+
+    result21 = _mm_shuffle_epi8(symbol_i, shuffle_negated_2);  
+    result22 = _mm_shuffle_epi8(symbol_abs, shuffle_abs_2);  
+
+    _mm_storeu_si128(resultPtr, _mm_packs_epi16(_mm_or_si128(result11, result12), _mm_or_si128(result21, result22))); 
+    resultPtr++;
+  }
+  // Demodulate last symbols 
+  for (int i=4*(nsymbols/4);i<nsymbols;i++) {
+    int yre = (int) (SCALE_BYTE_CONV_QAM16*crealf(symbols[i]));
+    int yim = (int) (SCALE_BYTE_CONV_QAM16*cimagf(symbols[i]));
+        
+    llr[4*i+0] = sat_b(-yre);
+    llr[4*i+1] = sat_b(-yim);
+    llr[4*i+2] = sat_b(abs(yre)-2*SCALE_BYTE_CONV_QAM16/sqrt(10));
+    llr[4*i+3] = sat_b(abs(yim)-2*SCALE_BYTE_CONV_QAM16/sqrt(10));    
+  }
+}
+#endif
+
+void demod_16qam_lte_b(const cf_t *symbols, int8_t *llr, int nsymbols) {
+#ifdef LV_HAVE_SSE
+  demod_16qam_lte_b_sse(symbols, llr, nsymbols);
+#else
+  for (int i=0;i<nsymbols;i++) {
+    int yre = (int) (SCALE_BYTE_CONV_QAM16*crealf(symbols[i]));
+    int yim = (int) (SCALE_BYTE_CONV_QAM16*cimagf(symbols[i]));
+        
+    llr[4*i+0] = sat_b(-yre);
+    llr[4*i+1] = sat_b(-yim);
+    llr[4*i+2] = sat_b(abs(yre)-2*SCALE_BYTE_CONV_QAM16/sqrt(10));
+    llr[4*i+3] = sat_b(abs(yim)-2*SCALE_BYTE_CONV_QAM16/sqrt(10));    
+  }
+#endif
+}
+
 void demod_16qam_lte_s(const cf_t *symbols, short *llr, int nsymbols) {
 #ifdef LV_HAVE_SSE
   demod_16qam_lte_s_sse(symbols, llr, nsymbols);
@@ -240,6 +342,93 @@ void demod_64qam_lte_s(const cf_t *symbols, short *llr, int nsymbols)
 #endif
 }
 
+#ifdef LV_HAVE_SSE
+
+/* Same as demod_64qam_lte_s_sse() with the 8-bit scale, the 16-bit LLRs of 4 symbols are
+ * packed with saturation into 24 bytes */
+void demod_64qam_lte_b_sse(const cf_t *symbols, int8_t *llr, int nsymbols) 
+{
+  float *symbolsPtr = (float*) symbols;
+  __m128 symbol1, symbol2; 
+  __m128i symbol_i1, symbol_i2, symbol_i, symbol_abs, symbol_abs2, res1, res2, res3;
+  __m128i offset1 = _mm_set1_epi16(4*SCALE_BYTE_CONV_QAM64/sqrt(42));
+  __m128i offset2 = _mm_set1_epi16(2*SCALE_BYTE_CONV_QAM64/sqrt(42));
+  __m128 scale_v = _mm_set1_ps(-SCALE_BYTE_CONV_QAM64);
+
+  __m128i shuffle_negated_1 = _mm_set_epi8(7,6,5,4,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,3,2,1,0);
+  __m128i shuffle_negated_2 = _mm_set_epi8(0xff,0xff,0xff,0xff,11,10,9,8,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff);
+  __m128i shuffle_negated_3 = _mm_set_epi8(0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,15,14,13,12,0xff,0xff,0xff,0xff);
+
+  __m128i shuffle_abs_1 = _mm_set_epi8(0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,3,2,1,0,0xff,0xff,0xff,0xff);
+  __m128i shuffle_abs_2 = _mm_set_epi8(11,10,9,8,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,7,6,5,4);
+  __m128i shuffle_abs_3 = _mm_set_epi8(0xff,0xff,0xff,0xff,15,14,13,12,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff);
+
+  __m128i shuffle_abs2_1 = _mm_set_epi8(0xff,0xff,0xff,0xff,3,2,1,0,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff);
+  __m128i shuffle_abs2_2 = _mm_set_epi8(0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,7,6,5,4,0xff,0xff,0xff,0xff);
+  __m128i shuffle_abs2_3 = _mm_set_epi8(15,14,13,12,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,11,10,9,8);
+
+  for (int i=0;i<nsymbols/4;i++) {
+    symbol1   = _mm_loadu_ps(symbolsPtr); symbolsPtr+=4;
+    symbol2   = _mm_loadu_ps(symbolsPtr); symbolsPtr+=4;
+    symbol_i1 = _mm_cvtps_epi32(_mm_mul_ps(symbol1, scale_v));
+    symbol_i2 = _mm_cvtps_epi32(_mm_mul_ps(symbol2, scale_v));
+    symbol_i  = _mm_packs_epi32(symbol_i1, symbol_i2);
+    
+    symbol_abs  = _mm_abs_epi16(symbol_i);
+    symbol_abs  = _mm_sub_epi16(symbol_abs, offset1);
+    symbol_abs2 = _mm_sub_epi16(_mm_abs_epi16(symbol_abs), offset2);
+    
+    res1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(symbol_i, shuffle_negated_1), 
+                                     _mm_shuffle_epi8(symbol_abs, shuffle_abs_1)), 
+                        _mm_shuffle_epi8(symbol_abs2, shuffle_abs2_1));
+    res2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(symbol_i, shuffle_negated_2), 
+                                     _mm_shuffle_epi8(symbol_abs, shuffle_abs_2)), 
+                        _mm_shuffle_epi8(symbol_abs2, shuffle_abs2_2));
+    res3 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(symbol_i, shuffle_negated_3), 
+                                     _mm_shuffle_epi8(symbol_abs, shuffle_abs_3)), 
+                        _mm_shuffle_epi8(symbol_abs2, shuffle_abs2_3));
+
+    _mm_storeu_si128((__m128i*) &llr[24*i], _mm_packs_epi16(res1, res2));
+    _mm_storel_epi64((__m128i*) &llr[24*i+16], _mm_packs_epi16(res3, res3));
+  }
+  for (int i=4*(nsymbols/4);i<nsymbols;i++) {
+    int yre = (int) (SCALE_BYTE_CONV_QAM64*crealf(symbols[i]));
+    int yim = (int) (SCALE_BYTE_CONV_QAM64*cimagf(symbols[i]));
+    int are = abs(yre)-4*SCALE_BYTE_CONV_QAM64/sqrt(42);
+    int aim = abs(yim)-4*SCALE_BYTE_CONV_QAM64/sqrt(42);
+
+    llr[6*i+0] = sat_b(-yre);
+    llr[6*i+1] = sat_b(-yim);
+    llr[6*i+2] = sat_b(are);
+    llr[6*i+3] = sat_b(aim);
+    llr[6*i+4] = sat_b(abs(are)-2*SCALE_BYTE_CONV_QAM64/sqrt(42));
+    llr[6*i+5] = sat_b(abs(aim)-2*SCALE_BYTE_CONV_QAM64/sqrt(42));        
+  }
+}
+  
+#endif
+
+void demod_64qam_lte_b(const cf_t *symbols, int8_t *llr, int nsymbols) 
+{
+#ifdef LV_HAVE_SSE
+  demod_64qam_lte_b_sse(symbols, llr, nsymbols);
+#else
+  for (int i=0;i<nsymbols;i++) {
+    int yre = (int) (SCALE_BYTE_CONV_QAM64*crealf(symbols[i]));
+    int yim = (int) (SCALE_BYTE_CONV_QAM64*cimagf(symbols[i]));
+    int are = abs(yre)-4*SCALE_BYTE_CONV_QAM64/sqrt(42);
+    int aim = abs(yim)-4*SCALE_BYTE_CONV_QAM64/sqrt(42);
+
+    llr[6*i+0] = sat_b(-yre);
+    llr[6*i+1] = sat_b(-yim);
+    llr[6*i+2] = sat_b(are);
+    llr[6*i+3] = sat_b(aim);
+    llr[6*i+4] = sat_b(abs(are)-2*SCALE_BYTE_CONV_QAM64/sqrt(42));
+    llr[6*i+5] = sat_b(abs(aim)-2*SCALE_BYTE_CONV_QAM64/sqrt(42));        
+  }
+#endif
+}
+
 int srslte_demod_soft_demodulate(srslte_mod_t modulation, const cf_t* symbols, float* llr, int nsymbols) {
   switch(modulation) {
     case SRSLTE_MOD_BPSK:
@@ -261,6 +450,27 @@ int srslte_demod_soft_demodulate(srslte_mod_t modulation, const cf_t* symbols, f
   return 0; 
 }
 
+int srslte_demod_soft_demodulate_b(srslte_mod_t modulation, const cf_t* symbols, int8_t* llr, int nsymbols) {
+  switch(modulation) {
+    case SRSLTE_MOD_BPSK:
+      demod_bpsk_lte_b(symbols, llr, nsymbols);
+      break;
+    case SRSLTE_MOD_QPSK:
+      demod_qpsk_lte_b(symbols, llr, nsymbols);
+      break;
+    case SRSLTE_MOD_16QAM:
+      demod_16qam_lte_b(symbols, llr, nsymbols);
+      break;
+    case SRSLTE_MOD_64QAM:
+      demod_64qam_lte_b(symbols, llr, nsymbols);
+      break;
+    default: 
+      fprintf(stderr, "Invalid modulation %d\n", modulation);
+      return -1; 
+  } 
+  return 0; 
+}
+
 int srslte_demod_soft_demodulate_s(srslte_mod_t modulation, const cf_t* symbols, short* llr, int nsymbols) {
   switch(modulation) {
     case SRSLTE_MOD_BPSK:
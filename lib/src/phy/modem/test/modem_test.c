@@ -88,6 +88,7 @@ int main(int argc, char **argv) {
   uint8_t *input, *input_bytes, *output;
   cf_t *symbols, *symbols_bytes;
   float *llr, *llr2;
+  int8_t *llr_b;
 
   parse_args(argc, argv);
 
@@ -144,6 +145,12 @@ int main(int argc, char **argv) {
     exit(-1);
   }
 
+  llr_b = srslte_vec_malloc(sizeof(int8_t) * num_bits);
+  if (!llr_b) {
+    perror("malloc");
+    exit(-1);
+  }
+
   /* generate random data */
   for (i=0;i<num_bits;i++) {
     input[i] = rand()%2;
@@ -197,6 +204,20 @@ int main(int argc, char **argv) {
     }
   }
 
+  /* 8-bit LLRs must give the same decisions */
+  gettimeofday(&x, NULL);
+  srslte_demod_soft_demodulate_b(modulation, symbols, llr_b, num_bits / mod.nbits_x_symbol);
+  gettimeofday(&y, NULL);
+
+  printf("Elapsed time 8-bit [us]: %ld\n", y.tv_usec - x.tv_usec);
+  for (i=0;i<num_bits;i++) {
+    if (input[i] != (llr_b[i]>=0 ? 1 : 0)) {
+      fprintf(stderr, "Error in 8-bit LLR %d\n", i);
+      exit(-1);
+    }
+  }
+
+  free(llr_b);
   free(llr2);
   free(llr);
   free(symbols);
@@ -680,17 +680,29 @@ static int srslte_pdsch_codeword_decode(srslte_pdsch_t *q, srslte_pdsch_cfg_t *c
          cfg->sf_idx, codeword_idx, tb_idx, srslte_mod_string(mcs->mod), mcs->tbs,
          nbits->nof_re, nbits->nof_bits, rv);
 
+    /* 8-bit LLRs use the first half of the 16-bit buffer */
+    int16_t *e   = q->e[codeword_idx];
+    int8_t  *e_b = (int8_t*) q->e[codeword_idx];
+
     /* demodulate symbols
      * The MAX-log-MAP algorithm used in turbo decoding is unsensitive to SNR estimation,
      * thus we don't need tot set it in the LLRs normalization
      */
-    srslte_demod_soft_demodulate_s(mcs->mod, q->d[codeword_idx], q->e[codeword_idx], nbits->nof_re);
+    if (dl_sch->llr_8bit) {
+      srslte_demod_soft_demodulate_b(mcs->mod, q->d[codeword_idx], e_b, nbits->nof_re);
+    } else {
+      srslte_demod_soft_demodulate_s(mcs->mod, q->d[codeword_idx], e, nbits->nof_re);
+    }
 
     /* Select scrambling sequence */
     srslte_sequence_t *seq = get_user_sequence(q, rnti, codeword_idx, cfg->sf_idx, nbits->nof_bits);
 
     /* Bit scrambling */
-    srslte_scrambling_s_offset(seq, q->e[codeword_idx], 0, nbits->nof_bits);
+    if (dl_sch->llr_8bit) {
+      srslte_scrambling_sb_offset(seq, e_b, 0, nbits->nof_bits);
+    } else {
+      srslte_scrambling_s_offset(seq, e, 0, nbits->nof_bits);
+    }
 
     uint32_t qm = 0;
     switch(cfg->grant.mcs[tb_idx].mod) {
@@ -711,8 +723,6 @@ static int srslte_pdsch_codeword_decode(srslte_pdsch_t *q, srslte_pdsch_cfg_t *c
         ERROR("No modulation");
     }
 
-    int16_t *e = q->e[codeword_idx];
-
     if (q->csi_enabled) {
       const uint32_t csi_max_idx = srslte_vec_max_fi(q->csi[codeword_idx], nbits->nof_bits / qm);
       float csi_max = 1.0f;
@@ -722,13 +732,21 @@ static int srslte_pdsch_codeword_decode(srslte_pdsch_t *q, srslte_pdsch_cfg_t *c
       for (int i = 0; i < nbits->nof_bits / qm; i++) {
         const float csi = q->csi[codeword_idx][i] / csi_max;
         for (int k = 0; k < qm; k++) {
-          e[qm * i + k] = (int16_t) ((float) e[qm * i + k] * csi);
+          if (dl_sch->llr_8bit) {
+            e_b[qm * i + k] = (int8_t) ((float) e_b[qm * i + k] * csi);
+          } else {
+            e[qm * i + k] = (int16_t) ((float) e[qm * i + k] * csi);
+          }
         }
       }
     }
 
     /* Return  */
-    ret = srslte_dlsch_decode2(dl_sch, cfg, softbuffer, q->e[codeword_idx], data, tb_idx);
+    if (dl_sch->llr_8bit) {
+      ret = srslte_dlsch_decode2_8bit(dl_sch, cfg, softbuffer, e_b, data, tb_idx);
+    } else {
+      ret = srslte_dlsch_decode2(dl_sch, cfg, softbuffer, e, data, tb_idx);
+    }
 
     q->last_nof_iterations[codeword_idx] = srslte_sch_last_noi(&q->dl_sch);
 
@@ -873,6 +891,7 @@ int srslte_pdsch_decode(srslte_pdsch_t *q,
             h->tb_idx = tb_idx;
             h->ack = &acks[tb_idx];
             h->dl_sch.max_iterations = q->dl_sch.max_iterations;
+            srslte_sch_set_early_stop(&h->dl_sch, q->dl_sch.decoder.early_stop);
             h->started = true;
             sem_post(&h->start);
 
@@ -1054,6 +1073,33 @@ void srslte_pdsch_set_max_noi(srslte_pdsch_t *q, uint32_t max_iter) {
   srslte_sch_set_max_noi(&q->dl_sch, max_iter);
 }
 
+/* Stops decoding code blocks whose hard decisions no longer change, see srslte_sch_set_early_stop() */
+void srslte_pdsch_set_early_stop(srslte_pdsch_t *q, bool enable) {
+  srslte_sch_set_early_stop(&q->dl_sch, enable);
+}
+
+/* Demodulates, descrambles and decodes with 8-bit LLRs, see srslte_sch_set_llr_8bit() */
+int srslte_pdsch_set_llr_8bit(srslte_pdsch_t *q, bool enable) {
+  srslte_pdsch_coworker_t *h = (srslte_pdsch_coworker_t *) q->coworker_ptr;
+
+  if (srslte_sch_set_llr_8bit(&q->dl_sch, enable)) {
+    return SRSLTE_ERROR;
+  }
+  if (h) {
+    return srslte_sch_set_llr_8bit(&h->dl_sch, enable);
+  }
+  return SRSLTE_SUCCESS;
+}
+
+void srslte_pdsch_set_sch_pool(srslte_pdsch_t *q, srslte_sch_pool_t *pool) {
+  srslte_pdsch_coworker_t *h = (srslte_pdsch_coworker_t *) q->coworker_ptr;
+
+  srslte_sch_set_pool(&q->dl_sch, pool);
+  if (h) {
+    srslte_sch_set_pool(&h->dl_sch, pool);
+  }
+}
+
 float srslte_pdsch_last_noi(srslte_pdsch_t *q) {
   float niters = 0;
   int   active_cw = 0;
@@ -1088,6 +1134,12 @@ int srslte_pdsch_enable_coworker(srslte_pdsch_t *q) {
       ret = SRSLTE_ERROR;
       goto clean;
     }
+    srslte_sch_set_pool(&h->dl_sch, q->dl_sch.pool);
+    if (srslte_sch_set_llr_8bit(&h->dl_sch, q->dl_sch.llr_8bit)) {
+      ERROR("Initiating DL SCH");
+      ret = SRSLTE_ERROR;
+      goto clean;
+    }
 
     if (sem_init(&h->start, 0, 0)) {
       ERROR("Creating semaphore");
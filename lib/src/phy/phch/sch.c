@@ -172,6 +172,42 @@ void srslte_sch_set_max_noi(srslte_sch_t *q, uint32_t max_iterations) {
   q->max_iterations = max_iterations;
 }
 
+/* Stops iterating a code block whose CRC fails once its hard decisions no longer change. 
+ * Saves iterations on code blocks that would not decode, at a small BLER cost */
+void srslte_sch_set_early_stop(srslte_sch_t *q, bool enable) {
+  srslte_tdec_set_early_stop(&q->decoder, enable);
+}
+
+/* Switches the turbo decoder to the 8-bit one, which srslte_dlsch_decode2_8bit() requires, or back 
+ * to the default one. Halves the memory the decoder and the soft buffers go through, at a BLER 
+ * cost of 0.1 to 0.5 dB (pdsch_test -E, 16QAM at 10 dB: BLER 0.60 instead of 0.44). Re-initiates 
+ * the decoder, so it is meant to be called at configuration time */
+int srslte_sch_set_llr_8bit(srslte_sch_t *q, bool enable) {
+  if (enable == q->llr_8bit) {
+    return SRSLTE_SUCCESS;
+  }
+  srslte_tdec_impl_type_t type = SRSLTE_TDEC_AUTO;
+  if (enable) {
+    if (srslte_tdec_impl_available(SRSLTE_TDEC_AVX8)) {
+      type = SRSLTE_TDEC_AVX8;
+    } else if (srslte_tdec_impl_available(SRSLTE_TDEC_SSE8)) {
+      type = SRSLTE_TDEC_SSE8;
+    } else {
+      fprintf(stderr, "8-bit turbo decoder is not available\n");
+      return SRSLTE_ERROR;
+    }
+  }
+  bool early_stop = q->decoder.early_stop;
+  srslte_tdec_free(&q->decoder);
+  if (srslte_tdec_init_manual(&q->decoder, SRSLTE_TCOD_MAX_LEN_CB, type)) {
+    fprintf(stderr, "Error initiating Turbo Decoder\n");
+    return SRSLTE_ERROR;
+  }
+  srslte_tdec_set_early_stop(&q->decoder, early_stop);
+  q->llr_8bit = enable;
+  return SRSLTE_SUCCESS;
+}
+
 uint32_t srslte_sch_last_noi(srslte_sch_t *q) {
   return q->nof_iterations;
 }
@@ -304,101 +340,163 @@ static int encode_tb(srslte_sch_t *q,
   return encode_tb_off(q, soft_buffer, cb_segm, Qm, rv, nof_e_bits, data, e_bits, 0);
 }
 
-bool decode_tb_cb(srslte_sch_t *q, 
-                     srslte_softbuffer_rx_t *softbuffer, srslte_cbsegm_t *cb_segm, 
-                     uint32_t Qm, uint32_t rv, uint32_t nof_e_bits, 
-                     int16_t *e_bits, uint8_t *data,
-                     uint32_t cb_size_group) 
+/* A group of equal size code blocks of one transport block. The caller and the pool threads helping
+ * it claim code blocks through next_cb. Fields from next_cb on are protected by the pool mutex when
+ * the job is shared.
+ */
+typedef struct sch_job_s {
+  srslte_softbuffer_rx_t *softbuffer;
+  srslte_cbsegm_t *cb_segm;
+  uint32_t Qm;
+  uint32_t rv;
+  uint32_t nof_e_bits;
+  int16_t *e_bits;
+  int8_t *e_bits_b;
+  uint32_t max_iterations;
+  bool early_stop;
+  bool llr_8bit;
+
+  uint32_t first_cb;
+  uint32_t nof_cb;
+  uint32_t cb_len;
+  uint32_t cb_len_idx;
+
+  uint32_t next_cb;
+  uint32_t nof_helpers;
+  uint32_t nof_iterations;
+  bool error;
+  struct sch_job_s *next;
+} sch_job_t;
+
+/* Returns the position of the rate matched bits of code block r in the codeword and writes its
+ * length to n_e. Follows 36.212 5.1.4.1.2 like encode_tb_off().
+ */
+static uint32_t cb_e_offset(srslte_cbsegm_t *cb_segm, uint32_t Qm, uint32_t nof_e_bits, uint32_t r, uint32_t *n_e)
 {
+  uint32_t Gp    = nof_e_bits / Qm;
+  uint32_t gamma = Gp % cb_segm->C;
+  uint32_t n_e1  = Qm * (Gp / cb_segm->C);
 
-  bool cb_map[SRSLTE_MAX_CODEBLOCKS];
-    
-  uint32_t cb_idx[SRSLTE_TDEC_MAX_NPAR];
-  int16_t *decoder_input[SRSLTE_TDEC_MAX_NPAR];
-  
-  uint32_t nof_cb     = cb_size_group?cb_segm->C2:cb_segm->C1;
-  uint32_t first_cb   = cb_size_group?cb_segm->C1:0;
-  uint32_t cb_len     = cb_size_group?cb_segm->K2:cb_segm->K1;
-  uint32_t cb_len_idx = cb_size_group?cb_segm->K2_idx:cb_segm->K1_idx;
-
-  uint32_t rlen       = cb_segm->C==1?cb_len:(cb_len-24);
-  uint32_t Gp         = nof_e_bits / Qm;
-  uint32_t gamma      = cb_segm->C>0?Gp%cb_segm->C:Gp;
-  uint32_t n_e        = Qm * (Gp/cb_segm->C);
-  
-  if (nof_cb > SRSLTE_MAX_CODEBLOCKS) {
-    fprintf(stderr, "Error SRSLTE_MAX_CODEBLOCKS=%d\n", SRSLTE_MAX_CODEBLOCKS);
-    return false; 
+  if (r < cb_segm->C - gamma) {
+    *n_e = n_e1;
+    return r * n_e1;
+  } else {
+    *n_e = n_e1 + Qm;
+    return (cb_segm->C - gamma) * n_e1 + (r - (cb_segm->C - gamma)) * (*n_e);
   }
-  
-  for (int i=0;i<srslte_tdec_get_nof_parallel(&q->decoder);i++) {
-    cb_idx[i]        = i+first_cb; 
-    decoder_input[i] = NULL;
+}
+
+/* Claims the next code block that still needs decoding. Returns -1 if there is none left */
+static int sch_job_next_cb(sch_job_t *job, srslte_sch_pool_t *pool)
+{
+  int cb = -1;
+
+  if (pool) {
+    pthread_mutex_lock(&pool->mutex);
   }
-  
-  uint32_t remaining_cb = 0;
-  for (int i=0;i<nof_cb;i++) {
+  while (cb < 0 && job->next_cb < job->nof_cb) {
+    uint32_t i = job->first_cb + job->next_cb++;
     /* Do not process blocks with CRC Ok */
-    cb_map[i] = softbuffer->cb_crc[i];
-    if (softbuffer->cb_crc[i] == false) {
-      remaining_cb ++;
+    if (!job->softbuffer->cb_crc[i]) {
+      cb = (int) i;
     }
   }
-    
-  srslte_tdec_reset(&q->decoder, cb_len);
-  
-  q->nof_iterations = 0;
+  if (pool) {
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  return cb;
+}
 
-  while(remaining_cb>0) {
-        
-    // Unratematch the codeblocks left to decode 
-    for (int i=0;i<srslte_tdec_get_nof_parallel(&q->decoder);i++) {
-      
-      if (!decoder_input[i] && remaining_cb > 0) {        
-        // Find an unprocessed CB 
-        cb_idx[i]=first_cb;
-        while(cb_idx[i]<first_cb+nof_cb-1 && cb_map[cb_idx[i]]) {
-          cb_idx[i]++;
-        }
-        if (cb_map[cb_idx[i]] == false) {
-          cb_map[cb_idx[i]] = true; 
-          
-          uint32_t rp   = cb_idx[i]*n_e;  
-          uint32_t n_e2 = n_e;
-          
-          if (cb_idx[i] > cb_segm->C - gamma) {
-            n_e2 = n_e+Qm;
-            rp   = (cb_segm->C - gamma)*n_e + (cb_idx[i]-(cb_segm->C - gamma))*n_e2;
-          }
+/* Decodes code blocks of the job with the decoder of q until none is left to claim. Every
+ * participant, the caller or a pool thread, runs this with its own srslte_sch_t. 8-bit code blocks
+ * are stored in the first half of their 16-bit soft buffer, unless it comes from an 8-bit pool.
+ */
+static void sch_job_run(srslte_sch_t *q, sch_job_t *job, srslte_sch_pool_t *pool)
+{
+  uint32_t cb_idx[SRSLTE_TDEC_MAX_NPAR];
+  int16_t *decoder_input[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+  int8_t *decoder_input_b[SRSLTE_TDEC_MAX_NPAR] = {NULL};
+
+  srslte_softbuffer_rx_t *softbuffer = job->softbuffer;
+  srslte_cbsegm_t *cb_segm = job->cb_segm;
+
+  uint32_t nof_par        = 0;
+  uint32_t rlen           = cb_segm->C==1?job->cb_len:(job->cb_len-24);
+  uint32_t nof_active     = 0;
+  uint32_t nof_iterations = 0;
+  bool     more_cb        = true;
+  bool     error          = false;
+
+  // Pool threads decode with a decoder of the same kind as the caller's
+  if (q->llr_8bit != job->llr_8bit) {
+    fprintf(stderr, "Error decoding code blocks: %d-bit job on a %d-bit decoder\n",
+            job->llr_8bit?8:16, q->llr_8bit?8:16);
+    more_cb = false;
+    error   = true;
+  } else {
+    nof_par = srslte_tdec_get_nof_parallel(&q->decoder);
+    srslte_tdec_reset(&q->decoder, job->cb_len);
+  }
 
-          INFO("CB %d: rp=%d, n_e=%d, i=%d\n", cb_idx[i], rp, n_e2, i);
-          if (srslte_rm_turbo_rx_lut(&e_bits[rp], softbuffer->buffer_f[cb_idx[i]], n_e2, cb_len_idx, rv)) {
+  do {
+    // Unratematch the next codeblocks into the free decoder lanes
+    for (uint32_t i=0;i<nof_par && more_cb;i++) {
+      if (!decoder_input[i]) {
+        int cb = sch_job_next_cb(job, pool);
+        if (cb < 0) {
+          more_cb = false;
+        } else {
+          uint32_t n_e;
+          uint32_t rp = cb_e_offset(cb_segm, job->Qm, job->nof_e_bits, (uint32_t) cb, &n_e);
+
+          INFO("CB %d: rp=%d, n_e=%d, i=%d\n", cb, rp, n_e, i);
+          int16_t *w_buff = srslte_softbuffer_rx_get_cb(softbuffer, (uint32_t) cb, 3*job->cb_len+12);
+          int ret;
+          if (!w_buff) {
+            ret = SRSLTE_ERROR;
+          } else if (job->e_bits_b) {
+            ret = srslte_rm_turbo_rx_lut_8bit(&job->e_bits_b[rp], (int8_t*) w_buff, n_e, job->cb_len_idx, job->rv);
+          } else {
+            ret = srslte_rm_turbo_rx_lut(&job->e_bits[rp], w_buff, n_e, job->cb_len_idx, job->rv);
+          }
+          if (ret) {
             fprintf(stderr, "Error in rate matching\n");
-            return SRSLTE_ERROR;
+            error = true;
+          } else {
+            cb_idx[i]          = (uint32_t) cb;
+            decoder_input[i]   = w_buff;
+            decoder_input_b[i] = (int8_t*) w_buff;
+            nof_active++;
           }
-
-          decoder_input[i] = softbuffer->buffer_f[cb_idx[i]];
         }
       }
     }
-        
+
+    if (nof_active == 0) {
+      continue;
+    }
+
     // Run 1 iteration for the codeblocks in queue
-    srslte_tdec_iteration_par(&q->decoder, decoder_input, cb_len);
+    if (job->e_bits_b) {
+      srslte_tdec_iteration_par_8bit(&q->decoder, decoder_input_b, job->cb_len);
+    } else {
+      srslte_tdec_iteration_par(&q->decoder, decoder_input, job->cb_len);
+    }
 
-    // Decide output bits and compute CRC 
-    for (int i=0;i<srslte_tdec_get_nof_parallel(&q->decoder);i++) {
-      if (decoder_input[i]) {        
-        srslte_tdec_decision_byte_par_cb(&q->decoder, q->cb_in, i, cb_len);
+    // Decide output bits and compute CRC
+    for (uint32_t i=0;i<nof_par;i++) {
+      if (decoder_input[i]) {
+        srslte_tdec_decision_byte_par_cb(&q->decoder, q->cb_in, i, job->cb_len);
+
+        uint32_t len_crc;
+        srslte_crc_t *crc_ptr;
 
-        uint32_t len_crc; 
-        srslte_crc_t *crc_ptr; 
-        
         if (cb_segm->C > 1) {
-          len_crc = cb_len; 
-          crc_ptr = &q->crc_cb; 
+          len_crc = job->cb_len;
+          crc_ptr = &q->crc_cb;
         } else {
-          len_crc = cb_segm->tbs+24; 
-          crc_ptr = &q->crc_tb; 
+          len_crc = cb_segm->tbs+24;
+          crc_ptr = &q->crc_tb;
         }
 
         // CRC is OK
@@ -407,43 +505,207 @@ bool decode_tb_cb(srslte_sch_t *q,
           memcpy(softbuffer->data[cb_idx[i]], q->cb_in, rlen/8 * sizeof(uint8_t));
           softbuffer->cb_crc[cb_idx[i]] = true;
 
-          q->nof_iterations += srslte_tdec_get_nof_iterations_cb(&q->decoder, i);
+          nof_iterations += srslte_tdec_get_nof_iterations_cb(&q->decoder, i);
 
-          // Reset number of iterations for that CB in the decoder 
+          // Reset number of iterations for that CB in the decoder
           srslte_tdec_reset_cb(&q->decoder, i);
-          remaining_cb--;        
-          decoder_input[i] = NULL; 
-          cb_idx[i] = 0; 
+          nof_active--;
+          decoder_input[i]   = NULL;
+          decoder_input_b[i] = NULL;
 
-        // CRC is error and exceeded maximum iterations for this CB.
-        // Early stop the whole transport block.
-        } else if (srslte_tdec_get_nof_iterations_cb(&q->decoder, i) >= q->max_iterations) {
-          INFO("CB %d: Error. CB is erroneous. remaining_cb=%d, i=%d, first_cb=%d, nof_cb=%d\n", 
-                cb_idx[i], remaining_cb, i, first_cb, nof_cb);
+          // Its soft bits will not be combined again
+          srslte_softbuffer_rx_release_cb(softbuffer, cb_idx[i]);
 
-          q->nof_iterations += q->max_iterations;
+        // CRC is error and exceeded maximum iterations for this CB or its decisions are stable.
+        } else if (srslte_tdec_get_nof_iterations_cb(&q->decoder, i) >= job->max_iterations ||
+                   (job->early_stop && 
+                    srslte_tdec_check_converged_cb(&q->decoder, i, q->cb_in, job->cb_len))) {
+          INFO("CB %d: Error. CB is erroneous. i=%d, first_cb=%d, nof_cb=%d\n",
+                cb_idx[i], i, job->first_cb, job->nof_cb);
+
+          nof_iterations += srslte_tdec_get_nof_iterations_cb(&q->decoder, i);
           srslte_tdec_reset_cb(&q->decoder, i);
-          remaining_cb--;
-          decoder_input[i] = NULL;
-          cb_idx[i] = 0;
+          nof_active--;
+          decoder_input[i]   = NULL;
+          decoder_input_b[i] = NULL;
         }
       }
-    }    
+    }
+  } while (nof_active > 0 || more_cb);
+
+  if (pool) {
+    pthread_mutex_lock(&pool->mutex);
   }
+  job->nof_iterations += nof_iterations;
+  job->error |= error;
+  if (pool) {
+    pthread_mutex_unlock(&pool->mutex);
+  }
+}
 
-  softbuffer->tb_crc = true;
-  for (int i = 0; i < nof_cb && softbuffer->tb_crc; i++) {
-    /* If one CB failed return false */
-    softbuffer->tb_crc = softbuffer->cb_crc[i];
+/* Decodes all code blocks of the job. If q has a pool and there are more code blocks than decoder
+ * lanes, idle pool threads join in and are waited for before returning.
+ */
+static void sch_job_decode(srslte_sch_t *q, sch_job_t *job)
+{
+  srslte_sch_pool_t *pool = q->pool;
+
+  if (pool && job->nof_cb > srslte_tdec_get_nof_parallel(&q->decoder)) {
+    pthread_mutex_lock(&pool->mutex);
+    sch_job_t **tail = (sch_job_t **) &pool->jobs;
+    while (*tail) {
+      tail = &(*tail)->next;
+    }
+    job->next = NULL;
+    *tail = job;
+    pthread_cond_broadcast(&pool->cvar_job);
+    pthread_mutex_unlock(&pool->mutex);
+
+    sch_job_run(q, job, pool);
+
+    // No new helper can pick the job once it is unlinked, wait for the ones still decoding
+    pthread_mutex_lock(&pool->mutex);
+    sch_job_t **j = (sch_job_t **) &pool->jobs;
+    while (*j != job) {
+      j = &(*j)->next;
+    }
+    *j = job->next;
+    while (job->nof_helpers > 0) {
+      pthread_cond_wait(&pool->cvar_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  } else {
+    sch_job_run(q, job, NULL);
   }
-  if (softbuffer->tb_crc) {
-    for (int i = 0; i < nof_cb; i++) {
-      memcpy(&data[i * rlen / 8], softbuffer->data[i], rlen/8 * sizeof(uint8_t));
+}
+
+static void *sch_pool_thread(void *arg)
+{
+  srslte_sch_t *q = (srslte_sch_t *) arg;
+  srslte_sch_pool_t *pool = q->pool;
+  srslte_sch_t *q_8bit = pool->sch_8bit?&pool->sch_8bit[q - pool->sch]:NULL;
+
+  pthread_mutex_lock(&pool->mutex);
+  while (!pool->quit) {
+    sch_job_t *job = (sch_job_t *) pool->jobs;
+    while (job && job->next_cb >= job->nof_cb) {
+      job = job->next;
+    }
+    if (job) {
+      job->nof_helpers++;
+      pthread_mutex_unlock(&pool->mutex);
+
+      sch_job_run(job->llr_8bit && q_8bit?q_8bit:q, job, pool);
+
+      pthread_mutex_lock(&pool->mutex);
+      job->nof_helpers--;
+      if (job->nof_helpers == 0) {
+        pthread_cond_broadcast(&pool->cvar_done);
+      }
+    } else {
+      pthread_cond_wait(&pool->cvar_job, &pool->mutex);
     }
   }
+  pthread_mutex_unlock(&pool->mutex);
 
-  q->nof_iterations /= nof_cb;
-  return softbuffer->tb_crc;
+  return NULL;
+}
+
+int srslte_sch_pool_init(srslte_sch_pool_t *pool, uint32_t nof_threads)
+{
+  return srslte_sch_pool_init_threads(pool, nof_threads, NULL, NULL);
+}
+
+/* Threads are created with thread_create, or with default attributes if it is NULL */
+int srslte_sch_pool_init_threads(srslte_sch_pool_t *pool, uint32_t nof_threads,
+                                 srslte_sch_pool_thread_create_t thread_create, void *ctx)
+{
+  int ret = SRSLTE_ERROR_INVALID_INPUTS;
+
+  if (pool && nof_threads > 0) {
+    ret = SRSLTE_ERROR;
+    bzero(pool, sizeof(srslte_sch_pool_t));
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cvar_job, NULL);
+    pthread_cond_init(&pool->cvar_done, NULL);
+
+    bool has_8bit = srslte_tdec_impl_available(SRSLTE_TDEC_AVX8) || srslte_tdec_impl_available(SRSLTE_TDEC_SSE8);
+
+    pool->sch = calloc(nof_threads, sizeof(srslte_sch_t));
+    pool->sch_8bit = has_8bit?calloc(nof_threads, sizeof(srslte_sch_t)):NULL;
+    pool->threads = calloc(nof_threads, sizeof(pthread_t));
+    if (!pool->sch || (has_8bit && !pool->sch_8bit) || !pool->threads) {
+      perror("calloc");
+      goto clean;
+    }
+
+    for (uint32_t i=0;i<nof_threads;i++) {
+      if (srslte_sch_init(&pool->sch[i])) {
+        fprintf(stderr, "Error initiating FEC pool decoder\n");
+        goto clean;
+      }
+      if (has_8bit && (srslte_sch_init(&pool->sch_8bit[i]) || srslte_sch_set_llr_8bit(&pool->sch_8bit[i], true))) {
+        fprintf(stderr, "Error initiating FEC pool decoder\n");
+        srslte_sch_free(&pool->sch[i]);
+        srslte_sch_free(&pool->sch_8bit[i]);
+        goto clean;
+      }
+      // Pool threads reach the pool through their decoder
+      pool->sch[i].pool = pool;
+      bool created = thread_create?thread_create(&pool->threads[i], sch_pool_thread, &pool->sch[i], ctx):
+                                   !pthread_create(&pool->threads[i], NULL, sch_pool_thread, &pool->sch[i]);
+      if (!created) {
+        fprintf(stderr, "Error creating FEC pool thread\n");
+        srslte_sch_free(&pool->sch[i]);
+        if (has_8bit) {
+          srslte_sch_free(&pool->sch_8bit[i]);
+        }
+        goto clean;
+      }
+      pool->nof_threads++;
+    }
+    ret = SRSLTE_SUCCESS;
+  }
+clean:
+  if (ret == SRSLTE_ERROR) {
+    srslte_sch_pool_free(pool);
+  }
+  return ret;
+}
+
+void srslte_sch_pool_free(srslte_sch_pool_t *pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+  pool->quit = true;
+  pthread_cond_broadcast(&pool->cvar_job);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (uint32_t i=0;i<pool->nof_threads;i++) {
+    pthread_join(pool->threads[i], NULL);
+    srslte_sch_free(&pool->sch[i]);
+    if (pool->sch_8bit) {
+      srslte_sch_free(&pool->sch_8bit[i]);
+    }
+  }
+  if (pool->sch) {
+    free(pool->sch);
+  }
+  if (pool->sch_8bit) {
+    free(pool->sch_8bit);
+  }
+  if (pool->threads) {
+    free(pool->threads);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->cvar_job);
+  pthread_cond_destroy(&pool->cvar_done);
+  bzero(pool, sizeof(srslte_sch_pool_t));
+}
+
+void srslte_sch_set_pool(srslte_sch_t *q, srslte_sch_pool_t *pool)
+{
+  q->pool = pool;
 }
 
 /**
@@ -462,13 +724,13 @@ bool decode_tb_cb(srslte_sch_t *q,
 static int decode_tb(srslte_sch_t *q, 
                      srslte_softbuffer_rx_t *softbuffer, srslte_cbsegm_t *cb_segm, 
                      uint32_t Qm, uint32_t rv, uint32_t nof_e_bits, 
-                     int16_t *e_bits, uint8_t *data) 
+                     int16_t *e_bits, int8_t *e_bits_b, uint8_t *data) 
 {
   
   if (q            != NULL && 
       data         != NULL &&       
       softbuffer   != NULL &&
-      e_bits       != NULL &&
+      (e_bits != NULL || e_bits_b != NULL) &&
       cb_segm      != NULL)
   {
     
@@ -485,23 +747,68 @@ static int decode_tb(srslte_sch_t *q,
       fprintf(stderr, "Error number of CB (%d) exceeds soft buffer size (%d CBs)\n", cb_segm->C, softbuffer->max_cb);
       return SRSLTE_ERROR_INVALID_INPUTS;
     }
+
+    if (srslte_softbuffer_rx_is_8bit(softbuffer) && !e_bits_b) {
+      fprintf(stderr, "Error 8-bit soft buffers need 8-bit LLRs\n");
+      return SRSLTE_ERROR_INVALID_INPUTS;
+    }
         
     bool crc_ok = true; 
-    
-    uint32_t nof_cb_groups = cb_segm->C2>0?2:1; 
+    uint32_t nof_iterations = 0;
     
     data[cb_segm->tbs/8+0] = 0; 
     data[cb_segm->tbs/8+1] = 0; 
     data[cb_segm->tbs/8+2] = 0; 
     
-    // Process Codeblocks in groups of equal CB size to parallelize according to SRSLTE_TDEC_MAX_NPAR
-    for (uint32_t i=0;i<nof_cb_groups && crc_ok;i++) {
-      crc_ok = decode_tb_cb(q, softbuffer, cb_segm, Qm, rv, nof_e_bits, e_bits, data, i);            
+    // Process Codeblocks in groups of equal CB size, the C2 shorter ones come first as in encode_tb_off()
+    for (uint32_t i=0;i<2 && crc_ok;i++) {
+      sch_job_t job;
+      bzero(&job, sizeof(sch_job_t));
+
+      job.softbuffer     = softbuffer;
+      job.cb_segm        = cb_segm;
+      job.Qm             = Qm;
+      job.rv             = rv;
+      job.nof_e_bits     = nof_e_bits;
+      job.e_bits         = e_bits;
+      job.e_bits_b       = e_bits_b;
+      job.max_iterations = q->max_iterations;
+      job.early_stop     = q->decoder.early_stop;
+      job.llr_8bit       = q->llr_8bit;
+      job.first_cb       = i?cb_segm->C2:0;
+      job.nof_cb         = i?cb_segm->C1:cb_segm->C2;
+      job.cb_len         = i?cb_segm->K1:cb_segm->K2;
+      job.cb_len_idx     = i?cb_segm->K1_idx:cb_segm->K2_idx;
+
+      if (job.nof_cb > 0) {
+        sch_job_decode(q, &job);
+
+        nof_iterations += job.nof_iterations;
+        crc_ok = !job.error;
+        for (uint32_t cb = job.first_cb; cb < job.first_cb + job.nof_cb && crc_ok; cb++) {
+          /* If one CB failed return false */
+          crc_ok = softbuffer->cb_crc[cb];
+        }
+      }
     }
+
+    q->nof_iterations  = nof_iterations / cb_segm->C;
+    softbuffer->tb_crc = crc_ok;
     
     if (crc_ok) {
 
       uint32_t par_rx = 0, par_tx = 0;
+
+      // Join the code blocks of the transport block
+      uint32_t wp = 0;
+      for (uint32_t i = 0; i < cb_segm->C; i++) {
+        uint32_t rlen = i < cb_segm->C2?cb_segm->K2:cb_segm->K1;
+        if (cb_segm->C > 1) {
+          rlen -= 24;
+        }
+        memcpy(&data[wp / 8], softbuffer->data[i], rlen/8 * sizeof(uint8_t));
+        wp += rlen;
+      }
   
       // Compute transport block CRC
       par_rx = srslte_crc_checksum_byte(&q->crc_tb, data, cb_segm->tbs);
@@ -542,7 +849,25 @@ int srslte_dlsch_decode2(srslte_sch_t *q, srslte_pdsch_cfg_t *cfg, srslte_softbu
 
   return decode_tb(q, softbuffer, &cfg->cb_segm[tb_idx],
                    cfg->grant.Qm[tb_idx] * Nl, cfg->rv[tb_idx], cfg->nbits[tb_idx].nof_bits,
-                   e_bits, data);
+                   e_bits, NULL, data);
+}
+
+/* Same as srslte_dlsch_decode2() with 8-bit LLRs, needs srslte_sch_set_llr_8bit() */
+int srslte_dlsch_decode2_8bit(srslte_sch_t *q, srslte_pdsch_cfg_t *cfg, srslte_softbuffer_rx_t *softbuffer,
+                              int8_t *e_bits, uint8_t *data, int tb_idx) {
+  uint32_t Nl = 1;
+
+  if (!q->llr_8bit) {
+    fprintf(stderr, "8-bit LLRs are not enabled\n");
+    return SRSLTE_ERROR;
+  }
+  if (cfg->nof_layers != SRSLTE_RA_DL_GRANT_NOF_TB(&cfg->grant)) {
+    Nl = 2;
+  }
+
+  return decode_tb(q, softbuffer, &cfg->cb_segm[tb_idx],
+                   cfg->grant.Qm[tb_idx] * Nl, cfg->rv[tb_idx], cfg->nbits[tb_idx].nof_bits,
+                   NULL, e_bits, data);
 }
 
 /**
@@ -741,7 +1066,7 @@ int srslte_ulsch_uci_decode(srslte_sch_t *q, srslte_pusch_cfg_t *cfg, srslte_sof
     uint32_t G = nb_q/Qm - Q_prime_ri - Q_prime_cqi;     
     ret = decode_tb(q, softbuffer, &cfg->cb_segm, 
                    Qm, cfg->rv, G*Qm, 
-                   &g_bits[e_offset], data);
+                   &g_bits[e_offset], NULL, data);
     if (ret) {
       return ret; 
     }
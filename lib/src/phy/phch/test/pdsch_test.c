@@ -61,11 +61,16 @@ uint16_t rnti = 1234;
 uint32_t nof_rx_antennas = 1;
 bool tb_cw_swap = false;
 bool enable_coworker = false;
+uint32_t nof_fec_threads = 0;
+bool llr_8bit = false;
+bool use_softbuffer_pool = false;
+uint32_t nof_bler_frames = 0;
+float snr_min = 0.0f, snr_max = 10.0f;
 uint32_t pmi = 0;
 char *input_file = NULL; 
 
 void usage(char *prog) {
-  printf("Usage: %s [fmMcsrtRFpnwav] \n", prog);
+  printf("Usage: %s [fmMcsrtRFpnwavjPBGEST] \n", prog);
   printf("\t-f read signal from file [Default generate it with pdsch_encode()]\n");
   printf("\t-m MCS [Default %d]\n", mcs[0]);
   printf("\t-M MCS2 [Default %d]\n", mcs[1]);
@@ -81,12 +86,18 @@ void usage(char *prog) {
   printf("\t-p pmi (multiplex only)  [Default %d]\n", pmi);
   printf("\t-w Swap Transport Blocks\n");
   printf("\t-j Enable PDSCH decoder coworker\n");
+  printf("\t-P Number of shared FEC pool threads [Default %d]\n", nof_fec_threads);
+  printf("\t-B Decode with 8-bit LLRs\n");
+  printf("\t-G Take code block soft buffers from a pool, 8-bit ones with -B\n");
+  printf("\t-E Compare BLER and throughput of 16 and 8-bit LLRs over this many subframes per SNR [Default %d]\n", nof_bler_frames);
+  printf("\t-S Lowest SNR of the comparison in dB [Default %.1f]\n", snr_min);
+  printf("\t-T Highest SNR of the comparison in dB [Default %.1f]\n", snr_max);
   printf("\t-v [set srslte_verbose to debug, default none]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "fmMcsrtRFpnawvxj")) != -1) {
+  while ((opt = getopt(argc, argv, "fmMcsrtRFpnawvxjPBGEST")) != -1) {
     switch(opt) {
     case 'f':
       input_file = argv[optind];
@@ -134,6 +145,24 @@ void parse_args(int argc, char **argv) {
     case 'j':
       enable_coworker = true;
       break;
+    case 'P':
+      nof_fec_threads = (uint32_t) atoi(argv[optind]);
+      break;
+    case 'B':
+      llr_8bit = true;
+      break;
+    case 'G':
+      use_softbuffer_pool = true;
+      break;
+    case 'E':
+      nof_bler_frames = (uint32_t) atoi(argv[optind]);
+      break;
+    case 'S':
+      snr_min = (float) atof(argv[optind]);
+      break;
+    case 'T':
+      snr_max = (float) atof(argv[optind]);
+      break;
     case 'v':
       srslte_verbose++;
       break;
@@ -158,9 +187,91 @@ cf_t *rx_sf_symbols[SRSLTE_MAX_PORTS];
 cf_t *tx_slot_symbols[SRSLTE_MAX_PORTS];
 cf_t *rx_slot_symbols[SRSLTE_MAX_PORTS];
 srslte_pdsch_t pdsch_tx, pdsch_rx;
+srslte_sch_pool_t sch_pool;
+srslte_softbuffer_pool_t softbuffer_pool;
 srslte_ofdm_t ofdm_tx[SRSLTE_MAX_PORTS], ofdm_rx[SRSLTE_MAX_PORTS];
 srslte_chest_dl_t chest_dl;
 
+/* Decodes nof_bler_frames noisy copies of the received subframe at each SNR, first with 16-bit and
+ * then with 8-bit LLRs, and prints the transport block error rate and the decoding throughput.
+ * Both LLR widths see the same noise */
+static int bler_sweep(void) {
+  int ret = SRSLTE_ERROR;
+  cf_t *rx_noisy[SRSLTE_MAX_PORTS] = {NULL};
+  bool acks[SRSLTE_MAX_CODEWORDS];
+  uint32_t sf_len = SRSLTE_SF_LEN_RE(cell.nof_prb, cell.cp);
+  struct timeval t[3];
+
+  for (uint32_t i = 0; i < nof_rx_antennas; i++) {
+    rx_noisy[i] = srslte_vec_malloc(sizeof(cf_t) * sf_len);
+    if (!rx_noisy[i]) {
+      perror("srslte_vec_malloc");
+      goto clean;
+    }
+  }
+
+  // Average power of the PDSCH resource elements
+  float signal_power = srslte_vec_avg_power_cf(rx_slot_symbols[0], sf_len) * sf_len / pdsch_cfg.nbits[0].nof_re;
+
+  printf("   SNR  LLR      BLER   Mbps\n");
+  for (float snr = snr_min; snr <= snr_max; snr += 0.5f) {
+    float std_dev = sqrtf(signal_power / (2 * powf(10.0f, snr / 10.0f)));
+
+    for (int b = 0; b < 2; b++) {
+      // 8-bit pooled soft buffers only take 8-bit LLRs
+      if (use_softbuffer_pool && softbuffer_pool.int8 != (b == 1)) {
+        continue;
+      }
+      if (srslte_pdsch_set_llr_8bit(&pdsch_rx, b == 1)) {
+        continue;
+      }
+      uint32_t nof_tb = 0, nof_errors = 0, nof_tb_bits = 0;
+      long usec = 0;
+
+      srand(0);
+      for (uint32_t f = 0; f < nof_bler_frames; f++) {
+        for (uint32_t i = 0; i < nof_rx_antennas; i++) {
+          srslte_ch_awgn_c(rx_slot_symbols[i], rx_noisy[i], std_dev, sf_len);
+        }
+        for (uint32_t i = 0; i < SRSLTE_MAX_CODEWORDS; i++) {
+          if (grant.tb_en[i]) {
+            srslte_softbuffer_rx_reset_tbs(softbuffers_rx[i], (uint32_t) grant.mcs[i].tbs);
+          }
+        }
+        bzero(acks, sizeof(acks));
+
+        gettimeofday(&t[1], NULL);
+        if (srslte_pdsch_decode(&pdsch_rx, &pdsch_cfg, softbuffers_rx, rx_noisy, ce, 0, rnti, data_rx, acks)) {
+          ERROR("Error decoding PDSCH");
+          goto clean;
+        }
+        gettimeofday(&t[2], NULL);
+        get_time_interval(t);
+        usec += t[0].tv_sec * 1000000 + t[0].tv_usec;
+
+        for (uint32_t i = 0; i < SRSLTE_MAX_CODEWORDS; i++) {
+          if (grant.tb_en[i]) {
+            nof_tb++;
+            nof_errors += acks[i] ? 0 : 1;
+            nof_tb_bits += grant.mcs[i].tbs;
+          }
+        }
+      }
+      printf("%6.1f  %s  %8.2e  %5.1f\n", snr, b ? " 8" : "16", (float) nof_errors / nof_tb,
+             usec ? (float) nof_tb_bits / usec : 0.0f);
+    }
+  }
+  ret = srslte_pdsch_set_llr_8bit(&pdsch_rx, llr_8bit);
+
+clean:
+  for (uint32_t i = 0; i < nof_rx_antennas; i++) {
+    if (rx_noisy[i]) {
+      free(rx_noisy[i]);
+    }
+  }
+  return ret;
+}
+
 int main(int argc, char **argv) {
   uint32_t i, j, k;
   int ret = -1;
@@ -174,6 +285,7 @@ int main(int argc, char **argv) {
   /* Initialise to zeros */
   bzero(&pdsch_tx, sizeof(srslte_pdsch_t));
   bzero(&pdsch_rx, sizeof(srslte_pdsch_t));
+  bzero(&sch_pool, sizeof(srslte_sch_pool_t));
   bzero(&pdsch_cfg, sizeof(srslte_pdsch_cfg_t));
   bzero(ce, sizeof(cf_t*)*SRSLTE_MAX_PORTS);
   bzero(ce_dummy, sizeof(cf_t*)*SRSLTE_MAX_PORTS);
@@ -321,6 +433,18 @@ int main(int argc, char **argv) {
 
   srslte_pdsch_set_rnti(&pdsch_rx, rnti);
 
+  if (llr_8bit && srslte_pdsch_set_llr_8bit(&pdsch_rx, true)) {
+    printf("8-bit LLRs are not available, decoding with 16-bit LLRs\n");
+    llr_8bit = false;
+  }
+
+  if (use_softbuffer_pool) {
+    if (srslte_softbuffer_pool_init(&softbuffer_pool, cell.nof_prb, SRSLTE_MAX_CODEWORDS, llr_8bit)) {
+      fprintf(stderr, "Error initiating soft buffer pool\n");
+      goto quit;
+    }
+  }
+
   for (i = 0; i < SRSLTE_MAX_CODEWORDS; i++) {
     softbuffers_rx[i] = calloc(sizeof(srslte_softbuffer_rx_t), 1);
     if (!softbuffers_rx[i]) {
@@ -328,7 +452,12 @@ int main(int argc, char **argv) {
       goto quit;
     }
 
-    if (srslte_softbuffer_rx_init(softbuffers_rx[i], cell.nof_prb)) {
+    if (use_softbuffer_pool) {
+      if (srslte_softbuffer_rx_init_pool(softbuffers_rx[i], cell.nof_prb, &softbuffer_pool)) {
+        fprintf(stderr, "Error initiating RX soft buffer\n");
+        goto quit;
+      }
+    } else if (srslte_softbuffer_rx_init(softbuffers_rx[i], cell.nof_prb)) {
       fprintf(stderr, "Error initiating RX soft buffer\n");
       goto quit;
     }
@@ -479,6 +608,20 @@ int main(int argc, char **argv) {
     srslte_pdsch_enable_coworker(&pdsch_rx);
   }
 
+  if (nof_fec_threads) {
+    if (srslte_sch_pool_init(&sch_pool, nof_fec_threads)) {
+      ERROR("Error initiating FEC pool");
+      goto quit;
+    }
+    srslte_pdsch_set_sch_pool(&pdsch_rx, &sch_pool);
+
+    /* Pool threads only join transport blocks with more code blocks than the decoder lanes */
+    if (pdsch_cfg.cb_segm[0].C <= srslte_tdec_get_nof_parallel(&pdsch_rx.dl_sch.decoder)) {
+      ERROR("%d code blocks do not reach the FEC pool, use a larger MCS (-m)", pdsch_cfg.cb_segm[0].C);
+      goto quit;
+    }
+  }
+
   gettimeofday(&t[1], NULL);
   for (k = 0; k < M; k++) {
 #ifdef DO_OFDM
@@ -511,6 +654,13 @@ int main(int argc, char **argv) {
     goto quit;
   }
 
+  /* Decoded code blocks give their soft buffer back to the pool */
+  if (use_softbuffer_pool && srslte_softbuffer_pool_nof_used(&softbuffer_pool)) {
+    ERROR("%d code block soft buffers were not given back to the pool", srslte_softbuffer_pool_nof_used(&softbuffer_pool));
+    ret = SRSLTE_ERROR;
+    goto quit;
+  }
+
   /* Check Tx and Rx bytes */
   for (int tb = 0; tb < SRSLTE_MAX_CODEWORDS; tb++) {
     if (grant.tb_en[tb]) {
@@ -526,14 +676,21 @@ int main(int argc, char **argv) {
     }
   }
 
-  /* Check all transport blocks have been decoded OK */
-  for (int tb = 0; tb < SRSLTE_MAX_CODEWORDS; tb++) {
-    if (grant.tb_en[tb]) {
-      ret |= (acks[tb]) ? SRSLTE_SUCCESS : SRSLTE_ERROR;
+  if (nof_bler_frames && !input_file) {
+    if (bler_sweep()) {
+      ret = SRSLTE_ERROR;
+      goto quit;
     }
   }
 
+  /* Check all transport blocks have been decoded OK */
   ret = SRSLTE_SUCCESS;
+  for (int tb = 0; tb < SRSLTE_MAX_CODEWORDS; tb++) {
+    if (grant.tb_en[tb] && !acks[tb]) {
+      ERROR("TB %d CRC failed", tb);
+      ret = SRSLTE_ERROR;
+    }
+  }
 
 quit:
   for (i = 0; i < cell.nof_ports; i++) {
@@ -545,6 +702,9 @@ quit:
   srslte_chest_dl_free(&chest_dl);
   srslte_pdsch_free(&pdsch_tx);
   srslte_pdsch_free(&pdsch_rx);
+  if (sch_pool.nof_threads) {
+    srslte_sch_pool_free(&sch_pool);
+  }
   for (i = 0; i < SRSLTE_MAX_CODEWORDS; i++) {
     srslte_softbuffer_tx_free(softbuffers_tx[i]);
     if (softbuffers_tx[i]) {
@@ -564,6 +724,7 @@ quit:
       free(data_rx[i]);
     }
   }
+  srslte_softbuffer_pool_free(&softbuffer_pool);
 
   for (i=0;i<SRSLTE_MAX_PORTS;i++) {
     for (j = 0; j < SRSLTE_MAX_PORTS; j++) {
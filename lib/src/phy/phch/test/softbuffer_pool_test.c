@@ -0,0 +1,295 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2015 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of the srsLTE library.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/* Decodes multi code block transport blocks into soft buffers taking their code block buffers from
+ * a srslte_softbuffer_pool_t sized for one of them, with 16-bit and 8-bit LLRs.
+ *  - The first transmission (rv 0) of some code blocks is noise. The others pass their CRC and give
+ *    their buffer back to the pool, the failed ones keep it.
+ *  - A second transport block of noise on another soft buffer exhausts the pool.
+ *  - The retransmissions (rv 2) are combined into the partly released soft buffers, and once both
+ *    transport blocks are decoded every code block buffer is back in the pool.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "srslte/srslte.h"
+
+#define LLR_AMP   20
+#define NOISE_AMP 3
+#define MAX_CB    32
+
+uint32_t nof_prb = 50;
+uint32_t tbs_idx = 20;
+uint32_t Qm      = 4;
+
+void usage(char *prog) {
+  printf("Usage: %s [ntmv]\n", prog);
+  printf("\t-n nof_prb of the soft buffers [Default %d]\n", nof_prb);
+  printf("\t-t TBS index, needs more than one code block [Default %d]\n", tbs_idx);
+  printf("\t-m modulation order [Default %d]\n", Qm);
+  printf("\t-v [set srslte_verbose to debug, default none]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ntmv")) != -1) {
+    switch(opt) {
+    case 'n':
+      nof_prb = atoi(argv[optind]);
+      break;
+    case 't':
+      tbs_idx = atoi(argv[optind]);
+      break;
+    case 'm':
+      Qm = atoi(argv[optind]);
+      break;
+    case 'v':
+      srslte_verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FUNCTION__, __LINE__, #cond); return false; } } while (0)
+
+srslte_sch_t sch;
+srslte_pdsch_cfg_t cfg;
+srslte_softbuffer_tx_t softbuffer_tx;
+uint8_t *data_tx, *data_rx, *e_bits[4], *bits;
+int16_t *llr;
+int8_t *llr_b;
+
+/* Position and length of the rate matched bits of code block r, as in 36.212 5.1.4.1.2 with one layer */
+static uint32_t cb_e_range(uint32_t r, uint32_t *n_e) {
+  uint32_t C      = cfg.cb_segm[0].C;
+  uint32_t Gp     = cfg.nbits[0].nof_bits / Qm;
+  uint32_t gamma  = Gp % C;
+  uint32_t n_e1   = Qm * (Gp / C);
+
+  if (r < C - gamma) {
+    *n_e = n_e1;
+    return r * n_e1;
+  } else {
+    *n_e = n_e1 + Qm;
+    return (C - gamma) * n_e1 + (r - (C - gamma)) * (*n_e);
+  }
+}
+
+/* LLRs of the transmission with redundancy version rv, code blocks with noise[r] set are replaced by noise */
+static void make_llr(uint32_t rv, bool *noise) {
+  srslte_bit_unpack_vector(e_bits[rv], bits, cfg.nbits[0].nof_bits);
+  for (uint32_t r = 0; r < cfg.cb_segm[0].C; r++) {
+    uint32_t n_e;
+    uint32_t rp = cb_e_range(r, &n_e);
+    for (uint32_t i = rp; i < rp + n_e; i++) {
+      if (noise && noise[r]) {
+        llr[i] = (int16_t) (rand() % (2 * NOISE_AMP + 1) - NOISE_AMP);
+      } else {
+        llr[i] = bits[i] ? LLR_AMP : -LLR_AMP;
+      }
+      llr_b[i] = (int8_t) llr[i];
+    }
+  }
+}
+
+static int decode(srslte_softbuffer_rx_t *softbuffer, uint32_t rv, bool *noise, bool int8) {
+  cfg.rv[0] = rv;
+  make_llr(rv, noise);
+  if (int8) {
+    return srslte_dlsch_decode2_8bit(&sch, &cfg, softbuffer, llr_b, data_rx, 0);
+  } else {
+    return srslte_dlsch_decode2(&sch, &cfg, softbuffer, llr, data_rx, 0);
+  }
+}
+
+static bool run(bool int8) {
+  srslte_softbuffer_pool_t pool;
+  srslte_softbuffer_rx_t softbuffer[2];
+  bool noise[MAX_CB];
+  bool all_noise[MAX_CB];
+  uint32_t C = cfg.cb_segm[0].C;
+  uint32_t nof_noise = 0;
+
+  CHECK(!srslte_softbuffer_pool_init(&pool, nof_prb, 1, int8));
+  CHECK(C <= pool.max_cb && C <= MAX_CB);
+  for (int i = 0; i < 2; i++) {
+    CHECK(!srslte_softbuffer_rx_init_pool(&softbuffer[i], nof_prb, &pool));
+  }
+
+  // All code blocks of the first transport block but the first fail. The second group of equal size
+  // code blocks is only decoded if the first one passes
+  for (uint32_t r = 0; r < C; r++) {
+    noise[r]     = r >= SRSLTE_MAX(cfg.cb_segm[0].C2, 1);
+    all_noise[r] = true;
+    nof_noise   += noise[r]?1:0;
+  }
+  CHECK(nof_noise > 0 && nof_noise + C > pool.max_cb);
+
+  CHECK(decode(&softbuffer[0], 0, noise, int8) != SRSLTE_SUCCESS);
+  for (uint32_t r = 0; r < C; r++) {
+    CHECK(softbuffer[0].cb_crc[r] == !noise[r]);
+    CHECK((softbuffer[0].buffer_f[r] != NULL) == noise[r]);
+  }
+  CHECK(srslte_softbuffer_pool_nof_used(&pool) == nof_noise);
+
+  // The second one takes what is left in the pool, some of its code blocks find it exhausted
+  CHECK(decode(&softbuffer[1], 0, all_noise, int8) != SRSLTE_SUCCESS);
+  CHECK(srslte_softbuffer_pool_nof_used(&pool) == pool.max_cb);
+  CHECK(pool.nof_free == 0);
+  CHECK(softbuffer[1].buffer_f[C - 1] == NULL);
+
+  // Retransmissions are combined into the code blocks that failed
+  CHECK(decode(&softbuffer[0], 2, NULL, int8) == SRSLTE_SUCCESS);
+  CHECK(!memcmp(data_tx, data_rx, cfg.cb_segm[0].tbs / 8));
+  CHECK(srslte_softbuffer_pool_nof_used(&pool) == pool.max_cb - nof_noise);
+  for (uint32_t r = 0; r < C; r++) {
+    CHECK(softbuffer[0].buffer_f[r] == NULL);
+  }
+
+  bzero(data_rx, cfg.cb_segm[0].tbs / 8);
+  CHECK(decode(&softbuffer[1], 2, NULL, int8) == SRSLTE_SUCCESS);
+  CHECK(!memcmp(data_tx, data_rx, cfg.cb_segm[0].tbs / 8));
+  CHECK(srslte_softbuffer_pool_nof_used(&pool) == 0);
+  CHECK(pool.nof_alloc == pool.max_cb && pool.nof_free == pool.max_cb);
+
+  // A new transport block starts from zeroed buffers, the rv 0 noise is not combined again
+  srslte_softbuffer_rx_reset(&softbuffer[0]);
+  CHECK(decode(&softbuffer[0], 0, NULL, int8) == SRSLTE_SUCCESS);
+  CHECK(srslte_softbuffer_pool_nof_used(&pool) == 0);
+
+  printf("%s: %d code blocks, pool of %d, %d failed in rv 0: OK\n",
+         int8?"8-bit ":"16-bit", C, pool.max_cb, nof_noise);
+
+  for (int i = 0; i < 2; i++) {
+    srslte_softbuffer_rx_free(&softbuffer[i]);
+  }
+  srslte_softbuffer_pool_free(&pool);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int ret = -1;
+  uint32_t nof_bits;
+
+  parse_args(argc, argv);
+  srand(time(NULL));
+
+  bzero(&cfg, sizeof(srslte_pdsch_cfg_t));
+  cfg.grant.tb_en[0] = true;
+  cfg.grant.Qm[0]    = Qm;
+  cfg.nof_layers     = 1;
+  if (srslte_cbsegm(&cfg.cb_segm[0], (uint32_t) srslte_ra_tbs_from_idx(tbs_idx, nof_prb))) {
+    fprintf(stderr, "Error computing code block segmentation\n");
+    exit(-1);
+  }
+  // Code rate 1/2, rv 2 alone decodes
+  nof_bits = 2 * cfg.cb_segm[0].tbs;
+  nof_bits -= nof_bits % (8 * Qm);
+  cfg.nbits[0].nof_bits = nof_bits;
+  cfg.nbits[0].nof_re   = nof_bits / Qm;
+
+  bzero(e_bits, sizeof(e_bits));
+  data_tx = srslte_vec_malloc(cfg.cb_segm[0].tbs / 8 + 3);
+  data_rx = srslte_vec_malloc(cfg.cb_segm[0].tbs / 8 + 3);
+  bits    = srslte_vec_malloc(nof_bits);
+  llr     = srslte_vec_malloc(sizeof(int16_t) * nof_bits);
+  llr_b   = srslte_vec_malloc(sizeof(int8_t) * nof_bits);
+  for (int i = 0; i < 4; i += 2) {
+    e_bits[i] = srslte_vec_malloc(nof_bits / 8);
+  }
+  if (!data_tx || !data_rx || !bits || !llr || !llr_b || !e_bits[0] || !e_bits[2]) {
+    perror("malloc");
+    goto quit;
+  }
+
+  if (srslte_sch_init(&sch)) {
+    fprintf(stderr, "Error initiating SCH\n");
+    goto quit;
+  }
+  if (srslte_softbuffer_tx_init(&softbuffer_tx, nof_prb)) {
+    fprintf(stderr, "Error initiating TX soft buffer\n");
+    goto quit;
+  }
+
+  for (uint32_t i = 0; i < cfg.cb_segm[0].tbs / 8; i++) {
+    data_tx[i] = (uint8_t) rand();
+  }
+  for (uint32_t rv = 0; rv < 4; rv += 2) {
+    cfg.rv[0] = rv;
+    if (srslte_dlsch_encode2(&sch, &cfg, &softbuffer_tx, data_tx, e_bits[rv], 0)) {
+      fprintf(stderr, "Error encoding\n");
+      goto quit;
+    }
+  }
+
+  if (!run(false)) {
+    goto quit;
+  }
+  if (!srslte_tdec_impl_available(SRSLTE_TDEC_AVX8) && !srslte_tdec_impl_available(SRSLTE_TDEC_SSE8)) {
+    printf("8-bit: no 8-bit turbo decoder available, skipped\n");
+  } else if (srslte_sch_set_llr_8bit(&sch, true) || !run(true)) {
+    goto quit;
+  }
+  ret = 0;
+
+quit:
+  srslte_softbuffer_tx_free(&softbuffer_tx);
+  srslte_sch_free(&sch);
+  for (int i = 0; i < 4; i++) {
+    if (e_bits[i]) {
+      free(e_bits[i]);
+    }
+  }
+  if (data_tx) {
+    free(data_tx);
+  }
+  if (data_rx) {
+    free(data_rx);
+  }
+  if (bits) {
+    free(bits);
+  }
+  if (llr) {
+    free(llr);
+  }
+  if (llr_b) {
+    free(llr_b);
+  }
+  if (ret) {
+    printf("Error\n");
+  } else {
+    printf("Ok\n");
+  }
+  exit(ret);
+}
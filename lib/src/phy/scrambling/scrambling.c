@@ -50,6 +50,11 @@ void srslte_scrambling_s_offset(srslte_sequence_t *s, short *data, int offset, i
   srslte_vec_prod_sss(data, &s->c_short[offset], data, len);
 }
 
+void srslte_scrambling_sb_offset(srslte_sequence_t *s, int8_t *data, int offset, int len) {
+  assert (len + offset <= s->cur_len);
+  srslte_vec_neg_bbb(data, (int8_t*) &s->c[offset], data, len);
+}
+
 void srslte_scrambling_c(srslte_sequence_t *s, cf_t *data) {
   srslte_scrambling_c_offset(s, data, 0, s->cur_len);
 }
@@ -981,7 +981,10 @@ void srslte_ue_dl_save_signal(srslte_ue_dl_t *q, srslte_softbuffer_rx_t *softbuf
   for (int i=0;i<q->pdsch_cfg.cb_segm[0].C;i++) {
     char tmpstr[64];
     snprintf(tmpstr,64,"rmout_%d.dat",i);
-    srslte_vec_save_file(tmpstr, softbuffer->buffer_f[i], (3*cb_len+12)*sizeof(int16_t));  
+    // Code blocks from a soft buffer pool are given back once decoded
+    if (softbuffer->buffer_f[i]) {
+      srslte_vec_save_file(tmpstr, softbuffer->buffer_f[i], (3*cb_len+12)*sizeof(int16_t));  
+    }
   }
   printf("Saved files for tti=%d, sf=%d, cfi=%d, mcs=%d, tbs=%d, rv=%d, rnti=0x%x\n", tti, tti%10, cfi,
          q->pdsch_cfg.grant.mcs[0].idx, q->pdsch_cfg.grant.mcs[0].tbs, rv_idx, rnti);
@@ -58,6 +58,15 @@ void srslte_vec_sub_sss(const int16_t *x, const int16_t *y, int16_t *z, const ui
   srslte_vec_sub_sss_simd(x, y, z, len);
 }
 
+void srslte_vec_sub_bbb(const int8_t *x, const int8_t *y, int8_t *z, const uint32_t len) {
+  srslte_vec_sub_bbb_simd(x, y, z, len);
+}
+
+// Used by 8-bit descrambling
+void srslte_vec_neg_bbb(const int8_t *x, const int8_t *y, int8_t *z, const uint32_t len) {
+  srslte_vec_neg_bbb_simd(x, y, z, len);
+}
+
 // Noise estimation in chest_dl, interpolation 
 void srslte_vec_sub_ccc(const cf_t *x, const cf_t *y, cf_t *z, const uint32_t len) {
   return srslte_vec_sub_fff((const float*) x,(const float*) y,(float*) z, 2*len);
@@ -100,6 +109,10 @@ void srslte_vec_convert_fi(const float *x, const float scale, int16_t *z, const
   srslte_vec_convert_fi_simd(x, z, scale, len);
 }
 
+void srslte_vec_convert_sb(const int16_t *x, const int shift, int8_t *z, const uint32_t len) {
+  srslte_vec_convert_sb_simd(x, z, shift, len);
+}
+
 void srslte_vec_lut_sss(const short *x, const unsigned short *lut, short *y, const uint32_t len) {
   srslte_vec_lut_sss_simd(x, lut, y, len);
 }
@@ -110,6 +123,12 @@ void srslte_vec_lut_sis(const short *x, const unsigned int *lut, short *y, const
   }
 }
 
+void srslte_vec_lut_bbb(const int8_t *x, const unsigned short *lut, int8_t *y, const uint32_t len) {
+  for (int i=0; i < len; i++) {
+    y[lut[i]] = x[i];
+  }
+}
+
 void *srslte_vec_malloc(uint32_t size) {
   void *ptr;
   if (posix_memalign(&ptr, SRSLTE_SIMD_BIT_ALIGN, size)) {
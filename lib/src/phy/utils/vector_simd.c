@@ -42,8 +42,8 @@ void srslte_vec_xor_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, const
 #if SRSLTE_SIMD_B_SIZE
   if (SRSLTE_IS_ALIGNED(x) && SRSLTE_IS_ALIGNED(y) && SRSLTE_IS_ALIGNED(z)) {
     for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
-      simd_b_t a = srslte_simd_b_load(&x[i]);
-      simd_b_t b = srslte_simd_b_load(&y[i]);
+      simd_b_t a = srslte_simd_b_load((int8_t*) &x[i]);
+      simd_b_t b = srslte_simd_b_load((int8_t*) &y[i]);
 
       simd_b_t r = srslte_simd_b_xor(a, b);
 
@@ -51,10 +51,10 @@ void srslte_vec_xor_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, const
     }
   } else {
     for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
-      simd_b_t a = srslte_simd_b_loadu(&x[i]);
-      simd_b_t b = srslte_simd_b_loadu(&y[i]);
+      simd_b_t a = srslte_simd_b_loadu((int8_t*) &x[i]);
+      simd_b_t b = srslte_simd_b_loadu((int8_t*) &y[i]);
 
-      simd_s_t r = srslte_simd_b_xor(a, b);
+      simd_b_t r = srslte_simd_b_xor(a, b);
 
       srslte_simd_b_storeu(&z[i], r);
     }
@@ -66,6 +66,65 @@ void srslte_vec_xor_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, const
   }
 }
 
+void srslte_vec_sub_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, const int len) {
+  int i = 0;
+#if SRSLTE_SIMD_B_SIZE
+  if (SRSLTE_IS_ALIGNED(x) && SRSLTE_IS_ALIGNED(y) && SRSLTE_IS_ALIGNED(z)) {
+    for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
+      simd_b_t a = srslte_simd_b_load((int8_t*) &x[i]);
+      simd_b_t b = srslte_simd_b_load((int8_t*) &y[i]);
+
+      simd_b_t r = srslte_simd_b_sub(a, b);
+
+      srslte_simd_b_store(&z[i], r);
+    }
+  } else {
+    for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
+      simd_b_t a = srslte_simd_b_loadu((int8_t*) &x[i]);
+      simd_b_t b = srslte_simd_b_loadu((int8_t*) &y[i]);
+
+      simd_b_t r = srslte_simd_b_sub(a, b);
+
+      srslte_simd_b_storeu(&z[i], r);
+    }
+  }
+#endif /* SRSLTE_SIMD_B_SIZE */
+
+  for(; i < len; i++){
+    int16_t r = (int16_t) x[i] - y[i];
+    z[i] = (int8_t) (r > INT8_MAX ? INT8_MAX : (r < INT8_MIN ? INT8_MIN : r));
+  }
+}
+
+void srslte_vec_neg_bbb_simd(const int8_t *x, const int8_t *y, int8_t *z, const int len) {
+  int i = 0;
+#if SRSLTE_SIMD_B_SIZE
+  if (SRSLTE_IS_ALIGNED(x) && SRSLTE_IS_ALIGNED(y) && SRSLTE_IS_ALIGNED(z)) {
+    for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
+      simd_b_t a = srslte_simd_b_load((int8_t*) &x[i]);
+      simd_b_t b = srslte_simd_b_load((int8_t*) &y[i]);
+
+      simd_b_t r = srslte_simd_b_neg(a, b);
+
+      srslte_simd_b_store(&z[i], r);
+    }
+  } else {
+    for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
+      simd_b_t a = srslte_simd_b_loadu((int8_t*) &x[i]);
+      simd_b_t b = srslte_simd_b_loadu((int8_t*) &y[i]);
+
+      simd_b_t r = srslte_simd_b_neg(a, b);
+
+      srslte_simd_b_storeu(&z[i], r);
+    }
+  }
+#endif /* SRSLTE_SIMD_B_SIZE */
+
+  for(; i < len; i++){
+    z[i] = y[i] ? (x[i] == INT8_MIN ? INT8_MAX : -x[i]) : x[i];
+  }
+}
+
 int srslte_vec_dot_prod_sss_simd(const int16_t *x, const int16_t *y, const int len) {
   int i = 0;
   int result = 0;
@@ -295,6 +354,37 @@ void srslte_vec_convert_fi_simd(const float *x, int16_t *z, const float scale, c
   }
 }
 
+void srslte_vec_convert_sb_simd(const int16_t *x, int8_t *z, const int shift, const int len) {
+  int i = 0;
+
+#if SRSLTE_SIMD_S_SIZE && SRSLTE_SIMD_B_SIZE
+  if (SRSLTE_IS_ALIGNED(x) && SRSLTE_IS_ALIGNED(z)) {
+    for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
+      simd_s_t a = srslte_simd_s_load(&x[i]);
+      simd_s_t b = srslte_simd_s_load(&x[i + SRSLTE_SIMD_S_SIZE]);
+
+      simd_b_t i8 = srslte_simd_convert_2s_b(srslte_simd_s_sra(a, shift), srslte_simd_s_sra(b, shift));
+
+      srslte_simd_b_store(&z[i], i8);
+    }
+  } else {
+    for (; i < len - SRSLTE_SIMD_B_SIZE + 1; i += SRSLTE_SIMD_B_SIZE) {
+      simd_s_t a = srslte_simd_s_loadu(&x[i]);
+      simd_s_t b = srslte_simd_s_loadu(&x[i + SRSLTE_SIMD_S_SIZE]);
+
+      simd_b_t i8 = srslte_simd_convert_2s_b(srslte_simd_s_sra(a, shift), srslte_simd_s_sra(b, shift));
+
+      srslte_simd_b_storeu(&z[i], i8);
+    }
+  }
+#endif /* SRSLTE_SIMD_S_SIZE && SRSLTE_SIMD_B_SIZE */
+
+  for(; i < len; i++){
+    int16_t r = x[i] >> shift;
+    z[i] = (int8_t) (r > INT8_MAX ? INT8_MAX : (r < INT8_MIN ? INT8_MIN : r));
+  }
+}
+
 float srslte_vec_acc_ff_simd(const float *x, const int len) {
   int i = 0;
   float acc_sum = 0.0f;
@@ -35,62 +35,152 @@ namespace srslte {
  * Ref: 3GPP TS 29.281 v10.1.0 Section 5
  ***************************************************************************/
 
+/* The mandatory part of the header is handled as one 64-bit word in memory
+ * order: flags, message type, length and TEID, all big endian on the wire.
+ */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define GTPU_HDR_PACK(flags, type, len, teid) \
+  ((uint64_t) (flags) | (uint64_t) (type) << 8 | (uint64_t) __builtin_bswap16(len) << 16 | (uint64_t) __builtin_bswap32(teid) << 32)
+#define GTPU_HDR_FLAGS(h)   ((uint8_t) (h))
+#define GTPU_HDR_TYPE(h)    ((uint8_t) ((h) >> 8))
+#define GTPU_HDR_LENGTH(h)  __builtin_bswap16((uint16_t) ((h) >> 16))
+#define GTPU_HDR_TEID(h)    __builtin_bswap32((uint32_t) ((h) >> 32))
+#else
+#define GTPU_HDR_PACK(flags, type, len, teid) \
+  ((uint64_t) (flags) << 56 | (uint64_t) (type) << 48 | (uint64_t) (len) << 32 | (uint64_t) (teid))
+#define GTPU_HDR_FLAGS(h)   ((uint8_t) ((h) >> 56))
+#define GTPU_HDR_TYPE(h)    ((uint8_t) ((h) >> 48))
+#define GTPU_HDR_LENGTH(h)  ((uint16_t) ((h) >> 32))
+#define GTPU_HDR_TEID(h)    ((uint32_t) (h))
+#endif
+
 bool gtpu_write_header(gtpu_header_t *header, srslte::byte_buffer_t *pdu, srslte::log *gtpu_log)
 {
-  if(header->flags != 0x30) {
+  if((header->flags & 0xF0) != (GTPU_FLAGS_VERSION_V1 | GTPU_FLAGS_GTP_PROTOCOL)) {
     gtpu_log->error("gtpu_write_header - Unhandled header flags: 0x%x\n", header->flags);
     return false;
   }
-  if(header->message_type != 0xFF) {
-    gtpu_log->error("gtpu_write_header - Unhandled message type: 0x%x\n", header->message_type);
+  if((header->flags & GTPU_FLAGS_EXTENDED_HDR) && header->next_ext_hdr_type != 0) {
+    gtpu_log->error("gtpu_write_header - Writing extension headers is not supported\n");
     return false;
   }
-  if(pdu->get_headroom() < GTPU_HEADER_LEN) {
+
+  uint32_t opt_len = (header->flags & GTPU_FLAGS_OPTIONAL) ? GTPU_OPT_HEADER_LEN : 0;
+  if(pdu->get_headroom() < GTPU_HEADER_LEN + opt_len) {
     gtpu_log->error("gtpu_write_header - No room in PDU for header\n");
     return false;
   }
+  if(pdu->N_bytes + opt_len > 0xFFFF) {
+    gtpu_log->error("gtpu_write_header - PDU too long: %d bytes\n", pdu->N_bytes);
+    return false;
+  }
+  header->length = pdu->N_bytes + opt_len;
 
-  pdu->msg      -= GTPU_HEADER_LEN;
-  pdu->N_bytes  += GTPU_HEADER_LEN;
-
-  uint8_t *ptr = pdu->msg;
+  pdu->msg      -= GTPU_HEADER_LEN + opt_len;
+  pdu->N_bytes  += GTPU_HEADER_LEN + opt_len;
 
-  *ptr = header->flags;
-  ptr++;
-  *ptr = header->message_type;
-  ptr++;
-  uint16_to_uint8(header->length, ptr);
-  ptr += 2;
-  uint32_to_uint8(header->teid, ptr);
+  uint64_t h = GTPU_HDR_PACK(header->flags, header->message_type, header->length, header->teid);
+  memcpy(pdu->msg, &h, sizeof(h));
 
+  if(opt_len) {
+    uint8_t *ptr = pdu->msg + GTPU_HEADER_LEN;
+    uint16_to_uint8(header->seq_number, ptr);
+    ptr[2] = header->n_pdu;
+    ptr[3] = 0;
+  }
   return true;
 }
 
 bool gtpu_read_header(srslte::byte_buffer_t *pdu, gtpu_header_t *header, srslte::log *gtpu_log)
 {
-  uint8_t *ptr  = pdu->msg;
-
-  pdu->msg      += GTPU_HEADER_LEN;
-  pdu->N_bytes  -= GTPU_HEADER_LEN;
-
-  header->flags         = *ptr;
-  ptr++;
-  header->message_type  = *ptr;
-  ptr++;
-  uint8_to_uint16(ptr, &header->length);
-  ptr += 2;
-  uint8_to_uint32(ptr, &header->teid);
+  if(pdu->N_bytes < GTPU_HEADER_LEN) {
+    gtpu_log->error("gtpu_read_header - PDU too short: %d bytes\n", pdu->N_bytes);
+    return false;
+  }
 
-  if(header->flags != 0x30) {
+  uint8_t *ptr = pdu->msg;
+  uint64_t h;
+  memcpy(&h, ptr, sizeof(h));
+  header->flags             = GTPU_HDR_FLAGS(h);
+  header->message_type      = GTPU_HDR_TYPE(h);
+  header->length            = GTPU_HDR_LENGTH(h);
+  header->teid              = GTPU_HDR_TEID(h);
+  header->seq_number        = 0;
+  header->n_pdu             = 0;
+  header->next_ext_hdr_type = 0;
+
+  if((header->flags & 0xF0) != (GTPU_FLAGS_VERSION_V1 | GTPU_FLAGS_GTP_PROTOCOL)) {
     gtpu_log->error("gtpu_read_header - Unhandled header flags: 0x%x\n", header->flags);
     return false;
   }
-  if(header->message_type != 0xFF) {
-    gtpu_log->error("gtpu_read_header - Unhandled message type: 0x%x\n", header->message_type);
+  if((uint32_t) GTPU_HEADER_LEN + header->length > pdu->N_bytes) {
+    gtpu_log->error("gtpu_read_header - Length field %d exceeds PDU of %d bytes\n", header->length, pdu->N_bytes);
     return false;
   }
+  // Drop anything past the GTP-U message, e.g. link-layer padding
+  pdu->N_bytes = GTPU_HEADER_LEN + header->length;
+
+  uint32_t hdr_len = GTPU_HEADER_LEN;
+  if(header->flags & GTPU_FLAGS_OPTIONAL) {
+    hdr_len += GTPU_OPT_HEADER_LEN;
+    if(hdr_len > pdu->N_bytes) {
+      gtpu_log->error("gtpu_read_header - PDU too short for optional fields\n");
+      return false;
+    }
+    uint8_to_uint16(&ptr[8], &header->seq_number);
+    header->n_pdu = ptr[10];
+
+    // Each extension header is a length in 4-octet units, contents, and the next type
+    if(header->flags & GTPU_FLAGS_EXTENDED_HDR) {
+      header->next_ext_hdr_type = ptr[11];
+      uint8_t next = header->next_ext_hdr_type;
+      while(next != 0) {
+        uint32_t ext_len = hdr_len < pdu->N_bytes ? 4 * ptr[hdr_len] : 0;
+        if(ext_len == 0 || hdr_len + ext_len > pdu->N_bytes) {
+          gtpu_log->error("gtpu_read_header - Malformed extension header 0x%x\n", next);
+          return false;
+        }
+        next     = ptr[hdr_len + ext_len - 1];
+        hdr_len += ext_len;
+      }
+    }
+  }
 
+  pdu->msg      += hdr_len;
+  pdu->N_bytes  -= hdr_len;
   return true;
 }
 
+bool gtpu_write_echo_response(const gtpu_header_t *request, srslte::byte_buffer_t *pdu, srslte::log *gtpu_log)
+{
+  gtpu_header_t header;
+  header.flags             = GTPU_FLAGS_VERSION_V1 | GTPU_FLAGS_GTP_PROTOCOL | GTPU_FLAGS_SEQUENCE;
+  header.message_type      = GTPU_MSG_ECHO_RESPONSE;
+  header.teid              = 0;
+  header.seq_number        = request->seq_number;
+  header.n_pdu             = 0;
+  header.next_ext_hdr_type = 0;
+
+  // Recovery IE, the restart counter is always 0 for GTP-U (TS 29.281 Section 8.2)
+  pdu->reset();
+  pdu->msg[0]  = GTPU_IE_RECOVERY;
+  pdu->msg[1]  = 0;
+  pdu->N_bytes = 2;
+  return gtpu_write_header(&header, pdu, gtpu_log);
+}
+
+bool gtpu_write_echo_request(uint16_t seq_number, srslte::byte_buffer_t *pdu, srslte::log *gtpu_log)
+{
+  gtpu_header_t header;
+  header.flags             = GTPU_FLAGS_VERSION_V1 | GTPU_FLAGS_GTP_PROTOCOL | GTPU_FLAGS_SEQUENCE;
+  header.message_type      = GTPU_MSG_ECHO_REQUEST;
+  header.teid              = 0;
+  header.seq_number        = seq_number;
+  header.n_pdu             = 0;
+  header.next_ext_hdr_type = 0;
+
+  pdu->reset();
+  return gtpu_write_header(&header, pdu, gtpu_log);
+}
+
 } // namespace srslte
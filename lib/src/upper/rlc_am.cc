@@ -1023,7 +1023,7 @@ void rlc_am::handle_data_pdu_segment(uint8_t *payload, uint32_t nof_bytes, rlc_a
   }
 
   rlc_amd_rx_pdu_t segment;
-  segment.buf = pool_allocate;
+  segment.buf = pool_allocate_size(nof_bytes);
   if (!segment.buf) {
 #ifdef RLC_AM_BUFFER_DEBUG
     log->console("Fatal Error: Couldn't allocate PDU in handle_data_pdu_segment().\n");
@@ -0,0 +1,315 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "srslte/asn1/liblte_s1ap.h"
+#include "srslte/asn1/s1ap_lazy.h"
+
+#define NOF_BENCH_ITERATIONS 2000
+
+static uint8_t nas_msg[] = {0x27, 0x1f, 0x9d, 0x3a, 0x62, 0x05, 0x07, 0x53,
+                            0x08, 0x5b, 0x1e, 0x72, 0x05, 0x44, 0xf3, 0xa1,
+                            0x44, 0x0d, 0x50, 0x13};
+
+static void fill_tai_cgi(LIBLTE_S1AP_TAI_STRUCT *tai, LIBLTE_S1AP_EUTRAN_CGI_STRUCT *cgi)
+{
+  uint8_t plmn[3] = {0x00, 0xf1, 0x10};
+  memcpy(tai->pLMNidentity.buffer, plmn, 3);
+  tai->tAC.buffer[0] = 0x00;
+  tai->tAC.buffer[1] = 0x07;
+  memcpy(cgi->pLMNidentity.buffer, plmn, 3);
+  for (uint32_t i = 0; i < LIBLTE_S1AP_CELLIDENTITY_BIT_STRING_LEN; i++) {
+    cgi->cell_ID.buffer[i] = (0x19b01 >> (27 - i)) & 1;
+  }
+}
+
+static void pack(LIBLTE_S1AP_S1AP_PDU_STRUCT *pdu, LIBLTE_BYTE_MSG_STRUCT *msg)
+{
+  assert(liblte_s1ap_pack_s1ap_pdu(pdu, msg) == LIBLTE_SUCCESS);
+}
+
+static void uplink_nas_transport_test(LIBLTE_S1AP_S1AP_PDU_STRUCT *pdu, LIBLTE_S1AP_S1AP_PDU_STRUCT *eager, LIBLTE_BYTE_MSG_STRUCT *msg)
+{
+  bzero(pdu, sizeof(LIBLTE_S1AP_S1AP_PDU_STRUCT));
+  pdu->choice_type = LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE;
+  LIBLTE_S1AP_INITIATINGMESSAGE_STRUCT *init = &pdu->choice.initiatingMessage;
+  init->procedureCode = LIBLTE_S1AP_PROC_ID_UPLINKNASTRANSPORT;
+  init->criticality   = LIBLTE_S1AP_CRITICALITY_IGNORE;
+  init->choice_type   = LIBLTE_S1AP_INITIATINGMESSAGE_CHOICE_UPLINKNASTRANSPORT;
+  LIBLTE_S1AP_MESSAGE_UPLINKNASTRANSPORT_STRUCT *ul = &init->choice.UplinkNASTransport;
+  ul->MME_UE_S1AP_ID.MME_UE_S1AP_ID = 0x10203;
+  ul->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID = 77;
+  ul->NAS_PDU.n_octets = sizeof(nas_msg);
+  memcpy(ul->NAS_PDU.buffer, nas_msg, sizeof(nas_msg));
+  fill_tai_cgi(&ul->TAI, &ul->EUTRAN_CGI);
+  pack(pdu, msg);
+
+  srslte::s1ap_arena    arena;
+  srslte::s1ap_lazy_pdu lazy;
+  assert(lazy.parse(msg->msg, msg->N_bytes, &arena) == LIBLTE_SUCCESS);
+  assert(lazy.get_pdu_type() == LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE);
+  assert(lazy.get_procedure_code() == LIBLTE_S1AP_PROC_ID_UPLINKNASTRANSPORT);
+  assert(lazy.get_nof_ies() == 5);
+
+  assert(liblte_s1ap_unpack_s1ap_pdu(msg, eager) == LIBLTE_SUCCESS);
+  LIBLTE_S1AP_MESSAGE_UPLINKNASTRANSPORT_STRUCT *ref = &eager->choice.initiatingMessage.choice.UplinkNASTransport;
+
+  const LIBLTE_S1AP_MME_UE_S1AP_ID_STRUCT *mme_id = lazy.get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id);
+  const LIBLTE_S1AP_ENB_UE_S1AP_ID_STRUCT *enb_id = lazy.get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id);
+  assert(mme_id && mme_id->MME_UE_S1AP_ID == ref->MME_UE_S1AP_ID.MME_UE_S1AP_ID);
+  assert(enb_id && enb_id->ENB_UE_S1AP_ID == ref->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID);
+  // Decoded once, then served from the arena
+  assert(lazy.get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id) == mme_id);
+
+  const uint8_t *nas;
+  uint32_t nas_len;
+  assert(lazy.get_octet_string(LIBLTE_S1AP_IE_ID_NAS_PDU, &nas, &nas_len));
+  assert(nas_len == ref->NAS_PDU.n_octets && !memcmp(nas, ref->NAS_PDU.buffer, nas_len));
+  const LIBLTE_S1AP_NAS_PDU_STRUCT *nas_ie = lazy.get_ie(LIBLTE_S1AP_IE_ID_NAS_PDU, liblte_s1ap_unpack_nas_pdu);
+  assert(nas_ie && nas_ie->n_octets == nas_len && !memcmp(nas_ie->buffer, nas, nas_len));
+
+  const LIBLTE_S1AP_TAI_STRUCT *tai = lazy.get_ie(LIBLTE_S1AP_IE_ID_TAI, liblte_s1ap_unpack_tai);
+  assert(tai && !memcmp(tai->pLMNidentity.buffer, ref->TAI.pLMNidentity.buffer, 3));
+  assert(!memcmp(tai->tAC.buffer, ref->TAI.tAC.buffer, 2));
+  const LIBLTE_S1AP_EUTRAN_CGI_STRUCT *cgi = lazy.get_ie(LIBLTE_S1AP_IE_ID_EUTRAN_CGI, liblte_s1ap_unpack_eutran_cgi);
+  assert(cgi && !memcmp(cgi->cell_ID.buffer, ref->EUTRAN_CGI.cell_ID.buffer, LIBLTE_S1AP_CELLIDENTITY_BIT_STRING_LEN));
+
+  assert(lazy.find_ie(LIBLTE_S1AP_IE_ID_CAUSE) == NULL);
+  assert(lazy.get_ie(LIBLTE_S1AP_IE_ID_CAUSE, liblte_s1ap_unpack_cause) == NULL);
+}
+
+static void initial_ue_message_test(LIBLTE_S1AP_S1AP_PDU_STRUCT *pdu, LIBLTE_S1AP_S1AP_PDU_STRUCT *eager, LIBLTE_BYTE_MSG_STRUCT *msg)
+{
+  bzero(pdu, sizeof(LIBLTE_S1AP_S1AP_PDU_STRUCT));
+  pdu->choice_type = LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE;
+  LIBLTE_S1AP_INITIATINGMESSAGE_STRUCT *init = &pdu->choice.initiatingMessage;
+  init->procedureCode = LIBLTE_S1AP_PROC_ID_INITIALUEMESSAGE;
+  init->criticality   = LIBLTE_S1AP_CRITICALITY_IGNORE;
+  init->choice_type   = LIBLTE_S1AP_INITIATINGMESSAGE_CHOICE_INITIALUEMESSAGE;
+  LIBLTE_S1AP_MESSAGE_INITIALUEMESSAGE_STRUCT *ue = &init->choice.InitialUEMessage;
+  ue->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID = 300;
+  ue->NAS_PDU.n_octets = sizeof(nas_msg);
+  memcpy(ue->NAS_PDU.buffer, nas_msg, sizeof(nas_msg));
+  fill_tai_cgi(&ue->TAI, &ue->EUTRAN_CGI);
+  ue->RRC_Establishment_Cause.e = LIBLTE_S1AP_RRC_ESTABLISHMENT_CAUSE_MO_SIGNALLING;
+  pack(pdu, msg);
+
+  srslte::s1ap_arena    arena;
+  srslte::s1ap_lazy_pdu lazy;
+  assert(lazy.parse(msg->msg, msg->N_bytes, &arena) == LIBLTE_SUCCESS);
+  assert(lazy.get_procedure_code() == LIBLTE_S1AP_PROC_ID_INITIALUEMESSAGE);
+  assert(liblte_s1ap_unpack_s1ap_pdu(msg, eager) == LIBLTE_SUCCESS);
+  LIBLTE_S1AP_MESSAGE_INITIALUEMESSAGE_STRUCT *ref = &eager->choice.initiatingMessage.choice.InitialUEMessage;
+
+  assert(lazy.find_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID) == NULL);
+  const LIBLTE_S1AP_ENB_UE_S1AP_ID_STRUCT *enb_id = lazy.get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id);
+  assert(enb_id && enb_id->ENB_UE_S1AP_ID == ref->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID);
+  const uint8_t *nas;
+  uint32_t nas_len;
+  assert(lazy.get_octet_string(LIBLTE_S1AP_IE_ID_NAS_PDU, &nas, &nas_len));
+  assert(nas_len == ref->NAS_PDU.n_octets && !memcmp(nas, ref->NAS_PDU.buffer, nas_len));
+}
+
+static void ue_context_release_request_test(LIBLTE_S1AP_S1AP_PDU_STRUCT *pdu, LIBLTE_S1AP_S1AP_PDU_STRUCT *eager, LIBLTE_BYTE_MSG_STRUCT *msg)
+{
+  bzero(pdu, sizeof(LIBLTE_S1AP_S1AP_PDU_STRUCT));
+  pdu->choice_type = LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE;
+  LIBLTE_S1AP_INITIATINGMESSAGE_STRUCT *init = &pdu->choice.initiatingMessage;
+  init->procedureCode = LIBLTE_S1AP_PROC_ID_UECONTEXTRELEASEREQUEST;
+  init->criticality   = LIBLTE_S1AP_CRITICALITY_IGNORE;
+  init->choice_type   = LIBLTE_S1AP_INITIATINGMESSAGE_CHOICE_UECONTEXTRELEASEREQUEST;
+  LIBLTE_S1AP_MESSAGE_UECONTEXTRELEASEREQUEST_STRUCT *rel = &init->choice.UEContextReleaseRequest;
+  rel->MME_UE_S1AP_ID.MME_UE_S1AP_ID = 5;
+  rel->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID = 6;
+  rel->Cause.choice_type = LIBLTE_S1AP_CAUSE_CHOICE_RADIONETWORK;
+  rel->Cause.choice.radioNetwork.e = LIBLTE_S1AP_CAUSERADIONETWORK_USER_INACTIVITY;
+  pack(pdu, msg);
+
+  srslte::s1ap_arena    arena;
+  srslte::s1ap_lazy_pdu lazy;
+  assert(lazy.parse(msg->msg, msg->N_bytes, &arena) == LIBLTE_SUCCESS);
+  assert(lazy.get_procedure_code() == LIBLTE_S1AP_PROC_ID_UECONTEXTRELEASEREQUEST);
+  assert(liblte_s1ap_unpack_s1ap_pdu(msg, eager) == LIBLTE_SUCCESS);
+  LIBLTE_S1AP_MESSAGE_UECONTEXTRELEASEREQUEST_STRUCT *ref = &eager->choice.initiatingMessage.choice.UEContextReleaseRequest;
+
+  const LIBLTE_S1AP_MME_UE_S1AP_ID_STRUCT *mme_id = lazy.get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id);
+  assert(mme_id && mme_id->MME_UE_S1AP_ID == ref->MME_UE_S1AP_ID.MME_UE_S1AP_ID);
+  const LIBLTE_S1AP_CAUSE_STRUCT *cause = lazy.get_ie(LIBLTE_S1AP_IE_ID_CAUSE, liblte_s1ap_unpack_cause);
+  assert(cause && cause->choice_type == ref->Cause.choice_type);
+  assert(cause->choice.radioNetwork.e == ref->Cause.choice.radioNetwork.e);
+
+  // Truncated messages are rejected by parse()
+  for (uint32_t len = 0; len < msg->N_bytes; len++) {
+    assert(lazy.parse(msg->msg, len, &arena) != LIBLTE_SUCCESS);
+  }
+}
+
+static void initial_context_setup_response_test(LIBLTE_S1AP_S1AP_PDU_STRUCT *pdu, LIBLTE_S1AP_S1AP_PDU_STRUCT *eager, LIBLTE_BYTE_MSG_STRUCT *msg)
+{
+  bzero(pdu, sizeof(LIBLTE_S1AP_S1AP_PDU_STRUCT));
+  pdu->choice_type = LIBLTE_S1AP_S1AP_PDU_CHOICE_SUCCESSFULOUTCOME;
+  LIBLTE_S1AP_SUCCESSFULOUTCOME_STRUCT *succ = &pdu->choice.successfulOutcome;
+  succ->procedureCode = LIBLTE_S1AP_PROC_ID_INITIALCONTEXTSETUP;
+  succ->criticality   = LIBLTE_S1AP_CRITICALITY_REJECT;
+  succ->choice_type   = LIBLTE_S1AP_SUCCESSFULOUTCOME_CHOICE_INITIALCONTEXTSETUPRESPONSE;
+  LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPRESPONSE_STRUCT *res = &succ->choice.InitialContextSetupResponse;
+  res->MME_UE_S1AP_ID.MME_UE_S1AP_ID = 0x10203;
+  res->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID = 77;
+  res->E_RABSetupListCtxtSURes.len = 2;
+  for (uint32_t i = 0; i < 2; i++) {
+    LIBLTE_S1AP_E_RABSETUPITEMCTXTSURES_STRUCT *item = &res->E_RABSetupListCtxtSURes.buffer[i];
+    item->e_RAB_ID.E_RAB_ID = 5 + i;
+    item->transportLayerAddress.n_bits = 32;
+    for (uint32_t j = 0; j < 32; j++) {
+      item->transportLayerAddress.buffer[j] = (0x7f000001 >> (31 - j)) & 1;
+    }
+    item->gTP_TEID.buffer[3] = 0x10 + i;
+  }
+  pack(pdu, msg);
+
+  srslte::s1ap_arena    arena;
+  srslte::s1ap_lazy_pdu lazy;
+  assert(lazy.parse(msg->msg, msg->N_bytes, &arena) == LIBLTE_SUCCESS);
+  assert(lazy.get_pdu_type() == LIBLTE_S1AP_S1AP_PDU_CHOICE_SUCCESSFULOUTCOME);
+  assert(lazy.get_procedure_code() == LIBLTE_S1AP_PROC_ID_INITIALCONTEXTSETUP);
+  assert(liblte_s1ap_unpack_s1ap_pdu(msg, eager) == LIBLTE_SUCCESS);
+  LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPRESPONSE_STRUCT *ref = &eager->choice.successfulOutcome.choice.InitialContextSetupResponse;
+
+  const LIBLTE_S1AP_MME_UE_S1AP_ID_STRUCT *mme_id = lazy.get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id);
+  assert(mme_id && mme_id->MME_UE_S1AP_ID == ref->MME_UE_S1AP_ID.MME_UE_S1AP_ID);
+  const LIBLTE_S1AP_E_RABSETUPLISTCTXTSURES_STRUCT *list =
+      lazy.get_ie(LIBLTE_S1AP_IE_ID_E_RABSETUPLISTCTXTSURES, liblte_s1ap_unpack_e_rabsetuplistctxtsures);
+  assert(list && list->len == ref->E_RABSetupListCtxtSURes.len);
+  for (uint32_t i = 0; i < list->len; i++) {
+    const LIBLTE_S1AP_E_RABSETUPITEMCTXTSURES_STRUCT *a = &list->buffer[i];
+    const LIBLTE_S1AP_E_RABSETUPITEMCTXTSURES_STRUCT *b = &ref->E_RABSetupListCtxtSURes.buffer[i];
+    assert(a->e_RAB_ID.E_RAB_ID == b->e_RAB_ID.E_RAB_ID);
+    assert(a->transportLayerAddress.n_bits == b->transportLayerAddress.n_bits);
+    assert(!memcmp(a->transportLayerAddress.buffer, b->transportLayerAddress.buffer, b->transportLayerAddress.n_bits));
+    assert(!memcmp(a->gTP_TEID.buffer, b->gTP_TEID.buffer, 4));
+  }
+}
+
+static double elapsed_us(const struct timeval *t0, const struct timeval *t1)
+{
+  return (t1->tv_sec - t0->tv_sec) * 1e6 + (t1->tv_usec - t0->tv_usec);
+}
+
+typedef uint32_t (*lazy_read_t)(srslte::s1ap_lazy_pdu *lazy);
+
+// What the MME reads from each message: the UE ids to pick a worker, then what its handler uses
+static uint32_t read_uplink_nas_transport(srslte::s1ap_lazy_pdu *lazy)
+{
+  const uint8_t *nas;
+  uint32_t nas_len;
+  uint32_t sum = lazy->get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id)->MME_UE_S1AP_ID;
+  sum += lazy->get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id)->ENB_UE_S1AP_ID;
+  lazy->get_octet_string(LIBLTE_S1AP_IE_ID_NAS_PDU, &nas, &nas_len);
+  return sum + nas_len;
+}
+
+static uint32_t read_initial_ue_message(srslte::s1ap_lazy_pdu *lazy)
+{
+  const uint8_t *nas;
+  uint32_t nas_len;
+  uint32_t sum = lazy->get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id)->ENB_UE_S1AP_ID;
+  lazy->get_octet_string(LIBLTE_S1AP_IE_ID_NAS_PDU, &nas, &nas_len);
+  sum += nas_len;
+  sum += lazy->get_ie(LIBLTE_S1AP_IE_ID_TAI, liblte_s1ap_unpack_tai)->tAC.buffer[1];
+  sum += lazy->get_ie(LIBLTE_S1AP_IE_ID_EUTRAN_CGI, liblte_s1ap_unpack_eutran_cgi)->cell_ID.buffer[27];
+  sum += lazy->get_ie(LIBLTE_S1AP_IE_ID_RRC_ESTABLISHMENT_CAUSE, liblte_s1ap_unpack_rrc_establishment_cause)->e;
+  return sum;
+}
+
+static uint32_t read_initial_context_setup_response(srslte::s1ap_lazy_pdu *lazy)
+{
+  uint32_t sum = lazy->get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id)->MME_UE_S1AP_ID;
+  sum += lazy->get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id)->ENB_UE_S1AP_ID;
+  const LIBLTE_S1AP_E_RABSETUPLISTCTXTSURES_STRUCT *list =
+      lazy->get_ie(LIBLTE_S1AP_IE_ID_E_RABSETUPLISTCTXTSURES, liblte_s1ap_unpack_e_rabsetuplistctxtsures);
+  for (uint32_t i = 0; i < list->len; i++) {
+    sum += list->buffer[i].gTP_TEID.buffer[3];
+  }
+  return sum;
+}
+
+// Decode cost of the message in msg, eager against what the MME needs from it
+static void bench(const char *name, LIBLTE_S1AP_S1AP_PDU_STRUCT *eager, LIBLTE_BYTE_MSG_STRUCT *msg, lazy_read_t read)
+{
+  struct timeval t0, t1;
+  gettimeofday(&t0, NULL);
+  for (uint32_t i = 0; i < NOF_BENCH_ITERATIONS; i++) {
+    liblte_s1ap_unpack_s1ap_pdu(msg, eager);
+  }
+  gettimeofday(&t1, NULL);
+  double eager_us = elapsed_us(&t0, &t1) / NOF_BENCH_ITERATIONS;
+
+  srslte::s1ap_arena    arena;
+  srslte::s1ap_lazy_pdu lazy;
+  uint32_t sum = 0;
+  gettimeofday(&t0, NULL);
+  for (uint32_t i = 0; i < NOF_BENCH_ITERATIONS; i++) {
+    arena.reset();
+    lazy.parse(msg->msg, msg->N_bytes, &arena);
+    sum += read(&lazy);
+  }
+  gettimeofday(&t1, NULL);
+  double lazy_us = elapsed_us(&t0, &t1) / NOF_BENCH_ITERATIONS;
+  assert(sum != 0);
+
+  printf("%-34s (%3d bytes): eager %.2f us, %lu bytes; lazy %.2f us, %d bytes of arena\n",
+         name, msg->N_bytes, eager_us, sizeof(LIBLTE_S1AP_S1AP_PDU_STRUCT) + sizeof(LIBLTE_BIT_MSG_STRUCT),
+         lazy_us, arena.used());
+}
+
+int main(int argc, char **argv)
+{
+  // Over a MB each
+  LIBLTE_S1AP_S1AP_PDU_STRUCT *pdu   = new LIBLTE_S1AP_S1AP_PDU_STRUCT;
+  LIBLTE_S1AP_S1AP_PDU_STRUCT *eager = new LIBLTE_S1AP_S1AP_PDU_STRUCT;
+  LIBLTE_BYTE_MSG_STRUCT      *msg   = new LIBLTE_BYTE_MSG_STRUCT;
+
+  uplink_nas_transport_test(pdu, eager, msg);
+  initial_ue_message_test(pdu, eager, msg);
+  ue_context_release_request_test(pdu, eager, msg);
+  initial_context_setup_response_test(pdu, eager, msg);
+
+  uplink_nas_transport_test(pdu, eager, msg);
+  bench("Uplink NAS Transport", eager, msg, read_uplink_nas_transport);
+  initial_ue_message_test(pdu, eager, msg);
+  bench("Initial UE Message", eager, msg, read_initial_ue_message);
+  initial_context_setup_response_test(pdu, eager, msg);
+  bench("Initial Context Setup Response", eager, msg, read_initial_context_setup_response);
+
+  delete pdu;
+  delete eager;
+  delete msg;
+  printf("Done\n");
+  return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        buffer_pool_test.cc
+ * Description: Functional checks of buffer_pool (exhaustion, double and
+ *              foreign frees), of the byte buffer size classes, and a
+ *              multi-threaded allocate/deallocate
+ *              benchmark, with and without buffers crossing threads,
+ *              against a mutex + linear search reference pool.
+ *****************************************************************************/
+
+#define NOF_OPS       2000000
+#define POOL_LEN      2048
+#define BURST         16
+#define QUEUE_LEN     256
+#define MAX_THREADS   4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <vector>
+#include <stack>
+#include <algorithm>
+#include "srslte/common/buffer_pool.h"
+#include "srslte/common/ring_queue.h"
+
+using namespace srslte;
+
+// Previous pool implementation: global mutex, std::find on deallocate
+template <class buffer_t>
+class mutex_pool {
+public:
+  mutex_pool(int capacity) {
+    pthread_mutex_init(&mutex, NULL);
+    for (int i = 0; i < capacity; i++) {
+      available.push(new buffer_t);
+    }
+  }
+  ~mutex_pool() {
+    while (available.size()) {
+      delete available.top();
+      available.pop();
+    }
+  }
+  buffer_t* allocate(const char *debug_name = NULL) {
+    buffer_t *b = NULL;
+    pthread_mutex_lock(&mutex);
+    if (available.size()) {
+      b = available.top();
+      available.pop();
+      used.push_back(b);
+    }
+    pthread_mutex_unlock(&mutex);
+    return b;
+  }
+  bool deallocate(buffer_t *b) {
+    bool ret = false;
+    pthread_mutex_lock(&mutex);
+    typename std::vector<buffer_t*>::iterator elem = std::find(used.begin(), used.end(), b);
+    if (elem != used.end()) {
+      used.erase(elem);
+      available.push(b);
+      ret = true;
+    }
+    pthread_mutex_unlock(&mutex);
+    return ret;
+  }
+private:
+  std::stack<buffer_t*>  available;
+  std::vector<buffer_t*> used;
+  pthread_mutex_t        mutex;
+};
+
+template<class pool_t>
+struct bench_t {
+  pool_t                        *pool;
+  spsc_queue<byte_buffer_t*>    *q;
+  uint32_t                       nof_ops;
+  bool                           ok;
+};
+
+// Each thread allocates a burst of buffers and frees them again
+template<class pool_t>
+void* alloc_free(void *a)
+{
+  bench_t<pool_t> *args = (bench_t<pool_t>*) a;
+  byte_buffer_t   *b[BURST];
+  args->ok = true;
+  for (uint32_t n = 0; n < args->nof_ops; n += BURST) {
+    for (uint32_t i = 0; i < BURST; i++) {
+      b[i] = args->pool->allocate("alloc_free");
+      args->ok &= b[i] != NULL;
+    }
+    for (uint32_t i = 0; i < BURST; i++) {
+      args->ok &= args->pool->deallocate(b[i]);
+    }
+  }
+  return NULL;
+}
+
+// Producer/consumer pair: buffers are allocated and freed on different threads
+template<class pool_t>
+void* producer(void *a)
+{
+  bench_t<pool_t> *args = (bench_t<pool_t>*) a;
+  args->ok = true;
+  for (uint32_t n = 0; n < args->nof_ops; n++) {
+    byte_buffer_t *b;
+    while ((b = args->pool->allocate("producer")) == NULL) {
+      usleep(10);
+    }
+    args->q->push(b);
+  }
+  args->q->push(NULL);
+  return NULL;
+}
+
+template<class pool_t>
+void* consumer(void *a)
+{
+  bench_t<pool_t> *args = (bench_t<pool_t>*) a;
+  args->ok = true;
+  byte_buffer_t *b;
+  while ((b = args->q->wait_pop()) != NULL) {
+    args->ok &= args->pool->deallocate(b);
+  }
+  return NULL;
+}
+
+static double now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+template<class pool_t>
+bool bench(const char *name, uint32_t nof_threads, bool cross_thread)
+{
+  pool_t                     pool(POOL_LEN);
+  spsc_queue<byte_buffer_t*> *q[MAX_THREADS];
+  bench_t<pool_t>            args[2*MAX_THREADS];
+  pthread_t                  tid[2*MAX_THREADS];
+  uint32_t                   nof_tids = cross_thread ? 2*nof_threads : nof_threads;
+
+  // Keep the buffers in flight well below the pool size
+  for (uint32_t i = 0; i < nof_threads; i++) {
+    q[i] = new spsc_queue<byte_buffer_t*>(QUEUE_LEN);
+  }
+  double t0 = now();
+  for (uint32_t i = 0; i < nof_tids; i++) {
+    args[i].pool    = &pool;
+    args[i].q       = q[i % nof_threads];
+    args[i].nof_ops = NOF_OPS/nof_threads;
+    if (cross_thread) {
+      pthread_create(&tid[i], NULL, i < nof_threads ? &producer<pool_t> : &consumer<pool_t>, &args[i]);
+    } else {
+      pthread_create(&tid[i], NULL, &alloc_free<pool_t>, &args[i]);
+    }
+  }
+  bool ok = true;
+  for (uint32_t i = 0; i < nof_tids; i++) {
+    pthread_join(tid[i], NULL);
+    ok &= args[i].ok;
+  }
+  double elapsed = now() - t0;
+  for (uint32_t i = 0; i < nof_threads; i++) {
+    delete q[i];
+  }
+  printf("%-12s %s threads=%d: %7.1f ns per alloc+free %s\n", name, cross_thread ? "cross" : "local",
+         nof_threads, 1e9*elapsed/NOF_OPS, ok ? "" : "FAILED");
+  return ok;
+}
+
+bool functional()
+{
+  bool                       ok = true;
+  buffer_pool<byte_buffer_t> pool(256);
+  std::vector<byte_buffer_t*> b;
+
+  // Drain the pool, everything must come back
+  byte_buffer_t *p;
+  while ((p = pool.allocate("functional")) != NULL) {
+    b.push_back(p);
+  }
+  ok &= b.size() == 256 && pool.nof_available_pdus() == 0;
+  for (uint32_t i = 0; i < b.size(); i++) {
+    ok &= pool.deallocate(b[i]);
+  }
+  ok &= pool.nof_available_pdus() == 256;
+
+  // Double free and foreign buffers are rejected
+  byte_buffer_t foreign;
+  p = pool.allocate();
+  ok &= pool.deallocate(p);
+  ok &= !pool.deallocate(p);
+  ok &= !pool.deallocate(&foreign);
+  ok &= !pool.deallocate((byte_buffer_t*) ((uint8_t*) p + 1));
+  ok &= pool.nof_available_pdus() == 256;
+
+  // Small pools bypass the magazines and can be drained by any thread
+  buffer_pool<byte_buffer_t> small_pool(4);
+  for (uint32_t i = 0; i < 4; i++) {
+    ok &= small_pool.allocate() != NULL;
+  }
+  ok &= small_pool.allocate() == NULL;
+
+  printf("functional: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static long resident_kb()
+{
+  long  pages = 0, resident = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(f);
+  }
+  return resident*(sysconf(_SC_PAGESIZE)/1024);
+}
+
+bool size_classes()
+{
+  bool ok = true;
+
+  long rss = resident_kb();
+  byte_buffer_pool *pool = byte_buffer_pool::get_instance(POOL_LEN);
+  printf("byte_buffer_pool(%d) resident: %ld kB\n", POOL_LEN, resident_kb() - rss);
+
+  byte_buffer_t *small  = pool->allocate("small", 40);
+  byte_buffer_t *medium = pool->allocate("medium", 1500);
+  byte_buffer_t *large  = pool->allocate("large");
+  ok &= small->get_size_class()  == SRSLTE_BUFFER_SMALL  && small->get_tailroom()  == SRSLTE_BUFFER_SMALL_BYTES;
+  ok &= medium->get_size_class() == SRSLTE_BUFFER_MEDIUM && medium->get_tailroom() == SRSLTE_BUFFER_MEDIUM_BYTES;
+  ok &= large->get_size_class()  == SRSLTE_BUFFER_LARGE;
+  ok &= large->get_tailroom() == SRSLTE_MAX_BUFFER_SIZE_BYTES - SRSLTE_BUFFER_HEADER_OFFSET;
+
+  // Every class keeps the headroom and LIBLTE's view of the payload
+  uint32_t headroom = large->get_headroom();
+  ok &= headroom >= 512 && small->get_headroom() == headroom && medium->get_headroom() == headroom;
+  ok &= small->msg == (uint8_t*) small + sizeof(uint32_t) + SRSLTE_BUFFER_HEADER_OFFSET;
+
+  small->msg     -= 8;
+  small->N_bytes += 48;
+  ok &= small->get_headroom() == headroom - 8;
+  ok &= small->get_tailroom() == SRSLTE_BUFFER_SMALL_BYTES - 40;
+
+  // Standalone copies are full size and keep the headroom
+  byte_buffer_t copy(*small);
+  ok &= copy.get_size_class() == SRSLTE_BUFFER_LARGE && copy.get_headroom() == small->get_headroom();
+  ok &= copy.N_bytes == small->N_bytes && memcmp(copy.msg, small->msg, copy.N_bytes) == 0;
+
+  pool->deallocate(small);
+  pool->deallocate(medium);
+  pool->deallocate(large);
+
+  // An exhausted class falls back to the next one
+  std::vector<byte_buffer_t*> b;
+  byte_buffer_t *p;
+  while ((p = pool->allocate("fallback", 40)) != NULL && p->get_size_class() == SRSLTE_BUFFER_SMALL) {
+    b.push_back(p);
+  }
+  ok &= p != NULL && p->get_size_class() == SRSLTE_BUFFER_MEDIUM;
+  pool->deallocate(p);
+  for (uint32_t i = 0; i < b.size(); i++) {
+    pool->deallocate(b[i]);
+  }
+
+  // A foreign buffer is reported and left untouched
+  byte_buffer_t foreign;
+  foreign.N_bytes = 40;
+  pool->deallocate(&foreign);
+  ok &= foreign.N_bytes == 40;
+  byte_buffer_pool::cleanup();
+
+  printf("size classes: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  bool result = functional();
+  result &= size_classes();
+
+  for (uint32_t n = 1; n <= MAX_THREADS; n *= 2) {
+    result &= bench<mutex_pool<byte_buffer_t> >("mutex_pool", n, false);
+    result &= bench<buffer_pool<byte_buffer_t> >("buffer_pool", n, false);
+  }
+  for (uint32_t n = 1; n <= MAX_THREADS/2; n *= 2) {
+    result &= bench<mutex_pool<byte_buffer_t> >("mutex_pool", n, true);
+    result &= bench<buffer_pool<byte_buffer_t> >("buffer_pool", n, true);
+  }
+
+  if (result) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
@@ -0,0 +1,260 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#define NTHREADS 16
+#define NMSGS    1000
+#define NBENCH   100000
+#define NBATCH   (SRSLTE_LOG_RING_LEN / 2)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "srslte/common/log_filter.h"
+#include "srslte/common/logger_file.h"
+#include "srslte/common/logger_async.h"
+
+using namespace srslte;
+
+class fixed_time : public log_filter::time_itf {
+public:
+  srslte_timestamp_t get_time() {
+    srslte_timestamp_t t;
+    t.full_secs = 1234;
+    t.frac_secs = 0.5;
+    return t;
+  }
+};
+
+// Calls that must produce the same lines with both loggers
+void write_calls(logger *l) {
+  fixed_time t;
+  uint8_t    hex[300];
+  char       long_str[400];
+
+  for(int i=0;i<300;i++)
+    hex[i] = i & 0xFF;
+  memset(long_str, 'a', sizeof(long_str) - 1);
+  long_str[sizeof(long_str) - 1] = '\0';
+  std::string runtime_fmt = std::string("Runtime format %d ") + "%s\n";
+
+  log_filter filter("TEST", l, true);
+  filter.set_level(LOG_LEVEL_DEBUG);
+  filter.set_hex_limit(32);
+  filter.set_time_src(&t, log_filter::TIME);
+  filter.step(42);
+
+  filter.error("Ints %d %5d %-3d| %u %x %08X %c %%\n", -1, 2, 3, 4u, 0xab, 0xcd, 'z');
+  filter.warning("Longs %ld %lu %lld %llu %zu %jd %td\n", -5L, 6UL, -7LL, 8ULL, (size_t) 9,
+                 (intmax_t) 10, (ptrdiff_t) 11);
+  filter.info("Floats %f %.2f %8.3e %g\n", 1.5, 2.25f, 3e10, 0.1);
+  filter.debug("Strings %s|%-8s|%.3s|%.*s|%*d\n", "abc", "de", "fghij", 2, "klm", 5, 7);
+  filter.debug("Pointer %p\n", (void*) 0x1234);
+  filter.debug("No newline");
+  filter.debug("%s", "");
+  filter.debug(runtime_fmt.c_str(), 12, "dynamic");
+  filter.debug("Too long for a record %s\n", long_str);
+  filter.set_log_level_short(false);
+  filter.show_layer(false);
+  filter.prepend_string("[prepended]");
+  filter.info("Long level and no layer %d\n", 1);
+  filter.step(43);
+  filter.set_time_src(&t, log_filter::EPOCH);
+  filter.info("Epoch %d\n", 2);
+
+  filter.info_hex(hex, 10, "Hex no newline %d", 3);
+  filter.error_hex(hex, 100, "Hex limited %d\n", 4);
+  filter.set_hex_limit(200);
+  filter.debug_hex(hex, 300, "Hex too long for a record\n");
+  filter.set_hex_limit(0);
+  filter.warning_hex(hex, 100, "Hex disabled\n");
+  l->log(new std::string("Raw string\n"));
+}
+
+bool read_file(std::string filename, std::string *out) {
+  FILE *f = fopen(filename.c_str(), "r");
+  if (!f) {
+    return false;
+  }
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    out->append(buf, n);
+  }
+  fclose(f);
+  return true;
+}
+
+bool same_output() {
+  std::string a, b;
+  {
+    logger_file l;
+    l.init("log_file.txt");
+    write_calls(&l);
+  }
+  {
+    logger_async l;
+    l.init("log_async.txt");
+    write_calls(&l);
+  }
+  bool pass = read_file("log_file.txt", &a) && read_file("log_async.txt", &b) && a == b;
+  if (!pass) {
+    printf("Output differs:\n--- logger_file\n%s--- logger_async\n%s", a.c_str(), b.c_str());
+  }
+  remove("log_file.txt");
+  remove("log_async.txt");
+  return pass;
+}
+
+typedef struct {
+  logger_async *l;
+  int thread_id;
+}args_t;
+
+void* thread_loop(void *a) {
+  args_t *args = (args_t*)a;
+  char buf[100];
+
+  sprintf(buf, "LAYER%d", args->thread_id);
+  log_filter filter(buf, args->l);
+  filter.set_level(LOG_LEVEL_INFO);
+  filter.show_layer(false);
+  filter.set_time_src(NULL, log_filter::EPOCH);
+
+  for(int i=0;i<NMSGS;i++)
+  {
+    filter.info("Thread %d: %d\n", args->thread_id, i);
+    filter.debug("Filtered %d: %d\n", args->thread_id, i);
+  }
+  return NULL;
+}
+
+bool threads() {
+  bool pass = true;
+  static bool written[NTHREADS][NMSGS];
+  {
+    logger_async l;
+    l.init("log.txt");
+    pthread_t threads[NTHREADS];
+    args_t    args[NTHREADS];
+    for(int i=0;i<NTHREADS;i++) {
+      args[i].l = &l;
+      args[i].thread_id = i;
+      pthread_create(&threads[i], NULL, &thread_loop, &args[i]);
+    }
+    for(int i=0;i<NTHREADS;i++) {
+      pthread_join(threads[i], NULL);
+    }
+    pass &= l.get_nof_dropped() == 0;
+  }
+  FILE *f = fopen("log.txt", "r");
+  char  line[256];
+  int   thread, msg;
+  long  t;
+  while(f && fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "%ld [I] Thread %d: %d", &t, &thread, &msg) == 3 &&
+        thread < NTHREADS && msg < NMSGS) {
+      written[thread][msg] = true;
+    }
+  }
+  if (f) {
+    fclose(f);
+  }
+  for(int i=0;i<NTHREADS;i++) {
+    for(int j=0;j<NMSGS;j++) {
+      if(!written[i][j]) pass = false;
+    }
+  }
+  remove("log.txt");
+  return pass;
+}
+
+/* Time a debug() call as seen by the calling thread. Calls go in batches of half a ring, and the
+ * logger thread writes each batch out before the next one, untimed, so no record is dropped and
+ * what is measured is the enqueueing */
+void bench(const char *name, logger *l, logger_async *async, bool hex) {
+  uint8_t        pdu[32];
+  struct timeval t[2];
+  double         us = 0;
+  log_filter     filter("PHY0", l, true);
+  filter.set_level(LOG_LEVEL_DEBUG);
+  filter.set_hex_limit(32);
+  memset(pdu, 0x5a, sizeof(pdu));
+
+  for (uint32_t b = 0; b < NBENCH; b += NBATCH) {
+    gettimeofday(&t[0], NULL);
+    for (uint32_t i = b; i < b + NBATCH && i < NBENCH; i++) {
+      filter.step(i);
+      if (hex) {
+        filter.debug_hex(pdu, sizeof(pdu), "PDSCH: rnti=0x%x, tbs=%d, mcs=%d, crc=%s\n", 0x46, 1000 + i, i % 28, "OK");
+      } else {
+        filter.debug("PDSCH: rnti=0x%x, tbs=%d, mcs=%d, snr=%.1f dB, crc=%s\n", 0x46, 1000 + i, i % 28, 12.5, "OK");
+      }
+    }
+    gettimeofday(&t[1], NULL);
+    us += (t[1].tv_sec - t[0].tv_sec)*1e6 + (t[1].tv_usec - t[0].tv_usec);
+    while (async && async->get_nof_queued()) {
+      usleep(100);
+    }
+  }
+  printf("%-13s %s: %7.1f ns per call\n", name, hex ? "debug_hex" : "debug    ", us * 1e3 / NBENCH);
+}
+
+int main(int argc, char **argv) {
+  bool result = true;
+
+  result &= same_output();
+  printf("same output: %s\n", result ? "ok" : "FAILED");
+  result &= threads();
+  printf("threads: %s\n", result ? "ok" : "FAILED");
+
+  for (int hex = 0; hex < 2; hex++) {
+    {
+      logger_file l;
+      l.init("log_bench.txt");
+      bench("logger_file", &l, NULL, hex);
+    }
+    {
+      logger_async l;
+      l.init("log_bench.txt");
+      bench("logger_async", &l, &l, hex);
+      printf("              %lu records dropped\n", (unsigned long) l.get_nof_dropped());
+      result &= l.get_nof_dropped() == 0;
+    }
+  }
+  remove("log_bench.txt");
+
+  if(result) {
+    printf("Passed\n");
+    exit(0);
+  }else{
+    printf("Failed\n");
+    exit(1);
+  }
+}
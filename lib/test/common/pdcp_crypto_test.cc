@@ -0,0 +1,259 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "srslte/common/pdcp_crypto.h"
+#include "srslte/common/security.h"
+
+using namespace srslte;
+
+#define NOF_BENCH_SDUS  4000
+#define BENCH_SDU_LEN   1500
+#define BATCH_SIZE      32
+
+static uint8_t key[] = { 0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c,
+                         0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1 };
+
+static double elapsed(struct timeval *t0, struct timeval *t1)
+{
+  return (t1->tv_sec - t0->tv_sec) + (t1->tv_usec - t0->tv_usec) * 1e-6;
+}
+
+/*
+ * 33.401 V13.1.0 Annex C.2, 128-EIA2 test set 1
+ */
+void test_eia2_vector()
+{
+  uint8_t msg[] = { 0x48, 0x45, 0x83, 0xd5, 0xaf, 0xe0, 0x82, 0xae };
+  uint8_t mac_exp[] = { 0xb9, 0x37, 0x87, 0xe6 };
+  uint8_t mac[4];
+
+  pdcp_crypto crypto;
+  crypto.set_keys(key, key, CIPHERING_ALGORITHM_ID_EEA0, INTEGRITY_ALGORITHM_ID_128_EIA2);
+  crypto.integrity(0x398a59b4, 0x1a, 1, msg, sizeof(msg), mac);
+  assert(memcmp(mac, mac_exp, 4) == 0);
+}
+
+/*
+ * 33.401 V13.1.0 Annex C.4, 128-EIA1 test set 1
+ */
+void test_eia1_vector()
+{
+  uint8_t ik[] = { 0x2b, 0xd6, 0x45, 0x9f, 0x82, 0xc5, 0xb3, 0x00,
+                   0x95, 0x2c, 0x49, 0x10, 0x48, 0x81, 0xff, 0x48 };
+  uint8_t msg[] = { 0x33, 0x32, 0x34, 0x62, 0x63, 0x39, 0x38, 0x61,
+                    0x37, 0x34, 0x79 };
+  uint8_t mac_exp[] = { 0x73, 0x1f, 0x11, 0x65 };
+  uint8_t mac[4];
+
+  pdcp_crypto crypto;
+  crypto.set_keys(ik, ik, CIPHERING_ALGORITHM_ID_EEA0, INTEGRITY_ALGORITHM_ID_128_EIA1);
+  crypto.integrity(0x38a6f056, 0x1f, 0, msg, sizeof(msg), mac);
+  assert(memcmp(mac, mac_exp, 4) == 0);
+}
+
+/*
+ * Every length up to 3 blocks past a typical SDU, against the per-packet
+ * functions in liblte_security
+ */
+void test_against_reference()
+{
+  uint8_t msg[1600];
+  uint8_t out[1600];
+  uint8_t ref[1600];
+  uint8_t mac[4];
+  uint8_t mac_ref[4];
+
+  for (uint32_t i = 0; i < sizeof(msg); i++) {
+    msg[i] = rand();
+  }
+
+  pdcp_crypto eea1, eea2, eea3;
+  eea1.set_keys(key, key, CIPHERING_ALGORITHM_ID_128_EEA1, INTEGRITY_ALGORITHM_ID_128_EIA1);
+  eea2.set_keys(key, key, CIPHERING_ALGORITHM_ID_128_EEA2, INTEGRITY_ALGORITHM_ID_128_EIA2);
+  eea3.set_keys(key, key, CIPHERING_ALGORITHM_ID_128_EEA3, INTEGRITY_ALGORITHM_ID_128_EIA3);
+
+  for (uint32_t len = 1; len < sizeof(msg); len++) {
+    uint32_t count = 0x1000 + len;
+
+    security_128_eea1(key, count, 3, 1, msg, len, ref);
+    eea1.cipher(count, 3, 1, msg, len, out);
+    assert(memcmp(out, ref, len) == 0);
+
+    security_128_eea2(key, count, 3, 1, msg, len, ref);
+    eea2.cipher(count, 3, 1, msg, len, out);
+    assert(memcmp(out, ref, len) == 0);
+
+    // In place
+    memcpy(out, msg, len);
+    eea2.cipher(count, 3, 1, out, len, out);
+    assert(memcmp(out, ref, len) == 0);
+
+    security_128_eea3(key, count, 3, 1, msg, len, ref);
+    memcpy(out, msg, len);
+    eea3.cipher(count, 3, 1, out, len, out);
+    assert(memcmp(out, ref, len) == 0);
+
+    security_128_eia1(key, count, 3, 0, msg, len, mac_ref);
+    eea1.integrity(count, 3, 0, msg, len, mac);
+    assert(memcmp(mac, mac_ref, 4) == 0);
+
+    security_128_eia2(key, count, 3, 0, msg, len, mac_ref);
+    eea2.integrity(count, 3, 0, msg, len, mac);
+    assert(memcmp(mac, mac_ref, 4) == 0);
+
+    security_128_eia3(key, count, 3, 0, msg, len, mac_ref);
+    eea3.integrity(count, 3, 0, msg, len, mac);
+    assert(memcmp(mac, mac_ref, 4) == 0);
+  }
+}
+
+void test_batch()
+{
+  uint8_t           msg[BATCH_SIZE][100];
+  uint8_t           ref[BATCH_SIZE][100];
+  pdcp_crypto_sdu_t sdus[BATCH_SIZE];
+
+  pdcp_crypto crypto;
+  crypto.set_keys(key, key, CIPHERING_ALGORITHM_ID_128_EEA2, INTEGRITY_ALGORITHM_ID_EIA0);
+  for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+    for (uint32_t j = 0; j < sizeof(msg[i]); j++) {
+      msg[i][j] = rand();
+    }
+    sdus[i].count = i;
+    sdus[i].msg   = msg[i];
+    sdus[i].len   = 50 + i;
+    security_128_eea2(key, i, 5, 0, msg[i], sdus[i].len, ref[i]);
+  }
+  crypto.cipher_batch(5, 0, sdus, BATCH_SIZE);
+  for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+    assert(memcmp(msg[i], ref[i], sdus[i].len) == 0);
+  }
+}
+
+/*
+ * Throughput with sdu_len byte SDUs: per-packet functions through a
+ * temporary buffer, as PDCP used them, against the engine with cached
+ * key schedules, ciphering in place
+ */
+void bench_algo(const char *name, uint32_t sdu_len, CIPHERING_ALGORITHM_ID_ENUM cipher_algo, INTEGRITY_ALGORITHM_ID_ENUM integ_algo)
+{
+  static uint8_t    msg[BATCH_SIZE][BENCH_SDU_LEN];
+  static uint8_t    tmp[BENCH_SDU_LEN];
+  pdcp_crypto_sdu_t sdus[BATCH_SIZE];
+  uint8_t           mac[4];
+  struct timeval    t0, t1;
+  uint32_t          i;
+
+  pdcp_crypto crypto;
+  crypto.set_keys(key, key, cipher_algo, integ_algo);
+
+  gettimeofday(&t0, NULL);
+  for (i = 0; i < NOF_BENCH_SDUS; i++) {
+    switch (integ_algo) {
+      case INTEGRITY_ALGORITHM_ID_128_EIA1:
+        security_128_eia1(key, i, 1, 0, msg[0], sdu_len, mac);
+        break;
+      case INTEGRITY_ALGORITHM_ID_128_EIA2:
+        security_128_eia2(key, i, 1, 0, msg[0], sdu_len, mac);
+        break;
+      case INTEGRITY_ALGORITHM_ID_128_EIA3:
+        security_128_eia3(key, i, 1, 0, msg[0], sdu_len, mac);
+        break;
+      default:
+        break;
+    }
+    switch (cipher_algo) {
+      case CIPHERING_ALGORITHM_ID_128_EEA1:
+        security_128_eea1(key, i, 1, 0, msg[0], sdu_len, tmp);
+        memcpy(msg[0], tmp, sdu_len);
+        break;
+      case CIPHERING_ALGORITHM_ID_128_EEA2:
+        security_128_eea2(key, i, 1, 0, msg[0], sdu_len, tmp);
+        memcpy(msg[0], tmp, sdu_len);
+        break;
+      case CIPHERING_ALGORITHM_ID_128_EEA3:
+        security_128_eea3(key, i, 1, 0, msg[0], sdu_len, tmp);
+        memcpy(msg[0], tmp, sdu_len);
+        break;
+      default:
+        break;
+    }
+  }
+  gettimeofday(&t1, NULL);
+  double ref_s = elapsed(&t0, &t1);
+
+  gettimeofday(&t0, NULL);
+  for (i = 0; i < NOF_BENCH_SDUS; i++) {
+    crypto.integrity(i, 1, 0, msg[0], sdu_len, mac);
+    crypto.cipher(i, 1, 0, msg[0], sdu_len, msg[0]);
+  }
+  gettimeofday(&t1, NULL);
+  double engine_s = elapsed(&t0, &t1);
+
+  double mbit = 8.0 * sdu_len * NOF_BENCH_SDUS / 1e6;
+  printf("%-10s %4d B  per-packet %7.1f Mbps, engine %7.1f Mbps",
+         name, sdu_len, mbit / ref_s, mbit / engine_s);
+
+  if (cipher_algo != CIPHERING_ALGORITHM_ID_EEA0) {
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < NOF_BENCH_SDUS; i += BATCH_SIZE) {
+      for (uint32_t j = 0; j < BATCH_SIZE; j++) {
+        sdus[j].count = i + j;
+        sdus[j].msg   = msg[j];
+        sdus[j].len   = sdu_len;
+      }
+      crypto.cipher_batch(1, 0, sdus, BATCH_SIZE);
+    }
+    gettimeofday(&t1, NULL);
+    printf(", batches of %d %7.1f Mbps", BATCH_SIZE, mbit / elapsed(&t0, &t1));
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+  test_eia1_vector();
+  test_eia2_vector();
+  test_against_reference();
+  test_batch();
+
+  uint32_t sdu_len[] = {64, BENCH_SDU_LEN};
+  for (uint32_t i = 0; i < 2; i++) {
+    bench_algo("EEA1",      sdu_len[i], CIPHERING_ALGORITHM_ID_128_EEA1, INTEGRITY_ALGORITHM_ID_EIA0);
+    bench_algo("EEA2",      sdu_len[i], CIPHERING_ALGORITHM_ID_128_EEA2, INTEGRITY_ALGORITHM_ID_EIA0);
+    bench_algo("EIA1",      sdu_len[i], CIPHERING_ALGORITHM_ID_EEA0,     INTEGRITY_ALGORITHM_ID_128_EIA1);
+    bench_algo("EEA3",      sdu_len[i], CIPHERING_ALGORITHM_ID_128_EEA3, INTEGRITY_ALGORITHM_ID_EIA0);
+    bench_algo("EIA2",      sdu_len[i], CIPHERING_ALGORITHM_ID_EEA0,     INTEGRITY_ALGORITHM_ID_128_EIA2);
+    bench_algo("EIA3",      sdu_len[i], CIPHERING_ALGORITHM_ID_EEA0,     INTEGRITY_ALGORITHM_ID_128_EIA3);
+    bench_algo("EEA2+EIA2", sdu_len[i], CIPHERING_ALGORITHM_ID_128_EEA2, INTEGRITY_ALGORITHM_ID_128_EIA2);
+  }
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Includes
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "srslte/common/zuc.h"
+
+/*
+ * Tests
+ *
+ * Document Reference: Specification of the 3GPP Confidentiality and
+ *                     Integrity Algorithms 128-EEA3 & 128-EIA3
+ *                     Document 2 (ZUC) and Document 3 (Implementor's
+ *                     Test Data)
+ */
+
+void test_zuc(const uint8_t *k, const uint8_t *iv, uint32_t z1, uint32_t z2)
+{
+  zuc_state_t st;
+  uint32_t z[2];
+
+  zuc_initialize(&st, k, iv);
+  zuc_generate_keystream(&st, 2, z);
+  assert(z[0] == z1);
+  assert(z[1] == z2);
+}
+
+void test_zuc_sets()
+{
+  uint8_t k[16], iv[16];
+
+  memset(k, 0x00, 16);
+  memset(iv, 0x00, 16);
+  test_zuc(k, iv, 0x27bede74, 0x018082da);
+
+  memset(k, 0xff, 16);
+  memset(iv, 0xff, 16);
+  test_zuc(k, iv, 0x0657cfa0, 0x7096398b);
+
+  uint8_t k3[] = { 0x3d, 0x4c, 0x4b, 0xe9, 0x6a, 0x82, 0xfd, 0xae,
+      0xb5, 0x8f, 0x64, 0x1d, 0xb1, 0x7b, 0x45, 0x5b };
+  uint8_t iv3[] = { 0x84, 0x31, 0x9a, 0xa8, 0xde, 0x69, 0x15, 0xca,
+      0x1f, 0x6b, 0xda, 0x6b, 0xfb, 0xd8, 0xc7, 0x66 };
+  test_zuc(k3, iv3, 0x14f1c272, 0x3279c419);
+}
+
+/* The first 192 of the 193 bits of EEA3 test set 1. The keystream does
+ * not depend on the length, so the cut message must give the same bits.
+ */
+void test_set_1()
+{
+  uint8_t key[] = { 0x17, 0x3d, 0x14, 0xba, 0x50, 0x03, 0x73, 0x1d,
+      0x7a, 0x60, 0x04, 0x94, 0x70, 0xf0, 0x0a, 0x29 };
+  uint32_t count = 0x66035492;
+  uint8_t bearer = 0x0f;
+  uint8_t direction = 0;
+  uint32_t len_bits = 192, len_bytes = (len_bits + 7) / 8;
+  uint8_t msg[] = { 0x6c, 0xf6, 0x53, 0x40, 0x73, 0x55, 0x52, 0xab,
+      0x0c, 0x97, 0x52, 0xfa, 0x6f, 0x90, 0x25, 0xfe, 0x0b, 0xd6,
+      0x75, 0xd9, 0x00, 0x58, 0x75, 0xb2 };
+  uint8_t ct[] = { 0xa6, 0xc8, 0x5f, 0xc6, 0x6a, 0xfb, 0x85, 0x33,
+      0xaa, 0xfc, 0x25, 0x18, 0xdf, 0xe7, 0x84, 0x94, 0x0e, 0xe1,
+      0xe4, 0xb0, 0x30, 0x23, 0x8c, 0xc8 };
+  uint8_t out[sizeof(msg)];
+
+  // encryption
+  memcpy(out, msg, len_bytes);
+  zuc_eea3(key, count, bearer, direction, out, len_bits);
+  assert(memcmp(ct, out, len_bytes) == 0);
+
+  // decryption
+  zuc_eea3(key, count, bearer, direction, out, len_bits);
+  assert(memcmp(msg, out, len_bytes) == 0);
+
+  // bits past the length are zeroed
+  memcpy(out, msg, len_bytes);
+  zuc_eea3(key, count, bearer, direction, out, len_bits - 3);
+  assert(memcmp(ct, out, len_bytes - 1) == 0);
+  assert(out[len_bytes - 1] == (ct[len_bytes - 1] & 0xf8));
+}
+
+/*
+ * Functions
+ */
+
+int main(int argc, char * argv[]) {
+  test_zuc_sets();
+  test_set_1();
+}
@@ -0,0 +1,104 @@
+/*
+ * Includes
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "srslte/common/zuc.h"
+
+/*
+ * Tests
+ *
+ * Document Reference: Specification of the 3GPP Confidentiality and
+ *                     Integrity Algorithms 128-EEA3 & 128-EIA3
+ *                     Document 3: Implementor's Test Data
+ */
+
+void test_set_1()
+{
+  uint8_t key[16] = {0};
+  uint8_t msg[4] = {0};
+  uint8_t mac[4];
+  uint8_t mac_exp[] = { 0xc8, 0xa9, 0x59, 0x5e };
+
+  zuc_eia3(key, 0, 0, 0, msg, 1, mac);
+  assert(memcmp(mac, mac_exp, 4) == 0);
+}
+
+void test_set_2()
+{
+  uint8_t key[] = { 0x47, 0x05, 0x41, 0x25, 0x56, 0x1e, 0xb2, 0xdd,
+      0xa9, 0x40, 0x59, 0xda, 0x05, 0x09, 0x78, 0x50 };
+  uint8_t msg[12] = {0};
+  uint8_t mac[4];
+  uint8_t mac_exp[] = { 0x67, 0x19, 0xa0, 0x88 };
+
+  zuc_eia3(key, 0x561eb2dd, 0x14, 0, msg, 90, mac);
+  assert(memcmp(mac, mac_exp, 4) == 0);
+}
+
+/* Section 4.4 of Document 1 taken literally, one bit at a time over the
+ * whole keystream, against the windowed implementation
+ */
+void ref_eia3(uint8_t *key, uint32_t count, uint32_t bearer, uint32_t dir,
+              uint8_t *data, uint32_t length, uint8_t *mac)
+{
+  zuc_state_t st;
+  uint8_t iv[16];
+  uint32_t L = (length + 31) / 32 + 2;
+  uint32_t *z = (uint32_t *) calloc(L, sizeof(uint32_t));
+  uint32_t T = 0;
+
+  iv[0] = count >> 24; iv[1] = count >> 16; iv[2] = count >> 8; iv[3] = count;
+  iv[4] = bearer << 3; iv[5] = iv[6] = iv[7] = 0;
+  memcpy(&iv[8], &iv[0], 8);
+  iv[8]  ^= dir << 7;
+  iv[14] ^= dir << 7;
+  zuc_initialize(&st, key, iv);
+  zuc_generate_keystream(&st, L, z);
+
+  for (uint32_t i = 0; i <= length; i++) {
+    if (i == length || (data[i/8] >> (7 - i%8)) & 1) {
+      uint32_t w = z[i/32] << (i%32);
+      if (i%32) {
+        w |= z[i/32 + 1] >> (32 - i%32);
+      }
+      T ^= w;
+    }
+  }
+  T ^= z[L - 1];
+  mac[0] = T >> 24; mac[1] = T >> 16; mac[2] = T >> 8; mac[3] = T;
+  free(z);
+}
+
+void test_against_reference()
+{
+  uint8_t key[16];
+  uint8_t msg[200];
+  uint8_t mac[4], mac_ref[4];
+
+  for (uint32_t i = 0; i < sizeof(key); i++) {
+    key[i] = rand();
+  }
+  for (uint32_t i = 0; i < sizeof(msg); i++) {
+    msg[i] = rand();
+  }
+  for (uint32_t len = 0; len < 8 * sizeof(msg); len++) {
+    zuc_eia3(key, len, 5, len & 1, msg, len, mac);
+    ref_eia3(key, len, 5, len & 1, msg, len, mac_ref);
+    assert(memcmp(mac, mac_ref, 4) == 0);
+  }
+}
+
+/*
+ * Functions
+ */
+
+int main(int argc, char * argv[]) {
+  test_set_1();
+  test_set_2();
+  test_against_reference();
+}
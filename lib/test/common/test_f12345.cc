@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <sys/time.h>
 
 #include "srslte/common/liblte_security.h"
 
@@ -165,6 +166,93 @@ void test_set_2()
   return;
 }
 
+/*
+  Same vectors through a precomputed context
+*/
+void test_set_2_ctx()
+{
+  LIBLTE_ERROR_ENUM err_lte = LIBLTE_ERROR_INVALID_INPUTS;
+  int32 err_cmp = 0;
+
+  uint8_t k[] = {0x46, 0x5b, 0x5c, 0xe8, 0xb1, 0x99, 0xb4, 0x9f, 0xaa, 0x5f, 0x0a, 0x2e, 0xe2, 0x38, 0xa6, 0xbc};
+  uint8_t rand[] = {0x23, 0x55, 0x3c, 0xbe, 0x96, 0x37, 0xa8, 0x9d, 0x21, 0x8a, 0xe6, 0x4d, 0xae, 0x47, 0xbf, 0x35};
+  uint8_t sqn[] = {0xff, 0x9b, 0xb4, 0xd0, 0xb6, 0x07};
+  uint8_t amf[] = {0xb9, 0xb9};
+  uint8_t opc[] = {0xcd, 0x63, 0xcb, 0x71, 0x95, 0x4a, 0x9f, 0x4e, 0x48, 0xa5, 0x99, 0x4e, 0x37, 0xa0, 0x2b, 0xaf};
+
+  LIBLTE_SECURITY_MILENAGE_CTX_STRUCT ctx;
+  err_lte = liblte_security_milenage_init(k, opc, &ctx);
+  assert(err_lte == LIBLTE_SUCCESS);
+
+  uint8_t mac_o[8];
+  uint8_t res_o[8];
+  uint8_t ck_o[16];
+  uint8_t ik_o[16];
+  uint8_t ak_o[6];
+  err_lte = liblte_security_milenage_f12345(&ctx, rand, sqn, amf, mac_o, res_o, ck_o, ik_o, ak_o);
+  assert(err_lte == LIBLTE_SUCCESS);
+
+  uint8_t mac_a[] = {0x4a, 0x9f, 0xfa, 0xc3, 0x54, 0xdf, 0xaf, 0xb3};
+  uint8_t res[] = {0xa5, 0x42, 0x11, 0xd5, 0xe3, 0xba, 0x50, 0xbf};
+  uint8_t ck[] = {0xb4, 0x0b, 0xa9, 0xa3, 0xc5, 0x8b, 0x2a, 0x05, 0xbb, 0xf0, 0xd9, 0x87, 0xb2, 0x1b, 0xf8, 0xcb};
+  uint8_t ik[] = {0xf7, 0x69, 0xbc, 0xd7, 0x51, 0x04, 0x46, 0x04, 0x12, 0x76, 0x72, 0x71, 0x1c, 0x6d, 0x34, 0x41};
+  uint8_t ak[] = {0xaa, 0x68, 0x9c, 0x64, 0x83, 0x70};
+
+  err_cmp = arrcmp(mac_o, mac_a, sizeof(mac_a));
+  assert(err_cmp == 0);
+  err_cmp = arrcmp(res_o, res, sizeof(res));
+  assert(err_cmp == 0);
+  err_cmp = arrcmp(ck_o, ck, sizeof(ck));
+  assert(err_cmp == 0);
+  err_cmp = arrcmp(ik_o, ik, sizeof(ik));
+  assert(err_cmp == 0);
+  err_cmp = arrcmp(ak_o, ak, sizeof(ak));
+  assert(err_cmp == 0);
+  return;
+}
+
+/*
+  Authentication vectors per second, as the HSS computes them for an
+  attach: F1-F5 and K_ASME, per call or from a cached context
+*/
+#define NOF_BENCH_VECTORS 20000
+
+void bench_auth_vectors()
+{
+  uint8_t k[] = {0x46, 0x5b, 0x5c, 0xe8, 0xb1, 0x99, 0xb4, 0x9f, 0xaa, 0x5f, 0x0a, 0x2e, 0xe2, 0x38, 0xa6, 0xbc};
+  uint8_t opc[] = {0xcd, 0x63, 0xcb, 0x71, 0x95, 0x4a, 0x9f, 0x4e, 0x48, 0xa5, 0x99, 0x4e, 0x37, 0xa0, 0x2b, 0xaf};
+  uint8_t rand[16] = {0};
+  uint8_t sqn[] = {0x00, 0x00, 0x00, 0x00, 0x12, 0x34};
+  uint8_t amf[] = {0x80, 0x00};
+  uint8_t mac[8], res[8], ck[16], ik[16], ak[6], k_asme[32];
+  struct timeval t0, t1;
+  uint32 i;
+
+  gettimeofday(&t0, NULL);
+  for (i = 0; i < NOF_BENCH_VECTORS; i++) {
+    rand[0] = i;
+    liblte_security_milenage_f2345(k, opc, rand, res, ck, ik, ak);
+    liblte_security_milenage_f1(k, opc, rand, sqn, amf, mac);
+    liblte_security_generate_k_asme(ck, ik, ak, sqn, 1, 1, k_asme);
+  }
+  gettimeofday(&t1, NULL);
+  double per_call_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) * 1e-6;
+
+  LIBLTE_SECURITY_MILENAGE_CTX_STRUCT ctx;
+  liblte_security_milenage_init(k, opc, &ctx);
+  gettimeofday(&t0, NULL);
+  for (i = 0; i < NOF_BENCH_VECTORS; i++) {
+    rand[0] = i;
+    liblte_security_milenage_f12345(&ctx, rand, sqn, amf, mac, res, ck, ik, ak);
+    liblte_security_generate_k_asme(ck, ik, ak, sqn, 1, 1, k_asme);
+  }
+  gettimeofday(&t1, NULL);
+  double ctx_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) * 1e-6;
+
+  printf("Auth vectors/s: f1+f2345 %.0f, cached context f12345 %.0f\n",
+         NOF_BENCH_VECTORS / per_call_s, NOF_BENCH_VECTORS / ctx_s);
+}
+
 /*
   Own test sets 
 */
@@ -172,6 +260,8 @@ void test_set_2()
 int main(int argc, char * argv[]) {
 
   test_set_2();
+  test_set_2_ctx();
+  bench_auth_vectors();
   /*
   test_set_3();
   test_set_4();
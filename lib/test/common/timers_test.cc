@@ -0,0 +1,265 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+#include <algorithm>
+#include "srslte/common/timers.h"
+
+using namespace srslte;
+
+/* The linear-scan timers this implementation replaced, used as reference
+ * for the expiry semantics and as baseline for the step cost.
+ */
+class linear_timers
+{
+public:
+  class timer
+  {
+  public:
+    timer(uint32_t id_=0) {id = id_; counter = 0; timeout = 0; running = false; callback = NULL; }
+    void set(timer_callback *callback_, uint32_t timeout_) {
+      callback = callback_;
+      timeout = timeout_;
+      reset();
+    }
+    bool is_running() {
+      return (counter < timeout) && running;
+    }
+    bool is_expired() {
+      return (timeout > 0) && (counter >= timeout);
+    }
+    void reset() {
+      counter = 0;
+    }
+    uint32_t value() {
+      return counter;
+    }
+    void step() {
+      if (running) {
+        counter++;
+        if (is_expired()) {
+          running = false;
+          if (callback) {
+            callback->timer_expired(id);
+          }
+        }
+      }
+    }
+    void stop() {
+      running = false;
+    }
+    void run() {
+      running = true;
+    }
+    uint32_t id;
+  private:
+    timer_callback *callback;
+    uint32_t timeout;
+    uint32_t counter;
+    bool running;
+  };
+
+  linear_timers(uint32_t nof_timers_) : timer_list(nof_timers_) {
+    nof_timers = nof_timers_;
+    for (uint32_t i=0;i<nof_timers;i++) {
+      timer_list[i].id = i;
+    }
+  }
+  void step_all() {
+    for (uint32_t i=0;i<nof_timers;i++) {
+      timer_list[i].step();
+    }
+  }
+  timer *get(uint32_t i) {
+    return &timer_list[i];
+  }
+private:
+  uint32_t nof_timers;
+  std::vector<timer> timer_list;
+};
+
+class expired_list : public timer_callback
+{
+public:
+  void timer_expired(uint32_t timer_id) {
+    ids.push_back(timer_id);
+  }
+  std::vector<uint32_t> ids;
+};
+
+#define NOF_TIMERS 64
+#define NOF_STEPS  200000
+
+// Random operations on both implementations must give the same timer states
+bool compare_random()
+{
+  timers        wheel(NOF_TIMERS);
+  linear_timers linear(NOF_TIMERS);
+  expired_list  wheel_cb, linear_cb;
+  bool          ok = true;
+
+  srand(1234);
+  for (uint32_t s = 0; s < NOF_STEPS && ok; s++) {
+    uint32_t nof_ops = rand() % 4;
+    for (uint32_t k = 0; k < nof_ops; k++) {
+      uint32_t i  = rand() % NOF_TIMERS;
+      uint32_t op = rand() % 6;
+      uint32_t timeout;
+      switch (op) {
+        case 0:
+          // Short, wheel-crossing and multi-level timeouts, and 0
+          timeout = rand() % 3 == 0 ? rand() % 70 : rand() % 20000;
+          wheel.get(i)->set(&wheel_cb, timeout);
+          linear.get(i)->set(&linear_cb, timeout);
+          break;
+        case 1:
+        case 2:
+          wheel.get(i)->run();
+          linear.get(i)->run();
+          break;
+        case 3:
+          wheel.get(i)->stop();
+          linear.get(i)->stop();
+          break;
+        case 4:
+          wheel.get(i)->reset();
+          linear.get(i)->reset();
+          break;
+        default:
+          wheel.get(i)->step();
+          linear.get(i)->step();
+          break;
+      }
+    }
+    wheel.step_all();
+    linear.step_all();
+
+    std::sort(wheel_cb.ids.begin(), wheel_cb.ids.end());
+    std::sort(linear_cb.ids.begin(), linear_cb.ids.end());
+    ok &= wheel_cb.ids == linear_cb.ids;
+    wheel_cb.ids.clear();
+    linear_cb.ids.clear();
+    for (uint32_t i = 0; i < NOF_TIMERS; i++) {
+      ok &= wheel.get(i)->value()      == linear.get(i)->value();
+      ok &= wheel.get(i)->is_running() == linear.get(i)->is_running();
+      ok &= wheel.get(i)->is_expired() == linear.get(i)->is_expired();
+      if (!ok) {
+        printf("Timer %d differs at step %d\n", i, s);
+        break;
+      }
+    }
+  }
+  printf("compare with linear scan: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// A timeout beyond the top wheel level is re-filed until it is due
+bool long_timeout()
+{
+  timers       wheel(2);
+  expired_list cb;
+  uint32_t     timeout = 20000000;
+  wheel.get(0)->set(&cb, timeout);
+  wheel.get(0)->run();
+  wheel.get(1)->set(&cb, 1000);
+  wheel.get(1)->run();
+  uint32_t s = 0;
+  while (cb.ids.size() < 2 && s < timeout + 10) {
+    wheel.step_all();
+    s++;
+    if (cb.ids.size() == 1 && cb.ids[0] == 1 && s == 1000) {
+      wheel.get(1)->reset();
+      wheel.get(1)->run();
+      cb.ids.clear();
+    }
+  }
+  bool ok = s == timeout && cb.ids.size() == 2 && cb.ids[0] == 1 && cb.ids[1] == 0;
+  printf("long timeout: %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// Callback that restarts expired timers, so a fraction of them runs for ever
+template<class timers_t>
+class rearm : public timer_callback
+{
+public:
+  rearm(timers_t *t_) : t(t_) {}
+  void timer_expired(uint32_t timer_id) {
+    t->get(timer_id)->reset();
+    t->get(timer_id)->run();
+  }
+private:
+  timers_t *t;
+};
+
+template<class timers_t>
+double bench_step(uint32_t nof_timers, uint32_t nof_running, uint32_t nof_steps)
+{
+  timers_t         t(nof_timers);
+  rearm<timers_t>  cb(&t);
+  struct timeval   tv[2];
+
+  srand(0);
+  for (uint32_t i = 0; i < nof_running; i++) {
+    // RLC/RRC-like timeouts
+    t.get(i)->set(&cb, 10 + rand() % 990);
+    t.get(i)->run();
+  }
+  gettimeofday(&tv[0], NULL);
+  for (uint32_t s = 0; s < nof_steps; s++) {
+    t.step_all();
+  }
+  gettimeofday(&tv[1], NULL);
+  return ((tv[1].tv_sec - tv[0].tv_sec)*1e9 + (tv[1].tv_usec - tv[0].tv_usec)*1e3) / nof_steps;
+}
+
+int main(int argc, char **argv)
+{
+  bool result = compare_random();
+  result &= long_timeout();
+
+  for (uint32_t n = 100; n <= 100000; n *= 10) {
+    uint32_t steps = 100000000 / n < 20000 ? 100000000 / n : 20000;
+    for (uint32_t pct = 1; pct <= 100; pct *= 10) {
+      uint32_t running = n * (pct == 1 ? 1 : pct) / 100;
+      running = running ? running : 1;
+      double lin = bench_step<linear_timers>(n, running, steps);
+      double whl = bench_step<timers>(n, running, steps);
+      printf("timers=%6d running=%3d%%: linear %10.1f ns/step, wheel %8.1f ns/step\n", n, pct, lin, whl);
+    }
+  }
+
+  if (result) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
@@ -0,0 +1,196 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <map>
+#include <vector>
+#include "srslte/upper/gtpu_fwd_table.h"
+
+using namespace srslte;
+
+#define NOF_BEARERS   100000
+#define NOF_LOOKUPS   10000000
+
+// Random inserts/erases/lookups checked against std::map
+bool compare_fwd_map()
+{
+  fwd_map<uint32_t>            m;
+  std::map<uint32_t, uint32_t> ref;
+
+  srand(0);
+  for (uint32_t n = 0; n < 2000000; n++) {
+    // Small key range so that erases and overwrites hit
+    uint32_t key = rand() % 50000;
+    switch (rand() % 4) {
+      case 0:
+      case 1:
+        m.insert(key, n);
+        ref[key] = n;
+        break;
+      case 2:
+        if (m.erase(key) != (ref.erase(key) > 0)) {
+          printf("fwd_map: erase(%d) mismatch\n", key);
+          return false;
+        }
+        break;
+      default:
+        uint32_t *v = m.find(key);
+        std::map<uint32_t, uint32_t>::iterator it = ref.find(key);
+        if ((v == NULL) != (it == ref.end()) || (v && *v != it->second)) {
+          printf("fwd_map: find(%d) mismatch\n", key);
+          return false;
+        }
+    }
+    if (m.size() != ref.size()) {
+      printf("fwd_map: size %d != %d\n", m.size(), (uint32_t) ref.size());
+      return false;
+    }
+  }
+
+  uint32_t nof_used = 0;
+  for (uint32_t i = 0; i < m.capacity(); i++) {
+    if (m.used(i)) {
+      if (ref.count(m.key_at(i)) == 0 || ref[m.key_at(i)] != m.value_at(i)) {
+        printf("fwd_map: slot %d holds a stale entry\n", i);
+        return false;
+      }
+      nof_used++;
+    }
+  }
+  return nof_used == ref.size();
+}
+
+bool test_teid_table()
+{
+  teid_table<uint32_t> t(4);
+
+  uint32_t a = t.add(10);
+  uint32_t b = t.add(20);
+  uint32_t c = t.add(30);
+  if (a != 1 || b != 2 || c != 3 || t.add(40) != teid_table<uint32_t>::INVALID_TEID) {
+    printf("teid_table: unexpected TEIDs %d %d %d\n", a, b, c);
+    return false;
+  }
+  if (!t.find(b) || *t.find(b) != 20 || t.find(0) || t.find(4)) {
+    printf("teid_table: find failed\n");
+    return false;
+  }
+  t.remove(a);
+  t.remove(b);
+  // Freed TEIDs are reused oldest first
+  if (t.find(a) || t.add(50) != a || t.add(60) != b || t.size() != 3) {
+    printf("teid_table: reuse failed\n");
+    return false;
+  }
+  return true;
+}
+
+double now_ns()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+// UE IPs as allocated by the SP-GW: consecutive addresses in network order
+std::vector<uint32_t> ue_ips(uint32_t n)
+{
+  std::vector<uint32_t> ips(n);
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t h = 0xAC100002 + i;
+    ips[i] = ((h & 0xFF) << 24) | ((h & 0xFF00) << 8) | ((h >> 8) & 0xFF00) | (h >> 24);
+  }
+  return ips;
+}
+
+// Random lookup order, drawn in advance so the generator is not measured
+std::vector<uint32_t> lookup_order(uint32_t n)
+{
+  std::vector<uint32_t> idx(NOF_LOOKUPS);
+  srand(1);
+  for (uint32_t i = 0; i < NOF_LOOKUPS; i++) {
+    idx[i] = rand() % n;
+  }
+  return idx;
+}
+
+void benchmark()
+{
+  std::vector<uint32_t> ips = ue_ips(NOF_BEARERS);
+  std::vector<uint32_t> idx = lookup_order(NOF_BEARERS);
+  uint64_t sum = 0;
+
+  std::map<uint32_t, uint32_t> m;
+  fwd_map<uint32_t>            h;
+  teid_table<uint32_t>         t(NOF_BEARERS + 1);
+  std::vector<uint32_t>        teids(NOF_BEARERS);
+  for (uint32_t i = 0; i < NOF_BEARERS; i++) {
+    m[ips[i]] = i;
+    h.insert(ips[i], i);
+    teids[i] = t.add(i);
+  }
+
+  double t0 = now_ns();
+  for (uint32_t i = 0; i < NOF_LOOKUPS; i++) {
+    sum += m.find(ips[idx[i]])->second;
+  }
+  double t1 = now_ns();
+  for (uint32_t i = 0; i < NOF_LOOKUPS; i++) {
+    sum += *h.find(ips[idx[i]]);
+  }
+  double t2 = now_ns();
+  for (uint32_t i = 0; i < NOF_LOOKUPS; i++) {
+    sum += *t.find(teids[idx[i]]);
+  }
+  double t3 = now_ns();
+
+  printf("%d bearers, random lookups:\n", NOF_BEARERS);
+  printf("  std::map   by UE IP %6.1f ns/op\n", (t1 - t0) / NOF_LOOKUPS);
+  printf("  fwd_map    by UE IP %6.1f ns/op\n", (t2 - t1) / NOF_LOOKUPS);
+  printf("  teid_table by TEID  %6.1f ns/op\n", (t3 - t2) / NOF_LOOKUPS);
+  printf("  (checksum %lu)\n", (unsigned long) sum);
+}
+
+int main(int argc, char **argv)
+{
+  bool result = compare_fwd_map();
+  printf("fwd_map vs std::map: %s\n", result ? "ok" : "FAILED");
+  bool ok = test_teid_table();
+  printf("teid_table: %s\n", ok ? "ok" : "FAILED");
+  result &= ok;
+
+  benchmark();
+
+  if (result) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
@@ -0,0 +1,275 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "srslte/common/log_filter.h"
+#include "srslte/upper/gtpu.h"
+
+#define NOF_BENCH_PKTS 20000000
+
+using namespace srslte;
+
+log_filter gtpu_log("GTPU");
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FUNCTION__, __LINE__, #cond); return false; } } while (0)
+
+void fill_pdu(byte_buffer_t *pdu, uint32_t len)
+{
+  pdu->reset();
+  for (uint32_t i = 0; i < len; i++) {
+    pdu->msg[i] = i;
+  }
+  pdu->N_bytes = len;
+}
+
+bool tpdu_roundtrip(byte_buffer_t *pdu)
+{
+  gtpu_header_t header;
+  bzero(&header, sizeof(header));
+  header.flags        = 0x30;
+  header.message_type = 0xFF;
+  header.teid         = 0x12345678;
+
+  fill_pdu(pdu, 100);
+  CHECK(gtpu_write_header(&header, pdu, &gtpu_log));
+  uint8_t expected[GTPU_HEADER_LEN] = {0x30, 0xFF, 0x00, 100, 0x12, 0x34, 0x56, 0x78};
+  CHECK(pdu->N_bytes == 108 && memcmp(pdu->msg, expected, sizeof(expected)) == 0);
+
+  // The per-bearer template must produce the same bytes
+  fill_pdu(pdu, 100);
+  CHECK(gtpu_write_tpdu(gtpu_tpdu_template(0x12345678), pdu));
+  CHECK(pdu->N_bytes == 108 && memcmp(pdu->msg, expected, sizeof(expected)) == 0);
+
+  gtpu_header_t rx;
+  CHECK(gtpu_read_header(pdu, &rx, &gtpu_log));
+  CHECK(rx.flags == 0x30 && rx.message_type == GTPU_MSG_DATA_PDU && rx.length == 100 && rx.teid == 0x12345678);
+  CHECK(pdu->N_bytes == 100 && pdu->msg[0] == 0 && pdu->msg[99] == 99);
+  return true;
+}
+
+bool optional_fields(byte_buffer_t *pdu)
+{
+  gtpu_header_t header;
+  bzero(&header, sizeof(header));
+  header.flags        = GTPU_FLAGS_VERSION_V1 | GTPU_FLAGS_GTP_PROTOCOL | GTPU_FLAGS_SEQUENCE | GTPU_FLAGS_PACKET_NUM;
+  header.message_type = GTPU_MSG_DATA_PDU;
+  header.teid         = 7;
+  header.seq_number   = 0xBEEF;
+  header.n_pdu        = 0x42;
+
+  fill_pdu(pdu, 10);
+  CHECK(gtpu_write_header(&header, pdu, &gtpu_log));
+  CHECK(pdu->N_bytes == 22 && header.length == 14);
+
+  gtpu_header_t rx;
+  CHECK(gtpu_read_header(pdu, &rx, &gtpu_log));
+  CHECK(rx.seq_number == 0xBEEF && rx.n_pdu == 0x42 && rx.teid == 7 && rx.length == 14);
+  CHECK(pdu->N_bytes == 10 && pdu->msg[0] == 0);
+  return true;
+}
+
+bool extension_headers(byte_buffer_t *pdu)
+{
+  // PDCP PDU number (0xC0) followed by a two-unit unknown header, then 3 payload bytes
+  uint8_t raw[] = {0x34, 0xFF, 0x00, 4 + 4 + 8 + 3, 0, 0, 0, 9,
+                   0x00, 0x01, 0x00, 0xC0,
+                   0x01, 0xAA, 0xBB, 0x81,
+                   0x02, 1, 2, 3, 4, 5, 6, 0x00,
+                   0xD0, 0xD1, 0xD2};
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+
+  gtpu_header_t rx;
+  CHECK(gtpu_read_header(pdu, &rx, &gtpu_log));
+  CHECK(rx.next_ext_hdr_type == 0xC0 && rx.seq_number == 1 && rx.teid == 9);
+  CHECK(pdu->N_bytes == 3 && pdu->msg[0] == 0xD0);
+
+  // Extension header that claims to run past the end of the PDU
+  raw[16] = 0x03;
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+  CHECK(!gtpu_read_header(pdu, &rx, &gtpu_log));
+
+  // Zero-length extension header
+  raw[16] = 0x00;
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+  CHECK(!gtpu_read_header(pdu, &rx, &gtpu_log));
+  return true;
+}
+
+bool malformed(byte_buffer_t *pdu)
+{
+  gtpu_header_t rx;
+  uint8_t raw[] = {0x30, 0xFF, 0x00, 0x04, 0, 0, 0, 1, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF};
+
+  // Trailing padding is trimmed to the length field
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+  CHECK(gtpu_read_header(pdu, &rx, &gtpu_log) && pdu->N_bytes == 4);
+
+  // Length field beyond the end of the PDU
+  raw[3] = 0x20;
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+  CHECK(!gtpu_read_header(pdu, &rx, &gtpu_log));
+
+  // GTP' and version 2 are rejected
+  raw[0] = 0x20;
+  raw[3] = 0x04;
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+  CHECK(!gtpu_read_header(pdu, &rx, &gtpu_log));
+  raw[0] = 0x50;
+  pdu->reset();
+  memcpy(pdu->msg, raw, sizeof(raw));
+  pdu->N_bytes = sizeof(raw);
+  CHECK(!gtpu_read_header(pdu, &rx, &gtpu_log));
+
+  pdu->reset();
+  pdu->N_bytes = 5;
+  CHECK(!gtpu_read_header(pdu, &rx, &gtpu_log));
+  return true;
+}
+
+bool echo(byte_buffer_t *pdu)
+{
+  CHECK(gtpu_write_echo_request(0x1234, pdu, &gtpu_log));
+  uint8_t expected_req[] = {0x32, GTPU_MSG_ECHO_REQUEST, 0x00, 0x04, 0, 0, 0, 0, 0x12, 0x34, 0x00, 0x00};
+  CHECK(pdu->N_bytes == sizeof(expected_req) && memcmp(pdu->msg, expected_req, sizeof(expected_req)) == 0);
+
+  gtpu_header_t rx;
+  CHECK(gtpu_read_header(pdu, &rx, &gtpu_log));
+  CHECK(rx.message_type == GTPU_MSG_ECHO_REQUEST && rx.seq_number == 0x1234 && pdu->N_bytes == 0);
+
+  CHECK(gtpu_write_echo_response(&rx, pdu, &gtpu_log));
+  uint8_t expected_resp[] = {0x32, GTPU_MSG_ECHO_RESPONSE, 0x00, 0x06, 0, 0, 0, 0, 0x12, 0x34, 0x00, 0x00, GTPU_IE_RECOVERY, 0x00};
+  CHECK(pdu->N_bytes == sizeof(expected_resp) && memcmp(pdu->msg, expected_resp, sizeof(expected_resp)) == 0);
+  return true;
+}
+
+// The byte-wise writer this codec replaced, as baseline
+void bytewise_write(gtpu_header_t *header, byte_buffer_t *pdu)
+{
+  pdu->msg     -= GTPU_HEADER_LEN;
+  pdu->N_bytes += GTPU_HEADER_LEN;
+  uint8_t *ptr = pdu->msg;
+  *ptr++ = header->flags;
+  *ptr++ = header->message_type;
+  uint16_to_uint8(header->length, ptr);
+  ptr += 2;
+  uint32_to_uint8(header->teid, ptr);
+}
+
+double now_ns()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1e9 + tv.tv_usec * 1e3;
+}
+
+void benchmark(byte_buffer_t *pdu)
+{
+  gtpu_header_t header;
+  bzero(&header, sizeof(header));
+  header.flags        = 0x30;
+  header.message_type = 0xFF;
+  header.teid         = 0x01020304;
+  gtpu_tpdu_template_t tmpl = gtpu_tpdu_template(header.teid);
+  uint8_t *msg = pdu->msg;
+  uint64_t sum = 0;
+
+  fill_pdu(pdu, 1400);
+  double t0 = now_ns();
+  for (uint32_t i = 0; i < NOF_BENCH_PKTS; i++) {
+    pdu->msg     = msg;
+    pdu->N_bytes = 1400 + (i & 63);
+    header.length = pdu->N_bytes;
+    bytewise_write(&header, pdu);
+    sum += pdu->msg[3];
+  }
+  double t1 = now_ns();
+  for (uint32_t i = 0; i < NOF_BENCH_PKTS; i++) {
+    pdu->msg     = msg;
+    pdu->N_bytes = 1400 + (i & 63);
+    gtpu_write_header(&header, pdu, &gtpu_log);
+    sum += pdu->msg[3];
+  }
+  double t2 = now_ns();
+  for (uint32_t i = 0; i < NOF_BENCH_PKTS; i++) {
+    pdu->msg     = msg;
+    pdu->N_bytes = 1400 + (i & 63);
+    gtpu_write_tpdu(tmpl, pdu);
+    sum += pdu->msg[3];
+  }
+  double t3 = now_ns();
+  gtpu_header_t rx;
+  for (uint32_t i = 0; i < NOF_BENCH_PKTS; i++) {
+    pdu->msg     = msg - GTPU_HEADER_LEN;
+    pdu->N_bytes = 1400 + 63 + GTPU_HEADER_LEN;
+    gtpu_read_header(pdu, &rx, &gtpu_log);
+    sum += rx.teid;
+  }
+  double t4 = now_ns();
+
+  printf("T-PDU header, %d packets:\n", NOF_BENCH_PKTS);
+  printf("  byte-wise write    %7.1f Mpkts/s\n", NOF_BENCH_PKTS / (t1 - t0) * 1e3);
+  printf("  gtpu_write_header  %7.1f Mpkts/s\n", NOF_BENCH_PKTS / (t2 - t1) * 1e3);
+  printf("  gtpu_write_tpdu    %7.1f Mpkts/s\n", NOF_BENCH_PKTS / (t3 - t2) * 1e3);
+  printf("  gtpu_read_header   %7.1f Mpkts/s\n", NOF_BENCH_PKTS / (t4 - t3) * 1e3);
+  printf("  (checksum %lu)\n", (unsigned long) sum);
+}
+
+int main(int argc, char **argv)
+{
+  gtpu_log.set_level(LOG_LEVEL_NONE);
+  byte_buffer_t *pdu = new byte_buffer_t;
+
+  bool result = tpdu_roundtrip(pdu);
+  result &= optional_fields(pdu);
+  result &= extension_headers(pdu);
+  result &= malformed(pdu);
+  result &= echo(pdu);
+
+  benchmark(pdu);
+  delete pdu;
+
+  if (result) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
@@ -45,6 +45,7 @@
 #include "srslte/common/buffer_pool.h"
 #include "srslte/interfaces/ue_interfaces.h"
 #include "srslte/common/logger_file.h"
+#include "srslte/common/logger_async.h"
 #include "srslte/common/log_filter.h"
 #include "srslte/interfaces/sched_interface.h"
 #include "srslte/interfaces/enb_metrics_interface.h"
@@ -87,6 +88,7 @@ typedef struct {
   int           all_hex_limit;
   int           file_max_size;
   std::string   filename;
+  bool          async;
 }log_args_t;
 
 typedef struct {
@@ -156,6 +158,7 @@ private:
 
   srslte::logger_stdout logger_stdout;
   srslte::logger_file   logger_file;
+  srslte::logger_async  logger_async;
   srslte::logger        *logger;
 
   srslte::log_filter  rf_log;
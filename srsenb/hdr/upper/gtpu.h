@@ -33,6 +33,8 @@
 #include "srslte/common/threads.h"
 #include "srslte/srslte.h"
 #include "srslte/interfaces/enb_interfaces.h"
+#include "srslte/upper/gtpu.h"
+#include "srslte/upper/gtpu_fwd_table.h"
 
 #ifndef SRSENB_GTPU_H
 #define SRSENB_GTPU_H
@@ -121,8 +123,10 @@ private:
     uint32_t teids_in[SRSENB_N_RADIO_BEARERS];
     uint32_t teids_out[SRSENB_N_RADIO_BEARERS];
     uint32_t spgw_addrs[SRSENB_N_RADIO_BEARERS];
+    srslte::gtpu_tpdu_template_t hdr_tmpls[SRSENB_N_RADIO_BEARERS];
+    struct sockaddr_in           spgw_sockaddrs[SRSENB_N_RADIO_BEARERS];
   }bearer_map;
-  std::map<uint16_t, bearer_map> rnti_bearers;
+  srslte::fwd_map<bearer_map> rnti_bearers;
 
   // Socket file descriptors
   int snk_fd;
@@ -28,16 +28,20 @@
 #define SRSENB_RRC_H
 
 #include <map>
+#include <vector>
 #include <queue>
+#include <sys/socket.h>
+#include <endian.h>
 #include "srslte/common/buffer_pool.h"
 #include "srslte/common/common.h"
-#include "srslte/common/block_queue.h"
+#include "srslte/common/ring_queue.h"
 #include "srslte/common/threads.h"
 #include "srslte/common/timeout.h"
 #include "srslte/common/log.h"
 #include "srslte/interfaces/enb_interfaces.h"
 #include "common_enb.h"
 #include "rrc_metrics.h"
+#include "rrc_ue_table.h"
 
 #define SRSENB_RRC_ATTACH 0x01
 #define SRSENB_RRC_NORMAL 0x02
@@ -54,11 +58,25 @@
 #define RRC_RECEIVE_LEN sizeof(rrc_receive_head)
 #define RRC_SEND_LEN sizeof(rrc_send_head)
 
+// Maximum number of datagrams drained/flushed per recvmmsg/sendmmsg call
+#define SRSENB_RRC_MAX_BATCH 64
+
+// Capacity of each shard's downlink PDU queue, pushes block when it is full
+#define SRSENB_RRC_PDU_QUEUE_LEN 4096
+
+// Maximum number of RRC shards (each one a SO_REUSEPORT socket + 2 threads)
+#define SRSENB_RRC_MAX_SHARDS 32
+// Byte of the ueid from which the 32-bit shard key is read (last 4 bytes)
+#define SRSENB_RRC_SHARD_KEY_OFFSET 11
+
 namespace srsenb {
 
 typedef struct {
   std::string rrc_bind_addr;
   uint32_t rrc_bind_port;
+  uint32_t rrc_batch_size;
+  uint32_t rrc_nof_shards;
+  bool     rrc_dl_fast_path;
 } rrc_args_t;
 
 
@@ -73,14 +91,20 @@ public:
     s1ap = NULL;
     gtpu_pdcp = NULL;
     log_h = NULL;
+    nof_shards = 0;
+    dl_fast_path = false;
   }
+  ~rrc();
 
   void init(s1ap_interface_rrc *s1ap,
             gtpu_interface_rrc *gtpu,
             gtpu_interface_pdcp *gtpu_pdcp,
             srslte::log *log_rrc,
             std::string bind_addr,
-            uint32_t bind_port);
+            uint32_t bind_port,
+            uint32_t batch_size = 1,
+            uint32_t nof_shards = 1,
+            bool dl_fast_path = false);
 
   void stop();
 
@@ -100,32 +124,33 @@ public:
   gtpu_interface_pdcp  *gtpu_pdcp;
   srslte::log          *log_h;
 
-  typedef struct ueid_t{
-    uint8_t value[15];
-    bool operator < (const ueid_t &ue) const {
-        int i;
-        for(i = 0;i < 14 && ue.value[i] == value[i];i ++);
-        return value[i] < ue.value[i];
-    }
-    uint8_t& operator [] (int i) {
-        return value[i];
-    }
-  }ueid;
-
-
-  typedef struct rrc_receive_head_t {
-    uint8_t type;
-    uint8_t ip[4];
-    uint8_t port[2];
-    struct ueid_t id;
+  typedef rrc_ueid_t ueid;
+
+  /* Wire views of the RRC datagram headers. They are packed so they can
+   * be overlaid on the datagram buffer and read/written in place, the
+   * layout matches what the UE side has always sent (28 and 18 bytes).
+   * Multi-byte fields are little endian, use the accessors below.
+   */
+  typedef struct __attribute__((packed)) rrc_receive_head_t {
+    uint8_t  type;
+    uint8_t  ip[4];
+    uint8_t  port[2];
+    ueid     id;
     uint16_t lcid;
-    LIBLTE_S1AP_RRC_ESTABLISHMENT_CAUSE_ENUM cause;
+    uint32_t cause;
+
+    uint32_t get_lcid() const { return le16toh(lcid); }
+    LIBLTE_S1AP_RRC_ESTABLISHMENT_CAUSE_ENUM get_cause() const {
+      return (LIBLTE_S1AP_RRC_ESTABLISHMENT_CAUSE_ENUM) le32toh(cause);
+    }
   } rrc_receive_head;
 
-  typedef struct rrc_send_head_t {
-    uint8_t type;
-    struct ueid_t id;
+  typedef struct __attribute__((packed)) rrc_send_head_t {
+    uint8_t  type;
+    ueid     id;
     uint16_t lcid;
+
+    void set_lcid(uint32_t l) { lcid = htole16((uint16_t) l); }
   } rrc_send_head;
 
   typedef struct {
@@ -134,28 +159,80 @@ public:
     srslte::byte_buffer_t*  pdu;
   }rrc_pdu;
 
-  srslte::block_queue<rrc_pdu> pdu_queue;
-  std::map<uint16_t, sockaddr_in> addr_map;
-  std::map<uint16_t, ueid> rnti_map;
-  std::map<ueid, uint16_t> ueid_map;
+  /* A shard owns one SO_REUSEPORT socket, one downlink queue and the slice
+   * of the UE tables for the UEs hashed to it. A UE is owned by shard
+   * ueid_to_shard(id) and all its RNTIs satisfy rnti_to_shard(rnti) == idx,
+   * so its uplink and downlink are served by the same pair of threads.
+   */
+  class shard
+  {
+  public:
+    shard(rrc *parent_, uint32_t idx_);
+    bool init(std::string bind_addr, uint32_t bind_port, uint32_t batch_size_);
+    void stop();
+
+    rrc                          *parent;
+    uint32_t                      idx;
+    srslte::log                  *log_h;
+    srslte::byte_buffer_pool     *pool;
+
+    srslte::mpmc_queue<rrc_pdu>   pdu_queue;
+    rrc_ue_table                  users;
+    pthread_mutex_t               user_mutex;
+
+    int sock_fd;
+
+    // Batched I/O: datagrams are drained/flushed with recvmmsg/sendmmsg.
+    // The rx ring buffers stay pinned to the shard unless handed over to GTP-U.
+    uint32_t               batch_size;
+    srslte::byte_buffer_t *rx_ring[SRSENB_RRC_MAX_BATCH];
+    struct iovec           rx_iovs[SRSENB_RRC_MAX_BATCH];
+    struct mmsghdr         rx_msgs[SRSENB_RRC_MAX_BATCH];
+    rrc_pdu                tx_pdus[SRSENB_RRC_MAX_BATCH];
+    sockaddr_in            tx_addrs[SRSENB_RRC_MAX_BATCH];
+    struct iovec           tx_iovs[SRSENB_RRC_MAX_BATCH];
+    struct mmsghdr         tx_msgs[SRSENB_RRC_MAX_BATCH];
+
+    bool find_rnti(const ueid &id, uint16_t *rnti);
+    bool find_ueid(uint16_t rnti, ueid *id);
+    bool add_user(const ueid &id, sockaddr_in addr, uint16_t *rnti);
+    bool rem_user(uint16_t rnti);
+
+    bool handle_uplink(srslte::byte_buffer_t *sdu);
+    bool handle_normal(const rrc_receive_head *head, srslte::byte_buffer_t *sdu);
+    void handle_attach(const rrc_receive_head *head, srslte::byte_buffer_t *sdu);
+    bool handle_data(const rrc_receive_head *head, srslte::byte_buffer_t *sdu);
+
+    bool prepare_downlink(rrc_pdu pdu, uint8_t type, sockaddr_in *addr);
+    bool send_normal(rrc_pdu pdu);
+    bool send_paging(rrc_pdu pdu);
+    void send_direct(rrc_pdu pdu);
+
+    void rx_ring_refill(uint32_t i);
+    void receive_uplink_batch();
+    void send_downlink_batch();
+
+    void send_downlink();
+    void receive_uplink();
+  };
+
+  uint32_t             nof_shards;
+  bool                 dl_fast_path;
+  std::vector<shard*>  shards;
   std::map<uint16_t, uint8_t> page_map;
 
-  int sock_fd;
-  int send_fd;
-
-  pthread_mutex_t user_mutex;
+  pthread_mutex_t s1ap_mutex;
   pthread_mutex_t paging_mutex;
 
-  void handle_normal(rrc_receive_head head, srslte::byte_buffer_t *sdu);
-  void handle_attach(rrc_receive_head head, srslte::byte_buffer_t *sdu);
-  void handle_data(rrc_receive_head head, srslte::byte_buffer_t *sdu);
-
-  bool send_normal(rrc_pdu pdu);
-  bool send_paging(rrc_pdu pdu);
-  void append_head(rrc_pdu pdu);
+  uint32_t get_nof_shards();
+  uint32_t ueid_to_shard(const ueid &id);
+  uint32_t rnti_to_shard(uint16_t rnti);
+  void     push_pdu(rrc_pdu pdu);
+  bool     push_nas_pdu(uint16_t rnti, LIBLTE_S1AP_NAS_PDU_STRUCT *nas_pdu);
+  bool     attach_steering_filter();
 
-  void send_downlink();
-  void receive_uplink();
+  void send_downlink(uint32_t shard_idx = 0);
+  void receive_uplink(uint32_t shard_idx = 0);
 };
 
 } // namespace srsenb
@@ -0,0 +1,109 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        rrc_ue_table.h
+ * Description: UE context table of one RRC shard. Contexts (rnti, ueid and
+ *              UE address) live in a flat array indexed by RNTI, free RNTIs
+ *              are kept in a FIFO free-list and an open-addressing index
+ *              maps the ueid to its RNTI. All operations are O(1).
+ *****************************************************************************/
+
+#ifndef SRSENB_RRC_UE_TABLE_H
+#define SRSENB_RRC_UE_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <netinet/in.h>
+
+namespace srsenb {
+
+#define SRSENB_RRC_UEID_LEN 15
+
+typedef struct rrc_ueid_t {
+  uint8_t value[SRSENB_RRC_UEID_LEN];
+  bool operator == (const rrc_ueid_t &ue) const {
+    return memcmp(value, ue.value, SRSENB_RRC_UEID_LEN) == 0;
+  }
+  uint8_t& operator [] (int i) {
+    return value[i];
+  }
+  const uint8_t& operator [] (int i) const {
+    return value[i];
+  }
+} rrc_ueid_t;
+
+class rrc_ue_table
+{
+public:
+  rrc_ue_table();
+
+  // Manages the RNTIs first_rnti + k*rnti_step below 0xFFFF
+  void init(uint32_t first_rnti, uint32_t rnti_step);
+  void clear();
+
+  bool add(const rrc_ueid_t &id, const sockaddr_in &addr, uint16_t *rnti);
+  bool rem(uint16_t rnti);
+  bool find_rnti(const rrc_ueid_t &id, uint16_t *rnti);
+  bool find_ctx(uint16_t rnti, rrc_ueid_t *id, sockaddr_in *addr);
+
+  uint32_t size();
+  uint32_t capacity();
+
+private:
+  static const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+  typedef struct {
+    rrc_ueid_t  id;
+    bool        active;
+    uint16_t    rnti;
+    uint32_t    hash;
+    uint32_t    next_free;
+    sockaddr_in addr;
+  } ue_ctx_t;
+
+  // Index entry: 0 is empty, otherwise the RNTI of the context
+  std::vector<uint16_t> index;
+  std::vector<ue_ctx_t> ctx;
+
+  uint32_t first_rnti;
+  uint32_t rnti_step;
+  uint32_t index_mask;
+  uint32_t free_head;
+  uint32_t free_tail;
+  uint32_t nof_users;
+
+  static uint32_t hash_ueid(const rrc_ueid_t &id);
+  bool     rnti_to_slot(uint16_t rnti, uint32_t *slot);
+  uint32_t slot_of(uint16_t rnti);
+  bool     index_find(const rrc_ueid_t &id, uint32_t hash, uint32_t *pos);
+  void     index_erase(uint32_t pos);
+};
+
+} // namespace srsenb
+
+#endif // SRSENB_RRC_UE_TABLE_H
@@ -71,6 +71,10 @@ bool enb::init(all_args_t *args_)
 
   if (!args->log.filename.compare("stdout")) {
     logger = &logger_stdout;
+  } else if (args->log.async) {
+    logger_async.init(args->log.filename, args->log.file_max_size);
+    logger_async.log("\n\n");
+    logger = &logger_async;
   } else {
     logger_file.init(args->log.filename, args->log.file_max_size);
     logger_file.log("\n\n");
@@ -117,7 +121,7 @@ bool enb::init(all_args_t *args_)
  // end here
 
   // Init all layers
-  rrc.init(&s1ap, &gtpu, &gtpu, &rrc_log, args->enb.rrc.rrc_bind_addr, args->enb.rrc.rrc_bind_port);
+  rrc.init(&s1ap, &gtpu, &gtpu, &rrc_log, args->enb.rrc.rrc_bind_addr, args->enb.rrc.rrc_bind_port, args->enb.rrc.rrc_batch_size, args->enb.rrc.rrc_nof_shards, args->enb.rrc.rrc_dl_fast_path);
   s1ap.init(args->enb.s1ap, &rrc, &s1ap_log);
   gtpu.init(args->enb.s1ap.gtp_bind_addr, args->enb.s1ap.mme_addr, &rrc, &gtpu_log, args->expert.enable_mbsfn);
 
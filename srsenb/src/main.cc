@@ -34,6 +34,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <boost/program_options.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <srsenb/hdr/enb.h>
@@ -81,6 +82,9 @@ void parse_args(all_args_t *args, int argc, char* argv[]) {
     ("enb.s1c_bind_addr", bpo::value<string>(&args->enb.s1ap.s1c_bind_addr)->default_value("192.168.3.1"), "Local IP address to bind for S1AP connection")
     ("enb.rrc_bind_addr", bpo::value<string>(&args->enb.rrc.rrc_bind_addr)->default_value("127.0.0.1"), "IP address for UE to connect")
     ("enb.rrc_bind_port", bpo::value<uint32_t>(&args->enb.rrc.rrc_bind_port)->default_value(10001), "Port for UE to connect")
+    ("enb.rrc_batch_size",bpo::value<uint32_t>(&args->enb.rrc.rrc_batch_size)->default_value(1),      "Datagrams per recvmmsg/sendmmsg call on the RRC socket (1 disables batching)")
+    ("enb.rrc_nof_shards",bpo::value<uint32_t>(&args->enb.rrc.rrc_nof_shards)->default_value(1),      "Number of RRC shards, each with its own SO_REUSEPORT socket and uplink/downlink threads")
+    ("enb.rrc_dl_fast_path",bpo::value<bool>(&args->enb.rrc.rrc_dl_fast_path)->default_value(false), "Send DRB downlink PDUs straight from the GTP-U thread instead of queueing them")
     ("enb.phy_cell_id",   bpo::value<uint32_t>(&args->enb.pci)->default_value(0),                  "Physical Cell Identity (PCI)")
     ("enb.n_prb",         bpo::value<uint32_t>(&args->enb.n_prb)->default_value(25),               "Number of PRB")
     ("enb.nof_ports",     bpo::value<uint32_t>(&args->enb.nof_ports)->default_value(1),            "Number of ports")
@@ -108,6 +112,7 @@ void parse_args(all_args_t *args, int argc, char* argv[]) {
 
     ("log.filename",      bpo::value<string>(&args->log.filename)->default_value("/tmp/ue.log"),"Log filename")
     ("log.file_max_size", bpo::value<int>(&args->log.file_max_size)->default_value(-1), "Maximum file size (in kilobytes). When passed, multiple files are created. Default -1 (single file)")
+    ("log.async",         bpo::value<bool>(&args->log.async)->default_value(false), "Queue log arguments and format them in the logger thread")
 
     /* Expert section */
 
@@ -263,23 +268,43 @@ void sig_int_handler(int signo)
   }
 }
 
+typedef struct {
+  rrc*     _rrc;
+  uint32_t shard;
+} rrc_thread_args_t;
+
 void* receive_loop(void* arg) {
-   rrc* _rrc = (rrc*) arg;
+   rrc_thread_args_t* a = (rrc_thread_args_t*) arg;
    while(true) {
        pthread_testcancel();
-       _rrc->receive_uplink();
+       a->_rrc->receive_uplink(a->shard);
    }
 }
 
 void* send_loop(void* arg) {
     // TODO parse here
-    rrc* _rrc = (rrc*) arg;
+    rrc_thread_args_t* a = (rrc_thread_args_t*) arg;
     while(true) {
         pthread_testcancel();
-        _rrc->send_downlink();
+        a->_rrc->send_downlink(a->shard);
     }
 }
 
+// Uplink and downlink threads of one shard share a core
+void set_shard_affinity(pthread_t tid, uint32_t shard)
+{
+  long nof_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nof_cpus <= 1) {
+    return;
+  }
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(shard % nof_cpus, &cpuset);
+  if (pthread_setaffinity_np(tid, sizeof(cpu_set_t), &cpuset)) {
+    perror("pthread_setaffinity_np");
+  }
+}
+
 void *input_loop(void *m)
 {
   metrics_stdout *metrics = (metrics_stdout*) m;
@@ -324,11 +349,22 @@ int main(int argc, char *argv[])
   metrics.init(enb, args.expert.metrics_period_secs);
 
   pthread_t input;
-  pthread_t send_tid;
-  pthread_t receive_tid;
   pthread_create(&input, NULL, &input_loop, &metrics);
-  pthread_create(&send_tid, NULL, &send_loop, &(enb->rrc));
-  pthread_create(&receive_tid, NULL, &receive_loop, &(enb->rrc));
+
+  uint32_t nof_shards = enb->rrc.get_nof_shards();
+  std::vector<pthread_t> send_tid(nof_shards);
+  std::vector<pthread_t> receive_tid(nof_shards);
+  std::vector<rrc_thread_args_t> rrc_thread_args(nof_shards);
+  for (uint32_t i = 0; i < nof_shards; i++) {
+    rrc_thread_args[i]._rrc  = &(enb->rrc);
+    rrc_thread_args[i].shard = i;
+    pthread_create(&send_tid[i], NULL, &send_loop, &rrc_thread_args[i]);
+    pthread_create(&receive_tid[i], NULL, &receive_loop, &rrc_thread_args[i]);
+    if (nof_shards > 1) {
+      set_shard_affinity(send_tid[i], i);
+      set_shard_affinity(receive_tid[i], i);
+    }
+  }
 
   bool plot_started         = false;
   bool signals_pregenerated = false;
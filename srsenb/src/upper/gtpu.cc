@@ -140,24 +140,31 @@ void gtpu::stop()
 void gtpu::write_pdu(uint16_t rnti, uint32_t lcid, srslte::byte_buffer_t* pdu)
 {
   gtpu_log->info_hex(pdu->msg, pdu->N_bytes, "TX PDU, RNTI: 0x%x, LCID: %d, n_bytes=%d", rnti, lcid, pdu->N_bytes);
-  gtpu_header_t header;
-  header.flags        = 0x30;
-  header.message_type = 0xFF;
-  header.length       = pdu->N_bytes;
-  header.teid         = rnti_bearers[rnti].teids_out[lcid];
-
-  struct sockaddr_in servaddr;
-  servaddr.sin_family      = AF_INET;
-  servaddr.sin_addr.s_addr = htonl(rnti_bearers[rnti].spgw_addrs[lcid]);
-  servaddr.sin_port        = htons(GTPU_PORT);
-
-  gtpu_write_header(&header, pdu, gtpu_log);
+
+  // Called concurrently by the RRC shards, look up without inserting
+  pthread_mutex_lock(&mutex);
+  bearer_map *bearers = rnti_bearers.find(rnti);
+  if (!bearers || lcid >= SRSENB_N_RADIO_BEARERS) {
+    pthread_mutex_unlock(&mutex);
+    gtpu_log->warning("Unknown bearer for UL PDU, RNTI: 0x%x, LCID: %d - dropping packet\n", rnti, lcid);
+    pool->deallocate(pdu);
+    return;
+  }
+  gtpu_tpdu_template_t hdr_tmpl = bearers->hdr_tmpls[lcid];
+  struct sockaddr_in   servaddr = bearers->spgw_sockaddrs[lcid];
+  pthread_mutex_unlock(&mutex);
+
+  if(!gtpu_write_tpdu(hdr_tmpl, pdu)) {
+    gtpu_log->error("No room in PDU for GTP-U header\n");
+    pool->deallocate(pdu);
+    return;
+  }
   ssize_t len = 0;
   len = sendto(snk_fd, pdu->msg, pdu->N_bytes, MSG_EOR, (struct sockaddr*)&servaddr, sizeof(struct sockaddr_in));
   if(len < 0) {
     perror("sendto");
   }
-  gtpu_log->console("Send to SPGW len:%d\n", (uint32_t)len);
+  gtpu_log->debug("Send to SPGW len:%d\n", (uint32_t)len);
 
   pool->deallocate(pdu);
 }
@@ -175,17 +182,25 @@ void gtpu::add_bearer(uint16_t rnti, uint32_t lcid, uint32_t addr, uint32_t teid
   }
 
   // Initialize maps if it's a new RNTI
-  if(rnti_bearers.count(rnti) == 0) {
-    for(int i=0;i<SRSENB_N_RADIO_BEARERS;i++) {
-      rnti_bearers[rnti].teids_in[i]  = 0;
-      rnti_bearers[rnti].teids_out[i] = 0;
-      rnti_bearers[rnti].spgw_addrs[i] = 0;
-    }
+  pthread_mutex_lock(&mutex);
+  bearer_map *bearers = rnti_bearers.find(rnti);
+  if(!bearers) {
+    bearer_map empty;
+    bzero(&empty, sizeof(empty));
+    bearers = rnti_bearers.insert(rnti, empty);
   }
 
-  rnti_bearers[rnti].teids_in[lcid]  = *teid_in;
-  rnti_bearers[rnti].teids_out[lcid] = teid_out;
-  rnti_bearers[rnti].spgw_addrs[lcid] = addr;
+  bearers->teids_in[lcid]  = *teid_in;
+  bearers->teids_out[lcid] = teid_out;
+  bearers->spgw_addrs[lcid] = addr;
+
+  // Everything write_pdu() needs, so it does not rebuild it per packet
+  bearers->hdr_tmpls[lcid] = gtpu_tpdu_template(teid_out);
+  bzero(&bearers->spgw_sockaddrs[lcid], sizeof(struct sockaddr_in));
+  bearers->spgw_sockaddrs[lcid].sin_family      = AF_INET;
+  bearers->spgw_sockaddrs[lcid].sin_addr.s_addr = htonl(addr);
+  bearers->spgw_sockaddrs[lcid].sin_port        = htons(GTPU_PORT);
+  pthread_mutex_unlock(&mutex);
 }
 
 void gtpu::rem_bearer(uint16_t rnti, uint32_t lcid)
@@ -193,13 +208,18 @@ void gtpu::rem_bearer(uint16_t rnti, uint32_t lcid)
   pthread_mutex_lock(&mutex);
   gtpu_log->info("Removing bearer for rnti: 0x%x, lcid: %d\n", rnti, lcid);
 
-  rnti_bearers[rnti].teids_in[lcid]  = 0;
-  rnti_bearers[rnti].teids_out[lcid] = 0;
+  bearer_map *bearers = rnti_bearers.find(rnti);
+  if(!bearers) {
+    pthread_mutex_unlock(&mutex);
+    return;
+  }
+  bearers->teids_in[lcid]  = 0;
+  bearers->teids_out[lcid] = 0;
 
   // Remove RNTI if all bearers are removed
   bool rem = true;
   for(int i=0;i<SRSENB_N_RADIO_BEARERS; i++) {
-    if(rnti_bearers[rnti].teids_in[i] != 0) {
+    if(bearers->teids_in[i] != 0) {
       rem = false;
     }
   }
@@ -232,26 +252,42 @@ void gtpu::run_thread()
     pdu->reset();
     gtpu_log->debug("Waiting for read...\n");
     int n = 0;
+    struct sockaddr_in src_addr;
+    socklen_t addrlen = sizeof(src_addr);
     do{
-      n = recv(src_fd, pdu->msg, SRSENB_MAX_BUFFER_SIZE_BYTES - SRSENB_BUFFER_HEADER_OFFSET, 0);
-      gtpu_log->console("GTPU: Receive len:%d\n", n);
+      n = recvfrom(src_fd, pdu->msg, SRSENB_MAX_BUFFER_SIZE_BYTES - SRSENB_BUFFER_HEADER_OFFSET, 0, (struct sockaddr *) &src_addr, &addrlen);
+      gtpu_log->debug("GTPU: Receive len:%d\n", n);
     } while (n == -1 && errno == EAGAIN);
 
     if (n < 0) {
         gtpu_log->error("Failed to read from socket\n");
+        continue;
     }
 
     pdu->N_bytes = (uint32_t) n;
 
     gtpu_header_t header;
-    gtpu_read_header(pdu, &header,gtpu_log);
+    if(!gtpu_read_header(pdu, &header,gtpu_log)) {
+      continue;
+    }
+    if(header.message_type == GTPU_MSG_ECHO_REQUEST) {
+      gtpu_log->debug("Echo request from %s, seq %d\n", inet_ntoa(src_addr.sin_addr), header.seq_number);
+      if(gtpu_write_echo_response(&header, pdu, gtpu_log)) {
+        sendto(src_fd, pdu->msg, pdu->N_bytes, 0, (struct sockaddr *) &src_addr, addrlen);
+      }
+      continue;
+    }
+    if(header.message_type != GTPU_MSG_DATA_PDU) {
+      gtpu_log->debug("Ignoring GTP-U message type %d\n", header.message_type);
+      continue;
+    }
 
     uint16_t rnti = 0;
     uint16_t lcid = 0;
     teidin_to_rntilcid(header.teid, &rnti, &lcid);
 
     pthread_mutex_lock(&mutex);
-    bool user_exists = (rnti_bearers.count(rnti) > 0);
+    bool user_exists = (rnti_bearers.find(rnti) != NULL);
     pthread_mutex_unlock(&mutex);
 
     if(!user_exists) {
@@ -380,7 +416,9 @@ void gtpu::mch_thread::run_thread()
     pdu->N_bytes = (uint32_t) n;
 
     gtpu_header_t header;
-    gtpu_read_header(pdu, &header, gtpu_log);
+    if(n < 0 || !gtpu_read_header(pdu, &header, gtpu_log) || header.message_type != GTPU_MSG_DATA_PDU) {
+      continue;
+    }
 
     pdcp->write_sdu(SRSLTE_MRNTI, lcid, pdu);
     do {
@@ -2,6 +2,8 @@
 #include "srsenb/hdr/upper/rrc.h"
 #include "srslte/asn1/liblte_mme.h"
 #include "srslte/asn1/liblte_rrc.h"
+#include <stddef.h>
+#include <linux/filter.h>
 
 using srslte::byte_buffer_t;
 
@@ -12,61 +14,131 @@ void rrc::init(s1ap_interface_rrc* s1ap_,
         gtpu_interface_pdcp* gtpu_pdcp_,
         srslte::log* log_rrc,
         std::string bind_addr,
-        uint32_t bind_port) {
+        uint32_t bind_port,
+        uint32_t batch_size,
+        uint32_t nof_shards_,
+        bool dl_fast_path_) {
     s1ap = s1ap_;
     gtpu = gtpu_;
     gtpu_pdcp = gtpu_pdcp_;
     log_h = log_rrc;
     pool = srslte::byte_buffer_pool::get_instance();
 
-    pthread_mutex_init(&user_mutex, NULL);
+    pthread_mutex_init(&s1ap_mutex, NULL);
     pthread_mutex_init(&paging_mutex, NULL);
 
-    sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    send_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    struct sockaddr_in rrc_addr;
-    int result = 0;
-    if(sock_fd < 0)
-      result = 1;
-    else {
-      memset(&rrc_addr, 0, sizeof(rrc_addr));
-      rrc_addr.sin_family = AF_INET;
-      inet_pton(AF_INET, bind_addr.c_str(), &rrc_addr.sin_addr);
-      rrc_addr.sin_port = htons(bind_port);
-      if(bind(sock_fd, (struct sockaddr*) &rrc_addr, sizeof(rrc_addr)) < 0)
-        result = 2;
-      //rrc_addr.sin_port = htons(bind_port + 1);
-      //if(bind(send_fd, (struct sockaddr*) &rrc_addr, sizeof(rrc_addr)) < 0)
-       //   result = 2;
+    dl_fast_path = dl_fast_path_;
+    nof_shards = nof_shards_;
+    if(nof_shards < 1)
+      nof_shards = 1;
+    if(nof_shards > SRSENB_RRC_MAX_SHARDS) {
+      log_h->warning("RRC nof_shards %d too large, using %d\n", nof_shards, SRSENB_RRC_MAX_SHARDS);
+      nof_shards = SRSENB_RRC_MAX_SHARDS;
     }
-    switch(result) {
-      case 1:
-        log_h->error("Invalid socket fd during rrc\n");
-        log_h->console("Invalid socket fd during rrc\n");
-        break;
-      case 2:
-        log_h->error("Bind error in rrc init\n");
-        log_h->console("Bind error in rrc init\n");
-        break;
-      default:
-        log_h->debug("RRC bind to ip%s:%d\n", bind_addr.c_str(), bind_port);
+    for(uint32_t i = 0;i < nof_shards;i ++) {
+      shards.push_back(new shard(this, i));
+      shards[i]->init(bind_addr, bind_port, batch_size);
     }
+    if(nof_shards > 1) {
+      attach_steering_filter();
+      log_h->info("RRC running %d shards on %s:%d\n", nof_shards, bind_addr.c_str(), bind_port);
+    }
+}
+
+rrc::~rrc() {
+    for(uint32_t i = 0;i < shards.size();i ++)
+      delete shards[i];
+    shards.clear();
 }
 
 void rrc::stop() {
-    pthread_mutex_lock(&user_mutex);
-    rnti_map.clear();
-    ueid_map.clear();
-    addr_map.clear();
-    pthread_mutex_unlock(&user_mutex);
+    for(uint32_t i = 0;i < shards.size();i ++)
+      shards[i]->stop();
     pthread_mutex_lock(&paging_mutex);
     page_map.clear();
     pthread_mutex_unlock(&paging_mutex);
-    pdu_queue.clear();
-    pthread_mutex_destroy(&user_mutex);
+    pthread_mutex_destroy(&s1ap_mutex);
     pthread_mutex_destroy(&paging_mutex);
 }
 
+///////////////////////////////////////
+//
+//   Shard helpers
+//
+///////////////////////////////////////
+
+// The RRC headers are overlaid on the datagrams, their size is the wire format
+typedef char rrc_receive_head_len_check[(sizeof(rrc::rrc_receive_head) == 28) ? 1 : -1];
+typedef char rrc_send_head_len_check[(sizeof(rrc::rrc_send_head) == 18) ? 1 : -1];
+
+/* The NAS PDU lives in the decoded S1AP message, which does not outlive the
+ * call, so it is copied once into the smallest pool buffer that fits. The
+ * copy starts at msg, after the headroom where the RRC header is later
+ * prepended in place.
+ */
+bool rrc::push_nas_pdu(uint16_t rnti, LIBLTE_S1AP_NAS_PDU_STRUCT *nas_pdu) {
+    srslte::byte_buffer_t *sdu = pool_allocate_size(nas_pdu->n_octets);
+    if(!sdu) {
+        log_h->error("Couldn't allocate NAS PDU for rnti:%d\n", rnti);
+        return false;
+    }
+    if(nas_pdu->n_octets > sdu->get_tailroom()) {
+        log_h->error("NAS PDU too long for rnti:%d len:%d\n", rnti, nas_pdu->n_octets);
+        pool->deallocate(sdu);
+        return false;
+    }
+    memcpy(sdu->msg, nas_pdu->buffer, nas_pdu->n_octets);
+    sdu->N_bytes = nas_pdu->n_octets;
+    rrc_pdu pdu = {rnti, RB_ID_SRB1, sdu};
+    push_pdu(pdu);
+    return true;
+}
+
+uint32_t rrc::get_nof_shards() {
+    return nof_shards;
+}
+
+/* Must match the BPF program installed by attach_steering_filter(): the
+ * key is the big-endian 32-bit word at the tail of the ueid.
+ */
+uint32_t rrc::ueid_to_shard(const ueid &id) {
+    uint32_t key = ((uint32_t) id[SRSENB_RRC_SHARD_KEY_OFFSET] << 24) |
+                   ((uint32_t) id[SRSENB_RRC_SHARD_KEY_OFFSET + 1] << 16) |
+                   ((uint32_t) id[SRSENB_RRC_SHARD_KEY_OFFSET + 2] << 8) |
+                   (uint32_t) id[SRSENB_RRC_SHARD_KEY_OFFSET + 3];
+    return key % nof_shards;
+}
+
+uint32_t rrc::rnti_to_shard(uint16_t rnti) {
+    return rnti % nof_shards;
+}
+
+void rrc::push_pdu(rrc_pdu pdu) {
+    shards[rnti_to_shard(pdu.rnti)]->pdu_queue.push(pdu);
+}
+
+/* Installs a classic BPF program on the SO_REUSEPORT group that returns the
+ * index of the shard owning the ueid in the datagram. Without it the kernel
+ * spreads datagrams by 4-tuple hash and the receiving shard forwards them to
+ * the owner's tables, which is still correct but crosses cores.
+ */
+bool rrc::attach_steering_filter() {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+    struct sock_filter code[] = {
+      { BPF_LD  | BPF_W   | BPF_ABS, 0, 0, (uint32_t) (offsetof(rrc_receive_head, id) + SRSENB_RRC_SHARD_KEY_OFFSET) },
+      { BPF_ALU | BPF_MOD | BPF_K,   0, 0, nof_shards },
+      { BPF_RET | BPF_A,             0, 0, 0 },
+    };
+    struct sock_fprog prog;
+    prog.len    = sizeof(code)/sizeof(struct sock_filter);
+    prog.filter = code;
+    if(setsockopt(shards[0]->sock_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == 0)
+      return true;
+#endif
+    log_h->warning("Could not attach RRC shard steering filter, uplink will cross shards\n");
+    return false;
+}
+
 ///////////////////////////////////////
 //
 //   S1AP interface
@@ -74,16 +146,13 @@ void rrc::stop() {
 ///////////////////////////////////////
 void rrc::write_dl_info(uint16_t rnti, srslte::byte_buffer_t *sdu) {
     rrc_pdu p = {rnti, RB_ID_SRB1, sdu};
-    printf("S1ap write dl info rnti:%d len:%d\n", rnti, sdu->N_bytes);
-    pdu_queue.push(p);
+    log_h->info("S1ap write dl info rnti:%d len:%d\n", rnti, sdu->N_bytes);
+    push_pdu(p);
 }
 
 void rrc::release_complete(uint16_t rnti) {
     ueid id;
-    if(rnti_map.count(rnti) == 1) {
-        id = rnti_map[rnti];
-    }
-    else {
+    if(!shards[rnti_to_shard(rnti)]->find_ueid(rnti, &id)) {
         log_h->error("No user rnti:%d\n", rnti);
         return;
     }
@@ -91,14 +160,15 @@ void rrc::release_complete(uint16_t rnti) {
     //ueid_map.erease(id);
     //addr_map.erease(rnti);
     rrc_pdu p = {rnti, SRSENB_DL_RELEASE_USER, NULL};
-    pdu_queue.push(p);
+    push_pdu(p);
     log_h->info("Release user rnti:%d\n", rnti);
 }
 
 bool rrc::setup_ue_ctxt(uint16_t rnti, LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPREQUEST_STRUCT *msg) {
   // TODO add PDU to PDU Queue
     log_h->console("Setup new ctxt erab for rnti:%d\n", rnti);
-    if(rnti_map.count(rnti) != 0) {
+    ueid ue;
+    if(shards[rnti_to_shard(rnti)]->find_ueid(rnti, &ue)) {
         LIBLTE_S1AP_E_RABTOBESETUPLISTCTXTSUREQ_STRUCT *e = &msg->E_RABToBeSetupListCtxtSUReq;
         LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPRESPONSE_STRUCT res;
         res.ext = false;
@@ -116,13 +186,8 @@ bool rrc::setup_ue_ctxt(uint16_t rnti, LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPRE
             uint8_t *bit_ptr = addr->buffer;
             uint32_t addr_ = liblte_bits_2_value(&bit_ptr, addr->n_bits);
             LIBLTE_S1AP_NAS_PDU_STRUCT* nas_pdu = erab->nAS_PDU_present? &erab->nAS_PDU:NULL;
-            if(nas_pdu != NULL) {
-                srslte::byte_buffer_t *sdu = pool->allocate();
-                memcpy(sdu->msg, nas_pdu->buffer, nas_pdu->n_octets);
-                sdu->N_bytes = nas_pdu->n_octets;
-                rrc_pdu pdu = {rnti, RB_ID_SRB1, sdu};
-                pdu_queue.push(pdu);
-            }
+            if(nas_pdu != NULL)
+                push_nas_pdu(rnti, nas_pdu);
             gtpu->add_bearer(rnti, lcid, addr_, teid_out, &teid_in);
             log_h->console("Add bearer for ctxt, rnti:%d lcid:%d\n", rnti, lcid);
             ///////////////////// for complete
@@ -141,7 +206,8 @@ bool rrc::setup_ue_ctxt(uint16_t rnti, LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPRE
 }
 bool rrc::setup_ue_erabs(uint16_t rnti, LIBLTE_S1AP_MESSAGE_E_RABSETUPREQUEST_STRUCT *msg) {
     log_h->console("Setup new ctxt erab for rnti:%d\n", rnti);
-    if(rnti_map.count(rnti) != 0) {
+    ueid ue;
+    if(shards[rnti_to_shard(rnti)]->find_ueid(rnti, &ue)) {
         LIBLTE_S1AP_E_RABTOBESETUPLISTBEARERSUREQ_STRUCT *e = &msg->E_RABToBeSetupListBearerSUReq;
         LIBLTE_S1AP_MESSAGE_E_RABSETUPRESPONSE_STRUCT res;
         res.ext = false;
@@ -161,12 +227,7 @@ bool rrc::setup_ue_erabs(uint16_t rnti, LIBLTE_S1AP_MESSAGE_E_RABSETUPREQUEST_ST
             uint32_t addr_ = liblte_bits_2_value(&bit_ptr, addr->n_bits);
             gtpu->add_bearer(rnti, lcid, addr_, teid_out, &teid_in);
             log_h->console("Add bearer for erab rnti:%d lcid:%d", rnti, lcid);
-            LIBLTE_S1AP_NAS_PDU_STRUCT* nas_pdu = &erab->nAS_PDU;
-            srslte::byte_buffer_t *sdu = pool->allocate();
-            memcpy(sdu->msg, nas_pdu->buffer, nas_pdu->n_octets);
-            sdu->N_bytes = nas_pdu->n_octets;
-            rrc_pdu pdu = {rnti, RB_ID_SRB1, sdu};
-            pdu_queue.push(pdu);
+            push_nas_pdu(rnti, &erab->nAS_PDU);
             /////////////// for Complete
             res.E_RABSetupListBearerSURes_present = true;
             uint32_t j = res.E_RABSetupListBearerSURes.len ++;
@@ -183,7 +244,7 @@ bool rrc::setup_ue_erabs(uint16_t rnti, LIBLTE_S1AP_MESSAGE_E_RABSETUPREQUEST_ST
 
 bool rrc::release_erabs(uint32_t rnti) {
     rrc_pdu p = {(uint16_t)rnti, SRSENB_DL_RELEASE_ERAB, NULL};
-    pdu_queue.push(p);
+    push_pdu(p);
     return true;
 }
 void rrc::add_paging_id(uint32_t ueid, LIBLTE_S1AP_UEPAGINGID_STRUCT UEPagingID) {
@@ -196,12 +257,148 @@ void rrc::add_paging_id(uint32_t ueid, LIBLTE_S1AP_UEPAGINGID_STRUCT UEPagingID)
 //
 ///////////////////////////////////////
 
+/* Called from the GTP-U receive thread. With the DL fast path enabled, user
+ * plane PDUs (DRBs, lcid >= 3) are sent right here to the UE address cached
+ * in the owner shard, skipping the queue handoff and the send_downlink
+ * thread wakeup. SRB traffic always goes through the queue.
+ */
 void rrc::write_sdu(uint16_t rnti, uint32_t lcid, srslte::byte_buffer_t *pdu) {
     rrc_pdu p = {rnti, lcid, pdu};
-    log_h->console("SDU rnti:%d lcid:%d len:%d\n", rnti, lcid, pdu->N_bytes);
-    pdu_queue.push(p);
+    log_h->debug("SDU rnti:%d lcid:%d len:%d\n", rnti, lcid, pdu->N_bytes);
+    if(dl_fast_path && lcid >= 3 && lcid < SRSENB_N_RADIO_BEARERS) {
+        shards[rnti_to_shard(rnti)]->send_direct(p);
+        return;
+    }
+    push_pdu(p);
+}
+
+///////////////////////////////////////
+//
+// Thread entry points
+//
+///////////////////////////////////////
+
+void rrc::send_downlink(uint32_t shard_idx) {
+    shards[shard_idx]->send_downlink();
 }
 
+void rrc::receive_uplink(uint32_t shard_idx) {
+    shards[shard_idx]->receive_uplink();
+}
+
+///////////////////////////////////////
+//
+// Shard
+//
+///////////////////////////////////////
+
+rrc::shard::shard(rrc *parent_, uint32_t idx_) : pdu_queue(SRSENB_RRC_PDU_QUEUE_LEN) {
+    parent     = parent_;
+    idx        = idx_;
+    log_h      = parent->log_h;
+    pool       = parent->pool;
+    sock_fd    = -1;
+    batch_size = 1;
+    pthread_mutex_init(&user_mutex, NULL);
+    users.init(idx, parent->nof_shards);
+    bzero(rx_ring, sizeof(rx_ring));
+    bzero(rx_msgs, sizeof(rx_msgs));
+    bzero(tx_msgs, sizeof(tx_msgs));
+}
+
+bool rrc::shard::init(std::string bind_addr, uint32_t bind_port, uint32_t batch_size_) {
+    sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in rrc_addr;
+    int result = 0;
+    if(sock_fd < 0)
+      result = 1;
+    else {
+      if(parent->nof_shards > 1) {
+        int enable = 1;
+        if(setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) < 0)
+          log_h->error("setsockopt(SO_REUSEPORT) failed\n");
+      }
+      memset(&rrc_addr, 0, sizeof(rrc_addr));
+      rrc_addr.sin_family = AF_INET;
+      inet_pton(AF_INET, bind_addr.c_str(), &rrc_addr.sin_addr);
+      rrc_addr.sin_port = htons(bind_port);
+      if(bind(sock_fd, (struct sockaddr*) &rrc_addr, sizeof(rrc_addr)) < 0)
+        result = 2;
+    }
+    switch(result) {
+      case 1:
+        log_h->error("Invalid socket fd during rrc\n");
+        log_h->console("Invalid socket fd during rrc\n");
+        return false;
+      case 2:
+        log_h->error("Bind error in rrc init\n");
+        log_h->console("Bind error in rrc init\n");
+        return false;
+      default:
+        log_h->debug("RRC shard %d bind to ip%s:%d\n", idx, bind_addr.c_str(), bind_port);
+    }
+
+    batch_size = batch_size_;
+    if(batch_size < 1)
+      batch_size = 1;
+    if(batch_size > SRSENB_RRC_MAX_BATCH) {
+      log_h->warning("RRC batch size %d too large, using %d\n", batch_size, SRSENB_RRC_MAX_BATCH);
+      batch_size = SRSENB_RRC_MAX_BATCH;
+    }
+    if(batch_size > 1) {
+      for(uint32_t i = 0;i < batch_size;i ++)
+        rx_ring_refill(i);
+      log_h->info("RRC shard %d batched I/O enabled, batch size %d\n", idx, batch_size);
+    }
+    return true;
+}
+
+void rrc::shard::stop() {
+    pthread_mutex_lock(&user_mutex);
+    users.clear();
+    pthread_mutex_unlock(&user_mutex);
+    pdu_queue.clear();
+    for(uint32_t i = 0;i < SRSENB_RRC_MAX_BATCH;i ++) {
+      if(rx_ring[i]) {
+        pool->deallocate(rx_ring[i]);
+        rx_ring[i] = NULL;
+      }
+    }
+    if(sock_fd >= 0) {
+      close(sock_fd);
+      sock_fd = -1;
+    }
+    pthread_mutex_destroy(&user_mutex);
+}
+
+bool rrc::shard::find_rnti(const ueid &id, uint16_t *rnti) {
+    pthread_mutex_lock(&user_mutex);
+    bool ret = users.find_rnti(id, rnti);
+    pthread_mutex_unlock(&user_mutex);
+    return ret;
+}
+
+bool rrc::shard::find_ueid(uint16_t rnti, ueid *id) {
+    pthread_mutex_lock(&user_mutex);
+    bool ret = users.find_ctx(rnti, id, NULL);
+    pthread_mutex_unlock(&user_mutex);
+    return ret;
+}
+
+/* Allocates an RNTI owned by this shard, i.e. rnti % nof_shards == idx */
+bool rrc::shard::add_user(const ueid &id, sockaddr_in addr, uint16_t *rnti) {
+    pthread_mutex_lock(&user_mutex);
+    bool ret = users.add(id, addr, rnti);
+    pthread_mutex_unlock(&user_mutex);
+    return ret;
+}
+
+bool rrc::shard::rem_user(uint16_t rnti) {
+    pthread_mutex_lock(&user_mutex);
+    bool ret = users.rem(rnti);
+    pthread_mutex_unlock(&user_mutex);
+    return ret;
+}
 
 ///////////////////////////////////////
 //
@@ -209,81 +406,142 @@ void rrc::write_sdu(uint16_t rnti, uint32_t lcid, srslte::byte_buffer_t *pdu) {
 //
 ///////////////////////////////////////
 
-void rrc::handle_normal(rrc_receive_head head, srslte::byte_buffer_t *sdu) {
-    if(ueid_map.count(head.id) == 1)
-        if(head.lcid < 3)
-            s1ap->write_pdu(ueid_map[head.id],sdu);
-        else
-            gtpu_pdcp->write_pdu(ueid_map[head.id], head.lcid, sdu);
+bool rrc::shard::handle_normal(const rrc_receive_head *head, srslte::byte_buffer_t *sdu) {
+    uint16_t rnti;
+    uint32_t lcid = head->get_lcid();
+    shard *owner = parent->shards[parent->ueid_to_shard(head->id)];
+    if(owner->find_rnti(head->id, &rnti)) {
+        if(lcid < 3) {
+            pthread_mutex_lock(&parent->s1ap_mutex);
+            parent->s1ap->write_pdu(rnti, sdu);
+            pthread_mutex_unlock(&parent->s1ap_mutex);
+        } else {
+            parent->gtpu_pdcp->write_pdu(rnti, lcid, sdu);
+            return true;
+        }
+    }
     else {
         log_h->error("Unknown ueid:");
         for(int i = 0;i < 15;i ++)
-            log_h->error("%d ",head.id[i]);
+            log_h->error("%d ",head->id[i]);
         log_h->error("\n");
     }
+    return false;
 }
 
-void rrc::handle_data(rrc_receive_head head, srslte::byte_buffer_t *sdu) {
-    log_h->console("Receive data len:%d\n", (uint32_t)sdu->N_bytes);
-    for(uint32_t i = 0;i < sdu->N_bytes;i ++)
-        printf("0x%x ",sdu->msg[i]);
-    printf("\n");
-    if(ueid_map.count(head.id) == 1) {
-        gtpu_pdcp->write_pdu(ueid_map[head.id], head.lcid, sdu);
+bool rrc::shard::handle_data(const rrc_receive_head *head, srslte::byte_buffer_t *sdu) {
+    uint16_t rnti;
+    log_h->debug_hex(sdu->msg, sdu->N_bytes, "Receive data len:%d\n", (uint32_t)sdu->N_bytes);
+    shard *owner = parent->shards[parent->ueid_to_shard(head->id)];
+    if(owner->find_rnti(head->id, &rnti)) {
+        parent->gtpu_pdcp->write_pdu(rnti, head->get_lcid(), sdu);
+        return true;
     }
-    // TODO should we dallocate sdu here?
+    return false;
 }
 
-void rrc::handle_attach(rrc_receive_head head, srslte::byte_buffer_t *sdu) {
+void rrc::shard::handle_attach(const rrc_receive_head *head, srslte::byte_buffer_t *sdu) {
     sockaddr_in ue_addr_in;
     ue_addr_in.sin_family = AF_INET;
-    ue_addr_in.sin_port = htons(((uint16_t)head.port[0] << 8) + (uint16_t)head.port[1]);
-    ue_addr_in.sin_addr.s_addr = (((uint32_t)head.ip[3]) << 24) +
-                                 (((uint32_t)head.ip[2]) << 16) +
-                                 (((uint32_t)head.ip[1]) << 8) +
-                                 (uint32_t)head.ip[0];
-    printf("add %s:%d\n", inet_ntoa(ue_addr_in.sin_addr), ue_addr_in.sin_port);
-    for(uint16_t rnti = 1;rnti < 0xFFFF;rnti ++) {
-        if(rnti_map.count(rnti) == 0) {
-            //printf("Send initial_ue\n");
-            rnti_map[rnti] = head.id;
-            ueid_map[head.id] = rnti;
-            addr_map[rnti] = ue_addr_in;
-            s1ap->initial_ue(rnti, head.cause, sdu);
-            return;
-        }
+    ue_addr_in.sin_port = htons(((uint16_t)head->port[0] << 8) + (uint16_t)head->port[1]);
+    ue_addr_in.sin_addr.s_addr = (((uint32_t)head->ip[3]) << 24) +
+                                 (((uint32_t)head->ip[2]) << 16) +
+                                 (((uint32_t)head->ip[1]) << 8) +
+                                 (uint32_t)head->ip[0];
+    log_h->info("add %s:%d\n", inet_ntoa(ue_addr_in.sin_addr), ue_addr_in.sin_port);
+    uint16_t rnti;
+    shard *owner = parent->shards[parent->ueid_to_shard(head->id)];
+    if(owner->add_user(head->id, ue_addr_in, &rnti)) {
+        pthread_mutex_lock(&parent->s1ap_mutex);
+        parent->s1ap->initial_ue(rnti, head->get_cause(), sdu);
+        pthread_mutex_unlock(&parent->s1ap_mutex);
+        return;
     }
     log_h->error("Rnti map is full for id:");
     for(int i = 0;i < 15;i ++)
-        log_h->error("%d ", head.id[i]);
+        log_h->error("%d ", head->id[i]);
     log_h->error("\n");
 }
 
-bool rrc::send_normal(rrc_pdu pdu) {
-    if(rnti_map.count(pdu.rnti) != 0) {
-        append_head(pdu);
-        if(pdu.lcid < 3)
-            pdu.pdu->msg[0] = SRSENB_RRC_NORMAL;//Normal
-        else
-            pdu.pdu->msg[0] = SRSENB_RRC_DATA;
-        sockaddr_in addr = addr_map[pdu.rnti];
-        printf("Send to %s:0x%x: ", inet_ntoa(addr.sin_addr), addr.sin_port);
-        for(uint32_t i = 0;i < pdu.pdu->N_bytes; i ++)
-            printf("0x%x ", pdu.pdu->msg[i]);
-        printf("\n");
+/* Overlays the RRC header on the datagram and dispatches the SDU. The
+ * header bytes stay in the buffer headroom, so the view is valid until the
+ * buffer is handed on. Returns true if the buffer ownership was passed on
+ * (i.e. to GTP-U).
+ */
+bool rrc::shard::handle_uplink(srslte::byte_buffer_t *sdu) {
+  if(sdu->N_bytes < RRC_RECEIVE_LEN) {
+    log_h->warning("Dropping short uplink datagram len:%d\n", sdu->N_bytes);
+    return false;
+  }
+  log_h->debug_hex(sdu->msg, sdu->N_bytes, "Receive Uplink len:%d type:0x%x\n", sdu->N_bytes, sdu->msg[0]);
+  const rrc_receive_head *head = (const rrc_receive_head*) sdu->msg;
+  sdu->msg += RRC_RECEIVE_LEN;
+  sdu->N_bytes -= RRC_RECEIVE_LEN;
+  switch(head->type) {
+    case SRSENB_RRC_NORMAL:
+      return handle_normal(head, sdu);
+    case SRSENB_RRC_ATTACH:
+      handle_attach(head, sdu);
+      break;
+    case SRSENB_RRC_PAGING:
+      log_h->warning("ENB received Paging?\n");
+      break;
+    case SRSENB_RRC_RELEASE:
+      // TODO Release
+      // s1ap->user_release
+      log_h->warning("Release the rnti\n");
+      break;
+    case SRSENB_RRC_DATA:
+      return handle_data(head, sdu);
+    default:
+      log_h->warning("Unkown PDU Type 0x%x\n", head->type);
+  }
+  return false;
+}
+
+///////////////////////////////////////
+//
+// Downlink
+//
+///////////////////////////////////////
+
+/* Writes the RRC header straight into the buffer headroom and returns the
+ * UE address. Only called from the shard owning pdu.rnti.
+ */
+bool rrc::shard::prepare_downlink(rrc_pdu pdu, uint8_t type, sockaddr_in *addr) {
+    if(pdu.pdu->get_headroom() < RRC_SEND_LEN) {
+        log_h->error("No room in PDU for RRC header, rnti:%d\n", pdu.rnti);
+        return false;
+    }
+    rrc_send_head *head = (rrc_send_head*) (pdu.pdu->msg - RRC_SEND_LEN);
+    pthread_mutex_lock(&user_mutex);
+    bool found = users.find_ctx(pdu.rnti, &head->id, addr);
+    pthread_mutex_unlock(&user_mutex);
+    if(!found)
+        return false;
+
+    head->type = type;
+    head->set_lcid(pdu.lcid);
+    pdu.pdu->msg -= RRC_SEND_LEN;
+    pdu.pdu->N_bytes += RRC_SEND_LEN;
+    return true;
+}
+
+bool rrc::shard::send_normal(rrc_pdu pdu) {
+    sockaddr_in addr;
+    if(prepare_downlink(pdu, pdu.lcid < 3 ? SRSENB_RRC_NORMAL : SRSENB_RRC_DATA, &addr)) {
+        log_h->debug_hex(pdu.pdu->msg, pdu.pdu->N_bytes, "Send to %s:0x%x\n", inet_ntoa(addr.sin_addr), addr.sin_port);
         ssize_t send_len = sendto(sock_fd, pdu.pdu->msg, pdu.pdu->N_bytes, 0, (sockaddr*)&addr, sizeof(struct sockaddr));
-        //ssize_t send_len = sendto(send_fd, pdu.pdu->msg, pdu.pdu->N_bytes, 0, (sockaddr*)&addr, sizeof(struct sockaddr));
-        printf("Sent len:%d\n", (int)send_len);
+        if((uint32_t)send_len != pdu.pdu->N_bytes)
+            log_h->warning("Send to rnti:%d failure, need to send:%d sent:%d\n", pdu.rnti, pdu.pdu->N_bytes, (int)send_len);
         return true;
     }
     return false;
 }
 
-bool rrc::send_paging(rrc_pdu pdu) {
-    if(rnti_map.count(pdu.rnti) != 0) {
-        append_head(pdu);
-        pdu.pdu->msg[0] = SRSENB_RRC_PAGING;
-        sockaddr_in addr = addr_map[pdu.rnti];
+bool rrc::shard::send_paging(rrc_pdu pdu) {
+    sockaddr_in addr;
+    if(prepare_downlink(pdu, SRSENB_RRC_PAGING, &addr)) {
         ssize_t send_len = sendto(sock_fd, pdu.pdu->msg, pdu.pdu->N_bytes, 0, (sockaddr*)&addr, sizeof(struct sockaddr));
         if((uint32_t)send_len != pdu.pdu->N_bytes)
             log_h->warning("Send to rnti:%d failure, need to send:%d sent:%d\n", pdu.rnti, pdu.pdu->N_bytes, (int)send_len);
@@ -292,36 +550,32 @@ bool rrc::send_paging(rrc_pdu pdu) {
     return false;
 }
 
-void rrc::append_head(rrc_pdu pdu) {
-    rrc_send_head head;
-    head.lcid = pdu.lcid;
-    head.id = rnti_map[pdu.rnti];
-    pdu.pdu->msg -= RRC_SEND_LEN;
-    pdu.pdu->N_bytes += RRC_SEND_LEN;
-    memcpy(pdu.pdu->msg, &head, sizeof(rrc_send_head));
-    /*pdu.pdu->msg -= 2;
-    pdu.pdu->msg[0] = (uint8_t)pdu.lcid;
-    pdu.pdu->msg[1] = (uint8_t)(pdu.lcid >> 8);
-    pdu.pdu->msg -= 15;
-    ueid id = rnti_map[pdu.rnti];
-    for(int i = 0;i < 15;i ++)
-        pdu.pdu->msg[i] = id[i];
-    pdu.pdu->msg -= 1;
-    pdu.pdu->N_bytes += 18;*/
+/* Sends a DRB PDU from the caller's thread. prepare_downlink() only needs
+ * user_mutex and sendto() on the shared UDP socket is thread safe, so this
+ * can run concurrently with the shard's send_downlink thread.
+ */
+void rrc::shard::send_direct(rrc_pdu pdu) {
+    if(!send_normal(pdu))
+        log_h->warning("Unknown rnti:%d for DL PDU - dropping packet\n", pdu.rnti);
+    pool->deallocate(pdu.pdu);
 }
 
-void rrc::send_downlink() {
+void rrc::shard::send_downlink() {
+    if(batch_size > 1) {
+      send_downlink_batch();
+      return;
+    }
     rrc_pdu pdu = pdu_queue.wait_pop();
-    bool result = true;
     switch(pdu.lcid) {
         case SRSENB_DL_PAGING:
             send_paging(pdu);
             break;
         case SRSENB_DL_RELEASE_USER:
-            gtpu->rem_user(pdu.rnti);
+            parent->gtpu->rem_user(pdu.rnti);
+            rem_user(pdu.rnti);
             break;
         case SRSENB_DL_RELEASE_ERAB:
-            gtpu->rem_bearer(pdu.rnti, pdu.lcid & 0x0000FFFF);
+            parent->gtpu->rem_bearer(pdu.rnti, pdu.lcid & 0x0000FFFF);
             break;
         default:
             if(pdu.lcid < 0x00010000)
@@ -332,45 +586,119 @@ void rrc::send_downlink() {
     pool->deallocate(pdu.pdu);
 }
 
-void rrc::receive_uplink() {
-  // TODO How about static byte_buffer_t?
-  srslte::byte_buffer_t *sdu = pool->allocate();
-  ssize_t len = read(sock_fd, sdu->msg, SRSLTE_MAX_BUFFER_SIZE_BYTES);
+/* Pops up to batch_size PDUs (blocking only for the first one) and
+ * flushes all the datagrams with as few sendmmsg() calls as possible.
+ */
+void rrc::shard::send_downlink_batch() {
+    uint32_t n = 0;
+    rrc_pdu pdu = pdu_queue.wait_pop();
+    do {
+        uint8_t type = 0;
+        switch(pdu.lcid) {
+            case SRSENB_DL_PAGING:
+                type = SRSENB_RRC_PAGING;
+                break;
+            case SRSENB_DL_RELEASE_USER:
+                parent->gtpu->rem_user(pdu.rnti);
+                rem_user(pdu.rnti);
+                break;
+            case SRSENB_DL_RELEASE_ERAB:
+                parent->gtpu->rem_bearer(pdu.rnti, pdu.lcid & 0x0000FFFF);
+                break;
+            default:
+                if(pdu.lcid < 0x00010000)
+                    type = pdu.lcid < 3 ? SRSENB_RRC_NORMAL : SRSENB_RRC_DATA;
+                else
+                    log_h->error("Invalid DL LCID:0x%x", pdu.lcid);
+        }
+        if(type != 0 && pdu.pdu != NULL && prepare_downlink(pdu, type, &tx_addrs[n])) {
+            tx_iovs[n].iov_base = pdu.pdu->msg;
+            tx_iovs[n].iov_len  = pdu.pdu->N_bytes;
+            tx_msgs[n].msg_hdr.msg_name    = &tx_addrs[n];
+            tx_msgs[n].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            tx_msgs[n].msg_hdr.msg_iov     = &tx_iovs[n];
+            tx_msgs[n].msg_hdr.msg_iovlen  = 1;
+            tx_pdus[n ++] = pdu;
+        } else {
+            pool->deallocate(pdu.pdu);
+        }
+    } while(n < batch_size && pdu_queue.try_pop(&pdu));
+
+    uint32_t sent = 0;
+    while(sent < n) {
+        int ret = sendmmsg(sock_fd, &tx_msgs[sent], n - sent, 0);
+        if(ret <= 0) {
+            log_h->warning("sendmmsg failure, dropping %d PDUs\n", n - sent);
+            break;
+        }
+        sent += ret;
+    }
+    for(uint32_t i = 0;i < n;i ++)
+        pool->deallocate(tx_pdus[i].pdu);
+}
+
+///////////////////////////////////////
+//
+// Uplink
+//
+///////////////////////////////////////
+
+void rrc::shard::receive_uplink() {
+  if(batch_size > 1) {
+    receive_uplink_batch();
+    return;
+  }
+  srslte::byte_buffer_t *sdu = pool_allocate;
+  if(!sdu) {
+    log_h->error("Fatal Error: Couldn't allocate buffer in rrc::receive_uplink().\n");
+    usleep(10000);
+    return;
+  }
+  ssize_t len = read(sock_fd, sdu->msg, sdu->get_tailroom());
+  if(len < 0) {
+    pool->deallocate(sdu);
+    return;
+  }
   sdu->N_bytes = (uint32_t) len;
-  log_h->debug("Receive Uplink len:%d type:0x%x\n", (uint32_t) len, sdu->msg[0]);
-  log_h->console("Receive Uplink len:%d type:0x%x\n", (uint32_t) len, sdu->msg[0]);
-  for(int i = 0;i < len;i ++) 
-printf("0x%x ", sdu->msg[i]);
-printf("\n");
-  rrc_receive_head head;
-  memcpy(&head, sdu->msg, sizeof(rrc_receive_head));
-  sdu->msg += RRC_RECEIVE_LEN;
-  sdu->N_bytes -= RRC_RECEIVE_LEN;
-  for(uint32_t i = 0;i < sdu->N_bytes;i ++)
-      printf("0x%x ", sdu->msg[i]);
-  printf("\n");
-  switch(head.type) {
-    case SRSENB_RRC_NORMAL:
-      handle_normal(head, sdu);
-      break;
-    case SRSENB_RRC_ATTACH:
-      handle_attach(head, sdu);
-      break;
-    case SRSENB_RRC_PAGING:
-      log_h->warning("ENB received Paging?\n");
-      break;
-    case SRSENB_RRC_RELEASE:
-      // TODO Release
-      // s1ap->user_release
-      log_h->warning("Release the rnti\n");
-      break;
-    case SRSENB_RRC_DATA:
-      handle_data(head, sdu);
-      break;
-    default:
-      log_h->warning("Unkown PDU Type 0x%x\n", sdu->msg[0]);
+  if(!handle_uplink(sdu))
+    pool->deallocate(sdu);
+}
+
+/* Re-arms slot i of the rx ring. A new pool buffer is only taken when the
+ * previous one was handed over to another layer.
+ */
+void rrc::shard::rx_ring_refill(uint32_t i) {
+  if(rx_ring[i] == NULL) {
+    do {
+      rx_ring[i] = pool_allocate;
+      if(!rx_ring[i]) {
+        log_h->console("RRC Buffer pool empty. Trying again...\n");
+        usleep(10000);
+      }
+    } while(!rx_ring[i]);
+  } else {
+    rx_ring[i]->reset();
+  }
+  rx_iovs[i].iov_base = rx_ring[i]->msg;
+  rx_iovs[i].iov_len  = rx_ring[i]->get_tailroom();
+  rx_msgs[i].msg_hdr.msg_iov    = &rx_iovs[i];
+  rx_msgs[i].msg_hdr.msg_iovlen = 1;
+  rx_msgs[i].msg_len            = 0;
+}
+
+/* Blocks until at least one datagram is available and drains up to
+ * batch_size of them with a single recvmmsg() call.
+ */
+void rrc::shard::receive_uplink_batch() {
+  int n = recvmmsg(sock_fd, rx_msgs, batch_size, MSG_WAITFORONE, NULL);
+  if(n <= 0)
+    return;
+  for(int i = 0;i < n;i ++) {
+    rx_ring[i]->N_bytes = rx_msgs[i].msg_len;
+    if(handle_uplink(rx_ring[i]))
+      rx_ring[i] = NULL;
+    rx_ring_refill(i);
   }
-  pool->deallocate(sdu);
 }
 
 }
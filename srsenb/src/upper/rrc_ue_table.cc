@@ -0,0 +1,245 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <algorithm>
+#include "srsenb/hdr/upper/rrc_ue_table.h"
+
+namespace srsenb {
+
+rrc_ue_table::rrc_ue_table()
+{
+  first_rnti = 1;
+  rnti_step  = 1;
+  index_mask = 0;
+  free_head  = NO_SLOT;
+  free_tail  = NO_SLOT;
+  nof_users  = 0;
+}
+
+void rrc_ue_table::init(uint32_t first_rnti_, uint32_t rnti_step_)
+{
+  first_rnti = first_rnti_ ? first_rnti_ : rnti_step_;
+  rnti_step  = rnti_step_ ? rnti_step_ : 1;
+
+  uint32_t nof_slots = 0;
+  if (first_rnti < 0xFFFF) {
+    nof_slots = (0xFFFF - first_rnti + rnti_step - 1) / rnti_step;
+  }
+  ctx.resize(nof_slots);
+
+  // Keep the index at most half full so that probe sequences stay short
+  uint32_t index_size = 16;
+  while (index_size < 2 * nof_slots) {
+    index_size <<= 1;
+  }
+  index.resize(index_size);
+  index_mask = index_size - 1;
+
+  clear();
+}
+
+/* RNTIs are handed out in FIFO order so that a released RNTI is reused as
+ * late as possible and stale PDUs for it are not delivered to a new UE.
+ */
+void rrc_ue_table::clear()
+{
+  uint32_t nof_slots = ctx.size();
+  for (uint32_t i = 0; i < nof_slots; i++) {
+    ctx[i].active    = false;
+    ctx[i].rnti      = (uint16_t) (first_rnti + i * rnti_step);
+    ctx[i].next_free = (i + 1 < nof_slots) ? i + 1 : NO_SLOT;
+  }
+  free_head = nof_slots ? 0 : NO_SLOT;
+  free_tail = nof_slots ? nof_slots - 1 : NO_SLOT;
+  std::fill(index.begin(), index.end(), 0);
+  nof_users = 0;
+}
+
+bool rrc_ue_table::add(const rrc_ueid_t &id, const sockaddr_in &addr, uint16_t *rnti)
+{
+  uint32_t hash = hash_ueid(id);
+  uint32_t pos;
+
+  // A UE attaching again keeps its RNTI, only the address is refreshed
+  if (index_find(id, hash, &pos)) {
+    uint32_t slot = slot_of(index[pos]);
+    ctx[slot].addr = addr;
+    *rnti = ctx[slot].rnti;
+    return true;
+  }
+  if (free_head == NO_SLOT) {
+    return false;
+  }
+
+  uint32_t slot = free_head;
+  free_head = ctx[slot].next_free;
+  if (free_head == NO_SLOT) {
+    free_tail = NO_SLOT;
+  }
+
+  ue_ctx_t *c  = &ctx[slot];
+  c->id        = id;
+  c->addr      = addr;
+  c->hash      = hash;
+  c->active    = true;
+  c->next_free = NO_SLOT;
+  index[pos]   = c->rnti;
+  nof_users++;
+
+  *rnti = c->rnti;
+  return true;
+}
+
+bool rrc_ue_table::rem(uint16_t rnti)
+{
+  uint32_t slot;
+  uint32_t pos;
+  if (!rnti_to_slot(rnti, &slot) || !ctx[slot].active) {
+    return false;
+  }
+  if (index_find(ctx[slot].id, ctx[slot].hash, &pos)) {
+    index_erase(pos);
+  }
+
+  ctx[slot].active    = false;
+  ctx[slot].next_free = NO_SLOT;
+  if (free_tail == NO_SLOT) {
+    free_head = slot;
+  } else {
+    ctx[free_tail].next_free = slot;
+  }
+  free_tail = slot;
+  nof_users--;
+  return true;
+}
+
+bool rrc_ue_table::find_rnti(const rrc_ueid_t &id, uint16_t *rnti)
+{
+  uint32_t pos;
+  if (!index_find(id, hash_ueid(id), &pos)) {
+    return false;
+  }
+  *rnti = index[pos];
+  return true;
+}
+
+bool rrc_ue_table::find_ctx(uint16_t rnti, rrc_ueid_t *id, sockaddr_in *addr)
+{
+  uint32_t slot;
+  if (!rnti_to_slot(rnti, &slot) || !ctx[slot].active) {
+    return false;
+  }
+  if (id) {
+    *id = ctx[slot].id;
+  }
+  if (addr) {
+    *addr = ctx[slot].addr;
+  }
+  return true;
+}
+
+uint32_t rrc_ue_table::size()
+{
+  return nof_users;
+}
+
+uint32_t rrc_ue_table::capacity()
+{
+  return ctx.size();
+}
+
+/*******************************************************************************
+  Helpers
+*******************************************************************************/
+
+// FNV-1a over the 15 bytes of the ueid
+uint32_t rrc_ue_table::hash_ueid(const rrc_ueid_t &id)
+{
+  uint32_t h = 2166136261u;
+  for (uint32_t i = 0; i < SRSENB_RRC_UEID_LEN; i++) {
+    h ^= id.value[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+bool rrc_ue_table::rnti_to_slot(uint16_t rnti, uint32_t *slot)
+{
+  if (rnti < first_rnti || (rnti - first_rnti) % rnti_step) {
+    return false;
+  }
+  *slot = (rnti - first_rnti) / rnti_step;
+  return *slot < ctx.size();
+}
+
+// Only for RNTIs taken from the index, which are always valid
+uint32_t rrc_ue_table::slot_of(uint16_t rnti)
+{
+  return (rnti - first_rnti) / rnti_step;
+}
+
+/* Linear probing. Returns true and the position of the entry if the ueid is
+ * present, otherwise false and the first empty position of its sequence.
+ */
+bool rrc_ue_table::index_find(const rrc_ueid_t &id, uint32_t hash, uint32_t *pos)
+{
+  uint32_t i = hash & index_mask;
+  while (index[i]) {
+    uint32_t slot = slot_of(index[i]);
+    if (ctx[slot].hash == hash && ctx[slot].id == id) {
+      *pos = i;
+      return true;
+    }
+    i = (i + 1) & index_mask;
+  }
+  *pos = i;
+  return false;
+}
+
+/* Backward-shift deletion: entries following the removed one are moved back
+ * unless their home position lies cyclically in (i, j], so no tombstones are
+ * needed and lookups never degrade after many attach/detach cycles.
+ */
+void rrc_ue_table::index_erase(uint32_t pos)
+{
+  uint32_t i = pos;
+  uint32_t j = pos;
+  while (true) {
+    j = (j + 1) & index_mask;
+    if (!index[j]) {
+      break;
+    }
+    uint32_t k = ctx[slot_of(index[j])].hash & index_mask;
+    if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+    index[i] = index[j];
+    i = j;
+  }
+  index[i] = 0;
+}
+
+} // namespace srsenb
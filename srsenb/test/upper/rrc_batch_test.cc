@@ -0,0 +1,312 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        rrc_batch_test.cc
+ * Description: Benchmark of the eNB RRC UDP front-end. A local traffic
+ *              generator floods the RRC socket and the uplink/downlink
+ *              packet rate per core is reported for several batch sizes
+ *              and shard counts, and for the direct DL fast path.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "srslte/common/log_filter.h"
+#include "srslte/common/logger_stdout.h"
+#include "srsenb/hdr/upper/rrc.h"
+
+#define BIND_ADDR     "127.0.0.1"
+#define BIND_PORT     12001
+#define SINK_PORT     12101
+#define PAYLOAD_LEN   40
+#define TEST_SECONDS  2
+#define NOF_DL_PDUS   200000
+#define NOF_UES       64
+#define GEN_BATCH     32
+
+using namespace srsenb;
+
+class dummy_s1ap : public s1ap_interface_rrc
+{
+public:
+  void initial_ue(uint16_t rnti, LIBLTE_S1AP_RRC_ESTABLISHMENT_CAUSE_ENUM cause, srslte::byte_buffer_t *pdu) {}
+  void initial_ue(uint16_t rnti, LIBLTE_S1AP_RRC_ESTABLISHMENT_CAUSE_ENUM cause, srslte::byte_buffer_t *pdu, uint32_t m_tmsi, uint8_t mmec) {}
+  void write_pdu(uint16_t rnti, srslte::byte_buffer_t *pdu) {}
+  bool user_exists(uint16_t rnti) { return true; }
+  bool user_release(uint16_t rnti, LIBLTE_S1AP_CAUSERADIONETWORK_ENUM cause_radio) { return true; }
+  void ue_ctxt_setup_complete(uint16_t rnti, LIBLTE_S1AP_MESSAGE_INITIALCONTEXTSETUPRESPONSE_STRUCT *res) {}
+  void ue_erab_setup_complete(uint16_t rnti, LIBLTE_S1AP_MESSAGE_E_RABSETUPRESPONSE_STRUCT *res) {}
+};
+
+class dummy_gtpu : public gtpu_interface_rrc, public gtpu_interface_pdcp
+{
+public:
+  dummy_gtpu() : nof_pdus(0), released(false) {}
+  void add_bearer(uint16_t rnti, uint32_t lcid, uint32_t addr, uint32_t teid_out, uint32_t *teid_in) {}
+  void rem_bearer(uint16_t rnti, uint32_t lcid) {}
+  void rem_user(uint16_t rnti) { released = true; }
+  void write_pdu(uint16_t rnti, uint32_t lcid, srslte::byte_buffer_t *pdu) {
+    __sync_fetch_and_add(&nof_pdus, 1);
+    srslte::byte_buffer_pool::get_instance()->deallocate(pdu);
+  }
+  uint64_t      nof_pdus;
+  volatile bool released;
+};
+
+typedef struct {
+  rrc           *r;
+  dummy_gtpu    *gtpu;
+  uint32_t       port;
+  uint32_t       shard;
+  volatile bool *running;
+  double         cpu_sec;
+} bench_args_t;
+
+static double cpu_time()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static double wall_time()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static void set_ueid(rrc::ueid *id, uint32_t ue)
+{
+  for(int i = 0;i < 15;i ++)
+    id->value[i] = (uint8_t) (i + 1);
+  id->value[14] = (uint8_t) ue;
+}
+
+void* uplink_generator(void *a)
+{
+  bench_args_t *args = (bench_args_t*) a;
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+  sockaddr_in dst;
+  bzero(&dst, sizeof(dst));
+  dst.sin_family = AF_INET;
+  dst.sin_port   = htons(args->port);
+  inet_pton(AF_INET, BIND_ADDR, &dst.sin_addr);
+
+  uint8_t pkt[NOF_UES][sizeof(rrc::rrc_receive_head) + PAYLOAD_LEN];
+  bzero(pkt, sizeof(pkt));
+  for(uint32_t ue = 0;ue < NOF_UES;ue ++) {
+    rrc::rrc_receive_head head;
+    bzero(&head, sizeof(head));
+    head.type = SRSENB_RRC_NORMAL;
+    head.lcid = htole16(3);
+    set_ueid(&head.id, ue);
+    memcpy(pkt[ue], &head, sizeof(head));
+  }
+
+  struct iovec   iov[GEN_BATCH];
+  struct mmsghdr msgs[GEN_BATCH];
+  bzero(msgs, sizeof(msgs));
+  for(int i = 0;i < GEN_BATCH;i ++) {
+    iov[i].iov_len  = sizeof(pkt[0]);
+    msgs[i].msg_hdr.msg_name    = &dst;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dst);
+    msgs[i].msg_hdr.msg_iov     = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+  }
+  uint32_t ue = 0;
+  while(*args->running) {
+    for(int i = 0;i < GEN_BATCH;i ++) {
+      iov[i].iov_base = pkt[ue];
+      ue = (ue + 1) % NOF_UES;
+    }
+    sendmmsg(fd, msgs, GEN_BATCH, 0);
+  }
+  close(fd);
+  return NULL;
+}
+
+void* uplink_receiver(void *a)
+{
+  bench_args_t *args = (bench_args_t*) a;
+  double t0 = cpu_time();
+  while(*args->running) {
+    args->r->receive_uplink(args->shard);
+  }
+  args->cpu_sec = cpu_time() - t0;
+  return NULL;
+}
+
+void* downlink_sender(void *a)
+{
+  bench_args_t *args = (bench_args_t*) a;
+  double t0 = cpu_time();
+  while(!args->gtpu->released) {
+    args->r->send_downlink(args->shard);
+  }
+  args->cpu_sec = cpu_time() - t0;
+  return NULL;
+}
+
+void init_rrc(rrc *r, dummy_s1ap *s1ap, dummy_gtpu *gtpu, srslte::log *log_h,
+              uint32_t port, uint32_t batch_size, uint32_t nof_shards, uint16_t *rntis,
+              bool dl_fast_path = false)
+{
+  r->init(s1ap, gtpu, gtpu, log_h, BIND_ADDR, port, batch_size, nof_shards, dl_fast_path);
+
+  sockaddr_in ue_addr;
+  bzero(&ue_addr, sizeof(ue_addr));
+  ue_addr.sin_family = AF_INET;
+  ue_addr.sin_port   = htons(SINK_PORT);
+  inet_pton(AF_INET, BIND_ADDR, &ue_addr.sin_addr);
+
+  for(uint32_t ue = 0;ue < NOF_UES;ue ++) {
+    rrc::ueid id;
+    set_ueid(&id, ue);
+    r->shards[r->ueid_to_shard(id)]->add_user(id, ue_addr, &rntis[ue]);
+  }
+
+  // Let the receivers poll the stop flag
+  struct timeval tv = {0, 100000};
+  for(uint32_t i = 0;i < r->get_nof_shards();i ++) {
+    setsockopt(r->shards[i]->sock_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  }
+}
+
+void uplink_bench(srslte::log *log_h, uint32_t batch_size, uint32_t nof_shards, uint32_t port)
+{
+  rrc           r;
+  dummy_s1ap    s1ap;
+  dummy_gtpu    gtpu;
+  uint16_t      rntis[NOF_UES];
+  volatile bool running = true;
+  bench_args_t  gen_args;
+  bench_args_t  rx_args[SRSENB_RRC_MAX_SHARDS];
+  pthread_t     gen_tid;
+  pthread_t     rx_tid[SRSENB_RRC_MAX_SHARDS];
+
+  init_rrc(&r, &s1ap, &gtpu, log_h, port, batch_size, nof_shards, rntis);
+  for(uint32_t i = 0;i < nof_shards;i ++) {
+    rx_args[i].r       = &r;
+    rx_args[i].gtpu    = &gtpu;
+    rx_args[i].shard   = i;
+    rx_args[i].running = &running;
+    rx_args[i].cpu_sec = 0;
+    pthread_create(&rx_tid[i], NULL, &uplink_receiver, &rx_args[i]);
+  }
+  gen_args.port    = port;
+  gen_args.running = &running;
+  pthread_create(&gen_tid, NULL, &uplink_generator, &gen_args);
+
+  sleep(TEST_SECONDS);
+  uint64_t nof_pdus = gtpu.nof_pdus;
+  running = false;
+  double cpu_sec = 0;
+  for(uint32_t i = 0;i < nof_shards;i ++) {
+    pthread_join(rx_tid[i], NULL);
+    cpu_sec += rx_args[i].cpu_sec;
+  }
+  pthread_join(gen_tid, NULL);
+  r.stop();
+
+  printf("UL batch=%2d shards=%d: %10.0f pkt/s, %10.0f pkt/s per core\n", batch_size, nof_shards,
+         (double) nof_pdus/TEST_SECONDS, cpu_sec > 0 ? nof_pdus/cpu_sec : 0);
+}
+
+/* The producer stands in for the GTP-U receive thread: it hands DRB PDUs to
+ * rrc::write_sdu(), which either queues them or, with the fast path, sends
+ * them right away.
+ */
+void downlink_bench(srslte::log *log_h, uint32_t batch_size, uint32_t port, bool dl_fast_path)
+{
+  rrc           r;
+  dummy_s1ap    s1ap;
+  dummy_gtpu    gtpu;
+  uint16_t      rntis[NOF_UES];
+  bench_args_t  args;
+  pthread_t     tx_tid;
+
+  init_rrc(&r, &s1ap, &gtpu, log_h, port, batch_size, 1, rntis, dl_fast_path);
+  args.r     = &r;
+  args.gtpu  = &gtpu;
+  args.shard = 0;
+
+  // The pdu_queue is bounded so the producer never drains the buffer pool
+  srslte::byte_buffer_pool *pool = srslte::byte_buffer_pool::get_instance();
+  double t0 = wall_time();
+  double c0 = cpu_time();
+  pthread_create(&tx_tid, NULL, &downlink_sender, &args);
+  for(uint32_t i = 0;i < NOF_DL_PDUS;i ++) {
+    srslte::byte_buffer_t *pdu = NULL;
+    while((pdu = pool->allocate()) == NULL) {
+      usleep(10);
+    }
+    pdu->N_bytes = PAYLOAD_LEN;
+    r.write_sdu(rntis[i % NOF_UES], 3, pdu);
+  }
+  double producer_sec = cpu_time() - c0;
+  rrc::rrc_pdu p = {rntis[0], SRSENB_DL_RELEASE_USER, NULL};
+  r.push_pdu(p);
+  pthread_join(tx_tid, NULL);
+  double wall_sec = wall_time() - t0;
+  r.stop();
+
+  printf("DL batch=%2d%s: %10.0f pkt/s, %10.0f pkt/s per core\n", batch_size, dl_fast_path ? " fast" : "     ",
+         NOF_DL_PDUS/wall_sec, NOF_DL_PDUS/(args.cpu_sec + producer_sec));
+}
+
+int main(int argc, char **argv)
+{
+  srslte::logger_stdout logger;
+  srslte::log_filter    log_h("RRC ", &logger);
+  log_h.set_level(srslte::LOG_LEVEL_NONE);
+
+  srslte::byte_buffer_pool::get_instance(8192);
+
+  uint32_t port = BIND_PORT;
+  uint32_t batch_sizes[] = {1, 8, 32, 64};
+  uint32_t nof_batch_sizes = sizeof(batch_sizes)/sizeof(uint32_t);
+  for(uint32_t i = 0;i < nof_batch_sizes;i ++) {
+    uplink_bench(&log_h, batch_sizes[i], 1, port++);
+  }
+  uint32_t shard_counts[] = {2, 4};
+  for(uint32_t i = 0;i < sizeof(shard_counts)/sizeof(uint32_t);i ++) {
+    uplink_bench(&log_h, 32, shard_counts[i], port++);
+  }
+  for(uint32_t i = 0;i < nof_batch_sizes;i ++) {
+    downlink_bench(&log_h, batch_sizes[i], port++, false);
+  }
+  downlink_bench(&log_h, 1, port++, true);
+
+  srslte::byte_buffer_pool::cleanup();
+  printf("Done\n");
+  exit(0);
+}
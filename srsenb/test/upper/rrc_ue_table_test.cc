@@ -0,0 +1,183 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsUE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsUE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        rrc_ue_table_test.cc
+ * Description: Checks the RRC UE context table and measures the cost of
+ *              attaching and detaching 60k UEs.
+ *****************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "srsenb/hdr/upper/rrc_ue_table.h"
+
+#define NOF_UES    60000
+#define NOF_ROUNDS 10
+
+using namespace srsenb;
+
+static double now_sec()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// IMSI-like ueid: 15 decimal digits
+static void make_ueid(rrc_ueid_t *id, uint32_t ue)
+{
+  uint64_t imsi = 1010123456000ULL + ue;
+  for (int i = SRSENB_RRC_UEID_LEN - 1; i >= 0; i--) {
+    id->value[i] = (uint8_t) (imsi % 10);
+    imsi /= 10;
+  }
+}
+
+static sockaddr_in make_addr(uint32_t ue)
+{
+  sockaddr_in addr;
+  bzero(&addr, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(0x0A000000 | ue);
+  addr.sin_port        = htons(10000 + (ue & 0x3FFF));
+  return addr;
+}
+
+void functional_test()
+{
+  rrc_ue_table t;
+  rrc_ueid_t   id, id_out;
+  sockaddr_in  addr;
+  uint16_t     rnti, rnti2;
+
+  // Shard 2 of 4 owns the RNTIs 2, 6, 10, ...
+  t.init(2, 4);
+  assert(t.capacity() == (0xFFFF - 2 + 3) / 4);
+
+  make_ueid(&id, 1);
+  assert(t.add(id, make_addr(1), &rnti));
+  assert(rnti == 2);
+  assert(t.find_rnti(id, &rnti2) && rnti2 == rnti);
+  assert(t.find_ctx(rnti, &id_out, &addr));
+  assert(id_out == id);
+  assert(addr.sin_addr.s_addr == make_addr(1).sin_addr.s_addr);
+
+  // Attaching again keeps the RNTI and refreshes the address
+  assert(t.add(id, make_addr(7), &rnti2) && rnti2 == rnti);
+  assert(t.find_ctx(rnti, NULL, &addr));
+  assert(addr.sin_addr.s_addr == make_addr(7).sin_addr.s_addr);
+  assert(t.size() == 1);
+
+  // RNTIs not owned by the table are rejected
+  assert(!t.find_ctx(3, NULL, NULL));
+  assert(!t.rem(3));
+
+  // Released RNTIs are reused last
+  make_ueid(&id, 2);
+  assert(t.add(id, make_addr(2), &rnti2) && rnti2 == 6);
+  assert(t.rem(rnti));
+  assert(!t.rem(rnti));
+  make_ueid(&id, 3);
+  assert(t.add(id, make_addr(3), &rnti2) && rnti2 == 10);
+
+  // Fill the table completely
+  t.init(1, 1);
+  for (uint32_t i = 0; i < t.capacity(); i++) {
+    make_ueid(&id, i);
+    assert(t.add(id, make_addr(i), &rnti));
+  }
+  make_ueid(&id, t.capacity());
+  assert(!t.add(id, make_addr(0), &rnti));
+
+  // Remove every other UE and check that the rest is still found
+  for (uint32_t i = 0; i < t.capacity(); i += 2) {
+    make_ueid(&id, i);
+    assert(t.find_rnti(id, &rnti));
+    assert(t.rem(rnti));
+  }
+  for (uint32_t i = 0; i < t.capacity(); i++) {
+    make_ueid(&id, i);
+    assert(t.find_rnti(id, &rnti) == (i % 2 == 1));
+  }
+  assert(t.size() == t.capacity() / 2);
+}
+
+void benchmark()
+{
+  rrc_ue_table t;
+  rrc_ueid_t  *ids   = new rrc_ueid_t[NOF_UES];
+  uint16_t    *rntis = new uint16_t[NOF_UES];
+  double       t_attach = 0, t_lookup = 0, t_detach = 0;
+
+  for (uint32_t i = 0; i < NOF_UES; i++) {
+    make_ueid(&ids[i], i);
+  }
+  t.init(1, 1);
+
+  for (uint32_t r = 0; r < NOF_ROUNDS; r++) {
+    double t0 = now_sec();
+    for (uint32_t i = 0; i < NOF_UES; i++) {
+      if (!t.add(ids[i], make_addr(i), &rntis[i])) {
+        printf("Failed to attach UE %d\n", i);
+        exit(1);
+      }
+    }
+    double t1 = now_sec();
+    for (uint32_t i = 0; i < NOF_UES; i++) {
+      uint16_t rnti;
+      if (!t.find_rnti(ids[i], &rnti) || rnti != rntis[i]) {
+        printf("Failed to find UE %d\n", i);
+        exit(1);
+      }
+    }
+    double t2 = now_sec();
+    for (uint32_t i = 0; i < NOF_UES; i++) {
+      t.rem(rntis[i]);
+    }
+    double t3 = now_sec();
+    t_attach += t1 - t0;
+    t_lookup += t2 - t1;
+    t_detach += t3 - t2;
+  }
+  assert(t.size() == 0);
+
+  double nof_ops = (double) NOF_UES * NOF_ROUNDS;
+  printf("%d UEs x %d rounds: attach %.1f ns/op, lookup %.1f ns/op, detach %.1f ns/op\n",
+         NOF_UES, NOF_ROUNDS, 1e9 * t_attach / nof_ops, 1e9 * t_lookup / nof_ops, 1e9 * t_detach / nof_ops);
+
+  delete[] ids;
+  delete[] rntis;
+}
+
+int main(int argc, char **argv)
+{
+  functional_test();
+  benchmark();
+  printf("Passed\n");
+  exit(0);
+}
@@ -38,9 +38,13 @@
 #include "srslte/common/logger_file.h"
 #include "srslte/common/log_filter.h"
 #include "srslte/common/buffer_pool.h"
+#include "srslte/common/threads.h"
+#include "srslte/common/liblte_security.h"
 #include "srslte/interfaces/epc_interfaces.h"
+#include "hss_db.h"
 #include <fstream>
 #include <map>
+#include <deque>
 
 namespace srsepc{
 
@@ -49,19 +53,25 @@ typedef struct{
   std::string db_file;
   uint16_t mcc;
   uint16_t mnc;
+  uint32_t av_pool_size;
 }hss_args_t;
 
 typedef struct{
-    std::string name;
-    uint64_t imsi;
-    uint8_t  key[16];
-    bool     op_configured;
-    uint8_t  op[16];
-    uint8_t  opc[16];
-    uint8_t  amf[2];
-    uint8_t  sqn[6];
-    uint16_t qci;
-    uint8_t  last_rand[16];
+  uint8_t rand[16];
+  uint8_t xres[16];
+  uint8_t autn[16];
+  uint8_t k_asme[32];
+}hss_auth_vector_t;
+
+/* Runtime state of a subscriber, created on first use. The subscriber
+ * data itself stays in the mapped store record.
+ */
+typedef struct{
+    hss_db_record_t *rec;
+    LIBLTE_SECURITY_MILENAGE_CTX_STRUCT milenage;   // round keys of key, and OPc
+    std::deque<hss_auth_vector_t> av_pool;          // oldest SQN first
+    uint32_t av_epoch;                              // bumped when the pool is flushed
+    bool     av_queued;                             // waiting for the generator
 }hss_ue_ctx_t;
 
 enum hss_auth_algo {
@@ -69,7 +79,12 @@ enum hss_auth_algo {
   HSS_ALGO_MILENAGE
 };
 
-class hss : public hss_interface_s1ap
+/* Authentication vectors are generated ahead of time by the HSS thread,
+ * up to av_pool_size per UE, and handed out in SQN order. A request that
+ * finds the pool empty computes its vector inline and flushes the pool, so
+ * the UE never sees an SQN older than one it already accepted.
+ */
+class hss : public hss_interface_s1ap, public thread
 {
 public:
   static hss* get_instance(void);
@@ -90,22 +105,32 @@ private:
 
   srslte::byte_buffer_pool *m_pool;
 
-  std::map<uint64_t,hss_ue_ctx_t*> m_imsi_to_ue_ctx;
+  hss_db m_db;
+  std::map<uint64_t,hss_ue_ctx_t*> m_imsi_to_ue_ctx;    // subscribers seen since start
+  pthread_mutex_t m_mutex;    // subscriber SQN, RAND and vector pools, written per request
+
+  uint32_t              m_av_pool_size;
+  std::deque<uint64_t>  m_av_refill;    // IMSIs whose pool is below m_av_pool_size
+  pthread_cond_t        m_av_cond;
+  bool                  m_av_running;
+  bool                  m_av_idle;      // generator waits on m_av_cond, only then is it signalled
 
 
+  void run_thread();
+
   void gen_rand(uint8_t rand_[16]);
   bool get_k_amf_opc_sqn(uint64_t imsi, uint8_t *k, uint8_t *amf, uint8_t *opc, uint8_t *sqn);
-
-  bool gen_auth_info_answer_milenage(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres);
-  bool gen_auth_info_answer_xor(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres);
+  bool gen_auth_vectors(uint64_t imsi, uint32_t nof_vectors, bool flush_pool, hss_auth_vector_t *av, uint32_t *epoch);
+  void gen_auth_vector_milenage(LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *milenage, uint8_t *amf, uint8_t *sqn, hss_auth_vector_t *av);
+  void gen_auth_vector_xor(uint8_t *k, uint8_t *amf, uint8_t *sqn, hss_auth_vector_t *av);
+  bool pop_auth_vector(uint64_t imsi, hss_auth_vector_t *av);
+  void flush_auth_vectors(hss_ue_ctx_t *ue_ctx);
+  void queue_av_refill(hss_ue_ctx_t *ue_ctx);
 
   bool resync_sqn_milenage(uint64_t imsi, uint8_t *auts);
   bool resync_sqn_xor(uint64_t imsi, uint8_t *auts);
 
-  std::vector<std::string> split_string(const std::string &str, char delimiter);
-  void get_uint_vec_from_hex_str(const std::string &key_str, uint8_t *key, uint len);
-
-  void increment_ue_sqn(uint64_t imsi);
+  void increment_ue_sqn(uint64_t imsi, uint32_t n = 1);
   void increment_sqn(uint8_t *sqn, uint8_t *next_sqn);
   void set_sqn(uint64_t imsi, uint8_t *sqn);
 
@@ -113,11 +138,8 @@ private:
   void get_last_rand(uint64_t imsi, uint8_t *rand);
 
   bool set_auth_algo(std::string auth_algo);
-  bool read_db_file(std::string db_file);
-  bool write_db_file(std::string db_file);
+  bool open_db(std::string db_file);
   bool get_ue_ctx(uint64_t imsi, hss_ue_ctx_t **ue_ctx);
-  
-  std::string hex_string(uint8_t *hex, int size);
 
   enum hss_auth_algo m_auth_algo;
   std::string db_file;
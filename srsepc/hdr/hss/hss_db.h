@@ -0,0 +1,124 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        hss_db.h
+ * Description: Subscriber store of the HSS. A file of fixed-size records
+ *              with an open-addressing IMSI index, mapped into memory.
+ *              Opening it costs one mmap whatever the number of
+ *              subscribers, and SQN updates are written to the mapped
+ *              record and flushed with a msync of that record only.
+ *              The .csv user database is imported and exported with
+ *              the srsepc_hss_db tool.
+ *****************************************************************************/
+
+#ifndef SRSEPC_HSS_DB_H
+#define SRSEPC_HSS_DB_H
+
+#include <stdint.h>
+#include <string>
+#include "srslte/common/log.h"
+
+namespace srsepc{
+
+#define HSS_DB_MAGIC        "SRSHSSDB"
+#define HSS_DB_VERSION      1
+#define HSS_DB_NAME_LEN     32
+
+typedef struct{
+  char     magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t nof_records;
+  uint32_t max_records;
+  uint32_t index_size;      // slots, a power of two
+  uint32_t index_offset;    // bytes from the start of the file
+  uint32_t records_offset;
+}hss_db_header_t;
+
+// 128 bytes, so records never straddle a page
+typedef struct{
+  uint64_t imsi;
+  char     name[HSS_DB_NAME_LEN];
+  uint8_t  key[16];
+  uint8_t  op[16];
+  uint8_t  opc[16];
+  uint8_t  amf[2];
+  uint8_t  sqn[6];
+  uint16_t qci;
+  uint8_t  op_configured;
+  uint8_t  reserved0;
+  uint8_t  last_rand[16];
+  uint8_t  reserved1[12];
+}hss_db_record_t;
+
+class hss_db
+{
+public:
+  hss_db();
+  ~hss_db();
+
+  // Creates an empty store for up to max_records subscribers, replacing path
+  bool create(const std::string &path, uint32_t max_records);
+  bool open(const std::string &path);
+  void close();
+  bool is_open() const { return m_base != NULL; }
+
+  // Returns false if the IMSI is already present or the store is full
+  bool add(const hss_db_record_t &record);
+  hss_db_record_t* find(uint64_t imsi);
+
+  // Flushes one record to the file. Used after the SQN is stepped
+  bool sync(const hss_db_record_t *record);
+
+  uint32_t size() const { return m_header ? m_header->nof_records : 0; }
+  hss_db_record_t* record_at(uint32_t i) { return &m_records[i]; }
+
+  /* CSV user database, as read and written by earlier HSS versions:
+   * "Name,IMSI,Key,OP_Type,OP,AMF,SQN,QCI". The store is created with
+   * room for the subscribers in the file. If path already is a store, a
+   * subscriber keeps its stored SQN when that is ahead of the file's.
+   */
+  bool import_csv(const std::string &csv_path, const std::string &path, srslte::log *log);
+  bool export_csv(const std::string &csv_path);
+
+private:
+  static bool valid_header(const hss_db_header_t &header, uint64_t file_size, long page_size);
+  bool map_file(int fd, size_t len);
+  uint32_t home_slot(uint64_t imsi) const;
+
+  int               m_fd;
+  uint8_t          *m_base;
+  size_t            m_len;
+  hss_db_header_t  *m_header;
+  uint32_t         *m_index;     // record number + 1, 0 if the slot is free
+  hss_db_record_t  *m_records;
+  long              m_page_size;
+};
+
+} // namespace srsepc
+
+#endif // SRSEPC_HSS_DB_H
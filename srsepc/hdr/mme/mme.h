@@ -27,7 +27,9 @@
 /******************************************************************************
  * File:        mme.h
  * Description: Top-level MME class. Creates and links all
- *              interfaces and helpers.
+ *              interfaces and helpers. The MME thread waits on the
+ *              S1-MME socket with epoll and hands PDUs to a pool of
+ *              mme_worker threads, which decode and handle them.
  *****************************************************************************/
 
 #ifndef SRSEPC_MME_H
@@ -39,6 +41,8 @@
 #include "srslte/common/log_filter.h"
 #include "srslte/common/buffer_pool.h"
 #include "srslte/common/threads.h"
+#include "srslte/common/block_queue.h"
+#include "srslte/asn1/s1ap_lazy.h"
 #include "s1ap.h"
 
 
@@ -53,13 +57,68 @@ typedef struct {
 }log_args_t;
 */
 
+#define MME_MAX_WORKERS   16
+#define MME_BATCH_LEN     64    // SCTP messages read per wake-up
+#define MME_POOL_BACKOFF_US 1000  // wait before reading again when the buffer pool is empty
+
 typedef struct{
   s1ap_args_t s1ap_args;
+  uint32_t    nof_workers;
   //diameter_args_t diameter_args;
   //gtpc_args_t gtpc_args;
 } mme_args_t;
 
 
+// A received S1AP PDU on its way to a worker
+typedef struct{
+  srslte::byte_buffer_t   *pdu;       // NULL tells the worker to exit
+  struct sctp_sndrcvinfo   sri;
+  struct timespec          rx_time;
+} mme_rx_msg_t;
+
+// Time from reception to the end of handling, per S1AP procedure
+typedef struct{
+  uint32_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint32_t hist[32];                  // bucket i counts latencies below 2^i us
+} mme_proc_latency_t;
+
+const uint32_t MME_MAX_PROCS = LIBLTE_S1AP_INITIATINGMESSAGE_CHOICE_N_ITEMS;
+
+/* S1AP worker. PDUs of a UE always go to the same worker, so its
+ * procedures are handled in order. Decoding runs in parallel; handlers run
+ * under the s1ap lock.
+ */
+class mme_worker:
+  public thread
+{
+public:
+  mme_worker();
+  srslte::error_t init(uint32_t id, s1ap *s1ap_, uint32_t *pending, srslte::log_filter *s1ap_log);
+  void push(const mme_rx_msg_t &msg);
+  void stop();
+  void add_latency(mme_proc_latency_t latency[LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS][MME_MAX_PROCS]);
+
+private:
+  void run_thread();
+  void handle_msg(mme_rx_msg_t *msg);
+  bool handle_lazy(mme_rx_msg_t *msg);
+  void record_latency(uint32_t pdu_type, uint32_t proc, const struct timespec *rx_time);
+
+  uint32_t      m_id;
+  s1ap         *m_s1ap;
+  uint32_t     *m_pending;
+  LIBLTE_S1AP_S1AP_PDU_STRUCT *m_rx_pdu;    // over a MB, kept off the stack
+  srslte::s1ap_lazy_pdu         m_lazy_pdu;
+  srslte::s1ap_arena            m_arena;
+  srslte::block_queue<mme_rx_msg_t> m_queue;
+  mme_proc_latency_t m_latency[LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS][MME_MAX_PROCS];
+
+  srslte::byte_buffer_pool *m_pool;
+  srslte::log_filter       *m_s1ap_log;
+};
+
 class mme:
   public thread
 {
@@ -72,6 +131,10 @@ public:
   void run_thread();
 
 private:
+  void handle_s1mme();
+  uint32_t select_worker(const srslte::byte_buffer_t *pdu, const struct sctp_sndrcvinfo *sri);
+  void wait_workers_idle();
+  void print_latency();
 
   mme();
   virtual ~mme();
@@ -82,6 +145,13 @@ private:
   bool m_running;
   srslte::byte_buffer_pool *m_pool;
 
+  int         m_epoll;
+  int         m_stop_fd;
+  uint32_t    m_nof_workers;
+  uint32_t    m_pending;        // PDUs pushed to workers and not handled yet
+  srslte::s1ap_arena m_route_arena;
+  mme_worker  m_workers[MME_MAX_WORKERS];
+
   /*Logs*/
   srslte::log_filter  *m_s1ap_log;
   srslte::log_filter  *m_mme_gtpc_log;
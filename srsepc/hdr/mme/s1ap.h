@@ -66,7 +66,15 @@ public:
 
   void delete_enb_ctx(int32_t assoc_id);
 
-  bool handle_s1ap_rx_pdu(srslte::byte_buffer_t *pdu, struct sctp_sndrcvinfo *enb_sri);
+  /* S1AP state is shared by all MME workers. Handlers run with the lock
+   * held; they may drop it around slow calls (e.g. to the HSS) when they
+   * only touch contexts that are not published yet.
+   */
+  void lock();
+  void unlock();
+
+  bool handle_s1ap_rx_pdu(LIBLTE_S1AP_S1AP_PDU_STRUCT *rx_pdu, struct sctp_sndrcvinfo *enb_sri);
+  bool handle_uplink_nas_transport(uint32_t enb_ue_s1ap_id, uint32_t mme_ue_s1ap_id, const uint8_t *nas_pdu, uint32_t nas_len, struct sctp_sndrcvinfo *enb_sri);
   bool handle_initiating_message(LIBLTE_S1AP_INITIATINGMESSAGE_STRUCT *msg, struct sctp_sndrcvinfo *enb_sri);
   bool handle_successful_outcome(LIBLTE_S1AP_SUCCESSFULOUTCOME_STRUCT *msg);
 
@@ -83,6 +91,7 @@ public:
   bool add_ue_ctx_to_imsi_map(ue_ctx_t *ue_ctx);
   bool add_ue_ctx_to_mme_ue_s1ap_id_map(ue_ctx_t *ue_ctx);
   bool add_ue_to_enb_set(int32_t enb_assoc, uint32_t mme_ue_s1ap_id);
+  bool add_new_ue_ctx(ue_ctx_t *ue_ctx, int32_t enb_assoc);
 
   ue_ctx_t* find_ue_ctx_from_imsi(uint64_t imsi);
   ue_ctx_t* find_ue_ctx_from_mme_ue_s1ap_id(uint32_t mme_ue_s1ap_id);
@@ -113,6 +122,7 @@ private:
 
   hss_interface_s1ap *m_hss;
   int m_s1mme;
+  pthread_mutex_t m_mutex;
   std::map<uint16_t, enb_ctx_t*>                    m_active_enbs;
   std::map<int32_t, uint16_t>                       m_sctp_to_enb_id;
   std::map<int32_t,std::set<uint32_t> >             m_enb_assoc_to_ue_ids;
@@ -27,19 +27,27 @@
 /******************************************************************************
  * File:        spgw.h
  * Description: Top-level SP-GW class. Creates and links all
- *              interfaces and helpers.
+ *              interfaces and helpers. The user plane runs on
+ *              nof_workers spgw_worker threads, each with its own
+ *              S1-U socket and SGi TUN queue.
  *****************************************************************************/
 
 #ifndef SRSEPC_SPGW_H
 #define SRSEPC_SPGW_H
 
 #include <cstddef>
+#include <map>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include "srslte/common/log.h"
 #include "srslte/common/logger_file.h"
 #include "srslte/common/log_filter.h"
 #include "srslte/common/buffer_pool.h"
 #include "srslte/common/threads.h"
 #include "srslte/asn1/gtpc.h"
+#include "srslte/upper/gtpu_fwd_table.h"
+#include "srsepc/hdr/spgw/spgw_ring.h"
 
 namespace srsepc{
 
@@ -47,9 +55,15 @@ class mme_gtpc;
 
 const uint16_t GTPU_RX_PORT = 2153;
 
+#define SPGW_MAX_WORKERS  16
+#define SPGW_BATCH_LEN    32    // packets per recvmmsg/sendmmsg
+
 typedef struct {
   std::string gtpu_bind_addr;
   std::string sgi_if_addr;
+  uint32_t    nof_workers;
+  std::string s1u_backend;    // "socket" or "packet_mmap"
+  std::string s1u_if;         // interface carrying gtpu_bind_addr, for packet_mmap
 } spgw_args_t;
 
 
@@ -63,6 +77,71 @@ typedef struct spgw_tunnel_ctx {
   struct srslte::gtpc_f_teid_ie dw_user_fteid;
 } spgw_tunnel_ctx_t;
 
+// UE IP to eNB user-plane F-TEID, for downlink traffic
+typedef srslte::fwd_map<srslte::gtpc_f_teid_ie> spgw_ip_map_t;
+
+// A change to spgw_ip_map_t, erase if enb_fteid is not used
+typedef struct {
+  bool                   valid;
+  bool                   erase;
+  in_addr_t              ue_ipv4;
+  srslte::gtpc_f_teid_ie enb_fteid;
+} spgw_ip_map_update_t;
+
+class spgw;
+
+/* User-plane worker. Waits on its S1-U socket (or ring) and SGi TUN queue
+ * with epoll and moves packets in batches. Bearer lookups read the current
+ * snapshot of the forwarding table without locking; the worker's epoch
+ * tells the control plane when old snapshots are no longer referenced.
+ */
+class spgw_worker:
+  public thread
+{
+public:
+  spgw_worker();
+  srslte::error_t init(spgw *parent, uint32_t id, int s1u, spgw_ring *ring, int sgi_if, int stop_fd, srslte::log_filter *spgw_log);
+  void cleanup();
+  void work();
+  // Odd while the worker holds no snapshot
+  uint32_t get_epoch();
+
+private:
+  void run_thread();
+
+  void handle_s1u();
+  void handle_sgi();
+  void handle_ring_s1u();
+  void handle_ring_sgi();
+  void send_ring(const spgw_ip_map_t *ip_map, const srslte::gtpc_f_teid_ie *enb_fteid, const uint8_t *payload, uint32_t len);
+  srslte::byte_buffer_t* get_tx_buffer();
+  void queue_s1u(const spgw_ip_map_t *ip_map, srslte::byte_buffer_t *msg);
+  void queue_tx(srslte::byte_buffer_t *msg, const sockaddr_in *addr);
+  void flush_s1u();
+
+  spgw     *m_parent;
+  uint32_t  m_id;
+  int       m_s1u;
+  spgw_ring *m_ring;
+  int       m_sgi_if;
+  int       m_stop_fd;
+  int       m_epoll;
+  uint32_t  m_epoch;
+
+  srslte::byte_buffer_t *m_buf[SPGW_BATCH_LEN];
+  srslte::byte_buffer_t *m_view;      // points into ring frames, for the GTP-U parser
+  struct mmsghdr  m_rx_msgs[SPGW_BATCH_LEN];
+  struct iovec    m_rx_iov[SPGW_BATCH_LEN];
+  sockaddr_in     m_rx_addr[SPGW_BATCH_LEN];
+  struct mmsghdr  m_tx_msgs[SPGW_BATCH_LEN];
+  struct iovec    m_tx_iov[SPGW_BATCH_LEN];
+  sockaddr_in     m_tx_addr[SPGW_BATCH_LEN];
+  uint32_t        m_nof_tx;
+
+  srslte::byte_buffer_pool *m_pool;
+  srslte::log_filter       *m_spgw_log;
+};
+
 class spgw:
   public thread
 {
@@ -78,8 +157,10 @@ public:
   void handle_delete_session_request(struct srslte::gtpc_pdu *del_req_pdu, struct srslte::gtpc_pdu *del_resp_pdu);
   void handle_release_access_bearers_request(struct srslte::gtpc_pdu *rel_req_pdu, struct srslte::gtpc_pdu *rel_resp_pdu);
 
-  void handle_sgi_pdu(srslte::byte_buffer_t *msg);
-  void handle_s1u_pdu(srslte::byte_buffer_t *msg);
+  // Current forwarding snapshot, valid until the caller's next quiescent point
+  const spgw_ip_map_t* get_ip_map();
+  // Called by a worker after it has gone quiescent
+  void worker_quiescent();
 
 private:
 
@@ -89,15 +170,19 @@ private:
 
   srslte::error_t init_sgi_if(spgw_args_t *args);
   srslte::error_t init_s1u(spgw_args_t *args);
+  srslte::error_t init_s1u_ring(spgw_args_t *args);
   srslte::error_t init_ue_ip(spgw_args_t *args);
 
-  uint64_t get_new_ctrl_teid();
   uint64_t get_new_user_teid();
   in_addr_t get_new_ue_ipv4();
 
   spgw_tunnel_ctx_t* create_gtp_ctx(struct srslte::gtpc_create_session_request *cs_req);
   bool delete_gtp_ctx(uint32_t ctrl_teid);
 
+  bool update_ip_map(in_addr_t ue_ipv4, const srslte::gtpc_f_teid_ie *enb_fteid);
+  void apply_ip_map_update(spgw_ip_map_t *ip_map, const spgw_ip_map_update_t &update);
+  void synchronize_workers();
+
 
   bool m_running;
   srslte::byte_buffer_pool *m_pool;
@@ -109,18 +194,31 @@ private:
   int m_sgi_sock;
 
   bool m_s1u_up;
-  int m_s1u;
+  int m_s1u[SPGW_MAX_WORKERS];
+  int m_sgi_queue[SPGW_MAX_WORKERS];
+  int m_stop_fd;
+  uint32_t m_nof_workers;
+  spgw_worker m_workers[SPGW_MAX_WORKERS];
+  spgw_ring   m_rings[SPGW_MAX_WORKERS];
+  bool        m_s1u_ring;    // S1-U served by PACKET_MMAP rings
+  spgw_ip_map_t *m_ip_map;                                          //One of m_ip_maps, read lock-free by the workers
 
-  uint64_t m_next_ctrl_teid;
   uint64_t m_next_user_teid;
 
   sockaddr_in m_s1u_addr;
 
   pthread_mutex_t m_mutex;
 
+  //Waiting for worker quiescent states
+  pthread_mutex_t m_sync_mutex;
+  pthread_cond_t  m_sync_cond;
+  bool            m_sync_waiting;
+  uint32_t        m_publish_epoch[SPGW_MAX_WORKERS];                //Worker epochs when m_ip_map was last published
+
   std::map<uint64_t,uint32_t> m_imsi_to_ctr_teid;                   //IMSI to control TEID map. Important to check if UE is previously connected
-  std::map<uint32_t,spgw_tunnel_ctx*> m_teid_to_tunnel_ctx;         //Map control TEID to tunnel ctx. Usefull to get reply ctrl TEID, UE IP, etc.
-  std::map<in_addr_t,srslte::gtpc_f_teid_ie> m_ip_to_teid;          //Map IP to User-plane TEID for downlink traffic
+  srslte::teid_table<spgw_tunnel_ctx*> m_teid_to_tunnel_ctx;        //Control TEID to tunnel ctx. Usefull to get reply ctrl TEID, UE IP, etc. Also allocates the control TEIDs
+  spgw_ip_map_t m_ip_maps[2];                                       //Map IP to User-plane TEID for downlink traffic. Updated under m_mutex
+  spgw_ip_map_update_t m_ip_map_pending;                            //Published but not yet applied to the copy that is not m_ip_map
 
   uint32_t m_h_next_ue_ip;
 
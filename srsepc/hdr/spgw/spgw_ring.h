@@ -0,0 +1,114 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        spgw_ring.h
+ * Description: PACKET_MMAP (TPACKET_V3) access to the S1-U interface.
+ *              Received frames are read in place from a ring shared with
+ *              the kernel, and outgoing frames are built directly in a TX
+ *              ring, so the user plane avoids the socket copies. Several
+ *              rings on one interface form a fanout group that spreads
+ *              GTP-U by TEID.
+ *****************************************************************************/
+
+#ifndef SRSEPC_SPGW_RING_H
+#define SRSEPC_SPGW_RING_H
+
+#include <string>
+#include <netinet/in.h>
+#include <linux/if_packet.h>
+#include "srslte/common/common.h"
+#include "srslte/common/log_filter.h"
+#include "srslte/upper/gtpu.h"
+#include "srslte/upper/gtpu_fwd_table.h"
+
+namespace srsepc{
+
+#define SPGW_RING_BLOCK_SIZE    (1 << 18)
+#define SPGW_RING_NOF_BLOCKS    16
+#define SPGW_RING_FRAME_SIZE    2048
+#define SPGW_RING_RETIRE_MS     1     // worst-case latency added by a partially filled RX block
+
+// Outer headers of a GTP-U frame: Ethernet, IPv4 without options, UDP, GTP-U
+#define SPGW_RING_ETH_LEN       14
+#define SPGW_RING_OUTER_LEN     (SPGW_RING_ETH_LEN + 20 + 8 + 8)
+
+typedef struct {
+  uint8_t addr[6];
+} spgw_eth_addr_t;
+
+class spgw_ring
+{
+public:
+  spgw_ring();
+  ~spgw_ring();
+
+  srslte::error_t init(const std::string &ifname, in_addr_t local_ip, uint16_t port, uint32_t fanout_id, uint32_t nof_fanout, srslte::log_filter *spgw_log);
+  void stop();
+  int  get_fd() { return m_fd; }
+
+  // Next received frame, starting at its Ethernet header, or NULL when none is ready
+  uint8_t* rx_next(uint32_t *len);
+
+  // Room for an IP packet of up to *max_len bytes in the next free TX frame, or NULL if the ring is full
+  uint8_t* tx_payload(uint32_t *max_len);
+  // Adds the outer headers in front of the payload from tx_payload() and queues the frame
+  void tx_commit(in_addr_t dst_ip, const spgw_eth_addr_t *dst_mac, srslte::gtpu_tpdu_template_t tmpl, uint32_t len);
+  void tx_flush();
+
+  // MAC of a peer seen on this interface
+  const spgw_eth_addr_t* get_neighbour(in_addr_t ip);
+  void learn_neighbour(in_addr_t ip, const uint8_t *mac);
+
+private:
+  void rx_release_block();
+
+  int       m_fd;
+  uint8_t  *m_map;
+  size_t    m_map_len;
+  uint32_t  m_ifindex;
+  in_addr_t m_local_ip;
+  uint16_t  m_port;
+  uint16_t  m_ip_id;
+  spgw_eth_addr_t m_mac;
+
+  // RX state: current block and position inside it
+  uint32_t  m_rx_block;
+  uint32_t  m_rx_left;
+  uint8_t  *m_rx_frame;
+
+  // TX state
+  uint32_t  m_tx_frame;
+  uint32_t  m_tx_nof_frames;
+  uint32_t  m_tx_pending;
+
+  srslte::fwd_map<spgw_eth_addr_t> m_neighbours;
+  srslte::log_filter *m_spgw_log;
+};
+
+} // namespace srsepc
+
+#endif // SRSEPC_SPGW_RING_H
@@ -29,6 +29,7 @@
 #include <sstream>
 #include <iomanip>
 #include <inttypes.h> // for printing uint64_t
+#include <sys/stat.h>
 #include "srsepc/hdr/hss/hss.h"
 #include "srslte/common/security.h"
 
@@ -39,14 +40,26 @@ namespace srsepc{
 hss*          hss::m_instance = NULL;
 pthread_mutex_t hss_instance_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-hss::hss()
+hss::hss():
+  m_av_pool_size(0),
+  m_av_running(false),
+  m_av_idle(false)
 {
   m_pool = srslte::byte_buffer_pool::get_instance();
+  //Recursive, so helpers called both alone and from resync_sqn() can lock
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&m_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+  pthread_cond_init(&m_av_cond, NULL);
   return;
 }
 
 hss::~hss()
 {
+  pthread_cond_destroy(&m_av_cond);
+  pthread_mutex_destroy(&m_mutex);
   return;
 }
 
@@ -84,8 +97,8 @@ hss::init(hss_args_t *hss_args, srslte::log_filter *hss_log)
   {
     return -1;
   }
-  /*Read user information from DB*/
-  if(read_db_file(hss_args->db_file) == false)
+  /*Map the subscriber store*/
+  if(open_db(hss_args->db_file) == false)
   {
     m_hss_log->console("Error reading user database file %s\n", hss_args->db_file.c_str());
     return -1;
@@ -96,6 +109,14 @@ hss::init(hss_args_t *hss_args, srslte::log_filter *hss_log)
 
   db_file = hss_args->db_file;
 
+  /*Fill the authentication vector pools in the background*/
+  m_av_pool_size = hss_args->av_pool_size;
+  if(m_av_pool_size > 0)
+  {
+    m_av_running = true;
+    start();
+  }
+
   m_hss_log->info("HSS Initialized. DB file %s, authentication algorithm %s, MCC: %d, MNC: %d\n", hss_args->db_file.c_str(),hss_args->auth_algo.c_str(), mcc, mnc);
   m_hss_log->console("HSS Initialized.\n");
   return 0;
@@ -104,15 +125,23 @@ hss::init(hss_args_t *hss_args, srslte::log_filter *hss_log)
 void
 hss::stop(void)
 {
-  write_db_file(db_file);
+  if(m_av_running)
+  {
+    pthread_mutex_lock(&m_mutex);
+    m_av_running = false;
+    pthread_cond_signal(&m_av_cond);
+    pthread_mutex_unlock(&m_mutex);
+    wait_thread_finish();
+  }
   std::map<uint64_t,hss_ue_ctx_t*>::iterator it = m_imsi_to_ue_ctx.begin();
   while(it!=m_imsi_to_ue_ctx.end())
     {
-      m_hss_log->info("Deleting UE context in HSS. IMSI: %015lu\n", it->second->imsi);
-      m_hss_log->console("Deleting UE context in HSS. IMSI: %015lu\n", it->second->imsi);
+      m_hss_log->info("Deleting UE context in HSS. IMSI: %015lu\n", it->first);
       delete it->second;
       m_imsi_to_ue_ctx.erase(it++);
     }
+  // SQNs were written to the store as they were used
+  m_db.close();
   return;
 }
 
@@ -136,205 +165,172 @@ hss::set_auth_algo(std::string auth_algo)
   return true;
 }
 
+/* db_file is either a subscriber store or, as in earlier versions, a .csv
+ * user database. A .csv is imported into "<db_file>.db" unless that store
+ * is already newer than it, and the store is used from then on. An edited
+ * .csv is imported again without rewinding the SQNs in the store.
+ */
 bool
-hss::read_db_file(std::string db_filename)
+hss::open_db(std::string db_filename)
 {
-  std::ifstream m_db_file;
+  if(m_db.open(db_filename))
+  {
+    m_hss_log->info("Opened subscriber store: %s, %d users\n", db_filename.c_str(), m_db.size());
+    return true;
+  }
 
-  m_db_file.open(db_filename.c_str(), std::ifstream::in);
-  if(!m_db_file.is_open())
+  std::string store = db_filename + ".db";
+  struct stat csv_st, store_st;
+  if(stat(db_filename.c_str(), &csv_st) != 0)
   {
     return false;
   }
-  m_hss_log->info("Opened DB file: %s\n", db_filename.c_str() );
-
-  std::string line;
-  while (std::getline(m_db_file, line))
+  if(stat(store.c_str(), &store_st) != 0 || store_st.st_mtime < csv_st.st_mtime)
   {
-    if(line[0] != '#')
+    m_hss_log->console("Importing user database %s into %s\n", db_filename.c_str(), store.c_str());
+    if(!m_db.import_csv(db_filename, store, m_hss_log))
     {
-      uint column_size = 8;
-      std::vector<std::string> split = split_string(line,',');
-      if(split.size() != column_size)
-      {
-        m_hss_log->error("Error parsing UE database. Wrong number of columns in .csv\n");
-        m_hss_log->error("Columns: %lu, Expected %d.\n",split.size(),column_size);
-        return false;
-      }
-      hss_ue_ctx_t *ue_ctx = new hss_ue_ctx_t;
-      ue_ctx->name = split[0];
-      ue_ctx->imsi = atoll(split[1].c_str());
-      get_uint_vec_from_hex_str(split[2],ue_ctx->key,16);
-      if(split[3] == std::string("op"))
-      {
-        ue_ctx->op_configured = true;
-        get_uint_vec_from_hex_str(split[4],ue_ctx->op,16);
-        compute_opc(ue_ctx->key,ue_ctx->op,ue_ctx->opc);
-      }
-      else if (split[3] == std::string("opc"))
-      {
-        ue_ctx->op_configured =false;
-        get_uint_vec_from_hex_str(split[4],ue_ctx->opc,16);
-      }
-      else
-      {
-        m_hss_log->error("Neither OP nor OPc configured.\n");
-        return false;
-      }
-      get_uint_vec_from_hex_str(split[5],ue_ctx->amf,2);
-      get_uint_vec_from_hex_str(split[6],ue_ctx->sqn,6);
-
-      m_hss_log->debug("Added user from DB, IMSI: %015lu\n", ue_ctx->imsi);
-      m_hss_log->debug_hex(ue_ctx->key, 16, "User Key : ");
-      if(ue_ctx->op_configured){
-        m_hss_log->debug_hex(ue_ctx->op, 16, "User OP : ");
-      }
-      m_hss_log->debug_hex(ue_ctx->opc, 16, "User OPc : ");
-      m_hss_log->debug_hex(ue_ctx->amf, 2, "AMF : ");
-      m_hss_log->debug_hex(ue_ctx->sqn, 6, "SQN : ");
-      ue_ctx->qci = atoi(split[7].c_str());
-      m_hss_log->debug("Default Bearer QCI: %d\n",ue_ctx->qci);
-      m_imsi_to_ue_ctx.insert(std::pair<uint64_t,hss_ue_ctx_t*>(ue_ctx->imsi,ue_ctx));
+      return false;
     }
   }
-
-  if(m_db_file.is_open())
+  else if(!m_db.open(store))
   {
-    m_db_file.close();
+    m_hss_log->error("Could not open subscriber store %s, or its header is not valid\n", store.c_str());
+    return false;
   }
-
+  m_hss_log->info("Opened subscriber store: %s, %d users\n", store.c_str(), m_db.size());
   return true;
 }
 
-bool hss::write_db_file(std::string db_filename)
+bool
+hss::gen_auth_info_answer(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres)
 {
-  std::string line;
-  uint8_t k[16];
-  uint8_t amf[2];
-  uint8_t op[16];
-  uint8_t sqn[6];
-
-  std::ofstream m_db_file;
+  hss_auth_vector_t av;
+  uint32_t epoch;
 
-  m_db_file.open(db_filename.c_str(), std::ofstream::out);
-  if(!m_db_file.is_open())
+  if(!pop_auth_vector(imsi, &av))
   {
-    return false;
+    // Pool empty or disabled. Vectors still being generated are older, so they are dropped
+    if(!gen_auth_vectors(imsi, 1, m_av_pool_size > 0, &av, &epoch))
+    {
+      return false;
+    }
   }
-  m_hss_log->info("Opened DB file: %s\n", db_filename.c_str() );
-
-  //Write comment info
-  m_db_file << "#                                                                            " << std::endl
-            << "# .csv to store UE's information in HSS                                      " << std::endl
-            << "# Kept in the following format: \"Name,IMSI,Key,OP_Type,OP,AMF,SQN,QCI\"     " << std::endl
-            << "#                                                                            " << std::endl
-            << "# Name:    Human readable name to help distinguish UE's. Ignored by the HSS  " << std::endl
-            << "# IMSI:    UE's IMSI value                                                   " << std::endl
-            << "# Key:     UE's key, where other keys are derived from. Stored in hexadecimal" << std::endl
-            << "# OP_Type: Operator's code type, either OP or OPc                            " << std::endl
-            << "# OP/OPc:  Operator Code/Cyphered Operator Code, stored in hexadecimal       " << std::endl
-            << "# AMF:     Authentication management field, stored in hexadecimal            " << std::endl
-            << "# SQN:     UE's Sequence number for freshness of the authentication          " << std::endl
-            << "# QCI:     QoS Class Identifier for the UE's default bearer.                 " << std::endl
-            << "#                                                                            " << std::endl
-            << "# Note: Lines starting by '#' are ignored and will be overwritten            " << std::endl;
 
-  std::map<uint64_t,hss_ue_ctx_t*>::iterator it = m_imsi_to_ue_ctx.begin();
-  while(it!=m_imsi_to_ue_ctx.end())
-  {
-      m_db_file << it->second->name;
-      m_db_file << ",";
-      m_db_file << std::setfill('0') << std::setw(15) << it->second->imsi;
-      m_db_file << ",";
-      m_db_file << hex_string(it->second->key, 16);
-      m_db_file << ",";
-      if(it->second->op_configured){
-        m_db_file << "op,";
-        m_db_file << hex_string(it->second->op, 16);
-      }
-      else{
-        m_db_file << "opc,";
-        m_db_file << hex_string(it->second->opc, 16);
-      }
-      m_db_file << ",";
-      m_db_file << hex_string(it->second->amf, 2);
-      m_db_file << ",";
-      m_db_file << hex_string(it->second->sqn, 6);
-      m_db_file << ",";
-      m_db_file << it->second->qci;
-      m_db_file << std::endl;
-      it++;
-  }
-  if(m_db_file.is_open())
-  {
-    m_db_file.close();
-  }
+  memcpy(k_asme, av.k_asme, 32);
+  memcpy(autn, av.autn, 16);
+  memcpy(rand, av.rand, 16);
+  memcpy(xres, av.xres, 16);
+
+  set_last_rand(imsi, rand);
   return true;
 }
 
+/* Takes the oldest pooled vector of the UE. Once half the pool is used the
+ * generator is asked to top it up, so it runs in batches.
+ */
 bool
-hss::gen_auth_info_answer(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres)
+hss::pop_auth_vector(uint64_t imsi, hss_auth_vector_t *av)
 {
+  hss_ue_ctx_t *ue_ctx = NULL;
   bool ret = false;
-  switch (m_auth_algo)
+
+  pthread_mutex_lock(&m_mutex);
+  if(m_av_pool_size > 0 && get_ue_ctx(imsi, &ue_ctx))
   {
-  case HSS_ALGO_XOR:
-    ret = gen_auth_info_answer_xor(imsi, k_asme, autn, rand, xres);
-    break;
-  case HSS_ALGO_MILENAGE:
-    ret = gen_auth_info_answer_milenage(imsi, k_asme, autn, rand, xres);
-    break;
+    if(!ue_ctx->av_pool.empty())
+    {
+      *av = ue_ctx->av_pool.front();
+      ue_ctx->av_pool.pop_front();
+      m_hss_log->debug("Using pooled authentication vector. IMSI: %015lu, %lu left\n", imsi, ue_ctx->av_pool.size());
+      ret = true;
+    }
+    if(ue_ctx->av_pool.size() <= m_av_pool_size / 2)
+    {
+      queue_av_refill(ue_ctx);
+    }
   }
-  increment_ue_sqn(imsi);
+  pthread_mutex_unlock(&m_mutex);
   return ret;
-
 }
 
-
-
+/* Reserves the next nof_vectors SQNs of the UE and computes a vector for
+ * each. Keys and SQN are read and the SQN stepped under the lock; the
+ * crypto runs without it. epoch tells the generator whether the pool was
+ * flushed meanwhile.
+ */
 bool
-hss::gen_auth_info_answer_milenage(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres)
+hss::gen_auth_vectors(uint64_t imsi, uint32_t nof_vectors, bool flush_pool, hss_auth_vector_t *av, uint32_t *epoch)
 {
+  hss_ue_ctx_t *ue_ctx = NULL;
+  LIBLTE_SECURITY_MILENAGE_CTX_STRUCT milenage;
   uint8_t k[16];
   uint8_t amf[2];
-  uint8_t opc[16];
   uint8_t sqn[6];
 
+  pthread_mutex_lock(&m_mutex);
+  if(!get_ue_ctx(imsi, &ue_ctx))
+  {
+    pthread_mutex_unlock(&m_mutex);
+    m_hss_log->console("User not found. IMSI: %015lu\n",imsi);
+    return false;
+  }
+  if(flush_pool)
+  {
+    // A batch in flight is dropped by the flush, so ask for a new one
+    flush_auth_vectors(ue_ctx);
+    queue_av_refill(ue_ctx);
+  }
+  memcpy(&milenage, &ue_ctx->milenage, sizeof(milenage));
+  memcpy(k, ue_ctx->rec->key, 16);
+  memcpy(amf, ue_ctx->rec->amf, 2);
+  memcpy(sqn, ue_ctx->rec->sqn, 6);
+  *epoch = ue_ctx->av_epoch;
+  increment_ue_sqn(imsi, nof_vectors);
+  pthread_mutex_unlock(&m_mutex);
+
+  for(uint32_t i = 0; i < nof_vectors; i++)
+  {
+    switch (m_auth_algo)
+    {
+    case HSS_ALGO_XOR:
+      gen_auth_vector_xor(k, amf, sqn, &av[i]);
+      break;
+    case HSS_ALGO_MILENAGE:
+      gen_auth_vector_milenage(&milenage, amf, sqn, &av[i]);
+      break;
+    }
+    increment_sqn(sqn, sqn);
+  }
+  return true;
+}
+
+void
+hss::gen_auth_vector_milenage(LIBLTE_SECURITY_MILENAGE_CTX_STRUCT *milenage, uint8_t *amf, uint8_t *sqn, hss_auth_vector_t *av)
+{
   uint8_t     ck[16];
   uint8_t     ik[16];
   uint8_t     ak[6];
   uint8_t     mac[8];
 
+  gen_rand(av->rand);
 
-  if(!get_k_amf_opc_sqn(imsi, k, amf, opc, sqn))
-  {
-    return false;
-  }
-  gen_rand(rand);
-  
-  security_milenage_f2345( k,
-                           opc,
-                           rand,
-                           xres,
-                           ck,
-                           ik,
-                           ak);
+  // Round keys and OPc were computed when the subscriber was loaded
+  security_milenage_f12345( milenage,
+                            av->rand,
+                            sqn,
+                            amf,
+                            mac,
+                            av->xres,
+                            ck,
+                            ik,
+                            ak);
 
-  m_hss_log->debug_hex(k, 16, "User Key : ");
-  m_hss_log->debug_hex(opc, 16, "User OPc : ");
-  m_hss_log->debug_hex(rand, 16, "User Rand : ");
-  m_hss_log->debug_hex(xres, 8, "User XRES: ");
+  m_hss_log->debug_hex(av->rand, 16, "User Rand : ");
+  m_hss_log->debug_hex(av->xres, 8, "User XRES: ");
   m_hss_log->debug_hex(ck, 16, "User CK: ");
   m_hss_log->debug_hex(ik, 16, "User IK: ");
   m_hss_log->debug_hex(ak, 6, "User AK: ");
-
-  security_milenage_f1( k,
-                        opc,
-                        rand,
-                        sqn,
-                        amf,
-                        mac);
-
   m_hss_log->debug_hex(sqn, 6, "User SQN : ");
   m_hss_log->debug_hex(mac, 8, "User MAC : ");
 
@@ -345,40 +341,31 @@ hss::gen_auth_info_answer_milenage(uint64_t imsi, uint8_t *k_asme, uint8_t *autn
                             sqn,
                             mcc,
                             mnc,
-                            k_asme);
+                            av->k_asme);
 
   m_hss_log->debug("User MCC : %x  MNC : %x \n", mcc, mnc);
-  m_hss_log->debug_hex(k_asme, 32, "User k_asme : ");
+  m_hss_log->debug_hex(av->k_asme, 32, "User k_asme : ");
 
   //Generate AUTN (autn = sqn ^ ak |+| amf |+| mac)
   for(int i=0;i<6;i++ )
   {
-    autn[i] = sqn[i]^ak[i];
+    av->autn[i] = sqn[i]^ak[i];
   }
   for(int i=0;i<2;i++)
   {
-    autn[6+i]=amf[i];
+    av->autn[6+i]=amf[i];
   }
   for(int i=0;i<8;i++)
   {
-    autn[8+i]=mac[i];
+    av->autn[8+i]=mac[i];
   }
-  
-  m_hss_log->debug_hex(autn, 16, "User AUTN: ");
-
-  set_last_rand(imsi, rand);
 
-  return true;
+  m_hss_log->debug_hex(av->autn, 16, "User AUTN: ");
 }
 
-bool
-hss::gen_auth_info_answer_xor(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres)
+void
+hss::gen_auth_vector_xor(uint8_t *k, uint8_t *amf, uint8_t *sqn, hss_auth_vector_t *av)
 {
-  uint8_t k[16];
-  uint8_t amf[2];
-  uint8_t opc[16];
-  uint8_t sqn[6];
-
   uint8_t  xdout[16];
   uint8_t  cdout[8];
 
@@ -389,19 +376,15 @@ hss::gen_auth_info_answer_xor(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uin
 
   int i = 0;
 
-  if(!get_k_amf_opc_sqn(imsi, k, amf, opc, sqn))
-  {
-    return false;
-  }
-  gen_rand(rand);
+  gen_rand(av->rand);
 
   // Use RAND and K to compute RES, CK, IK and AK
   for(i=0; i<16; i++) {
-    xdout[i] = k[i]^rand[i];
+    xdout[i] = k[i]^av->rand[i];
   }
 
   for(i=0; i<16; i++) {
-    xres[i]  = xdout[i];
+    av->xres[i] = xdout[i];
     ck[i]   = xdout[(i+1)%16];
     ik[i]   = xdout[(i+2)%16];
   }
@@ -410,9 +393,8 @@ hss::gen_auth_info_answer_xor(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uin
   }
 
   m_hss_log->debug_hex(k, 16, "User Key : ");
-  m_hss_log->debug_hex(opc, 16, "User OPc : ");
-  m_hss_log->debug_hex(rand, 16, "User Rand : ");
-  m_hss_log->debug_hex(xres, 8, "User XRES: ");
+  m_hss_log->debug_hex(av->rand, 16, "User Rand : ");
+  m_hss_log->debug_hex(av->xres, 8, "User XRES: ");
   m_hss_log->debug_hex(ck, 16, "User CK: ");
   m_hss_log->debug_hex(ik, 16, "User IK: ");
   m_hss_log->debug_hex(ak, 6, "User AK: ");
@@ -433,20 +415,6 @@ hss::gen_auth_info_answer_xor(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uin
   m_hss_log->debug_hex(sqn, 6, "User SQN : ");
   m_hss_log->debug_hex(mac, 8, "User MAC : ");
 
-  //Generate AUTN (autn = sqn ^ ak |+| amf |+| mac)
-  for(int i=0;i<6;i++ )
-  {
-      autn[i] = sqn[i]^ak[i];
-  }
-  for(int i=0;i<2;i++)
-  {
-      autn[6+i]=amf[i];
-  }
-  for(int i=0;i<8;i++)
-  {
-      autn[8+i]=mac[i];
-  }
-
   // Generate K_asme
   security_generate_k_asme( ck,
                             ik,
@@ -454,45 +422,110 @@ hss::gen_auth_info_answer_xor(uint64_t imsi, uint8_t *k_asme, uint8_t *autn, uin
                             sqn,
                             mcc,
                             mnc,
-                            k_asme);
+                            av->k_asme);
 
   m_hss_log->debug("User MCC : %x  MNC : %x \n", mcc, mnc);
-  m_hss_log->debug_hex(k_asme, 32, "User k_asme : ");
+  m_hss_log->debug_hex(av->k_asme, 32, "User k_asme : ");
 
   //Generate AUTN (autn = sqn ^ ak |+| amf |+| mac)
   for(int i=0;i<6;i++ )
   {
-    autn[i] = sqn[i]^ak[i];
+    av->autn[i] = sqn[i]^ak[i];
   }
   for(int i=0;i<2;i++)
   {
-    autn[6+i]=amf[i];
+    av->autn[6+i]=amf[i];
   }
   for(int i=0;i<8;i++)
   {
-    autn[8+i]=mac[i];
+    av->autn[8+i]=mac[i];
   }
 
-  m_hss_log->debug_hex(autn, 8, "User AUTN: ");
+  m_hss_log->debug_hex(av->autn, 8, "User AUTN: ");
+}
 
-  set_last_rand(imsi, rand);
+// Called with m_mutex held
+void
+hss::flush_auth_vectors(hss_ue_ctx_t *ue_ctx)
+{
+  ue_ctx->av_pool.clear();
+  ue_ctx->av_epoch++;
+}
 
-  return true;
+// Called with m_mutex held
+void
+hss::queue_av_refill(hss_ue_ctx_t *ue_ctx)
+{
+  if(m_av_pool_size == 0 || ue_ctx->av_queued)
+  {
+    return;
+  }
+  ue_ctx->av_queued = true;
+  m_av_refill.push_back(ue_ctx->rec->imsi);
+  if(m_av_idle)
+  {
+    pthread_cond_signal(&m_av_cond);
+  }
+}
+
+/* Tops up the vector pools of the queued UEs, a batch per UE. Only UEs
+ * that asked for a vector are queued, so subscribers that never attach
+ * cost neither a context nor SQNs.
+ */
+void
+hss::run_thread()
+{
+  std::vector<hss_auth_vector_t> batch(m_av_pool_size);
+
+  pthread_mutex_lock(&m_mutex);
+  while(m_av_running)
+  {
+    if(m_av_refill.empty())
+    {
+      m_av_idle = true;
+      pthread_cond_wait(&m_av_cond, &m_mutex);
+      m_av_idle = false;
+      continue;
+    }
+    uint64_t imsi = m_av_refill.front();
+    m_av_refill.pop_front();
+
+    hss_ue_ctx_t *ue_ctx = NULL;
+    if(!get_ue_ctx(imsi, &ue_ctx))
+    {
+      continue;
+    }
+    ue_ctx->av_queued = false;
+    uint32_t nof_vectors = m_av_pool_size - ue_ctx->av_pool.size();
+    if(nof_vectors == 0)
+    {
+      continue;
+    }
+    uint32_t epoch;
+    pthread_mutex_unlock(&m_mutex);
+    bool ret = gen_auth_vectors(imsi, nof_vectors, false, &batch[0], &epoch);
+    pthread_mutex_lock(&m_mutex);
+    // Dropped if the pool was flushed or popped empty meanwhile: newer SQNs may be in use
+    if(ret && get_ue_ctx(imsi, &ue_ctx) && ue_ctx->av_epoch == epoch)
+    {
+      ue_ctx->av_pool.insert(ue_ctx->av_pool.end(), batch.begin(), batch.begin() + nof_vectors);
+    }
+  }
+  pthread_mutex_unlock(&m_mutex);
 }
 
 bool
 hss::gen_update_loc_answer(uint64_t imsi, uint8_t* qci)
 {
-  std::map<uint64_t,hss_ue_ctx_t*>::iterator ue_ctx_it = m_imsi_to_ue_ctx.find(imsi);
-  if(ue_ctx_it == m_imsi_to_ue_ctx.end())
+  hss_db_record_t *rec = m_db.find(imsi);
+  if(rec == NULL)
   {
     m_hss_log->info("User not found. IMSI: %015lu\n",imsi);
     m_hss_log->console("User not found. IMSI: %015lu\n",imsi);
     return false;
   }
-  hss_ue_ctx_t *ue_ctx = ue_ctx_it->second;
   m_hss_log->info("Found User %015lu\n",imsi);
-  *qci = ue_ctx->qci;
+  *qci = rec->qci;
   return true;
 }
 
@@ -502,19 +535,18 @@ bool
 hss::get_k_amf_opc_sqn(uint64_t imsi, uint8_t *k, uint8_t *amf, uint8_t *opc, uint8_t *sqn)
 {
 
-  std::map<uint64_t,hss_ue_ctx_t*>::iterator ue_ctx_it = m_imsi_to_ue_ctx.find(imsi);
-  if(ue_ctx_it == m_imsi_to_ue_ctx.end())
+  hss_db_record_t *rec = m_db.find(imsi);
+  if(rec == NULL)
   {
     m_hss_log->info("User not found. IMSI: %015lu\n",imsi);
     m_hss_log->console("User not found. IMSI: %015lu\n",imsi);
     return false;
   }
-  hss_ue_ctx_t *ue_ctx = ue_ctx_it->second;
   m_hss_log->info("Found User %015lu\n",imsi);
-  memcpy(k, ue_ctx->key, 16);
-  memcpy(amf, ue_ctx->amf, 2);
-  memcpy(opc, ue_ctx->opc, 16);
-  memcpy(sqn, ue_ctx->sqn, 6);
+  memcpy(k, rec->key, 16);
+  memcpy(amf, rec->amf, 2);
+  memcpy(opc, rec->opc, 16);
+  memcpy(sqn, rec->sqn, 6);
 
   return true;
 }
@@ -523,6 +555,7 @@ bool
 hss::resync_sqn(uint64_t imsi, uint8_t *auts)
 {
   bool ret = false;
+  pthread_mutex_lock(&m_mutex);
   switch (m_auth_algo)
   {
   case HSS_ALGO_XOR:
@@ -533,6 +566,14 @@ hss::resync_sqn(uint64_t imsi, uint8_t *auts)
     break;
   }
   increment_ue_sqn(imsi);
+  // Pooled vectors were made with the old SQN
+  hss_ue_ctx_t *ue_ctx = NULL;
+  if(get_ue_ctx(imsi, &ue_ctx))
+  {
+    flush_auth_vectors(ue_ctx);
+    queue_av_refill(ue_ctx);
+  }
+  pthread_mutex_unlock(&m_mutex);
   return ret;
 }
 
@@ -603,8 +644,9 @@ hss::resync_sqn_milenage(uint64_t imsi, uint8_t *auts)
   return true;
 }
 
+// Steps the SQN n times and writes it through to the store
 void
-hss::increment_ue_sqn(uint64_t imsi)
+hss::increment_ue_sqn(uint64_t imsi, uint32_t n)
 {
   hss_ue_ctx_t *ue_ctx = NULL;
   bool ret = get_ue_ctx(imsi, &ue_ctx);
@@ -613,9 +655,13 @@ hss::increment_ue_sqn(uint64_t imsi)
     return;
   }
 
-  increment_sqn(ue_ctx->sqn,ue_ctx->sqn);
+  for(uint32_t i = 0; i < n; i++)
+  {
+    increment_sqn(ue_ctx->rec->sqn,ue_ctx->rec->sqn);
+  }
+  m_db.sync(ue_ctx->rec);
   m_hss_log->debug("Incremented SQN (IMSI: %" PRIu64 ")" PRIu64 "\n", imsi);
-  m_hss_log->debug_hex(ue_ctx->sqn, 6, "SQN: ");
+  m_hss_log->debug_hex(ue_ctx->rec->sqn, 6, "SQN: ");
 }
 
 void
@@ -645,19 +691,21 @@ hss::set_sqn(uint64_t imsi, uint8_t *sqn)
   {
     return;
   }
-  memcpy(ue_ctx->sqn, sqn, 6);
+  memcpy(ue_ctx->rec->sqn, sqn, 6);
+  m_db.sync(ue_ctx->rec);
 }
 
 void
 hss::set_last_rand(uint64_t imsi, uint8_t *rand)
 {
   hss_ue_ctx_t *ue_ctx = NULL;
+  pthread_mutex_lock(&m_mutex);
   bool ret = get_ue_ctx(imsi, &ue_ctx);
-  if(ret == false)
+  if(ret == true)
   {
-    return;
+    memcpy(ue_ctx->rec->last_rand, rand, 16);
   }
-  memcpy(ue_ctx->last_rand, rand, 16);
+  pthread_mutex_unlock(&m_mutex);
 
 }
 
@@ -670,7 +718,7 @@ hss::get_last_rand(uint64_t imsi, uint8_t *rand)
   {
     return;
   }
-  memcpy(rand, ue_ctx->last_rand, 16);
+  memcpy(rand, ue_ctx->rec->last_rand, 16);
 }
 
 void
@@ -683,57 +731,39 @@ hss::gen_rand(uint8_t rand_[16])
   return;
 }
 
+/* Contexts are made the first time a subscriber is used, so startup does
+ * not depend on the size of the store. Called with m_mutex held when
+ * other threads may be running.
+ */
 bool hss::get_ue_ctx(uint64_t imsi, hss_ue_ctx_t **ue_ctx)
 {
   std::map<uint64_t,hss_ue_ctx_t*>::iterator ue_ctx_it = m_imsi_to_ue_ctx.find(imsi);
-  if(ue_ctx_it == m_imsi_to_ue_ctx.end())
+  if(ue_ctx_it != m_imsi_to_ue_ctx.end())
   {
-    m_hss_log->info("User not found. IMSI: %015lu\n",imsi);
-    return false;
+    *ue_ctx = ue_ctx_it->second;
+    return true;
   }
 
-  *ue_ctx = ue_ctx_it->second;
-  return true;
-}
-
-/* Helper functions*/
-std::vector<std::string>
-hss::split_string(const std::string &str, char delimiter)
-{
-  std::vector<std::string> tokens;
-  std::string token;
-  std::istringstream tokenStream(str);
-
-  while (std::getline(tokenStream, token, delimiter))
+  hss_db_record_t *rec = m_db.find(imsi);
+  if(rec == NULL)
   {
-    tokens.push_back(token); 
-  }
-  return tokens;
-}
-
-void
-hss::get_uint_vec_from_hex_str(const std::string &key_str, uint8_t *key, uint len)
-{
-  const char *pos =  key_str.c_str();
-
-  for (uint count = 0; count < len; count++) {
-    sscanf(pos, "%2hhx", &key[count]);
-    pos += 2;
-  }
-
-  return;
-}
-
-
-std::string 
-hss::hex_string(uint8_t *hex, int size)
-{
-  std::stringstream ss;
-
-  ss << std::hex << std::setfill('0');
-  for(int i=0;i<size;i++) {
-    ss << std::setw(2) << static_cast<unsigned>(hex[i]);
+    m_hss_log->info("User not found. IMSI: %015lu\n",imsi);
+    return false;
   }
-  return ss.str();
+  hss_ue_ctx_t *ctx = new hss_ue_ctx_t;
+  ctx->rec = rec;
+  security_milenage_init(rec->key, rec->opc, &ctx->milenage);
+  ctx->av_epoch = 0;
+  ctx->av_queued = false;
+  m_imsi_to_ue_ctx.insert(std::pair<uint64_t,hss_ue_ctx_t*>(imsi,ctx));
+
+  m_hss_log->debug("Loaded user from store, IMSI: %015lu\n", imsi);
+  m_hss_log->debug_hex(rec->key, 16, "User Key : ");
+  m_hss_log->debug_hex(rec->opc, 16, "User OPc : ");
+  m_hss_log->debug_hex(rec->amf, 2, "AMF : ");
+  m_hss_log->debug_hex(rec->sqn, 6, "SQN : ");
+  m_hss_log->debug("Default Bearer QCI: %d\n",rec->qci);
+  *ue_ctx = ctx;
+  return true;
 }
 } //namespace srsepc
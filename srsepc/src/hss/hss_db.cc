@@ -0,0 +1,433 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include "srsepc/hdr/hss/hss_db.h"
+#include "srslte/common/security.h"
+
+namespace srsepc{
+
+hss_db::hss_db():
+  m_fd(-1),
+  m_base(NULL),
+  m_len(0),
+  m_header(NULL),
+  m_index(NULL),
+  m_records(NULL)
+{
+  m_page_size = sysconf(_SC_PAGESIZE);
+}
+
+hss_db::~hss_db()
+{
+  close();
+}
+
+bool
+hss_db::create(const std::string &path, uint32_t max_records)
+{
+  close();
+
+  // Index at most half full, so probe sequences stay short
+  uint32_t index_size = 16;
+  while(index_size < 2 * max_records)
+  {
+    index_size <<= 1;
+  }
+
+  hss_db_header_t header;
+  bzero(&header, sizeof(header));
+  memcpy(header.magic, HSS_DB_MAGIC, sizeof(header.magic));
+  header.version        = HSS_DB_VERSION;
+  header.record_size    = sizeof(hss_db_record_t);
+  header.nof_records    = 0;
+  header.max_records    = max_records;
+  header.index_size     = index_size;
+  header.index_offset   = m_page_size;
+  header.records_offset = m_page_size + (index_size * sizeof(uint32_t) + m_page_size - 1) / m_page_size * m_page_size;
+  size_t len = header.records_offset + (size_t) max_records * sizeof(hss_db_record_t);
+
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if(fd < 0)
+  {
+    return false;
+  }
+  // The file is sparse: index and records read as zeros until written
+  if(ftruncate(fd, len) < 0 || pwrite(fd, &header, sizeof(header), 0) != sizeof(header))
+  {
+    ::close(fd);
+    return false;
+  }
+  return map_file(fd, len);
+}
+
+bool
+hss_db::open(const std::string &path)
+{
+  close();
+
+  int fd = ::open(path.c_str(), O_RDWR);
+  if(fd < 0)
+  {
+    return false;
+  }
+  hss_db_header_t header;
+  struct stat st;
+  if(pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+     fstat(fd, &st) < 0 ||
+     !valid_header(header, st.st_size, m_page_size))
+  {
+    ::close(fd);
+    return false;
+  }
+  return map_file(fd, st.st_size);
+}
+
+/* Everything find() and add() trust: a power of two index with a free
+ * slot left, so probing ends, and index and records inside the file.
+ * Records start on a page boundary, as create() lays them out.
+ */
+bool
+hss_db::valid_header(const hss_db_header_t &header, uint64_t file_size, long page_size)
+{
+  uint64_t index_end   = header.index_offset + (uint64_t) header.index_size * sizeof(uint32_t);
+  uint64_t records_end = header.records_offset + (uint64_t) header.max_records * sizeof(hss_db_record_t);
+
+  return !memcmp(header.magic, HSS_DB_MAGIC, sizeof(header.magic)) &&
+         header.version == HSS_DB_VERSION &&
+         header.record_size == sizeof(hss_db_record_t) &&
+         header.index_size != 0 &&
+         (header.index_size & (header.index_size - 1)) == 0 &&
+         header.index_size > header.max_records &&
+         header.nof_records <= header.max_records &&
+         header.index_offset >= sizeof(hss_db_header_t) &&
+         header.index_offset % sizeof(uint32_t) == 0 &&
+         header.records_offset >= index_end &&
+         header.records_offset % page_size == 0 &&
+         records_end <= file_size;
+}
+
+bool
+hss_db::map_file(int fd, size_t len)
+{
+  void *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(base == MAP_FAILED)
+  {
+    ::close(fd);
+    return false;
+  }
+  m_fd      = fd;
+  m_base    = (uint8_t*) base;
+  m_len     = len;
+  m_header  = (hss_db_header_t*) m_base;
+  m_index   = (uint32_t*) (m_base + m_header->index_offset);
+  m_records = (hss_db_record_t*) (m_base + m_header->records_offset);
+  return true;
+}
+
+void
+hss_db::close()
+{
+  if(m_base != NULL)
+  {
+    msync(m_base, m_len, MS_SYNC);
+    munmap(m_base, m_len);
+    ::close(m_fd);
+  }
+  m_fd      = -1;
+  m_base    = NULL;
+  m_len     = 0;
+  m_header  = NULL;
+  m_index   = NULL;
+  m_records = NULL;
+}
+
+uint32_t
+hss_db::home_slot(uint64_t imsi) const
+{
+  return (uint32_t) ((imsi * 0x9E3779B97F4A7C15ULL) >> 32) & (m_header->index_size - 1);
+}
+
+hss_db_record_t*
+hss_db::find(uint64_t imsi)
+{
+  if(m_header == NULL)
+  {
+    return NULL;
+  }
+  uint32_t mask = m_header->index_size - 1;
+  for(uint32_t i = home_slot(imsi); m_index[i] != 0; i = (i + 1) & mask)
+  {
+    if(m_index[i] > m_header->nof_records)
+    {
+      return NULL;    // corrupt slot, it would point outside the records
+    }
+    hss_db_record_t *record = &m_records[m_index[i] - 1];
+    if(record->imsi == imsi)
+    {
+      return record;
+    }
+  }
+  return NULL;
+}
+
+bool
+hss_db::add(const hss_db_record_t &record)
+{
+  if(m_header == NULL || m_header->nof_records == m_header->max_records || find(record.imsi) != NULL)
+  {
+    return false;
+  }
+  uint32_t n = m_header->nof_records;
+  m_records[n] = record;
+
+  uint32_t mask = m_header->index_size - 1;
+  uint32_t i = home_slot(record.imsi);
+  while(m_index[i] != 0)
+  {
+    i = (i + 1) & mask;
+  }
+  m_index[i] = n + 1;
+  m_header->nof_records = n + 1;
+  return true;
+}
+
+bool
+hss_db::sync(const hss_db_record_t *record)
+{
+  // msync wants a page-aligned start; a record never crosses a page
+  uintptr_t page = (uintptr_t) record & ~((uintptr_t) m_page_size - 1);
+  return msync((void*) page, m_page_size, MS_SYNC) == 0;
+}
+
+/* CSV helpers */
+static std::vector<std::string>
+split_string(const std::string &str, char delimiter)
+{
+  std::vector<std::string> tokens;
+  std::string token;
+  std::istringstream tokenStream(str);
+
+  while (std::getline(tokenStream, token, delimiter))
+  {
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+static void
+get_uint_vec_from_hex_str(const std::string &key_str, uint8_t *key, uint len)
+{
+  const char *pos =  key_str.c_str();
+
+  for (uint count = 0; count < len; count++) {
+    sscanf(pos, "%2hhx", &key[count]);
+    pos += 2;
+  }
+}
+
+static std::string
+hex_string(const uint8_t *hex, int size)
+{
+  std::stringstream ss;
+
+  ss << std::hex << std::setfill('0');
+  for(int i=0;i<size;i++) {
+    ss << std::setw(2) << static_cast<unsigned>(hex[i]);
+  }
+  return ss.str();
+}
+
+bool
+hss_db::import_csv(const std::string &csv_path, const std::string &path, srslte::log *log)
+{
+  std::ifstream csv_file;
+  csv_file.open(csv_path.c_str(), std::ifstream::in);
+  if(!csv_file.is_open())
+  {
+    log->error("Could not open user database %s\n", csv_path.c_str());
+    return false;
+  }
+
+  std::vector<hss_db_record_t> records;
+  std::string line;
+  while (std::getline(csv_file, line))
+  {
+    if(line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+    uint column_size = 8;
+    std::vector<std::string> split = split_string(line,',');
+    if(split.size() != column_size)
+    {
+      log->error("Error parsing UE database. Wrong number of columns in .csv\n");
+      log->error("Columns: %lu, Expected %d.\n",split.size(),column_size);
+      return false;
+    }
+    hss_db_record_t record;
+    bzero(&record, sizeof(record));
+    strncpy(record.name, split[0].c_str(), HSS_DB_NAME_LEN - 1);
+    record.imsi = atoll(split[1].c_str());
+    get_uint_vec_from_hex_str(split[2],record.key,16);
+    if(split[3] == std::string("op"))
+    {
+      record.op_configured = true;
+      get_uint_vec_from_hex_str(split[4],record.op,16);
+      srslte::compute_opc(record.key,record.op,record.opc);
+    }
+    else if (split[3] == std::string("opc"))
+    {
+      record.op_configured = false;
+      get_uint_vec_from_hex_str(split[4],record.opc,16);
+    }
+    else
+    {
+      log->error("Neither OP nor OPc configured.\n");
+      return false;
+    }
+    get_uint_vec_from_hex_str(split[5],record.amf,2);
+    get_uint_vec_from_hex_str(split[6],record.sqn,6);
+    record.qci = atoi(split[7].c_str());
+    records.push_back(record);
+  }
+
+  /* UEs may have seen SQNs past the ones in the .csv, which is only
+   * written on export. Rewinding them would fail every authentication
+   * until resync, so the higher of the two is kept.
+   */
+  hss_db stored;
+  if(stored.open(path))
+  {
+    for(uint32_t i = 0; i < records.size(); i++)
+    {
+      hss_db_record_t *old_record = stored.find(records[i].imsi);
+      // SQNs are big endian, so bytewise order is numeric order
+      if(old_record != NULL && memcmp(old_record->sqn, records[i].sqn, 6) > 0)
+      {
+        memcpy(records[i].sqn, old_record->sqn, 6);
+        log->info("Keeping stored SQN of IMSI %015lu, ahead of %s\n", records[i].imsi, csv_path.c_str());
+      }
+    }
+    stored.close();
+  }
+
+  // Built aside and renamed over path, so a failed import leaves the old store
+  std::string tmp_path = path + ".tmp";
+  if(!create(tmp_path, records.size()))
+  {
+    log->error("Could not create subscriber store %s\n", tmp_path.c_str());
+    return false;
+  }
+  for(uint32_t i = 0; i < records.size(); i++)
+  {
+    if(!add(records[i]))
+    {
+      log->error("Duplicated IMSI in user database: %015lu\n", records[i].imsi);
+      close();
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    log->debug("Added user from DB, IMSI: %015lu\n", records[i].imsi);
+  }
+  msync(m_base, m_len, MS_SYNC);
+  if(rename(tmp_path.c_str(), path.c_str()) < 0)
+  {
+    log->error("Could not replace subscriber store %s\n", path.c_str());
+    close();
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  log->info("Imported %d subscribers from %s into %s\n", size(), csv_path.c_str(), path.c_str());
+  return true;
+}
+
+bool
+hss_db::export_csv(const std::string &csv_path)
+{
+  std::ofstream csv_file;
+  csv_file.open(csv_path.c_str(), std::ofstream::out);
+  if(!csv_file.is_open() || !is_open())
+  {
+    return false;
+  }
+
+  //Write comment info
+  csv_file << "#                                                                            " << std::endl
+           << "# .csv to store UE's information in HSS                                      " << std::endl
+           << "# Kept in the following format: \"Name,IMSI,Key,OP_Type,OP,AMF,SQN,QCI\"     " << std::endl
+           << "#                                                                            " << std::endl
+           << "# Name:    Human readable name to help distinguish UE's. Ignored by the HSS  " << std::endl
+           << "# IMSI:    UE's IMSI value                                                   " << std::endl
+           << "# Key:     UE's key, where other keys are derived from. Stored in hexadecimal" << std::endl
+           << "# OP_Type: Operator's code type, either OP or OPc                            " << std::endl
+           << "# OP/OPc:  Operator Code/Cyphered Operator Code, stored in hexadecimal       " << std::endl
+           << "# AMF:     Authentication management field, stored in hexadecimal            " << std::endl
+           << "# SQN:     UE's Sequence number for freshness of the authentication          " << std::endl
+           << "# QCI:     QoS Class Identifier for the UE's default bearer.                 " << std::endl
+           << "#                                                                            " << std::endl
+           << "# Note: Lines starting by '#' are ignored and will be overwritten            " << std::endl;
+
+  for(uint32_t i = 0; i < size(); i++)
+  {
+    const hss_db_record_t *record = &m_records[i];
+    csv_file << std::string(record->name, strnlen(record->name, HSS_DB_NAME_LEN));
+    csv_file << ",";
+    csv_file << std::setfill('0') << std::setw(15) << record->imsi;
+    csv_file << ",";
+    csv_file << hex_string(record->key, 16);
+    csv_file << ",";
+    if(record->op_configured){
+      csv_file << "op,";
+      csv_file << hex_string(record->op, 16);
+    }
+    else{
+      csv_file << "opc,";
+      csv_file << hex_string(record->opc, 16);
+    }
+    csv_file << ",";
+    csv_file << hex_string(record->amf, 2);
+    csv_file << ",";
+    csv_file << hex_string(record->sqn, 6);
+    csv_file << ",";
+    csv_file << std::dec << record->qci;
+    csv_file << std::endl;
+  }
+  csv_file.close();
+  return true;
+}
+
+} //namespace srsepc
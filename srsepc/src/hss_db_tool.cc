@@ -0,0 +1,92 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        hss_db_tool.cc
+ * Description: Converts between the HSS subscriber store and the .csv
+ *              user database.
+ *****************************************************************************/
+
+#include <iostream>
+#include <string.h>
+#include "srslte/common/logger_stdout.h"
+#include "srslte/common/log_filter.h"
+#include "srsepc/hdr/hss/hss_db.h"
+
+using namespace std;
+using namespace srsepc;
+
+static void
+usage(const char *prog)
+{
+  cout << "Usage: " << prog << " import <user_db.csv> <store>" << endl
+       << "       " << prog << " export <store> <user_db.csv>" << endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc != 4)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  srslte::logger_stdout logger;
+  srslte::log_filter    log;
+  log.init("HSS ", &logger);
+  log.set_level(srslte::LOG_LEVEL_INFO);
+
+  hss_db db;
+  if(!strcmp(argv[1], "import"))
+  {
+    if(!db.import_csv(argv[2], argv[3], &log))
+    {
+      return 1;
+    }
+  }
+  else if(!strcmp(argv[1], "export"))
+  {
+    if(!db.open(argv[2]))
+    {
+      cout << "Error opening subscriber store " << argv[2] << endl;
+      return 1;
+    }
+    if(!db.export_csv(argv[3]))
+    {
+      cout << "Error writing " << argv[3] << endl;
+      return 1;
+    }
+    cout << "Exported " << db.size() << " subscribers to " << argv[3] << endl;
+  }
+  else
+  {
+    usage(argv[0]);
+    return 1;
+  }
+  db.close();
+  return 0;
+}
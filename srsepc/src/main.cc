@@ -109,10 +109,15 @@ parse_args(all_args_t *args, int argc, char* argv[]) {
     ("mme.mme_bind_addr",   bpo::value<string>(&mme_bind_addr)->default_value("127.0.0.1"),"IP address of MME for S1 connnection")
     ("mme.dns_addr",        bpo::value<string>(&dns_addr)->default_value("8.8.8.8"),"IP address of the DNS server for the UEs")
     ("mme.apn",             bpo::value<string>(&mme_apn)->default_value(""),                   "Set Access Point Name (APN) for data services")
-    ("hss.db_file",         bpo::value<string>(&hss_db_file)->default_value("ue_db.csv"),".csv file that stores UE's keys")
+    ("mme.nof_workers",     bpo::value<uint32_t>(&args->mme_args.nof_workers)->default_value(1),"Number of S1AP worker threads")
+    ("hss.db_file",         bpo::value<string>(&hss_db_file)->default_value("ue_db.csv"),"Subscriber store, or .csv file that stores UE's keys")
     ("hss.auth_algo",       bpo::value<string>(&hss_auth_algo)->default_value("milenage"),"HSS uthentication algorithm.")
+    ("hss.av_pool_size",    bpo::value<uint32_t>(&args->hss_args.av_pool_size)->default_value(8),"Authentication vectors pre-generated per UE")
     ("spgw.gtpu_bind_addr", bpo::value<string>(&spgw_bind_addr)->default_value("127.0.0.1"),"IP address of SP-GW for the S1-U connection")
     ("spgw.sgi_if_addr",    bpo::value<string>(&sgi_if_addr)->default_value("176.16.0.1"),"IP address of TUN interface for the SGi connection")
+    ("spgw.nof_workers",    bpo::value<uint32_t>(&args->spgw_args.nof_workers)->default_value(1),"Number of user-plane worker threads")
+    ("spgw.s1u_backend",    bpo::value<string>(&args->spgw_args.s1u_backend)->default_value("socket"),"S1-U I/O backend: socket or packet_mmap")
+    ("spgw.s1u_if",         bpo::value<string>(&args->spgw_args.s1u_if)->default_value(""),"Interface holding gtpu_bind_addr, for the packet_mmap backend")
 
     ("log.s1ap_level",     bpo::value<string>(&args->log_args.s1ap_level),   "MME S1AP log level")
     ("log.s1ap_hex_limit", bpo::value<int>(&args->log_args.s1ap_hex_limit),  "MME S1AP log hex dump limit")
@@ -25,9 +25,13 @@
  */
 
 #include <iostream> //TODO Remove
+#include <algorithm>
+#include <inttypes.h> // for printing uint64_t
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <netinet/sctp.h>
 #include "srsepc/hdr/mme/mme.h"
 
@@ -37,7 +41,12 @@ mme*          mme::m_instance = NULL;
 pthread_mutex_t mme_instance_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 mme::mme():
-  m_running(false)
+  m_running(false),
+  m_epoll(-1),
+  m_stop_fd(-1),
+  m_nof_workers(1),
+  m_pending(0),
+  m_route_arena(4096)
 {
   m_pool = srslte::byte_buffer_pool::get_instance();     
   return;
@@ -92,8 +101,40 @@ mme::init(mme_args_t* args, srslte::log_filter *s1ap_log, srslte::log_filter *mm
     exit(-1);
   }
 
+  /*Init S1-MME event loop and workers*/
+  m_nof_workers = std::max(1u, std::min(args->nof_workers, (uint32_t) MME_MAX_WORKERS));
+  int s1mme = m_s1ap->get_s1_mme();
+  m_stop_fd = eventfd(0, 0);
+  m_epoll = epoll_create1(0);
+  if(s1mme < 0 || m_stop_fd < 0 || m_epoll < 0)
+  {
+    m_s1ap_log->console("Error initializing S1-MME event loop\n");
+    exit(-1);
+  }
+  int fds[2] = {m_stop_fd, s1mme};
+  for(uint32_t i = 0; i < 2; i++)
+  {
+    struct epoll_event ev;
+    bzero(&ev, sizeof(ev));
+    ev.events  = EPOLLIN;
+    ev.data.fd = fds[i];
+    if(epoll_ctl(m_epoll, EPOLL_CTL_ADD, fds[i], &ev))
+    {
+      m_s1ap_log->console("Error initializing S1-MME event loop: %s\n", strerror(errno));
+      exit(-1);
+    }
+  }
+  for(uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    if(m_workers[i].init(i, m_s1ap, &m_pending, m_s1ap_log) != srslte::ERROR_NONE)
+    {
+      m_s1ap_log->console("Error initializing MME worker %d\n", i);
+      exit(-1);
+    }
+  }
+
   /*Log successful initialization*/
-  m_s1ap_log->info("MME Initialized. MCC: %d, MNC: %d\n",args->s1ap_args.mcc, args->s1ap_args.mnc);
+  m_s1ap_log->info("MME Initialized. MCC: %d, MNC: %d, %d S1AP worker(s)\n",args->s1ap_args.mcc, args->s1ap_args.mnc, m_nof_workers);
   m_s1ap_log->console("MME Initialized. \n");
   return 0;
 }
@@ -103,11 +144,26 @@ mme::stop()
 {
   if(m_running)
   {
-    m_s1ap->stop();
-    m_s1ap->cleanup();
     m_running = false;
-    thread_cancel();
+    uint64_t one = 1;
+    if(write(m_stop_fd, &one, sizeof(one)) < 0)
+    {
+      m_s1ap_log->error("Failed to wake up MME thread: %s\n", strerror(errno));
+    }
     wait_thread_finish();
+    print_latency();
+    m_s1ap->stop();
+    m_s1ap->cleanup();
+  }
+  if(m_epoll >= 0)
+  {
+    close(m_epoll);
+    m_epoll = -1;
+  }
+  if(m_stop_fd >= 0)
+  {
+    close(m_stop_fd);
+    m_stop_fd = -1;
   }
   return;
 }
@@ -115,55 +171,235 @@ mme::stop()
 void
 mme::run_thread()
 {
-  srslte::byte_buffer_t *pdu = m_pool->allocate("mme::run_thread");
-  uint32_t sz = SRSLTE_MAX_BUFFER_SIZE_BYTES - SRSLTE_BUFFER_HEADER_OFFSET;
-
-  struct sockaddr_in enb_addr;
-  struct sctp_sndrcvinfo sri;
-  socklen_t fromlen = sizeof(enb_addr);
-  bzero(&enb_addr, sizeof(enb_addr));
-  int rd_sz;
-  int msg_flags=0;
+  struct epoll_event events[2];
 
   //Mark the thread as running
   m_running=true;
+  for(uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    m_workers[i].start();
+  }
 
-  //Get S1-MME socket
-  int s1mme = m_s1ap->get_s1_mme();
   while(m_running)
   {
     m_s1ap_log->debug("Waiting for SCTP Msg\n");
-    pdu->reset();
-    rd_sz = sctp_recvmsg(s1mme, pdu->msg, sz,(struct sockaddr*) &enb_addr, &fromlen, &sri, &msg_flags);
-    if (rd_sz == -1 && errno != EAGAIN){
-      m_s1ap_log->error("Error reading from SCTP socket: %s", strerror(errno));
+    int n = epoll_wait(m_epoll, events, 2, -1);
+    if(n < 0)
+    {
+      if(errno != EINTR)
+      {
+        m_s1ap_log->error("Error waiting for S1-MME events: %s\n", strerror(errno));
+        break;
+      }
+      continue;
+    }
+    for(int i = 0; i < n && m_running; i++)
+    {
+      if(events[i].data.fd != m_stop_fd)
+      {
+        handle_s1mme();
+      }
+    }
+  }
+
+  for(uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    m_workers[i].stop();
+  }
+  return;
+}
+
+/* sctp_recvmsg() with MSG_DONTWAIT. The S1-MME socket stays blocking: the
+ * workers send their replies on it and must wait for room, not drop them.
+ */
+static int
+sctp_recvmsg_nowait(int sd, void *msg, size_t len, struct sockaddr *from, socklen_t *fromlen,
+                    struct sctp_sndrcvinfo *sinfo, int *msg_flags)
+{
+  char cbuf[CMSG_SPACE(sizeof(struct sctp_sndrcvinfo))];
+  struct iovec iov;
+  struct msghdr inmsg;
+
+  iov.iov_base = msg;
+  iov.iov_len  = len;
+  bzero(&inmsg, sizeof(inmsg));
+  inmsg.msg_name       = from;
+  inmsg.msg_namelen    = *fromlen;
+  inmsg.msg_iov        = &iov;
+  inmsg.msg_iovlen     = 1;
+  inmsg.msg_control    = cbuf;
+  inmsg.msg_controllen = sizeof(cbuf);
+
+  int n = recvmsg(sd, &inmsg, MSG_DONTWAIT);
+  if(n < 0)
+  {
+    return n;
+  }
+  *fromlen   = inmsg.msg_namelen;
+  *msg_flags = inmsg.msg_flags;
+  for(struct cmsghdr *c = CMSG_FIRSTHDR(&inmsg); c != NULL; c = CMSG_NXTHDR(&inmsg, c))
+  {
+    if(c->cmsg_level == IPPROTO_SCTP && c->cmsg_type == SCTP_SNDRCV)
+    {
+      memcpy(sinfo, CMSG_DATA(c), sizeof(struct sctp_sndrcvinfo));
+    }
+  }
+  return n;
+}
+
+// Drains the S1-MME socket, up to one batch, and hands the PDUs to the workers
+void
+mme::handle_s1mme()
+{
+  uint32_t sz = SRSLTE_MAX_BUFFER_SIZE_BYTES - SRSLTE_BUFFER_HEADER_OFFSET;
+  int s1mme = m_s1ap->get_s1_mme();
+  struct sockaddr_in enb_addr;
+
+  for(uint32_t i = 0; i < MME_BATCH_LEN; i++)
+  {
+    srslte::byte_buffer_t *pdu = m_pool->allocate("mme::handle_s1mme");
+    if(pdu == NULL)
+    {
+      //The socket is still readable, give the workers time to free buffers
+      //instead of spinning on epoll
+      m_s1ap_log->error("Could not allocate buffer for S1AP message\n");
+      usleep(MME_POOL_BACKOFF_US);
+      return;
+    }
+    mme_rx_msg_t msg;
+    socklen_t fromlen = sizeof(enb_addr);
+    int msg_flags = 0;
+    bzero(&msg.sri, sizeof(msg.sri));
+    int rd_sz = sctp_recvmsg_nowait(s1mme, pdu->msg, sz, (struct sockaddr*) &enb_addr, &fromlen, &msg.sri, &msg_flags);
+    if(rd_sz == -1)
+    {
+      if(errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        m_s1ap_log->error("Error reading from SCTP socket: %s", strerror(errno));
+      }
+      m_pool->deallocate(pdu);
+      return;
     }
-    else if (rd_sz == -1 && errno == EAGAIN){
-      m_s1ap_log->debug("Socket timeout reached");
+    if(msg_flags & MSG_NOTIFICATION)
+    {
+      //Received notification
+      union sctp_notification *notification = (union sctp_notification*)pdu->msg;
+      m_s1ap_log->debug("SCTP Notification %d\n", notification->sn_header.sn_type);
+      if (notification->sn_header.sn_type == SCTP_SHUTDOWN_EVENT)
+      {
+        m_s1ap_log->info("SCTP Association Shutdown. Association: %d\n",msg.sri.sinfo_assoc_id);
+        m_s1ap_log->console("SCTP Association Shutdown. Association: %d\n",msg.sri.sinfo_assoc_id);
+        //The eNB's UEs may be spread over all workers: let them finish first
+        wait_workers_idle();
+        m_s1ap->lock();
+        m_s1ap->delete_enb_ctx(msg.sri.sinfo_assoc_id);
+        m_s1ap->unlock();
+      }
+      m_pool->deallocate(pdu);
+      continue;
+    }
+
+    //Received data
+    pdu->N_bytes = rd_sz;
+    m_s1ap_log->info("Received S1AP msg. Size: %d\n", pdu->N_bytes);
+    clock_gettime(CLOCK_MONOTONIC, &msg.rx_time);
+    msg.pdu = pdu;
+    __atomic_add_fetch(&m_pending, 1, __ATOMIC_RELAXED);
+    m_workers[select_worker(pdu, &msg.sri)].push(msg);
+  }
+}
+
+/* Routes by MME-UE-S1AP-ID so a UE's procedures stay in order. A UE's first
+ * message (Initial UE Message) only has the eNB-UE-S1AP-ID; everything it
+ * causes is sent after the reply, so it does not need the UE's worker.
+ * Non-UE-associated messages stay on one worker per eNB.
+ */
+uint32_t
+mme::select_worker(const srslte::byte_buffer_t *pdu, const struct sctp_sndrcvinfo *sri)
+{
+  if(m_nof_workers == 1)
+  {
+    return 0;
+  }
+  //Only the id IEs are decoded
+  const LIBLTE_S1AP_MME_UE_S1AP_ID_STRUCT *mme_id = NULL;
+  const LIBLTE_S1AP_ENB_UE_S1AP_ID_STRUCT *enb_id = NULL;
+  srslte::s1ap_lazy_pdu lazy_pdu;
+  m_route_arena.reset();
+  if(lazy_pdu.parse(pdu->msg, pdu->N_bytes, &m_route_arena) == LIBLTE_SUCCESS)
+  {
+    mme_id = lazy_pdu.get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id);
+    if(mme_id == NULL)
+    {
+      enb_id = lazy_pdu.get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id);
     }
-    else{
-      if(msg_flags & MSG_NOTIFICATION)
+  }
+  uint32_t key;
+  if(mme_id != NULL)
+  {
+    key = mme_id->MME_UE_S1AP_ID;
+  }
+  else if(enb_id != NULL)
+  {
+    key = ((uint32_t) sri->sinfo_assoc_id * 0x9E3779B1u) ^ enb_id->ENB_UE_S1AP_ID;
+  }
+  else
+  {
+    key = sri->sinfo_assoc_id;
+  }
+  return ((uint64_t) (key * 0x9E3779B1u) * m_nof_workers) >> 32;
+}
+
+void
+mme::wait_workers_idle()
+{
+  while(__atomic_load_n(&m_pending, __ATOMIC_ACQUIRE) != 0)
+  {
+    usleep(100);
+  }
+}
+
+void
+mme::print_latency()
+{
+  static mme_proc_latency_t latency[LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS][MME_MAX_PROCS];
+  bzero(latency, sizeof(latency));
+  for(uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    m_workers[i].add_latency(latency);
+  }
+  for(uint32_t t = 0; t < LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS; t++)
+  {
+    for(uint32_t p = 0; p < MME_MAX_PROCS; p++)
+    {
+      mme_proc_latency_t *l = &latency[t][p];
+      if(l->count == 0)
+      {
+        continue;
+      }
+      const char *name = "";
+      switch(t)
       {
-        //Received notification
-        union sctp_notification *notification = (union sctp_notification*)pdu->msg;
-        m_s1ap_log->debug("SCTP Notification %d\n", notification->sn_header.sn_type);
-        if (notification->sn_header.sn_type == SCTP_SHUTDOWN_EVENT)
-        {
-          m_s1ap_log->info("SCTP Association Shutdown. Association: %d\n",sri.sinfo_assoc_id);
-          m_s1ap_log->console("SCTP Association Shutdown. Association: %d\n",sri.sinfo_assoc_id);
-          m_s1ap->delete_enb_ctx(sri.sinfo_assoc_id);
-        }
+      case LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE:
+        name = liblte_s1ap_initiatingmessage_choice_text[p];
+        break;
+      case LIBLTE_S1AP_S1AP_PDU_CHOICE_SUCCESSFULOUTCOME:
+        name = liblte_s1ap_successfuloutcome_choice_text[p];
+        break;
+      case LIBLTE_S1AP_S1AP_PDU_CHOICE_UNSUCCESSFULOUTCOME:
+        name = liblte_s1ap_unsuccessfuloutcome_choice_text[p];
+        break;
       }
-      else
-      { 
-        //Received data
-        pdu->N_bytes = rd_sz;
-        m_s1ap_log->info("Received S1AP msg. Size: %d\n", pdu->N_bytes);
-        m_s1ap->handle_s1ap_rx_pdu(pdu,&sri);
+      //99th percentile, to the histogram's power-of-two resolution
+      uint32_t below = 0, p99 = 0;
+      while(p99 < 31 && (below += l->hist[p99]) * 100 < l->count * 99)
+      {
+        p99++;
       }
+      m_s1ap_log->info("S1AP latency - %s: %d msgs, mean %" PRIu64 " us, p99 < %u us, max %" PRIu64 " us\n",
+                       name, l->count, l->total_us / l->count, 1u << p99, l->max_us);
     }
   }
-  return;
 }
 
 } //namespace srsepc
@@ -0,0 +1,205 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <time.h>
+#include <algorithm>
+#include "srsepc/hdr/mme/mme.h"
+
+namespace srsepc{
+
+mme_worker::mme_worker():
+  m_id(0),
+  m_s1ap(NULL),
+  m_pending(NULL),
+  m_rx_pdu(NULL),
+  m_pool(NULL),
+  m_s1ap_log(NULL)
+{
+  bzero(m_latency, sizeof(m_latency));
+}
+
+srslte::error_t
+mme_worker::init(uint32_t id, s1ap *s1ap_, uint32_t *pending, srslte::log_filter *s1ap_log)
+{
+  m_id        = id;
+  m_s1ap      = s1ap_;
+  m_pending   = pending;
+  m_s1ap_log  = s1ap_log;
+  m_pool      = srslte::byte_buffer_pool::get_instance();
+  m_rx_pdu    = new LIBLTE_S1AP_S1AP_PDU_STRUCT;
+  return srslte::ERROR_NONE;
+}
+
+void
+mme_worker::push(const mme_rx_msg_t &msg)
+{
+  m_queue.push(msg);
+}
+
+void
+mme_worker::stop()
+{
+  mme_rx_msg_t msg;
+  bzero(&msg, sizeof(msg));
+  m_queue.push(msg);
+  wait_thread_finish();
+  delete m_rx_pdu;
+  m_rx_pdu = NULL;
+}
+
+void
+mme_worker::run_thread()
+{
+  while(true)
+  {
+    mme_rx_msg_t msg = m_queue.wait_pop();
+    if(msg.pdu == NULL)
+    {
+      break;
+    }
+    handle_msg(&msg);
+    m_pool->deallocate(msg.pdu);
+    __atomic_sub_fetch(m_pending, 1, __ATOMIC_RELEASE);
+  }
+}
+
+/* Uplink NAS Transport carries most of the S1AP traffic of attached UEs.
+ * It only needs the two ids and the NAS octets, so it is handled from the
+ * lazily decoded PDU. Returns false if the message needs a full decode.
+ */
+bool
+mme_worker::handle_lazy(mme_rx_msg_t *msg)
+{
+  m_arena.reset();
+  if(m_lazy_pdu.parse(msg->pdu->msg, msg->pdu->N_bytes, &m_arena) != LIBLTE_SUCCESS ||
+     m_lazy_pdu.get_pdu_type() != LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE ||
+     m_lazy_pdu.get_procedure_code() != LIBLTE_S1AP_PROC_ID_UPLINKNASTRANSPORT)
+  {
+    return false;
+  }
+  const LIBLTE_S1AP_MME_UE_S1AP_ID_STRUCT *mme_id = m_lazy_pdu.get_ie(LIBLTE_S1AP_IE_ID_MME_UE_S1AP_ID, liblte_s1ap_unpack_mme_ue_s1ap_id);
+  const LIBLTE_S1AP_ENB_UE_S1AP_ID_STRUCT *enb_id = m_lazy_pdu.get_ie(LIBLTE_S1AP_IE_ID_ENB_UE_S1AP_ID, liblte_s1ap_unpack_enb_ue_s1ap_id);
+  const uint8_t *nas_pdu;
+  uint32_t nas_len;
+  if(mme_id == NULL || enb_id == NULL || !m_lazy_pdu.get_octet_string(LIBLTE_S1AP_IE_ID_NAS_PDU, &nas_pdu, &nas_len))
+  {
+    return false;
+  }
+
+  m_s1ap->lock();
+  m_s1ap->handle_uplink_nas_transport(enb_id->ENB_UE_S1AP_ID, mme_id->MME_UE_S1AP_ID, nas_pdu, nas_len, &msg->sri);
+  m_s1ap->unlock();
+
+  record_latency(LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE, LIBLTE_S1AP_INITIATINGMESSAGE_CHOICE_UPLINKNASTRANSPORT, &msg->rx_time);
+  return true;
+}
+
+void
+mme_worker::handle_msg(mme_rx_msg_t *msg)
+{
+  if(handle_lazy(msg))
+  {
+    return;
+  }
+
+  //Decoding needs no shared state, so workers do it in parallel
+  if(liblte_s1ap_unpack_s1ap_pdu((LIBLTE_BYTE_MSG_STRUCT*)msg->pdu, m_rx_pdu) != LIBLTE_SUCCESS)
+  {
+    m_s1ap_log->error("Failed to unpack received PDU\n");
+    return;
+  }
+
+  m_s1ap->lock();
+  m_s1ap->handle_s1ap_rx_pdu(m_rx_pdu, &msg->sri);
+  m_s1ap->unlock();
+
+  uint32_t proc = 0;
+  switch(m_rx_pdu->choice_type)
+  {
+  case LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE:
+    proc = m_rx_pdu->choice.initiatingMessage.choice_type;
+    break;
+  case LIBLTE_S1AP_S1AP_PDU_CHOICE_SUCCESSFULOUTCOME:
+    proc = m_rx_pdu->choice.successfulOutcome.choice_type;
+    break;
+  case LIBLTE_S1AP_S1AP_PDU_CHOICE_UNSUCCESSFULOUTCOME:
+    proc = m_rx_pdu->choice.unsuccessfulOutcome.choice_type;
+    break;
+  default:
+    return;
+  }
+  record_latency(m_rx_pdu->choice_type, proc, &msg->rx_time);
+}
+
+void
+mme_worker::record_latency(uint32_t pdu_type, uint32_t proc, const struct timespec *rx_time)
+{
+  if(proc >= MME_MAX_PROCS)
+  {
+    return;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t us = (now.tv_sec - rx_time->tv_sec) * 1000000 + (now.tv_nsec - rx_time->tv_nsec) / 1000;
+  if(us < 0)
+  {
+    us = 0;
+  }
+
+  uint32_t bucket = 0;
+  while(bucket < 31 && (uint64_t) us >> bucket)
+  {
+    bucket++;
+  }
+  mme_proc_latency_t *l = &m_latency[pdu_type][proc];
+  l->count++;
+  l->total_us += us;
+  l->max_us = std::max(l->max_us, (uint64_t) us);
+  l->hist[bucket]++;
+}
+
+// Adds this worker's latency counters to the given ones. Only valid once the worker has stopped
+void
+mme_worker::add_latency(mme_proc_latency_t latency[LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS][MME_MAX_PROCS])
+{
+  for(uint32_t t = 0; t < LIBLTE_S1AP_S1AP_PDU_CHOICE_N_ITEMS; t++)
+  {
+    for(uint32_t p = 0; p < MME_MAX_PROCS; p++)
+    {
+      mme_proc_latency_t *dst = &latency[t][p];
+      const mme_proc_latency_t *src = &m_latency[t][p];
+      dst->count    += src->count;
+      dst->total_us += src->total_us;
+      dst->max_us    = std::max(dst->max_us, src->max_us);
+      for(uint32_t i = 0; i < 32; i++)
+      {
+        dst->hist[i] += src->hist[i];
+      }
+    }
+  }
+}
+
+} //namespace srsepc
@@ -43,10 +43,12 @@ s1ap::s1ap():
   m_mme_gtpc(NULL),
   m_pool(NULL)
 {
+  pthread_mutex_init(&m_mutex, NULL);
 }
 
 s1ap::~s1ap()
 {
+  pthread_mutex_destroy(&m_mutex);
 }
 
 s1ap*
@@ -198,31 +200,37 @@ s1ap::enb_listen()
 }
 
 
-bool
-s1ap::handle_s1ap_rx_pdu(srslte::byte_buffer_t *pdu, struct sctp_sndrcvinfo *enb_sri) 
+void
+s1ap::lock()
 {
-  LIBLTE_S1AP_S1AP_PDU_STRUCT rx_pdu;
+  pthread_mutex_lock(&m_mutex);
+}
 
-  if(liblte_s1ap_unpack_s1ap_pdu((LIBLTE_BYTE_MSG_STRUCT*)pdu, &rx_pdu) != LIBLTE_SUCCESS) {
-    m_s1ap_log->error("Failed to unpack received PDU\n");
-    return false;
-  }
+void
+s1ap::unlock()
+{
+  pthread_mutex_unlock(&m_mutex);
+}
 
-  switch(rx_pdu.choice_type) {
+//Called by the MME workers with the S1AP lock held
+bool
+s1ap::handle_s1ap_rx_pdu(LIBLTE_S1AP_S1AP_PDU_STRUCT *rx_pdu, struct sctp_sndrcvinfo *enb_sri)
+{
+  switch(rx_pdu->choice_type) {
   case LIBLTE_S1AP_S1AP_PDU_CHOICE_INITIATINGMESSAGE:
     m_s1ap_log->info("Received initiating PDU\n");
-    return handle_initiating_message(&rx_pdu.choice.initiatingMessage, enb_sri);
+    return handle_initiating_message(&rx_pdu->choice.initiatingMessage, enb_sri);
     break;
   case LIBLTE_S1AP_S1AP_PDU_CHOICE_SUCCESSFULOUTCOME:
     m_s1ap_log->info("Received Succeseful Outcome PDU\n");
-    return handle_successful_outcome(&rx_pdu.choice.successfulOutcome);
+    return handle_successful_outcome(&rx_pdu->choice.successfulOutcome);
     break;
   case LIBLTE_S1AP_S1AP_PDU_CHOICE_UNSUCCESSFULOUTCOME:
     m_s1ap_log->info("Received Unsucceseful Outcome PDU\n");
     return true;//TODO handle_unsuccessfuloutcome(&rx_pdu.choice.unsuccessfulOutcome);
     break;
   default:
-    m_s1ap_log->error("Unhandled PDU type %d\n", rx_pdu.choice_type);
+    m_s1ap_log->error("Unhandled PDU type %d\n", rx_pdu->choice_type);
     return false;
   }
 
@@ -230,6 +238,32 @@ s1ap::handle_s1ap_rx_pdu(srslte::byte_buffer_t *pdu, struct sctp_sndrcvinfo *enb
 
 }
 
+/* Uplink NAS Transport from the lazily decoded PDU: the ids and the NAS
+ * octets are all the handler needs. Called with the S1AP lock held.
+ */
+bool
+s1ap::handle_uplink_nas_transport(uint32_t enb_ue_s1ap_id, uint32_t mme_ue_s1ap_id, const uint8_t *nas_pdu, uint32_t nas_len, struct sctp_sndrcvinfo *enb_sri)
+{
+  bool reply_flag = false;
+  srslte::byte_buffer_t * reply_buffer = m_pool->allocate();
+
+  m_s1ap_log->info("Received Uplink NAS Transport Message.\n");
+  m_s1ap_nas_transport->handle_uplink_nas_transport(enb_ue_s1ap_id, mme_ue_s1ap_id, nas_pdu, nas_len, enb_sri, reply_buffer, &reply_flag);
+  if(reply_flag == true)
+  {
+    ssize_t n_sent = sctp_send(m_s1mme,reply_buffer->msg, reply_buffer->N_bytes, enb_sri, 0);
+    if(n_sent == -1)
+    {
+      m_s1ap_log->console("Failed to send S1AP Initiating Reply.\n");
+      m_s1ap_log->error("Failed to send S1AP Initiating Reply. \n");
+      m_pool->deallocate(reply_buffer);
+      return false;
+    }
+  }
+  m_pool->deallocate(reply_buffer);
+  return true;
+}
+
 bool
 s1ap::handle_initiating_message(LIBLTE_S1AP_INITIATINGMESSAGE_STRUCT *msg,  struct sctp_sndrcvinfo *enb_sri)
 {
@@ -418,6 +452,29 @@ s1ap::add_ue_to_enb_set(int32_t enb_assoc, uint32_t mme_ue_s1ap_id)
   return true;
 }
 
+//Adds a new UE context to the IMSI and MME UE S1AP Id maps and to its eNB's UE set.
+//Either all three are updated or none is.
+bool
+s1ap::add_new_ue_ctx(ue_ctx_t *ue_ctx, int32_t enb_assoc)
+{
+  if(!add_ue_ctx_to_imsi_map(ue_ctx))
+  {
+    return false;
+  }
+  if(!add_ue_ctx_to_mme_ue_s1ap_id_map(ue_ctx))
+  {
+    m_imsi_to_ue_ctx.erase(ue_ctx->emm_ctx.imsi);
+    return false;
+  }
+  if(!add_ue_to_enb_set(enb_assoc, ue_ctx->ecm_ctx.mme_ue_s1ap_id))
+  {
+    m_mme_ue_s1ap_id_to_ue_ctx.erase(ue_ctx->ecm_ctx.mme_ue_s1ap_id);
+    m_imsi_to_ue_ctx.erase(ue_ctx->emm_ctx.imsi);
+    return false;
+  }
+  return true;
+}
+
 ue_ctx_t*
 s1ap::find_ue_ctx_from_mme_ue_s1ap_id(uint32_t mme_ue_s1ap_id)
 {
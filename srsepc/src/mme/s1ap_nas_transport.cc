@@ -176,10 +176,18 @@ s1ap_nas_transport::handle_initial_ue_message(LIBLTE_S1AP_MESSAGE_INITIALUEMESSA
 
 bool
 s1ap_nas_transport::handle_uplink_nas_transport(LIBLTE_S1AP_MESSAGE_UPLINKNASTRANSPORT_STRUCT *ul_xport, struct sctp_sndrcvinfo *enb_sri, srslte::byte_buffer_t *reply_buffer, bool *reply_flag)
+{
+  return handle_uplink_nas_transport(ul_xport->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID,
+                                     ul_xport->MME_UE_S1AP_ID.MME_UE_S1AP_ID,
+                                     ul_xport->NAS_PDU.buffer,
+                                     ul_xport->NAS_PDU.n_octets,
+                                     enb_sri, reply_buffer, reply_flag);
+}
+
+bool
+s1ap_nas_transport::handle_uplink_nas_transport(uint32_t enb_ue_s1ap_id, uint32_t mme_ue_s1ap_id, const uint8_t *nas_pdu, uint32_t nas_len, struct sctp_sndrcvinfo *enb_sri, srslte::byte_buffer_t *reply_buffer, bool *reply_flag)
 {
   uint8_t pd, msg_type, sec_hdr_type;
-  uint32_t enb_ue_s1ap_id = ul_xport->eNB_UE_S1AP_ID.ENB_UE_S1AP_ID;
-  uint32_t mme_ue_s1ap_id = ul_xport->MME_UE_S1AP_ID.MME_UE_S1AP_ID;
   bool mac_valid = false;
 
   //Get UE ECM context
@@ -196,8 +204,14 @@ s1ap_nas_transport::handle_uplink_nas_transport(LIBLTE_S1AP_MESSAGE_UPLINKNASTRA
 
   //Parse NAS message header
   srslte::byte_buffer_t *nas_msg = m_pool->allocate();
-  memcpy(nas_msg->msg, &ul_xport->NAS_PDU.buffer, ul_xport->NAS_PDU.n_octets);
-  nas_msg->N_bytes = ul_xport->NAS_PDU.n_octets;
+  if(nas_len > SRSLTE_MAX_BUFFER_SIZE_BYTES - SRSLTE_BUFFER_HEADER_OFFSET)
+  {
+    m_s1ap_log->warning("Uplink NAS: NAS PDU too long (%d bytes). MME-UE S1AP id: %d\n", nas_len, mme_ue_s1ap_id);
+    m_pool->deallocate(nas_msg);
+    return false;
+  }
+  memcpy(nas_msg->msg, nas_pdu, nas_len);
+  nas_msg->N_bytes = nas_len;
   liblte_mme_parse_msg_header((LIBLTE_BYTE_MSG_STRUCT *) nas_msg, &pd, &msg_type);
 
   // Parse the message security header
@@ -497,23 +511,40 @@ s1ap_nas_transport::handle_nas_imsi_attach_request(uint32_t enb_ue_s1ap_id,
   //Save attach request type
   emm_ctx->attach_type = attach_req.eps_attach_type;
 
-  //Get Authentication Vectors from HSS
-  if(!m_hss->gen_auth_info_answer(emm_ctx->imsi, emm_ctx->security_ctxt.k_asme, autn, rand, emm_ctx->security_ctxt.xres))
+  //Get Authentication Vectors from HSS. The new context is not visible to
+  //other workers yet, so the S1AP lock can be dropped while the HSS runs.
+  m_s1ap->unlock();
+  bool auth_ok = m_hss->gen_auth_info_answer(emm_ctx->imsi, emm_ctx->security_ctxt.k_asme, autn, rand, emm_ctx->security_ctxt.xres);
+  m_s1ap->lock();
+  if(!auth_ok)
   {
     m_s1ap_log->console("User not found. IMSI %015lu\n",emm_ctx->imsi);
     m_s1ap_log->info("User not found. IMSI %015lu\n",emm_ctx->imsi);
     return false;
   }
+  //Another worker may have attached the same IMSI while the lock was
+  //dropped. That attach has already sent its Authentication Request, so
+  //it is kept and this one is rejected.
+  if(m_s1ap->find_ue_ctx_from_imsi(imsi) != NULL)
+  {
+    m_s1ap_log->console("Attach Request -- Concurrent attach for IMSI %015lu, rejecting\n", imsi);
+    m_s1ap_log->warning("Attach Request -- Concurrent attach for IMSI %015lu, rejecting\n", imsi);
+    return false;
+  }
   //Allocate eKSI for this authentication vector
   //Here we assume a new security context thus a new eKSI
   emm_ctx->security_ctxt.eksi=0;
 
-  //Save the UE context
+  //Save the UE context. This fails if the eNB went away while the lock
+  //was dropped.
   ue_ctx_t *new_ctx = new ue_ctx_t;
   memcpy(new_ctx,&ue_ctx,sizeof(ue_ctx_t));
-  m_s1ap->add_ue_ctx_to_imsi_map(new_ctx);
-  m_s1ap->add_ue_ctx_to_mme_ue_s1ap_id_map(new_ctx);
-  m_s1ap->add_ue_to_enb_set(enb_sri->sinfo_assoc_id,ecm_ctx->mme_ue_s1ap_id);
+  if(!m_s1ap->add_new_ue_ctx(new_ctx, enb_sri->sinfo_assoc_id))
+  {
+    m_s1ap_log->error("Attach Request -- Could not save UE context. IMSI %015lu\n", imsi);
+    delete new_ctx;
+    return false;
+  }
 
   //Pack NAS Authentication Request in Downlink NAS Transport msg
   pack_authentication_request(reply_buffer, ecm_ctx->enb_ue_s1ap_id, ecm_ctx->mme_ue_s1ap_id, emm_ctx->security_ctxt.eksi, autn, rand);
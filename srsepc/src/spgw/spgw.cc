@@ -33,6 +33,8 @@
 #include <linux/if.h>
 #include <linux/if_tun.h>
 #include <linux/ip.h>
+#include <linux/filter.h>
+#include <sys/eventfd.h>
 #include <inttypes.h> // for printing uint64_t
 #include "srsepc/hdr/spgw/spgw.h"
 #include "srsepc/hdr/mme/mme_gtpc.h"
@@ -43,15 +45,25 @@ namespace srsepc{
 spgw*          spgw::m_instance = NULL;
 pthread_mutex_t spgw_instance_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-const uint16_t SPGW_BUFFER_SIZE = 2500;
+static void close_fds(int *fds, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++) {
+    close(fds[i]);
+  }
+}
 
 spgw::spgw():
   m_running(false),
   m_sgi_up(false),
   m_s1u_up(false),
-  m_next_ctrl_teid(1),
-  m_next_user_teid(1)
+  m_stop_fd(-1),
+  m_nof_workers(1),
+  m_s1u_ring(false),
+  m_ip_map(&m_ip_maps[0]),
+  m_next_user_teid(1),
+  m_sync_waiting(false)
 {
+  bzero(&m_ip_map_pending, sizeof(m_ip_map_pending));
   return;
 }
 
@@ -92,6 +104,8 @@ spgw::init(spgw_args_t* args, srslte::log_filter *spgw_log)
   m_spgw_log = spgw_log;
   m_mme_gtpc = mme_gtpc::get_instance();
 
+  m_nof_workers = std::max(1u, std::min(args->nof_workers, (uint32_t) SPGW_MAX_WORKERS));
+
   //Init SGi interface
   err = init_sgi_if(args);
   if (err != srslte::ERROR_NONE)
@@ -107,6 +121,20 @@ spgw::init(spgw_args_t* args, srslte::log_filter *spgw_log)
     m_spgw_log->console("Could not initialize the S1-U interface.\n");
     return -1;
   }
+  if (args->s1u_backend == "packet_mmap")
+  {
+    err = init_s1u_ring(args);
+    if (err != srslte::ERROR_NONE)
+    {
+      m_spgw_log->console("Could not initialize the S1-U packet rings.\n");
+      return -1;
+    }
+  }
+  else if (args->s1u_backend != "socket")
+  {
+    m_spgw_log->console("Unknown S1-U backend %s.\n", args->s1u_backend.c_str());
+    return -1;
+  }
   //Initialize UE ip pool
   err = init_ue_ip(args);
   if (err != srslte::ERROR_NONE)
@@ -117,7 +145,27 @@ spgw::init(spgw_args_t* args, srslte::log_filter *spgw_log)
 
   //Init mutex
   pthread_mutex_init(&m_mutex,NULL);
-  m_spgw_log->info("SP-GW Initialized.\n");
+  pthread_mutex_init(&m_sync_mutex,NULL);
+  pthread_cond_init(&m_sync_cond,NULL);
+
+  //Init user-plane workers. They share one eventfd to be told to stop.
+  m_stop_fd = eventfd(0, 0);
+  if (m_stop_fd < 0)
+  {
+    m_spgw_log->error("Failed to create eventfd: %s\n", strerror(errno));
+    return -1;
+  }
+  for (uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    err = m_workers[i].init(this, i, m_s1u[i], m_s1u_ring ? &m_rings[i] : NULL, m_sgi_queue[i], m_stop_fd, m_spgw_log);
+    if (err != srslte::ERROR_NONE)
+    {
+      m_spgw_log->console("Could not initialize SP-GW worker %d.\n", i);
+      return -1;
+    }
+  }
+
+  m_spgw_log->info("SP-GW Initialized. %d user-plane worker(s).\n", m_nof_workers);
   m_spgw_log->console("SP-GW Initialized.\n");
   return 0;
 }
@@ -128,28 +176,59 @@ spgw::stop()
   if(m_running)
   {
     m_running = false;
-    thread_cancel();
+    uint64_t one = 1;
+    if (write(m_stop_fd, &one, sizeof(one)) < 0) {
+      m_spgw_log->error("Failed to wake up SP-GW workers: %s\n", strerror(errno));
+    }
     wait_thread_finish();
+  }
+  for (uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    m_workers[i].cleanup();
+  }
+  if (m_stop_fd >= 0)
+  {
+    close(m_stop_fd);
+    m_stop_fd = -1;
+  }
 
-    //Clean up SGi interface
-    if(m_sgi_up)
+  //Clean up SGi interface
+  if(m_sgi_up)
+  {
+    for (uint32_t i = 0; i < m_nof_workers; i++)
     {
-      close(m_sgi_if);
-      close(m_sgi_sock);
+      close(m_sgi_queue[i]);
     }
-    //Clean up S1-U socket
-    if(m_s1u_up)
+    close(m_sgi_sock);
+    m_sgi_up = false;
+  }
+  //Clean up S1-U sockets
+  if(m_s1u_up)
+  {
+    for (uint32_t i = 0; i < m_nof_workers; i++)
     {
-      close(m_s1u);
+      close(m_s1u[i]);
     }
+    m_s1u_up = false;
   }
-  std::map<uint32_t,spgw_tunnel_ctx*>::iterator it = m_teid_to_tunnel_ctx.begin();         //Map control TEID to tunnel ctx. Usefull to get reply ctrl TEID, UE IP, etc.
-  while(it!=m_teid_to_tunnel_ctx.end())
+  if(m_s1u_ring)
   {
-    m_spgw_log->info("Deleting SP-GW GTP-C Tunnel. IMSI: %lu\n", it->second->imsi);
-    m_spgw_log->console("Deleting SP-GW GTP-C Tunnel. IMSI: %lu\n", it->second->imsi);
-    delete it->second;
-    m_teid_to_tunnel_ctx.erase(it++);
+    for (uint32_t i = 0; i < m_nof_workers; i++)
+    {
+      m_rings[i].stop();
+    }
+    m_s1u_ring = false;
+  }
+  for(uint32_t teid = 0; teid < m_teid_to_tunnel_ctx.end_teid(); teid++)
+  {
+    spgw_tunnel_ctx_t **tunnel_ctx = m_teid_to_tunnel_ctx.find(teid);
+    if(tunnel_ctx)
+    {
+      m_spgw_log->info("Deleting SP-GW GTP-C Tunnel. IMSI: %lu\n", (*tunnel_ctx)->imsi);
+      m_spgw_log->console("Deleting SP-GW GTP-C Tunnel. IMSI: %lu\n", (*tunnel_ctx)->imsi);
+      delete *tunnel_ctx;
+      m_teid_to_tunnel_ctx.remove(teid);
+    }
   }
   return;
 }
@@ -166,26 +245,34 @@ spgw::init_sgi_if(spgw_args_t *args)
   }
 
 
-  // Construct the TUN device
-  m_sgi_if = open("/dev/net/tun", O_RDWR);
-  m_spgw_log->info("TUN file descriptor = %d\n", m_sgi_if);
-  if(m_sgi_if < 0)
+  // Construct the TUN device, with one queue per worker
+  for (uint32_t i = 0; i < m_nof_workers; i++)
   {
-      m_spgw_log->error("Failed to open TUN device: %s\n", strerror(errno));
-      return(srslte::ERROR_CANT_START);
-  }
+    m_sgi_queue[i] = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    m_spgw_log->info("TUN file descriptor = %d\n", m_sgi_queue[i]);
+    if(m_sgi_queue[i] < 0)
+    {
+        m_spgw_log->error("Failed to open TUN device: %s\n", strerror(errno));
+        close_fds(m_sgi_queue, i);
+        return(srslte::ERROR_CANT_START);
+    }
 
-  memset(&ifr, 0, sizeof(ifr));
-  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
-  strncpy(ifr.ifr_ifrn.ifrn_name, dev, IFNAMSIZ-1);
-  ifr.ifr_ifrn.ifrn_name[IFNAMSIZ-1]='\0';
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    if (m_nof_workers > 1) {
+      ifr.ifr_flags |= IFF_MULTI_QUEUE;
+    }
+    strncpy(ifr.ifr_ifrn.ifrn_name, dev, IFNAMSIZ-1);
+    ifr.ifr_ifrn.ifrn_name[IFNAMSIZ-1]='\0';
 
-  if(ioctl(m_sgi_if, TUNSETIFF, &ifr) < 0)
-  {
-      m_spgw_log->error("Failed to set TUN device name: %s\n", strerror(errno));
-      close(m_sgi_if);
-      return(srslte::ERROR_CANT_START);
+    if(ioctl(m_sgi_queue[i], TUNSETIFF, &ifr) < 0)
+    {
+        m_spgw_log->error("Failed to set TUN device name: %s\n", strerror(errno));
+        close_fds(m_sgi_queue, i+1);
+        return(srslte::ERROR_CANT_START);
+    }
   }
+  m_sgi_if = m_sgi_queue[0];
 
   // Bring up the interface
   m_sgi_sock = socket(AF_INET, SOCK_DGRAM, 0);
@@ -193,14 +280,14 @@ spgw::init_sgi_if(spgw_args_t *args)
   if(ioctl(m_sgi_sock, SIOCGIFFLAGS, &ifr) < 0)
   {
       m_spgw_log->error("Failed to bring up socket: %s\n", strerror(errno));
-      close(m_sgi_if);
+      close_fds(m_sgi_queue, m_nof_workers);
       return(srslte::ERROR_CANT_START);
   }
   ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
   if(ioctl(m_sgi_sock, SIOCSIFFLAGS, &ifr) < 0)
   {
       m_spgw_log->error("Failed to set socket flags: %s\n", strerror(errno));
-      close(m_sgi_if);
+      close_fds(m_sgi_queue, m_nof_workers);
       return(srslte::ERROR_CANT_START);
   }
 
@@ -212,7 +299,7 @@ spgw::init_sgi_if(spgw_args_t *args)
 
   if (ioctl(m_sgi_sock, SIOCSIFADDR, &ifr) < 0) {
     m_spgw_log->error("Failed to set TUN interface IP. Address: %s, Error: %s\n", args->sgi_if_addr.c_str(), strerror(errno));
-    close(m_sgi_if);
+    close_fds(m_sgi_queue, m_nof_workers);
     close(m_sgi_sock);
     return srslte::ERROR_CANT_START;
   }
@@ -221,7 +308,7 @@ spgw::init_sgi_if(spgw_args_t *args)
   ((struct sockaddr_in *)&ifr.ifr_netmask)->sin_addr.s_addr = inet_addr("255.255.255.0");
   if (ioctl(m_sgi_sock, SIOCSIFNETMASK, &ifr) < 0) {
     m_spgw_log->error("Failed to set TUN interface Netmask. Error: %s\n", strerror(errno));
-    close(m_sgi_if);
+    close_fds(m_sgi_queue, m_nof_workers);
     close(m_sgi_sock);
     return srslte::ERROR_CANT_START;
   }
@@ -236,30 +323,98 @@ spgw::init_sgi_if(spgw_args_t *args)
 srslte::error_t
 spgw::init_s1u(spgw_args_t *args)
 {
-  //Open S1-U socket
-  m_s1u = socket(AF_INET,SOCK_DGRAM,0);
-  if (m_s1u == -1)
-  {
-    m_spgw_log->error("Failed to open socket: %s\n", strerror(errno));
-    return srslte::ERROR_CANT_START;
-  }
-  m_s1u_up = true;
-
-  //Bind the socket
   m_s1u_addr.sin_family = AF_INET;
   m_s1u_addr.sin_addr.s_addr=inet_addr(args->gtpu_bind_addr.c_str());
   m_s1u_addr.sin_port=htons(GTPU_RX_PORT);
 
-  if (bind(m_s1u,(struct sockaddr *)&m_s1u_addr,sizeof(struct sockaddr_in))) {
-    m_spgw_log->error("Failed to bind socket: %s\n", strerror(errno));
-    return srslte::ERROR_CANT_START;
+  //Open one S1-U socket per worker, all bound to the same address
+  for (uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    m_s1u[i] = socket(AF_INET,SOCK_DGRAM|SOCK_NONBLOCK,0);
+    if (m_s1u[i] == -1)
+    {
+      m_spgw_log->error("Failed to open socket: %s\n", strerror(errno));
+      close_fds(m_s1u, i);
+      return srslte::ERROR_CANT_START;
+    }
+    int enable = 1;
+    if (m_nof_workers > 1 && setsockopt(m_s1u[i], SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable))) {
+      m_spgw_log->error("Failed to set SO_REUSEPORT: %s\n", strerror(errno));
+      close_fds(m_s1u, i+1);
+      return srslte::ERROR_CANT_START;
+    }
+    if (bind(m_s1u[i],(struct sockaddr *)&m_s1u_addr,sizeof(struct sockaddr_in))) {
+      m_spgw_log->error("Failed to bind socket: %s\n", strerror(errno));
+      close_fds(m_s1u, i+1);
+      return srslte::ERROR_CANT_START;
+    }
+    m_spgw_log->info("S1-U socket = %d\n", m_s1u[i]);
+  }
+  m_s1u_up = true;
+
+  /* Shard uplink by TEID: the reuseport program sees the UDP payload, so
+   * the socket index is the GTP-U TEID (bytes 4-7) modulo the number of
+   * sockets. A bearer's uplink therefore always lands on the same worker.
+   */
+  if (m_nof_workers > 1)
+  {
+    struct sock_filter code[] = {
+      { BPF_LD  | BPF_W   | BPF_ABS, 0, 0, 4 },
+      { BPF_ALU | BPF_MOD | BPF_K,   0, 0, m_nof_workers },
+      { BPF_RET | BPF_A,             0, 0, 0 },
+    };
+    struct sock_fprog prog;
+    prog.len    = sizeof(code)/sizeof(code[0]);
+    prog.filter = code;
+    if (setsockopt(m_s1u[0], SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog))) {
+      m_spgw_log->warning("Failed to attach TEID steering program, using kernel hash: %s\n", strerror(errno));
+    }
   }
-  m_spgw_log->info("S1-U socket = %d\n", m_s1u);
   m_spgw_log->info("S1-U IP = %s, Port = %d \n", inet_ntoa(m_s1u_addr.sin_addr),ntohs(m_s1u_addr.sin_port));
 
   return srslte::ERROR_NONE;
 }
 
+/* PACKET_MMAP backend: GTP-U frames are read from and written to rings
+ * shared with the kernel on s1u_if, one per worker, with PACKET_FANOUT
+ * steering by TEID like the reuseport program above. The kernel still
+ * delivers a copy of each frame to the UDP sockets; those are kept for
+ * sending to eNBs whose MAC is not known yet, but given a drop-all filter
+ * so uplink is not seen twice.
+ */
+srslte::error_t
+spgw::init_s1u_ring(spgw_args_t *args)
+{
+  uint32_t fanout_id = getpid() & 0xffff;
+  for (uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    srslte::error_t err = m_rings[i].init(args->s1u_if, m_s1u_addr.sin_addr.s_addr, GTPU_RX_PORT,
+                                          fanout_id, m_nof_workers, m_spgw_log);
+    if (err != srslte::ERROR_NONE)
+    {
+      for (uint32_t j = 0; j < i; j++)
+      {
+        m_rings[j].stop();
+      }
+      return err;
+    }
+  }
+  m_s1u_ring = true;
+
+  struct sock_filter drop = { BPF_RET | BPF_K, 0, 0, 0 };
+  struct sock_fprog prog;
+  prog.len    = 1;
+  prog.filter = &drop;
+  for (uint32_t i = 0; i < m_nof_workers; i++)
+  {
+    if (setsockopt(m_s1u[i], SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog))) {
+      m_spgw_log->warning("Failed to detach S1-U socket from uplink: %s\n", strerror(errno));
+    }
+  }
+  m_spgw_log->info("S1-U using PACKET_MMAP rings on %s\n", args->s1u_if.c_str());
+  return srslte::ERROR_NONE;
+}
+
 srslte::error_t
 spgw::init_ue_ip(spgw_args_t *args)
 {
@@ -272,157 +427,104 @@ spgw::run_thread()
 {
   //Mark the thread as running
   m_running=true;
-  srslte::byte_buffer_t *msg;
-  msg = m_pool->allocate();
-
-  struct sockaddr src_addr;
-  socklen_t addrlen;
-  struct iphdr   *ip_pkt;
-  int sgi = m_sgi_if;
-
-  fd_set set;
-  //struct timeval to;
-  int max_fd = std::max(m_s1u,sgi);
-  while (m_running)
+
+  //Workers 1..N-1 get a core each, worker 0 runs in this thread
+  long nof_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  for (uint32_t i = 1; i < m_nof_workers; i++)
   {
-    msg->reset();
-    FD_ZERO(&set);
-    FD_SET(m_s1u, &set);
-    FD_SET(sgi, &set);
-
-    //m_spgw_log->info("Waiting for S1-U or SGi packets.\n");
-    int n = select(max_fd+1, &set, NULL, NULL, NULL);
-    if (n == -1)
-    { 
-      m_spgw_log->error("Error from select\n");
-    }
-    else if (n)
-    {
-      //m_spgw_log->info("Data is available now.\n");
-      if (FD_ISSET(m_s1u, &set))
-      {
-        msg->N_bytes = recvfrom(m_s1u, msg->msg, SRSLTE_MAX_BUFFER_SIZE_BYTES, 0, &src_addr, &addrlen );
-        handle_s1u_pdu(msg);
-      /*}
-      if (FD_ISSET(m_sgi_if, &set))
-      {
-        msg->N_bytes = read(sgi, msg->msg, SRSLTE_MAX_BUFFER_SIZE_BYTES);*/
-        handle_sgi_pdu(msg);
-      }
-    }
-    else
-    {
-      m_spgw_log->debug("No data from select.\n");
-    }
+    m_workers[i].start_cpu(-2, i % std::max(1L, nof_cpus));
+  }
+  m_workers[0].work();
+  for (uint32_t i = 1; i < m_nof_workers; i++)
+  {
+    m_workers[i].wait_thread_finish();
   }
-  m_pool->deallocate(msg);
   return;
 }
 
-void
-spgw::handle_sgi_pdu(srslte::byte_buffer_t *msg)
+const spgw_ip_map_t*
+spgw::get_ip_map()
 {
-  uint8_t version=0;
-  uint32_t dest_ip;
-  struct in_addr dest_addr;
-  std::map<uint32_t,srslte::gtpc_f_teid_ie>::iterator gtp_fteid_it;
-  bool ip_found = false;
-  srslte::gtpc_f_teid_ie enb_fteid;
-
-  struct iphdr *iph = (struct iphdr *) msg->msg;
-  printf("SGI_:");
-  for(uint32_t i = 0;i < msg->N_bytes;i ++)
-      printf("0x%x ", msg->msg[i]);
-  printf("\n");
-  if(iph->version != 4)
-  {
-    m_spgw_log->warning("IPv6 not supported yet.\n");
-    return;
-  }
-  if(iph->tot_len < 20)
-  {
-    m_spgw_log->warning("Invalid IP header length.\n");
-    return;
-  }
+  return __atomic_load_n(&m_ip_map, __ATOMIC_ACQUIRE);
+}
 
-  pthread_mutex_lock(&m_mutex);
-  gtp_fteid_it = m_ip_to_teid.find(iph->daddr);
-  if(gtp_fteid_it != m_ip_to_teid.end())
-  {
-    ip_found = true;
-    enb_fteid = gtp_fteid_it->second;
+/* Adds (enb_fteid != NULL) or removes the bearer of a UE IP. The workers
+ * read *m_ip_map while the other copy is updated and then published, so a
+ * change costs two O(1) map updates rather than a copy of the whole map.
+ * The copy the workers just left only gets the change at the next update,
+ * by when they have nearly always gone quiescent and there is nothing to
+ * wait for. Called with m_mutex held. Returns false if there was nothing
+ * to remove.
+ */
+bool
+spgw::update_ip_map(in_addr_t ue_ipv4, const srslte::gtpc_f_teid_ie *enb_fteid)
+{
+  if (!enb_fteid && !m_ip_map->find(ue_ipv4)) {
+    return false;
   }
-  pthread_mutex_unlock(&m_mutex);
-
-  if(ip_found == false)
-  {
-    m_spgw_log->console("IP Packet is not for any UE\n");
-    return;
+  spgw_ip_map_t *standby = m_ip_map == &m_ip_maps[0] ? &m_ip_maps[1] : &m_ip_maps[0];
+  if (m_ip_map_pending.valid) {
+    if (m_running) {
+      synchronize_workers();
+    }
+    apply_ip_map_update(standby, m_ip_map_pending);
   }
-  struct sockaddr_in enb_addr;
-  enb_addr.sin_family = AF_INET;
-  enb_addr.sin_port = htons(GTPU_RX_PORT);
-  enb_addr.sin_addr.s_addr = enb_fteid.ipv4;
-  m_spgw_log->console("UE F-TEID found, TEID 0x%x, eNB IP %s\n", enb_fteid.teid, inet_ntoa(enb_addr.sin_addr));
-
-  //Setup GTP-U header
-  srslte::gtpu_header_t header;
-  header.flags        = 0x30;
-  header.message_type = 0xFF;
-  header.length       = msg->N_bytes;
-  header.teid         = enb_fteid.teid;
-
-  //Write header into packet
-  if(!srslte::gtpu_write_header(&header, msg, m_spgw_log))
-  {
-    m_spgw_log->console("Error writing GTP-U header on PDU\n");
+  m_ip_map_pending.valid   = true;
+  m_ip_map_pending.erase   = enb_fteid == NULL;
+  m_ip_map_pending.ue_ipv4 = ue_ipv4;
+  if (enb_fteid) {
+    m_ip_map_pending.enb_fteid = *enb_fteid;
   }
+  apply_ip_map_update(standby, m_ip_map_pending);
 
-
-  //Send packet to destination
-  int n = sendto(m_s1u,msg->msg,msg->N_bytes,0,(struct sockaddr*) &enb_addr,sizeof(enb_addr));
-  if(n<0)
-  {
-    m_spgw_log->error("Error sending packet to eNB\n");
-    return;
+  __atomic_store_n(&m_ip_map, standby, __ATOMIC_SEQ_CST);
+  for (uint32_t i = 0; i < m_nof_workers; i++) {
+    m_publish_epoch[i] = m_workers[i].get_epoch();
   }
-  else if((unsigned int) n!=msg->N_bytes)
-  {
-    m_spgw_log->error("Mis-match between packet bytes and sent bytes: Sent: %d, Packet: %d \n",n,msg->N_bytes);
+  return true;
+}
+
+void
+spgw::apply_ip_map_update(spgw_ip_map_t *ip_map, const spgw_ip_map_update_t &update)
+{
+  if (update.erase) {
+    ip_map->erase(update.ue_ipv4);
+  } else {
+    ip_map->insert(update.ue_ipv4, update.enb_fteid);
   }
-  return;
 }
 
+/* Waits until every worker has gone through a quiescent state since the
+ * last publication, i.e. its epoch was odd (blocked in epoll) or has moved.
+ * Workers only signal m_sync_cond while someone is waiting.
+ */
+void
+spgw::synchronize_workers()
+{
+  pthread_mutex_lock(&m_sync_mutex);
+  __atomic_store_n(&m_sync_waiting, true, __ATOMIC_SEQ_CST);
+  for (uint32_t i = 0; i < m_nof_workers; i++) {
+    while ((m_publish_epoch[i] & 1) == 0 && m_workers[i].get_epoch() == m_publish_epoch[i]) {
+      pthread_cond_wait(&m_sync_cond, &m_sync_mutex);
+    }
+  }
+  __atomic_store_n(&m_sync_waiting, false, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&m_sync_mutex);
+}
 
 void
-spgw::handle_s1u_pdu(srslte::byte_buffer_t *msg)
+spgw::worker_quiescent()
 {
-  //m_spgw_log->console("Received PDU from S1-U. Bytes=%d\n",msg->N_bytes);
-  srslte::gtpu_header_t header;
-  srslte::gtpu_read_header(msg, &header, m_spgw_log);
- 
-  /*m_spgw_log->console("TEID 0x%x. Bytes=%d\n", header.teid, msg->N_bytes);
-  int n = write(m_sgi_if, msg->msg, msg->N_bytes);
-  if(n<0)
-  {
-    m_spgw_log->error("Could not write to TUN interface.\n");
+  if (__atomic_load_n(&m_sync_waiting, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&m_sync_mutex);
+    pthread_cond_broadcast(&m_sync_cond);
+    pthread_mutex_unlock(&m_sync_mutex);
   }
-  else
-  {
-    //m_spgw_log->console("Forwarded packet to TUN interface. Bytes= %d/%d\n", n, msg->N_bytes);
-  }*/
-  return;
 }
 
 /*
  * Helper Functions
  */
-uint64_t
-spgw::get_new_ctrl_teid()
-{
-  return m_next_ctrl_teid++;
-}
-
 uint64_t
 spgw::get_new_user_teid()
 {
@@ -439,8 +541,6 @@ spgw::get_new_ue_ipv4()
 spgw_tunnel_ctx_t*
 spgw::create_gtp_ctx(struct srslte::gtpc_create_session_request *cs_req)
 {
-  //Setup uplink control TEID
-  uint64_t spgw_uplink_ctrl_teid = get_new_ctrl_teid();
   //Setup uplink user TEID
   uint64_t spgw_uplink_user_teid = get_new_user_teid();
   //Allocate UE IP
@@ -448,17 +548,19 @@ spgw::create_gtp_ctx(struct srslte::gtpc_create_session_request *cs_req)
   //in_addr_t ue_ip = inet_addr("172.16.0.2");
   uint8_t default_bearer_id = 5;
 
+  //Save the UE IP to User TEID map 
+  spgw_tunnel_ctx_t *tunnel_ctx = new spgw_tunnel_ctx_t;
+  bzero(tunnel_ctx,sizeof(spgw_tunnel_ctx_t));
+
+  //Setup uplink control TEID. The table hands them out, which keeps them dense.
+  uint64_t spgw_uplink_ctrl_teid = m_teid_to_tunnel_ctx.add(tunnel_ctx);
+
   m_spgw_log->console("SPGW: Allocated Ctrl TEID %" PRIu64 "\n", spgw_uplink_ctrl_teid);
   m_spgw_log->console("SPGW: Allocated User TEID %" PRIu64 "\n", spgw_uplink_user_teid);
   struct in_addr ue_ip_;
   ue_ip_.s_addr=ue_ip;
   m_spgw_log->console("SPGW: Allocate UE IP %s\n", inet_ntoa(ue_ip_));
 
-
-  //Save the UE IP to User TEID map 
-  spgw_tunnel_ctx_t *tunnel_ctx = new spgw_tunnel_ctx_t;
-  bzero(tunnel_ctx,sizeof(spgw_tunnel_ctx_t));
-
   tunnel_ctx->imsi = cs_req->imsi;
   tunnel_ctx->ebi = default_bearer_id;
   tunnel_ctx->up_user_fteid.teid = spgw_uplink_user_teid;
@@ -468,7 +570,6 @@ spgw::create_gtp_ctx(struct srslte::gtpc_create_session_request *cs_req)
 
   tunnel_ctx->up_ctrl_fteid.teid = spgw_uplink_ctrl_teid;
   tunnel_ctx->ue_ipv4 = ue_ip;
-  m_teid_to_tunnel_ctx.insert(std::pair<uint32_t,spgw_tunnel_ctx_t*>(spgw_uplink_ctrl_teid,tunnel_ctx));
   m_imsi_to_ctr_teid.insert(std::pair<uint64_t,uint32_t>(cs_req->imsi,spgw_uplink_ctrl_teid));
   return tunnel_ctx; 
 }
@@ -476,25 +577,22 @@ spgw::create_gtp_ctx(struct srslte::gtpc_create_session_request *cs_req)
 bool
 spgw::delete_gtp_ctx(uint32_t ctrl_teid)
 {
-  spgw_tunnel_ctx_t *tunnel_ctx;
-  if(!m_teid_to_tunnel_ctx.count(ctrl_teid)){
+  spgw_tunnel_ctx_t **tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
+  if(!tunnel_it){
     m_spgw_log->error("Could not find GTP context to delete.\n");
     return false;
   }
-  tunnel_ctx = m_teid_to_tunnel_ctx[ctrl_teid];
+  spgw_tunnel_ctx_t *tunnel_ctx = *tunnel_it;
 
   //Remove GTP-U connections, if any.
-  if(m_ip_to_teid.count(tunnel_ctx->ue_ipv4))
-  {
-    pthread_mutex_lock(&m_mutex);
-    m_ip_to_teid.erase(tunnel_ctx->ue_ipv4);
-    pthread_mutex_unlock(&m_mutex);   
-  }
+  pthread_mutex_lock(&m_mutex);
+  update_ip_map(tunnel_ctx->ue_ipv4, NULL);
+  pthread_mutex_unlock(&m_mutex);
   //Remove Ctrl TEID from IMSI to control TEID map
   m_imsi_to_ctr_teid.erase(tunnel_ctx->imsi);
 
   //Remove GTP context from control TEID mapping
-  m_teid_to_tunnel_ctx.erase(ctrl_teid);
+  m_teid_to_tunnel_ctx.remove(ctrl_teid);
   delete tunnel_ctx; 
   return true;
 }
@@ -561,13 +659,13 @@ spgw::handle_modify_bearer_request(struct srslte::gtpc_pdu *mb_req_pdu, struct s
 
   //Get control tunnel info from mb_req PDU
   uint32_t ctrl_teid = mb_req_pdu->header.teid;
-  std::map<uint32_t,spgw_tunnel_ctx_t*>::iterator tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
-  if(tunnel_it == m_teid_to_tunnel_ctx.end())
+  spgw_tunnel_ctx_t **tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
+  if(!tunnel_it)
   {
     m_spgw_log->warning("Could not find TEID %d to modify\n",ctrl_teid);
     return;
   }
-  spgw_tunnel_ctx_t *tunnel_ctx = tunnel_it->second;
+  spgw_tunnel_ctx_t *tunnel_ctx = *tunnel_it;
 
   //Store user DW link TEID
   srslte::gtpc_modify_bearer_request *mb_req = &mb_req_pdu->choice.modify_bearer_request;
@@ -592,8 +690,7 @@ spgw::handle_modify_bearer_request(struct srslte::gtpc_pdu *mb_req_pdu, struct s
   //Setup IP to F-TEID map
   //bool ret = false;
   pthread_mutex_lock(&m_mutex);
-  m_ip_to_teid[tunnel_ctx->ue_ipv4]=tunnel_ctx->dw_user_fteid;
-  //ret = m_ip_to_teid.insert(std::pair<uint32_t,srslte::gtpc_f_teid_ie>(tunnel_ctx->ue_ipv4, tunnel_ctx->dw_user_fteid));
+  update_ip_map(tunnel_ctx->ue_ipv4, &tunnel_ctx->dw_user_fteid);
   pthread_mutex_unlock(&m_mutex);
 
   //Setting up Modify bearer response PDU
@@ -617,24 +714,20 @@ spgw::handle_delete_session_request(struct srslte::gtpc_pdu *del_req_pdu, struct
 {
   //Find tunel ctxt
   uint32_t ctrl_teid = del_req_pdu->header.teid;
-  std::map<uint32_t,spgw_tunnel_ctx_t*>::iterator tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
-  if(tunnel_it == m_teid_to_tunnel_ctx.end())
+  spgw_tunnel_ctx_t **tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
+  if(!tunnel_it)
   {
     m_spgw_log->warning("Could not find TEID %d to delete\n",ctrl_teid);
     return;
   }
-  spgw_tunnel_ctx_t *tunnel_ctx = tunnel_it->second;
+  spgw_tunnel_ctx_t *tunnel_ctx = *tunnel_it;
   in_addr_t ue_ipv4 = tunnel_ctx->ue_ipv4;
 
   //Delete data tunnel
   pthread_mutex_lock(&m_mutex);
-  std::map<in_addr_t,srslte::gtp_fteid_t>::iterator data_it = m_ip_to_teid.find(tunnel_ctx->ue_ipv4);
-  if(data_it != m_ip_to_teid.end())
-  {
-    m_ip_to_teid.erase(data_it);
-  }
+  update_ip_map(tunnel_ctx->ue_ipv4, NULL);
   pthread_mutex_unlock(&m_mutex);
-  m_teid_to_tunnel_ctx.erase(tunnel_it);
+  m_teid_to_tunnel_ctx.remove(ctrl_teid);
 
   delete tunnel_ctx; 
   return;
@@ -645,22 +738,18 @@ spgw::handle_release_access_bearers_request(struct srslte::gtpc_pdu *rel_req_pdu
 {
   //Find tunel ctxt
   uint32_t ctrl_teid = rel_req_pdu->header.teid;
-  std::map<uint32_t,spgw_tunnel_ctx_t*>::iterator tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
-  if(tunnel_it == m_teid_to_tunnel_ctx.end())
+  spgw_tunnel_ctx_t **tunnel_it = m_teid_to_tunnel_ctx.find(ctrl_teid);
+  if(!tunnel_it)
   {
     m_spgw_log->warning("Could not find TEID %d to release bearers from\n",ctrl_teid);
     return;
   }
-  spgw_tunnel_ctx_t *tunnel_ctx = tunnel_it->second;
+  spgw_tunnel_ctx_t *tunnel_ctx = *tunnel_it;
   in_addr_t ue_ipv4 = tunnel_ctx->ue_ipv4;
 
   //Delete data tunnel
   pthread_mutex_lock(&m_mutex);
-  std::map<in_addr_t,srslte::gtpc_f_teid_ie>::iterator data_it = m_ip_to_teid.find(tunnel_ctx->ue_ipv4);
-  if(data_it != m_ip_to_teid.end())
-  {
-    m_ip_to_teid.erase(data_it);
-  }
+  update_ip_map(tunnel_ctx->ue_ipv4, NULL);
   pthread_mutex_unlock(&m_mutex);
 
   //Do NOT delete control tunnel
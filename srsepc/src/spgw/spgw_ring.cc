@@ -0,0 +1,352 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include "srsepc/hdr/spgw/spgw_ring.h"
+
+namespace srsepc{
+
+// Transmitted data starts this far into a TX frame (kernel default without PACKET_TX_HAS_OFF)
+static const uint32_t SPGW_RING_TX_DATA_OFFSET = TPACKET3_HDRLEN - sizeof(struct sockaddr_ll);
+
+static uint16_t ip_checksum(const uint16_t *hdr)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < 10; i++) {
+    sum += hdr[i];
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return ~sum;
+}
+
+spgw_ring::spgw_ring():
+  m_fd(-1),
+  m_map(NULL),
+  m_map_len(0),
+  m_ifindex(0),
+  m_local_ip(0),
+  m_port(0),
+  m_ip_id(0),
+  m_rx_block(0),
+  m_rx_left(0),
+  m_rx_frame(NULL),
+  m_tx_frame(0),
+  m_tx_nof_frames(0),
+  m_tx_pending(0),
+  m_spgw_log(NULL)
+{
+  bzero(&m_mac, sizeof(m_mac));
+}
+
+spgw_ring::~spgw_ring()
+{
+  stop();
+}
+
+srslte::error_t
+spgw_ring::init(const std::string &ifname, in_addr_t local_ip, uint16_t port, uint32_t fanout_id, uint32_t nof_fanout, srslte::log_filter *spgw_log)
+{
+  m_spgw_log = spgw_log;
+  m_local_ip = local_ip;
+  m_port     = port;
+
+  m_ifindex = if_nametoindex(ifname.c_str());
+  if (m_ifindex == 0) {
+    m_spgw_log->error("Unknown S1-U interface %s\n", ifname.c_str());
+    return srslte::ERROR_CANT_START;
+  }
+
+  m_fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_IP));
+  if (m_fd < 0) {
+    m_spgw_log->error("Failed to open packet socket: %s\n", strerror(errno));
+    return srslte::ERROR_CANT_START;
+  }
+
+  struct ifreq ifr;
+  bzero(&ifr, sizeof(ifr));
+  strncpy(ifr.ifr_name, ifname.c_str(), IFNAMSIZ-1);
+  if (ioctl(m_fd, SIOCGIFHWADDR, &ifr) < 0) {
+    m_spgw_log->error("Failed to get MAC address of %s: %s\n", ifname.c_str(), strerror(errno));
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+  memcpy(m_mac.addr, ifr.ifr_hwaddr.sa_data, sizeof(m_mac.addr));
+
+  int version = TPACKET_V3;
+  if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version))) {
+    m_spgw_log->error("TPACKET_V3 not supported: %s\n", strerror(errno));
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+
+  // Only GTP-U for us: unfragmented IPv4/UDP to local_ip:port
+  struct sock_filter code[] = {
+    { BPF_LD  | BPF_H   | BPF_ABS,  0, 0, 12 },                     // ethertype
+    { BPF_JMP | BPF_JEQ | BPF_K,    0, 9, ETH_P_IP },
+    { BPF_LD  | BPF_B   | BPF_ABS,  0, 0, SPGW_RING_ETH_LEN + 9 },  // IP protocol
+    { BPF_JMP | BPF_JEQ | BPF_K,    0, 7, IPPROTO_UDP },
+    { BPF_LD  | BPF_W   | BPF_ABS,  0, 0, SPGW_RING_ETH_LEN + 16 }, // IP destination
+    { BPF_JMP | BPF_JEQ | BPF_K,    0, 5, ntohl(local_ip) },
+    { BPF_LD  | BPF_H   | BPF_ABS,  0, 0, SPGW_RING_ETH_LEN + 6 },  // fragment offset
+    { BPF_JMP | BPF_JSET| BPF_K,    3, 0, 0x1FFF },
+    { BPF_LDX | BPF_B   | BPF_MSH,  0, 0, SPGW_RING_ETH_LEN },      // IP header length
+    { BPF_LD  | BPF_H   | BPF_IND,  0, 0, SPGW_RING_ETH_LEN + 2 },  // UDP destination port
+    { BPF_JMP | BPF_JEQ | BPF_K,    1, 0, port },
+    { BPF_RET | BPF_K,              0, 0, 0 },
+    { BPF_RET | BPF_K,              0, 0, 0xFFFF },
+  };
+  struct sock_fprog filter;
+  filter.len    = sizeof(code)/sizeof(code[0]);
+  filter.filter = code;
+  if (setsockopt(m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter))) {
+    m_spgw_log->error("Failed to attach S1-U filter: %s\n", strerror(errno));
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+
+  int enable = 1;
+  setsockopt(m_fd, SOL_PACKET, PACKET_QDISC_BYPASS, &enable, sizeof(enable));
+#ifdef PACKET_IGNORE_OUTGOING
+  setsockopt(m_fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &enable, sizeof(enable));
+#endif
+
+  struct tpacket_req3 req;
+  bzero(&req, sizeof(req));
+  req.tp_block_size     = SPGW_RING_BLOCK_SIZE;
+  req.tp_block_nr       = SPGW_RING_NOF_BLOCKS;
+  req.tp_frame_size     = SPGW_RING_FRAME_SIZE;
+  req.tp_frame_nr       = SPGW_RING_BLOCK_SIZE / SPGW_RING_FRAME_SIZE * SPGW_RING_NOF_BLOCKS;
+  req.tp_retire_blk_tov = SPGW_RING_RETIRE_MS;
+  if (setsockopt(m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req))) {
+    m_spgw_log->error("Failed to set up RX ring: %s\n", strerror(errno));
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+  req.tp_retire_blk_tov = 0;
+  if (setsockopt(m_fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req))) {
+    m_spgw_log->error("Failed to set up TX ring: %s\n", strerror(errno));
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+  m_tx_nof_frames = req.tp_frame_nr;
+
+  m_map_len = 2 * (size_t) SPGW_RING_BLOCK_SIZE * SPGW_RING_NOF_BLOCKS;
+  void *map = mmap(NULL, m_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, 0);
+  if (map == MAP_FAILED) {
+    m_spgw_log->error("Failed to map rings: %s\n", strerror(errno));
+    m_map_len = 0;
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+  m_map = (uint8_t*) map;
+
+  struct sockaddr_ll ll;
+  bzero(&ll, sizeof(ll));
+  ll.sll_family   = AF_PACKET;
+  ll.sll_protocol = htons(ETH_P_IP);
+  ll.sll_ifindex  = m_ifindex;
+  if (bind(m_fd, (struct sockaddr *) &ll, sizeof(ll))) {
+    m_spgw_log->error("Failed to bind packet socket to %s: %s\n", ifname.c_str(), strerror(errno));
+    stop();
+    return srslte::ERROR_CANT_START;
+  }
+
+  /* Same TEID sharding as the S1-U sockets. The fanout program sees the
+   * frame from the IP header: TEID is 12 bytes into the UDP header.
+   */
+  if (nof_fanout > 1) {
+    int arg = (fanout_id & 0xFFFF) | (PACKET_FANOUT_CBPF << 16);
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg))) {
+      m_spgw_log->error("Failed to join fanout group: %s\n", strerror(errno));
+      stop();
+      return srslte::ERROR_CANT_START;
+    }
+    struct sock_filter shard[] = {
+      { BPF_LDX | BPF_B   | BPF_MSH, 0, 0, 0 },
+      { BPF_LD  | BPF_W   | BPF_IND, 0, 0, 8 + 4 },
+      { BPF_ALU | BPF_MOD | BPF_K,   0, 0, nof_fanout },
+      { BPF_RET | BPF_A,             0, 0, 0 },
+    };
+    struct sock_fprog prog;
+    prog.len    = sizeof(shard)/sizeof(shard[0]);
+    prog.filter = shard;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_FANOUT_DATA, &prog, sizeof(prog))) {
+      m_spgw_log->warning("Failed to set fanout program, spreading by hash: %s\n", strerror(errno));
+    }
+  }
+
+  m_spgw_log->info("S1-U ring on %s: %d x %d kB RX and TX\n", ifname.c_str(), SPGW_RING_NOF_BLOCKS, SPGW_RING_BLOCK_SIZE/1024);
+  return srslte::ERROR_NONE;
+}
+
+void
+spgw_ring::stop()
+{
+  if (m_map) {
+    munmap(m_map, m_map_len);
+    m_map = NULL;
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+    m_fd = -1;
+  }
+}
+
+uint8_t*
+spgw_ring::rx_next(uint32_t *len)
+{
+  while (true) {
+    if (m_rx_left) {
+      struct tpacket3_hdr *ppd = (struct tpacket3_hdr *) m_rx_frame;
+      *len = ppd->tp_snaplen;
+      m_rx_left--;
+      m_rx_frame += ppd->tp_next_offset;
+      return (uint8_t*) ppd + ppd->tp_mac;
+    }
+    // The frame returned last is still in use until now
+    if (m_rx_frame) {
+      rx_release_block();
+    }
+    struct tpacket_block_desc *bd = (struct tpacket_block_desc *) (m_map + (size_t) m_rx_block * SPGW_RING_BLOCK_SIZE);
+    if (!(__atomic_load_n(&bd->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+      return NULL;
+    }
+    m_rx_left  = bd->hdr.bh1.num_pkts;
+    m_rx_frame = (uint8_t*) bd + bd->hdr.bh1.offset_to_first_pkt;
+  }
+}
+
+void
+spgw_ring::rx_release_block()
+{
+  struct tpacket_block_desc *bd = (struct tpacket_block_desc *) (m_map + (size_t) m_rx_block * SPGW_RING_BLOCK_SIZE);
+  __atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+  m_rx_block = (m_rx_block + 1) % SPGW_RING_NOF_BLOCKS;
+  m_rx_frame = NULL;
+}
+
+uint8_t*
+spgw_ring::tx_payload(uint32_t *max_len)
+{
+  uint8_t *frame = m_map + (size_t) SPGW_RING_BLOCK_SIZE * SPGW_RING_NOF_BLOCKS + (size_t) m_tx_frame * SPGW_RING_FRAME_SIZE;
+  struct tpacket3_hdr *hdr = (struct tpacket3_hdr *) frame;
+  if (__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) {
+    return NULL;
+  }
+  *max_len = SPGW_RING_FRAME_SIZE - SPGW_RING_TX_DATA_OFFSET - SPGW_RING_OUTER_LEN;
+  return frame + SPGW_RING_TX_DATA_OFFSET + SPGW_RING_OUTER_LEN;
+}
+
+void
+spgw_ring::tx_commit(in_addr_t dst_ip, const spgw_eth_addr_t *dst_mac, srslte::gtpu_tpdu_template_t tmpl, uint32_t len)
+{
+  uint8_t *frame = m_map + (size_t) SPGW_RING_BLOCK_SIZE * SPGW_RING_NOF_BLOCKS + (size_t) m_tx_frame * SPGW_RING_FRAME_SIZE;
+  uint8_t *ptr   = frame + SPGW_RING_TX_DATA_OFFSET;
+
+  memcpy(ptr, dst_mac->addr, 6);
+  memcpy(ptr + 6, m_mac.addr, 6);
+  ptr[12] = ETH_P_IP >> 8;
+  ptr[13] = ETH_P_IP & 0xFF;
+  ptr += SPGW_RING_ETH_LEN;
+
+  struct iphdr *ip = (struct iphdr *) ptr;
+  ip->version  = 4;
+  ip->ihl      = 5;
+  ip->tos      = 0;
+  ip->tot_len  = htons(20 + 8 + GTPU_HEADER_LEN + len);
+  ip->id       = htons(m_ip_id++);
+  ip->frag_off = htons(0x4000);   // DF
+  ip->ttl      = 64;
+  ip->protocol = IPPROTO_UDP;
+  ip->check    = 0;
+  ip->saddr    = m_local_ip;
+  ip->daddr    = dst_ip;
+  ip->check    = ip_checksum((uint16_t *) ip);
+  ptr += 20;
+
+  // No UDP checksum, as allowed over IPv4
+  struct udphdr *udp = (struct udphdr *) ptr;
+  udp->source = htons(m_port);
+  udp->dest   = htons(m_port);
+  udp->len    = htons(8 + GTPU_HEADER_LEN + len);
+  udp->check  = 0;
+  ptr += 8;
+
+  srslte::gtpu_write_tpdu(tmpl, len, ptr);
+
+  struct tpacket3_hdr *hdr = (struct tpacket3_hdr *) frame;
+  hdr->tp_len         = SPGW_RING_OUTER_LEN + len;
+  hdr->tp_snaplen     = hdr->tp_len;
+  hdr->tp_next_offset = 0;
+  __atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+
+  m_tx_frame = (m_tx_frame + 1) % m_tx_nof_frames;
+  m_tx_pending++;
+}
+
+void
+spgw_ring::tx_flush()
+{
+  if (m_tx_pending == 0) {
+    return;
+  }
+  if (send(m_fd, NULL, 0, MSG_DONTWAIT) < 0 && errno != EAGAIN && errno != ENOBUFS) {
+    m_spgw_log->error("Failed to send S1-U ring: %s\n", strerror(errno));
+  }
+  m_tx_pending = 0;
+}
+
+const spgw_eth_addr_t*
+spgw_ring::get_neighbour(in_addr_t ip)
+{
+  return m_neighbours.find(ip);
+}
+
+void
+spgw_ring::learn_neighbour(in_addr_t ip, const uint8_t *mac)
+{
+  spgw_eth_addr_t *known = m_neighbours.find(ip);
+  if (!known || memcmp(known->addr, mac, 6)) {
+    spgw_eth_addr_t addr;
+    memcpy(addr.addr, mac, 6);
+    m_neighbours.insert(ip, addr);
+  }
+}
+
+} //namespace srsepc
@@ -0,0 +1,481 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <arpa/inet.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include <algorithm>
+#include "srsepc/hdr/spgw/spgw.h"
+#include "srslte/upper/gtpu.h"
+
+namespace srsepc{
+
+// Batches drained per wake-up before going back to epoll
+const uint32_t SPGW_MAX_BATCHES = 8;
+
+spgw_worker::spgw_worker():
+  m_parent(NULL),
+  m_id(0),
+  m_s1u(-1),
+  m_ring(NULL),
+  m_sgi_if(-1),
+  m_stop_fd(-1),
+  m_epoll(-1),
+  m_epoch(1),
+  m_nof_tx(0),
+  m_pool(NULL),
+  m_spgw_log(NULL)
+{
+  bzero(m_buf, sizeof(m_buf));
+  m_view = NULL;
+}
+
+srslte::error_t
+spgw_worker::init(spgw *parent, uint32_t id, int s1u, spgw_ring *ring, int sgi_if, int stop_fd, srslte::log_filter *spgw_log)
+{
+  m_parent   = parent;
+  m_id       = id;
+  m_s1u      = s1u;
+  m_ring     = ring;
+  m_sgi_if   = sgi_if;
+  m_stop_fd  = stop_fd;
+  m_spgw_log = spgw_log;
+  m_pool     = srslte::byte_buffer_pool::get_instance();
+
+  for (uint32_t i = 0; i < SPGW_BATCH_LEN; i++) {
+    m_buf[i] = m_pool->allocate("spgw_worker");
+    if (m_buf[i] == NULL) {
+      m_spgw_log->error("Worker %d: could not allocate buffers\n", m_id);
+      return srslte::ERROR_CANT_START;
+    }
+  }
+  m_view = m_pool->allocate("spgw_worker");
+  if (m_view == NULL) {
+    m_spgw_log->error("Worker %d: could not allocate buffers\n", m_id);
+    return srslte::ERROR_CANT_START;
+  }
+
+  bzero(m_rx_msgs, sizeof(m_rx_msgs));
+  bzero(m_tx_msgs, sizeof(m_tx_msgs));
+  for (uint32_t i = 0; i < SPGW_BATCH_LEN; i++) {
+    m_rx_msgs[i].msg_hdr.msg_name    = &m_rx_addr[i];
+    m_rx_msgs[i].msg_hdr.msg_iov     = &m_rx_iov[i];
+    m_rx_msgs[i].msg_hdr.msg_iovlen  = 1;
+    m_tx_msgs[i].msg_hdr.msg_name    = &m_tx_addr[i];
+    m_tx_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    m_tx_msgs[i].msg_hdr.msg_iov     = &m_tx_iov[i];
+    m_tx_msgs[i].msg_hdr.msg_iovlen  = 1;
+  }
+
+  m_epoll = epoll_create1(0);
+  if (m_epoll < 0) {
+    m_spgw_log->error("Worker %d: failed to create epoll set: %s\n", m_id, strerror(errno));
+    return srslte::ERROR_CANT_START;
+  }
+  int fds[3] = {m_stop_fd, m_ring ? m_ring->get_fd() : m_s1u, m_sgi_if};
+  for (uint32_t i = 0; i < 3; i++) {
+    struct epoll_event ev;
+    bzero(&ev, sizeof(ev));
+    ev.events  = EPOLLIN;
+    ev.data.fd = fds[i];
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fds[i], &ev)) {
+      m_spgw_log->error("Worker %d: failed to add fd %d to epoll set: %s\n", m_id, fds[i], strerror(errno));
+      return srslte::ERROR_CANT_START;
+    }
+  }
+  return srslte::ERROR_NONE;
+}
+
+void
+spgw_worker::cleanup()
+{
+  for (uint32_t i = 0; i < SPGW_BATCH_LEN; i++) {
+    if (m_buf[i]) {
+      m_pool->deallocate(m_buf[i]);
+      m_buf[i] = NULL;
+    }
+  }
+  if (m_view) {
+    m_pool->deallocate(m_view);
+    m_view = NULL;
+  }
+  if (m_epoll >= 0) {
+    close(m_epoll);
+    m_epoll = -1;
+  }
+}
+
+uint32_t
+spgw_worker::get_epoch()
+{
+  return __atomic_load_n(&m_epoch, __ATOMIC_SEQ_CST);
+}
+
+void
+spgw_worker::run_thread()
+{
+  work();
+}
+
+void
+spgw_worker::work()
+{
+  struct epoll_event events[3];
+  bool running = true;
+
+  while (running) {
+    // Quiescent while blocked: the control plane need not wait for us
+    __atomic_store_n(&m_epoch, m_epoch | 1, __ATOMIC_SEQ_CST);
+    m_parent->worker_quiescent();
+    int n = epoll_wait(m_epoll, events, 3, -1);
+    __atomic_add_fetch(&m_epoch, 1, __ATOMIC_SEQ_CST);
+
+    if (n < 0) {
+      if (errno != EINTR) {
+        m_spgw_log->error("Worker %d: epoll_wait failed: %s\n", m_id, strerror(errno));
+        running = false;
+      }
+      continue;
+    }
+    for (int i = 0; i < n; i++) {
+      if (events[i].data.fd == m_stop_fd) {
+        running = false;
+      } else if (events[i].data.fd == m_sgi_if) {
+        if (m_ring) {
+          handle_ring_sgi();
+        } else {
+          handle_sgi();
+        }
+      } else if (m_ring) {
+        handle_ring_s1u();
+      } else {
+        handle_s1u();
+      }
+    }
+  }
+  __atomic_store_n(&m_epoch, m_epoch | 1, __ATOMIC_SEQ_CST);
+  m_parent->worker_quiescent();
+}
+
+/* Uplink. Packets addressed to another UE are hairpinned back over S1-U,
+ * the rest are written to the SGi interface.
+ */
+void
+spgw_worker::handle_s1u()
+{
+  const spgw_ip_map_t *ip_map = m_parent->get_ip_map();
+
+  for (uint32_t b = 0; b < SPGW_MAX_BATCHES; b++) {
+    for (uint32_t i = 0; i < SPGW_BATCH_LEN; i++) {
+      m_buf[i]->reset();
+      m_rx_iov[i].iov_base = m_buf[i]->msg;
+      m_rx_iov[i].iov_len  = m_buf[i]->get_tailroom();
+      m_rx_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+    int n = recvmmsg(m_s1u, m_rx_msgs, SPGW_BATCH_LEN, MSG_DONTWAIT, NULL);
+    if (n <= 0) {
+      if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        m_spgw_log->error("Worker %d: error reading from S1-U: %s\n", m_id, strerror(errno));
+      }
+      return;
+    }
+
+    for (int i = 0; i < n; i++) {
+      srslte::byte_buffer_t *msg = m_buf[i];
+      msg->N_bytes = m_rx_msgs[i].msg_len;
+      srslte::gtpu_header_t header;
+      if (!srslte::gtpu_read_header(msg, &header, m_spgw_log)) {
+        continue;
+      }
+      if (header.message_type == GTPU_MSG_ECHO_REQUEST) {
+        if (srslte::gtpu_write_echo_response(&header, msg, m_spgw_log)) {
+          queue_tx(msg, &m_rx_addr[i]);
+        }
+        continue;
+      }
+      if (header.message_type != GTPU_MSG_DATA_PDU) {
+        m_spgw_log->debug("Worker %d: ignoring GTP-U message type %d\n", m_id, header.message_type);
+        continue;
+      }
+      if (msg->N_bytes < sizeof(struct iphdr)) {
+        m_spgw_log->warning("Worker %d: dropping short S1-U PDU of %d bytes\n", m_id, msg->N_bytes);
+        continue;
+      }
+
+      struct iphdr *iph = (struct iphdr *) msg->msg;
+      if (ip_map->find(iph->daddr)) {
+        queue_s1u(ip_map, msg);
+      } else if (write(m_sgi_if, msg->msg, msg->N_bytes) < 0) {
+        m_spgw_log->debug("Worker %d: could not write to TUN interface: %s\n", m_id, strerror(errno));
+      }
+    }
+    flush_s1u();
+
+    if (n < (int) SPGW_BATCH_LEN) {
+      return;
+    }
+  }
+}
+
+// Downlink. TUN queues have no batched read, but sends still go out in one sendmmsg
+void
+spgw_worker::handle_sgi()
+{
+  const spgw_ip_map_t *ip_map = m_parent->get_ip_map();
+
+  for (uint32_t b = 0; b < SPGW_MAX_BATCHES; b++) {
+    uint32_t n = 0;
+    while (n < SPGW_BATCH_LEN) {
+      srslte::byte_buffer_t *msg = m_buf[n];
+      msg->reset();
+      int len = read(m_sgi_if, msg->msg, msg->get_tailroom());
+      if (len <= 0) {
+        if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+          m_spgw_log->error("Worker %d: error reading from TUN interface: %s\n", m_id, strerror(errno));
+        }
+        break;
+      }
+      msg->N_bytes = len;
+      queue_s1u(ip_map, msg);
+      n++;
+    }
+    flush_s1u();
+
+    if (n < SPGW_BATCH_LEN) {
+      return;
+    }
+  }
+}
+
+/* Uplink from the S1-U ring. The GTP-U payload is parsed in place in the RX
+ * frame and goes to the TUN queue (or, for hairpinned traffic, into a TX
+ * frame) without passing through a pool buffer.
+ */
+void
+spgw_worker::handle_ring_s1u()
+{
+  const spgw_ip_map_t *ip_map = m_parent->get_ip_map();
+  uint32_t len;
+  uint8_t *frame;
+
+  for (uint32_t n = 0; n < SPGW_BATCH_LEN * SPGW_MAX_BATCHES && (frame = m_ring->rx_next(&len)); n++) {
+    if (len < SPGW_RING_ETH_LEN + sizeof(struct iphdr)) {
+      continue;
+    }
+    struct iphdr *outer = (struct iphdr *) (frame + SPGW_RING_ETH_LEN);
+    uint32_t udp_off = SPGW_RING_ETH_LEN + 4 * outer->ihl;
+    if (len < udp_off + sizeof(struct udphdr)) {
+      continue;
+    }
+    struct udphdr *udp = (struct udphdr *) (frame + udp_off);
+    uint32_t udp_len = std::min((uint32_t) ntohs(udp->len), len - udp_off);
+    if (udp_len < sizeof(struct udphdr)) {
+      continue;
+    }
+
+    // The eNB's MAC, for traffic towards it
+    m_ring->learn_neighbour(outer->saddr, frame + 6);
+
+    srslte::gtpu_header_t header;
+    m_view->msg     = (uint8_t *) udp + sizeof(struct udphdr);
+    m_view->N_bytes = udp_len - sizeof(struct udphdr);
+    if (!srslte::gtpu_read_header(m_view, &header, m_spgw_log)) {
+      continue;
+    }
+    if (header.message_type == GTPU_MSG_ECHO_REQUEST) {
+      srslte::byte_buffer_t *msg = get_tx_buffer();
+      if (srslte::gtpu_write_echo_response(&header, msg, m_spgw_log)) {
+        sockaddr_in addr;
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = udp->source;
+        addr.sin_addr.s_addr = outer->saddr;
+        queue_tx(msg, &addr);
+      }
+      continue;
+    }
+    if (header.message_type != GTPU_MSG_DATA_PDU || m_view->N_bytes < sizeof(struct iphdr)) {
+      continue;
+    }
+
+    struct iphdr *iph = (struct iphdr *) m_view->msg;
+    const srslte::gtpc_f_teid_ie *enb_fteid = ip_map->find(iph->daddr);
+    if (enb_fteid) {
+      send_ring(ip_map, enb_fteid, m_view->msg, m_view->N_bytes);
+    } else if (write(m_sgi_if, m_view->msg, m_view->N_bytes) < 0) {
+      m_spgw_log->debug("Worker %d: could not write to TUN interface: %s\n", m_id, strerror(errno));
+    }
+  }
+  m_ring->tx_flush();
+  flush_s1u();
+}
+
+/* Downlink to the S1-U ring. Packets are read from the TUN queue straight
+ * into a TX frame, behind room for the outer headers.
+ */
+void
+spgw_worker::handle_ring_sgi()
+{
+  const spgw_ip_map_t *ip_map = m_parent->get_ip_map();
+
+  for (uint32_t n = 0; n < SPGW_BATCH_LEN * SPGW_MAX_BATCHES; n++) {
+    uint32_t max_len;
+    uint8_t *payload = m_ring->tx_payload(&max_len);
+    if (!payload) {
+      // Ring full, let the socket path take this batch
+      m_ring->tx_flush();
+      flush_s1u();
+      handle_sgi();
+      return;
+    }
+    int len = read(m_sgi_if, payload, max_len);
+    if (len <= 0) {
+      if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        m_spgw_log->error("Worker %d: error reading from TUN interface: %s\n", m_id, strerror(errno));
+      }
+      break;
+    }
+    struct iphdr *iph = (struct iphdr *) payload;
+    if ((uint32_t) len < sizeof(struct iphdr) || iph->version != 4) {
+      continue;
+    }
+    const srslte::gtpc_f_teid_ie *enb_fteid = ip_map->find(iph->daddr);
+    if (!enb_fteid) {
+      m_spgw_log->debug("IP Packet is not for any UE\n");
+      continue;
+    }
+    const spgw_eth_addr_t *mac = m_ring->get_neighbour(enb_fteid->ipv4);
+    if (mac) {
+      m_ring->tx_commit(enb_fteid->ipv4, mac, srslte::gtpu_tpdu_template(enb_fteid->teid), len);
+    } else {
+      send_ring(ip_map, enb_fteid, payload, len);
+    }
+    if ((n + 1) % SPGW_BATCH_LEN == 0) {
+      m_ring->tx_flush();
+    }
+  }
+  m_ring->tx_flush();
+  flush_s1u();
+}
+
+/* Copies an IP packet into a TX frame for the eNB. eNBs we have not heard
+ * from yet have no known MAC; those packets go through the socket so the
+ * kernel resolves the address.
+ */
+void
+spgw_worker::send_ring(const spgw_ip_map_t *ip_map, const srslte::gtpc_f_teid_ie *enb_fteid, const uint8_t *payload, uint32_t len)
+{
+  const spgw_eth_addr_t *mac = m_ring->get_neighbour(enb_fteid->ipv4);
+  uint32_t max_len = 0;
+  uint8_t *frame   = mac ? m_ring->tx_payload(&max_len) : NULL;
+  if (frame && len <= max_len) {
+    memcpy(frame, payload, len);
+    m_ring->tx_commit(enb_fteid->ipv4, mac, srslte::gtpu_tpdu_template(enb_fteid->teid), len);
+    return;
+  }
+  srslte::byte_buffer_t *msg = get_tx_buffer();
+  if (len > msg->get_tailroom()) {
+    return;
+  }
+  memcpy(msg->msg, payload, len);
+  msg->N_bytes = len;
+  queue_s1u(ip_map, msg);
+}
+
+// A free buffer for the socket TX batch, in ring mode where m_buf is not used for reception
+srslte::byte_buffer_t*
+spgw_worker::get_tx_buffer()
+{
+  if (m_nof_tx == SPGW_BATCH_LEN) {
+    flush_s1u();
+  }
+  m_buf[m_nof_tx]->reset();
+  return m_buf[m_nof_tx];
+}
+
+// Adds the GTP-U header and queues the PDU for the UE's eNB. msg must stay valid until flush_s1u()
+void
+spgw_worker::queue_s1u(const spgw_ip_map_t *ip_map, srslte::byte_buffer_t *msg)
+{
+  struct iphdr *iph = (struct iphdr *) msg->msg;
+  if (msg->N_bytes < sizeof(struct iphdr) || iph->version != 4) {
+    m_spgw_log->debug("Worker %d: dropping non-IPv4 packet\n", m_id);
+    return;
+  }
+  if (ntohs(iph->tot_len) < 20) {
+    m_spgw_log->warning("Invalid IP header length.\n");
+    return;
+  }
+
+  const srslte::gtpc_f_teid_ie *enb_fteid = ip_map->find(iph->daddr);
+  if (!enb_fteid) {
+    m_spgw_log->debug("IP Packet is not for any UE\n");
+    return;
+  }
+
+  if (!srslte::gtpu_write_tpdu(srslte::gtpu_tpdu_template(enb_fteid->teid), msg)) {
+    m_spgw_log->error("Worker %d: could not write GTP-U header\n", m_id);
+    return;
+  }
+
+  sockaddr_in addr;
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(GTPU_RX_PORT);
+  addr.sin_addr.s_addr = enb_fteid->ipv4;
+  queue_tx(msg, &addr);
+}
+
+void
+spgw_worker::queue_tx(srslte::byte_buffer_t *msg, const sockaddr_in *addr)
+{
+  m_tx_addr[m_nof_tx] = *addr;
+  m_tx_iov[m_nof_tx].iov_base = msg->msg;
+  m_tx_iov[m_nof_tx].iov_len  = msg->N_bytes;
+  m_nof_tx++;
+}
+
+void
+spgw_worker::flush_s1u()
+{
+  uint32_t sent = 0;
+  while (sent < m_nof_tx) {
+    int n = sendmmsg(m_s1u, &m_tx_msgs[sent], m_nof_tx - sent, 0);
+    if (n <= 0) {
+      if (errno != EINTR) {
+        m_spgw_log->error("Worker %d: error sending %d packets to eNB: %s\n", m_id, m_nof_tx - sent, strerror(errno));
+        break;
+      }
+      continue;
+    }
+    sent += n;
+  }
+  m_nof_tx = 0;
+}
+
+} //namespace srsepc
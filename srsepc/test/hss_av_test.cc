@@ -0,0 +1,232 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        hss_av_test.cc
+ * Description: Attach-equivalent load on the HSS. Every UE of a generated
+ *              user database asks for an Authentication Information Answer
+ *              once per round, as the MME does on each attach. Each answer
+ *              is checked against Milenage f1/f2345 and K_ASME computed
+ *              from scratch, and the SQN must increase for every UE. Runs
+ *              with the vector pool disabled and with av_pool_size vectors
+ *              per UE, and reports the CPU time spent by the caller (the
+ *              S1AP worker) per answer.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <vector>
+#include "srsepc/hdr/hss/hss.h"
+#include "srslte/common/logger_stdout.h"
+#include "srslte/common/security.h"
+
+#define IMSI_BASE 1010123456000ULL
+#define MCC       0xf001
+#define MNC       0xff01
+
+using namespace srsepc;
+using namespace srslte;
+
+uint32_t    nof_ues      = 1000;
+uint32_t    nof_rounds   = 10;
+uint32_t    av_pool_size = 16;
+std::string db_file      = "/tmp/hss_av_test.csv";
+
+uint8_t key[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+uint8_t opc[16] = {0x63, 0xbf, 0xa5, 0x0e, 0xe6, 0x52, 0x33, 0x65, 0xff, 0x14, 0xc1, 0xf4, 0x5f, 0x88, 0x73, 0x7d};
+
+void usage(char *prog)
+{
+  printf("Usage: %s [urpd]\n", prog);
+  printf("\t-u Number of UEs [Default %d]\n", nof_ues);
+  printf("\t-r Number of attach rounds [Default %d]\n", nof_rounds);
+  printf("\t-p Vectors pooled per UE, 0 only runs without the pool [Default %d]\n", av_pool_size);
+  printf("\t-d User database written for the test [Default %s]\n", db_file.c_str());
+}
+
+void parse_args(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "urpd")) != -1) {
+    switch (opt) {
+    case 'u':
+      nof_ues = atoi(argv[optind]);
+      break;
+    case 'r':
+      nof_rounds = atoi(argv[optind]);
+      break;
+    case 'p':
+      av_pool_size = atoi(argv[optind]);
+      break;
+    case 'd':
+      db_file = argv[optind];
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (nof_ues < 1 || nof_rounds < 1) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+static double thread_cpu_time()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static double now()
+{
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+static bool write_db()
+{
+  FILE *f = fopen(db_file.c_str(), "w");
+  if (f == NULL) {
+    return false;
+  }
+  for (uint32_t i = 0; i < nof_ues; i++) {
+    fprintf(f, "ue%d,%015llu,00112233445566778899aabbccddeeff,opc,63bfa50ee6523365ff14c1f45f88737d,8000,000000001000,7\n",
+            i, IMSI_BASE + i);
+  }
+  fclose(f);
+  // Otherwise a store left from an earlier run would be used
+  unlink((db_file + ".db").c_str());
+  return true;
+}
+
+// Recomputes the answer from K and OPc and returns the SQN it carries
+static bool check_answer(uint8_t *k_asme, uint8_t *autn, uint8_t *rand, uint8_t *xres, uint64_t *sqn_out)
+{
+  uint8_t res[8], ck[16], ik[16], ak[6], mac[8], sqn[6], k_asme_ref[32];
+
+  security_milenage_f2345(key, opc, rand, res, ck, ik, ak);
+  uint64_t s = 0;
+  for (int i = 0; i < 6; i++) {
+    sqn[i] = autn[i] ^ ak[i];
+    s = (s << 8) | sqn[i];
+  }
+  security_milenage_f1(key, opc, rand, sqn, &autn[6], mac);
+  security_generate_k_asme(ck, ik, ak, sqn, MCC, MNC, k_asme_ref);
+  *sqn_out = s;
+  return !memcmp(res, xres, 8) && !memcmp(mac, &autn[8], 8) && !memcmp(k_asme_ref, k_asme, 32);
+}
+
+static bool run(uint32_t pool_size, srslte::log_filter *hss_log)
+{
+  if (!write_db()) {
+    printf("Could not write %s\n", db_file.c_str());
+    return false;
+  }
+  hss_args_t args;
+  args.auth_algo    = "milenage";
+  args.db_file      = db_file;
+  args.mcc          = MCC;
+  args.mnc          = MNC;
+  args.av_pool_size = pool_size;
+
+  hss *h = hss::get_instance();
+  if (h->init(&args, hss_log)) {
+    printf("Could not start the HSS\n");
+    hss::cleanup();
+    return false;
+  }
+
+  std::vector<uint64_t> last_sqn(nof_ues, 0);
+  uint32_t nof_bad = 0;
+  uint32_t nof_answers = 0;
+  double   cpu = 0, t0 = 0;
+
+  // Round 0 makes the UE contexts and starts the pools, it is not timed
+  for (uint32_t r = 0; r <= nof_rounds; r++) {
+    if (r == 1) {
+      // Let the generator fill the pools, as between attaches of a real UE
+      usleep(pool_size > 0 ? 200000 : 0);
+      t0 = now();
+    }
+    for (uint32_t i = 0; i < nof_ues; i++) {
+      uint8_t  k_asme[32], autn[16], rand[16], xres[16];
+      uint64_t sqn;
+      double   c0 = thread_cpu_time();
+      if (!h->gen_auth_info_answer(IMSI_BASE + i, k_asme, autn, rand, xres)) {
+        printf("No answer for IMSI %015llu\n", IMSI_BASE + i);
+        nof_bad++;
+        continue;
+      }
+      if (r > 0) {
+        cpu += thread_cpu_time() - c0;
+        nof_answers++;
+      }
+      if (!check_answer(k_asme, autn, rand, xres, &sqn) || sqn <= last_sqn[i]) {
+        nof_bad++;
+      }
+      last_sqn[i] = sqn;
+    }
+  }
+  double elapsed = now() - t0;
+  printf("av_pool_size=%-3d %d UEs x %d rounds: %.0f answers/s, %.2f us of caller CPU per answer, %d wrong\n",
+         pool_size, nof_ues, nof_rounds, nof_answers / elapsed, cpu * 1e6 / nof_answers, nof_bad);
+
+  h->stop();
+  hss::cleanup();
+  unlink(db_file.c_str());
+  unlink((db_file + ".db").c_str());
+  return nof_bad == 0;
+}
+
+int main(int argc, char **argv)
+{
+  parse_args(argc, argv);
+
+  srslte::logger_stdout logger;
+  srslte::log_filter    hss_log;
+  hss_log.init("HSS ", &logger);
+  hss_log.set_level(srslte::LOG_LEVEL_ERROR);
+
+  bool ok = run(0, &hss_log);
+  if (av_pool_size > 0) {
+    ok = run(av_pool_size, &hss_log) && ok;
+  }
+
+  if (ok) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
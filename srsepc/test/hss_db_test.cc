@@ -0,0 +1,258 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        hss_db_test.cc
+ * Description: Subscriber store: create, add, reopen and look up, refuse
+ *              stores with a corrupt header, and re-import a .csv without
+ *              rewinding SQNs already in the store.
+ *****************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "srsepc/hdr/hss/hss_db.h"
+#include "srslte/common/log_filter.h"
+#include "srslte/common/logger_stdout.h"
+
+#define NOF_UES   1000
+#define IMSI_BASE 1010123456000ULL
+
+using namespace srsepc;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FUNCTION__, __LINE__, #cond); return false; } } while (0)
+
+std::string path = "/tmp/hss_db_test.db";
+
+static void make_record(uint64_t imsi, hss_db_record_t *record)
+{
+  bzero(record, sizeof(hss_db_record_t));
+  record->imsi = imsi;
+  snprintf(record->name, HSS_DB_NAME_LEN, "ue%d", (int) (imsi - IMSI_BASE));
+  for (int i = 0; i < 16; i++) {
+    record->key[i] = (uint8_t) (imsi + i);
+    record->opc[i] = (uint8_t) (imsi * 3 + i);
+  }
+  record->amf[0] = 0x80;
+  record->sqn[5] = (uint8_t) imsi;
+  record->qci    = 7;
+}
+
+bool create_and_lookup()
+{
+  hss_db db;
+  CHECK(db.create(path, NOF_UES));
+  for (uint32_t i = 0; i < NOF_UES; i++) {
+    hss_db_record_t record;
+    make_record(IMSI_BASE + i, &record);
+    CHECK(db.add(record));
+  }
+  hss_db_record_t record;
+  make_record(IMSI_BASE, &record);
+  CHECK(!db.add(record));     // duplicate
+  make_record(IMSI_BASE + NOF_UES, &record);
+  CHECK(!db.add(record));     // full
+  CHECK(db.size() == NOF_UES);
+
+  // Stepped SQNs go through sync and must survive the reopen
+  hss_db_record_t *rec = db.find(IMSI_BASE + 10);
+  CHECK(rec != NULL);
+  rec->sqn[0] = 0x12;
+  CHECK(db.sync(rec));
+  db.close();
+
+  CHECK(db.open(path));
+  CHECK(db.size() == NOF_UES);
+  for (uint32_t i = 0; i < NOF_UES; i++) {
+    make_record(IMSI_BASE + i, &record);
+    if (i == 10) {
+      record.sqn[0] = 0x12;
+    }
+    rec = db.find(IMSI_BASE + i);
+    CHECK(rec != NULL);
+    CHECK(!memcmp(rec, &record, sizeof(record)));
+  }
+  CHECK(db.find(IMSI_BASE + NOF_UES) == NULL);
+  CHECK(db.find(0) == NULL);
+  return true;
+}
+
+// Rewrites one header field of the store at path and checks open() refuses it
+static bool corrupt_and_open(size_t offset, const void *value, size_t len)
+{
+  hss_db_header_t saved;
+  int fd = open(path.c_str(), O_RDWR);
+  CHECK(fd >= 0);
+  CHECK(pread(fd, &saved, sizeof(saved), 0) == sizeof(saved));
+  CHECK(pwrite(fd, value, len, offset) == (ssize_t) len);
+
+  hss_db db;
+  bool opened = db.open(path);
+  db.close();
+
+  CHECK(pwrite(fd, &saved, sizeof(saved), 0) == sizeof(saved));
+  close(fd);
+  CHECK(!opened);
+  return true;
+}
+
+bool corrupt_header()
+{
+  hss_db_header_t header;
+  int fd = open(path.c_str(), O_RDONLY);
+  CHECK(fd >= 0);
+  CHECK(pread(fd, &header, sizeof(header), 0) == sizeof(header));
+  close(fd);
+
+  uint32_t v;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, magic), "SRSHSSDX", 8));
+  v = HSS_DB_VERSION + 1;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, version), &v, 4));
+  v = header.record_size / 2;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, record_size), &v, 4));
+  v = header.index_size - 1;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, index_size), &v, 4));
+  v = 0;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, index_size), &v, 4));
+  v = header.max_records + 1;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, nof_records), &v, 4));
+  v = header.index_size;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, max_records), &v, 4));
+  v = header.records_offset;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, index_offset), &v, 4));
+  v = 0;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, index_offset), &v, 4));
+  v = header.records_offset + 128 * 1024 * 1024;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, records_offset), &v, 4));
+  v = 0xffffffff;
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, records_offset), &v, 4));
+
+  // Records off the page boundary, with the file grown so they still fit
+  struct stat st;
+  CHECK(stat(path.c_str(), &st) == 0);
+  CHECK(truncate(path.c_str(), st.st_size + sysconf(_SC_PAGESIZE)) == 0);
+  v = header.records_offset + sizeof(uint64_t);
+  CHECK(corrupt_and_open(offsetof(hss_db_header_t, records_offset), &v, 4));
+  CHECK(truncate(path.c_str(), st.st_size) == 0);
+
+  // Records cut off at the end of the file
+  CHECK(truncate(path.c_str(), st.st_size - sizeof(hss_db_record_t)) == 0);
+  hss_db db;
+  CHECK(!db.open(path));
+  CHECK(truncate(path.c_str(), st.st_size) == 0);
+
+  // Headers restored, so it opens again
+  CHECK(db.open(path));
+  CHECK(db.find(IMSI_BASE) != NULL);
+  return true;
+}
+
+static bool write_csv(const std::string &csv_path, const char *sqn)
+{
+  FILE *f = fopen(csv_path.c_str(), "w");
+  CHECK(f != NULL);
+  fprintf(f, "# test\n");
+  fprintf(f, "ue1,001010123456789,00112233445566778899aabbccddeeff,opc,63bfa50ee6523365ff14c1f45f88737d,9001,%s,9\n", sqn);
+  fprintf(f, "ue2,001010123456780,00112233445566778899aabbccddeeff,opc,63bfa50ee6523365ff14c1f45f88737d,9001,%s,7\n", sqn);
+  fclose(f);
+  return true;
+}
+
+bool reimport_keeps_sqn(srslte::log *log)
+{
+  std::string csv_path = path + ".csv";
+  uint8_t     sqn_csv[6]   = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00};
+  uint8_t     sqn_ahead[6] = {0x00, 0x00, 0x01, 0x00, 0x00, 0x20};
+  uint8_t     sqn_newer[6] = {0x00, 0x00, 0x02, 0x00, 0x00, 0x00};
+
+  hss_db db;
+  CHECK(write_csv(csv_path, "000000001000"));
+  CHECK(db.import_csv(csv_path, path, log));
+  CHECK(db.size() == 2);
+  hss_db_record_t *rec = db.find(1010123456789ULL);
+  CHECK(rec != NULL && rec->qci == 9 && !memcmp(rec->sqn, sqn_csv, 6));
+
+  // UE 1 attached meanwhile, the edited .csv still has the old SQN
+  memcpy(rec->sqn, sqn_ahead, 6);
+  CHECK(db.sync(rec));
+  db.close();
+  CHECK(write_csv(csv_path, "000000001000"));
+  CHECK(db.import_csv(csv_path, path, log));
+  rec = db.find(1010123456789ULL);
+  CHECK(rec != NULL && !memcmp(rec->sqn, sqn_ahead, 6));
+  rec = db.find(1010123456780ULL);
+  CHECK(rec != NULL && !memcmp(rec->sqn, sqn_csv, 6));
+
+  // An SQN raised in the .csv wins
+  db.close();
+  CHECK(write_csv(csv_path, "000002000000"));
+  CHECK(db.import_csv(csv_path, path, log));
+  rec = db.find(1010123456789ULL);
+  CHECK(rec != NULL && !memcmp(rec->sqn, sqn_newer, 6));
+
+  // A failed import leaves the store as it was
+  db.close();
+  FILE *f = fopen(csv_path.c_str(), "a");
+  CHECK(f != NULL);
+  fprintf(f, "ue3,001010123456780,00112233445566778899aabbccddeeff,opc,63bfa50ee6523365ff14c1f45f88737d,9001,000000000000,7\n");
+  fclose(f);
+  CHECK(!db.import_csv(csv_path, path, log));
+  CHECK(db.open(path));
+  CHECK(db.size() == 2);
+  CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+  db.close();
+
+  unlink(csv_path.c_str());
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1) {
+    path = argv[1];
+  }
+  srslte::logger_stdout logger;
+  srslte::log_filter    log;
+  log.init("HSS ", &logger);
+  log.set_level(srslte::LOG_LEVEL_NONE);
+
+  bool ok = create_and_lookup();
+  ok = ok && corrupt_header();
+  ok = ok && reimport_keeps_sqn(&log);
+  unlink(path.c_str());
+
+  if (ok) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
@@ -0,0 +1,478 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2017 Software Radio Systems Limited
+ *
+ * \section LICENSE
+ *
+ * This file is part of srsLTE.
+ *
+ * srsLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * srsLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/******************************************************************************
+ * File:        spgw_fwd_test.cc
+ * Description: Runs the SP-GW user plane with nof_workers workers and checks
+ *              forwarding end to end: downlink from a socket on the SGi
+ *              side through the TUN device to an emulated eNB, uplink back,
+ *              and that a deleted bearer is no longer forwarded. Then
+ *              measures downlink and uplink throughput, spread over many
+ *              UEs so TEID sharding uses every worker. Creating the TUN
+ *              device needs CAP_NET_ADMIN; without it the test is skipped.
+ *              With -N the eNB socket lives in that network namespace, so
+ *              S1-U crosses a real link (see spgw_veth_test.sh) and the
+ *              packet_mmap backend (-b) can be compared with the socket one.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+#include "srsepc/hdr/spgw/spgw.h"
+#include "srsepc/hdr/mme/mme_gtpc.h"
+
+#define SGI_PORT      5000
+#define UE_PORT       5001
+#define ENB_TEID_BASE 0x1000
+#define MAX_UES       1024
+#define MAX_PKT_LEN   1500
+
+using namespace srsepc;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FUNCTION__, __LINE__, #cond); return false; } } while (0)
+
+uint32_t    nof_workers = 1;
+uint32_t    nof_ues     = 16;
+uint32_t    nof_pkts    = 200000;
+uint32_t    pkt_len     = 1000;
+std::string gtpu_addr   = "127.0.1.1";
+std::string enb_addr    = "127.0.1.2";
+std::string sgi_addr    = "172.31.250.1";
+std::string backend     = "socket";
+std::string s1u_if      = "";
+std::string enb_netns   = "";
+
+// What the S-GW gave each UE
+struct ue_t {
+  in_addr_t ue_ipv4;
+  uint32_t  sgw_ctrl_teid;
+  uint32_t  sgw_user_teid;
+  uint32_t  enb_teid;
+};
+ue_t     ues[MAX_UES];
+uint32_t nof_created = 0;
+
+/* The test stands in for the MME. The S-GW only calls these two, so the
+ * MME itself does not need to be linked.
+ */
+static char mme_gtpc_stub;
+
+mme_gtpc* mme_gtpc::get_instance(void)
+{
+  return (mme_gtpc*) &mme_gtpc_stub;
+}
+
+void mme_gtpc::handle_create_session_response(srslte::gtpc_pdu *cs_resp_pdu)
+{
+  srslte::gtpc_create_session_response *cs_resp = &cs_resp_pdu->choice.create_session_response;
+  ue_t *ue = &ues[nof_created++];
+  ue->ue_ipv4       = cs_resp->paa.ipv4;
+  ue->sgw_ctrl_teid = cs_resp->sender_f_teid.teid;
+  ue->sgw_user_teid = cs_resp->eps_bearer_context_created.s1_u_sgw_f_teid.teid;
+}
+
+void usage(char *prog)
+{
+  printf("Usage: %s [wunsaegbiN]\n", prog);
+  printf("\t-w Number of SP-GW workers [Default %d]\n", nof_workers);
+  printf("\t-u Number of UEs [Default %d]\n", nof_ues);
+  printf("\t-n Number of packets per direction in the benchmark, 0 to skip it [Default %d]\n", nof_pkts);
+  printf("\t-s UDP payload length [Default %d]\n", pkt_len);
+  printf("\t-a S-GW S1-U address [Default %s]\n", gtpu_addr.c_str());
+  printf("\t-e eNB address [Default %s]\n", enb_addr.c_str());
+  printf("\t-g SGi interface address [Default %s]\n", sgi_addr.c_str());
+  printf("\t-b S1-U backend, socket or packet_mmap [Default %s]\n", backend.c_str());
+  printf("\t-i S1-U interface, for packet_mmap [Default none]\n");
+  printf("\t-N Network namespace of the eNB [Default none]\n");
+}
+
+void parse_args(int argc, char **argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "wunsaegbiN")) != -1) {
+    switch (opt) {
+    case 'w':
+      nof_workers = atoi(argv[optind]);
+      break;
+    case 'u':
+      nof_ues = atoi(argv[optind]);
+      break;
+    case 'n':
+      nof_pkts = atoi(argv[optind]);
+      break;
+    case 's':
+      pkt_len = atoi(argv[optind]);
+      break;
+    case 'a':
+      gtpu_addr = argv[optind];
+      break;
+    case 'e':
+      enb_addr = argv[optind];
+      break;
+    case 'g':
+      sgi_addr = argv[optind];
+      break;
+    case 'b':
+      backend = argv[optind];
+      break;
+    case 'i':
+      s1u_if = argv[optind];
+      break;
+    case 'N':
+      enb_netns = argv[optind];
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+  if (nof_ues < 1 || nof_ues > MAX_UES || pkt_len < 8 || pkt_len > MAX_PKT_LEN - 64) {
+    usage(argv[0]);
+    exit(-1);
+  }
+}
+
+static double now()
+{
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec + t.tv_usec*1e-6;
+}
+
+static int udp_socket(const char *addr, uint16_t port)
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct sockaddr_in sa;
+  bzero(&sa, sizeof(sa));
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = inet_addr(addr);
+  sa.sin_port        = htons(port);
+  int size = 8*1024*1024;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size));
+  struct timeval timeout = {1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  if (bind(fd, (struct sockaddr*) &sa, sizeof(sa))) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Opens the eNB socket inside enb_netns. Sockets stay in the namespace they were created in
+static int enb_socket()
+{
+  if (enb_netns.empty()) {
+    return udp_socket(enb_addr.c_str(), GTPU_RX_PORT);
+  }
+  int self = open("/proc/self/ns/net", O_RDONLY);
+  int ns   = open(("/var/run/netns/" + enb_netns).c_str(), O_RDONLY);
+  int fd   = -1;
+  if (self >= 0 && ns >= 0 && setns(ns, CLONE_NEWNET) == 0) {
+    fd = udp_socket(enb_addr.c_str(), GTPU_RX_PORT);
+    if (setns(self, CLONE_NEWNET)) {
+      printf("Could not return to the initial network namespace\n");
+      exit(1);
+    }
+  }
+  if (self >= 0) {
+    close(self);
+  }
+  if (ns >= 0) {
+    close(ns);
+  }
+  return fd;
+}
+
+static uint16_t ip_checksum(const uint8_t *hdr, uint32_t len)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < len; i += 2) {
+    sum += (hdr[i] << 8) | hdr[i + 1];
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return htons(~sum);
+}
+
+// GTP-U T-PDU carrying a UDP packet from the UE to the SGi socket
+static uint32_t build_uplink(uint8_t *pdu, const ue_t *ue, uint32_t seq)
+{
+  uint32_t       ip_len = sizeof(struct iphdr) + sizeof(struct udphdr) + pkt_len;
+  struct iphdr  *iph    = (struct iphdr*) &pdu[8];
+  struct udphdr *udp    = (struct udphdr*) (iph + 1);
+  uint8_t       *data   = (uint8_t*) (udp + 1);
+
+  pdu[0] = 0x30;
+  pdu[1] = 0xFF;
+  pdu[2] = ip_len >> 8;
+  pdu[3] = ip_len & 0xff;
+  uint32_t teid = htonl(ue->sgw_user_teid);
+  memcpy(&pdu[4], &teid, 4);
+
+  bzero(iph, sizeof(struct iphdr));
+  iph->version  = 4;
+  iph->ihl      = 5;
+  iph->tot_len  = htons(ip_len);
+  iph->ttl      = 64;
+  iph->protocol = IPPROTO_UDP;
+  iph->saddr    = ue->ue_ipv4;
+  iph->daddr    = inet_addr(sgi_addr.c_str());
+  iph->check    = ip_checksum((uint8_t*) iph, sizeof(struct iphdr));
+  udp->source   = htons(UE_PORT);
+  udp->dest     = htons(SGI_PORT);
+  udp->len      = htons(sizeof(struct udphdr) + pkt_len);
+  udp->check    = 0;
+  memset(data, 0, pkt_len);
+  memcpy(data, &seq, sizeof(seq));
+  return 8 + ip_len;
+}
+
+static void send_downlink(int sgi_sock, const ue_t *ue, uint32_t seq)
+{
+  uint8_t data[MAX_PKT_LEN];
+  memset(data, 0, pkt_len);
+  memcpy(data, &seq, sizeof(seq));
+  struct sockaddr_in sa;
+  bzero(&sa, sizeof(sa));
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = ue->ue_ipv4;
+  sa.sin_port        = htons(UE_PORT);
+  sendto(sgi_sock, data, pkt_len, 0, (struct sockaddr*) &sa, sizeof(sa));
+}
+
+static void send_uplink(int enb_sock, const ue_t *ue, uint32_t seq)
+{
+  uint8_t pdu[MAX_PKT_LEN];
+  uint32_t len = build_uplink(pdu, ue, seq);
+  struct sockaddr_in sa;
+  bzero(&sa, sizeof(sa));
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = inet_addr(gtpu_addr.c_str());
+  sa.sin_port        = htons(GTPU_RX_PORT);
+  sendto(enb_sock, pdu, len, 0, (struct sockaddr*) &sa, sizeof(sa));
+}
+
+// Receives one downlink GTP-U PDU at the eNB, returns the UE or -1
+static int recv_downlink(int enb_sock, uint32_t *seq)
+{
+  uint8_t pdu[MAX_PKT_LEN];
+  ssize_t len = recv(enb_sock, pdu, sizeof(pdu), 0);
+  if (len < (ssize_t) (8 + sizeof(struct iphdr) + sizeof(struct udphdr) + sizeof(uint32_t)) ||
+      pdu[0] != 0x30 || pdu[1] != 0xFF) {
+    return -1;
+  }
+  uint32_t teid;
+  memcpy(&teid, &pdu[4], 4);
+  teid = ntohl(teid);
+  struct iphdr *iph = (struct iphdr*) &pdu[8];
+  memcpy(seq, &pdu[8 + 4*iph->ihl + sizeof(struct udphdr)], sizeof(*seq));
+  for (uint32_t i = 0; i < nof_created; i++) {
+    if (ues[i].enb_teid == teid) {
+      return iph->daddr == ues[i].ue_ipv4 ? (int) i : -1;
+    }
+  }
+  return -1;
+}
+
+bool attach_ues(spgw *gw)
+{
+  double t0 = now();
+  for (uint32_t i = 0; i < nof_ues; i++) {
+    srslte::gtpc_create_session_request cs_req;
+    srslte::gtpc_pdu                    cs_resp_pdu;
+    bzero(&cs_req, sizeof(cs_req));
+    cs_req.imsi               = 1010123456789ULL + i;
+    cs_req.sender_f_teid.teid = i + 1;
+    gw->handle_create_session_request(&cs_req, &cs_resp_pdu);
+    CHECK(nof_created == i + 1);
+
+    srslte::gtpc_pdu mb_req_pdu, mb_resp_pdu;
+    bzero(&mb_req_pdu, sizeof(mb_req_pdu));
+    srslte::gtpc_modify_bearer_request *mb_req = &mb_req_pdu.choice.modify_bearer_request;
+    ues[i].enb_teid        = ENB_TEID_BASE + i;
+    mb_req_pdu.header.teid = ues[i].sgw_ctrl_teid;
+    mb_req->eps_bearer_context_to_modify.s1_u_enb_f_teid.teid = ues[i].enb_teid;
+    mb_req->eps_bearer_context_to_modify.s1_u_enb_f_teid.ipv4 = inet_addr(enb_addr.c_str());
+    gw->handle_modify_bearer_request(&mb_req_pdu, &mb_resp_pdu);
+  }
+  printf("attach: %d UEs, %.1f us per session\n", nof_ues, 1e6*(now() - t0)/nof_ues);
+  return true;
+}
+
+// One packet each way per UE, then no downlink for a detached UE
+bool forwarding(spgw *gw, int sgi_sock, int enb_sock)
+{
+  uint8_t  buf[MAX_PKT_LEN];
+  uint32_t seq;
+
+  for (uint32_t i = 0; i < nof_ues; i++) {
+    send_downlink(sgi_sock, &ues[i], i);
+    CHECK(recv_downlink(enb_sock, &seq) == (int) i && seq == i);
+
+    send_uplink(enb_sock, &ues[i], i);
+    struct sockaddr_in from;
+    socklen_t          from_len = sizeof(from);
+    ssize_t            len      = recvfrom(sgi_sock, buf, sizeof(buf), 0, (struct sockaddr*) &from, &from_len);
+    CHECK(len == (ssize_t) pkt_len && from.sin_addr.s_addr == ues[i].ue_ipv4);
+    memcpy(&seq, buf, sizeof(seq));
+    CHECK(seq == i);
+  }
+
+  // Two bearer changes in a row: the second one waits for the workers
+  srslte::gtpc_pdu del_req_pdu, del_resp_pdu;
+  bzero(&del_req_pdu, sizeof(del_req_pdu));
+  del_req_pdu.header.teid = ues[0].sgw_ctrl_teid;
+  gw->handle_delete_session_request(&del_req_pdu, &del_resp_pdu);
+  if (nof_ues > 1) {
+    del_req_pdu.header.teid = ues[1].sgw_ctrl_teid;
+    gw->handle_delete_session_request(&del_req_pdu, &del_resp_pdu);
+  }
+  for (uint32_t i = 0; i < nof_ues; i++) {
+    send_downlink(sgi_sock, &ues[i], i);
+  }
+  // Workers may deliver out of order
+  std::vector<bool> seen(nof_ues, false);
+  for (uint32_t i = 2; i < nof_ues; i++) {
+    int ue = recv_downlink(enb_sock, &seq);
+    CHECK(ue >= 2 && !seen[ue]);
+    seen[ue] = true;
+  }
+  CHECK(recv(enb_sock, buf, sizeof(buf), MSG_DONTWAIT) < 0);
+  return true;
+}
+
+struct sender_args_t {
+  int  sock;
+  bool downlink;
+};
+
+void* sender(void *a)
+{
+  sender_args_t *args = (sender_args_t*) a;
+  for (uint32_t n = 0; n < nof_pkts; n++) {
+    const ue_t *ue = &ues[2 + n % (nof_ues - 2)];
+    if (args->downlink) {
+      send_downlink(args->sock, ue, n);
+    } else {
+      send_uplink(args->sock, ue, n);
+    }
+  }
+  return NULL;
+}
+
+// Sends nof_pkts packets one way as fast as possible and counts what arrives
+void bench(int sgi_sock, int enb_sock, bool downlink)
+{
+  uint8_t       buf[MAX_PKT_LEN];
+  sender_args_t args;
+  pthread_t     tid;
+  args.sock     = downlink ? sgi_sock : enb_sock;
+  args.downlink = downlink;
+  int rx_sock   = downlink ? enb_sock : sgi_sock;
+
+  double   t0 = now(), t_last = t0;
+  uint32_t received = 0;
+  pthread_create(&tid, NULL, sender, &args);
+  while (received < nof_pkts && recv(rx_sock, buf, sizeof(buf), 0) > 0) {
+    received++;
+    t_last = now();
+  }
+  pthread_join(tid, NULL);
+  double elapsed = t_last - t0;
+  printf("%-8s %s workers=%d ues=%d: %d/%d packets, %.1f kpps, %.1f Mbps\n",
+         downlink ? "downlink" : "uplink", backend.c_str(), nof_workers, nof_ues - 2, received, nof_pkts,
+         received/elapsed/1e3, 8.0*received*pkt_len/elapsed/1e6);
+}
+
+int main(int argc, char **argv)
+{
+  parse_args(argc, argv);
+  if (geteuid() != 0) {
+    printf("Creating the SGi TUN device needs CAP_NET_ADMIN, skipping\n");
+    exit(0);
+  }
+
+  srslte::logger_stdout logger;
+  srslte::log_filter    spgw_log;
+  spgw_log.init("SPGW", &logger);
+  spgw_log.set_level(srslte::LOG_LEVEL_ERROR);
+
+  spgw_args_t args;
+  args.gtpu_bind_addr = gtpu_addr;
+  args.sgi_if_addr    = sgi_addr;
+  args.nof_workers    = nof_workers;
+  args.s1u_backend    = backend;
+  args.s1u_if         = s1u_if;
+
+  spgw *gw = spgw::get_instance();
+  if (gw->init(&args, &spgw_log)) {
+    printf("Could not start the SP-GW\n");
+    exit(1);
+  }
+  gw->start();
+
+  bool ok       = true;
+  int  sgi_sock = udp_socket(sgi_addr.c_str(), SGI_PORT);
+  int  enb_sock = enb_socket();
+  if (sgi_sock < 0 || enb_sock < 0) {
+    printf("Could not open the SGi and eNB sockets: %s\n", strerror(errno));
+    ok = false;
+  }
+  ok = ok && attach_ues(gw);
+  ok = ok && forwarding(gw, sgi_sock, enb_sock);
+  printf("forwarding: %s\n", ok ? "ok" : "FAILED");
+
+  if (ok && nof_pkts > 0 && nof_ues > 2) {
+    bench(sgi_sock, enb_sock, true);
+    bench(sgi_sock, enb_sock, false);
+  }
+
+  close(sgi_sock);
+  close(enb_sock);
+  gw->stop();
+  spgw::cleanup();
+
+  if (ok) {
+    printf("Passed\n");
+    exit(0);
+  } else {
+    printf("Failed\n");
+    exit(1);
+  }
+}
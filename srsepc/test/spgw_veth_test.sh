@@ -0,0 +1,68 @@
+#!/bin/bash
+
+###################################################################
+#
+# This file is part of srsLTE.
+#
+# srsLTE is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as
+# published by the Free Software Foundation, either version 3 of
+# the License, or (at your option) any later version.
+#
+# srsLTE is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Affero General Public License for more details.
+#
+# A copy of the GNU Affero General Public License can be found in
+# the LICENSE file in the top-level directory of this distribution
+# and at http://www.gnu.org/licenses/.
+#
+###################################################################
+
+# Runs spgw_fwd_test with S1-U over a veth pair, the eNB end in its own
+# network namespace, for the socket and packet_mmap backends.
+# Usage: spgw_veth_test.sh <spgw_fwd_test> [extra spgw_fwd_test args]
+
+if [ $# -lt 1 ]
+  then
+    echo "Usage: $0 <spgw_fwd_test> [args]"
+    exit 1
+fi
+TEST=$1
+shift
+
+if [ $(id -u) -ne 0 ]
+  then
+    echo "Creating network namespaces needs root, skipping"
+    exit 0
+fi
+
+NS=srsepc_test_enb
+SGW_IF=srsepc_s1u0
+ENB_IF=srsepc_s1u1
+SGW_ADDR=10.203.0.1
+ENB_ADDR=10.203.0.2
+
+cleanup() {
+  ip link del $SGW_IF 2>/dev/null
+  ip netns del $NS 2>/dev/null
+}
+trap cleanup EXIT
+cleanup
+
+ip netns add $NS || exit 1
+ip link add $SGW_IF type veth peer name $ENB_IF || exit 1
+ip link set $ENB_IF netns $NS
+ip addr add $SGW_ADDR/24 dev $SGW_IF
+ip link set $SGW_IF up
+ip netns exec $NS ip addr add $ENB_ADDR/24 dev $ENB_IF
+ip netns exec $NS ip link set $ENB_IF up
+ip netns exec $NS ip link set lo up
+
+RET=0
+for BACKEND in socket packet_mmap
+do
+  $TEST -b $BACKEND -i $SGW_IF -a $SGW_ADDR -e $ENB_ADDR -N $NS "$@" || RET=1
+done
+exit $RET
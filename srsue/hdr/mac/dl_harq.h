@@ -55,14 +55,30 @@ public:
   dl_harq_entity() : proc(N+1)
   {
     pcap = NULL;
+    bzero(&softbuffer_pool, sizeof(srslte_softbuffer_pool_t));
+  }
+
+  ~dl_harq_entity()
+  {
+    // Soft buffers give their code blocks back to the pool before it is freed
+    proc.clear();
+    srslte_softbuffer_pool_free(&softbuffer_pool);
   }
     
-  bool init(srslte::log *log_h_, srslte::timers::timer *timer_aligment_timer_, demux *demux_unit_)
+  // With llr_8bit the soft buffers hold the 8-bit LLRs the PHY decodes with, see phy_args_t::pdsch_llr_8bit
+  bool init(srslte::log *log_h_, srslte::timers::timer *timer_aligment_timer_, demux *demux_unit_, bool llr_8bit = false)
   {
     timer_aligment_timer  = timer_aligment_timer_;
     demux_unit = demux_unit_; 
     si_window_start = 0; 
     log_h = log_h_; 
+    // Code block soft buffers are only taken while their CB is pending and, once allocated, stay in the
+    // pool until the entity is destroyed. The pool is capped at one 110 PRB TB per process, half the
+    // worst case with two TBs. Past that a CB fails this transmission and is decoded from the retransmission
+    if (srslte_softbuffer_pool_init(&softbuffer_pool, 110, N+1, llr_8bit)) {
+      Error("Error initiating soft buffer pool\n");
+      return false;
+    }
     for (uint32_t i=0;i<N+1;i++) {
       if (!proc[i].init(i, this)) {
         return false; 
@@ -211,7 +227,7 @@ private:
 
       bool init(uint32_t pid_, dl_harq_entity *parent, uint32_t tb_idx) {
         tid = tb_idx;
-        if (srslte_softbuffer_rx_init(&softbuffer, 110)) {
+        if (srslte_softbuffer_rx_init_pool(&softbuffer, 110, &parent->softbuffer_pool)) {
           Error("Error initiating soft buffer\n");
           return false;
         } else {
@@ -442,6 +458,7 @@ private:
   
 
   std::vector<dl_harq_process> proc;
+  srslte_softbuffer_pool_t softbuffer_pool;
   srslte::timers::timer   *timer_aligment_timer;
   demux           *demux_unit; 
   srslte::log     *log_h;
@@ -54,7 +54,8 @@ class mac
 {
 public:
   mac();
-  bool init(phy_interface_mac *phy, rlc_interface_mac *rlc, rrc_interface_mac* rrc, srslte::log *log_h);
+  bool init(phy_interface_mac *phy, rlc_interface_mac *rlc, rrc_interface_mac* rrc, srslte::log *log_h,
+            bool pdsch_llr_8bit = false);
   void stop();
 
   void get_metrics(mac_metrics_t &m);
@@ -46,6 +46,7 @@ public:
   void  reset(); 
   void  set_common(phch_common *phy);
   void  enable_pdsch_coworker();
+  void  set_sch_pool(srslte_sch_pool_t *pool);
   bool  init(uint32_t max_prb, srslte::log *log, srslte::log *log_phy_lib_h, chest_feedback_itf *chest_loop);
 
   bool  set_cell(srslte_cell_t cell);
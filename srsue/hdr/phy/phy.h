@@ -150,10 +150,12 @@ public:
 private:
 
   void run_thread();
+  static bool fec_thread_create(pthread_t *thread, void *(*start_routine)(void*), void *arg, void *ctx);
 
   bool     initiated;
   uint32_t nof_workers; 
   uint32_t nof_coworkers;
+  srslte_sch_pool_t fec_pool;
 
   const static int MAX_WORKERS         = 3;
   const static int DEFAULT_WORKERS     = 2;
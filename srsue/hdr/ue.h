@@ -51,6 +51,7 @@
 #include "srslte/common/buffer_pool.h"
 #include "srslte/interfaces/ue_interfaces.h"
 #include "srslte/common/logger_file.h"
+#include "srslte/common/logger_async.h"
 #include "srslte/common/log_filter.h"
 
 #include "ue_metrics_interface.h"
@@ -104,6 +105,7 @@ private:
 
   srslte::logger_stdout logger_stdout;
   srslte::logger_file   logger_file;
+  srslte::logger_async  logger_async;
   srslte::logger        *logger;
 
   // rf_log is on ue_base
@@ -103,6 +103,7 @@ typedef struct {
   int           all_hex_limit;
   int           file_max_size;
   std::string   filename;
+  bool          async;
 }log_args_t;
 
 typedef struct {
@@ -61,8 +61,8 @@ static const char emm_state_text[EMM_STATE_N_ITEMS][100] = {"NULL",
                                                             "DEREGISTERED INITIATED",
                                                             "TRACKING AREA UPDATE INITIATED"};
 
-static const bool eia_caps[8] = {false, true, true, false, false, false, false, false};
-static const bool eea_caps[8] = {true,  true, true, false, false, false, false, false};
+static const bool eia_caps[8] = {false, true, true, true, false, false, false, false};
+static const bool eea_caps[8] = {true,  true, true, true, false, false, false, false};
 
 class nas
   : public nas_interface_rrc,
@@ -50,7 +50,8 @@ mac::mac() : timers(64),
   bzero(&metrics, sizeof(mac_metrics_t));
 }
 
-bool mac::init(phy_interface_mac *phy, rlc_interface_mac *rlc, rrc_interface_mac *rrc, srslte::log *log_h_)
+bool mac::init(phy_interface_mac *phy, rlc_interface_mac *rlc, rrc_interface_mac *rrc, srslte::log *log_h_,
+               bool pdsch_llr_8bit)
 {
   phy_h = phy;
   rlc_h = rlc;
@@ -71,7 +72,7 @@ bool mac::init(phy_interface_mac *phy, rlc_interface_mac *rlc, rrc_interface_mac
   ra_procedure.init (phy_h, rrc,   log_h, &uernti, &config,                timers.get(timer_alignment), timers.get(contention_resolution_timer), &mux_unit, &demux_unit);
   sr_procedure.init (phy_h, rrc,   log_h,          &config);
   ul_harq.init      (              log_h, &uernti, &config.ul_harq_params, timers.get(contention_resolution_timer), &mux_unit);
-  dl_harq.init      (              log_h,                                  timers.get(timer_alignment),             &demux_unit);
+  dl_harq.init      (              log_h,                                  timers.get(timer_alignment),             &demux_unit, pdsch_llr_8bit);
 
   reset();
 
@@ -128,6 +128,7 @@ void parse_args(all_args_t *args, int argc, char *argv[]) {
 
     ("log.filename", bpo::value<string>(&args->log.filename)->default_value("/tmp/ue.log"), "Log filename")
     ("log.file_max_size", bpo::value<int>(&args->log.file_max_size)->default_value(-1), "Maximum file size (in kilobytes). When passed, multiple files are created. Default -1 (single file)")
+    ("log.async",         bpo::value<bool>(&args->log.async)->default_value(false), "Queue log arguments and format them in the logger thread")
 
     ("usim.mode", bpo::value<string>(&args->usim.mode)->default_value("soft"), "USIM mode (soft or pcsc)")
     ("usim.algo", bpo::value<string>(&args->usim.algo), "USIM authentication algorithm")
@@ -216,6 +217,14 @@ void parse_args(all_args_t *args, int argc, char *argv[]) {
      bpo::value<int>(&args->expert.phy.pdsch_max_its)->default_value(4),
      "Maximum number of turbo decoder iterations")
 
+    ("expert.pdsch_early_stop",
+     bpo::value<bool>(&args->expert.phy.pdsch_early_stop)->default_value(false),
+     "Stops decoding code blocks whose hard decisions no longer change")
+
+    ("expert.pdsch_llr_8bit",
+     bpo::value<bool>(&args->expert.phy.pdsch_llr_8bit)->default_value(false),
+     "Decodes the PDSCH with 8-bit LLRs and soft buffers")
+
     ("expert.attach_enable_64qam",
      bpo::value<bool>(&args->expert.phy.attach_enable_64qam)->default_value(false),
      "PUSCH 64QAM modulation before attachment")
@@ -224,6 +233,10 @@ void parse_args(all_args_t *args, int argc, char *argv[]) {
      bpo::value<int>(&args->expert.phy.nof_phy_threads)->default_value(2),
      "Number of PHY threads")
 
+    ("expert.nof_fec_threads",
+     bpo::value<int>(&args->expert.phy.nof_fec_threads)->default_value(0),
+     "Number of FEC threads shared by the PHY workers (0 disables it)")
+
     ("expert.equalizer_mode",
      bpo::value<string>(&args->expert.phy.equalizer_mode)->default_value("mmse"),
      "Equalizer mode")
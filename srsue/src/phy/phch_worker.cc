@@ -107,6 +107,10 @@ void phch_worker::enable_pdsch_coworker() {
   srslte_pdsch_enable_coworker(&ue_dl.pdsch);
 }
 
+void phch_worker::set_sch_pool(srslte_sch_pool_t *pool) {
+  srslte_pdsch_set_sch_pool(&ue_dl.pdsch, pool);
+}
+
 void phch_worker::set_common(phch_common* phy_)
 {
   phy = phy_;   
@@ -132,6 +136,11 @@ bool phch_worker::init(uint32_t max_prb, srslte::log *log_h, srslte::log *log_ph
     return false;
   }
 
+  if (phy->args->pdsch_llr_8bit && srslte_pdsch_set_llr_8bit(&ue_dl.pdsch, true)) {
+    Error("Setting 8-bit PDSCH LLRs\n");
+    return false;
+  }
+
   if (srslte_ue_ul_init(&ue_ul, signal_buffer[0], max_prb)) {
     Error("Initiating UE UL\n");
     return false;
@@ -784,6 +793,7 @@ int phch_worker::decode_pdsch(srslte_ra_dl_grant_t *grant, uint8_t *payload[SRSL
         if (phy->args->pdsch_max_its > 0) {
           srslte_pdsch_set_max_noi(&ue_dl.pdsch, phy->args->pdsch_max_its);
         }
+        srslte_pdsch_set_early_stop(&ue_dl.pdsch, phy->args->pdsch_early_stop);
 
 
   #ifdef LOG_EXECTIME
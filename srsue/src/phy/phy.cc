@@ -54,6 +54,7 @@ phy::phy() : workers_pool(MAX_WORKERS),
              workers(MAX_WORKERS), 
              workers_common(phch_recv::MUTEX_X_WORKER*MAX_WORKERS),nof_coworkers(0)
 {
+  bzero(&fec_pool, sizeof(srslte_sch_pool_t));
 }
 
 static void srslte_phy_handler(phy_logger_level_t log_level, void *ctx, char *str) {
@@ -91,8 +92,11 @@ void phy::set_default_args(phy_args_t *args)
   args->snr_ema_coeff       = 0.1; 
   args->snr_estim_alg       = "refs";
   args->pdsch_max_its       = 4; 
+  args->pdsch_early_stop    = false; 
+  args->pdsch_llr_8bit      = false; 
   args->attach_enable_64qam = false; 
   args->nof_phy_threads     = DEFAULT_WORKERS;
+  args->nof_fec_threads     = 0;
   args->equalizer_mode      = "mmse"; 
   args->cfo_integer_enabled = false; 
   args->cfo_correct_tol_hz  = 50; 
@@ -112,6 +116,12 @@ bool phy::check_args(phy_args_t *args)
     log_h->console("Error in PHY args: snr_ema_coeff must be 0<=w<=1\n");
     return false; 
   }
+  // The MAC sizes its HARQ soft buffers after this setting, so it is cleared here and not in the workers
+  if (args->pdsch_llr_8bit && !srslte_tdec_impl_available(SRSLTE_TDEC_AVX8) &&
+      !srslte_tdec_impl_available(SRSLTE_TDEC_SSE8)) {
+    log_h->console("Warning in PHY args: no 8-bit turbo decoder available, pdsch_llr_8bit disabled\n");
+    args->pdsch_llr_8bit = false;
+  }
   return true; 
 }
 
@@ -172,6 +182,17 @@ void phy::run_thread() {
     workers[i].enable_pdsch_coworker();
   }
 
+  // All workers share the same FEC threads
+  if (args->nof_fec_threads > 0) {
+    if (srslte_sch_pool_init_threads(&fec_pool, (uint32_t) args->nof_fec_threads, fec_thread_create, args)) {
+      log_h->console("Error initiating FEC pool. Decoding code blocks in the workers only\n");
+    } else {
+      for (uint32_t i=0;i<nof_workers;i++) {
+        workers[i].set_sch_pool(&fec_pool);
+      }
+    }
+  }
+
   // Warning this must be initialized after all workers have been added to the pool
   sf_recv.init(radio_handler, mac, rrc, &prach_buffer, &workers_pool, &workers_common, log_h, log_phy_lib_h, args->nof_rx_ant, SF_RECV_THREAD_PRIO, args->sync_cpu_affinity);
 
@@ -181,6 +202,13 @@ void phy::run_thread() {
   initiated = true;
 }
 
+// FEC threads decode code blocks for the workers, so they run with the same priority and CPU mask
+bool phy::fec_thread_create(pthread_t *thread, void *(*start_routine)(void*), void *arg, void *ctx)
+{
+  phy_args_t *phy_args = (phy_args_t*) ctx;
+  return threads_new_rt_mask(thread, start_routine, arg, phy_args->worker_cpu_mask, WORKERS_THREAD_PRIO);
+}
+
 void phy::wait_initialize() {
   wait_thread_finish();
 }
@@ -213,6 +241,9 @@ void phy::stop()
 {  
   sf_recv.stop();
   workers_pool.stop();
+  if (fec_pool.nof_threads) {
+    srslte_sch_pool_free(&fec_pool);
+  }
 }
 
 void phy::get_metrics(phy_metrics_t &m) {
@@ -64,6 +64,11 @@ bool ue::init(all_args_t *args_) {
 
   if (!args->log.filename.compare("stdout")) {
     logger = &logger_stdout;
+  } else if (args->log.async) {
+    logger_async.init(args->log.filename, args->log.file_max_size);
+    logger_async.log("\n\n");
+    logger_async.log(get_build_string().c_str());
+    logger = &logger_async;
   } else {
     logger_file.init(args->log.filename, args->log.file_max_size);
     logger_file.log("\n\n");
@@ -218,7 +223,7 @@ bool ue::init(all_args_t *args_) {
   radio.register_error_handler(rf_msg);
   radio.set_freq_offset(args->rf.freq_offset);
 
-  mac.init(&phy, &rlc, &rrc, &mac_log);
+  mac.init(&phy, &rlc, &rrc, &mac_log, args->expert.phy.pdsch_llr_8bit);
   rlc.init(&pdcp, &rrc, this, &rlc_log, &mac, 0 /* RB_ID_SRB0 */);
   pdcp.init(&rlc, &rrc, &gw, &pdcp_log, 0 /* RB_ID_SRB0 */, SECURITY_DIRECTION_UPLINK);
 
@@ -421,6 +421,15 @@ void nas::integrity_generate(uint8_t *key_128,
                         msg_len,
                         mac);
       break;
+    case INTEGRITY_ALGORITHM_ID_128_EIA3:
+      security_128_eia3(key_128,
+                        count,
+                        0,            // Bearer always 0 for NAS
+                        direction,
+                        msg,
+                        msg_len,
+                        mac);
+      break;
     default:
       break;
   }
@@ -493,6 +502,15 @@ void nas::cipher_encrypt(byte_buffer_t *pdu)
                         &pdu_tmp.msg[6]);
       memcpy(&pdu->msg[6], &pdu_tmp.msg[6], pdu->N_bytes-6);
       break;
+  case CIPHERING_ALGORITHM_ID_128_EEA3:
+      security_128_eea3(&k_nas_enc[16],
+                        pdu->msg[5],
+                        0,            // Bearer always 0 for NAS
+                        SECURITY_DIRECTION_UPLINK,
+                        &pdu->msg[6],
+                        pdu->N_bytes-6,
+                        &pdu->msg[6]);
+      break;
   default:
       nas_log->error("Ciphering algorithm not known\n");
       break;
@@ -527,6 +545,15 @@ void nas::cipher_decrypt(byte_buffer_t *pdu)
       nas_log->debug_hex(tmp_pdu.msg, pdu->N_bytes, "Decrypted");
       memcpy(&pdu->msg[6], &tmp_pdu.msg[6], pdu->N_bytes-6);
       break;
+  case CIPHERING_ALGORITHM_ID_128_EEA3:
+      security_128_eea3(&k_nas_enc[16],
+                        pdu->msg[5],
+                        0,            // Bearer always 0 for NAS
+                        SECURITY_DIRECTION_DOWNLINK,
+                        &pdu->msg[6],
+                        pdu->N_bytes-6,
+                        &pdu->msg[6]);
+      break;
     default:
       nas_log->error("Ciphering algorithms not known\n");
       break;
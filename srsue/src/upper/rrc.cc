@@ -1312,6 +1312,15 @@ void rrc::send_con_restablish_request(LIBLTE_RRC_CON_REEST_REQ_CAUSE_ENUM cause)
                         N_bytes,
                         mac_key);
       break;
+    case INTEGRITY_ALGORITHM_ID_128_EIA3:
+      security_128_eia3(&k_rrc_int[16],
+                        0xffffffff,    // 32-bit all to ones
+                        0x1f,          // 5-bit all to ones
+                        1,             // 1-bit to one
+                        varShortMAC_packed,
+                        N_bytes,
+                        mac_key);
+      break;
     default:
       rrc_log->info("Unsupported integrity algorithm during reestablishment\n");
   }
@@ -1883,8 +1892,8 @@ byte_buffer_t* rrc::byte_align_and_pack()
     bit_buf.N_bits += 8 - (bit_buf.N_bits % 8);
   }
 
-  // Reset and reuse sdu buffer if provided
-  byte_buffer_t *pdcp_buf = pool_allocate;
+  // RRC messages are small, leave room for the PDCP MAC-I
+  byte_buffer_t *pdcp_buf = pool_allocate_size(bit_buf.N_bits / 8 + 4);
   if (pdcp_buf) {
     srslte_bit_pack_vector(bit_buf.msg, pdcp_buf->msg, bit_buf.N_bits);
     pdcp_buf->N_bytes = bit_buf.N_bits / 8;